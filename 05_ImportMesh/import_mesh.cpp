@@ -10,23 +10,35 @@
 #include "Batch.h"
 #include "Model.h"
 #include "BufferHelper.h"
-
-// Assimp
-#include "Importer.hpp"
-#include "scene.h"
-#include "postprocess.h"
+#include "MeshLoader.h"
+#include "SceneImporter.h"
+#include "MappedIOSystem.h"
 
 using namespace DirectX;
 using namespace DirectX::PackedVector;
 
 #define MESH_FILE "suzanne.obj"
 
+// Assimp post-processing of the formats other than OBJ
+#define MESH_IMPORT_PROFILE XNA::SceneImportFast
+
 struct Vertex
 {
 	XMFLOAT3 Position;
 	XMFLOAT4 Color;
 };
 
+// The loader only fills the position, the color is set by the demo
+namespace XNA
+{
+	template <> struct MeshVertexLayout<Vertex>
+	{
+		static const INT Position = offsetof( Vertex, Position );
+		static const INT Normal = -1;
+		static const INT TexCoord = -1;
+	};
+}
+
 
 class ShapesApp : public D3DApp
 {
@@ -50,7 +62,7 @@ private:
 	void BuildRasterState();
 	void BuildWireFrameRasterState();
 
-	bool ImportMeshFromFile( const std::string & filename, std::vector<Vertex>** vertices, std::vector<UINT>** indices );
+	bool ImportMeshFromFile( const std::string & filename, XNA::LoadedMesh<Vertex>* mesh, std::vector<BatchSubmesh>* submeshes );
 
 private:
 	ConstantBuffer<ConstantsPerObject> mObjectConstantBuffer;
@@ -225,9 +237,9 @@ void ShapesApp::OnMouseMove( WPARAM btnState, int x, int y )
 
 void ShapesApp::BuildGeometryBuffers()
 {
-	std::vector<Vertex>* vertices = nullptr;
-	std::vector<UINT>* indices = nullptr;
-	bool result = ImportMeshFromFile( MESH_FILE, &vertices, &indices );
+	XNA::LoadedMesh<Vertex> mesh;
+	std::vector<BatchSubmesh> submeshes;
+	bool result = ImportMeshFromFile( MESH_FILE, &mesh, &submeshes );
 	if ( !result )
 	{
 		OutputDebugString( L"Reading mesh file failed.\n" );
@@ -236,18 +248,13 @@ void ShapesApp::BuildGeometryBuffers()
 	ID3D11Buffer* vertexBuffer = nullptr;
 	ID3D11Buffer* indexBuffer = nullptr;
 
-	BufferHelper<Vertex>::CreateVertexBuffer( &md3dDevice, *vertices, &vertexBuffer );
-	BufferHelper<UINT>::CreateIndexBuffer( &md3dDevice, *indices, &indexBuffer );
+	BufferHelper<Vertex>::CreateVertexBuffer( &md3dDevice, mesh.pVertices, mesh.VertexCount, &vertexBuffer );
+	BufferHelper<UINT>::CreateIndexBuffer( &md3dDevice, mesh.pIndices, mesh.IndexCount, &indexBuffer );
 
-	Batch* importexMeshBatch = new Batch( &md3dDevice, &md3dImmediateContext, vertexBuffer, indexBuffer, indices->size(), sizeof( Vertex ), 0 );
+	// Every mesh of the file in one batch: the buffers are bound once, each submesh draws its range
+	Batch* importexMeshBatch = new Batch( &md3dDevice, &md3dImmediateContext, vertexBuffer, indexBuffer, submeshes, sizeof( Vertex ), 0 );
 	m_importedMeshModel = new Model( importexMeshBatch );
 
-	delete vertices;
-	vertices = 0;
-
-	delete indices;
-	indices = 0;
-
 	//m_importedMeshModel->SetTransition( XMFLOAT3( 0.0f, 0.5f, 0.0f ) );
 	//m_importedMeshModel->SetScale( XMFLOAT3( 2.0f, 1.0f, 2.0f ) );
 }
@@ -303,49 +310,58 @@ void ShapesApp::BuildWireFrameRasterState()
 	HR( md3dDevice->CreateRasterizerState( &wireframeDesc, &mRasterState ) );
 }
 
-bool ShapesApp::ImportMeshFromFile( const std::string & filename, std::vector<Vertex>** vertices, std::vector<UINT>** indices )
+bool ShapesApp::ImportMeshFromFile( const std::string & filename, XNA::LoadedMesh<Vertex>* mesh, std::vector<BatchSubmesh>* submeshes )
 {
 	wchar_t msg[256];
 
-	Assimp::Importer importer;
-
-	const aiScene* scene = importer.ReadFile( filename, aiProcess_Triangulate );
-	if ( !scene )
+	// OBJ files go through the native reader and its binary cache, other formats through Assimp with
+	// all the meshes of the scene converted in parallel. Either way the positions are converted
+	// straight into the vertices of this demo, one vertex and one index array with a subset per
+	// mesh or material.
+	// Assimp reads the file and its MTL or other references from memory mappings.
+	XNA::SceneImportTimings timings;
+	XNA::MappedIOSystem files;
+	if ( !XNA::LoadMeshFromFile( filename.c_str(), XNA::GetScenePostProcessFlags( MESH_IMPORT_PROFILE ), mesh, 0, &timings, &files ) )
 	{
-		fprintf( stderr, "ERROR: reading mesh %s\n", filename );
+		fprintf( stderr, "ERROR: reading mesh %s\n", filename.c_str() );
 		return false;
 	}
 
-	swprintf_s( msg, 256, L"  %i meshes\n", scene->mNumMeshes );
-	OutputDebugString( msg );
+	if ( !timings.Stages.empty() )
+	{
+		for ( size_t i = 0; i < timings.Stages.size(); i++ )
+		{
+			swprintf_s( msg, 256, L"  %-24hs %8.2f ms\n", timings.Stages[i].Name, timings.Stages[i].Milliseconds );
+			OutputDebugString( msg );
+		}
+		swprintf_s( msg, 256, L"  %-24hs %8.2f ms\n", "total", timings.TotalMilliseconds );
+		OutputDebugString( msg );
+	}
 
-	const aiMesh* mesh = scene->mMeshes[0];
-	swprintf_s( msg, 256, L"  %i vertices in mesh[0]\n", mesh->mNumVertices );
+	swprintf_s( msg, 256, L"  %u vertices, %u subsets\n", mesh->VertexCount, static_cast<UINT>( mesh->Subsets.size() ) );
 	OutputDebugString( msg );
 
-	if ( mesh->HasPositions() )
+	// The colored vertices of this demo get their color here.
+	XMFLOAT4 green( 0.0f, 0.8f, 0.0f, 1.0f );
+	for ( UINT i = 0; i < mesh->VertexCount; i++ )
 	{
-		*vertices = new std::vector<Vertex>( static_cast<size_t>( mesh->mNumVertices ) );
-		XMFLOAT4 green( 0.0f, 0.8f, 0.0f, 1.0f );
-		for ( int i = 0; i < mesh->mNumVertices; i++ )
-		{
-			const aiVector3D* pos = &( mesh->mVertices[i] );
-			( **vertices )[i].Position = XMFLOAT3( pos->x, pos->y, pos->z );
-			( **vertices )[i].Color = green;		//FIXME: for test
-		}
+		mesh->pVertices[i].Color = green;		//FIXME: for test
 	}
 
-	*indices = new std::vector<UINT>( mesh->mNumFaces * 3 );
-	for ( int i = 0; i < mesh->mNumFaces; i++ )
+	submeshes->resize( mesh->Subsets.size() );
+	for ( size_t i = 0; i < mesh->Subsets.size(); i++ )
 	{
-		const aiFace& face = mesh->mFaces[i];
-		assert( face.mNumIndices == 3 );
-		( **indices )[(i * 3) + 0] = face.mIndices[0];
-		( **indices )[(i * 3) + 1] = face.mIndices[1];
-		( **indices )[(i * 3) + 2] = face.mIndices[2];
+		const XNA::ImportedSubset& subset = mesh->Subsets[i];
+		const XNA::ImportedMaterial& material = mesh->Materials[subset.Material];
+		BatchSubmesh& submesh = ( *submeshes )[i];
+		submesh.startIndex = subset.FirstIndex;
+		submesh.indexCount = subset.IndexCount;
+		submesh.baseVertex = static_cast<INT>( subset.BaseVertex );
+		submesh.material.Ambient = XMFLOAT4( material.Ambient.x, material.Ambient.y, material.Ambient.z, 1.0f );
+		submesh.material.Diffuse = XMFLOAT4( material.Diffuse.x, material.Diffuse.y, material.Diffuse.z, material.Opacity );
+		submesh.material.Specular = XMFLOAT4( material.Specular.x, material.Specular.y, material.Specular.z, material.SpecularPower );
+		submesh.material.Reflect = XMFLOAT4( 0.0f, 0.0f, 0.0f, 0.0f );
 	}
 
-	swprintf_s( msg, 256, L"Complete reading mesh %s\n", filename );
-	
 	return true;
 }
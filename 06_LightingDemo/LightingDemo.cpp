@@ -1,4 +1,6 @@
-﻿#include <string>
+﻿#include <chrono>
+#include <string>
+#include <d3dcompiler.h>
 
 #include "d3dApp.h"
 #include "d3dUtil.h"
@@ -7,17 +9,31 @@
 #include "LightHelper.h"
 #include "Vertex.h"
 #include "Effects.h"
-
-// Assimp
-#include "Importer.hpp"
-#include "scene.h"
-#include "postprocess.h"
+#include "ShaderHelper.h"
+#include "GeometryGenerator.h"
+#include "AssetArchive.h"
+#include "AsyncMeshLoader.h"
+#include "MeshCache.h"
+#include "MeshLoader.h"
+#include "MeshWeld.h"
+#include "SceneImporter.h"
+#include "MappedIOSystem.h"
 
 using namespace DirectX;
 using namespace DirectX::PackedVector;
 
 #define MESH_FILE "suzanne.obj"
 
+// Shaders and meshes are read from this archive (AssetPacker) when it is next to the executable,
+// from loose files otherwise.
+#define ASSET_ARCHIVE "assets.pak"
+
+// Assimp post-processing of the formats other than OBJ
+#define MESH_IMPORT_PROFILE XNA::SceneImportFast
+
+// Meshes without normals are welded and get smooth normals, split where faces meet at more than this
+#define MESH_CREASE_DEGREES 60.0f
+
 class LightingApp : public D3DApp
 {
 public:
@@ -35,10 +51,13 @@ public:
 
 private:
 	void BuildGeometryBuffers();
+	void BuildPlaceholderBuffers();
 	void BuildRasterState();
 	void BuildWireFrameRasterState();
 
-	bool ImportMeshFromFile( const std::string & filename, ID3D11Buffer** vertexBuffer, ID3D11Buffer** indexBuffer, UINT* indexCount );
+	void UploadLoadedMesh( const XNA::MeshLoadResult& result );
+	static BOOL LoadMeshFile( const char* fileName, UINT threadCount, XNA::ImportedMesh* mesh, XNA::MeshCache* cache, VOID* context );
+	static HRESULT LoadArchiveShader( const char* fileName, ID3DBlob** blob, void* context );
 
 private:
 	ID3D11RasterizerState* mRasterState;
@@ -48,9 +67,18 @@ private:
 
 	ID3D11Buffer* mMonkeyVB;
 	ID3D11Buffer* mMonkeyIB;
-	UINT mMonkeyIndexCount;
+	std::vector<XNA::ImportedSubset> mMonkeySubsets;
+	UINT mMonkeyVertexStride;
 	XMFLOAT4X4 mMonkeyWorldMat;
 	Material mMonkeyMaterial;
+
+	// Declared before the loader: its threads read from the archive until it stops.
+	XNA::AssetArchive mAssets;
+
+	// Mesh files load on worker threads; the box of BuildPlaceholderBuffers is drawn until then.
+	XNA::AsyncMeshLoader mMeshLoader;
+	XNA::MeshLoadHandle mMonkeyLoad;
+	std::vector<XNA::MeshLoadResult> mLoadedMeshes;
 	
 	std::vector<DirectionalLight> mDirLights = std::vector<DirectionalLight>(3);
 	XMFLOAT3 mEyePosW;
@@ -83,7 +111,8 @@ int WINAPI WinMain( HINSTANCE hInstance, HINSTANCE prevInstance,
 
 LightingApp::LightingApp( HINSTANCE hInstance )
 	: D3DApp( hInstance ),
-	mTheta( 0.1f*MathHelper::Pi ), mPhi( 0.5f*MathHelper::Pi ), mRadius( 10.0f ), mEyePosW( 0.0f, 0.0f, 0.0f )
+	mTheta( 0.1f*MathHelper::Pi ), mPhi( 0.5f*MathHelper::Pi ), mRadius( 10.0f ), mEyePosW( 0.0f, 0.0f, 0.0f ),
+	mMonkeyVB( NULL ), mMonkeyIB( NULL ), mMonkeyVertexStride( sizeof( XNA::ImportedVertex ) ), mMonkeyLoad( 0 )
 {
 	mMainWndCaption = L"Lighting Demo";
 
@@ -125,6 +154,10 @@ LightingApp::LightingApp( HINSTANCE hInstance )
 
 LightingApp::~LightingApp()
 {
+	mMeshLoader.Stop();
+	ShaderHelper::SetShaderSource( NULL, NULL );
+	ReleaseCOM( mMonkeyVB );
+	ReleaseCOM( mMonkeyIB );
 	InputLayouts::DestroyAll();
 	Effects::DestroyAll();
 	ReleaseCOM( md3dImmediateContext );
@@ -136,6 +169,11 @@ bool LightingApp::Init()
 	if ( !D3DApp::Init() )
 		return false;
 
+	if ( mAssets.Open( ASSET_ARCHIVE ) )
+	{
+		ShaderHelper::SetShaderSource( &LightingApp::LoadArchiveShader, &mAssets );
+	}
+
 	BuildGeometryBuffers();
 
 	Effects::InitAll( md3dDevice );
@@ -158,6 +196,14 @@ void LightingApp::OnResize()
 
 void LightingApp::UpdateScene( float dt )
 {
+	// Upload the meshes the loader finished since the last frame.
+	mLoadedMeshes.clear();
+	mMeshLoader.DrainCompleted( &mLoadedMeshes );
+	for ( size_t i = 0; i < mLoadedMeshes.size(); i++ )
+	{
+		UploadLoadedMesh( mLoadedMeshes[i] );
+	}
+
 	// Convert Spherical to Cartesian coordinates.
 	float x = mRadius*sinf( mPhi )*cosf( mTheta );
 	float z = mRadius*sinf( mPhi )*sinf( mTheta );
@@ -222,15 +268,18 @@ void LightingApp::DrawScene()
 	Effects::BasicFX->Render( md3dImmediateContext, InputLayouts::PosNormal );
 
 	// 頂点バッファのセット
-	UINT stride = sizeof( Vertex::PosNormal );
 	UINT offset = 0;
-	md3dImmediateContext->IASetVertexBuffers( 0, 1, &mMonkeyVB, &stride, &offset );
+	md3dImmediateContext->IASetVertexBuffers( 0, 1, &mMonkeyVB, &mMonkeyVertexStride, &offset );
 
 	// インデックスバッファのセット
 	md3dImmediateContext->IASetIndexBuffer( mMonkeyIB, DXGI_FORMAT_R32_UINT, 0 );
 
-	// 描画
-	md3dImmediateContext->DrawIndexed( mMonkeyIndexCount, 0, 0 );
+	// 描画: every mesh of the file from the same buffers
+	for ( size_t i = 0; i < mMonkeySubsets.size(); i++ )
+	{
+		const XNA::ImportedSubset& subset = mMonkeySubsets[i];
+		md3dImmediateContext->DrawIndexed( subset.IndexCount, subset.FirstIndex, subset.BaseVertex );
+	}
 
 	HR( mSwapChain->Present( 0, 0 ) );
 }
@@ -282,11 +331,34 @@ void LightingApp::OnMouseMove( WPARAM btnState, int x, int y )
 
 void LightingApp::BuildGeometryBuffers()
 {
-	bool result = ImportMeshFromFile( MESH_FILE, &mMonkeyVB, &mMonkeyIB, &mMonkeyIndexCount );
-	if ( !result )
-	{
-		OutputDebugString( L"Reading mesh file failed.\n" );
-	}
+	// Init no longer waits for the mesh: it is requested here, parsed on a worker thread and
+	// uploaded by UpdateScene when it is done.
+	BuildPlaceholderBuffers();
+
+	mMeshLoader.Start( &LightingApp::LoadMeshFile, &mAssets );
+	mMonkeyLoad = mMeshLoader.Request( MESH_FILE );
+}
+
+void LightingApp::BuildPlaceholderBuffers()
+{
+	// GeometryGenerator::Vertex also starts with the position and normal, so the box is drawn
+	// with the PosNormal layout and its own stride.
+	GeometryGenerator::MeshData box;
+	GeometryGenerator geoGen;
+	geoGen.CreateBox( 2.0f, 2.0f, 2.0f, box );
+
+	BufferHelper<GeometryGenerator::Vertex>::CreateVertexBuffer( &md3dDevice, box.Vertices, &mMonkeyVB );
+	BufferHelper<UINT>::CreateIndexBuffer( &md3dDevice, box.Indices, &mMonkeyIB );
+	mMonkeyVertexStride = sizeof( GeometryGenerator::Vertex );
+
+	XNA::ImportedSubset subset;
+	subset.Material = 0;
+	subset.FirstIndex = 0;
+	subset.IndexCount = static_cast<UINT>( box.Indices.size() );
+	subset.BaseVertex = 0;
+	subset.Bounds.Center = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+	subset.Bounds.Extents = XMFLOAT3( 1.0f, 1.0f, 1.0f );
+	mMonkeySubsets.assign( 1, subset );
 }
 
 void LightingApp::BuildRasterState()
@@ -312,61 +384,126 @@ void LightingApp::BuildWireFrameRasterState()
 	HR( md3dDevice->CreateRasterizerState( &wireframeDesc, &mRasterState ) );
 }
 
-bool LightingApp::ImportMeshFromFile( const std::string & filename, ID3D11Buffer** vertexBuffer, ID3D11Buffer** indexBuffer, UINT* indexCount )
+void LightingApp::UploadLoadedMesh( const XNA::MeshLoadResult& result )
 {
 	wchar_t msg[256];
 
-	Assimp::Importer importer;
+	if ( !result.Succeeded )
+	{
+		swprintf_s( msg, 256, L"Reading mesh file %hs failed.\n", result.FileName.c_str() );
+		OutputDebugString( msg );
+		return;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	// A mesh read from its cache is uploaded straight from the mapping, the others from the vectors.
+	const XNA::ImportedVertex* vertices = result.Cache ? result.Cache->GetVertices() : result.Mesh.Vertices.data();
+	UINT vertexCount = result.Cache ? result.Cache->GetVertexCount() : static_cast<UINT>( result.Mesh.Vertices.size() );
+	const UINT* indices = result.Cache ? result.Cache->GetIndices() : result.Mesh.Indices.data();
+	UINT indexCount = result.Cache ? result.Cache->GetIndexCount() : static_cast<UINT>( result.Mesh.Indices.size() );
+
+	ID3D11Buffer* vertexBuffer = NULL;
+	ID3D11Buffer* indexBuffer = NULL;
+	BufferHelper<XNA::ImportedVertex>::CreateVertexBuffer( &md3dDevice, vertices, vertexCount, &vertexBuffer );
+	BufferHelper<UINT>::CreateIndexBuffer( &md3dDevice, indices, indexCount, &indexBuffer );
 
-	const aiScene* scene = importer.ReadFile( filename, aiProcess_Triangulate );
-	if ( !scene )
+	double uploadMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
+
+	if ( result.Handle == mMonkeyLoad )
 	{
-		fprintf( stderr, "ERROR: reading mesh %s\n", filename );
-		return false;
+		// Swap the placeholder out
+		ReleaseCOM( mMonkeyVB );
+		ReleaseCOM( mMonkeyIB );
+		mMonkeyVB = vertexBuffer;
+		mMonkeyIB = indexBuffer;
+		mMonkeyVertexStride = sizeof( XNA::ImportedVertex );
+		mMonkeySubsets = result.Mesh.Subsets;
+	}
+	else
+	{
+		ReleaseCOM( vertexBuffer );
+		ReleaseCOM( indexBuffer );
 	}
 
-	swprintf_s( msg, 256, L"  %i meshes\n", scene->mNumMeshes );
+	swprintf_s( msg, 256, L"%hs: %u vertices, %u subsets%hs\n", result.FileName.c_str(), vertexCount,
+		static_cast<UINT>( result.Mesh.Subsets.size() ), result.Cache ? " (mesh cache, in place)" : "" );
+	OutputDebugString( msg );
+	swprintf_s( msg, 256, L"  wait %.2f ms, load %.2f ms, queue %.2f ms, upload %.2f ms; %u requests waiting, %u pending\n",
+		result.WaitMilliseconds, result.LoadMilliseconds, result.QueueMilliseconds, uploadMs,
+		mMeshLoader.GetQueueDepth(), mMeshLoader.GetPendingCount() );
 	OutputDebugString( msg );
+}
+
+// Runs on a loader thread: nothing here may touch the device, the context or the app.
+BOOL LightingApp::LoadMeshFile( const char* fileName, UINT threadCount, XNA::ImportedMesh* mesh, XNA::MeshCache* cache, VOID* context )
+{
+	// MeshLoader picks the reader: packed OBJ files straight from the archive mapping, loose ones
+	// through their binary cache, which stays open so the vertices and indices are uploaded from its
+	// mapping, other formats through Assimp reading from memory mappings.
+	const XNA::AssetArchive* assets = static_cast<const XNA::AssetArchive*>( context );
+	XNA::MappedIOSystem files;
+	if ( assets->IsOpen() )
+	{
+		files.MountArchive( assets );
+	}
+
+	// The PosNormal layout needs normals: files without them are often written with a vertex per
+	// face corner, so the vertices are merged first and the normals smoothed over the merged faces.
+	// A loose OBJ is cached that way, and later runs upload it from the mapping as well.
+	XNA::MeshMissingNormalOptions normals;
+	normals.Normals.CreaseAngle = XMConvertToRadians( MESH_CREASE_DEGREES );
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	XNA::SceneImportTimings timings;
+	if ( !XNA::LoadMeshFromFile( fileName, XNA::GetScenePostProcessFlags( MESH_IMPORT_PROFILE ), mesh, cache, threadCount,
+		&timings, &files, &normals ) )
+	{
+		return FALSE;
+	}
+	double ms = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - start ).count();
 
-	const aiMesh* mesh = scene->mMeshes[0];
-	swprintf_s( msg, 256, L"  %i vertices in mesh[0]\n", mesh->mNumVertices );
+	wchar_t msg[256];
+	for ( size_t i = 0; i < timings.Stages.size(); i++ )
+	{
+		swprintf_s( msg, 256, L"  %-24hs %8.2f ms\n", timings.Stages[i].Name, timings.Stages[i].Milliseconds );
+		OutputDebugString( msg );
+	}
+	swprintf_s( msg, 256, L"  %-24hs %8.2f ms%s\n", "load", ms, cache->IsOpen() ? L", from the mesh cache" : L"" );
 	OutputDebugString( msg );
 
-	std::vector<Vertex::PosNormal> vertices = std::vector<Vertex::PosNormal>( static_cast<size_t>( mesh->mNumVertices ) );
+	return TRUE;
+}
 
-	if ( mesh->HasPositions() )
+// Compiled shaders packed in the archive: stored ones are copied into the blob straight from the
+// mapping, compressed ones are extracted first.
+HRESULT LightingApp::LoadArchiveShader( const char* fileName, ID3DBlob** blob, void* context )
+{
+	const XNA::AssetArchive* assets = static_cast<const XNA::AssetArchive*>( context );
+	UINT entry;
+	if ( !assets->Find( fileName, &entry ) )
 	{
-		for ( int i = 0; i < mesh->mNumVertices; i++ )
-		{
-			const aiVector3D* pos = &( mesh->mVertices[i] );
-			vertices[i].Position = XMFLOAT3( pos->x, pos->y, pos->z );
-		}
+		return S_FALSE;
 	}
 
-	if ( mesh->HasNormals() )
+	const BYTE* data;
+	size_t size;
+	std::vector<BYTE> extracted;
+	if ( !assets->GetView( entry, &data, &size ) )
 	{
-		for ( int i = 0; i < mesh->mNumVertices; i++ )
+		if ( !assets->Extract( entry, &extracted ) )
 		{
-			const aiVector3D* normal = &( mesh->mNormals[i] );
-			vertices[i].Normal = XMFLOAT3( normal->x, normal->y, normal->z );
+			return S_FALSE;
 		}
+		data = extracted.empty() ? NULL : &extracted[0];
+		size = extracted.size();
 	}
 
-	std::vector<UINT> indices = std::vector<UINT>( mesh->mNumFaces * 3 );
-	for ( int i = 0; i < mesh->mNumFaces; i++ )
+	if ( FAILED( D3DCreateBlob( size, blob ) ) )
 	{
-		const aiFace& face = mesh->mFaces[i];
-		assert( face.mNumIndices == 3 );
-		indices[( i * 3 ) + 0] = face.mIndices[0];
-		indices[( i * 3 ) + 1] = face.mIndices[1];
-		indices[( i * 3 ) + 2] = face.mIndices[2];
+		return S_FALSE;
 	}
-	*indexCount = static_cast<UINT>( indices.size() );
 
-	swprintf_s( msg, 256, L"Complete reading mesh %s\n", filename );
-
-	BufferHelper<Vertex::PosNormal>::CreateVertexBuffer( &md3dDevice, vertices, vertexBuffer );
-	BufferHelper<UINT>::CreateIndexBuffer( &md3dDevice, indices, indexBuffer );
-
-	return true;
+	memcpy( ( *blob )->GetBufferPointer(), data, size );
+	return S_OK;
 }
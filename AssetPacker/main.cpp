@@ -0,0 +1,254 @@
+﻿//***************************************************************************************
+// main.cpp
+//
+// Command line packer of asset archives (Common/AssetArchive.h).
+//
+//   AssetPacker [-lz4] [-store ext,ext...] archive directory
+//       Packs every file under directory, named by its path relative to it.
+//       -lz4 compresses the entries it saves at least 1/8 of, except those
+//       with an extension of the -store list ("obj,mtl,cso" by default): the
+//       ones the demos use in place, from the mapping, without extracting.
+//
+//   AssetPacker -list archive
+//       Prints the entries of an archive.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "xnacollision.h"
+#include "AssetArchive.h"
+#include "MappedFile.h"
+
+using namespace XNA;
+
+static void PrintUsage()
+{
+	printf( "usage: AssetPacker [-lz4] [-store ext,ext...] archive directory\n" );
+	printf( "       AssetPacker -list archive\n" );
+}
+
+static bool ReadFileData( const std::string& path, std::vector<BYTE>* data )
+{
+	FILE* file = fopen( path.c_str(), "rb" );
+	if( !file )
+		return false;
+
+	fseek( file, 0, SEEK_END );
+	long size = ftell( file );
+	fseek( file, 0, SEEK_SET );
+
+	bool ok = size >= 0;
+	if( ok )
+	{
+		data->resize( size );
+		ok = size == 0 || fread( &( *data )[0], 1, size, file ) == size_t( size );
+	}
+	fclose( file );
+	return ok;
+}
+
+// Appends the paths of every file under directory, relative to it.
+static void ListFiles( const std::string& directory, const std::string& relative, std::vector<std::string>* files )
+{
+	std::string path = relative.empty() ? directory : directory + "/" + relative;
+
+#if defined( _WIN32 )
+	WIN32_FIND_DATAA found;
+	HANDLE find = FindFirstFileA( ( path + "/*" ).c_str(), &found );
+	if( find == INVALID_HANDLE_VALUE )
+		return;
+
+	do
+	{
+		std::string name = found.cFileName;
+		if( name == "." || name == ".." )
+			continue;
+
+		std::string child = relative.empty() ? name : relative + "/" + name;
+		if( found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+			ListFiles( directory, child, files );
+		else
+			files->push_back( child );
+	} while( FindNextFileA( find, &found ) );
+	FindClose( find );
+#else
+	DIR* dir = opendir( path.c_str() );
+	if( !dir )
+		return;
+
+	while( dirent* entry = readdir( dir ) )
+	{
+		std::string name = entry->d_name;
+		if( name == "." || name == ".." )
+			continue;
+
+		std::string child = relative.empty() ? name : relative + "/" + name;
+		struct stat info;
+		if( stat( ( directory + "/" + child ).c_str(), &info ) != 0 )
+			continue;
+
+		if( S_ISDIR( info.st_mode ) )
+			ListFiles( directory, child, files );
+		else if( S_ISREG( info.st_mode ) )
+			files->push_back( child );
+	}
+	closedir( dir );
+#endif
+}
+
+static bool HasExtension( const std::string& name, const std::vector<std::string>& extensions )
+{
+	size_t dot = name.find_last_of( '.' );
+	if( dot == std::string::npos || name.find( '/', dot ) != std::string::npos )
+		return false;
+
+	std::string extension = MakeAssetKey( name.c_str() + dot + 1 );
+	for( size_t i = 0; i < extensions.size(); ++i )
+	{
+		if( extension == extensions[i] )
+			return true;
+	}
+	return false;
+}
+
+static std::vector<std::string> SplitExtensions( const char* list )
+{
+	std::vector<std::string> extensions;
+	std::string extension;
+	for( const char* p = list;; ++p )
+	{
+		if( *p == ',' || *p == '\0' )
+		{
+			if( !extension.empty() )
+				extensions.push_back( MakeAssetKey( extension.c_str() ) );
+			extension.clear();
+			if( *p == '\0' )
+				break;
+		}
+		else if( *p != '.' || !extension.empty() )
+		{
+			extension += *p;
+		}
+	}
+	return extensions;
+}
+
+static int List( const char* archivePath )
+{
+	AssetArchive archive;
+	if( !archive.Open( archivePath ) )
+	{
+		printf( "cannot open %s\n", archivePath );
+		return 1;
+	}
+
+	printf( "%-16s %12s %12s %-6s %s\n", "name hash", "size", "stored", "codec", "name" );
+	for( UINT i = 0; i < archive.GetEntryCount(); ++i )
+	{
+		const AssetArchiveEntry& entry = archive.GetEntries()[i];
+		printf( "%016llx %12llu %12llu %-6s %s\n", ( unsigned long long )entry.NameHash,
+				( unsigned long long )entry.OriginalSize, ( unsigned long long )entry.Size,
+				entry.Compression == AssetLz4 ? "lz4" : "stored", archive.GetName( i ) );
+	}
+	printf( "%u entries\n", archive.GetEntryCount() );
+	return 0;
+}
+
+static int Pack( const char* archivePath, const char* directory, bool lz4, const std::vector<std::string>& store )
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	std::vector<std::string> files;
+	ListFiles( directory, "", &files );
+
+	std::string archiveKey = MakeAssetKey( archivePath );
+	std::vector<AssetArchiveSource> sources;
+	sources.reserve( files.size() );
+	UINT64 totalSize = 0;
+	for( size_t i = 0; i < files.size(); ++i )
+	{
+		std::string path = std::string( directory ) + "/" + files[i];
+		if( MakeAssetKey( path.c_str() ) == archiveKey )
+			continue;
+
+		sources.push_back( AssetArchiveSource() );
+		AssetArchiveSource& source = sources.back();
+		source.Name = files[i];
+		source.Compression = lz4 && !HasExtension( files[i], store ) ? AssetLz4 : AssetStored;
+		if( !ReadFileData( path, &source.Data ) )
+		{
+			printf( "cannot read %s\n", path.c_str() );
+			return 1;
+		}
+		totalSize += source.Data.size();
+	}
+
+	std::vector<BYTE> image;
+	if( !BuildAssetArchive( sources, &image ) )
+	{
+		printf( "two files have the same name once case and separators are ignored\n" );
+		return 1;
+	}
+
+	if( !WriteFileAtomic( archivePath, &image[0], image.size() ) )
+	{
+		printf( "cannot write %s\n", archivePath );
+		return 1;
+	}
+
+	AssetArchive archive;
+	UINT compressed = 0;
+	if( archive.Open( archivePath ) )
+	{
+		for( UINT i = 0; i < archive.GetEntryCount(); ++i )
+			compressed += archive.GetEntries()[i].Compression != AssetStored;
+	}
+
+	double seconds = std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - start ).count();
+	printf( "%u files, %.2f MB -> %s %.2f MB (%u compressed) in %.2f s\n", UINT( sources.size() ),
+			totalSize / ( 1024.0 * 1024.0 ), archivePath, image.size() / ( 1024.0 * 1024.0 ), compressed, seconds );
+	return 0;
+}
+
+int main( int argc, char** argv )
+{
+	if( argc == 3 && strcmp( argv[1], "-list" ) == 0 )
+		return List( argv[2] );
+
+	bool lz4 = false;
+	std::vector<std::string> store = SplitExtensions( "obj,mtl,cso" );
+	int arg = 1;
+	for( ; arg < argc && argv[arg][0] == '-'; ++arg )
+	{
+		if( strcmp( argv[arg], "-lz4" ) == 0 )
+			lz4 = true;
+		else if( strcmp( argv[arg], "-store" ) == 0 && arg + 1 < argc )
+			store = SplitExtensions( argv[++arg] );
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if( argc - arg != 2 )
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	return Pack( argv[arg], argv[arg + 1], lz4, store );
+}
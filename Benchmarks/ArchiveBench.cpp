@@ -0,0 +1,252 @@
+﻿//***************************************************************************************
+// ArchiveBench.cpp
+//
+// Reading kFiles small assets (a few KB of shader or OBJ like text each) as
+// loose files, with an fopen, fseek, ftell, fread and fclose per file, against
+// one AssetArchive: open and map the archive, then a Find per asset and either
+// a view into the mapping (stored) or an extraction (LZ4). Every case reads
+// all the bytes of every asset, so the views are really paged in.
+//
+// The files and the archive are in the page cache: this is the cost of the
+// calls and of the lookups, not of the disk. On a cold start the loose files
+// also pay a directory lookup and a seek each, the archive one sequential file.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "xnacollision.h"
+#include "AssetArchive.h"
+#include "MappedFile.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const UINT kFiles = 2000;
+	const UINT kMinSize = 1024;
+	const UINT kMaxSize = 16 * 1024;
+	const int kRepeats = 5;
+
+	const char* kStoredArchive = "ArchiveBenchStored.pak";
+	const char* kLz4Archive = "ArchiveBenchLz4.pak";
+
+	std::string AssetPath( UINT i )
+	{
+		char path[64];
+		snprintf( path, sizeof( path ), "ArchiveBench%04u.txt", i );
+		return path;
+	}
+
+	// Lines of a few words from a small vocabulary, like shader sources or OBJ
+	// files: about as compressible as the real assets.
+	void MakeAsset( BenchRandom& random, std::vector<BYTE>* data )
+	{
+		static const char* const words[] =
+		{
+			"float4", "float3", "return", "mul(", "normalize(", "saturate(", "v", "vn", "vt", "f",
+			"0.125", "-1.5", "0.70710678", "gWorld", "gViewProj", "input.PosL", "output.NormalW", ";",
+		};
+		const UINT wordCount = UINT( BenchCountOf( words ) );
+
+		size_t size = kMinSize + random.Next() % ( kMaxSize - kMinSize );
+		data->clear();
+		while( data->size() < size )
+		{
+			UINT lineWords = 2 + random.Next() % 6;
+			for( UINT w = 0; w < lineWords; ++w )
+			{
+				const char* word = words[random.Next() % wordCount];
+				data->insert( data->end(), word, word + strlen( word ) );
+				data->push_back( w + 1 < lineWords ? ' ' : '\n' );
+			}
+		}
+		data->resize( size );
+	}
+
+	UINT64 Touch( const BYTE* data, size_t size )
+	{
+		UINT64 sum = 0;
+		for( size_t i = 0; i < size; ++i )
+			sum += data[i];
+		return sum;
+	}
+
+	UINT64 ReadLoose( const std::vector<std::string>& names, std::vector<BYTE>* buffer )
+	{
+		UINT64 sum = 0;
+		for( size_t i = 0; i < names.size(); ++i )
+		{
+			FILE* file = fopen( names[i].c_str(), "rb" );
+			if( !file )
+				continue;
+
+			fseek( file, 0, SEEK_END );
+			long size = ftell( file );
+			fseek( file, 0, SEEK_SET );
+			buffer->resize( size );
+			if( size > 0 && fread( &( *buffer )[0], 1, size, file ) == size_t( size ) )
+				sum += Touch( &( *buffer )[0], size );
+			fclose( file );
+		}
+		return sum;
+	}
+
+	UINT64 ReadArchive( const char* path, const std::vector<std::string>& names, std::vector<BYTE>* buffer )
+	{
+		AssetArchive archive;
+		if( !archive.Open( path ) )
+			return 0;
+
+		UINT64 sum = 0;
+		for( size_t i = 0; i < names.size(); ++i )
+		{
+			UINT index;
+			if( !archive.Find( names[i].c_str(), &index ) )
+				continue;
+
+			const BYTE* data;
+			size_t size;
+			if( archive.GetView( index, &data, &size ) )
+				sum += Touch( data, size );
+			else if( archive.Extract( index, buffer ) && !buffer->empty() )
+				sum += Touch( &( *buffer )[0], buffer->size() );
+		}
+		return sum;
+	}
+
+	template <class Function>
+	double Time( Function function )
+	{
+		double best = 0.0;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			BenchTimer timer;
+			function();
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+
+	void RemoveFiles( const std::vector<std::string>& names )
+	{
+		for( size_t i = 0; i < names.size(); ++i )
+			remove( names[i].c_str() );
+		remove( kStoredArchive );
+		remove( kLz4Archive );
+	}
+}
+
+void RunArchiveBenchmarks()
+{
+	BenchRandom random;
+	std::vector<std::string> names;
+	std::vector<AssetArchiveSource> stored( kFiles );
+	UINT64 totalBytes = 0;
+	for( UINT i = 0; i < kFiles; ++i )
+	{
+		names.push_back( AssetPath( i ) );
+		stored[i].Name = names[i];
+		stored[i].Compression = AssetStored;
+		MakeAsset( random, &stored[i].Data );
+		totalBytes += stored[i].Data.size();
+
+		FILE* file = fopen( names[i].c_str(), "wb" );
+		bool written = file && fwrite( &stored[i].Data[0], 1, stored[i].Data.size(), file ) == stored[i].Data.size();
+		if( file )
+			fclose( file );
+		if( !written )
+		{
+			printf( "cannot write %s\n", names[i].c_str() );
+			RemoveFiles( names );
+			return;
+		}
+	}
+
+	std::vector<AssetArchiveSource> lz4 = stored;
+	for( UINT i = 0; i < kFiles; ++i )
+		lz4[i].Compression = AssetLz4;
+
+	std::vector<BYTE> storedImage, lz4Image;
+	double packStoredMs = Time( [&]() { BuildAssetArchive( stored, &storedImage ); } );
+	double packLz4Ms = Time( [&]() { BuildAssetArchive( lz4, &lz4Image ); } );
+	if( !WriteFileAtomic( kStoredArchive, &storedImage[0], storedImage.size() ) ||
+		!WriteFileAtomic( kLz4Archive, &lz4Image[0], lz4Image.size() ) )
+	{
+		printf( "cannot write the archives\n" );
+		RemoveFiles( names );
+		return;
+	}
+
+	double megabytes = totalBytes / ( 1024.0 * 1024.0 );
+	printf( "%u files, %.2f MB, files and archives in the page cache\n", kFiles, megabytes );
+	printf( "%-16s %10s %10s %9s\n", "pack", "ms", "MB", "ratio" );
+	printf( "%-16s %10.2f %10.2f %9.3f\n", "stored", packStoredMs, storedImage.size() / ( 1024.0 * 1024.0 ),
+			double( storedImage.size() ) / totalBytes );
+	printf( "%-16s %10.2f %10.2f %9.3f\n", "lz4", packLz4Ms, lz4Image.size() / ( 1024.0 * 1024.0 ),
+			double( lz4Image.size() ) / totalBytes );
+
+	std::vector<BYTE> buffer;
+	UINT64 looseSum = 0, storedSum = 0, lz4Sum = 0;
+
+	// Once each to bring the files into the page cache.
+	ReadLoose( names, &buffer );
+	ReadArchive( kStoredArchive, names, &buffer );
+	ReadArchive( kLz4Archive, names, &buffer );
+
+	double looseMs = Time( [&]() { looseSum = ReadLoose( names, &buffer ); } );
+	double storedMs = Time( [&]() { storedSum = ReadArchive( kStoredArchive, names, &buffer ); } );
+	double lz4Ms = Time( [&]() { lz4Sum = ReadArchive( kLz4Archive, names, &buffer ); } );
+
+	printf( "\n%-16s %10s %10s %12s %8s  %s\n", "read all", "ms", "us/file", "MB/s", "speedup", "check" );
+	struct { const char* name; double ms; UINT64 sum; } cases[] =
+	{
+		{ "loose files", looseMs, looseSum },
+		{ "archive stored", storedMs, storedSum },
+		{ "archive lz4", lz4Ms, lz4Sum },
+	};
+	for( size_t c = 0; c < BenchCountOf( cases ); ++c )
+	{
+		printf( "%-16s %10.2f %10.2f %12.1f %7.2fx  %s\n", cases[c].name, cases[c].ms, cases[c].ms * 1000.0 / kFiles,
+				megabytes * 1000.0 / cases[c].ms, looseMs / cases[c].ms, cases[c].sum == looseSum ? "same" : "DIFFERENT" );
+	}
+
+	// The parts of an archive read: the lookups alone, and the LZ4 decoding alone.
+	AssetArchive archive;
+	double findNs = 0.0, decodeGBs = 0.0;
+	if( archive.Open( kLz4Archive ) )
+	{
+		std::vector<UINT> indices( kFiles );
+		double findMs = Time( [&]()
+		{
+			for( UINT i = 0; i < kFiles; ++i )
+				archive.Find( names[i].c_str(), &indices[i] );
+		} );
+		double decodeMs = Time( [&]()
+		{
+			for( UINT i = 0; i < kFiles; ++i )
+				archive.Extract( indices[i], &buffer );
+		} );
+		findNs = findMs * 1e6 / kFiles;
+		decodeGBs = totalBytes / ( decodeMs * 1e6 );
+		printf( "\nFind %.0f ns per lookup, LZ4 extract %.2f GB/s of output\n", findNs, decodeGBs );
+	}
+	archive.Close();
+
+	RemoveFiles( names );
+
+	BenchRecord( "archive loose read all", looseMs, "ms" );
+	BenchRecord( "archive stored read all", storedMs, "ms" );
+	BenchRecord( "archive lz4 read all", lz4Ms, "ms" );
+	BenchRecord( "archive pack lz4", packLz4Ms, "ms" );
+	BenchRecord( "archive lz4 ratio", double( lz4Image.size() ) / totalBytes, "ratio" );
+	BenchRecord( "archive find", findNs, "ns" );
+	BenchRecord( "archive lz4 decode", decodeGBs, "GB/s" );
+}
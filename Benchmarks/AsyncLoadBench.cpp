@@ -0,0 +1,203 @@
+﻿//***************************************************************************************
+// AsyncLoadBench.cpp
+//
+// Startup with kAssets generated OBJ tori of growing size, loaded the way the
+// demos did (one after the other inside Init, the first frame waits for all of
+// them) against AsyncMeshLoader: every file requested at once, then a frame
+// loop that drains the completion queue and copies the finished meshes into
+// "GPU" memory, as UpdateScene uploads them.
+//
+//   first frame   time until the frame loop can start
+//   all loaded    time until the last mesh is uploaded
+//   worst frame   longest frame of the loop, drain and copies included
+//   max depth     most requests waiting for a worker at a frame start
+//
+// The table after it is the time per asset of the default worker count: wait
+// for a worker, load on the worker, wait in the completion queue.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "xnacollision.h"
+#include "AsyncMeshLoader.h"
+#include "ObjLoader.h"
+#include "ParallelFor.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const UINT kAssets = 6;
+	const UINT kBaseRings = 100;
+	const UINT kRingStep = 100;
+	const UINT kSides = 200;
+
+	// The frame loop does no rendering, only a short sleep per frame.
+	const int kFrameSleepMs = 1;
+
+	std::string AssetPath( UINT i )
+	{
+		char path[64];
+		snprintf( path, sizeof( path ), "AsyncLoadBench%u.obj", i );
+		return path;
+	}
+
+	BOOL LoadObj( const char* fileName, UINT threadCount, ImportedMesh* mesh, MeshCache* cache, VOID* context )
+	{
+		return LoadObjFile( fileName, mesh, threadCount );
+	}
+
+	// Stands in for the vertex and index buffer creation.
+	void Upload( const ImportedMesh& mesh, std::vector<BYTE>* gpu )
+	{
+		size_t vertexBytes = mesh.Vertices.size() * sizeof( ImportedVertex );
+		size_t indexBytes = mesh.Indices.size() * sizeof( UINT );
+		gpu->resize( vertexBytes + indexBytes );
+		if( vertexBytes )
+			memcpy( &( *gpu )[0], &mesh.Vertices[0], vertexBytes );
+		if( indexBytes )
+			memcpy( &( *gpu )[vertexBytes], &mesh.Indices[0], indexBytes );
+	}
+
+	struct StartupResult
+	{
+		double firstFrameMs;
+		double allLoadedMs;
+		double worstFrameMs;
+		UINT maxDepth;
+		UINT frames;
+		UINT loaded;
+	};
+
+	StartupResult RunSync( const std::vector<std::string>& assets )
+	{
+		StartupResult result = {};
+		std::vector<BYTE> gpu;
+
+		BenchTimer timer;
+		for( size_t i = 0; i < assets.size(); ++i )
+		{
+			ImportedMesh mesh;
+			if( LoadObjFile( assets[i].c_str(), &mesh ) )
+			{
+				Upload( mesh, &gpu );
+				result.loaded++;
+			}
+		}
+		result.firstFrameMs = result.allLoadedMs = result.worstFrameMs = timer.ElapsedMs();
+		result.maxDepth = UINT( assets.size() );
+		return result;
+	}
+
+	StartupResult RunAsync( const std::vector<std::string>& assets, UINT workers, std::vector<MeshLoadResult>* perAsset )
+	{
+		StartupResult result = {};
+		std::vector<BYTE> gpu;
+
+		BenchTimer timer;
+		AsyncMeshLoader loader;
+		loader.Start( LoadObj, NULL, workers );
+		for( size_t i = 0; i < assets.size(); ++i )
+			loader.Request( assets[i].c_str() );
+		result.firstFrameMs = timer.ElapsedMs();
+
+		std::vector<MeshLoadResult> drained;
+		while( loader.GetPendingCount() > 0 )
+		{
+			BenchTimer frame;
+			result.maxDepth = ( std::max )( result.maxDepth, loader.GetQueueDepth() );
+
+			drained.clear();
+			loader.DrainCompleted( &drained );
+			for( size_t i = 0; i < drained.size(); ++i )
+			{
+				if( drained[i].Succeeded )
+				{
+					Upload( drained[i].Mesh, &gpu );
+					result.loaded++;
+				}
+				drained[i].Mesh = ImportedMesh();
+				if( perAsset )
+					perAsset->push_back( std::move( drained[i] ) );
+			}
+
+			std::this_thread::sleep_for( std::chrono::milliseconds( kFrameSleepMs ) );
+			result.worstFrameMs = ( std::max )( result.worstFrameMs, frame.ElapsedMs() );
+			result.frames++;
+		}
+		result.allLoadedMs = timer.ElapsedMs();
+		return result;
+	}
+
+	void Print( const char* name, const StartupResult& result )
+	{
+		printf( "%-14s %12.3f %12.1f %12.2f %9u %7u %6u/%u\n", name, result.firstFrameMs, result.allLoadedMs,
+				result.worstFrameMs, result.maxDepth, result.frames, result.loaded, kAssets );
+	}
+}
+
+void RunAsyncLoadBenchmarks()
+{
+	std::vector<std::string> assets;
+	double megabytes = 0.0;
+	for( UINT i = 0; i < kAssets; ++i )
+	{
+		long size = 0;
+		assets.push_back( AssetPath( i ) );
+		if( !WriteBenchTorusObj( assets[i].c_str(), kBaseRings + kRingStep * i, kSides, &size ) )
+		{
+			printf( "cannot write %s\n", assets[i].c_str() );
+			for( UINT j = 0; j <= i; ++j )
+				remove( assets[j].c_str() );
+			return;
+		}
+		megabytes += size / ( 1024.0 * 1024.0 );
+	}
+
+	UINT workers = ( std::max )( GetWorkerThreadCount() / 2, 1u );
+	printf( "%u OBJ files, %.1f MB, %u hardware threads, files in the page cache\n", kAssets, megabytes,
+			GetWorkerThreadCount() );
+	printf( "%-14s %12s %12s %12s %9s %7s %8s\n", "startup", "first frame", "all loaded", "worst frame", "max depth",
+			"frames", "loaded" );
+
+	// Once to bring the files into the page cache.
+	RunSync( assets );
+
+	StartupResult sync = RunSync( assets );
+	Print( "sync in Init", sync );
+
+	StartupResult single = RunAsync( assets, 1, NULL );
+	Print( "async, 1 wkr", single );
+
+	std::vector<MeshLoadResult> perAsset;
+	StartupResult async = RunAsync( assets, workers, &perAsset );
+	char name[32];
+	snprintf( name, sizeof( name ), "async, %u wkr", workers );
+	Print( name, async );
+
+	printf( "\nper asset, %u workers\n", workers );
+	printf( "%-22s %10s %10s %10s\n", "file", "wait ms", "load ms", "queue ms" );
+	for( size_t i = 0; i < perAsset.size(); ++i )
+	{
+		printf( "%-22s %10.2f %10.2f %10.2f\n", perAsset[i].FileName.c_str(), perAsset[i].WaitMilliseconds,
+				perAsset[i].LoadMilliseconds, perAsset[i].QueueMilliseconds );
+	}
+
+	BenchRecord( "asyncload sync first frame", sync.firstFrameMs, "ms" );
+	BenchRecord( "asyncload async first frame", async.firstFrameMs, "ms" );
+	BenchRecord( "asyncload sync all loaded", sync.allLoadedMs, "ms" );
+	BenchRecord( "asyncload async all loaded", async.allLoadedMs, "ms" );
+	BenchRecord( "asyncload async worst frame", async.worstFrameMs, "ms" );
+	BenchRecord( "asyncload async 1 worker all loaded", single.allLoadedMs, "ms" );
+
+	for( UINT i = 0; i < kAssets; ++i )
+		remove( assets[i].c_str() );
+}
@@ -0,0 +1,95 @@
+﻿//***************************************************************************************
+// Benchmark.h
+//
+// Shared helpers of the console benchmark runner: a wall clock timer, a
+// deterministic random generator, the JSON report and the entry points of the
+// suites.
+//***************************************************************************************
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <cstddef>
+
+class BenchTimer
+{
+public:
+	BenchTimer() { Reset(); }
+
+	void Reset() { mStart = std::chrono::high_resolution_clock::now(); }
+
+	// Milliseconds since construction or the last Reset.
+	double ElapsedMs() const
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - mStart;
+		return elapsed.count();
+	}
+
+private:
+	std::chrono::high_resolution_clock::time_point mStart;
+};
+
+// Number of elements of a fixed size array.
+template <class T, size_t N>
+inline size_t BenchCountOf( const T ( & )[N] ) { return N; }
+
+// Small xorshift generator so every run sees the same scenes, whatever the CRT.
+class BenchRandom
+{
+public:
+	explicit BenchRandom( unsigned int seed = 0x12345678 ) : mState( seed ? seed : 1 ) {}
+
+	unsigned int Next()
+	{
+		mState ^= mState << 13;
+		mState ^= mState >> 17;
+		mState ^= mState << 5;
+		return mState;
+	}
+
+	// Uniform in [a, b].
+	float Range( float a, float b ) { return a + ( b - a ) * ( Next() & 0xffffff ) / float( 0xffffff ); }
+
+private:
+	unsigned int mState;
+};
+
+// Adds a result to the report written by --json. The suite currently running
+// is recorded along with it.
+void BenchRecord( const char* name, double value, const char* unit );
+
+// Writes an OBJ torus of rings x sides quads with positions, normals and
+// texture coordinates, about 170 bytes per quad; *pSize gets the file size.
+bool WriteBenchTorusObj( const char* path, unsigned int rings, unsigned int sides, long* pSize );
+
+// Path of Common/meshes/suzanne.obj, found from the repository root, from a
+// build directory one or two levels below it or next to the executable; NULL
+// if it is in none of them.
+const char* FindBenchMeshFile();
+
+// Suites, one per source file.
+void RunBroadphaseBenchmarks();
+void RunRayPacketBenchmarks();
+void RunBoundsBenchmarks();
+void RunCollisionBenchmarks();
+void RunCullBenchmarks();
+void RunTransformBenchmarks();
+void RunHashGridBenchmarks();
+void RunBoxStackBenchmarks();
+void RunSweepBenchmarks();
+void RunConvexBenchmarks();
+void RunHullBenchmarks();
+void RunDistanceFieldBenchmarks();
+void RunObjBenchmarks();
+void RunMeshCacheBenchmarks();
+void RunSceneBenchmarks();
+void RunAsyncLoadBenchmarks();
+void RunArchiveBenchmarks();
+void RunMeshLoadBenchmarks();
+void RunWeldBenchmarks();
+void RunTangentBenchmarks();
+void RunMeshCodecBenchmarks();
+void RunTreeBenchmarks();
+
+#endif // BENCHMARK_H
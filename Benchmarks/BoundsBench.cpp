@@ -0,0 +1,119 @@
+﻿//***************************************************************************************
+// BoundsBench.cpp
+//
+// Time and tightness of the bounding volume construction routines: the serial
+// and multithreaded sphere, box and oriented box reductions, and the exact
+// (Welzl) sphere against the Ritter approximation.
+//***************************************************************************************
+
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "ParallelFor.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const int kRepeats = 3;
+
+	// A rotated, stretched blob of points, roughly what a scanned mesh looks like.
+	void BuildPoints( std::vector<XMFLOAT3>& points, UINT count )
+	{
+		BenchRandom rng;
+		XMMATRIX rotation = XMMatrixRotationRollPitchYaw( 0.3f, 0.7f, 0.1f );
+
+		points.resize( count );
+		for( UINT i = 0; i < count; ++i )
+		{
+			// Sum of uniforms, close enough to a gaussian.
+			float x = rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f );
+			float y = rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f );
+			float z = rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f );
+
+			XMVECTOR p = XMVectorSet( x * 8.0f, y * 3.0f, z, 0.0f );
+			XMStoreFloat3( &points[i], XMVector3TransformCoord( p, rotation ) + XMVectorSet( 100.0f, 5.0f, -20.0f, 0.0f ) );
+		}
+	}
+
+	void PrintRow( const char* method, UINT count, double ms, const char* sizeName, float size )
+	{
+		printf( "%-22s %9u %10.3f %12.1f  %s %.4f\n", method, count, ms, count / ( ms * 1000.0 ), sizeName, size );
+
+		char name[64];
+		snprintf( name, sizeof( name ), "%s %u", method, count );
+		BenchRecord( name, ms, "ms" );
+	}
+
+	// Best of kRepeats runs.
+	template<typename Build>
+	double Time( Build build )
+	{
+		double best = 0.0;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			BenchTimer timer;
+			build();
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+
+	float Volume( const XMFLOAT3& extents )
+	{
+		return 8.0f * extents.x * extents.y * extents.z;
+	}
+}
+
+void RunBoundsBenchmarks()
+{
+	static const UINT counts[] = { 10000, 100000, 1000000, 4000000 };
+
+	printf( "%u hardware threads, best of %d runs\n", GetWorkerThreadCount(), kRepeats );
+	printf( "%-22s %9s %10s %12s  %s\n", "method", "points", "ms", "points/us", "size" );
+
+	std::vector<XMFLOAT3> points;
+
+	for( size_t c = 0; c < BenchCountOf( counts ); ++c )
+	{
+		UINT count = counts[c];
+		BuildPoints( points, count );
+
+		const XMFLOAT3* p = &points[0];
+		const UINT stride = sizeof( XMFLOAT3 );
+
+		Sphere ritter, ritterMT, exact;
+		double ms;
+
+		ms = Time( [&]() { ComputeBoundingSphereFromPoints( &ritter, count, p, stride ); } );
+		PrintRow( "sphere ritter (1T)", count, ms, "radius", ritter.Radius );
+
+		ms = Time( [&]() { ComputeBoundingSphereFromPointsParallel( &ritterMT, count, p, stride, 0 ); } );
+		PrintRow( "sphere ritter (MT)", count, ms, "radius", ritterMT.Radius );
+
+		ms = Time( [&]() { ComputeMinimumBoundingSphereFromPoints( &exact, count, p, stride ); } );
+		PrintRow( "sphere welzl (exact)", count, ms, "radius", exact.Radius );
+
+		AxisAlignedBox box, boxMT;
+
+		ms = Time( [&]() { ComputeBoundingAxisAlignedBoxFromPoints( &box, count, p, stride ); } );
+		PrintRow( "aabb (1T)", count, ms, "volume", Volume( box.Extents ) );
+
+		ms = Time( [&]() { ComputeBoundingAxisAlignedBoxFromPointsParallel( &boxMT, count, p, stride, 0 ); } );
+		PrintRow( "aabb (MT)", count, ms, "volume", Volume( boxMT.Extents ) );
+
+		OrientedBox obb, obbMT;
+
+		ms = Time( [&]() { ComputeBoundingOrientedBoxFromPoints( &obb, count, p, stride ); } );
+		PrintRow( "obb (1T)", count, ms, "volume", Volume( obb.Extents ) );
+
+		ms = Time( [&]() { ComputeBoundingOrientedBoxFromPointsParallel( &obbMT, count, p, stride, 0 ); } );
+		PrintRow( "obb (MT)", count, ms, "volume", Volume( obbMT.Extents ) );
+
+		printf( "ritter radius is %.2f%% above the exact radius\n\n", ( ritter.Radius / exact.Radius - 1.0f ) * 100.0f );
+	}
+}
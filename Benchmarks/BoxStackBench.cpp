@@ -0,0 +1,174 @@
+﻿//***************************************************************************************
+// BoxStackBench.cpp
+//
+// Narrowphase of resting box stacks: towers of slightly rotated boxes that wobble
+// a little every frame, packed closely enough that neighbouring towers overlap
+// in the broadphase. The pairs found by SweepAndPrune are tested with
+// IntersectOrientedBoxOrientedBox every frame, and with an OrientedBoxPairCache
+// that starts with the axis that separated each pair the frame before.
+//***************************************************************************************
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "SweepAndPrune.h"
+#include "OrientedBoxPairCache.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const int kFrames = 100;
+
+	const float kHalfHeight = 0.25f;
+	const float kGap = 0.01f;				// Between the layers of a tower.
+	const float kSpacing = 1.04f;			// Between the tower centers.
+	const float kWobble = 0.006f;			// Radians.
+
+	struct Stack
+	{
+		std::vector<OrientedBox> boxes;
+		std::vector<AxisAlignedBox> bounds;
+		std::vector<float> yaw;
+		std::vector<float> phase;
+	};
+
+	void BuildStack( Stack& stack, UINT towers, UINT height )
+	{
+		BenchRandom rng;
+
+		UINT count = towers * towers * height;
+		stack.boxes.resize( count );
+		stack.bounds.resize( count );
+		stack.yaw.resize( count );
+		stack.phase.resize( count );
+
+		UINT i = 0;
+		for( UINT x = 0; x < towers; ++x )
+		{
+			for( UINT z = 0; z < towers; ++z )
+			{
+				for( UINT y = 0; y < height; ++y, ++i )
+				{
+					OrientedBox& box = stack.boxes[i];
+					box.Center = XMFLOAT3( x * kSpacing, kHalfHeight + y * ( 2.0f * kHalfHeight + kGap ), z * kSpacing );
+					box.Extents = XMFLOAT3( 0.5f, kHalfHeight, 0.5f );
+					stack.yaw[i] = rng.Range( -0.1f, 0.1f );
+					stack.phase[i] = rng.Range( 0.0f, XM_2PI );
+				}
+			}
+		}
+	}
+
+	// Every box rocks a little around its resting orientation.
+	void StepStack( Stack& stack, int frame )
+	{
+		for( size_t i = 0; i < stack.boxes.size(); ++i )
+		{
+			float t = stack.phase[i] + frame * 0.1f;
+
+			XMVECTOR rotation = XMQuaternionRotationRollPitchYaw( kWobble * sinf( t ), stack.yaw[i] + kWobble * cosf( t ),
+																  kWobble * sinf( 1.3f * t ) );
+			XMStoreFloat4( &stack.boxes[i].Orientation, rotation );
+
+			// Bounds of the rotated box.
+			XMMATRIX m = XMMatrixRotationQuaternion( rotation );
+			XMVECTOR extents = XMLoadFloat3( &stack.boxes[i].Extents );
+			XMVECTOR bounds = XMVectorAbs( m.r[0] ) * XMVectorSplatX( extents ) +
+							  XMVectorAbs( m.r[1] ) * XMVectorSplatY( extents ) +
+							  XMVectorAbs( m.r[2] ) * XMVectorSplatZ( extents );
+
+			stack.bounds[i].Center = stack.boxes[i].Center;
+			XMStoreFloat3( &stack.bounds[i].Extents, bounds );
+		}
+	}
+
+	void RunStack( UINT towers, UINT height )
+	{
+		Stack stack;
+		BuildStack( stack, towers, height );
+
+		UINT count = UINT( stack.boxes.size() );
+
+		SweepAndPrune broadphase;
+		OrientedBoxPairCache cache;
+		std::vector<ProxyPair> pairs, hits, expected;
+
+		double plainMs = 0.0, cachedMs = 0.0;
+		size_t pairCount = 0, plainHits = 0;
+		UINT mismatches = 0;
+
+		for( int frame = 0; frame < kFrames; ++frame )
+		{
+			StepStack( stack, frame );
+			broadphase.FindPairs( &stack.bounds[0], count, &pairs );
+			pairCount += pairs.size();
+
+			// The first frame fills the cache.
+			if( frame == 1 )
+				cache.ResetStats();
+
+			std::vector<BYTE> plain( pairs.size() );
+
+			BenchTimer timer;
+			for( size_t p = 0; p < pairs.size(); ++p )
+				plain[p] = IntersectOrientedBoxOrientedBox( &stack.boxes[pairs[p].ProxyA], &stack.boxes[pairs[p].ProxyB] ) ? 1 : 0;
+			double ms = timer.ElapsedMs();
+			if( frame > 0 )
+				plainMs += ms;
+
+			hits.clear();
+			timer.Reset();
+			cache.FilterPairs( &stack.boxes[0], &pairs[0], UINT( pairs.size() ), &hits );
+			cache.EndFrame();
+			ms = timer.ElapsedMs();
+			if( frame > 0 )
+				cachedMs += ms;
+
+			// Both must keep the same pairs, in the same order.
+			expected.clear();
+			for( size_t p = 0; p < pairs.size(); ++p )
+			{
+				if( plain[p] )
+					expected.push_back( pairs[p] );
+			}
+
+			bool same = expected.size() == hits.size();
+			for( size_t p = 0; same && p < hits.size(); ++p )
+				same = expected[p].ProxyA == hits[p].ProxyA && expected[p].ProxyB == hits[p].ProxyB;
+
+			plainHits += expected.size();
+			if( !same )
+				mismatches++;
+		}
+
+		plainMs /= kFrames - 1;
+		cachedMs /= kFrames - 1;
+
+		printf( "%u boxes (%ux%u towers of %u), %.0f pairs/frame, %.1f%% intersecting\n", count, towers, towers, height,
+				double( pairCount ) / kFrames, 100.0 * plainHits / pairCount );
+		printf( "  full SAT      %8.3f ms/frame\n", plainMs );
+		printf( "  cached axis   %8.3f ms/frame  speedup %.2fx, axis hit rate %.1f%% of %llu tests\n", cachedMs,
+				plainMs / cachedMs, 100.0 * cache.GetHitRate(), ( unsigned long long )cache.GetTests() );
+		printf( "  %u frames differ, %u cached pairs\n\n", mismatches, cache.GetPairCount() );
+
+		char name[64];
+		snprintf( name, sizeof( name ), "full SAT %u", count );
+		BenchRecord( name, plainMs, "ms" );
+		snprintf( name, sizeof( name ), "cached axis %u", count );
+		BenchRecord( name, cachedMs, "ms" );
+		snprintf( name, sizeof( name ), "axis hit rate %u", count );
+		BenchRecord( name, 100.0 * cache.GetHitRate(), "%" );
+	}
+}
+
+void RunBoxStackBenchmarks()
+{
+	printf( "%d frames, %.3f gap between layers, towers %.2f apart\n\n", kFrames, kGap, kSpacing );
+
+	RunStack( 10, 10 );
+	RunStack( 32, 10 );
+}
@@ -0,0 +1,207 @@
+﻿//***************************************************************************************
+// BroadphaseBench.cpp
+//
+// Moving boxes in a closed room: all pairs IntersectAxisAlignedBoxAxisAlignedBox
+// against SweepAndPrune (one thread and all threads) and DynamicAabbTree.
+//***************************************************************************************
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "SweepAndPrune.h"
+#include "DynamicAabbTree.h"
+#include "ParallelFor.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const int kFrames = 30;
+
+	// Brute force is quadratic: fewer frames, and skipped above this count.
+	const int kBruteForceFrames = 3;
+	const UINT kMaxBruteForce = 20000;
+
+	struct Scene
+	{
+		std::vector<AxisAlignedBox> boxes;
+		std::vector<XMFLOAT3> velocities;
+		float size;
+	};
+
+	// Roughly constant density: the room grows with the object count.
+	void BuildScene( Scene& scene, UINT count )
+	{
+		BenchRandom rng( count );
+
+		scene.size = 4.0f * powf( float( count ), 1.0f / 3.0f );
+		scene.boxes.resize( count );
+		scene.velocities.resize( count );
+
+		for( UINT i = 0; i < count; ++i )
+		{
+			scene.boxes[i].Center = XMFLOAT3( rng.Range( 0.0f, scene.size ), rng.Range( 0.0f, scene.size ), rng.Range( 0.0f, scene.size ) );
+			scene.boxes[i].Extents = XMFLOAT3( rng.Range( 0.2f, 1.0f ), rng.Range( 0.2f, 1.0f ), rng.Range( 0.2f, 1.0f ) );
+			scene.velocities[i] = XMFLOAT3( rng.Range( -0.05f, 0.05f ), rng.Range( -0.05f, 0.05f ), rng.Range( -0.05f, 0.05f ) );
+		}
+	}
+
+	// Every object moves every frame and bounces off the walls.
+	void StepScene( Scene& scene )
+	{
+		for( size_t i = 0; i < scene.boxes.size(); ++i )
+		{
+			float* c = &scene.boxes[i].Center.x;
+			float* v = &scene.velocities[i].x;
+
+			for( int a = 0; a < 3; ++a )
+			{
+				c[a] += v[a];
+				if( c[a] < 0.0f || c[a] > scene.size )
+					v[a] = -v[a];
+			}
+		}
+	}
+
+	UINT BruteForcePairs( const Scene& scene )
+	{
+		UINT count = UINT( scene.boxes.size() );
+		UINT pairs = 0;
+
+		for( UINT i = 0; i < count; ++i )
+		{
+			for( UINT j = i + 1; j < count; ++j )
+			{
+				if( IntersectAxisAlignedBoxAxisAlignedBox( &scene.boxes[i], &scene.boxes[j] ) )
+					++pairs;
+			}
+		}
+
+		return pairs;
+	}
+
+	void PrintRow( const char* method, UINT count, double msPerFrame, UINT pairs )
+	{
+		printf( "%-22s %8u %12.3f %10u\n", method, count, msPerFrame, pairs );
+		fflush( stdout );
+
+		char name[64];
+		snprintf( name, sizeof( name ), "%s %u", method, count );
+		BenchRecord( name, msPerFrame, "ms/frame" );
+	}
+
+	void RunBruteForce( UINT count )
+	{
+		Scene scene;
+		BuildScene( scene, count );
+
+		UINT pairs = 0;
+		double total = 0.0;
+		// Only time the last frames, so the pair count is comparable with the
+		// other methods.
+		for( int f = 0; f < kFrames - kBruteForceFrames; ++f )
+			StepScene( scene );
+
+		for( int f = 0; f < kBruteForceFrames; ++f )
+		{
+			StepScene( scene );
+
+			BenchTimer timer;
+			pairs = BruteForcePairs( scene );
+			total += timer.ElapsedMs();
+		}
+
+		PrintRow( "brute force", count, total / kBruteForceFrames, pairs );
+	}
+
+	void RunSweepAndPrune( UINT count, UINT threads, const char* method )
+	{
+		Scene scene;
+		BuildScene( scene, count );
+
+		SweepAndPrune sap( threads );
+		std::vector<ProxyPair> pairs;
+
+		// First call sorts from scratch, keep it out of the average.
+		sap.FindPairs( &scene.boxes[0], count, &pairs );
+
+		double total = 0.0;
+		UINT radixSorts = 0;
+		for( int f = 0; f < kFrames; ++f )
+		{
+			StepScene( scene );
+
+			BenchTimer timer;
+			sap.FindPairs( &scene.boxes[0], count, &pairs );
+			total += timer.ElapsedMs();
+
+			if( sap.WasRadixSorted() )
+				++radixSorts;
+		}
+
+		PrintRow( method, count, total / kFrames, UINT( pairs.size() ) );
+		if( radixSorts )
+			printf( "  (%u of %d frames fell back to the radix sort)\n", radixSorts, kFrames );
+	}
+
+	void RunDynamicTree( UINT count )
+	{
+		Scene scene;
+		BuildScene( scene, count );
+
+		DynamicAabbTree tree;
+		std::vector<UINT> proxies( count );
+		for( UINT i = 0; i < count; ++i )
+			proxies[i] = tree.CreateProxy( &scene.boxes[i], NULL );
+
+		std::vector<ProxyPair> added, removed, contacts;
+		tree.UpdatePairs( &added, &removed );
+
+		double total = 0.0;
+		for( int f = 0; f < kFrames; ++f )
+		{
+			StepScene( scene );
+
+			BenchTimer timer;
+			for( UINT i = 0; i < count; ++i )
+			{
+				const XMFLOAT3& v = scene.velocities[i];
+				tree.MoveProxy( proxies[i], &scene.boxes[i], XMVectorSet( v.x, v.y, v.z, 0.0f ) );
+			}
+			tree.UpdatePairs( &added, &removed );
+
+			// The tree reports fat box pairs, the tight test is part of the cost.
+			std::vector<ProxyPair> fat( tree.GetPairCount() );
+			for( UINT p = 0; p < tree.GetPairCount(); ++p )
+				fat[p] = tree.GetPair( p );
+			contacts.clear();
+			FilterPairsAxisAlignedBox( &tree, fat.empty() ? NULL : &fat[0], UINT( fat.size() ), &contacts );
+			total += timer.ElapsedMs();
+		}
+
+		PrintRow( "dynamic tree", count, total / kFrames, UINT( contacts.size() ) );
+	}
+}
+
+void RunBroadphaseBenchmarks()
+{
+	static const UINT counts[] = { 1000, 5000, 20000, 50000 };
+
+	printf( "%u hardware threads, %d frames per run\n", GetWorkerThreadCount(), kFrames );
+	printf( "%-22s %8s %12s %10s\n", "method", "objects", "ms/frame", "pairs" );
+
+	for( size_t c = 0; c < BenchCountOf( counts ); ++c )
+	{
+		UINT count = counts[c];
+
+		if( count <= kMaxBruteForce )
+			RunBruteForce( count );
+
+		RunSweepAndPrune( count, 1, "sweep and prune (1T)" );
+		RunSweepAndPrune( count, 0, "sweep and prune (MT)" );
+		RunDynamicTree( count );
+	}
+}
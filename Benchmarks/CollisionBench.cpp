@@ -0,0 +1,436 @@
+﻿//***************************************************************************************
+// CollisionBench.cpp
+//
+// Per call cost of every Intersect*, Transform* and Compute* routine of the
+// collision library. Each routine cycles through the same set of random
+// volumes, so the branches see a realistic mix of hits and misses. The timings
+// are recorded for the --json report so regressions show up between builds.
+//***************************************************************************************
+
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const UINT kInputs = 1024;			// Power of two, the index is masked.
+	const UINT kCalls = 1 << 18;
+	const int kRepeats = 5;
+
+	const UINT kPointCount = 4096;		// Points per Compute*FromPoints call.
+	const UINT kPointCalls = 256;
+
+	struct Inputs
+	{
+		std::vector<XMFLOAT3> points;
+		std::vector<XMFLOAT3> directions;
+		std::vector<XMFLOAT3> triangles;	// V0, V1, V2 per triangle.
+		std::vector<XMFLOAT4> rotations;
+		std::vector<XMFLOAT4> planes;
+		std::vector<float> scales;
+		std::vector<Sphere> spheres;
+		std::vector<AxisAlignedBox> boxes;
+		std::vector<OrientedBox> orientedBoxes;
+		std::vector<Frustum> frustums;
+		std::vector<XMFLOAT4> frustumPlanes;	// Six per frustum.
+		std::vector<XMFLOAT4X4> projections;
+
+		std::vector<RayPacket4> rays4;
+		std::vector<RayPacket8> rays8;
+		std::vector<SpherePacket4> spheres4;
+		std::vector<SpherePacket8> spheres8;
+		std::vector<AxisAlignedBoxPacket4> boxes4;
+		std::vector<AxisAlignedBoxPacket8> boxes8;
+		std::vector<TrianglePacket4> triangles4;
+		std::vector<TrianglePacket8> triangles8;
+
+		std::vector<XMFLOAT3> cloud;			// Input of the Compute*FromPoints routines.
+	};
+
+	XMVECTOR RandomUnit( BenchRandom& rng )
+	{
+		return XMVector3Normalize( XMVectorSet( rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ), 0.0f ) );
+	}
+
+	XMVECTOR RandomRotation( BenchRandom& rng )
+	{
+		return XMQuaternionNormalize( XMVectorSet( rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ),
+												   rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ) ) );
+	}
+
+	// Volumes of about unit size within a few units of the origin, and small
+	// frustums looking around from the same region, so that roughly half of the
+	// tests hit.
+	void BuildInputs( Inputs& in )
+	{
+		BenchRandom rng;
+
+		in.points.resize( kInputs );
+		in.directions.resize( kInputs );
+		in.triangles.resize( kInputs * 3 );
+		in.rotations.resize( kInputs );
+		in.planes.resize( kInputs );
+		in.scales.resize( kInputs );
+		in.spheres.resize( kInputs );
+		in.boxes.resize( kInputs );
+		in.orientedBoxes.resize( kInputs );
+		in.frustums.resize( kInputs );
+		in.frustumPlanes.resize( kInputs * 6 );
+		in.projections.resize( kInputs );
+
+		for( UINT i = 0; i < kInputs; ++i )
+		{
+			in.points[i] = XMFLOAT3( rng.Range( -4.0f, 4.0f ), rng.Range( -4.0f, 4.0f ), rng.Range( -4.0f, 4.0f ) );
+			XMStoreFloat3( &in.directions[i], RandomUnit( rng ) );
+			XMStoreFloat4( &in.rotations[i], RandomRotation( rng ) );
+
+			XMFLOAT3 center( rng.Range( -3.0f, 3.0f ), rng.Range( -3.0f, 3.0f ), rng.Range( -3.0f, 3.0f ) );
+			for( int k = 0; k < 3; ++k )
+			{
+				in.triangles[i * 3 + k] = XMFLOAT3( center.x + rng.Range( -1.5f, 1.5f ), center.y + rng.Range( -1.5f, 1.5f ),
+													center.z + rng.Range( -1.5f, 1.5f ) );
+			}
+
+			XMVECTOR normal = RandomUnit( rng );
+			XMStoreFloat4( &in.planes[i], XMVectorSetW( normal, rng.Range( -2.0f, 2.0f ) ) );
+
+			in.scales[i] = rng.Range( 0.5f, 2.0f );
+
+			in.spheres[i].Center = XMFLOAT3( rng.Range( -3.0f, 3.0f ), rng.Range( -3.0f, 3.0f ), rng.Range( -3.0f, 3.0f ) );
+			in.spheres[i].Radius = rng.Range( 0.25f, 1.5f );
+
+			in.boxes[i].Center = XMFLOAT3( rng.Range( -3.0f, 3.0f ), rng.Range( -3.0f, 3.0f ), rng.Range( -3.0f, 3.0f ) );
+			in.boxes[i].Extents = XMFLOAT3( rng.Range( 0.25f, 1.5f ), rng.Range( 0.25f, 1.5f ), rng.Range( 0.25f, 1.5f ) );
+
+			in.orientedBoxes[i].Center = XMFLOAT3( rng.Range( -3.0f, 3.0f ), rng.Range( -3.0f, 3.0f ), rng.Range( -3.0f, 3.0f ) );
+			in.orientedBoxes[i].Extents = XMFLOAT3( rng.Range( 0.25f, 1.5f ), rng.Range( 0.25f, 1.5f ), rng.Range( 0.25f, 1.5f ) );
+			XMStoreFloat4( &in.orientedBoxes[i].Orientation, RandomRotation( rng ) );
+
+			XMMATRIX projection = XMMatrixPerspectiveFovLH( rng.Range( 0.5f, 1.5f ), rng.Range( 1.0f, 2.0f ), 0.1f, rng.Range( 2.0f, 8.0f ) );
+			XMStoreFloat4x4( &in.projections[i], projection );
+
+			Frustum local;
+			ComputeFrustumFromProjection( &local, &projection );
+			XMVECTOR origin = XMVectorSet( rng.Range( -4.0f, 4.0f ), rng.Range( -4.0f, 4.0f ), rng.Range( -4.0f, 4.0f ), 0.0f );
+			TransformFrustum( &in.frustums[i], &local, 1.0f, RandomRotation( rng ), origin );
+
+			XMVECTOR p[6];
+			ComputePlanesFromFrustum( &in.frustums[i], &p[0], &p[1], &p[2], &p[3], &p[4], &p[5] );
+			for( int k = 0; k < 6; ++k )
+				XMStoreFloat4( &in.frustumPlanes[i * 6 + k], p[k] );
+		}
+
+		// Packets are built from consecutive inputs, wrapping around at the end.
+		UINT packetCount = kInputs / 8;
+		in.rays4.resize( packetCount );
+		in.rays8.resize( packetCount );
+		in.spheres4.resize( packetCount );
+		in.spheres8.resize( packetCount );
+		in.boxes4.resize( packetCount );
+		in.boxes8.resize( packetCount );
+		in.triangles4.resize( packetCount );
+		in.triangles8.resize( packetCount );
+
+		for( UINT i = 0; i < packetCount; ++i )
+		{
+			UINT first = i * 8;
+			LoadRayPacket( &in.rays4[i], 4, &in.points[first], &in.directions[first] );
+			LoadRayPacket( &in.rays8[i], 8, &in.points[first], &in.directions[first] );
+			LoadSpherePacket( &in.spheres4[i], 4, &in.spheres[first] );
+			LoadSpherePacket( &in.spheres8[i], 8, &in.spheres[first] );
+			LoadAxisAlignedBoxPacket( &in.boxes4[i], 4, &in.boxes[first] );
+			LoadAxisAlignedBoxPacket( &in.boxes8[i], 8, &in.boxes[first] );
+			LoadTrianglePacket( &in.triangles4[i], 4, &in.triangles[first * 3] );
+			LoadTrianglePacket( &in.triangles8[i], 8, &in.triangles[first * 3] );
+		}
+
+		in.cloud.resize( kPointCount );
+		XMMATRIX stretch = XMMatrixScaling( 6.0f, 2.0f, 1.0f ) * XMMatrixRotationRollPitchYaw( 0.4f, 0.2f, 0.9f );
+		for( UINT i = 0; i < kPointCount; ++i )
+		{
+			XMVECTOR p = XMVectorSet( rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ), 0.0f );
+			XMStoreFloat3( &in.cloud[i], XMVector3TransformCoord( p, stretch ) );
+		}
+	}
+
+	// Summed results of every call, printed at the end so the compiler has to
+	// keep the calls.
+	UINT gSink = 0;
+
+	// Best of kRepeats runs of calls calls of test( i ), in ns per call.
+	template<typename Test>
+	void Measure( const char* name, UINT calls, Test test )
+	{
+		double best = 0.0;
+		UINT sink = 0;
+
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			BenchTimer timer;
+			for( UINT i = 0; i < calls; ++i )
+				sink += UINT( test( i & ( kInputs - 1 ) ) );
+
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+
+		double ns = best * 1.0e6 / calls;
+		printf( "%-52s %10.2f\n", name, ns );
+		BenchRecord( name, ns, "ns/call" );
+
+		gSink += sink;
+	}
+
+	template<typename Test>
+	void Measure( const char* name, Test test )
+	{
+		Measure( name, kCalls, test );
+	}
+
+	XMVECTOR Load( const XMFLOAT3& v ) { return XMLoadFloat3( &v ); }
+	XMVECTOR Load( const XMFLOAT4& v ) { return XMLoadFloat4( &v ); }
+}
+
+void RunCollisionBenchmarks()
+{
+	Inputs in;
+	BuildInputs( in );
+
+	const XMFLOAT3* pt = &in.points[0];
+	const XMFLOAT3* dir = &in.directions[0];
+	const XMFLOAT3* tri = &in.triangles[0];
+	const XMFLOAT4* rot = &in.rotations[0];
+	const XMFLOAT4* pl = &in.planes[0];
+	const XMFLOAT4* fp = &in.frustumPlanes[0];
+	const float* scale = &in.scales[0];
+	const Sphere* sp = &in.spheres[0];
+	const AxisAlignedBox* box = &in.boxes[0];
+	const OrientedBox* obb = &in.orientedBoxes[0];
+	const Frustum* fr = &in.frustums[0];
+	const UINT packetMask = kInputs / 8 - 1;
+
+	// The second volume of a pair test is taken this far ahead of the first.
+	const UINT kOther = 37;
+	#define NEXT( i ) ( ( ( i ) + kOther ) & ( kInputs - 1 ) )
+	#define TRI( i ) Load( tri[( i ) * 3] ), Load( tri[( i ) * 3 + 1] ), Load( tri[( i ) * 3 + 2] )
+	#define PLANES( i ) Load( fp[( i ) * 6] ), Load( fp[( i ) * 6 + 1] ), Load( fp[( i ) * 6 + 2] ), \
+						Load( fp[( i ) * 6 + 3] ), Load( fp[( i ) * 6 + 4] ), Load( fp[( i ) * 6 + 5] )
+
+	printf( "%u inputs, best of %d runs\n", kInputs, kRepeats );
+	printf( "%-52s %10s\n", "routine", "ns/call" );
+
+	// Construction.
+	Measure( "ComputeBoundingSphereFromPoints/4096", kPointCalls, [&]( UINT )
+	{
+		Sphere out;
+		ComputeBoundingSphereFromPoints( &out, kPointCount, &in.cloud[0], sizeof( XMFLOAT3 ) );
+		return out.Radius > 0.0f;
+	} );
+	Measure( "ComputeBoundingAxisAlignedBoxFromPoints/4096", kPointCalls, [&]( UINT )
+	{
+		AxisAlignedBox out;
+		ComputeBoundingAxisAlignedBoxFromPoints( &out, kPointCount, &in.cloud[0], sizeof( XMFLOAT3 ) );
+		return out.Extents.x > 0.0f;
+	} );
+	Measure( "ComputeBoundingOrientedBoxFromPoints/4096", kPointCalls, [&]( UINT )
+	{
+		OrientedBox out;
+		ComputeBoundingOrientedBoxFromPoints( &out, kPointCount, &in.cloud[0], sizeof( XMFLOAT3 ) );
+		return out.Extents.x > 0.0f;
+	} );
+	Measure( "ComputeMinimumBoundingSphereFromPoints/4096", kPointCalls, [&]( UINT )
+	{
+		Sphere out;
+		ComputeMinimumBoundingSphereFromPoints( &out, kPointCount, &in.cloud[0], sizeof( XMFLOAT3 ) );
+		return out.Radius > 0.0f;
+	} );
+	Measure( "ComputeBoundingSphereFromPointsParallel/4096", kPointCalls, [&]( UINT )
+	{
+		Sphere out;
+		ComputeBoundingSphereFromPointsParallel( &out, kPointCount, &in.cloud[0], sizeof( XMFLOAT3 ), 0 );
+		return out.Radius > 0.0f;
+	} );
+	Measure( "ComputeBoundingAxisAlignedBoxFromPointsParallel/4096", kPointCalls, [&]( UINT )
+	{
+		AxisAlignedBox out;
+		ComputeBoundingAxisAlignedBoxFromPointsParallel( &out, kPointCount, &in.cloud[0], sizeof( XMFLOAT3 ), 0 );
+		return out.Extents.x > 0.0f;
+	} );
+	Measure( "ComputeBoundingOrientedBoxFromPointsParallel/4096", kPointCalls, [&]( UINT )
+	{
+		OrientedBox out;
+		ComputeBoundingOrientedBoxFromPointsParallel( &out, kPointCount, &in.cloud[0], sizeof( XMFLOAT3 ), 0 );
+		return out.Extents.x > 0.0f;
+	} );
+	Measure( "ComputeFrustumFromProjection", [&]( UINT i )
+	{
+		XMMATRIX projection = XMLoadFloat4x4( &in.projections[i] );
+		Frustum out;
+		ComputeFrustumFromProjection( &out, &projection );
+		return out.Far > 0.0f;
+	} );
+	Measure( "ComputePlanesFromFrustum", [&]( UINT i )
+	{
+		XMVECTOR p0, p1, p2, p3, p4, p5;
+		ComputePlanesFromFrustum( &fr[i], &p0, &p1, &p2, &p3, &p4, &p5 );
+		return XMVectorGetW( p0 ) + XMVectorGetW( p5 ) > 0.0f;
+	} );
+
+	// Transforms.
+	Measure( "TransformSphere", [&]( UINT i )
+	{
+		Sphere out;
+		TransformSphere( &out, &sp[i], scale[i], Load( rot[i] ), Load( pt[i] ) );
+		return out.Center.x > 0.0f;
+	} );
+	Measure( "TransformAxisAlignedBox", [&]( UINT i )
+	{
+		AxisAlignedBox out;
+		TransformAxisAlignedBox( &out, &box[i], scale[i], Load( rot[i] ), Load( pt[i] ) );
+		return out.Center.x > 0.0f;
+	} );
+	Measure( "TransformOrientedBox", [&]( UINT i )
+	{
+		OrientedBox out;
+		TransformOrientedBox( &out, &obb[i], scale[i], Load( rot[i] ), Load( pt[i] ) );
+		return out.Center.x > 0.0f;
+	} );
+	Measure( "TransformFrustum", [&]( UINT i )
+	{
+		Frustum out;
+		TransformFrustum( &out, &fr[i], scale[i], Load( rot[i] ), Load( pt[i] ) );
+		return out.Origin.x > 0.0f;
+	} );
+
+	// Point and ray tests.
+	Measure( "IntersectPointSphere", [&]( UINT i ) { return IntersectPointSphere( Load( pt[i] ), &sp[NEXT( i )] ); } );
+	Measure( "IntersectPointAxisAlignedBox", [&]( UINT i ) { return IntersectPointAxisAlignedBox( Load( pt[i] ), &box[NEXT( i )] ); } );
+	Measure( "IntersectPointOrientedBox", [&]( UINT i ) { return IntersectPointOrientedBox( Load( pt[i] ), &obb[NEXT( i )] ); } );
+	Measure( "IntersectPointFrustum", [&]( UINT i ) { return IntersectPointFrustum( Load( pt[i] ), &fr[NEXT( i )] ); } );
+	Measure( "IntersectRayTriangle", [&]( UINT i )
+	{
+		FLOAT dist;
+		return IntersectRayTriangle( Load( pt[i] ), Load( dir[i] ), TRI( NEXT( i ) ), &dist );
+	} );
+	Measure( "IntersectRaySphere", [&]( UINT i )
+	{
+		FLOAT dist;
+		return IntersectRaySphere( Load( pt[i] ), Load( dir[i] ), &sp[NEXT( i )], &dist );
+	} );
+	Measure( "IntersectRayAxisAlignedBox", [&]( UINT i )
+	{
+		FLOAT dist;
+		return IntersectRayAxisAlignedBox( Load( pt[i] ), Load( dir[i] ), &box[NEXT( i )], &dist );
+	} );
+	Measure( "IntersectRayOrientedBox", [&]( UINT i )
+	{
+		FLOAT dist;
+		return IntersectRayOrientedBox( Load( pt[i] ), Load( dir[i] ), &obb[NEXT( i )], &dist );
+	} );
+
+	// Ray packets, one packet call per measured call.
+	Measure( "IntersectRayPacketTriangle/4", [&]( UINT i )
+	{
+		XMVECTOR dist[1];
+		return IntersectRayPacketTriangle( &in.rays4[i & packetMask], 0xf, TRI( NEXT( i ) ), dist );
+	} );
+	Measure( "IntersectRayPacketTriangle/8", [&]( UINT i )
+	{
+		XMVECTOR dist[2];
+		return IntersectRayPacketTriangle( &in.rays8[i & packetMask], 0xff, TRI( NEXT( i ) ), dist );
+	} );
+	Measure( "IntersectRayPacketSphere/4", [&]( UINT i )
+	{
+		XMVECTOR dist[1];
+		return IntersectRayPacketSphere( &in.rays4[i & packetMask], 0xf, &sp[NEXT( i )], dist );
+	} );
+	Measure( "IntersectRayPacketSphere/8", [&]( UINT i )
+	{
+		XMVECTOR dist[2];
+		return IntersectRayPacketSphere( &in.rays8[i & packetMask], 0xff, &sp[NEXT( i )], dist );
+	} );
+	Measure( "IntersectRayPacketAxisAlignedBox/4", [&]( UINT i )
+	{
+		XMVECTOR dist[1];
+		return IntersectRayPacketAxisAlignedBox( &in.rays4[i & packetMask], 0xf, &box[NEXT( i )], dist );
+	} );
+	Measure( "IntersectRayPacketAxisAlignedBox/8", [&]( UINT i )
+	{
+		XMVECTOR dist[2];
+		return IntersectRayPacketAxisAlignedBox( &in.rays8[i & packetMask], 0xff, &box[NEXT( i )], dist );
+	} );
+	Measure( "IntersectRayTrianglePacket/4", [&]( UINT i )
+	{
+		XMVECTOR dist[1];
+		return IntersectRayTrianglePacket( Load( pt[i] ), Load( dir[i] ), &in.triangles4[i & packetMask], 0xf, dist );
+	} );
+	Measure( "IntersectRayTrianglePacket/8", [&]( UINT i )
+	{
+		XMVECTOR dist[2];
+		return IntersectRayTrianglePacket( Load( pt[i] ), Load( dir[i] ), &in.triangles8[i & packetMask], 0xff, dist );
+	} );
+	Measure( "IntersectRaySpherePacket/4", [&]( UINT i )
+	{
+		XMVECTOR dist[1];
+		return IntersectRaySpherePacket( Load( pt[i] ), Load( dir[i] ), &in.spheres4[i & packetMask], 0xf, dist );
+	} );
+	Measure( "IntersectRaySpherePacket/8", [&]( UINT i )
+	{
+		XMVECTOR dist[2];
+		return IntersectRaySpherePacket( Load( pt[i] ), Load( dir[i] ), &in.spheres8[i & packetMask], 0xff, dist );
+	} );
+	Measure( "IntersectRayAxisAlignedBoxPacket/4", [&]( UINT i )
+	{
+		XMVECTOR dist[1];
+		return IntersectRayAxisAlignedBoxPacket( Load( pt[i] ), Load( dir[i] ), &in.boxes4[i & packetMask], 0xf, dist );
+	} );
+	Measure( "IntersectRayAxisAlignedBoxPacket/8", [&]( UINT i )
+	{
+		XMVECTOR dist[2];
+		return IntersectRayAxisAlignedBoxPacket( Load( pt[i] ), Load( dir[i] ), &in.boxes8[i & packetMask], 0xff, dist );
+	} );
+
+	// Volume pairs.
+	Measure( "IntersectTriangleTriangle", [&]( UINT i ) { return IntersectTriangleTriangle( TRI( i ), TRI( NEXT( i ) ) ); } );
+	Measure( "IntersectTriangleSphere", [&]( UINT i ) { return IntersectTriangleSphere( TRI( i ), &sp[NEXT( i )] ); } );
+	Measure( "IntersectTriangleAxisAlignedBox", [&]( UINT i ) { return IntersectTriangleAxisAlignedBox( TRI( i ), &box[NEXT( i )] ); } );
+	Measure( "IntersectTriangleOrientedBox", [&]( UINT i ) { return IntersectTriangleOrientedBox( TRI( i ), &obb[NEXT( i )] ); } );
+	Measure( "IntersectSphereSphere", [&]( UINT i ) { return IntersectSphereSphere( &sp[i], &sp[NEXT( i )] ); } );
+	Measure( "IntersectSphereAxisAlignedBox", [&]( UINT i ) { return IntersectSphereAxisAlignedBox( &sp[i], &box[NEXT( i )] ); } );
+	Measure( "IntersectSphereOrientedBox", [&]( UINT i ) { return IntersectSphereOrientedBox( &sp[i], &obb[NEXT( i )] ); } );
+	Measure( "IntersectAxisAlignedBoxAxisAlignedBox", [&]( UINT i ) { return IntersectAxisAlignedBoxAxisAlignedBox( &box[i], &box[NEXT( i )] ); } );
+	Measure( "IntersectAxisAlignedBoxOrientedBox", [&]( UINT i ) { return IntersectAxisAlignedBoxOrientedBox( &box[i], &obb[NEXT( i )] ); } );
+	Measure( "IntersectOrientedBoxOrientedBox", [&]( UINT i ) { return IntersectOrientedBoxOrientedBox( &obb[i], &obb[NEXT( i )] ); } );
+
+	// Frustums.
+	Measure( "IntersectTriangleFrustum", [&]( UINT i ) { return IntersectTriangleFrustum( TRI( i ), &fr[NEXT( i )] ); } );
+	Measure( "IntersectSphereFrustum", [&]( UINT i ) { return IntersectSphereFrustum( &sp[i], &fr[NEXT( i )] ); } );
+	Measure( "IntersectAxisAlignedBoxFrustum", [&]( UINT i ) { return IntersectAxisAlignedBoxFrustum( &box[i], &fr[NEXT( i )] ); } );
+	Measure( "IntersectOrientedBoxFrustum", [&]( UINT i ) { return IntersectOrientedBoxFrustum( &obb[i], &fr[NEXT( i )] ); } );
+	Measure( "IntersectFrustumFrustum", [&]( UINT i ) { return IntersectFrustumFrustum( &fr[i], &fr[NEXT( i )] ); } );
+
+	// Six planes.
+	Measure( "IntersectTriangle6Planes", [&]( UINT i ) { return IntersectTriangle6Planes( TRI( i ), PLANES( NEXT( i ) ) ); } );
+	Measure( "IntersectSphere6Planes", [&]( UINT i ) { return IntersectSphere6Planes( &sp[i], PLANES( NEXT( i ) ) ); } );
+	Measure( "IntersectAxisAlignedBox6Planes", [&]( UINT i ) { return IntersectAxisAlignedBox6Planes( &box[i], PLANES( NEXT( i ) ) ); } );
+	Measure( "IntersectOrientedBox6Planes", [&]( UINT i ) { return IntersectOrientedBox6Planes( &obb[i], PLANES( NEXT( i ) ) ); } );
+	Measure( "IntersectFrustum6Planes", [&]( UINT i ) { return IntersectFrustum6Planes( &fr[i], PLANES( NEXT( i ) ) ); } );
+
+	// One plane.
+	Measure( "IntersectTrianglePlane", [&]( UINT i ) { return IntersectTrianglePlane( TRI( i ), Load( pl[NEXT( i )] ) ); } );
+	Measure( "IntersectSpherePlane", [&]( UINT i ) { return IntersectSpherePlane( &sp[i], Load( pl[NEXT( i )] ) ); } );
+	Measure( "IntersectAxisAlignedBoxPlane", [&]( UINT i ) { return IntersectAxisAlignedBoxPlane( &box[i], Load( pl[NEXT( i )] ) ); } );
+	Measure( "IntersectOrientedBoxPlane", [&]( UINT i ) { return IntersectOrientedBoxPlane( &obb[i], Load( pl[NEXT( i )] ) ); } );
+	Measure( "IntersectFrustumPlane", [&]( UINT i ) { return IntersectFrustumPlane( &fr[i], Load( pl[NEXT( i )] ) ); } );
+
+	#undef NEXT
+	#undef TRI
+	#undef PLANES
+
+	printf( "(checksum %u)\n", gSink );
+}
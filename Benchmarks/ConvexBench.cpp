@@ -0,0 +1,417 @@
+﻿//***************************************************************************************
+// ConvexBench.cpp
+//
+// Convex hull pairs: GJK overlap and distance, cold and warm started from the
+// simplex of the previous frame, and EPA penetration depth, against a brute
+// force separating axis test over the face normals of both hulls and the cross
+// products of all their edge directions. The hulls are lat-long ellipsoids, so
+// their faces and edges are known without building the hull; the pairs turn
+// and drift a little every frame. SAT also gives the exact penetration depth
+// to check EPA against.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "ConvexCollision.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const int kFrames = 20;
+	const UINT kPairCount = 128;
+
+	// Projections SAT may spend per frame; the larger hulls only test a few pairs.
+	const double kSatBudget = 2e7;
+
+	struct Hull
+	{
+		std::vector<XMFLOAT3> points;
+		std::vector<XMFLOAT3> normals;			// Outward face normals.
+		std::vector<XMFLOAT3> edges;			// Edge directions, parallel ones once.
+	};
+
+	void AddEdge( Hull& hull, FXMVECTOR a, FXMVECTOR b )
+	{
+		XMVECTOR direction = XMVector3Normalize( b - a );
+		for( size_t i = 0; i < hull.edges.size(); ++i )
+		{
+			if( XMVectorGetX( XMVector3LengthSq( XMVector3Cross( direction, XMLoadFloat3( &hull.edges[i] ) ) ) ) < 1e-10f )
+				return;
+		}
+
+		XMFLOAT3 e;
+		XMStoreFloat3( &e, direction );
+		hull.edges.push_back( e );
+	}
+
+	// Normal of the face through a, b, c, turned away from the hull center.
+	void AddFace( Hull& hull, FXMVECTOR a, FXMVECTOR b, FXMVECTOR c )
+	{
+		XMVECTOR normal = XMVector3Normalize( XMVector3Cross( b - a, c - a ) );
+		if( XMVectorGetX( XMVector3Dot( normal, a ) ) < 0.0f )
+			normal = -normal;
+
+		XMFLOAT3 n;
+		XMStoreFloat3( &n, normal );
+		hull.normals.push_back( n );
+	}
+
+	// Poles and rings x segments vertices on an ellipsoid. The quads between the
+	// rings are planar, so the faces are those of the convex hull.
+	void BuildHull( Hull& hull, UINT rings, UINT segments, const XMFLOAT3& radii )
+	{
+		XMVECTOR scale = XMLoadFloat3( &radii );
+
+		hull.points.clear();
+		hull.normals.clear();
+		hull.edges.clear();
+
+		hull.points.push_back( XMFLOAT3( 0.0f, radii.y, 0.0f ) );
+		for( UINT r = 1; r <= rings; ++r )
+		{
+			float phi = XM_PI * r / ( rings + 1 );
+			for( UINT s = 0; s < segments; ++s )
+			{
+				float theta = XM_2PI * s / segments;
+				XMFLOAT3 p;
+				XMStoreFloat3( &p, XMVectorSet( sinf( phi ) * cosf( theta ), cosf( phi ), sinf( phi ) * sinf( theta ), 0.0f ) * scale );
+				hull.points.push_back( p );
+			}
+		}
+		hull.points.push_back( XMFLOAT3( 0.0f, -radii.y, 0.0f ) );
+
+		UINT bottom = UINT( hull.points.size() - 1 );
+		#define P( i ) XMLoadFloat3( &hull.points[i] )
+
+		for( UINT s = 0; s < segments; ++s )
+		{
+			UINT next = ( s + 1 ) % segments;
+
+			// Fans around the poles.
+			AddFace( hull, P( 0 ), P( 1 + s ), P( 1 + next ) );
+			AddFace( hull, P( bottom ), P( 1 + ( rings - 1 ) * segments + s ), P( 1 + ( rings - 1 ) * segments + next ) );
+			AddEdge( hull, P( 0 ), P( 1 + s ) );
+			AddEdge( hull, P( bottom ), P( 1 + ( rings - 1 ) * segments + s ) );
+
+			for( UINT r = 0; r < rings; ++r )
+			{
+				UINT a = 1 + r * segments + s;
+				UINT b = 1 + r * segments + next;
+				AddEdge( hull, P( a ), P( b ) );
+
+				if( r + 1 < rings )
+				{
+					AddFace( hull, P( a ), P( b ), P( b + segments ) );
+					AddEdge( hull, P( a ), P( a + segments ) );
+				}
+			}
+		}
+
+		#undef P
+	}
+
+	struct Body
+	{
+		ConvexObject object;
+		XMFLOAT3 spin;							// Roll, pitch and yaw per frame.
+		XMFLOAT3 drift;
+	};
+
+	// The hull data of a body in world space, for SAT.
+	struct WorldHull
+	{
+		std::vector<XMFLOAT3> points;
+		std::vector<XMFLOAT3> normals;
+		std::vector<XMFLOAT3> edges;
+	};
+
+	void ToWorld( const Hull& hull, const ConvexObject& object, WorldHull& out )
+	{
+		XMMATRIX rotation = XMMatrixRotationQuaternion( XMLoadFloat4( &object.Orientation ) );
+		XMVECTOR position = XMLoadFloat3( &object.Position );
+
+		out.points.resize( hull.points.size() );
+		for( size_t i = 0; i < hull.points.size(); ++i )
+			XMStoreFloat3( &out.points[i], XMVector3TransformNormal( XMLoadFloat3( &hull.points[i] ), rotation ) + position );
+
+		out.normals.resize( hull.normals.size() );
+		for( size_t i = 0; i < hull.normals.size(); ++i )
+			XMStoreFloat3( &out.normals[i], XMVector3TransformNormal( XMLoadFloat3( &hull.normals[i] ), rotation ) );
+
+		out.edges.resize( hull.edges.size() );
+		for( size_t i = 0; i < hull.edges.size(); ++i )
+			XMStoreFloat3( &out.edges[i], XMVector3TransformNormal( XMLoadFloat3( &hull.edges[i] ), rotation ) );
+	}
+
+	void Project( const std::vector<XMFLOAT3>& points, const XMFLOAT3& axis, float* pMin, float* pMax )
+	{
+		float lo = FLT_MAX, hi = -FLT_MAX;
+		for( size_t i = 0; i < points.size(); ++i )
+		{
+			float d = points[i].x * axis.x + points[i].y * axis.y + points[i].z * axis.z;
+			lo = ( std::min )( lo, d );
+			hi = ( std::max )( hi, d );
+		}
+		*pMin = lo;
+		*pMax = hi;
+	}
+
+	// Overlap of the hulls along a unit axis, negative if it separates them.
+	float AxisOverlap( const WorldHull& a, const WorldHull& b, const XMFLOAT3& axis )
+	{
+		float minA, maxA, minB, maxB;
+		Project( a.points, axis, &minA, &maxA );
+		Project( b.points, axis, &minB, &maxB );
+		return ( std::min )( maxA - minB, maxB - minA );
+	}
+
+	// Brute force SAT. Returns true if the hulls intersect, with *pDepth the
+	// smallest overlap over all axes, which is the penetration depth.
+	bool SatIntersect( const WorldHull& a, const WorldHull& b, float* pDepth )
+	{
+		float depth = FLT_MAX;
+
+		for( int h = 0; h < 2; ++h )
+		{
+			const std::vector<XMFLOAT3>& normals = h ? b.normals : a.normals;
+			for( size_t i = 0; i < normals.size(); ++i )
+			{
+				float overlap = AxisOverlap( a, b, normals[i] );
+				if( overlap < 0.0f )
+					return false;
+				depth = ( std::min )( depth, overlap );
+			}
+		}
+
+		for( size_t i = 0; i < a.edges.size(); ++i )
+		{
+			for( size_t j = 0; j < b.edges.size(); ++j )
+			{
+				XMVECTOR cross = XMVector3Cross( XMLoadFloat3( &a.edges[i] ), XMLoadFloat3( &b.edges[j] ) );
+				float lengthSq = XMVectorGetX( XMVector3LengthSq( cross ) );
+				if( lengthSq < 1e-8f )
+					continue;
+
+				XMFLOAT3 axis;
+				XMStoreFloat3( &axis, cross * ( 1.0f / sqrtf( lengthSq ) ) );
+
+				float overlap = AxisOverlap( a, b, axis );
+				if( overlap < 0.0f )
+					return false;
+				depth = ( std::min )( depth, overlap );
+			}
+		}
+
+		*pDepth = depth;
+		return true;
+	}
+
+	XMFLOAT4 RandomOrientation( BenchRandom& rng )
+	{
+		XMFLOAT4 q;
+		XMStoreFloat4( &q, XMQuaternionRotationRollPitchYaw( rng.Range( -XM_PI, XM_PI ), rng.Range( -XM_PI, XM_PI ),
+															 rng.Range( -XM_PI, XM_PI ) ) );
+		return q;
+	}
+
+	void Step( Body& body )
+	{
+		XMVECTOR spin = XMQuaternionRotationRollPitchYaw( body.spin.x, body.spin.y, body.spin.z );
+		XMStoreFloat4( &body.object.Orientation,
+					   XMQuaternionNormalize( XMQuaternionMultiply( XMLoadFloat4( &body.object.Orientation ), spin ) ) );
+		XMStoreFloat3( &body.object.Position, XMLoadFloat3( &body.object.Position ) + XMLoadFloat3( &body.drift ) );
+	}
+
+	void RunHulls( UINT rings, UINT segments )
+	{
+		BenchRandom rng( rings * 100 + segments );
+
+		// Two hull shapes, different ellipsoids.
+		Hull hulls[2];
+		ConvexHullShape shapes[2];
+		for( int h = 0; h < 2; ++h )
+		{
+			XMFLOAT3 radii( rng.Range( 0.6f, 1.4f ), rng.Range( 0.6f, 1.4f ), rng.Range( 0.6f, 1.4f ) );
+			BuildHull( hulls[h], rings, segments, radii );
+			shapes[h].SetPoints( &hulls[h].points[0], UINT( hulls[h].points.size() ) );
+		}
+
+		std::vector<Body> bodies( 2 * kPairCount );
+		for( UINT p = 0; p < kPairCount; ++p )
+		{
+			for( int h = 0; h < 2; ++h )
+			{
+				Body& body = bodies[2 * p + h];
+				body.object.pShape = &shapes[h];
+				body.object.Orientation = RandomOrientation( rng );
+				body.spin = XMFLOAT3( rng.Range( -0.02f, 0.02f ), rng.Range( -0.02f, 0.02f ), rng.Range( -0.02f, 0.02f ) );
+				body.drift = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+			}
+
+			// B around A at about the distance where they start to touch.
+			XMVECTOR direction = XMVector3Normalize( XMVectorSet( rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ),
+																  rng.Range( -1.0f, 1.0f ), 0.0f ) );
+			float distance = rng.Range( 1.0f, 2.4f );
+			bodies[2 * p].object.Position = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+			XMStoreFloat3( &bodies[2 * p + 1].object.Position, direction * distance );
+			XMStoreFloat3( &bodies[2 * p + 1].drift, direction * rng.Range( -0.005f, 0.005f ) );
+		}
+
+		size_t axes = hulls[0].normals.size() + hulls[1].normals.size() + hulls[0].edges.size() * hulls[1].edges.size();
+		UINT satPairs = UINT( kSatBudget / ( double( axes ) * ( hulls[0].points.size() + hulls[1].points.size() ) ) );
+		satPairs = ( std::max )( 4u, ( std::min )( kPairCount, satPairs ) );
+
+		std::vector<GjkCache> boolCaches( kPairCount ), distanceCaches( kPairCount ), epaCaches( kPairCount );
+		for( UINT p = 0; p < kPairCount; ++p )
+			boolCaches[p].Count = distanceCaches[p].Count = epaCaches[p].Count = 0;
+
+		std::vector<BYTE> overlaps( kPairCount );
+		WorldHull worldA, worldB;
+
+		double satMs = 0.0, coldMs = 0.0, warmMs = 0.0, distColdMs = 0.0, distWarmMs = 0.0, epaMs = 0.0;
+		double coldIterations = 0.0, warmIterations = 0.0;
+		size_t intersecting = 0, satTests = 0, disagree = 0;
+		float maxDepthError = 0.0f;
+
+		for( int frame = 0; frame <= kFrames; ++frame )
+		{
+			for( size_t b = 0; b < bodies.size(); ++b )
+				Step( bodies[b] );
+
+			BenchTimer timer;
+			for( UINT p = 0; p < kPairCount; ++p )
+			{
+				GjkCache cold;
+				cold.Count = 0;
+				overlaps[p] = IntersectConvexConvex( &bodies[2 * p].object, &bodies[2 * p + 1].object, &cold ) ? 1 : 0;
+			}
+			double ms = timer.ElapsedMs();
+
+			// The first frame only fills the caches.
+			if( frame > 0 )
+				coldMs += ms;
+
+			timer.Reset();
+			UINT warmOverlaps = 0;
+			for( UINT p = 0; p < kPairCount; ++p )
+				warmOverlaps += IntersectConvexConvex( &bodies[2 * p].object, &bodies[2 * p + 1].object, &boolCaches[p] ) ? 1 : 0;
+			ms = timer.ElapsedMs();
+			if( frame > 0 )
+				warmMs += ms;
+
+			UINT iterations = 0;
+			timer.Reset();
+			for( UINT p = 0; p < kPairCount; ++p )
+			{
+				GjkCache cold;
+				cold.Count = 0;
+				ConvexDistance result;
+				ComputeConvexDistance( &bodies[2 * p].object, &bodies[2 * p + 1].object, &cold, &result );
+				iterations += result.Iterations;
+			}
+			ms = timer.ElapsedMs();
+			if( frame > 0 )
+			{
+				distColdMs += ms;
+				coldIterations += iterations;
+			}
+
+			iterations = 0;
+			timer.Reset();
+			for( UINT p = 0; p < kPairCount; ++p )
+			{
+				ConvexDistance result;
+				ComputeConvexDistance( &bodies[2 * p].object, &bodies[2 * p + 1].object, &distanceCaches[p], &result );
+				iterations += result.Iterations;
+			}
+			ms = timer.ElapsedMs();
+			if( frame > 0 )
+			{
+				distWarmMs += ms;
+				warmIterations += iterations;
+			}
+
+			std::vector<ConvexPenetration> penetrations( kPairCount );
+			timer.Reset();
+			for( UINT p = 0; p < kPairCount; ++p )
+				ComputeConvexPenetration( &bodies[2 * p].object, &bodies[2 * p + 1].object, &epaCaches[p], &penetrations[p] );
+			ms = timer.ElapsedMs();
+			if( frame == 0 )
+				continue;
+
+			epaMs += ms;
+
+			UINT frameIntersecting = 0;
+			for( UINT p = 0; p < kPairCount; ++p )
+				frameIntersecting += overlaps[p];
+			intersecting += frameIntersecting;
+			if( warmOverlaps != frameIntersecting )
+				disagree++;
+
+			// SAT on the first pairs, also checking GJK and EPA.
+			for( UINT p = 0; p < satPairs; ++p )
+			{
+				ToWorld( hulls[0], bodies[2 * p].object, worldA );
+				ToWorld( hulls[1], bodies[2 * p + 1].object, worldB );
+
+				timer.Reset();
+				float depth = 0.0f;
+				bool sat = SatIntersect( worldA, worldB, &depth );
+				satMs += timer.ElapsedMs();
+				satTests++;
+
+				// Pairs that barely touch may go either way.
+				if( sat != ( overlaps[p] != 0 ) && !( sat && depth < 1e-4f ) )
+					disagree++;
+
+				if( sat && overlaps[p] )
+					maxDepthError = ( std::max )( maxDepthError, fabsf( penetrations[p].Depth - depth ) );
+			}
+		}
+
+		double tests = double( kFrames ) * kPairCount;
+		double us = 1000.0 / tests;
+
+		printf( "%u vertices (%u rings x %u), %u pairs, %.1f%% intersecting, SAT over %u axes on %u pairs\n",
+				UINT( hulls[0].points.size() ), rings, segments, kPairCount, 100.0 * intersecting / tests, UINT( axes ),
+				satPairs );
+		printf( "  SAT brute force      %9.3f us/pair\n", 1000.0 * satMs / satTests );
+		printf( "  GJK overlap, cold    %9.3f us/pair\n", coldMs * us );
+		printf( "  GJK overlap, warm    %9.3f us/pair\n", warmMs * us );
+		printf( "  GJK distance, cold   %9.3f us/pair, %.2f iterations\n", distColdMs * us, coldIterations / tests );
+		printf( "  GJK distance, warm   %9.3f us/pair, %.2f iterations\n", distWarmMs * us, warmIterations / tests );
+		printf( "  GJK + EPA, warm      %9.3f us/pair, depth within %.2g of SAT\n", epaMs * us, maxDepthError );
+		printf( "  %u disagreements with SAT or between cold and warm GJK\n\n", UINT( disagree ) );
+
+		char name[64];
+		UINT count = UINT( hulls[0].points.size() );
+		snprintf( name, sizeof( name ), "SAT %u", count );
+		BenchRecord( name, 1000.0 * satMs / satTests, "us" );
+		snprintf( name, sizeof( name ), "GJK cold %u", count );
+		BenchRecord( name, coldMs * us, "us" );
+		snprintf( name, sizeof( name ), "GJK warm %u", count );
+		BenchRecord( name, warmMs * us, "us" );
+		snprintf( name, sizeof( name ), "GJK distance cold %u", count );
+		BenchRecord( name, distColdMs * us, "us" );
+		snprintf( name, sizeof( name ), "GJK distance warm %u", count );
+		BenchRecord( name, distWarmMs * us, "us" );
+		snprintf( name, sizeof( name ), "EPA warm %u", count );
+		BenchRecord( name, epaMs * us, "us" );
+	}
+}
+
+void RunConvexBenchmarks()
+{
+	printf( "%d frames, %u hull pairs turning and drifting a little every frame\n\n", kFrames, kPairCount );
+
+	RunHulls( 2, 7 );
+	RunHulls( 6, 10 );
+	RunHulls( 14, 18 );
+}
@@ -0,0 +1,348 @@
+﻿//***************************************************************************************
+// CullBench.cpp
+//
+// Camera fly-through over a field of object clusters: frustum culling with
+// IntersectAxisAlignedBox6Planes / IntersectOrientedBox6Planes against
+// FrustumCuller without and with plane coherency, and with the clusters
+// culled first so their objects only test the planes the cluster straddles.
+// Reports the time per frame and the average number of planes tested per
+// object. Then the same against CullingHierarchy, up to a million objects.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "FrustumCuller.h"
+#include "CullingHierarchy.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const UINT kObjectsPerCluster = 32;
+	const int kFrames = 240;
+	const int kHierarchyFrames = 60;
+
+	struct Scene
+	{
+		std::vector<AxisAlignedBox> boxes;
+		std::vector<OrientedBox> orientedBoxes;
+		std::vector<AxisAlignedBox> clusters;	// Bounds of kObjectsPerCluster consecutive boxes.
+	};
+
+	// Clusters of small objects (a house and its furniture, a tree and its
+	// leaves) scattered over a flat world.
+	void BuildScene( Scene& scene, UINT count )
+	{
+		BenchRandom rng;
+
+		UINT clusterCount = ( count + kObjectsPerCluster - 1 ) / kObjectsPerCluster;
+		float worldSize = 40.0f * sqrtf( float( clusterCount ) );
+
+		scene.boxes.resize( count );
+		scene.orientedBoxes.resize( count );
+		scene.clusters.resize( clusterCount );
+
+		for( UINT c = 0; c < clusterCount; ++c )
+		{
+			XMFLOAT3 center( rng.Range( -worldSize, worldSize ) * 0.5f, rng.Range( 0.0f, 10.0f ), rng.Range( -worldSize, worldSize ) * 0.5f );
+
+			XMVECTOR vMin = XMVectorReplicate( FLT_MAX );
+			XMVECTOR vMax = XMVectorReplicate( -FLT_MAX );
+
+			UINT first = c * kObjectsPerCluster;
+			UINT last = ( first + kObjectsPerCluster < count ) ? first + kObjectsPerCluster : count;
+
+			for( UINT i = first; i < last; ++i )
+			{
+				AxisAlignedBox& box = scene.boxes[i];
+				box.Center = XMFLOAT3( center.x + rng.Range( -8.0f, 8.0f ), center.y + rng.Range( -4.0f, 4.0f ), center.z + rng.Range( -8.0f, 8.0f ) );
+				box.Extents = XMFLOAT3( rng.Range( 0.2f, 1.5f ), rng.Range( 0.2f, 1.5f ), rng.Range( 0.2f, 1.5f ) );
+
+				OrientedBox& obb = scene.orientedBoxes[i];
+				obb.Center = box.Center;
+				obb.Extents = box.Extents;
+				XMStoreFloat4( &obb.Orientation, XMQuaternionRotationRollPitchYaw( rng.Range( -1.0f, 1.0f ), rng.Range( -3.0f, 3.0f ), 0.0f ) );
+
+				// The cluster bounds the oriented boxes too, a box always fits
+				// in the sphere around its extents.
+				XMVECTOR c3 = XMLoadFloat3( &box.Center );
+				XMVECTOR r = XMVector3Length( XMLoadFloat3( &box.Extents ) );
+				vMin = XMVectorMin( vMin, c3 - r );
+				vMax = XMVectorMax( vMax, c3 + r );
+			}
+
+			XMStoreFloat3( &scene.clusters[c].Center, ( vMin + vMax ) * 0.5f );
+			XMStoreFloat3( &scene.clusters[c].Extents, ( vMax - vMin ) * 0.5f );
+		}
+	}
+
+	// A camera flying low over the world in a loop, looking ahead and slowly
+	// panning from side to side; loop goes from 0 to 1 over the whole loop.
+	void GetCameraFrustum( const Frustum& local, UINT clusterCount, float loop, Frustum* pOut )
+	{
+		float worldSize = 40.0f * sqrtf( float( clusterCount ) );
+		float t = loop * XM_2PI;
+
+		XMVECTOR position = XMVectorSet( cosf( t ) * worldSize * 0.3f, 15.0f, sinf( t ) * worldSize * 0.3f, 0.0f );
+		float yaw = -t + 0.4f * sinf( 3.0f * t );
+		XMVECTOR orientation = XMQuaternionRotationRollPitchYaw( 0.15f, yaw, 0.0f );
+
+		TransformFrustum( pOut, &local, 1.0f, orientation, position );
+	}
+
+	struct Result
+	{
+		double msPerFrame;
+		double planesPerObject;
+		UINT visible;			// Over all frames.
+		UINT mismatches;		// Objects whose result differs from the 6 plane routine.
+	};
+
+	void PrintRow( const char* volume, const char* method, UINT count, const Result& r )
+	{
+		printf( "%-5s %-26s %8u %10.3f %10.2f %10u %6u\n", volume, method, count, r.msPerFrame, r.planesPerObject,
+				r.visible / kFrames, r.mismatches );
+		fflush( stdout );
+
+		char name[96];
+		snprintf( name, sizeof( name ), "%s/%s/%u/ms", volume, method, count );
+		BenchRecord( name, r.msPerFrame, "ms" );
+		snprintf( name, sizeof( name ), "%s/%s/%u/planes", volume, method, count );
+		BenchRecord( name, r.planesPerObject, "planes/object" );
+	}
+
+	// Method 0 is the 6 plane routine, 1 FrustumCuller without and 2 with
+	// plane coherency, 3 the same after culling the clusters.
+	template<typename Volume, typename SixPlanes, typename CullOne, typename CullArray>
+	void RunMethods( const char* volumeName, const Scene& scene, const std::vector<Volume>& volumes, SixPlanes sixPlanes,
+					 CullOne cullOne, CullArray cullArray )
+	{
+		static const char* methodNames[] = { "6 planes", "culler", "culler+coherency", "culler+coherency+clusters" };
+
+		UINT count = UINT( volumes.size() );
+		UINT clusterCount = UINT( scene.clusters.size() );
+
+		XMMATRIX projection = XMMatrixPerspectiveFovLH( 0.8f, 16.0f / 9.0f, 0.5f, 400.0f );
+		Frustum local;
+		ComputeFrustumFromProjection( &local, &projection );
+
+		// Reference results of every frame.
+		std::vector< std::vector<BYTE> > reference( kFrames );
+
+		for( int method = 0; method < 4; ++method )
+		{
+			FrustumCuller culler;
+			culler.EnablePlaneCoherency( method >= 2 );
+
+			std::vector<BYTE> results( count );
+			std::vector<BYTE> lastPlane( count, 0 );
+			std::vector<BYTE> clusterLastPlane( clusterCount, 0 );
+
+			Result r = {};
+			double total = 0.0;
+			UINT64 planes = 0;
+
+			for( int f = 0; f < kFrames; ++f )
+			{
+				Frustum frustum;
+				GetCameraFrustum( local, clusterCount, float( f ) / kFrames, &frustum );
+
+				BenchTimer timer;
+
+				if( method == 0 )
+				{
+					XMVECTOR p0, p1, p2, p3, p4, p5;
+					ComputePlanesFromFrustum( &frustum, &p0, &p1, &p2, &p3, &p4, &p5 );
+					for( UINT i = 0; i < count; ++i )
+						results[i] = BYTE( sixPlanes( &volumes[i], p0, p1, p2, p3, p4, p5 ) );
+				}
+				else if( method <= 2 )
+				{
+					culler.SetFrustum( &frustum );
+					cullArray( culler, &volumes[0], count, &results[0] );
+				}
+				else
+				{
+					culler.SetFrustum( &frustum );
+					for( UINT c = 0; c < clusterCount; ++c )
+					{
+						UINT mask;
+						INT clusterResult = culler.CullAxisAlignedBox( &scene.clusters[c], &clusterLastPlane[c], FrustumCuller::AllPlanes, &mask );
+
+						UINT first = c * kObjectsPerCluster;
+						UINT last = ( first + kObjectsPerCluster < count ) ? first + kObjectsPerCluster : count;
+
+						if( clusterResult != 1 )
+						{
+							for( UINT i = first; i < last; ++i )
+								results[i] = BYTE( clusterResult );
+							continue;
+						}
+
+						for( UINT i = first; i < last; ++i )
+							results[i] = BYTE( cullOne( culler, &volumes[i], &lastPlane[i], mask ) );
+					}
+				}
+
+				total += timer.ElapsedMs();
+
+				if( method == 0 )
+				{
+					reference[f] = results;
+					planes += UINT64( count ) * 6;
+				}
+
+				for( UINT i = 0; i < count; ++i )
+				{
+					r.visible += ( results[i] != 0 );
+					r.mismatches += ( results[i] != reference[f][i] );
+				}
+			}
+
+			if( method != 0 )
+				planes = culler.GetPlanesTested();
+
+			r.msPerFrame = total / kFrames;
+			r.planesPerObject = double( planes ) / ( double( count ) * kFrames );
+			PrintRow( volumeName, methodNames[method], count, r );
+		}
+	}
+
+	// Flat culling of every object against the hierarchy, producing the
+	// list of visible objects.
+	void RunHierarchy( UINT count )
+	{
+		Scene scene;
+		BuildScene( scene, count );
+		UINT clusterCount = UINT( scene.clusters.size() );
+
+		XMMATRIX projection = XMMatrixPerspectiveFovLH( 0.8f, 16.0f / 9.0f, 0.5f, 400.0f );
+		Frustum local;
+		ComputeFrustumFromProjection( &local, &projection );
+
+		BenchTimer buildTimer;
+		CullingHierarchy hierarchy;
+		hierarchy.Build( &scene.boxes[0], count );
+		double buildMs = buildTimer.ElapsedMs();
+
+		static const char* methodNames[] = { "flat 6 planes", "flat culler+coherency", "hierarchy" };
+
+		std::vector< std::vector<UINT> > reference( kHierarchyFrames );
+
+		for( int method = 0; method < 3; ++method )
+		{
+			FrustumCuller culler;
+			std::vector<BYTE> results( count );
+			std::vector<UINT> visible;
+			visible.reserve( count );
+
+			double total = 0.0;
+			UINT64 visibleTotal = 0;
+			UINT64 nodes = 0;
+			UINT mismatches = 0;
+
+			for( int f = 0; f < kHierarchyFrames; ++f )
+			{
+				Frustum frustum;
+				GetCameraFrustum( local, clusterCount, float( f ) / kHierarchyFrames, &frustum );
+
+				BenchTimer timer;
+				visible.clear();
+
+				if( method == 0 )
+				{
+					XMVECTOR p0, p1, p2, p3, p4, p5;
+					ComputePlanesFromFrustum( &frustum, &p0, &p1, &p2, &p3, &p4, &p5 );
+					for( UINT i = 0; i < count; ++i )
+					{
+						if( IntersectAxisAlignedBox6Planes( &scene.boxes[i], p0, p1, p2, p3, p4, p5 ) )
+							visible.push_back( i );
+					}
+				}
+				else if( method == 1 )
+				{
+					culler.SetFrustum( &frustum );
+					culler.CullAxisAlignedBoxes( &scene.boxes[0], count, &results[0] );
+					for( UINT i = 0; i < count; ++i )
+					{
+						if( results[i] )
+							visible.push_back( i );
+					}
+				}
+				else
+				{
+					culler.SetFrustum( &frustum );
+					hierarchy.Cull( &culler, &visible );
+					nodes += hierarchy.GetNodesVisited();
+				}
+
+				total += timer.ElapsedMs();
+				visibleTotal += visible.size();
+
+				std::sort( visible.begin(), visible.end() );
+				if( method == 0 )
+					reference[f] = visible;
+				else if( visible != reference[f] )
+					++mismatches;
+			}
+
+			double msPerFrame = total / kHierarchyFrames;
+			printf( "%-22s %8u %10.3f %10u %12u %6u\n", methodNames[method], count, msPerFrame,
+					UINT( visibleTotal / kHierarchyFrames ), UINT( nodes / kHierarchyFrames ), mismatches );
+			fflush( stdout );
+
+			char name[96];
+			snprintf( name, sizeof( name ), "%s/%u/ms", methodNames[method], count );
+			BenchRecord( name, msPerFrame, "ms" );
+		}
+
+		printf( "%-22s %8u %10.3f (build, %u nodes)\n", "hierarchy build", count, buildMs, hierarchy.GetNodeCount() );
+		char name[96];
+		snprintf( name, sizeof( name ), "hierarchy build/%u/ms", count );
+		BenchRecord( name, buildMs, "ms" );
+	}
+}
+
+void RunCullBenchmarks()
+{
+	printf( "camera fly-through, %d frames, clusters of %u objects; planes = average planes tested per object\n",
+			kFrames, kObjectsPerCluster );
+	printf( "%-5s %-26s %8s %10s %10s %10s %6s\n", "type", "method", "objects", "ms/frame", "planes", "visible", "diff" );
+
+	UINT counts[] = { 10000, 100000 };
+	for( int c = 0; c < 2; ++c )
+	{
+		Scene scene;
+		BuildScene( scene, counts[c] );
+
+		RunMethods( "aabb", scene, scene.boxes,
+			[]( const AxisAlignedBox* v, FXMVECTOR p0, FXMVECTOR p1, FXMVECTOR p2, CXMVECTOR p3, CXMVECTOR p4, CXMVECTOR p5 )
+			{ return IntersectAxisAlignedBox6Planes( v, p0, p1, p2, p3, p4, p5 ); },
+			[]( FrustumCuller& culler, const AxisAlignedBox* v, BYTE* lastPlane, UINT mask )
+			{ return culler.CullAxisAlignedBox( v, lastPlane, mask ); },
+			[]( FrustumCuller& culler, const AxisAlignedBox* v, UINT count, BYTE* results )
+			{ return culler.CullAxisAlignedBoxes( v, count, results ); } );
+
+		RunMethods( "obb", scene, scene.orientedBoxes,
+			[]( const OrientedBox* v, FXMVECTOR p0, FXMVECTOR p1, FXMVECTOR p2, CXMVECTOR p3, CXMVECTOR p4, CXMVECTOR p5 )
+			{ return IntersectOrientedBox6Planes( v, p0, p1, p2, p3, p4, p5 ); },
+			[]( FrustumCuller& culler, const OrientedBox* v, BYTE* lastPlane, UINT mask )
+			{ return culler.CullOrientedBox( v, lastPlane, mask ); },
+			[]( FrustumCuller& culler, const OrientedBox* v, UINT count, BYTE* results )
+			{ return culler.CullOrientedBoxes( v, count, results ); } );
+	}
+
+	printf( "\nvisible list of a %d frame fly-through; nodes = hierarchy nodes tested per frame, diff = frames whose list differs\n",
+			kHierarchyFrames );
+	printf( "%-22s %8s %10s %10s %12s %6s\n", "method", "objects", "ms/frame", "visible", "nodes", "diff" );
+
+	UINT hierarchyCounts[] = { 10000, 100000, 1000000 };
+	for( int c = 0; c < 3; ++c )
+		RunHierarchy( hierarchyCounts[c] );
+}
@@ -0,0 +1,292 @@
+﻿//***************************************************************************************
+// DistanceFieldBench.cpp
+//
+// Signed distance field of a closed, bumpy sphere of 27K triangles: bake time
+// on one and on all hardware threads, brick storage against a dense grid, the
+// error of the interpolated distance, gradient and sign against the exact
+// nearest point, and the throughput of distance and sphere queries against the
+// BVH nearest point query and a loop of IntersectTriangleSphere over every
+// triangle.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "CollisionMesh.h"
+#include "SignedDistanceField.h"
+#include "ParallelFor.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const UINT kFaceCells = 48;					// Per cube face side: 6 * 48 * 48 * 2 triangles.
+	const float kRadius = 10.0f;
+	const float kCellSize = 0.25f;
+	const float kBandWidth = 1.0f;
+
+	const UINT kQueries = 1000000;
+	const UINT kBruteSpheres = 200;
+	const float kSphereRadius = 0.5f;
+
+	// Radius of the surface along a unit direction.
+	float SurfaceRadius( FXMVECTOR direction )
+	{
+		XMFLOAT3 d;
+		XMStoreFloat3( &d, direction );
+		return kRadius * ( 1.0f + 0.2f * sinf( 3.0f * d.x ) * sinf( 4.0f * d.y ) * sinf( 5.0f * d.z + 1.0f ) );
+	}
+
+	// A cube with its faces split into cells, pushed out to the bumpy sphere.
+	// The corners of neighboring faces come out at the same positions, so the
+	// welded mesh is closed; cross( V1 - V0, V2 - V0 ) points out.
+	void BuildMesh( std::vector<XMFLOAT3>& positions, std::vector<UINT>& indices )
+	{
+		static const float axes[6][9] =
+		{
+			{ 1, 0, 0, 0, 1, 0, 0, 0, 1 },
+			{ -1, 0, 0, 0, 0, 1, 0, 1, 0 },
+			{ 0, 1, 0, 0, 0, 1, 1, 0, 0 },
+			{ 0, -1, 0, 1, 0, 0, 0, 0, 1 },
+			{ 0, 0, 1, 1, 0, 0, 0, 1, 0 },
+			{ 0, 0, -1, 0, 1, 0, 1, 0, 0 },
+		};
+
+		const UINT side = kFaceCells + 1;
+		positions.clear();
+		indices.clear();
+
+		for( int f = 0; f < 6; ++f )
+		{
+			XMVECTOR n = XMVectorSet( axes[f][0], axes[f][1], axes[f][2], 0.0f );
+			XMVECTOR u = XMVectorSet( axes[f][3], axes[f][4], axes[f][5], 0.0f );
+			XMVECTOR v = XMVectorSet( axes[f][6], axes[f][7], axes[f][8], 0.0f );
+			UINT base = UINT( positions.size() );
+
+			for( UINT j = 0; j < side; ++j )
+			{
+				for( UINT i = 0; i < side; ++i )
+				{
+					float s = -1.0f + 2.0f * i / kFaceCells;
+					float t = -1.0f + 2.0f * j / kFaceCells;
+					XMVECTOR direction = XMVector3Normalize( n + u * s + v * t );
+
+					XMFLOAT3 p;
+					XMStoreFloat3( &p, direction * SurfaceRadius( direction ) );
+					positions.push_back( p );
+				}
+			}
+
+			for( UINT j = 0; j < kFaceCells; ++j )
+			{
+				for( UINT i = 0; i < kFaceCells; ++i )
+				{
+					UINT a = base + j * side + i;
+					UINT quad[6] = { a, a + 1, a + side, a + 1, a + side + 1, a + side };
+					indices.insert( indices.end(), quad, quad + 6 );
+				}
+			}
+		}
+	}
+
+	// Points within the band around the surface.
+	void BuildQueryPoints( std::vector<XMFLOAT3>& points, UINT count, BenchRandom& rng )
+	{
+		points.resize( count );
+		for( UINT i = 0; i < count; ++i )
+		{
+			XMVECTOR d;
+			float lengthSq;
+			do
+			{
+				d = XMVectorSet( rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ), 0.0f );
+				lengthSq = XMVectorGetX( XMVector3LengthSq( d ) );
+			}
+			while( lengthSq > 1.0f || lengthSq < 1e-4f );
+
+			d = d * ( 1.0f / sqrtf( lengthSq ) );
+			XMStoreFloat3( &points[i], d * ( SurfaceRadius( d ) + rng.Range( -kBandWidth, kBandWidth ) ) );
+		}
+	}
+
+	bool InsideSurface( const XMFLOAT3& p )
+	{
+		XMVECTOR v = XMLoadFloat3( &p );
+		float length = XMVectorGetX( XMVector3Length( v ) );
+		return length < SurfaceRadius( v * ( 1.0f / length ) );
+	}
+}
+
+void RunDistanceFieldBenchmarks()
+{
+	std::vector<XMFLOAT3> positions;
+	std::vector<UINT> indices;
+	BuildMesh( positions, indices );
+	UINT triangleCount = UINT( indices.size() / 3 );
+
+	CollisionMesh mesh;
+	mesh.Build( &positions[0], sizeof( XMFLOAT3 ), &indices[0], triangleCount );
+
+	printf( "%u triangles, cells of %.2f, band of %.2f, %u hardware threads\n", triangleCount, kCellSize, kBandWidth,
+			GetWorkerThreadCount() );
+
+	SignedDistanceField field;
+
+	BenchTimer timer;
+	field.Bake( &positions[0], sizeof( XMFLOAT3 ), &indices[0], triangleCount, kCellSize, kBandWidth, 1 );
+	double bake1Ms = timer.ElapsedMs();
+
+	timer.Reset();
+	field.Bake( &positions[0], sizeof( XMFLOAT3 ), &indices[0], triangleCount, kCellSize, kBandWidth, 0 );
+	double bakeMs = timer.ElapsedMs();
+
+	UINT cells = SignedDistanceField::BrickCells;
+	UINT brickSamples = ( cells + 1 ) * ( cells + 1 ) * ( cells + 1 );
+	AxisAlignedBox bounds;
+	field.GetBounds( &bounds );
+	double denseSamples = 1.0;
+	for( int a = 0; a < 3; ++a )
+		denseSamples *= 2.0f * ( &bounds.Extents.x )[a] / kCellSize + 1.0f;
+
+	printf( "bake: %.1f ms on 1 thread, %.1f ms on all; %u of %u bricks stored, %.2f MB (dense grid %.2f MB)\n", bake1Ms,
+			bakeMs, field.GetStoredBrickCount(), field.GetBrickCount(), field.GetMemorySize() / 1048576.0,
+			denseSamples * sizeof( float ) / 1048576.0 );
+	printf( "%.1f nearest point queries per us while baking\n",
+			( field.GetStoredBrickCount() * double( brickSamples ) + field.GetBrickCount() * 2.0 ) / ( bakeMs * 1000.0 ) );
+
+	BenchRecord( "bake 1 thread", bake1Ms, "ms" );
+	BenchRecord( "bake", bakeMs, "ms" );
+	BenchRecord( "memory", field.GetMemorySize() / 1048576.0, "MB" );
+
+	// Error against the exact nearest point.
+	BenchRandom rng( 5 );
+	std::vector<XMFLOAT3> points;
+	BuildQueryPoints( points, 20000, rng );
+
+	double sumError = 0.0, sumAngle = 0.0;
+	float maxError = 0.0f;
+	UINT signErrors = 0, signTests = 0;
+
+	for( size_t i = 0; i < points.size(); ++i )
+	{
+		XMVECTOR p = XMLoadFloat3( &points[i] );
+		XMVECTOR gradient;
+		float distance = field.GetDistance( p, &gradient );
+
+		ClosestHit hit;
+		mesh.FindClosestPoint( p, FLT_MAX, &hit );
+
+		float error = fabsf( fabsf( distance ) - hit.Distance );
+		sumError += error;
+		maxError = ( std::max )( maxError, error );
+
+		// The exact sign comes from the radial surface, which is close to the
+		// mesh but not on it; only points a cell away count.
+		if( hit.Distance > kCellSize )
+		{
+			signTests++;
+			if( ( distance < 0.0f ) != InsideSurface( points[i] ) )
+				signErrors++;
+
+			XMVECTOR away = XMVector3Normalize( p - XMLoadFloat3( &hit.Point ) );
+			if( distance < 0.0f )
+				away = -away;
+			float cosine = XMVectorGetX( XMVector3Dot( XMVector3Normalize( gradient ), away ) );
+			sumAngle += acosf( ( std::max )( -1.0f, ( std::min )( 1.0f, cosine ) ) );
+		}
+	}
+
+	printf( "distance error: mean %.4f, max %.4f (%.2f and %.2f cells); gradient off by %.2f degrees on average;\n"
+			"%u of %u signs wrong a cell or more from the surface\n",
+			sumError / points.size(), maxError, sumError / points.size() / kCellSize, maxError / kCellSize,
+			float( sumAngle / signTests ) * 180.0f / XM_PI, signErrors, signTests );
+
+	// Throughput.
+	BuildQueryPoints( points, kQueries, rng );
+	float sink = 0.0f;
+
+	timer.Reset();
+	for( UINT i = 0; i < kQueries; ++i )
+		sink += field.GetDistance( XMLoadFloat3( &points[i] ) );
+	double fieldMs = timer.ElapsedMs();
+
+	timer.Reset();
+	for( UINT i = 0; i < kQueries; ++i )
+	{
+		XMVECTOR gradient;
+		sink += field.GetDistance( XMLoadFloat3( &points[i] ), &gradient );
+		sink += XMVectorGetX( gradient );
+	}
+	double gradientMs = timer.ElapsedMs();
+
+	const UINT bvhQueries = kQueries / 10;
+	timer.Reset();
+	for( UINT i = 0; i < bvhQueries; ++i )
+	{
+		ClosestHit hit;
+		mesh.FindClosestPoint( XMLoadFloat3( &points[i] ), FLT_MAX, &hit );
+		sink += hit.Distance;
+	}
+	double bvhMs = timer.ElapsedMs() * kQueries / bvhQueries;
+
+	// Spheres: the field against every triangle.
+	UINT fieldHits = 0, bruteHits = 0, disagree = 0;
+	timer.Reset();
+	for( UINT i = 0; i < kQueries; ++i )
+	{
+		Sphere sphere = { points[i], kSphereRadius };
+		fieldHits += field.IntersectSphere( &sphere ) ? 1 : 0;
+	}
+	double sphereMs = timer.ElapsedMs();
+
+	double bruteMs = 0.0;
+	for( UINT i = 0; i < kBruteSpheres; ++i )
+	{
+		Sphere sphere = { points[i], kSphereRadius };
+
+		timer.Reset();
+		BOOL hit = FALSE;
+		for( UINT t = 0; t < triangleCount && !hit; ++t )
+			hit = IntersectTriangleSphere( XMLoadFloat3( &positions[indices[3 * t]] ),
+										   XMLoadFloat3( &positions[indices[3 * t + 1]] ),
+										   XMLoadFloat3( &positions[indices[3 * t + 2]] ), &sphere );
+		bruteMs += timer.ElapsedMs();
+		bruteHits += hit ? 1 : 0;
+
+		// A sphere the field calls touching but IntersectTriangleSphere does not
+		// can be one entirely inside the mesh; apart from that, only spheres
+		// within a fraction of a cell of touching may disagree.
+		ClosestHit nearest;
+		mesh.FindClosestPoint( XMLoadFloat3( &points[i] ), FLT_MAX, &nearest );
+		bool touching = nearest.Distance < kSphereRadius || InsideSurface( points[i] );
+		if( ( field.IntersectSphere( &sphere ) != 0 ) != touching &&
+			fabsf( nearest.Distance - kSphereRadius ) > 0.25f * kCellSize )
+			disagree++;
+	}
+	bruteMs *= double( kQueries ) / kBruteSpheres;
+
+	printf( "\n%-34s %12s %12s\n", "query", "ns/query", "M/s" );
+	printf( "%-34s %12.1f %12.2f\n", "field distance", fieldMs * 1e6 / kQueries, kQueries / ( fieldMs * 1000.0 ) );
+	printf( "%-34s %12.1f %12.2f\n", "field distance + gradient", gradientMs * 1e6 / kQueries,
+			kQueries / ( gradientMs * 1000.0 ) );
+	printf( "%-34s %12.1f %12.2f\n", "field sphere test", sphereMs * 1e6 / kQueries, kQueries / ( sphereMs * 1000.0 ) );
+	printf( "%-34s %12.1f %12.2f\n", "BVH nearest point", bvhMs * 1e6 / kQueries, kQueries / ( bvhMs * 1000.0 ) );
+	printf( "%-34s %12.1f %12.4f\n", "IntersectTriangleSphere loop", bruteMs * 1e6 / kQueries,
+			kQueries / ( bruteMs * 1000.0 ) );
+	printf( "field sphere test %.0fx faster than the triangle loop, %.0fx faster than the BVH; %u of %u spheres\n"
+			"disagree with the exact test by more than a quarter cell (%u of them touch by the triangle loop)\n",
+			bruteMs / sphereMs, bvhMs / sphereMs, disagree, kBruteSpheres, bruteHits );
+
+	BenchRecord( "field distance", fieldMs * 1e6 / kQueries, "ns" );
+	BenchRecord( "field distance + gradient", gradientMs * 1e6 / kQueries, "ns" );
+	BenchRecord( "field sphere test", sphereMs * 1e6 / kQueries, "ns" );
+	BenchRecord( "BVH nearest point", bvhMs * 1e6 / kQueries, "ns" );
+	BenchRecord( "IntersectTriangleSphere loop", bruteMs * 1e6 / kQueries, "ns" );
+
+	if( sink == 12345.0f )
+		printf( "%u\n", fieldHits );
+}
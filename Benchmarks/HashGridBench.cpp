@@ -0,0 +1,172 @@
+﻿//***************************************************************************************
+// HashGridBench.cpp
+//
+// Particle proximity with SpatialHashGrid: rebuild, one "within radius" query
+// per particle and all touching pairs, single threaded and on every hardware
+// thread, up to 1M particles. The query results are checked against
+// IntersectSphereSphere over all particles for a sample of the queries, whose
+// time also gives the brute force estimate.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "SpatialHashGrid.h"
+#include "ParallelFor.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const int kRepeats = 3;
+
+	// Particles per unit volume and the query radius: about 14 neighbours per
+	// query. The cells are as large as the query radius.
+	const float kDensity = 1.0f;
+	const float kQueryRadius = 1.5f;
+	const float kParticleRadius = 0.4f;
+
+	const UINT kBruteForceQueries = 64;
+
+	// All pairs brute force is quadratic, only done up to this count.
+	const UINT kMaxBruteForcePairs = 10000;
+
+	// Points in a box of constant density, and the same points as particles of
+	// radius kParticleRadius.
+	void BuildScene( std::vector<Sphere>& points, std::vector<Sphere>& particles, UINT count )
+	{
+		BenchRandom rng( count );
+
+		float size = powf( float( count ) / kDensity, 1.0f / 3.0f );
+
+		points.resize( count );
+		particles.resize( count );
+		for( UINT i = 0; i < count; ++i )
+		{
+			points[i].Center = XMFLOAT3( rng.Range( 0.0f, size ), rng.Range( 0.0f, size ), rng.Range( 0.0f, size ) );
+			points[i].Radius = 0.0f;
+
+			particles[i].Center = points[i].Center;
+			particles[i].Radius = kParticleRadius;
+		}
+	}
+
+	// Best of kRepeats runs.
+	template<typename Run>
+	double Time( Run run )
+	{
+		double best = 0.0;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			BenchTimer timer;
+			run();
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+
+	void Report( const char* method, UINT count, double ms, const char* extraName = NULL, double extra = 0.0 )
+	{
+		printf( "%-24s %9u %10.3f", method, count, ms );
+		if( extraName )
+			printf( "  %s %.0f", extraName, extra );
+		printf( "\n" );
+
+		char name[64];
+		snprintf( name, sizeof( name ), "%s %u", method, count );
+		BenchRecord( name, ms, "ms" );
+	}
+}
+
+void RunHashGridBenchmarks()
+{
+	static const UINT counts[] = { 10000, 100000, 1000000 };
+
+	printf( "%u hardware threads, best of %d runs, query radius %.1f, %.1f points per unit volume\n",
+			GetWorkerThreadCount(), kRepeats, kQueryRadius, kDensity );
+	printf( "%-24s %9s %10s\n", "method", "points", "ms" );
+
+	std::vector<Sphere> points, particles, queries;
+	std::vector<UINT> first, results, expected, found;
+	std::vector<ProxyPair> pairs, pairsMT;
+
+	SpatialHashGrid grid( kQueryRadius );
+
+	for( size_t c = 0; c < BenchCountOf( counts ); ++c )
+	{
+		UINT count = counts[c];
+		BuildScene( points, particles, count );
+
+		queries = points;
+		for( UINT i = 0; i < count; ++i )
+			queries[i].Radius = kQueryRadius;
+
+		grid.SetThreadCount( 1 );
+		Report( "build (1T)", count, Time( [&]() { grid.Build( &points[0], count ); } ) );
+		grid.SetThreadCount( 0 );
+		Report( "build (MT)", count, Time( [&]() { grid.Build( &points[0], count ); } ) );
+
+		grid.SetThreadCount( 1 );
+		double ms = Time( [&]() { grid.QuerySpheres( &queries[0], count, &first, &results ); } );
+		Report( "query all (1T)", count, ms, "results", double( results.size() ) );
+		grid.SetThreadCount( 0 );
+		ms = Time( [&]() { grid.QuerySpheres( &queries[0], count, &first, &results ); } );
+		Report( "query all (MT)", count, ms, "results", double( results.size() ) );
+
+		// Brute force on a sample of the queries, checking the grid results.
+		UINT mismatches = 0;
+		BenchTimer timer;
+		for( UINT q = 0; q < kBruteForceQueries; ++q )
+		{
+			UINT query = UINT( ( unsigned long long )q * count / kBruteForceQueries );
+
+			expected.clear();
+			for( UINT i = 0; i < count; ++i )
+			{
+				if( IntersectSphereSphere( &queries[query], &points[i] ) )
+					expected.push_back( i );
+			}
+
+			found.assign( results.begin() + first[query], results.begin() + first[query + 1] );
+			std::sort( found.begin(), found.end() );
+			if( found != expected )
+				mismatches++;
+		}
+		double bruteMs = timer.ElapsedMs() * count / kBruteForceQueries;
+		Report( "query all (brute force)", count, bruteMs );
+
+		grid.Build( &particles[0], count );
+		grid.SetThreadCount( 1 );
+		ms = Time( [&]() { grid.FindPairs( &pairs ); } );
+		Report( "pairs (1T)", count, ms, "pairs", double( pairs.size() ) );
+		grid.SetThreadCount( 0 );
+		ms = Time( [&]() { grid.FindPairs( &pairsMT ); } );
+		Report( "pairs (MT)", count, ms, "pairs", double( pairsMT.size() ) );
+
+		bool samePairs = pairs.size() == pairsMT.size() &&
+						 std::equal( pairs.begin(), pairs.end(), pairsMT.begin(), []( const ProxyPair& a, const ProxyPair& b )
+						 {
+							 return a.ProxyA == b.ProxyA && a.ProxyB == b.ProxyB;
+						 } );
+
+		printf( "%u of %u sampled queries differ from brute force, pairs %s between thread counts\n",
+				mismatches, kBruteForceQueries, samePairs ? "identical" : "DIFFERENT" );
+
+		if( count <= kMaxBruteForcePairs )
+		{
+			size_t bruteForcePairs = 0;
+			for( UINT i = 0; i < count; ++i )
+				for( UINT j = i + 1; j < count; ++j )
+					bruteForcePairs += IntersectSphereSphere( &particles[i], &particles[j] ) ? 1 : 0;
+
+			printf( "brute force finds %u pairs\n", UINT( bruteForcePairs ) );
+		}
+		printf( "\n" );
+	}
+}
@@ -0,0 +1,171 @@
+﻿//***************************************************************************************
+// HullBench.cpp
+//
+// Quickhull from 1K to 5M points, and the oriented box fitted to the hull
+// vertices against the one fitted to all the points. Two point sets: a dense
+// blob, whose hull has few vertices, and a shell of points just under an
+// ellipsoid, like the vertices of a scanned or subdivided mesh, whose hull
+// keeps a good part of them. The small sets are checked against every face.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "ConvexHull.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const int kRepeats = 3;
+	const UINT kBudget = 64;
+
+	// Sets up to this size are checked against every hull face.
+	const UINT kCheckLimit = 10000;
+
+	const XMVECTOR kOffset = XMVectorSet( 100.0f, 5.0f, -20.0f, 0.0f );
+
+	// The stretched, rotated gaussian blob of BoundsBench.
+	void BuildBlob( std::vector<XMFLOAT3>& points, UINT count )
+	{
+		BenchRandom rng;
+		XMMATRIX rotation = XMMatrixRotationRollPitchYaw( 0.3f, 0.7f, 0.1f );
+
+		points.resize( count );
+		for( UINT i = 0; i < count; ++i )
+		{
+			float x = rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f );
+			float y = rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f );
+			float z = rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f ) + rng.Range( -1.0f, 1.0f );
+
+			XMVECTOR p = XMVectorSet( x * 8.0f, y * 3.0f, z, 0.0f );
+			XMStoreFloat3( &points[i], XMVector3TransformCoord( p, rotation ) + kOffset );
+		}
+	}
+
+	// Points on an ellipsoid pushed in by up to 1% of the radius.
+	void BuildShell( std::vector<XMFLOAT3>& points, UINT count )
+	{
+		BenchRandom rng( 7 );
+		XMMATRIX rotation = XMMatrixRotationRollPitchYaw( 0.3f, 0.7f, 0.1f );
+
+		points.resize( count );
+		for( UINT i = 0; i < count; ++i )
+		{
+			XMVECTOR d;
+			float lengthSq;
+			do
+			{
+				d = XMVectorSet( rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ), 0.0f );
+				lengthSq = XMVectorGetX( XMVector3LengthSq( d ) );
+			}
+			while( lengthSq > 1.0f || lengthSq < 1e-4f );
+
+			d = d * ( rng.Range( 0.99f, 1.0f ) / sqrtf( lengthSq ) );
+			XMStoreFloat3( &points[i], XMVector3TransformCoord( d * XMVectorSet( 8.0f, 3.0f, 1.0f, 0.0f ), rotation ) + kOffset );
+		}
+	}
+
+	template<typename Build>
+	double Time( Build build )
+	{
+		double best = 0.0;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			BenchTimer timer;
+			build();
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+
+	float Volume( const OrientedBox& box )
+	{
+		return 8.0f * box.Extents.x * box.Extents.y * box.Extents.z;
+	}
+
+	// Largest distance of a point above a hull face, and whether the faces
+	// close up (a closed triangulated surface has F / 2 + 2 vertices).
+	float MaxOutside( const ConvexHull& hull, const std::vector<XMFLOAT3>& points, bool* pClosed )
+	{
+		const XMFLOAT3* v = hull.GetVertices();
+		const UINT* indices = hull.GetIndices();
+		float worst = -FLT_MAX;
+
+		for( UINT t = 0; t < hull.GetTriangleCount(); ++t )
+		{
+			XMVECTOR a = XMLoadFloat3( &v[indices[3 * t]] );
+			XMVECTOR b = XMLoadFloat3( &v[indices[3 * t + 1]] );
+			XMVECTOR c = XMLoadFloat3( &v[indices[3 * t + 2]] );
+			XMVECTOR n = XMVector3Normalize( XMVector3Cross( b - a, c - a ) );
+
+			for( size_t i = 0; i < points.size(); ++i )
+				worst = ( std::max )( worst, XMVectorGetX( XMVector3Dot( XMLoadFloat3( &points[i] ) - a, n ) ) );
+		}
+
+		*pClosed = hull.GetVertexCount() == hull.GetTriangleCount() / 2 + 2;
+		return worst;
+	}
+
+	void RunSet( const char* name, void ( *build )( std::vector<XMFLOAT3>&, UINT ), UINT count )
+	{
+		std::vector<XMFLOAT3> points;
+		build( points, count );
+
+		const XMFLOAT3* p = &points[0];
+		const UINT stride = sizeof( XMFLOAT3 );
+
+		ConvexHull hull, budget;
+		OrientedBox all, fromHull;
+
+		double hullMs = Time( [&]() { hull.Build( p, count, stride ); } );
+		double budgetMs = Time( [&]() { budget.Build( p, count, stride, kBudget ); } );
+		double allMs = Time( [&]() { ComputeBoundingOrientedBoxFromPoints( &all, count, p, stride ); } );
+		double obbMs = Time( [&]() { ComputeBoundingOrientedBoxFromHull( &fromHull, hull ); } );
+
+		printf( "%-6s %8u %9.3f %8u %9.3f %10.3f %10.4f %9.3f %9.2f %9.3f", name, count, hullMs, hull.GetVertexCount(),
+				allMs, obbMs, allMs / ( hullMs + obbMs ), Volume( fromHull ) / Volume( all ), budgetMs,
+				budget.GetMaxOutsideDistance() );
+
+		if( count <= kCheckLimit )
+		{
+			bool closed;
+			float outside = MaxOutside( hull, points, &closed );
+			printf( "  %.2g%s", outside, closed ? "" : " open" );
+		}
+		printf( "\n" );
+
+		char record[64];
+		snprintf( record, sizeof( record ), "hull %s %u", name, count );
+		BenchRecord( record, hullMs, "ms" );
+		snprintf( record, sizeof( record ), "hull %s %u budget %u", name, count, kBudget );
+		BenchRecord( record, budgetMs, "ms" );
+		snprintf( record, sizeof( record ), "obb all points %s %u", name, count );
+		BenchRecord( record, allMs, "ms" );
+		snprintf( record, sizeof( record ), "obb hull vertices %s %u", name, count );
+		BenchRecord( record, obbMs, "ms" );
+	}
+}
+
+void RunHullBenchmarks()
+{
+	static const UINT counts[] = { 1000, 10000, 100000, 1000000, 5000000 };
+
+	printf( "best of %d runs, budget of %u vertices; the box volume is relative to the box of all the points,\n"
+			"the last column is the farthest point above a face for sets of up to %u points\n",
+			kRepeats, kBudget, kCheckLimit );
+	printf( "%-6s %8s %9s %8s %9s %10s %10s %9s %9s %9s\n", "set", "points", "hull ms", "vertices", "obb ms",
+			"hull obb ms", "hull+obb x", "volume", "budget ms", "budget err" );
+
+	for( size_t c = 0; c < BenchCountOf( counts ); ++c )
+		RunSet( "blob", BuildBlob, counts[c] );
+
+	for( size_t c = 0; c < BenchCountOf( counts ); ++c )
+		RunSet( "shell", BuildShell, counts[c] );
+}
@@ -0,0 +1,259 @@
+﻿//***************************************************************************************
+// MeshCacheBench.cpp
+//
+// Startup cost of a mesh with and without the binary cache, for suzanne.obj and
+// the generated ~100 MB torus of ObjBench (both copied or written to the working
+// directory, so the caches do not land next to the repository meshes):
+//
+//   import     LoadObjFile, what every start paid before
+//   cold       LoadObjFileCached without a cache: import, build and write it
+//   warm       LoadObjFileCached with a current cache: hash the OBJ and MTL,
+//              map the cache
+//   warm+read  the same, then reading every vertex and index once, as the copy
+//              into a GPU buffer does
+//
+// "welded" is suzanne with its normals taken out: the cache keeps it welded and
+// with smooth normals, so import and cold include FillMissingNormals and warm
+// does not.
+//
+// The cached mesh must be identical to the imported one. The files are in the
+// page cache; a start from disk adds the read time of the OBJ (hashed every
+// time) and of the cache pages actually touched.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "xnacollision.h"
+#include "ObjLoader.h"
+#include "MeshCache.h"
+#include "MeshWeld.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const int kRepeats = 3;
+	const int kSmallRepeats = 20;
+
+	const UINT kRings = 1100;
+	const UINT kSides = 540;
+
+	bool CopyFile( const char* from, const char* to )
+	{
+		FILE* in = fopen( from, "rb" );
+		if( !in )
+			return false;
+
+		FILE* out = fopen( to, "wb" );
+		bool ok = out != NULL;
+		char buffer[65536];
+		size_t read;
+		while( ok && ( read = fread( buffer, 1, sizeof( buffer ), in ) ) > 0 )
+			ok = fwrite( buffer, 1, read, out ) == read;
+
+		fclose( in );
+		if( out )
+			ok = fclose( out ) == 0 && ok;
+		return ok;
+	}
+
+	// The OBJ without its normals: no vn lines, and "v/t/n" or "v//n" corners
+	// become "v/t" and "v".
+	bool CopyWithoutNormals( const char* from, const char* to )
+	{
+		FILE* in = fopen( from, "r" );
+		if( !in )
+			return false;
+
+		FILE* out = fopen( to, "w" );
+		bool ok = out != NULL;
+		char line[4096];
+		while( ok && fgets( line, sizeof( line ), in ) )
+		{
+			if( strncmp( line, "vn ", 3 ) == 0 )
+				continue;
+
+			std::string text( line );
+			if( strncmp( line, "f ", 2 ) == 0 )
+			{
+				text = "f";
+				for( char* corner = strtok( line + 2, " \t\r\n" ); corner; corner = strtok( NULL, " \t\r\n" ) )
+				{
+					std::string kept( corner );
+					size_t first = kept.find( '/' );
+					size_t second = first == std::string::npos ? first : kept.find( '/', first + 1 );
+					if( second != std::string::npos )
+						kept.resize( second == first + 1 ? first : second );
+					text += " " + kept;
+				}
+				text += "\n";
+			}
+			ok = fputs( text.c_str(), out ) >= 0;
+		}
+
+		fclose( in );
+		if( out )
+			ok = fclose( out ) == 0 && ok;
+		return ok;
+	}
+
+	long FileSize( const char* path )
+	{
+		FILE* file = fopen( path, "rb" );
+		if( !file )
+			return 0;
+		fseek( file, 0, SEEK_END );
+		long size = ftell( file );
+		fclose( file );
+		return size;
+	}
+
+	bool SameMesh( const ImportedMesh& a, const ImportedMesh& b )
+	{
+		if( a.Vertices.size() != b.Vertices.size() || a.Indices != b.Indices || a.Subsets.size() != b.Subsets.size() ||
+			a.Materials.size() != b.Materials.size() )
+			return false;
+
+		for( size_t i = 0; i < a.Materials.size(); ++i )
+		{
+			if( a.Materials[i].Name != b.Materials[i].Name ||
+				memcmp( &a.Materials[i].Diffuse, &b.Materials[i].Diffuse, sizeof( XMFLOAT3 ) ) != 0 )
+				return false;
+		}
+
+		return a.Vertices.empty() ||
+			   memcmp( &a.Vertices[0], &b.Vertices[0], a.Vertices.size() * sizeof( ImportedVertex ) ) == 0;
+	}
+
+	// Touches the mapped arrays the way an upload would.
+	float ReadAll( const MeshCache& cache )
+	{
+		const float* p = ( const float* )cache.GetVertices();
+		size_t count = size_t( cache.GetVertexCount() ) * sizeof( ImportedVertex ) / sizeof( float );
+		float sum = 0.0f;
+		for( size_t i = 0; i < count; ++i )
+			sum += p[i];
+
+		const UINT* indices = cache.GetIndices();
+		UINT bits = 0;
+		for( UINT i = 0; i < cache.GetIndexCount(); ++i )
+			bits ^= indices[i];
+		return sum + float( bits & 1 );
+	}
+
+	template<typename Load>
+	double Time( int repeats, Load load )
+	{
+		double best = 0.0;
+		for( int r = 0; r < repeats; ++r )
+		{
+			BenchTimer timer;
+			load();
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+
+	void RunFile( const char* name, const char* path, int repeats, const MeshMissingNormalOptions* options = NULL )
+	{
+		std::string cacheName = std::string( path ) + ".meshcache";
+		remove( cacheName.c_str() );
+
+		ImportedMesh imported, cached;
+		bool ok = LoadObjFile( path, &imported );
+
+		double importMs = Time( repeats, [&]()
+		{
+			LoadObjFile( path, &imported );
+			if( options )
+				FillMissingNormals( &imported, *options );
+		} );
+		double coldMs = Time( repeats, [&]()
+		{
+			remove( cacheName.c_str() );
+			MeshCache cache;
+			LoadObjFileCached( path, &cache, 0, options );
+		} );
+
+		MeshCache check;
+		ok = ok && LoadObjFileCached( path, &check, 0, options ) && check.GetOptionsKey() == GetMeshCacheOptionsKey( options );
+		check.GetMesh( &cached );
+		check.Close();
+		bool same = ok && cached.HasNormals == imported.HasNormals && SameMesh( imported, cached );
+
+		double warmMs = Time( repeats, [&]()
+		{
+			MeshCache cache;
+			LoadObjFileCached( path, &cache, 0, options );
+		} );
+
+		volatile float sink = 0.0f;
+		double readMs = Time( repeats, [&]()
+		{
+			MeshCache cache;
+			LoadObjFileCached( path, &cache, 0, options );
+			sink = sink + ReadAll( cache );
+		} );
+
+		UINT64 hash, size;
+		double hashMs = Time( repeats, [&]() { ComputeFileHash( path, &hash, &size ); } );
+
+		double objMb = FileSize( path ) / ( 1024.0 * 1024.0 );
+		double cacheMb = FileSize( cacheName.c_str() ) / ( 1024.0 * 1024.0 );
+
+		printf( "%-8s %8.1f %8.1f %10.2f %10.2f %10.3f %10.3f %9.3f %8.0fx  %s\n", name, objMb, cacheMb, importMs, coldMs,
+				warmMs, readMs, hashMs, importMs / readMs, !ok ? "load failed" : same ? "same" : "DIFFERENT" );
+
+		char record[64];
+		snprintf( record, sizeof( record ), "meshcache %s import", name );
+		BenchRecord( record, importMs, "ms" );
+		snprintf( record, sizeof( record ), "meshcache %s cold", name );
+		BenchRecord( record, coldMs, "ms" );
+		snprintf( record, sizeof( record ), "meshcache %s warm", name );
+		BenchRecord( record, warmMs, "ms" );
+		snprintf( record, sizeof( record ), "meshcache %s warm read", name );
+		BenchRecord( record, readMs, "ms" );
+
+		remove( cacheName.c_str() );
+	}
+}
+
+void RunMeshCacheBenchmarks()
+{
+	printf( "best of %d runs (%d for suzanne), files in the page cache\n", kRepeats, kSmallRepeats );
+	printf( "%-8s %8s %8s %10s %10s %10s %10s %9s %9s\n", "file", "obj MB", "cache MB", "import ms", "cold ms",
+			"warm ms", "warm+read", "hash ms", "speedup" );
+
+	const char* suzanne = "MeshCacheBenchSuzanne.obj";
+	const char* path = FindBenchMeshFile();
+	bool copied = path && CopyFile( path, suzanne );
+
+	if( copied )
+		RunFile( "suzanne", suzanne, kSmallRepeats );
+	else
+		printf( "suzanne.obj not found, run from the repository root\n" );
+
+	const char* welded = "MeshCacheBenchWelded.obj";
+	MeshMissingNormalOptions options;
+	options.Normals.CreaseAngle = XMConvertToRadians( 60.0f );
+	if( copied && CopyWithoutNormals( suzanne, welded ) )
+		RunFile( "welded", welded, kSmallRepeats, &options );
+	remove( welded );
+	remove( suzanne );
+
+	const char* torus = "MeshCacheBenchTorus.obj";
+	long size;
+	if( WriteBenchTorusObj( torus, kRings, kSides, &size ) )
+		RunFile( "torus", torus, kRepeats );
+	else
+		printf( "cannot write %s\n", torus );
+	remove( torus );
+}
@@ -0,0 +1,235 @@
+﻿//***************************************************************************************
+// MeshCodecBench.cpp
+//
+// Vertex and index buffer codecs on suzanne.obj and on a torus of
+// kSegments x kRings quads, the torus both as ImportedVertex (32 bytes) and
+// in the GeometryGenerator::Vertex layout (44 bytes, with tangents). For
+// each buffer: the encoded size, the size once LZ4 compressed as an archive
+// entry would be, and the decode speed in GB/s of decoded bytes, against a
+// memcpy and an LZ4 decompression of the raw buffer.
+//
+// The decoded vertices must be the same bytes, the decoded triangles the
+// same up to rotation.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "xnacollision.h"
+#include "AssetArchive.h"
+#include "MeshCodec.h"
+#include "ObjLoader.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const UINT kSegments = 1024;
+	const UINT kRings = 512;
+	const float kMajorRadius = 3.0f;
+	const float kMinorRadius = 1.0f;
+	const int kRepeats = 5;
+	const double kMinTimeMs = 50.0;
+
+	// Same layout as GeometryGenerator::Vertex.
+	struct GeneratorVertex
+	{
+		XMFLOAT3 Position;
+		XMFLOAT3 Normal;
+		XMFLOAT3 TangentU;
+		XMFLOAT2 TexC;
+	};
+
+	void BuildTorus( std::vector<ImportedVertex>* vertices, std::vector<GeneratorVertex>* generator, std::vector<UINT>* indices )
+	{
+		vertices->clear();
+		generator->clear();
+		for( UINT s = 0; s <= kSegments; ++s )
+		{
+			for( UINT r = 0; r <= kRings; ++r )
+			{
+				float u = float( s ) / kSegments;
+				float v = float( r ) / kRings;
+				float theta = u * XM_2PI;
+				float phi = v * XM_2PI;
+				float radius = kMajorRadius + kMinorRadius * cosf( phi );
+
+				ImportedVertex vertex;
+				vertex.Position = XMFLOAT3( radius * cosf( theta ), kMinorRadius * sinf( phi ), radius * sinf( theta ) );
+				vertex.Normal = XMFLOAT3( cosf( phi ) * cosf( theta ), sinf( phi ), cosf( phi ) * sinf( theta ) );
+				vertex.TexCoord = XMFLOAT2( u, v );
+				vertices->push_back( vertex );
+
+				GeneratorVertex g;
+				g.Position = vertex.Position;
+				g.Normal = vertex.Normal;
+				g.TangentU = XMFLOAT3( -sinf( theta ), 0.0f, cosf( theta ) );
+				g.TexC = vertex.TexCoord;
+				generator->push_back( g );
+			}
+		}
+
+		indices->clear();
+		for( UINT s = 0; s < kSegments; ++s )
+		{
+			for( UINT r = 0; r < kRings; ++r )
+			{
+				UINT v00 = s * ( kRings + 1 ) + r, v01 = v00 + 1;
+				UINT v10 = v00 + kRings + 1, v11 = v10 + 1;
+				UINT quad[6] = { v00, v01, v11, v00, v11, v10 };
+				indices->insert( indices->end(), quad, quad + 6 );
+			}
+		}
+	}
+
+	// Best time of one run in ms; short runs are repeated to last kMinTimeMs.
+	template <class Run>
+	double Time( Run run )
+	{
+		int loops = 1;
+		for( ;; )
+		{
+			BenchTimer timer;
+			for( int i = 0; i < loops; ++i )
+				run();
+			if( timer.ElapsedMs() >= kMinTimeMs || loops >= ( 1 << 20 ) )
+				break;
+			loops *= 2;
+		}
+
+		double best = 0.0;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			BenchTimer timer;
+			for( int i = 0; i < loops; ++i )
+				run();
+			double ms = timer.ElapsedMs() / loops;
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+
+	double GBs( size_t bytes, double ms )
+	{
+		return bytes / ( ms * 1e6 );
+	}
+
+	size_t Lz4Size( const BYTE* data, size_t size )
+	{
+		std::vector<BYTE> compressed( GetLz4CompressBound( size ) );
+		return CompressLz4Block( data, size, compressed.empty() ? NULL : &compressed[0], compressed.size() );
+	}
+
+	bool SameTriangles( const std::vector<UINT>& a, const std::vector<UINT>& b )
+	{
+		if( a.size() != b.size() )
+			return false;
+		for( size_t t = 0; t < a.size(); t += 3 )
+		{
+			bool same = false;
+			for( int r = 0; r < 3 && !same; ++r )
+				same = a[t] == b[t + r] && a[t + 1] == b[t + ( r + 1 ) % 3] && a[t + 2] == b[t + ( r + 2 ) % 3];
+			if( !same )
+				return false;
+		}
+		return true;
+	}
+
+	// Raw size, LZ4, codec, codec + LZ4, then decode speeds.
+	void PrintRow( const char* mesh, const char* kind, size_t raw, size_t lz4, size_t encoded, size_t encodedLz4,
+		double memcpyMs, double lz4Ms, double decodeMs, bool same )
+	{
+		printf( "%-9s %-8s %10u %7.2fx %7.2fx %7.2fx %9.2f %9.2f %9.2f  %s\n", mesh, kind, UINT( raw ),
+			double( raw ) / lz4, double( raw ) / encoded, double( raw ) / encodedLz4,
+			GBs( raw, memcpyMs ), GBs( raw, lz4Ms ), GBs( raw, decodeMs ), same ? "same" : "DIFFERENT" );
+	}
+
+	// Vertices of any layout: encodes, decodes and times.
+	void RunVertices( const char* mesh, const void* vertices, UINT count, UINT stride, double* ratio, double* gbs )
+	{
+		size_t raw = size_t( count ) * stride;
+		const BYTE* bytes = static_cast<const BYTE*>( vertices );
+		std::vector<BYTE> encoded;
+		EncodeVertexBuffer( vertices, count, stride, &encoded );
+
+		std::vector<BYTE> decoded( raw );
+		std::vector<BYTE> lz4( GetLz4CompressBound( raw ) );
+		size_t lz4Size = CompressLz4Block( bytes, raw, &lz4[0], lz4.size() );
+
+		bool same = DecodeVertexBuffer( &decoded[0], count, stride, &encoded[0], encoded.size() ) &&
+			memcmp( &decoded[0], bytes, raw ) == 0;
+		double memcpyMs = Time( [&]() { memcpy( &decoded[0], bytes, raw ); } );
+		double lz4Ms = Time( [&]() { DecompressLz4Block( &lz4[0], lz4Size, &decoded[0], raw ); } );
+		double decodeMs = Time( [&]() { DecodeVertexBuffer( &decoded[0], count, stride, &encoded[0], encoded.size() ); } );
+
+		PrintRow( mesh, stride == sizeof( ImportedVertex ) ? "vertices" : "vert44", raw, lz4Size, encoded.size(),
+			Lz4Size( &encoded[0], encoded.size() ), memcpyMs, lz4Ms, decodeMs, same );
+		*ratio = double( raw ) / encoded.size();
+		*gbs = GBs( raw, decodeMs );
+	}
+
+	void RunIndices( const char* mesh, const std::vector<UINT>& indices, double* ratio, double* gbs )
+	{
+		UINT count = UINT( indices.size() );
+		size_t raw = indices.size() * sizeof( UINT );
+		const BYTE* bytes = reinterpret_cast<const BYTE*>( &indices[0] );
+		std::vector<BYTE> encoded;
+		EncodeIndexBuffer( &indices[0], count, &encoded );
+
+		std::vector<UINT> decoded( count );
+		std::vector<BYTE> lz4( GetLz4CompressBound( raw ) );
+		size_t lz4Size = CompressLz4Block( bytes, raw, &lz4[0], lz4.size() );
+
+		bool same = DecodeIndexBuffer( &decoded[0], count, &encoded[0], encoded.size() ) && SameTriangles( indices, decoded );
+		double memcpyMs = Time( [&]() { memcpy( &decoded[0], bytes, raw ); } );
+		double lz4Ms = Time( [&]() { DecompressLz4Block( &lz4[0], lz4Size, reinterpret_cast<BYTE*>( &decoded[0] ), raw ); } );
+		double decodeMs = Time( [&]() { DecodeIndexBuffer( &decoded[0], count, &encoded[0], encoded.size() ); } );
+
+		PrintRow( mesh, "indices", raw, lz4Size, encoded.size(), Lz4Size( &encoded[0], encoded.size() ),
+			memcpyMs, lz4Ms, decodeMs, same );
+		*ratio = double( raw ) / encoded.size();
+		*gbs = GBs( raw, decodeMs );
+	}
+}
+
+void RunMeshCodecBenchmarks()
+{
+	printf( "%-9s %-8s %10s %8s %8s %8s %9s %9s %9s  %s\n", "mesh", "buffer", "bytes", "lz4", "codec", "codec+4",
+		"memcpy", "lz4 GB/s", "codec", "check" );
+
+	ImportedMesh suzanne;
+	const char* path = FindBenchMeshFile();
+	bool loaded = path && LoadObjFile( path, &suzanne );
+
+	double ratio = 0.0, gbs = 0.0;
+	if( loaded )
+	{
+		RunVertices( "suzanne", &suzanne.Vertices[0], UINT( suzanne.Vertices.size() ), sizeof( ImportedVertex ), &ratio, &gbs );
+		BenchRecord( "codec suzanne vertex ratio", ratio, "x" );
+		RunIndices( "suzanne", suzanne.Indices, &ratio, &gbs );
+		BenchRecord( "codec suzanne index ratio", ratio, "x" );
+	}
+	else
+	{
+		printf( "suzanne.obj not found\n" );
+	}
+
+	std::vector<ImportedVertex> vertices;
+	std::vector<GeneratorVertex> generator;
+	std::vector<UINT> indices;
+	BuildTorus( &vertices, &generator, &indices );
+	RunVertices( "torus", &vertices[0], UINT( vertices.size() ), sizeof( ImportedVertex ), &ratio, &gbs );
+	BenchRecord( "codec torus vertex ratio", ratio, "x" );
+	BenchRecord( "codec torus vertex decode", gbs, "GB/s" );
+	RunVertices( "torus", &generator[0], UINT( generator.size() ), sizeof( GeneratorVertex ), &ratio, &gbs );
+	BenchRecord( "codec torus vertex44 ratio", ratio, "x" );
+	RunIndices( "torus", indices, &ratio, &gbs );
+	BenchRecord( "codec torus index ratio", ratio, "x" );
+	BenchRecord( "codec torus index decode", gbs, "GB/s" );
+}
@@ -0,0 +1,312 @@
+﻿//***************************************************************************************
+// ObjBench.cpp
+//
+// OBJ import: LoadObjFile on one thread and on every hardware thread, against a
+// plain line by line reader (fgets, strtof and a std::map of v/vt/vn tuples)
+// and, when the runner is built with Assimp (BENCH_WITH_ASSIMP), against
+// Assimp::Importer::ReadFile with aiProcess_Triangulate as the demos used it.
+// Two files: suzanne.obj, and a generated torus of about 100 MB with positions,
+// texture coordinates, normals and quads. The reader must produce exactly the
+// vertices and indices of the line by line reader.
+//
+// Both files are read once before timing, so the times are for a file in the
+// page cache, not for the disk.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "xnacollision.h"
+#include "ObjLoader.h"
+#include "ParallelFor.h"
+#include "Benchmark.h"
+
+#if defined( BENCH_WITH_ASSIMP )
+#include "Importer.hpp"
+#include "scene.h"
+#include "postprocess.h"
+#endif
+
+using namespace XNA;
+
+namespace
+{
+	const int kRepeats = 3;
+	const int kSmallRepeats = 50;
+
+	// Torus of kRings x kSides quads, about 170 bytes per quad.
+	const UINT kRings = 1100;
+	const UINT kSides = 540;
+	const char* const kLargeFile = "ObjBenchTorus.obj";
+
+	// The straightforward reader: one line at a time, strtof, and a std::map
+	// from v/vt/vn tuples to vertices. Only positive indices.
+	struct TupleKey
+	{
+		int v, vt, vn;
+		bool operator<( const TupleKey& o ) const
+		{
+			return v != o.v ? v < o.v : vt != o.vt ? vt < o.vt : vn < o.vn;
+		}
+	};
+
+	bool LoadObjLineByLine( const char* path, std::vector<ImportedVertex>& vertices, std::vector<UINT>& indices )
+	{
+		FILE* file = fopen( path, "r" );
+		if( !file )
+			return false;
+
+		std::vector<XMFLOAT3> positions, normals;
+		std::vector<XMFLOAT2> texCoords;
+		std::map<TupleKey, UINT> tuples;
+		vertices.clear();
+		indices.clear();
+
+		char line[1024];
+		while( fgets( line, sizeof( line ), file ) )
+		{
+			char* p = line;
+			if( p[0] == 'v' && p[1] == ' ' )
+			{
+				XMFLOAT3 v;
+				v.x = strtof( p + 2, &p );
+				v.y = strtof( p, &p );
+				v.z = strtof( p, &p );
+				positions.push_back( v );
+			}
+			else if( p[0] == 'v' && p[1] == 't' )
+			{
+				XMFLOAT2 t;
+				t.x = strtof( p + 3, &p );
+				t.y = strtof( p, &p );
+				texCoords.push_back( t );
+			}
+			else if( p[0] == 'v' && p[1] == 'n' )
+			{
+				XMFLOAT3 n;
+				n.x = strtof( p + 3, &p );
+				n.y = strtof( p, &p );
+				n.z = strtof( p, &p );
+				normals.push_back( n );
+			}
+			else if( p[0] == 'f' && p[1] == ' ' )
+			{
+				UINT face[16];
+				UINT count = 0;
+				for( char* token = strtok( p + 2, " \t\r\n" ); token && count < 16; token = strtok( NULL, " \t\r\n" ) )
+				{
+					TupleKey key = { 0, 0, 0 };
+					key.v = strtol( token, &token, 10 );
+					if( *token == '/' )
+					{
+						key.vt = strtol( token + 1, &token, 10 );
+						if( *token == '/' )
+							key.vn = strtol( token + 1, &token, 10 );
+					}
+
+					std::map<TupleKey, UINT>::iterator it = tuples.find( key );
+					if( it == tuples.end() )
+					{
+						ImportedVertex vertex;
+						vertex.Position = positions[key.v - 1];
+						vertex.TexCoord = key.vt ? texCoords[key.vt - 1] : XMFLOAT2( 0.0f, 0.0f );
+						vertex.Normal = key.vn ? normals[key.vn - 1] : XMFLOAT3( 0.0f, 0.0f, 0.0f );
+						it = tuples.insert( std::make_pair( key, UINT( vertices.size() ) ) ).first;
+						vertices.push_back( vertex );
+					}
+					face[count++] = it->second;
+				}
+
+				for( UINT i = 2; i < count; ++i )
+				{
+					indices.push_back( face[0] );
+					indices.push_back( face[i - 1] );
+					indices.push_back( face[i] );
+				}
+			}
+		}
+
+		fclose( file );
+		return true;
+	}
+
+	bool SameMesh( const ImportedMesh& mesh, const std::vector<ImportedVertex>& vertices, const std::vector<UINT>& indices )
+	{
+		if( mesh.Vertices.size() != vertices.size() || mesh.Indices != indices )
+			return false;
+
+		return vertices.empty() ||
+			   memcmp( &mesh.Vertices[0], &vertices[0], vertices.size() * sizeof( ImportedVertex ) ) == 0;
+	}
+
+	template<typename Load>
+	double Time( int repeats, Load load )
+	{
+		double best = 0.0;
+		for( int r = 0; r < repeats; ++r )
+		{
+			BenchTimer timer;
+			load();
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+
+	void RunFile( const char* name, const char* path, double megabytes, int repeats )
+	{
+		UINT threads = GetWorkerThreadCount();
+		ImportedMesh mesh;
+		std::vector<ImportedVertex> vertices;
+		std::vector<UINT> indices;
+
+		// Warm the page cache and check the result.
+		bool ok = LoadObjFile( path, &mesh ) && LoadObjLineByLine( path, vertices, indices );
+		bool same = ok && SameMesh( mesh, vertices, indices );
+
+		double oneMs = Time( repeats, [&]() { LoadObjFile( path, &mesh, 1 ); } );
+		double allMs = Time( repeats, [&]() { LoadObjFile( path, &mesh, threads ); } );
+		double lineMs = Time( ( std::min )( repeats, kRepeats ), [&]() { LoadObjLineByLine( path, vertices, indices ); } );
+
+		printf( "%-8s %8.1f %9u %9u %10.2f %10.2f %8.0f %10.2f", name, megabytes, UINT( mesh.Vertices.size() ),
+				UINT( mesh.Indices.size() / 3 ), oneMs, allMs, megabytes * 1000.0 / allMs, lineMs );
+
+		char record[64];
+#if defined( BENCH_WITH_ASSIMP )
+		double assimpMs = Time( ( std::min )( repeats, kRepeats ), [&]()
+		{
+			Assimp::Importer importer;
+			importer.ReadFile( path, aiProcess_Triangulate );
+		} );
+		printf( " %10.2f", assimpMs );
+		snprintf( record, sizeof( record ), "obj %s assimp", name );
+		BenchRecord( record, assimpMs, "ms" );
+#endif
+		printf( "  %s\n", !ok ? "load failed" : same ? "same" : "DIFFERENT" );
+
+		snprintf( record, sizeof( record ), "obj %s 1 thread", name );
+		BenchRecord( record, oneMs, "ms" );
+		snprintf( record, sizeof( record ), "obj %s %u threads", name, threads );
+		BenchRecord( record, allMs, "ms" );
+		snprintf( record, sizeof( record ), "obj %s line by line", name );
+		BenchRecord( record, lineMs, "ms" );
+	}
+}
+
+// Positions and normals wrap around, the texture coordinates do not, so the
+// seams have vertices with the same position and normal but another texture
+// coordinate.
+bool WriteBenchTorusObj( const char* path, UINT rings, UINT sides, long* pSize )
+{
+	FILE* file = fopen( path, "wb" );
+	if( !file )
+		return false;
+
+	const float R = 3.0f, r = 1.0f;
+	fprintf( file, "# ObjBench torus, %u x %u quads\no torus\n", rings, sides );
+
+	for( UINT i = 0; i < rings; ++i )
+	{
+		float u = XM_2PI * i / rings;
+		for( UINT j = 0; j < sides; ++j )
+		{
+			float v = XM_2PI * j / sides;
+			float nx = cosf( u ) * cosf( v ), ny = sinf( u ) * cosf( v ), nz = sinf( v );
+			fprintf( file, "v %.6f %.6f %.6f\n", R * cosf( u ) + r * nx, R * sinf( u ) + r * ny, r * nz );
+			fprintf( file, "vn %.6f %.6f %.6f\n", nx, ny, nz );
+		}
+	}
+
+	for( UINT i = 0; i <= rings; ++i )
+	{
+		for( UINT j = 0; j <= sides; ++j )
+			fprintf( file, "vt %.6f %.6f\n", float( i ) / rings, float( j ) / sides );
+	}
+
+	for( UINT i = 0; i < rings; ++i )
+	{
+		for( UINT j = 0; j < sides; ++j )
+		{
+			UINT p[4] = { i * sides + j, ( ( i + 1 ) % rings ) * sides + j,
+						  ( ( i + 1 ) % rings ) * sides + ( j + 1 ) % sides, i * sides + ( j + 1 ) % sides };
+			UINT t[4] = { i * ( sides + 1 ) + j, ( i + 1 ) * ( sides + 1 ) + j, ( i + 1 ) * ( sides + 1 ) + j + 1,
+						  i * ( sides + 1 ) + j + 1 };
+			fprintf( file, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", p[0] + 1, t[0] + 1, p[0] + 1, p[1] + 1,
+					 t[1] + 1, p[1] + 1, p[2] + 1, t[2] + 1, p[2] + 1, p[3] + 1, t[3] + 1, p[3] + 1 );
+		}
+	}
+
+	*pSize = ftell( file );
+	return fclose( file ) == 0;
+}
+
+const char* FindBenchMeshFile()
+{
+	static const char* const paths[] =
+	{
+		"Common/meshes/suzanne.obj",
+		"../Common/meshes/suzanne.obj",
+		"../../Common/meshes/suzanne.obj",
+		"suzanne.obj",
+	};
+
+	for( size_t i = 0; i < BenchCountOf( paths ); ++i )
+	{
+		FILE* file = fopen( paths[i], "rb" );
+		if( file )
+		{
+			fclose( file );
+			return paths[i];
+		}
+	}
+	return NULL;
+}
+
+void RunObjBenchmarks()
+{
+	const char* path = FindBenchMeshFile();
+
+	printf( "best of %d runs (%d for suzanne), files in the page cache; %u hardware threads\n", kRepeats,
+			kSmallRepeats, GetWorkerThreadCount() );
+#if defined( BENCH_WITH_ASSIMP )
+	printf( "%-8s %8s %9s %9s %10s %10s %8s %10s %10s\n", "file", "MB", "vertices", "triangles", "1 thread", "all ms",
+			"MB/s", "lines ms", "assimp ms" );
+#else
+	printf( "%-8s %8s %9s %9s %10s %10s %8s %10s   (built without Assimp)\n", "file", "MB", "vertices",
+			"triangles", "1 thread", "all ms", "MB/s", "lines ms" );
+#endif
+
+	if( path )
+	{
+		FILE* file = fopen( path, "rb" );
+		fseek( file, 0, SEEK_END );
+		double megabytes = ftell( file ) / ( 1024.0 * 1024.0 );
+		fclose( file );
+		RunFile( "suzanne", path, megabytes, kSmallRepeats );
+	}
+	else
+	{
+		printf( "suzanne.obj not found, run from the repository root\n" );
+	}
+
+	long size = 0;
+	BenchTimer timer;
+	if( !WriteBenchTorusObj( kLargeFile, kRings, kSides, &size ) )
+	{
+		printf( "cannot write %s\n", kLargeFile );
+		remove( kLargeFile );
+		return;
+	}
+	double writeMs = timer.ElapsedMs();
+
+	RunFile( "torus", kLargeFile, size / ( 1024.0 * 1024.0 ), kRepeats );
+	printf( "(torus written in %.0f ms)\n", writeMs );
+	remove( kLargeFile );
+}
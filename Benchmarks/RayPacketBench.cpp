@@ -0,0 +1,297 @@
+﻿//***************************************************************************************
+// RayPacketBench.cpp
+//
+// Throughput of the single ray intersection routines against the 4 and 8 lane
+// packet routines, for several rays against one primitive and for one ray
+// against several primitives. Every variant finds the nearest hit of a grid of
+// coherent picking rays among the same primitives.
+//***************************************************************************************
+
+#include <cfloat>
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const UINT kRayGrid = 64;			// kRayGrid * kRayGrid rays.
+	const UINT kPrimitives = 256;
+	const int kRepeats = 5;
+
+	struct Scene
+	{
+		std::vector<XMFLOAT3> origins;
+		std::vector<XMFLOAT3> directions;
+		std::vector<Sphere> spheres;
+		std::vector<AxisAlignedBox> boxes;
+		std::vector<XMFLOAT3> triangles;	// V0, V1, V2 per triangle.
+	};
+
+	// A pinhole camera looking down +z at primitives scattered in front of it.
+	void BuildScene( Scene& scene )
+	{
+		BenchRandom rng;
+
+		UINT rayCount = kRayGrid * kRayGrid;
+		scene.origins.assign( rayCount, XMFLOAT3( 0.0f, 0.0f, -20.0f ) );
+		scene.directions.resize( rayCount );
+
+		for( UINT y = 0; y < kRayGrid; ++y )
+		{
+			for( UINT x = 0; x < kRayGrid; ++x )
+			{
+				float u = ( x + 0.5f ) / kRayGrid * 2.0f - 1.0f;
+				float v = ( y + 0.5f ) / kRayGrid * 2.0f - 1.0f;
+				XMVECTOR d = XMVector3Normalize( XMVectorSet( u * 0.5f, v * 0.5f, 1.0f, 0.0f ) );
+				XMStoreFloat3( &scene.directions[y * kRayGrid + x], d );
+			}
+		}
+
+		scene.spheres.resize( kPrimitives );
+		scene.boxes.resize( kPrimitives );
+		scene.triangles.resize( kPrimitives * 3 );
+
+		for( UINT i = 0; i < kPrimitives; ++i )
+		{
+			XMFLOAT3 center( rng.Range( -10.0f, 10.0f ), rng.Range( -10.0f, 10.0f ), rng.Range( 0.0f, 20.0f ) );
+
+			scene.spheres[i].Center = center;
+			scene.spheres[i].Radius = rng.Range( 0.2f, 1.0f );
+
+			scene.boxes[i].Center = center;
+			scene.boxes[i].Extents = XMFLOAT3( rng.Range( 0.2f, 1.0f ), rng.Range( 0.2f, 1.0f ), rng.Range( 0.2f, 1.0f ) );
+
+			for( int k = 0; k < 3; ++k )
+			{
+				scene.triangles[i * 3 + k] = XMFLOAT3( center.x + rng.Range( -1.0f, 1.0f ), center.y + rng.Range( -1.0f, 1.0f ),
+													   center.z + rng.Range( -1.0f, 1.0f ) );
+			}
+		}
+	}
+
+	// Ray/primitive pair tests per microsecond.
+	void PrintRow( const char* primitive, const char* method, double ms, UINT hits )
+	{
+		double tests = double( kRayGrid * kRayGrid ) * kPrimitives * kRepeats;
+		printf( "%-10s %-28s %10.2f %12.1f %8u\n", primitive, method, ms, tests / ( ms * 1000.0 ), hits );
+
+		char name[96];
+		snprintf( name, sizeof( name ), "%s %s", primitive, method );
+		BenchRecord( name, ms, "ms" );
+	}
+
+	//------------------------------------------------------------------------------------
+	// Single ray routines.
+	//------------------------------------------------------------------------------------
+	template<typename Test>
+	void RunSingle( const Scene& scene, const char* primitive, Test test )
+	{
+		UINT rayCount = UINT( scene.origins.size() );
+		UINT hits = 0;
+
+		BenchTimer timer;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			hits = 0;
+			for( UINT i = 0; i < rayCount; ++i )
+			{
+				XMVECTOR origin = XMLoadFloat3( &scene.origins[i] );
+				XMVECTOR direction = XMLoadFloat3( &scene.directions[i] );
+
+				float nearest = FLT_MAX;
+				for( UINT p = 0; p < kPrimitives; ++p )
+				{
+					float dist;
+					if( test( origin, direction, p, &dist ) && dist < nearest )
+						nearest = dist;
+				}
+
+				if( nearest < FLT_MAX )
+					++hits;
+			}
+		}
+
+		PrintRow( primitive, "single ray", timer.ElapsedMs(), hits );
+	}
+
+	//------------------------------------------------------------------------------------
+	// Packets of rays against one primitive at a time.
+	//------------------------------------------------------------------------------------
+	template<typename Packet, UINT Width, typename Test>
+	void RunRayPackets( const Scene& scene, const char* primitive, const char* method, Test test )
+	{
+		UINT rayCount = UINT( scene.origins.size() );
+
+		std::vector<Packet> packets( rayCount / Width );
+		for( UINT i = 0; i < packets.size(); ++i )
+			LoadRayPacket( &packets[i], Width, &scene.origins[i * Width], &scene.directions[i * Width] );
+
+		const UINT allLanes = ( 1u << Width ) - 1;
+		const XMVECTOR farthest = XMVectorReplicate( FLT_MAX );
+		UINT hits = 0;
+
+		BenchTimer timer;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			hits = 0;
+			for( UINT i = 0; i < packets.size(); ++i )
+			{
+				XMVECTOR nearest[2] = { farthest, farthest };
+				UINT hitLanes = 0;
+
+				for( UINT p = 0; p < kPrimitives; ++p )
+				{
+					XMVECTOR dist[2] = { farthest, farthest };
+					hitLanes |= test( &packets[i], allLanes, p, dist );
+					nearest[0] = XMVectorMin( nearest[0], dist[0] );
+					nearest[1] = XMVectorMin( nearest[1], dist[1] );
+				}
+
+				for( UINT lane = 0; lane < Width; ++lane )
+					hits += ( hitLanes >> lane ) & 1;
+			}
+		}
+
+		PrintRow( primitive, method, timer.ElapsedMs(), hits );
+	}
+
+	//------------------------------------------------------------------------------------
+	// One ray against packets of primitives.
+	//------------------------------------------------------------------------------------
+	template<typename Packet, UINT Width, typename Test>
+	void RunPrimitivePackets( const Scene& scene, const std::vector<Packet>& packets, const char* primitive,
+							  const char* method, Test test )
+	{
+		UINT rayCount = UINT( scene.origins.size() );
+		const UINT allLanes = ( 1u << Width ) - 1;
+		const XMVECTOR farthest = XMVectorReplicate( FLT_MAX );
+		UINT hits = 0;
+
+		BenchTimer timer;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			hits = 0;
+			for( UINT i = 0; i < rayCount; ++i )
+			{
+				XMVECTOR origin = XMLoadFloat3( &scene.origins[i] );
+				XMVECTOR direction = XMLoadFloat3( &scene.directions[i] );
+
+				XMVECTOR nearest = farthest;
+				UINT hitLanes = 0;
+
+				for( UINT p = 0; p < packets.size(); ++p )
+				{
+					XMVECTOR dist[2] = { farthest, farthest };
+					hitLanes |= test( origin, direction, &packets[p], allLanes, dist );
+					nearest = XMVectorMin( nearest, XMVectorMin( dist[0], dist[1] ) );
+				}
+
+				if( hitLanes )
+					++hits;
+			}
+		}
+
+		PrintRow( primitive, method, timer.ElapsedMs(), hits );
+	}
+
+	template<typename Packet, UINT Width, typename Source, typename Loader>
+	std::vector<Packet> BuildPrimitivePackets( const Source* source, UINT stride, Loader load )
+	{
+		std::vector<Packet> packets( kPrimitives / Width );
+		for( UINT i = 0; i < packets.size(); ++i )
+			load( &packets[i], Width, source + i * Width * stride );
+		return packets;
+	}
+}
+
+void RunRayPacketBenchmarks()
+{
+	Scene scene;
+	BuildScene( scene );
+
+	printf( "%u rays x %u primitives, %d repeats; throughput in ray/primitive tests per us\n",
+			kRayGrid * kRayGrid, kPrimitives, kRepeats );
+	printf( "%-10s %-28s %10s %12s %8s\n", "primitive", "method", "ms", "tests/us", "hits" );
+
+	// Spheres.
+	RunSingle( scene, "sphere", [&]( FXMVECTOR o, FXMVECTOR d, UINT p, float* t )
+	{
+		return IntersectRaySphere( o, d, &scene.spheres[p], t );
+	} );
+	RunRayPackets<RayPacket4, 4>( scene, "sphere", "4 rays vs 1", [&]( const RayPacket4* rays, UINT mask, UINT p, XMVECTOR* t )
+	{
+		return IntersectRayPacketSphere( rays, mask, &scene.spheres[p], t );
+	} );
+	RunRayPackets<RayPacket8, 8>( scene, "sphere", "8 rays vs 1", [&]( const RayPacket8* rays, UINT mask, UINT p, XMVECTOR* t )
+	{
+		return IntersectRayPacketSphere( rays, mask, &scene.spheres[p], t );
+	} );
+	{
+		std::vector<SpherePacket4> packets4 = BuildPrimitivePackets<SpherePacket4, 4>( &scene.spheres[0], 1,
+			[]( SpherePacket4* out, UINT n, const Sphere* in ) { LoadSpherePacket( out, n, in ); } );
+		std::vector<SpherePacket8> packets8 = BuildPrimitivePackets<SpherePacket8, 8>( &scene.spheres[0], 1,
+			[]( SpherePacket8* out, UINT n, const Sphere* in ) { LoadSpherePacket( out, n, in ); } );
+
+		RunPrimitivePackets<SpherePacket4, 4>( scene, packets4, "sphere", "1 ray vs 4",
+			[]( FXMVECTOR o, FXMVECTOR d, const SpherePacket4* p, UINT mask, XMVECTOR* t ) { return IntersectRaySpherePacket( o, d, p, mask, t ); } );
+		RunPrimitivePackets<SpherePacket8, 8>( scene, packets8, "sphere", "1 ray vs 8",
+			[]( FXMVECTOR o, FXMVECTOR d, const SpherePacket8* p, UINT mask, XMVECTOR* t ) { return IntersectRaySpherePacket( o, d, p, mask, t ); } );
+	}
+
+	// Axis aligned boxes.
+	RunSingle( scene, "box", [&]( FXMVECTOR o, FXMVECTOR d, UINT p, float* t )
+	{
+		return IntersectRayAxisAlignedBox( o, d, &scene.boxes[p], t );
+	} );
+	RunRayPackets<RayPacket4, 4>( scene, "box", "4 rays vs 1", [&]( const RayPacket4* rays, UINT mask, UINT p, XMVECTOR* t )
+	{
+		return IntersectRayPacketAxisAlignedBox( rays, mask, &scene.boxes[p], t );
+	} );
+	RunRayPackets<RayPacket8, 8>( scene, "box", "8 rays vs 1", [&]( const RayPacket8* rays, UINT mask, UINT p, XMVECTOR* t )
+	{
+		return IntersectRayPacketAxisAlignedBox( rays, mask, &scene.boxes[p], t );
+	} );
+	{
+		std::vector<AxisAlignedBoxPacket4> packets4 = BuildPrimitivePackets<AxisAlignedBoxPacket4, 4>( &scene.boxes[0], 1,
+			[]( AxisAlignedBoxPacket4* out, UINT n, const AxisAlignedBox* in ) { LoadAxisAlignedBoxPacket( out, n, in ); } );
+		std::vector<AxisAlignedBoxPacket8> packets8 = BuildPrimitivePackets<AxisAlignedBoxPacket8, 8>( &scene.boxes[0], 1,
+			[]( AxisAlignedBoxPacket8* out, UINT n, const AxisAlignedBox* in ) { LoadAxisAlignedBoxPacket( out, n, in ); } );
+
+		RunPrimitivePackets<AxisAlignedBoxPacket4, 4>( scene, packets4, "box", "1 ray vs 4",
+			[]( FXMVECTOR o, FXMVECTOR d, const AxisAlignedBoxPacket4* p, UINT mask, XMVECTOR* t ) { return IntersectRayAxisAlignedBoxPacket( o, d, p, mask, t ); } );
+		RunPrimitivePackets<AxisAlignedBoxPacket8, 8>( scene, packets8, "box", "1 ray vs 8",
+			[]( FXMVECTOR o, FXMVECTOR d, const AxisAlignedBoxPacket8* p, UINT mask, XMVECTOR* t ) { return IntersectRayAxisAlignedBoxPacket( o, d, p, mask, t ); } );
+	}
+
+	// Triangles.
+	RunSingle( scene, "triangle", [&]( FXMVECTOR o, FXMVECTOR d, UINT p, float* t )
+	{
+		const XMFLOAT3* v = &scene.triangles[p * 3];
+		return IntersectRayTriangle( o, d, XMLoadFloat3( &v[0] ), XMLoadFloat3( &v[1] ), XMLoadFloat3( &v[2] ), t );
+	} );
+	RunRayPackets<RayPacket4, 4>( scene, "triangle", "4 rays vs 1", [&]( const RayPacket4* rays, UINT mask, UINT p, XMVECTOR* t )
+	{
+		const XMFLOAT3* v = &scene.triangles[p * 3];
+		return IntersectRayPacketTriangle( rays, mask, XMLoadFloat3( &v[0] ), XMLoadFloat3( &v[1] ), XMLoadFloat3( &v[2] ), t );
+	} );
+	RunRayPackets<RayPacket8, 8>( scene, "triangle", "8 rays vs 1", [&]( const RayPacket8* rays, UINT mask, UINT p, XMVECTOR* t )
+	{
+		const XMFLOAT3* v = &scene.triangles[p * 3];
+		return IntersectRayPacketTriangle( rays, mask, XMLoadFloat3( &v[0] ), XMLoadFloat3( &v[1] ), XMLoadFloat3( &v[2] ), t );
+	} );
+	{
+		std::vector<TrianglePacket4> packets4 = BuildPrimitivePackets<TrianglePacket4, 4>( &scene.triangles[0], 3,
+			[]( TrianglePacket4* out, UINT n, const XMFLOAT3* in ) { LoadTrianglePacket( out, n, in ); } );
+		std::vector<TrianglePacket8> packets8 = BuildPrimitivePackets<TrianglePacket8, 8>( &scene.triangles[0], 3,
+			[]( TrianglePacket8* out, UINT n, const XMFLOAT3* in ) { LoadTrianglePacket( out, n, in ); } );
+
+		RunPrimitivePackets<TrianglePacket4, 4>( scene, packets4, "triangle", "1 ray vs 4",
+			[]( FXMVECTOR o, FXMVECTOR d, const TrianglePacket4* p, UINT mask, XMVECTOR* t ) { return IntersectRayTrianglePacket( o, d, p, mask, t ); } );
+		RunPrimitivePackets<TrianglePacket8, 8>( scene, packets8, "triangle", "1 ray vs 8",
+			[]( FXMVECTOR o, FXMVECTOR d, const TrianglePacket8* p, UINT mask, XMVECTOR* t ) { return IntersectRayTrianglePacket( o, d, p, mask, t ); } );
+	}
+}
@@ -0,0 +1,354 @@
+﻿//***************************************************************************************
+// SceneBench.cpp
+//
+// ImportScene on a scene of many meshes: a generated OBJ of kParts tori of
+// growing size, each its own object and material, so Assimp reads one aiMesh
+// per torus. The scene is read once; the times are for the conversion of all
+// the meshes into the merged vertex and index arrays, on one thread and on
+// every hardware thread, against converting only mMeshes[0] as the demos did.
+// The merged result must be the same whatever the thread count.
+//
+// Then the whole ImportSceneFromFile for every post-processing profile, with
+// the time of each stage, against what the profile gives the GPU: vertex
+// count and ACMR (vertices transformed per triangle with a FIFO post-transform
+// cache of kCacheSize entries; 3 is no reuse at all).
+//
+// Last, suzanne.obj and its MTL read through Assimp's default stdio IOSystem
+// against MappedIOSystem: a new one per import (the first import of a file,
+// mapped once however often Assimp opens it), one kept across imports
+// (mappings reused), and with both files mounted from memory (an archive).
+//
+// Needs Assimp (BENCH_WITH_ASSIMP); without it the suite only says so.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "xnacollision.h"
+#include "Benchmark.h"
+
+#if defined( BENCH_WITH_ASSIMP )
+
+#include "ImportedMesh.h"
+#include "SceneImporter.h"
+#include "MappedIOSystem.h"
+#include "ParallelFor.h"
+#include "Importer.hpp"
+#include "scene.h"
+#include "postprocess.h"
+
+using namespace XNA;
+
+namespace
+{
+	const int kRepeats = 5;
+
+	// Torus i has (kBaseRings + kRingStep * i) x kSides quads.
+	const UINT kParts = 48;
+	const UINT kBaseRings = 40;
+	const UINT kRingStep = 12;
+	const UINT kSides = 64;
+	const char* const kSceneFile = "SceneBenchParts.obj";
+
+	const UINT kCacheSize = 32;
+
+	const int kSmallRepeats = 50;
+
+	struct ProfileCase
+	{
+		const char* name;
+		SceneImportProfile profile;
+	};
+
+	const ProfileCase kProfiles[] =
+	{
+		{ "minimal", SceneImportMinimal },
+		{ "fast", SceneImportFast },
+		{ "quality", SceneImportQuality },
+	};
+
+	bool WriteParts( const char* path )
+	{
+		FILE* file = fopen( path, "wb" );
+		if( !file )
+			return false;
+
+		const float R = 3.0f, r = 1.0f;
+		UINT base = 1;
+		for( UINT part = 0; part < kParts; ++part )
+		{
+			UINT rings = kBaseRings + kRingStep * part;
+			fprintf( file, "o part%u\nusemtl part%u\n", part, part );
+
+			for( UINT i = 0; i < rings; ++i )
+			{
+				float u = XM_2PI * i / rings;
+				for( UINT j = 0; j < kSides; ++j )
+				{
+					float v = XM_2PI * j / kSides;
+					float nx = cosf( u ) * cosf( v ), ny = sinf( u ) * cosf( v ), nz = sinf( v );
+					fprintf( file, "v %.5f %.5f %.5f\nvn %.5f %.5f %.5f\n", R * cosf( u ) + r * nx + 10.0f * part,
+							 R * sinf( u ) + r * ny, r * nz, nx, ny, nz );
+				}
+			}
+
+			for( UINT i = 0; i < rings; ++i )
+			{
+				for( UINT j = 0; j < kSides; ++j )
+				{
+					UINT p[4] = { i * kSides + j, ( ( i + 1 ) % rings ) * kSides + j,
+								  ( ( i + 1 ) % rings ) * kSides + ( j + 1 ) % kSides, i * kSides + ( j + 1 ) % kSides };
+					fprintf( file, "f %u//%u %u//%u %u//%u %u//%u\n", base + p[0], base + p[0], base + p[1], base + p[1],
+							 base + p[2], base + p[2], base + p[3], base + p[3] );
+				}
+			}
+			base += rings * kSides;
+		}
+
+		return fclose( file ) == 0;
+	}
+
+	// What ImportMeshFromFile did before: the first mesh only.
+	void ConvertFirstMesh( const aiScene* scene, ImportedMesh* out )
+	{
+		const aiMesh* mesh = scene->mMeshes[0];
+		out->Vertices.resize( mesh->mNumVertices );
+		for( UINT i = 0; i < mesh->mNumVertices; ++i )
+		{
+			out->Vertices[i].Position = XMFLOAT3( mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z );
+			out->Vertices[i].Normal = XMFLOAT3( mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z );
+			out->Vertices[i].TexCoord = XMFLOAT2( 0.0f, 0.0f );
+		}
+
+		out->Indices.resize( mesh->mNumFaces * 3 );
+		for( UINT i = 0; i < mesh->mNumFaces; ++i )
+		{
+			out->Indices[i * 3 + 0] = mesh->mFaces[i].mIndices[0];
+			out->Indices[i * 3 + 1] = mesh->mFaces[i].mIndices[1];
+			out->Indices[i * 3 + 2] = mesh->mFaces[i].mIndices[2];
+		}
+	}
+
+	bool SameMesh( const ImportedMesh& a, const ImportedMesh& b )
+	{
+		if( a.Vertices.size() != b.Vertices.size() || a.Indices != b.Indices || a.Subsets.size() != b.Subsets.size() )
+			return false;
+
+		for( size_t i = 0; i < a.Subsets.size(); ++i )
+		{
+			if( memcmp( &a.Subsets[i], &b.Subsets[i], sizeof( ImportedSubset ) ) != 0 )
+				return false;
+		}
+
+		return a.Vertices.empty() ||
+			   memcmp( &a.Vertices[0], &b.Vertices[0], a.Vertices.size() * sizeof( ImportedVertex ) ) == 0;
+	}
+
+	double ComputeAcmr( const ImportedMesh& mesh )
+	{
+		// FIFO: a vertex is in the cache while fewer than kCacheSize misses came after its own.
+		std::vector<UINT> inserted( mesh.Vertices.size(), 0 );
+		UINT misses = 0;
+		for( size_t s = 0; s < mesh.Subsets.size(); ++s )
+		{
+			const ImportedSubset& subset = mesh.Subsets[s];
+			for( UINT i = 0; i < subset.IndexCount; ++i )
+			{
+				UINT v = subset.BaseVertex + mesh.Indices[subset.FirstIndex + i];
+				if( inserted[v] == 0 || misses - inserted[v] >= kCacheSize )
+					inserted[v] = ++misses;
+			}
+		}
+		return mesh.Indices.empty() ? 0.0 : misses * 3.0 / mesh.Indices.size();
+	}
+
+	void RunProfiles()
+	{
+		printf( "\nImportSceneFromFile per profile, one run each\n" );
+		printf( "%-10s %10s %10s %8s %10s\n", "profile", "vertices", "triangles", "ACMR", "total ms" );
+
+		char record[64];
+		for( size_t p = 0; p < BenchCountOf( kProfiles ); ++p )
+		{
+			ImportedMesh mesh;
+			SceneImportTimings timings;
+			if( !ImportSceneFromFile( kSceneFile, GetScenePostProcessFlags( kProfiles[p].profile ), &mesh, 0, &timings ) )
+			{
+				printf( "%-10s import failed\n", kProfiles[p].name );
+				continue;
+			}
+
+			double acmr = ComputeAcmr( mesh );
+			printf( "%-10s %10u %10u %8.3f %10.1f\n", kProfiles[p].name, UINT( mesh.Vertices.size() ),
+					UINT( mesh.Indices.size() / 3 ), acmr, timings.TotalMilliseconds );
+			for( size_t i = 0; i < timings.Stages.size(); ++i )
+				printf( "    %-26s %10.2f ms\n", timings.Stages[i].Name, timings.Stages[i].Milliseconds );
+
+			snprintf( record, sizeof( record ), "scene %s import", kProfiles[p].name );
+			BenchRecord( record, timings.TotalMilliseconds, "ms" );
+			snprintf( record, sizeof( record ), "scene %s vertices", kProfiles[p].name );
+			BenchRecord( record, double( mesh.Vertices.size() ), "count" );
+			snprintf( record, sizeof( record ), "scene %s acmr", kProfiles[p].name );
+			BenchRecord( record, acmr, "ratio" );
+		}
+	}
+
+	template<typename Convert>
+	double Time( Convert convert, int repeats = kRepeats )
+	{
+		double best = 0.0;
+		for( int r = 0; r < repeats; ++r )
+		{
+			BenchTimer timer;
+			convert();
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+
+	bool ReadWholeFile( const char* path, std::vector<char>* out )
+	{
+		FILE* file = fopen( path, "rb" );
+		if( !file )
+			return false;
+		fseek( file, 0, SEEK_END );
+		long size = ftell( file );
+		fseek( file, 0, SEEK_SET );
+		out->resize( size > 0 ? size : 0 );
+		bool ok = size >= 0 && ( size == 0 || fread( &( *out )[0], 1, size, file ) == size_t( size ) );
+		fclose( file );
+		return ok;
+	}
+
+	void RunIOSystems()
+	{
+		const char* obj = FindBenchMeshFile();
+		if( !obj )
+		{
+			printf( "\nsuzanne.obj not found, IOSystem comparison skipped\n" );
+			return;
+		}
+
+		std::string mtl( obj );
+		mtl.replace( mtl.size() - 4, 4, ".mtl" );
+		std::vector<char> objData, mtlData;
+		ReadWholeFile( obj, &objData );
+		ReadWholeFile( mtl.c_str(), &mtlData );
+
+		UINT flags = GetScenePostProcessFlags( SceneImportMinimal );
+		ImportedMesh reference, mesh;
+		bool ok = ImportSceneFromFile( obj, flags, &reference, 1 ) != FALSE;
+
+		MappedIOSystem shared, mounted;
+		mounted.Mount( obj, objData.empty() ? NULL : &objData[0], objData.size() );
+		mounted.Mount( mtl.c_str(), mtlData.empty() ? NULL : &mtlData[0], mtlData.size() );
+
+		// files NULL with perImport false is Assimp's own IOSystem.
+		struct IOCase
+		{
+			const char* name;
+			MappedIOSystem* files;
+			bool perImport;
+		};
+		const IOCase cases[] =
+		{
+			{ "stdio (default)", NULL, false },
+			{ "mapped, per import", NULL, true },
+			{ "mapped, kept", &shared, false },
+			{ "mounted in memory", &mounted, false },
+		};
+
+		printf( "\n%s and its MTL, SceneImportMinimal, 1 thread, best of %d runs\n", obj, kSmallRepeats );
+		printf( "%-20s %10s %8s\n", "IOSystem", "ms", "speedup" );
+		double stdioMs = 0.0;
+		char record[64];
+		for( size_t c = 0; c < BenchCountOf( cases ); ++c )
+		{
+			bool same = true;
+			double ms = Time( [&]()
+			{
+				MappedIOSystem perImport;
+				MappedIOSystem* files = cases[c].perImport ? &perImport : cases[c].files;
+				same = ImportSceneFromFile( obj, flags, &mesh, 1, NULL, files ) && same && SameMesh( reference, mesh );
+			}, kSmallRepeats );
+			if( c == 0 )
+				stdioMs = ms;
+
+			printf( "%-20s %10.3f %7.2fx  %s\n", cases[c].name, ms, stdioMs / ms,
+					!ok ? "import failed" : same ? "same" : "DIFFERENT" );
+			snprintf( record, sizeof( record ), "scene io %s", cases[c].name );
+			BenchRecord( record, ms, "ms" );
+		}
+		printf( "%u files mapped by the kept IOSystem\n", shared.GetMappedFileCount() );
+	}
+
+}
+
+void RunSceneBenchmarks()
+{
+	if( !WriteParts( kSceneFile ) )
+	{
+		printf( "cannot write %s\n", kSceneFile );
+		remove( kSceneFile );
+		return;
+	}
+
+	Assimp::Importer importer;
+	BenchTimer readTimer;
+	const aiScene* scene = importer.ReadFile( kSceneFile, aiProcess_Triangulate );
+	double readMs = readTimer.ElapsedMs();
+
+	if( !scene || scene->mNumMeshes == 0 )
+	{
+		printf( "Assimp could not read %s\n", kSceneFile );
+		remove( kSceneFile );
+		return;
+	}
+
+	UINT threads = GetWorkerThreadCount();
+	ImportedMesh first, one, all;
+	bool ok = ImportScene( scene, &one, 1 ) && ImportScene( scene, &all, threads );
+	bool same = ok && SameMesh( one, all );
+
+	double firstMs = Time( [&]() { ConvertFirstMesh( scene, &first ); } );
+	double oneMs = Time( [&]() { ImportScene( scene, &one, 1 ); } );
+	double allMs = Time( [&]() { ImportScene( scene, &all, threads ); } );
+
+	double megabytes = ( all.Vertices.size() * sizeof( ImportedVertex ) + all.Indices.size() * sizeof( UINT ) ) /
+					   ( 1024.0 * 1024.0 );
+
+	printf( "%u meshes, %u vertices, %u triangles, %.1f MB merged; Assimp read %.0f ms; best of %d runs\n",
+			scene->mNumMeshes, UINT( all.Vertices.size() ), UINT( all.Indices.size() / 3 ), megabytes, readMs, kRepeats );
+	printf( "%-22s %10s %10s %8s\n", "conversion", "ms", "vertices", "MB/s" );
+	printf( "%-22s %10.3f %10u %8s\n", "mMeshes[0] only", firstMs, UINT( first.Vertices.size() ), "" );
+	printf( "%-22s %10.3f %10u %8.0f\n", "all, 1 thread", oneMs, UINT( one.Vertices.size() ), megabytes * 1000.0 / oneMs );
+	printf( "%-12s%2u threads %10.3f %10u %8.0f  %s\n", "all,", threads, allMs, UINT( all.Vertices.size() ),
+			megabytes * 1000.0 / allMs, !ok ? "import failed" : same ? "same" : "DIFFERENT" );
+
+	char record[64];
+	BenchRecord( "scene first mesh", firstMs, "ms" );
+	BenchRecord( "scene all 1 thread", oneMs, "ms" );
+	snprintf( record, sizeof( record ), "scene all %u threads", threads );
+	BenchRecord( record, allMs, "ms" );
+
+	RunProfiles();
+	remove( kSceneFile );
+
+	RunIOSystems();
+}
+
+#else
+
+void RunSceneBenchmarks()
+{
+	printf( "built without Assimp (BENCH_WITH_ASSIMP), nothing to measure\n" );
+}
+
+#endif
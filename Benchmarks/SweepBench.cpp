@@ -0,0 +1,269 @@
+﻿//***************************************************************************************
+// SweepBench.cpp
+//
+// Sphere movers sliding over level geometry: suzanne scaled up to 40 units across,
+// with every mover heading for a random point inside it each frame and sliding
+// along the surface with CollisionMesh::MoveSpheres. The BVH sweeps are checked
+// against IntersectSweptSphereTriangle over all triangles for a sample of the
+// movers, whose time also gives the brute force estimate, and at the end no
+// mover may overlap the mesh.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "xnacollision.h"
+#include "CollisionMesh.h"
+#include "ParallelFor.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const int kFrames = 60;
+	const float kMeshScale = 15.0f;
+	const float kMoverRadius = 0.5f;
+	const float kMaxSpeed = 0.3f;				// Units per frame.
+
+	// Movers checked against brute force, every kSampleInterval frames.
+	const UINT kSampledMovers = 16;
+	const int kSampleInterval = 6;
+
+	// Positions and faces of an OBJ file, polygons split into fans.
+	bool LoadObj( const char* path, float scale, std::vector<XMFLOAT3>& positions, std::vector<UINT>& indices )
+	{
+		FILE* file = fopen( path, "r" );
+		if( !file )
+			return false;
+
+		positions.clear();
+		indices.clear();
+
+		char line[512];
+		while( fgets( line, sizeof( line ), file ) )
+		{
+			if( line[0] == 'v' && line[1] == ' ' )
+			{
+				XMFLOAT3 p;
+				if( sscanf( line + 2, "%f %f %f", &p.x, &p.y, &p.z ) == 3 )
+					positions.push_back( XMFLOAT3( p.x * scale, p.y * scale, p.z * scale ) );
+			}
+			else if( line[0] == 'f' && line[1] == ' ' )
+			{
+				UINT face[16];
+				UINT count = 0;
+				for( char* token = strtok( line + 2, " \t\r\n" ); token && count < 16; token = strtok( NULL, " \t\r\n" ) )
+					face[count++] = UINT( atoi( token ) - 1 );
+
+				for( UINT i = 2; i < count; ++i )
+				{
+					indices.push_back( face[0] );
+					indices.push_back( face[i - 1] );
+					indices.push_back( face[i] );
+				}
+			}
+		}
+
+		fclose( file );
+		return !indices.empty();
+	}
+
+	struct Movers
+	{
+		std::vector<Sphere> spheres;
+		std::vector<XMFLOAT3> targets;
+		std::vector<XMFLOAT3> moves;
+	};
+
+	XMFLOAT3 RandomTarget( float shellRadius, BenchRandom& rng )
+	{
+		float r = 0.6f * shellRadius;
+		return XMFLOAT3( rng.Range( -r, r ), rng.Range( -r, r ), rng.Range( -r, r ) );
+	}
+
+	// Movers start on a shell around the mesh, all outside of it.
+	void SpawnMovers( Movers& movers, UINT count, float shellRadius, BenchRandom& rng )
+	{
+		movers.spheres.resize( count );
+		movers.targets.resize( count );
+		movers.moves.resize( count );
+
+		for( UINT i = 0; i < count; ++i )
+		{
+			XMVECTOR direction = XMVector3Normalize( XMVectorSet( rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ),
+																  rng.Range( -1.0f, 1.0f ), 0.0f ) );
+			XMStoreFloat3( &movers.spheres[i].Center, direction * shellRadius );
+			movers.spheres[i].Radius = kMoverRadius;
+			movers.targets[i] = RandomTarget( shellRadius, rng );
+		}
+	}
+
+	// Every mover walks towards its target, a random point within the shell
+	// that is replaced now and then.
+	void StepMovers( Movers& movers, float shellRadius, BenchRandom& rng )
+	{
+		for( size_t i = 0; i < movers.spheres.size(); ++i )
+		{
+			if( ( rng.Next() & 31 ) == 0 )
+				movers.targets[i] = RandomTarget( shellRadius, rng );
+
+			XMVECTOR toTarget = XMLoadFloat3( &movers.targets[i] ) - XMLoadFloat3( &movers.spheres[i].Center );
+			float distance = XMVectorGetX( XMVector3Length( toTarget ) );
+			XMVECTOR move = distance > kMaxSpeed ? toTarget * ( kMaxSpeed / distance ) : toTarget;
+			XMStoreFloat3( &movers.moves[i], move );
+		}
+	}
+
+	bool BruteForceSweep( const std::vector<XMFLOAT3>& positions, const std::vector<UINT>& indices, const Sphere& sphere,
+						  FXMVECTOR move, float* pTime )
+	{
+		bool hit = false;
+		for( size_t t = 0; t < indices.size(); t += 3 )
+		{
+			float time;
+			XMVECTOR normal;
+			if( IntersectSweptSphereTriangle( &sphere, move, XMLoadFloat3( &positions[indices[t]] ),
+											  XMLoadFloat3( &positions[indices[t + 1]] ),
+											  XMLoadFloat3( &positions[indices[t + 2]] ), &time, &normal ) &&
+				( !hit || time < *pTime ) )
+			{
+				*pTime = time;
+				hit = true;
+			}
+		}
+		return hit;
+	}
+
+	void RunMovers( const CollisionMesh& mesh, const std::vector<XMFLOAT3>& positions, const std::vector<UINT>& indices,
+					float shellRadius, UINT count, UINT threads )
+	{
+		BenchRandom rng( count );
+		Movers movers;
+		SpawnMovers( movers, count, shellRadius, rng );
+
+		UINT stride = count / kSampledMovers > 0 ? count / kSampledMovers : 1;
+
+		double moveMs = 0.0, bruteMs = 0.0;
+		UINT samples = 0, mismatches = 0, hits = 0;
+		int sampledFrames = 0;
+
+		for( int frame = 0; frame < kFrames; ++frame )
+		{
+			StepMovers( movers, shellRadius, rng );
+
+			BenchTimer timer;
+			if( frame % kSampleInterval != 0 )
+			{
+				mesh.MoveSpheres( &movers.spheres[0], &movers.moves[0], count, threads );
+				moveMs += timer.ElapsedMs();
+				continue;
+			}
+
+			// Sample sweeps against every triangle, before the movers move.
+			std::vector<float> bruteTimes;
+			std::vector<bool> bruteHits;
+			for( UINT i = 0; i < count; i += stride )
+			{
+				float time = 0.0f;
+				bruteHits.push_back( BruteForceSweep( positions, indices, movers.spheres[i],
+													  XMLoadFloat3( &movers.moves[i] ), &time ) );
+				bruteTimes.push_back( time );
+			}
+			bruteMs += timer.ElapsedMs() * count / bruteTimes.size();
+			sampledFrames++;
+
+			for( UINT i = 0, s = 0; i < count; i += stride, ++s )
+			{
+				SweepHit hit;
+				bool bvhHit = mesh.SweepSphere( &movers.spheres[i], XMLoadFloat3( &movers.moves[i] ), &hit ) != FALSE;
+				if( bvhHit != bruteHits[s] || ( bvhHit && fabsf( hit.Time - bruteTimes[s] ) > 1e-6f ) )
+					mismatches++;
+				hits += bvhHit ? 1 : 0;
+				samples++;
+			}
+
+			timer.Reset();
+			mesh.MoveSpheres( &movers.spheres[0], &movers.moves[0], count, threads );
+			moveMs += timer.ElapsedMs();
+		}
+
+		// Nobody got into the mesh: no sampled mover overlaps a triangle, within
+		// the rounding of the sweeps.
+		UINT penetrating = 0;
+		for( UINT i = 0; i < count; i += stride )
+		{
+			Sphere shrunk = movers.spheres[i];
+			shrunk.Radius *= 0.99f;
+			for( size_t t = 0; t < indices.size(); t += 3 )
+			{
+				if( IntersectTriangleSphere( XMLoadFloat3( &positions[indices[t]] ), XMLoadFloat3( &positions[indices[t + 1]] ),
+											 XMLoadFloat3( &positions[indices[t + 2]] ), &shrunk ) )
+				{
+					penetrating++;
+					break;
+				}
+			}
+		}
+
+		moveMs /= kFrames;
+		bruteMs /= sampledFrames;
+
+		char method[32];
+		snprintf( method, sizeof( method ), "move (%s)", threads == 1 ? "1T" : "MT" );
+		printf( "%-16s %7u %10.3f %12.3f %9.1f%%  %u of %u sweeps differ, %u movers inside\n", method, count, moveMs,
+				bruteMs, 100.0 * hits / samples, mismatches, samples, penetrating );
+
+		char name[64];
+		snprintf( name, sizeof( name ), "%s %u", method, count );
+		BenchRecord( name, moveMs, "ms" );
+		if( threads == 1 )
+		{
+			snprintf( name, sizeof( name ), "brute force sweep %u", count );
+			BenchRecord( name, bruteMs, "ms" );
+		}
+	}
+}
+
+void RunSweepBenchmarks()
+{
+	std::vector<XMFLOAT3> positions;
+	std::vector<UINT> indices;
+
+	const char* path = FindBenchMeshFile();
+	if( !path || !LoadObj( path, kMeshScale, positions, indices ) )
+	{
+		printf( "suzanne.obj not found, run from the repository root\n" );
+		return;
+	}
+
+	UINT triangleCount = UINT( indices.size() / 3 );
+
+	CollisionMesh mesh;
+	BenchTimer timer;
+	mesh.Build( &positions[0], sizeof( XMFLOAT3 ), &indices[0], triangleCount );
+	double buildMs = timer.ElapsedMs();
+
+	Sphere bounds;
+	ComputeBoundingSphereFromPoints( &bounds, UINT( positions.size() ), &positions[0], sizeof( XMFLOAT3 ) );
+	float shellRadius = bounds.Radius + 2.0f * kMoverRadius;
+
+	printf( "%s x%.0f: %u triangles, %u nodes, built in %.3f ms\n", path, kMeshScale, triangleCount, mesh.GetNodeCount(),
+			buildMs );
+	printf( "%d frames, movers of radius %.1f at up to %.1f units per frame, %u hardware threads\n", kFrames,
+			kMoverRadius, kMaxSpeed, GetWorkerThreadCount() );
+	printf( "%-16s %7s %10s %12s %10s\n", "method", "movers", "ms/frame", "brute force", "hit" );
+
+	BenchRecord( "build", buildMs, "ms" );
+
+	static const UINT counts[] = { 100, 500, 2000 };
+	for( size_t c = 0; c < BenchCountOf( counts ); ++c )
+	{
+		RunMovers( mesh, positions, indices, shellRadius, counts[c], 1 );
+		RunMovers( mesh, positions, indices, shellRadius, counts[c], 0 );
+	}
+}
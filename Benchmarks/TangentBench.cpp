@@ -0,0 +1,223 @@
+﻿//***************************************************************************************
+// TangentBench.cpp
+//
+// MikkTSpace style tangents of an indexed torus of kSegments x kRings quads
+// with analytic normals, where the exact tangent is the direction of the
+// segments. Every thread count must give the same bits.
+//
+// The same torus with its texture mirrored halfway round shows the vertices
+// split for both orientations, and a vertex struct laid out as
+// GeometryGenerator::Vertex goes through GenerateMeshDataTangents.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "xnacollision.h"
+#include "MeshTangents.h"
+#include "ParallelFor.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const UINT kSegments = 1024;
+	const UINT kRings = 512;
+	const float kMajorRadius = 3.0f;
+	const float kMinorRadius = 1.0f;
+	const int kRepeats = 3;
+
+	// Same layout as GeometryGenerator::Vertex and MeshData.
+	struct GeneratorVertex
+	{
+		XMFLOAT3 Position;
+		XMFLOAT3 Normal;
+		XMFLOAT3 TangentU;
+		XMFLOAT2 TexC;
+	};
+
+	struct GeneratorMesh
+	{
+		std::vector<GeneratorVertex> Vertices;
+		std::vector<UINT> Indices;
+	};
+
+	// mirrored: u runs from 1 to 0 over the first half and back to 1.
+	ImportedVertex TorusVertex( UINT segment, UINT ring, bool mirrored )
+	{
+		float u = float( segment ) / kSegments;
+		float v = float( ring ) / kRings;
+		float theta = u * XM_2PI;
+		float phi = v * XM_2PI;
+
+		ImportedVertex vertex;
+		float r = kMajorRadius + kMinorRadius * cosf( phi );
+		vertex.Position = XMFLOAT3( r * cosf( theta ), kMinorRadius * sinf( phi ), r * sinf( theta ) );
+		vertex.Normal = XMFLOAT3( cosf( phi ) * cosf( theta ), sinf( phi ), cosf( phi ) * sinf( theta ) );
+		vertex.TexCoord = XMFLOAT2( mirrored ? fabsf( 2.0f * u - 1.0f ) : u, v );
+		return vertex;
+	}
+
+	void BuildTorus( ImportedMesh* mesh, bool mirrored )
+	{
+		mesh->Clear();
+		mesh->Vertices.reserve( ( kSegments + 1 ) * ( kRings + 1 ) );
+		for( UINT s = 0; s <= kSegments; ++s )
+		{
+			for( UINT r = 0; r <= kRings; ++r )
+				mesh->Vertices.push_back( TorusVertex( s, r, mirrored ) );
+		}
+
+		mesh->Indices.reserve( kSegments * kRings * 6 );
+		for( UINT s = 0; s < kSegments; ++s )
+		{
+			for( UINT r = 0; r < kRings; ++r )
+			{
+				UINT v00 = s * ( kRings + 1 ) + r, v01 = v00 + 1;
+				UINT v10 = v00 + kRings + 1, v11 = v10 + 1;
+				UINT quad[6] = { v00, v01, v11, v00, v11, v10 };
+				mesh->Indices.insert( mesh->Indices.end(), quad, quad + 6 );
+			}
+		}
+
+		ImportedMaterial material;
+		InitializeImportedMaterial( &material, "default" );
+		mesh->Materials.assign( 1, material );
+
+		ImportedSubset subset;
+		subset.Material = 0;
+		subset.FirstIndex = 0;
+		subset.IndexCount = UINT( mesh->Indices.size() );
+		subset.BaseVertex = 0;
+		mesh->Subsets.assign( 1, subset );
+		ComputeImportedSubsetBounds( mesh );
+		mesh->HasNormals = TRUE;
+		mesh->HasTexCoords = TRUE;
+	}
+
+	void ToGeneratorMesh( const ImportedMesh& mesh, GeneratorMesh* out )
+	{
+		out->Vertices.resize( mesh.Vertices.size() );
+		for( size_t i = 0; i < mesh.Vertices.size(); ++i )
+		{
+			out->Vertices[i].Position = mesh.Vertices[i].Position;
+			out->Vertices[i].Normal = mesh.Vertices[i].Normal;
+			out->Vertices[i].TangentU = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+			out->Vertices[i].TexC = mesh.Vertices[i].TexCoord;
+		}
+		out->Indices = mesh.Indices;
+	}
+
+	bool SameTangents( const ImportedMesh& a, const ImportedMesh& b )
+	{
+		return a.Tangents.size() == b.Tangents.size() && a.Indices == b.Indices &&
+			a.Vertices.size() == b.Vertices.size() &&
+			( a.Tangents.empty() || memcmp( &a.Tangents[0], &b.Tangents[0], a.Tangents.size() * sizeof( XMFLOAT4 ) ) == 0 );
+	}
+
+	// Largest angle in degrees between a tangent and the direction of the
+	// segments, which is the direction of u (either way round if mirrored),
+	// and the number of signs that are not +1 or -1.
+	double MaxTangentError( const ImportedMesh& mesh, bool mirrored, UINT* wrongSigns )
+	{
+		double worst = 0.0;
+		*wrongSigns = 0;
+		for( size_t i = 0; i < mesh.Vertices.size(); ++i )
+		{
+			const XMFLOAT3& p = mesh.Vertices[i].Position;
+			const XMFLOAT4& t = mesh.Tangents[i];
+			double length = sqrt( double( p.x ) * p.x + double( p.z ) * p.z );
+			double dot = ( -p.z * t.x + p.x * t.z ) / length;
+			dot = mirrored ? fabs( dot ) : dot;
+			dot = dot > 1.0 ? 1.0 : ( dot < -1.0 ? -1.0 : dot );
+			double degrees = acos( dot ) * 180.0 / 3.14159265358979;
+			worst = degrees > worst ? degrees : worst;
+			if( t.w != 1.0f && t.w != -1.0f )
+				++*wrongSigns;
+		}
+		return worst;
+	}
+
+	// Best of kRepeats of Step on a fresh copy of source; the last result in *out.
+	template <class Mesh, class Step>
+	double TimeStep( const Mesh& source, Mesh* out, Step step )
+	{
+		double best = 0.0;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			*out = source;
+			BenchTimer timer;
+			step( out );
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+}
+
+void RunTangentBenchmarks()
+{
+	UINT threads = GetWorkerThreadCount();
+	ImportedMesh torus;
+	BuildTorus( &torus, false );
+	UINT vertexCount = UINT( torus.Vertices.size() );
+
+	printf( "torus of %u triangles, %u vertices\n", UINT( torus.Indices.size() / 3 ), vertexCount );
+	printf( "%-26s %10s %10s %12s  %s\n", "step", "ms", "ns/vert", "vertices", "check" );
+
+	ImportedMesh one;
+	double oneMs = TimeStep( torus, &one, []( ImportedMesh* mesh ) { GenerateImportedTangents( mesh, 1 ); } );
+	UINT wrongSigns = 0;
+	double error = MaxTangentError( one, false, &wrongSigns );
+	printf( "%-23s%2u %10.2f %10.2f %12u  max error %.3f deg, %u bad signs\n", "tangents, threads", 1u, oneMs,
+		oneMs * 1e6 / vertexCount, UINT( one.Vertices.size() ), error, wrongSigns );
+
+	UINT threadCounts[] = { 2, 3, threads };
+	double allMs = oneMs;
+	for( int c = 0; c < 3; ++c )
+	{
+		ImportedMesh other;
+		double ms = TimeStep( torus, &other, [&]( ImportedMesh* mesh ) { GenerateImportedTangents( mesh, threadCounts[c] ); } );
+		if( c == 2 )
+			allMs = ms;
+		printf( "%-23s%2u %10.2f %10.2f %12u  %s\n", "tangents, threads", threadCounts[c], ms, ms * 1e6 / vertexCount,
+			UINT( other.Vertices.size() ), SameTangents( one, other ) ? "same" : "DIFFERENT" );
+	}
+
+	// Mirrored texture: the column at the mirror line is split.
+	ImportedMesh mirrored;
+	BuildTorus( &mirrored, true );
+	ImportedMesh mirroredOne, mirroredAll;
+	double mirroredMs = TimeStep( mirrored, &mirroredOne, []( ImportedMesh* mesh ) { GenerateImportedTangents( mesh, 1 ); } );
+	TimeStep( mirrored, &mirroredAll, [&]( ImportedMesh* mesh ) { GenerateImportedTangents( mesh, threads ); } );
+	UINT split = UINT( mirroredOne.Vertices.size() ) - vertexCount;
+	double mirroredError = MaxTangentError( mirroredOne, true, &wrongSigns );
+	printf( "%-23s%2u %10.2f %10.2f %12u  %u split (%s), max error %.3f deg, %s\n", "mirrored, threads", 1u, mirroredMs,
+		mirroredMs * 1e6 / vertexCount, UINT( mirroredOne.Vertices.size() ), split, split == kRings + 1 ? "expected" : "WRONG COUNT",
+		mirroredError, SameTangents( mirroredOne, mirroredAll ) ? "same" : "DIFFERENT" );
+
+	// GeometryGenerator layout: TangentU must be the xyz of the imported tangents.
+	GeneratorMesh generator, generatorOut;
+	ToGeneratorMesh( torus, &generator );
+	double generatorMs = TimeStep( generator, &generatorOut, [&]( GeneratorMesh* mesh ) { GenerateMeshDataTangents( mesh, threads ); } );
+	bool generatorSame = generatorOut.Vertices.size() == one.Tangents.size();
+	for( size_t i = 0; generatorSame && i < one.Tangents.size(); ++i )
+	{
+		const XMFLOAT3& a = generatorOut.Vertices[i].TangentU;
+		const XMFLOAT4& b = one.Tangents[i];
+		generatorSame = memcmp( &a, &b, sizeof( a ) ) == 0;
+	}
+	printf( "%-23s%2u %10.2f %10.2f %12u  %s\n", "MeshData, threads", threads, generatorMs, generatorMs * 1e6 / vertexCount,
+		UINT( generatorOut.Vertices.size() ), generatorSame ? "same" : "DIFFERENT" );
+
+	BenchRecord( "tangents torus 1 thread", oneMs, "ms" );
+	BenchRecord( "tangents torus all threads", allMs, "ms" );
+	BenchRecord( "tangents torus max error", error, "deg" );
+	BenchRecord( "tangents mirrored split vertices", split, "vertices" );
+}
@@ -0,0 +1,317 @@
+﻿//***************************************************************************************
+// TransformBench.cpp
+//
+// Batched bounding volume transforms (TransformSpheres, TransformAxisAlignedBoxes
+// and TransformOrientedBoxes on structure of arrays data) against a loop over
+// the per volume Transform* routines, single threaded and on every hardware
+// thread. The batch results are checked against the per volume ones, which
+// only take uniform scale, and the boxes under non-uniform scale against the
+// bounds of their transformed corners.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "ParallelFor.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const int kRepeats = 3;
+
+	// Structure of arrays storage of the three volume types: center x, y, z,
+	// extents x, y, z (the sphere radius shares the first), padding and the
+	// orientation x, y, z, w.
+	struct VolumeArrays
+	{
+		std::vector<float> data[11];
+
+		void Resize( UINT count )
+		{
+			for( int i = 0; i < 11; ++i )
+				data[i].resize( count );
+		}
+
+		SphereArrays Spheres()
+		{
+			SphereArrays a = { { &data[0][0], &data[1][0], &data[2][0] }, &data[3][0] };
+			return a;
+		}
+
+		AxisAlignedBoxArrays Boxes()
+		{
+			AxisAlignedBoxArrays a = { { &data[0][0], &data[1][0], &data[2][0] }, { &data[3][0], &data[4][0], &data[5][0] } };
+			return a;
+		}
+
+		OrientedBoxArrays OrientedBoxes()
+		{
+			OrientedBoxArrays a = { { &data[0][0], &data[1][0], &data[2][0] }, { &data[3][0], &data[4][0], &data[5][0] },
+									{ &data[7][0], &data[8][0], &data[9][0], &data[10][0] } };
+			return a;
+		}
+	};
+
+	struct Scene
+	{
+		VolumeArrays local;
+		std::vector<OrientedBox> orientedBoxes;	// The same volumes as structures.
+		std::vector<float> scales;
+		std::vector<XMFLOAT4> rotations;
+		std::vector<XMFLOAT3> translations;
+		std::vector<XMFLOAT4X4> matrices;		// Scale * rotation * translation.
+	};
+
+	XMVECTOR RandomRotation( BenchRandom& rng )
+	{
+		return XMQuaternionNormalize( XMVectorSet( rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ),
+												   rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ) ) );
+	}
+
+	// Unit sized volumes around their local origin, placed by uniformly scaled
+	// rigid transforms, or by non-uniform scales when nonUniform is set.
+	void BuildScene( Scene& scene, UINT count, bool nonUniform )
+	{
+		BenchRandom rng;
+
+		scene.local.Resize( count );
+		scene.orientedBoxes.resize( count );
+		scene.scales.resize( count );
+		scene.rotations.resize( count );
+		scene.translations.resize( count );
+		scene.matrices.resize( count );
+
+		for( UINT i = 0; i < count; ++i )
+		{
+			OrientedBox& box = scene.orientedBoxes[i];
+			box.Center = XMFLOAT3( rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ), rng.Range( -1.0f, 1.0f ) );
+			box.Extents = XMFLOAT3( rng.Range( 0.1f, 1.0f ), rng.Range( 0.1f, 1.0f ), rng.Range( 0.1f, 1.0f ) );
+			XMStoreFloat4( &box.Orientation, RandomRotation( rng ) );
+
+			float* v = &box.Center.x;
+			for( int j = 0; j < 3; ++j )
+				scene.local.data[j][i] = v[j];
+			v = &box.Extents.x;
+			for( int j = 0; j < 3; ++j )
+				scene.local.data[3 + j][i] = v[j];
+			scene.local.data[6][i] = 0.0f;
+			v = &box.Orientation.x;
+			for( int j = 0; j < 4; ++j )
+				scene.local.data[7 + j][i] = v[j];
+
+			scene.scales[i] = rng.Range( 0.5f, 2.0f );
+			XMVECTOR rotation = RandomRotation( rng );
+			XMStoreFloat4( &scene.rotations[i], rotation );
+			scene.translations[i] = XMFLOAT3( rng.Range( -100.0f, 100.0f ), rng.Range( -100.0f, 100.0f ), rng.Range( -100.0f, 100.0f ) );
+
+			XMMATRIX scale = nonUniform ? XMMatrixScaling( rng.Range( 0.5f, 2.0f ), rng.Range( 0.5f, 2.0f ), rng.Range( 0.5f, 2.0f ) )
+										: XMMatrixScaling( scene.scales[i], scene.scales[i], scene.scales[i] );
+			XMMATRIX m = scale * XMMatrixRotationQuaternion( rotation ) *
+						 XMMatrixTranslation( scene.translations[i].x, scene.translations[i].y, scene.translations[i].z );
+			XMStoreFloat4x4( &scene.matrices[i], m );
+		}
+	}
+
+	// Best of kRepeats runs.
+	template<typename Run>
+	double Time( Run run )
+	{
+		double best = 0.0;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			BenchTimer timer;
+			run();
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+
+	void Report( const char* method, UINT count, double ms )
+	{
+		printf( "%-24s %9u %10.3f %12.1f\n", method, count, ms, count / ( ms * 1000.0 ) );
+
+		char name[64];
+		snprintf( name, sizeof( name ), "%s %u", method, count );
+		BenchRecord( name, ms, "ms" );
+	}
+
+	float RelativeError( float a, float b )
+	{
+		return fabsf( a - b ) / ( fabsf( b ) > 1.0f ? fabsf( b ) : 1.0f );
+	}
+
+	// Largest relative difference between the batch results and the per
+	// volume routines.
+	float CompareSpheres( VolumeArrays& out, const std::vector<Sphere>& reference )
+	{
+		float error = 0.0f;
+		for( size_t i = 0; i < reference.size(); ++i )
+		{
+			const float* c = &reference[i].Center.x;
+			for( int j = 0; j < 3; ++j )
+				error = ( std::max )( error, RelativeError( out.data[j][i], c[j] ) );
+			error = ( std::max )( error, RelativeError( out.data[3][i], reference[i].Radius ) );
+		}
+		return error;
+	}
+
+	float CompareBoxes( VolumeArrays& out, const std::vector<AxisAlignedBox>& reference )
+	{
+		float error = 0.0f;
+		for( size_t i = 0; i < reference.size(); ++i )
+		{
+			const float* c = &reference[i].Center.x;
+			const float* e = &reference[i].Extents.x;
+			for( int j = 0; j < 3; ++j )
+			{
+				error = ( std::max )( error, RelativeError( out.data[j][i], c[j] ) );
+				error = ( std::max )( error, RelativeError( out.data[3 + j][i], e[j] ) );
+			}
+		}
+		return error;
+	}
+
+	// The quaternions may differ in sign.
+	float CompareOrientedBoxes( VolumeArrays& out, const std::vector<OrientedBox>& reference )
+	{
+		float error = 0.0f;
+		for( size_t i = 0; i < reference.size(); ++i )
+		{
+			const float* c = &reference[i].Center.x;
+			const float* e = &reference[i].Extents.x;
+			for( int j = 0; j < 3; ++j )
+			{
+				error = ( std::max )( error, RelativeError( out.data[j][i], c[j] ) );
+				error = ( std::max )( error, RelativeError( out.data[3 + j][i], e[j] ) );
+			}
+
+			const float* q = &reference[i].Orientation.x;
+			float dot = 0.0f;
+			for( int j = 0; j < 4; ++j )
+				dot += out.data[7 + j][i] * q[j];
+			error = ( std::max )( error, 1.0f - fabsf( dot ) );
+		}
+		return error;
+	}
+
+	// Under non-uniform scale: how far the batch boxes are from the bounds of
+	// the eight transformed corners (Arvo's method should give the same box).
+	float CheckNonUniformBoxes( Scene& scene, VolumeArrays& out, UINT count )
+	{
+		float error = 0.0f;
+		for( UINT i = 0; i < count; ++i )
+		{
+			XMMATRIX m = XMLoadFloat4x4( &scene.matrices[i] );
+			XMVECTOR center = XMVectorSet( scene.local.data[0][i], scene.local.data[1][i], scene.local.data[2][i], 0.0f );
+			XMVECTOR extents = XMVectorSet( scene.local.data[3][i], scene.local.data[4][i], scene.local.data[5][i], 0.0f );
+
+			XMVECTOR minV = XMVectorReplicate( 1e30f );
+			XMVECTOR maxV = XMVectorReplicate( -1e30f );
+			for( int k = 0; k < 8; ++k )
+			{
+				XMVECTOR sign = XMVectorSet( ( k & 1 ) ? 1.0f : -1.0f, ( k & 2 ) ? 1.0f : -1.0f, ( k & 4 ) ? 1.0f : -1.0f, 0.0f );
+				XMVECTOR corner = XMVector3Transform( center + extents * sign, m );
+				minV = XMVectorMin( minV, corner );
+				maxV = XMVectorMax( maxV, corner );
+			}
+
+			XMFLOAT3 c, e;
+			XMStoreFloat3( &c, ( minV + maxV ) * 0.5f );
+			XMStoreFloat3( &e, ( maxV - minV ) * 0.5f );
+			const float* pc = &c.x;
+			const float* pe = &e.x;
+			for( int j = 0; j < 3; ++j )
+			{
+				error = ( std::max )( error, RelativeError( out.data[j][i], pc[j] ) );
+				error = ( std::max )( error, RelativeError( out.data[3 + j][i], pe[j] ) );
+			}
+		}
+		return error;
+	}
+}
+
+void RunTransformBenchmarks()
+{
+	static const UINT counts[] = { 10000, 100000, 1000000 };
+
+	printf( "%u hardware threads, best of %d runs\n", GetWorkerThreadCount(), kRepeats );
+	printf( "%-24s %9s %10s %12s\n", "method", "volumes", "ms", "volumes/us" );
+
+	Scene scene;
+	VolumeArrays out;
+	std::vector<Sphere> spheres, sphereResults;
+	std::vector<AxisAlignedBox> boxes, boxResults;
+	std::vector<OrientedBox> orientedBoxResults;
+
+	for( size_t c = 0; c < BenchCountOf( counts ); ++c )
+	{
+		UINT count = counts[c];
+		BuildScene( scene, count, false );
+		out.Resize( count );
+
+		// The same volumes as structures, for the per volume routines.
+		spheres.resize( count );
+		boxes.resize( count );
+		for( UINT i = 0; i < count; ++i )
+		{
+			spheres[i].Center = scene.orientedBoxes[i].Center;
+			spheres[i].Radius = scene.local.data[3][i];
+			boxes[i].Center = scene.orientedBoxes[i].Center;
+			boxes[i].Extents = scene.orientedBoxes[i].Extents;
+		}
+		sphereResults.resize( count );
+		boxResults.resize( count );
+		orientedBoxResults.resize( count );
+
+		SphereArrays inSpheres = scene.local.Spheres(), outSpheres = out.Spheres();
+		AxisAlignedBoxArrays inBoxes = scene.local.Boxes(), outBoxes = out.Boxes();
+		OrientedBoxArrays inOrientedBoxes = scene.local.OrientedBoxes(), outOrientedBoxes = out.OrientedBoxes();
+		const XMFLOAT4X4* matrices = &scene.matrices[0];
+
+		Report( "sphere per volume", count, Time( [&]()
+		{
+			for( UINT i = 0; i < count; ++i )
+				TransformSphere( &sphereResults[i], &spheres[i], scene.scales[i], XMLoadFloat4( &scene.rotations[i] ),
+								 XMLoadFloat3( &scene.translations[i] ) );
+		} ) );
+		Report( "sphere batch (1T)", count, Time( [&]() { TransformSpheres( &outSpheres, &inSpheres, matrices, count, 1 ); } ) );
+		Report( "sphere batch (MT)", count, Time( [&]() { TransformSpheres( &outSpheres, &inSpheres, matrices, count, 0 ); } ) );
+		float sphereError = CompareSpheres( out, sphereResults );
+
+		Report( "aabb per volume", count, Time( [&]()
+		{
+			for( UINT i = 0; i < count; ++i )
+				TransformAxisAlignedBox( &boxResults[i], &boxes[i], scene.scales[i], XMLoadFloat4( &scene.rotations[i] ),
+										 XMLoadFloat3( &scene.translations[i] ) );
+		} ) );
+		Report( "aabb batch (1T)", count, Time( [&]() { TransformAxisAlignedBoxes( &outBoxes, &inBoxes, matrices, count, 1 ); } ) );
+		Report( "aabb batch (MT)", count, Time( [&]() { TransformAxisAlignedBoxes( &outBoxes, &inBoxes, matrices, count, 0 ); } ) );
+		float boxError = CompareBoxes( out, boxResults );
+
+		Report( "obb per volume", count, Time( [&]()
+		{
+			for( UINT i = 0; i < count; ++i )
+				TransformOrientedBox( &orientedBoxResults[i], &scene.orientedBoxes[i], scene.scales[i],
+									  XMLoadFloat4( &scene.rotations[i] ), XMLoadFloat3( &scene.translations[i] ) );
+		} ) );
+		Report( "obb batch (1T)", count, Time( [&]() { TransformOrientedBoxes( &outOrientedBoxes, &inOrientedBoxes, matrices, count, 1 ); } ) );
+		Report( "obb batch (MT)", count, Time( [&]() { TransformOrientedBoxes( &outOrientedBoxes, &inOrientedBoxes, matrices, count, 0 ); } ) );
+		float orientedBoxError = CompareOrientedBoxes( out, orientedBoxResults );
+
+		printf( "largest difference to the per volume routines: sphere %.2g, aabb %.2g, obb %.2g\n",
+				sphereError, boxError, orientedBoxError );
+
+		BuildScene( scene, count, true );
+		inBoxes = scene.local.Boxes();
+		TransformAxisAlignedBoxes( &outBoxes, &inBoxes, &scene.matrices[0], count, 0 );
+		printf( "non-uniform scale aabb, largest difference to the corner bounds: %.2g\n\n",
+				CheckNonUniformBoxes( scene, out, count ) );
+	}
+}
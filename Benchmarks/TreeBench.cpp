@@ -0,0 +1,227 @@
+﻿//***************************************************************************************
+// TreeBench.cpp
+//
+// DynamicAabbTree at the scale it was written for: kMovers boxes in a closed
+// room, every one of them moving every frame. A frame is MoveProxy for every
+// box and one UpdatePairs; the target is kTargetMs per frame. The tree is
+// rebuilt once after the boxes are created, and its fat boxes cover
+// kDisplacementScale frames of motion: the boxes keep their velocity until
+// they hit a wall, so most of them stay inside for that long.
+//
+// On the last frame the tight pairs (the fat pairs filtered with
+// FilterPairsAxisAlignedBox) must be exactly the pairs of an independent
+// exact search (a sort along x), and a set
+// of Query boxes must return exactly the proxies whose fat boxes they touch.
+//***************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "xnacollision.h"
+#include "DynamicAabbTree.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const UINT kMovers = 50000;
+	const int kFrames = 60;
+	const UINT kQueries = 200;
+	const double kTargetMs = 1.0;
+	const float kMargin = 0.1f;
+	const float kDisplacementScale = 16.0f;
+
+	struct Scene
+	{
+		std::vector<AxisAlignedBox> boxes;
+		std::vector<XMFLOAT3> velocities;
+		float size;
+	};
+
+	// Roughly constant density, as in the broadphase suite.
+	void BuildScene( Scene& scene, UINT count )
+	{
+		BenchRandom rng( count );
+
+		scene.size = 4.0f * powf( float( count ), 1.0f / 3.0f );
+		scene.boxes.resize( count );
+		scene.velocities.resize( count );
+
+		for( UINT i = 0; i < count; ++i )
+		{
+			scene.boxes[i].Center = XMFLOAT3( rng.Range( 0.0f, scene.size ), rng.Range( 0.0f, scene.size ), rng.Range( 0.0f, scene.size ) );
+			scene.boxes[i].Extents = XMFLOAT3( rng.Range( 0.2f, 1.0f ), rng.Range( 0.2f, 1.0f ), rng.Range( 0.2f, 1.0f ) );
+			scene.velocities[i] = XMFLOAT3( rng.Range( -0.02f, 0.02f ), rng.Range( -0.02f, 0.02f ), rng.Range( -0.02f, 0.02f ) );
+		}
+	}
+
+	void StepScene( Scene& scene )
+	{
+		for( size_t i = 0; i < scene.boxes.size(); ++i )
+		{
+			float* c = &scene.boxes[i].Center.x;
+			float* v = &scene.velocities[i].x;
+
+			for( int a = 0; a < 3; ++a )
+			{
+				c[a] += v[a];
+				if( c[a] < 0.0f || c[a] > scene.size )
+					v[a] = -v[a];
+			}
+		}
+	}
+
+	UINT64 PackPair( UINT a, UINT b )
+	{
+		return a < b ? ( UINT64( a ) << 32 ) | b : ( UINT64( b ) << 32 ) | a;
+	}
+
+	// Every overlapping pair of box indices, sorted: the boxes sorted by their
+	// lowest x, and each one tested with IntersectAxisAlignedBoxAxisAlignedBox
+	// against all the boxes that start before it ends along x. Exact, like
+	// the all pairs loop, without its 50000 squared tests.
+	void ReferencePairs( const Scene& scene, std::vector<UINT64>* pairs )
+	{
+		UINT count = UINT( scene.boxes.size() );
+		std::vector<std::pair<float, UINT> > order( count );
+		for( UINT i = 0; i < count; ++i )
+			order[i] = std::make_pair( scene.boxes[i].Center.x - scene.boxes[i].Extents.x, i );
+		std::sort( order.begin(), order.end() );
+
+		pairs->clear();
+		for( UINT a = 0; a < count; ++a )
+		{
+			const AxisAlignedBox& box = scene.boxes[order[a].second];
+			float maxX = box.Center.x + box.Extents.x;
+			for( UINT b = a + 1; b < count && order[b].first <= maxX; ++b )
+			{
+				if( IntersectAxisAlignedBoxAxisAlignedBox( &box, &scene.boxes[order[b].second] ) )
+					pairs->push_back( PackPair( order[a].second, order[b].second ) );
+			}
+		}
+		std::sort( pairs->begin(), pairs->end() );
+	}
+
+	bool Overlap( const AxisAlignedBox& a, const AxisAlignedBox& b )
+	{
+		return fabsf( a.Center.x - b.Center.x ) <= a.Extents.x + b.Extents.x &&
+			fabsf( a.Center.y - b.Center.y ) <= a.Extents.y + b.Extents.y &&
+			fabsf( a.Center.z - b.Center.z ) <= a.Extents.z + b.Extents.z;
+	}
+}
+
+void RunTreeBenchmarks()
+{
+	Scene scene;
+	BuildScene( scene, kMovers );
+
+	DynamicAabbTree tree( kMargin, kDisplacementScale );
+	std::vector<UINT> proxies( kMovers );
+	for( UINT i = 0; i < kMovers; ++i )
+		proxies[i] = tree.CreateProxy( &scene.boxes[i], reinterpret_cast<VOID*>( size_t( i ) ) );
+	tree.Rebuild();
+
+	std::vector<ProxyPair> added, removed;
+	tree.UpdatePairs( &added, &removed );
+
+	double moveTotal = 0.0, pairTotal = 0.0, worst = 0.0;
+	UINT reinserted = 0;
+	for( int f = 0; f < kFrames; ++f )
+	{
+		StepScene( scene );
+
+		BenchTimer timer;
+		for( UINT i = 0; i < kMovers; ++i )
+		{
+			const XMFLOAT3& v = scene.velocities[i];
+			if( tree.MoveProxy( proxies[i], &scene.boxes[i], XMVectorSet( v.x, v.y, v.z, 0.0f ) ) )
+				++reinserted;
+		}
+		double moveMs = timer.ElapsedMs();
+		tree.UpdatePairs( &added, &removed );
+		double frameMs = timer.ElapsedMs();
+
+		moveTotal += moveMs;
+		pairTotal += frameMs - moveMs;
+		worst = ( std::max )( worst, frameMs );
+	}
+
+	double frameMs = ( moveTotal + pairTotal ) / kFrames;
+	double reinsertedPercent = 100.0 * reinserted / ( double( kMovers ) * kFrames );
+	printf( "%u movers, %d frames, %.1f%% of the moves re-inserted, height %d, area ratio %.1f\n", kMovers, kFrames,
+		reinsertedPercent, tree.GetHeight(), tree.GetAreaRatio() );
+	printf( "%-22s %12s\n", "step", "ms/frame" );
+	printf( "%-22s %12.3f\n", "MoveProxy", moveTotal / kFrames );
+	printf( "%-22s %12.3f\n", "UpdatePairs", pairTotal / kFrames );
+	printf( "%-22s %12.3f  %s (target %.1f ms)\n", "frame", frameMs, frameMs < kTargetMs ? "within" : "OVER", kTargetMs );
+	printf( "%-22s %12.3f\n", "worst frame", worst );
+
+	// Pair set of the last frame against the sweep along x.
+	std::vector<ProxyPair> fat( tree.GetPairCount() ), tight;
+	for( UINT p = 0; p < tree.GetPairCount(); ++p )
+		fat[p] = tree.GetPair( p );
+	FilterPairsAxisAlignedBox( &tree, fat.empty() ? NULL : &fat[0], UINT( fat.size() ), &tight );
+
+	// Proxy ids are node ids of the tree: back to box indices.
+	std::vector<UINT64> treePairs, referencePairs;
+	for( size_t p = 0; p < tight.size(); ++p )
+	{
+		UINT a = UINT( size_t( tree.GetUserData( tight[p].ProxyA ) ) );
+		UINT b = UINT( size_t( tree.GetUserData( tight[p].ProxyB ) ) );
+		treePairs.push_back( PackPair( a, b ) );
+	}
+	std::sort( treePairs.begin(), treePairs.end() );
+
+	BenchTimer referenceTimer;
+	ReferencePairs( scene, &referencePairs );
+	double referenceMs = referenceTimer.ElapsedMs();
+	bool samePairs = treePairs == referencePairs;
+	printf( "%-22s %12.3f  %u fat, %u tight, %u reference: %s\n", "reference (once)", referenceMs, UINT( fat.size() ),
+		UINT( treePairs.size() ), UINT( referencePairs.size() ), samePairs ? "same" : "DIFFERENT" );
+
+	// Queries against every fat box.
+	std::vector<AxisAlignedBox> fatBoxes( kMovers );
+	for( UINT i = 0; i < kMovers; ++i )
+		tree.GetFatBox( proxies[i], &fatBoxes[i] );
+
+	BenchRandom rng( 7 );
+	std::vector<UINT> results, expected;
+	bool sameQueries = true;
+	double queryMs = 0.0;
+	size_t hits = 0;
+	for( UINT q = 0; q < kQueries; ++q )
+	{
+		AxisAlignedBox box;
+		box.Center = XMFLOAT3( rng.Range( 0.0f, scene.size ), rng.Range( 0.0f, scene.size ), rng.Range( 0.0f, scene.size ) );
+		float e = rng.Range( 0.5f, 4.0f );
+		box.Extents = XMFLOAT3( e, e, e );
+
+		results.clear();
+		BenchTimer timer;
+		tree.Query( &box, &results );
+		queryMs += timer.ElapsedMs();
+		std::sort( results.begin(), results.end() );
+
+		expected.clear();
+		for( UINT i = 0; i < kMovers; ++i )
+		{
+			if( Overlap( box, fatBoxes[i] ) )
+				expected.push_back( proxies[i] );
+		}
+		std::sort( expected.begin(), expected.end() );
+		sameQueries = sameQueries && results == expected;
+		hits += results.size();
+	}
+	printf( "%-22s %12.4f  %u queries, %u hits: %s\n", "Query (each)", queryMs / kQueries, kQueries, UINT( hits ),
+		sameQueries ? "same" : "DIFFERENT" );
+
+	BenchRecord( "tree 50k movers frame", frameMs, "ms" );
+	BenchRecord( "tree 50k movers MoveProxy", moveTotal / kFrames, "ms" );
+	BenchRecord( "tree 50k movers UpdatePairs", pairTotal / kFrames, "ms" );
+	BenchRecord( "tree 50k movers worst frame", worst, "ms" );
+	BenchRecord( "tree 50k movers re-inserted", reinsertedPercent, "%" );
+	BenchRecord( "tree query", queryMs / kQueries, "ms" );
+}
@@ -0,0 +1,274 @@
+﻿//***************************************************************************************
+// WeldBench.cpp
+//
+// Welding and smooth normals of a torus of kSegments x kRings quads written
+// as a flat OBJ exporter does: three vertices of its own for every triangle,
+// texture coordinates but no normals. Welding merges it back to one vertex
+// per grid point, the points on the texture seams twice; the smooth normals
+// are then compared with the analytic normals of the torus.
+//
+// A cube of the same kind shows the crease angle: every corner is split into
+// one vertex per side below 90 degrees and stays whole above.
+//
+// Every step runs on one thread, on two, on three and on all of them, and
+// the results must be the same bytes.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "xnacollision.h"
+#include "MeshWeld.h"
+#include "ParallelFor.h"
+#include "Benchmark.h"
+
+using namespace XNA;
+
+namespace
+{
+	const UINT kSegments = 1024;
+	const UINT kRings = 512;
+	const float kMajorRadius = 3.0f;
+	const float kMinorRadius = 1.0f;
+	const int kRepeats = 3;
+
+	ImportedVertex TorusVertex( UINT segment, UINT ring )
+	{
+		float u = float( segment ) / kSegments;
+		float v = float( ring ) / kRings;
+		float theta = u * XM_2PI;
+		float phi = v * XM_2PI;
+
+		ImportedVertex vertex;
+		float r = kMajorRadius + kMinorRadius * cosf( phi );
+		vertex.Position = XMFLOAT3( r * cosf( theta ), kMinorRadius * sinf( phi ), r * sinf( theta ) );
+		vertex.Normal = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+		vertex.TexCoord = XMFLOAT2( u, v );
+		return vertex;
+	}
+
+	XMFLOAT3 TorusNormal( const XMFLOAT3& position )
+	{
+		float length = sqrtf( position.x * position.x + position.z * position.z );
+		XMFLOAT3 center( position.x * kMajorRadius / length, 0.0f, position.z * kMajorRadius / length );
+		XMFLOAT3 normal( position.x - center.x, position.y, position.z - center.z );
+		float n = sqrtf( normal.x * normal.x + normal.y * normal.y + normal.z * normal.z );
+		return XMFLOAT3( normal.x / n, normal.y / n, normal.z / n );
+	}
+
+	// One subset, three vertices per triangle.
+	void AddSplitTriangle( ImportedMesh* mesh, const ImportedVertex& a, const ImportedVertex& b, const ImportedVertex& c )
+	{
+		UINT first = UINT( mesh->Vertices.size() );
+		mesh->Vertices.push_back( a );
+		mesh->Vertices.push_back( b );
+		mesh->Vertices.push_back( c );
+		mesh->Indices.push_back( first );
+		mesh->Indices.push_back( first + 1 );
+		mesh->Indices.push_back( first + 2 );
+	}
+
+	void FinishSplitMesh( ImportedMesh* mesh )
+	{
+		ImportedMaterial material;
+		InitializeImportedMaterial( &material, "default" );
+		mesh->Materials.assign( 1, material );
+
+		ImportedSubset subset;
+		subset.Material = 0;
+		subset.FirstIndex = 0;
+		subset.IndexCount = UINT( mesh->Indices.size() );
+		subset.BaseVertex = 0;
+		mesh->Subsets.assign( 1, subset );
+		ComputeImportedSubsetBounds( mesh );
+		mesh->HasNormals = FALSE;
+		mesh->HasTexCoords = TRUE;
+	}
+
+	void BuildSplitTorus( ImportedMesh* mesh )
+	{
+		mesh->Clear();
+		mesh->Vertices.reserve( kSegments * kRings * 6 );
+		mesh->Indices.reserve( kSegments * kRings * 6 );
+		for( UINT s = 0; s < kSegments; ++s )
+		{
+			for( UINT r = 0; r < kRings; ++r )
+			{
+				ImportedVertex v00 = TorusVertex( s, r ), v10 = TorusVertex( s + 1, r );
+				ImportedVertex v01 = TorusVertex( s, r + 1 ), v11 = TorusVertex( s + 1, r + 1 );
+				AddSplitTriangle( mesh, v00, v01, v11 );
+				AddSplitTriangle( mesh, v00, v11, v10 );
+			}
+		}
+		FinishSplitMesh( mesh );
+	}
+
+	// A unit cube, two triangles per face, one texture per face.
+	void BuildSplitCube( ImportedMesh* mesh )
+	{
+		mesh->Clear();
+		for( int axis = 0; axis < 3; ++axis )
+		{
+			for( int sign = -1; sign <= 1; sign += 2 )
+			{
+				ImportedVertex corners[4];
+				for( int k = 0; k < 4; ++k )
+				{
+					float a = ( k == 1 || k == 2 ) ? 1.0f : -1.0f;
+					float b = ( k >= 2 ) ? 1.0f : -1.0f;
+					float p[3];
+					p[axis] = float( sign );
+					p[( axis + 1 ) % 3] = sign > 0 ? a : b;
+					p[( axis + 2 ) % 3] = sign > 0 ? b : a;
+					corners[k].Position = XMFLOAT3( p[0], p[1], p[2] );
+					corners[k].Normal = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+					corners[k].TexCoord = XMFLOAT2( 0.5f * ( a + 1.0f ), 0.5f * ( b + 1.0f ) );
+				}
+				AddSplitTriangle( mesh, corners[0], corners[1], corners[2] );
+				AddSplitTriangle( mesh, corners[0], corners[2], corners[3] );
+			}
+		}
+		FinishSplitMesh( mesh );
+	}
+
+	bool SameMesh( const ImportedMesh& a, const ImportedMesh& b )
+	{
+		return a.Vertices.size() == b.Vertices.size() && a.Indices == b.Indices &&
+			( a.Vertices.empty() || memcmp( &a.Vertices[0], &b.Vertices[0], a.Vertices.size() * sizeof( ImportedVertex ) ) == 0 );
+	}
+
+	// Largest angle in degrees between a normal of the mesh and the analytic one.
+	double MaxTorusNormalError( const ImportedMesh& mesh )
+	{
+		double worst = 0.0;
+		for( size_t i = 0; i < mesh.Vertices.size(); ++i )
+		{
+			XMFLOAT3 expected = TorusNormal( mesh.Vertices[i].Position );
+			const XMFLOAT3& n = mesh.Vertices[i].Normal;
+			double dot = n.x * expected.x + n.y * expected.y + n.z * expected.z;
+			dot = dot > 1.0 ? 1.0 : ( dot < -1.0 ? -1.0 : dot );
+			double degrees = acos( dot ) * 180.0 / 3.14159265358979;
+			worst = degrees > worst ? degrees : worst;
+		}
+		return worst;
+	}
+
+	// Best of kRepeats of Step on a fresh copy of source; the last result in *out.
+	template <class Step>
+	double TimeStep( const ImportedMesh& source, ImportedMesh* out, Step step )
+	{
+		double best = 0.0;
+		for( int r = 0; r < kRepeats; ++r )
+		{
+			*out = source;
+			BenchTimer timer;
+			step( out );
+			double ms = timer.ElapsedMs();
+			if( r == 0 || ms < best )
+				best = ms;
+		}
+		return best;
+	}
+}
+
+void RunWeldBenchmarks()
+{
+	UINT threads = GetWorkerThreadCount();
+	ImportedMesh split;
+	BuildSplitTorus( &split );
+	UINT splitVertices = UINT( split.Vertices.size() );
+	UINT expectedVertices = ( kSegments + 1 ) * ( kRings + 1 );
+
+	MeshWeldOptions weldOptions;
+	weldOptions.PositionEpsilon = 1e-4f;
+	ImportedMesh weldedOne;
+	double weldOneMs = TimeStep( split, &weldedOne, [&]( ImportedMesh* mesh ) { WeldImportedMesh( mesh, weldOptions, 1 ); } );
+	UINT weldedVertices = UINT( weldedOne.Vertices.size() );
+
+	printf( "torus of %u triangles, %u split vertices\n", UINT( split.Indices.size() / 3 ), splitVertices );
+	printf( "%-26s %10s %10s %12s %10s  %s\n", "step", "ms", "ns/vert", "vertices", "", "check" );
+	printf( "%-23s%2u %10.2f %10.2f %12u %9.2fx  %s\n", "weld, threads", 1u, weldOneMs, weldOneMs * 1e6 / splitVertices,
+		weldedVertices, double( splitVertices ) / weldedVertices, weldedVertices == expectedVertices ? "expected" : "WRONG COUNT" );
+
+	UINT threadCounts[] = { 2, 3, threads };
+	double weldAllMs = weldOneMs;
+	for( size_t t = 0; t < BenchCountOf( threadCounts ); ++t )
+	{
+		ImportedMesh other;
+		double ms = TimeStep( split, &other, [&]( ImportedMesh* mesh ) { WeldImportedMesh( mesh, weldOptions, threadCounts[t] ); } );
+		if( threadCounts[t] == threads )
+			weldAllMs = ms;
+		printf( "%-23s%2u %10.2f %10.2f %12u %9.2fx  %s\n", "weld, threads", threadCounts[t], ms, ms * 1e6 / splitVertices,
+			UINT( other.Vertices.size() ), double( splitVertices ) / other.Vertices.size(),
+			SameMesh( weldedOne, other ) ? "same" : "DIFFERENT" );
+	}
+
+	struct { const char* name; MeshNormalWeighting weighting; } normalCases[] =
+	{
+		{ "angle normals", MeshNormalsByAngle },
+		{ "area normals", MeshNormalsByArea },
+	};
+	double normalMs[2] = { 0.0, 0.0 };
+	double normalError[2] = { 0.0, 0.0 };
+	for( int c = 0; c < 2; ++c )
+	{
+		MeshNormalOptions normalOptions;
+		normalOptions.Weighting = normalCases[c].weighting;
+		normalOptions.CreaseAngle = XMConvertToRadians( 60.0f );
+		ImportedMesh one;
+		double oneMs = TimeStep( weldedOne, &one, [&]( ImportedMesh* mesh ) { GenerateSmoothNormals( mesh, normalOptions, 1 ); } );
+		normalError[c] = MaxTorusNormalError( one );
+
+		char name[64];
+		snprintf( name, sizeof( name ), "%s, threads", normalCases[c].name );
+		printf( "%-23s%2u %10.2f %10.2f %12u %10s  max error %.3f deg\n", name, 1u, oneMs, oneMs * 1e6 / weldedVertices,
+			UINT( one.Vertices.size() ), "", normalError[c] );
+		normalMs[c] = oneMs;
+		for( size_t t = 0; t < BenchCountOf( threadCounts ); ++t )
+		{
+			ImportedMesh other;
+			double ms = TimeStep( weldedOne, &other, [&]( ImportedMesh* mesh ) { GenerateSmoothNormals( mesh, normalOptions, threadCounts[t] ); } );
+			if( threadCounts[t] == threads )
+				normalMs[c] = ms;
+			printf( "%-23s%2u %10.2f %10.2f %12u %10s  %s\n", name, threadCounts[t], ms, ms * 1e6 / weldedVertices,
+				UINT( other.Vertices.size() ), "", SameMesh( one, other ) ? "same" : "DIFFERENT" );
+		}
+	}
+
+	// The split mesh straight away: its normals are smooth as well, since the
+	// faces are gathered per position, but every split vertex is kept.
+	MeshNormalOptions splitOptions;
+	ImportedMesh splitNormals;
+	double splitNormalMs = TimeStep( split, &splitNormals, [&]( ImportedMesh* mesh ) { GenerateSmoothNormals( mesh, splitOptions, threads ); } );
+	printf( "%-23s%2u %10.2f %10.2f %12u %10s  max error %.3f deg\n", "normals unwelded", threads, splitNormalMs,
+		splitNormalMs * 1e6 / splitVertices, UINT( splitNormals.Vertices.size() ), "", MaxTorusNormalError( splitNormals ) );
+
+	// Crease angle on a cube: 8 corners, welded per face by the texture.
+	ImportedMesh cube;
+	BuildSplitCube( &cube );
+	MeshWeldOptions positionOnly;
+	positionOnly.TexCoordEpsilon = 0.0f;
+	WeldImportedMesh( &cube, positionOnly );
+	printf( "\ncube, %u split vertices welded to %u\n", 36u, UINT( cube.Vertices.size() ) );
+	float creases[] = { 30.0f, 89.0f, 91.0f, 180.0f };
+	for( int c = 0; c < 4; ++c )
+	{
+		ImportedMesh creased = cube;
+		MeshNormalOptions options;
+		options.CreaseAngle = XMConvertToRadians( creases[c] );
+		UINT added = GenerateSmoothNormals( &creased, options );
+		printf( "  crease %5.1f deg: %2u vertices (%u added)\n", creases[c], UINT( creased.Vertices.size() ), added );
+	}
+
+	BenchRecord( "weld torus split vertices", splitVertices, "vertices" );
+	BenchRecord( "weld torus welded vertices", weldedVertices, "vertices" );
+	BenchRecord( "weld torus 1 thread", weldOneMs, "ms" );
+	BenchRecord( "weld torus all threads", weldAllMs, "ms" );
+	BenchRecord( "weld normals by angle all threads", normalMs[0], "ms" );
+	BenchRecord( "weld normals by area all threads", normalMs[1], "ms" );
+	BenchRecord( "weld normals by angle max error", normalError[0], "deg" );
+}
@@ -0,0 +1,192 @@
+﻿//***************************************************************************************
+// main.cpp
+//
+// Console benchmark runner. Without arguments every suite runs, otherwise only
+// the suites named on the command line, e.g. "Benchmarks.exe broadphase".
+// "--json file" also writes the recorded results to file, for comparing runs.
+//***************************************************************************************
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "xnacollision.h"
+#include "Benchmark.h"
+
+struct BenchSuite
+{
+	const char* name;
+	void ( *run )();
+};
+
+static const BenchSuite gSuites[] =
+{
+	{ "broadphase", RunBroadphaseBenchmarks },
+	{ "raypacket", RunRayPacketBenchmarks },
+	{ "bounds", RunBoundsBenchmarks },
+	{ "collision", RunCollisionBenchmarks },
+	{ "culling", RunCullBenchmarks },
+	{ "transforms", RunTransformBenchmarks },
+	{ "hashgrid", RunHashGridBenchmarks },
+	{ "boxstack", RunBoxStackBenchmarks },
+	{ "sweep", RunSweepBenchmarks },
+	{ "convex", RunConvexBenchmarks },
+	{ "hull", RunHullBenchmarks },
+	{ "sdf", RunDistanceFieldBenchmarks },
+	{ "obj", RunObjBenchmarks },
+	{ "meshcache", RunMeshCacheBenchmarks },
+	{ "scene", RunSceneBenchmarks },
+	{ "asyncload", RunAsyncLoadBenchmarks },
+	{ "archive", RunArchiveBenchmarks },
+	{ "meshload", RunMeshLoadBenchmarks },
+	{ "weld", RunWeldBenchmarks },
+	{ "tangents", RunTangentBenchmarks },
+	{ "codec", RunMeshCodecBenchmarks },
+	{ "tree", RunTreeBenchmarks },
+};
+
+static const int gSuiteCount = int( BenchCountOf( gSuites ) );
+
+struct BenchResult
+{
+	std::string suite;
+	std::string name;
+	double value;
+	std::string unit;
+};
+
+static std::vector<BenchResult> gResults;
+static const char* gCurrentSuite = "";
+
+void BenchRecord( const char* name, double value, const char* unit )
+{
+	BenchResult result;
+	result.suite = gCurrentSuite;
+	result.name = name;
+	result.value = value;
+	result.unit = unit;
+	gResults.push_back( result );
+}
+
+// The DirectXMath code path the collision library was compiled with.
+static const char* GetSimdName()
+{
+#if defined( _XM_NO_INTRINSICS_ )
+	return "scalar";
+#elif defined( _XM_AVX2_INTRINSICS_ )
+	return "avx2";
+#elif defined( _XM_AVX_INTRINSICS_ )
+	return "avx";
+#elif defined( _XM_ARM_NEON_INTRINSICS_ )
+	return "neon";
+#else
+	return "sse2";
+#endif
+}
+
+static const char* GetCompilerName()
+{
+#if defined( __clang__ )
+	return "clang";
+#elif defined( _MSC_VER )
+	return "msvc";
+#elif defined( __GNUC__ )
+	return "gcc";
+#else
+	return "unknown";
+#endif
+}
+
+// Names are plain identifiers, only quotes and backslashes need escaping.
+static void WriteJsonString( FILE* file, const std::string& s )
+{
+	fputc( '"', file );
+	for( size_t i = 0; i < s.size(); ++i )
+	{
+		if( s[i] == '"' || s[i] == '\\' )
+			fputc( '\\', file );
+		fputc( s[i], file );
+	}
+	fputc( '"', file );
+}
+
+static bool WriteJsonReport( const char* path )
+{
+	FILE* file = fopen( path, "w" );
+	if( !file )
+		return false;
+
+	fprintf( file, "{\n  \"compiler\": \"%s\",\n  \"simd\": \"%s\",\n  \"results\": [", GetCompilerName(), GetSimdName() );
+
+	for( size_t i = 0; i < gResults.size(); ++i )
+	{
+		const BenchResult& r = gResults[i];
+
+		fprintf( file, "%s\n    { \"suite\": ", i ? "," : "" );
+		WriteJsonString( file, r.suite );
+		fprintf( file, ", \"name\": " );
+		WriteJsonString( file, r.name );
+		fprintf( file, ", \"value\": %.6g, \"unit\": ", r.value );
+		WriteJsonString( file, r.unit );
+		fprintf( file, " }" );
+	}
+
+	fprintf( file, "\n  ]\n}\n" );
+
+	return fclose( file ) == 0;
+}
+
+int main( int argc, char** argv )
+{
+	const char* jsonPath = nullptr;
+	std::vector<const char*> names;
+
+	for( int a = 1; a < argc; ++a )
+	{
+		if( strcmp( argv[a], "--json" ) == 0 && a + 1 < argc )
+			jsonPath = argv[++a];
+		else
+			names.push_back( argv[a] );
+	}
+
+	bool ranAny = false;
+
+	for( int s = 0; s < gSuiteCount; ++s )
+	{
+		bool selected = names.empty();
+		for( size_t n = 0; n < names.size(); ++n )
+		{
+			if( strcmp( names[n], gSuites[s].name ) == 0 )
+				selected = true;
+		}
+
+		if( selected )
+		{
+			printf( "== %s ==\n", gSuites[s].name );
+			gCurrentSuite = gSuites[s].name;
+			gSuites[s].run();
+			printf( "\n" );
+			ranAny = true;
+		}
+	}
+
+	if( !ranAny )
+	{
+		printf( "usage: %s [--json file] [suite...]\nsuites:", argv[0] );
+		for( int s = 0; s < gSuiteCount; ++s )
+			printf( " %s", gSuites[s].name );
+		printf( "\n" );
+		return 1;
+	}
+
+	if( jsonPath && !WriteJsonReport( jsonPath ) )
+	{
+		printf( "could not write %s\n", jsonPath );
+		return 1;
+	}
+
+	return 0;
+}
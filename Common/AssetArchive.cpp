@@ -0,0 +1,649 @@
+//-------------------------------------------------------------------------------------
+// AssetArchive.cpp
+//
+// Asset archive reader and packer, asset path keys and the LZ4 block codec.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include "AssetArchive.h"
+
+namespace XNA
+{
+
+static_assert( sizeof( AssetArchiveHeader ) == 48, "AssetArchiveHeader layout is part of the file format" );
+static_assert( sizeof( AssetArchiveEntry ) == 48, "AssetArchiveEntry layout is part of the file format" );
+
+static const size_t Lz4MinMatch = 4;
+static const size_t Lz4LastLiterals = 5;        // The block always ends with this many literals,
+static const size_t Lz4MatchFindLimit = 12;     // and its last match starts this far from the end.
+static const size_t Lz4MaxOffset = 65535;
+static const UINT Lz4HashBits = 16;
+
+
+
+//-----------------------------------------------------------------------------
+// Asset paths.
+//-----------------------------------------------------------------------------
+std::string NormalizeAssetPath( const char* Path )
+{
+    XMASSERT( Path );
+
+    std::string Root;
+    std::vector<std::string> Segments;
+    std::string Segment;
+
+    const char* p = Path;
+    if( *p == '/' || *p == '\\' )
+    {
+        Root = "/";
+        p++;
+    }
+
+    for( ;; p++ )
+    {
+        if( *p != '/' && *p != '\\' && *p != '\0' )
+        {
+            Segment += *p;
+            continue;
+        }
+
+        if( Segment == ".." )
+        {
+            // Nothing is above the root; a relative path keeps its leading "..".
+            if( !Segments.empty() && Segments.back() != ".." )
+                Segments.pop_back();
+            else if( Root.empty() )
+                Segments.push_back( Segment );
+        }
+        else if( !Segment.empty() && Segment != "." )
+            Segments.push_back( Segment );
+        Segment.clear();
+
+        if( *p == '\0' )
+            break;
+    }
+
+    std::string Result = Root;
+    for( size_t i = 0; i < Segments.size(); i++ )
+    {
+        if( i > 0 )
+            Result += '/';
+        Result += Segments[i];
+    }
+    return Result;
+}
+
+
+
+std::string MakeAssetKey( const char* Path )
+{
+    std::string Key = NormalizeAssetPath( Path );
+    for( size_t i = 0; i < Key.size(); i++ )
+    {
+        if( Key[i] >= 'A' && Key[i] <= 'Z' )
+            Key[i] = static_cast<char>( Key[i] - 'A' + 'a' );
+    }
+    return Key;
+}
+
+
+
+UINT64 HashAssetKey( const std::string& Key )
+{
+    return ComputeContentHash( Key.data(), Key.size() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// LZ4 block format: sequences of a token (literal length in the high nibble,
+// match length - 4 in the low one, 15 meaning more length bytes follow), the
+// literals, a 16-bit match offset back into the output and the match length
+// bytes. The last sequence has literals only.
+//-----------------------------------------------------------------------------
+static inline UINT Read32( const BYTE* p )
+{
+    UINT Value;
+    memcpy( &Value, p, sizeof( Value ) );
+    return Value;
+}
+
+
+
+static inline UINT HashLz4Sequence( UINT Sequence )
+{
+    return ( Sequence * 2654435761U ) >> ( 32 - Lz4HashBits );
+}
+
+
+
+static inline BYTE* WriteLz4Length( BYTE* p, size_t Length )
+{
+    while( Length >= 255 )
+    {
+        *p++ = 255;
+        Length -= 255;
+    }
+    *p++ = static_cast<BYTE>( Length );
+    return p;
+}
+
+
+
+size_t GetLz4CompressBound( size_t Size )
+{
+    return Size + Size / 255 + 16;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Greedy compressor with a hash table of the last position of every 4-byte
+// sequence. Positions that found no match are skipped faster and faster, so
+// incompressible data costs little.
+//-----------------------------------------------------------------------------
+size_t CompressLz4Block( const BYTE* pSrc, size_t SrcSize, BYTE* pDst, size_t DstCapacity )
+{
+    XMASSERT( pSrc || SrcSize == 0 );
+    XMASSERT( pDst || DstCapacity == 0 );
+
+    BYTE* pOut = pDst;
+    BYTE* pOutEnd = pDst + DstCapacity;
+    size_t Anchor = 0;
+
+    if( SrcSize > Lz4MatchFindLimit )
+    {
+        std::vector<size_t> Table( size_t( 1 ) << Lz4HashBits, ~size_t( 0 ) );
+        size_t MatchLimit = SrcSize - Lz4LastLiterals;
+        size_t SearchLimit = SrcSize - Lz4MatchFindLimit;
+        size_t Position = 0;
+
+        while( Position < SearchLimit )
+        {
+            UINT Sequence = Read32( pSrc + Position );
+            UINT Hash = HashLz4Sequence( Sequence );
+            size_t Candidate = Table[Hash];
+            Table[Hash] = Position;
+
+            if( Candidate == ~size_t( 0 ) || Position - Candidate > Lz4MaxOffset || Read32( pSrc + Candidate ) != Sequence )
+            {
+                Position += 1 + ( ( Position - Anchor ) >> 6 );
+                continue;
+            }
+
+            size_t Length = Lz4MinMatch;
+            while( Position + Length < MatchLimit && pSrc[Candidate + Length] == pSrc[Position + Length] )
+                Length++;
+
+            size_t Literals = Position - Anchor;
+            size_t Needed = 1 + Literals / 255 + 1 + Literals + 2 + ( Length - Lz4MinMatch ) / 255 + 1;
+            if( Needed > size_t( pOutEnd - pOut ) )
+                return 0;
+
+            BYTE* pToken = pOut++;
+            if( Literals >= 15 )
+            {
+                *pToken = 15 << 4;
+                pOut = WriteLz4Length( pOut, Literals - 15 );
+            }
+            else
+            {
+                *pToken = static_cast<BYTE>( Literals << 4 );
+            }
+            memcpy( pOut, pSrc + Anchor, Literals );
+            pOut += Literals;
+
+            size_t Offset = Position - Candidate;
+            *pOut++ = static_cast<BYTE>( Offset );
+            *pOut++ = static_cast<BYTE>( Offset >> 8 );
+
+            size_t MatchCode = Length - Lz4MinMatch;
+            if( MatchCode >= 15 )
+            {
+                *pToken |= 15;
+                pOut = WriteLz4Length( pOut, MatchCode - 15 );
+            }
+            else
+            {
+                *pToken |= static_cast<BYTE>( MatchCode );
+            }
+
+            Position += Length;
+            Anchor = Position;
+        }
+    }
+
+    size_t Literals = SrcSize - Anchor;
+    if( 1 + Literals / 255 + 1 + Literals > size_t( pOutEnd - pOut ) )
+        return 0;
+
+    BYTE* pToken = pOut++;
+    if( Literals >= 15 )
+    {
+        *pToken = 15 << 4;
+        pOut = WriteLz4Length( pOut, Literals - 15 );
+    }
+    else
+    {
+        *pToken = static_cast<BYTE>( Literals << 4 );
+    }
+    if( Literals > 0 )
+        memcpy( pOut, pSrc + Anchor, Literals );
+    pOut += Literals;
+
+    return pOut - pDst;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Every length and offset is checked against both buffers before use. Short
+// literal runs and matches are copied in fixed size blocks when both buffers
+// have room past them: the bytes written beyond a sequence are overwritten
+// by the next one, and there are no per byte length branches.
+//-----------------------------------------------------------------------------
+BOOL DecompressLz4Block( const BYTE* pSrc, size_t SrcSize, BYTE* pDst, size_t DstSize )
+{
+    XMASSERT( pSrc || SrcSize == 0 );
+    XMASSERT( pDst || DstSize == 0 );
+
+    const BYTE* pIn = pSrc;
+    const BYTE* pInEnd = pSrc + SrcSize;
+    BYTE* pOut = pDst;
+    BYTE* pOutEnd = pDst + DstSize;
+
+    for( ;; )
+    {
+        if( pIn >= pInEnd )
+            return FALSE;
+
+        UINT Token = *pIn++;
+
+        size_t Literals = Token >> 4;
+        if( Literals == 15 )
+        {
+            BYTE Byte;
+            do
+            {
+                if( pIn >= pInEnd )
+                    return FALSE;
+                Byte = *pIn++;
+                Literals += Byte;
+            } while( Byte == 255 );
+        }
+
+        if( Literals > size_t( pInEnd - pIn ) || Literals > size_t( pOutEnd - pOut ) )
+            return FALSE;
+        if( Literals <= 16 && pInEnd - pIn >= 16 && pOutEnd - pOut >= 16 )
+            memcpy( pOut, pIn, 16 );
+        else if( Literals > 0 )
+            memcpy( pOut, pIn, Literals );
+        pIn += Literals;
+        pOut += Literals;
+
+        // The last sequence has no match.
+        if( pIn == pInEnd )
+            return pOut == pOutEnd;
+
+        if( pInEnd - pIn < 2 )
+            return FALSE;
+        size_t Offset = pIn[0] | ( pIn[1] << 8 );
+        pIn += 2;
+        if( Offset == 0 || Offset > size_t( pOut - pDst ) )
+            return FALSE;
+
+        size_t Length = Token & 15;
+        if( Length == 15 )
+        {
+            BYTE Byte;
+            do
+            {
+                if( pIn >= pInEnd )
+                    return FALSE;
+                Byte = *pIn++;
+                Length += Byte;
+            } while( Byte == 255 );
+        }
+        Length += Lz4MinMatch;
+
+        if( Length > size_t( pOutEnd - pOut ) )
+            return FALSE;
+
+        const BYTE* pMatch = pOut - Offset;
+        if( Offset >= 8 && size_t( pOutEnd - pOut ) >= Length + 8 )
+        {
+            // Whole 8 byte copies, up to 7 bytes past the match that the
+            // next sequence overwrites; 8 apart, they never read what they write.
+            BYTE* pEnd = pOut + Length;
+            do
+            {
+                memcpy( pOut, pMatch, 8 );
+                pOut += 8;
+                pMatch += 8;
+            } while( pOut < pEnd );
+            pOut = pEnd;
+        }
+        else if( Offset >= Length )
+        {
+            memcpy( pOut, pMatch, Length );
+            pOut += Length;
+        }
+        else
+        {
+            // Overlapping: the match repeats the last Offset bytes.
+            for( size_t i = 0; i < Length; i++ )
+                *pOut++ = pMatch[i];
+        }
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Reader.
+//-----------------------------------------------------------------------------
+AssetArchive::AssetArchive()
+    : m_pHeader( NULL ),
+      m_pEntries( NULL ),
+      m_pStrings( NULL )
+{
+}
+
+
+
+AssetArchive::~AssetArchive()
+{
+    Close();
+}
+
+
+
+BOOL AssetArchive::Open( const char* FileName )
+{
+    XMASSERT( FileName );
+
+    Close();
+    if( !m_File.Open( FileName ) )
+        return FALSE;
+
+    const BYTE* pData = m_File.GetData();
+    UINT64 Size = m_File.GetSize();
+    const AssetArchiveHeader* pHeader = reinterpret_cast<const AssetArchiveHeader*>( pData );
+
+    BOOL Valid = Size >= sizeof( AssetArchiveHeader ) && pHeader->Magic == AssetArchiveMagic &&
+                 pHeader->Version == AssetArchiveVersion && pHeader->FileSize == Size &&
+                 pHeader->EntryOffset % AssetArchiveAlignment == 0 && pHeader->EntryOffset <= Size &&
+                 pHeader->EntryCount <= ( Size - pHeader->EntryOffset ) / sizeof( AssetArchiveEntry ) &&
+                 pHeader->StringOffset <= Size && pHeader->StringSize <= Size - pHeader->StringOffset &&
+                 ( pHeader->StringSize == 0 || pData[pHeader->StringOffset + pHeader->StringSize - 1] == '\0' );
+
+    const AssetArchiveEntry* pEntries = Valid ? reinterpret_cast<const AssetArchiveEntry*>( pData + pHeader->EntryOffset )
+                                              : NULL;
+    for( UINT i = 0; Valid && i < pHeader->EntryCount; i++ )
+    {
+        const AssetArchiveEntry& Entry = pEntries[i];
+        Valid = Entry.Offset <= Size && Entry.Size <= Size - Entry.Offset && Entry.Name < pHeader->StringSize &&
+                ( Entry.Compression == AssetStored ? Entry.OriginalSize == Entry.Size
+                                                   : Entry.Compression == AssetLz4 && Entry.OriginalSize / 255 <= Entry.Size ) &&
+                ( i == 0 || pEntries[i - 1].NameHash <= Entry.NameHash );
+    }
+
+    if( !Valid )
+    {
+        Close();
+        return FALSE;
+    }
+
+    m_pHeader = pHeader;
+    m_pEntries = pEntries;
+    m_pStrings = reinterpret_cast<const char*>( pData + pHeader->StringOffset );
+    return TRUE;
+}
+
+
+
+VOID AssetArchive::Close()
+{
+    m_File.Close();
+    m_pHeader = NULL;
+    m_pEntries = NULL;
+    m_pStrings = NULL;
+}
+
+
+
+BOOL AssetArchive::IsOpen() const
+{
+    return m_pHeader != NULL;
+}
+
+
+
+UINT AssetArchive::GetEntryCount() const
+{
+    return m_pHeader ? m_pHeader->EntryCount : 0;
+}
+
+
+
+const AssetArchiveEntry* AssetArchive::GetEntries() const
+{
+    return m_pEntries;
+}
+
+
+
+const char* AssetArchive::GetName( UINT Index ) const
+{
+    XMASSERT( Index < GetEntryCount() );
+    return m_pStrings + m_pEntries[Index].Name;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Binary search on the hash, then the names of the entries sharing it.
+//-----------------------------------------------------------------------------
+BOOL AssetArchive::Find( const char* Name, UINT* pIndex ) const
+{
+    XMASSERT( Name );
+    XMASSERT( pIndex );
+
+    if( !m_pHeader )
+        return FALSE;
+
+    std::string Key = MakeAssetKey( Name );
+    UINT64 Hash = HashAssetKey( Key );
+
+    UINT First = 0;
+    UINT Count = m_pHeader->EntryCount;
+    while( Count > 0 )
+    {
+        UINT Half = Count / 2;
+        if( m_pEntries[First + Half].NameHash < Hash )
+        {
+            First += Half + 1;
+            Count -= Half + 1;
+        }
+        else
+        {
+            Count = Half;
+        }
+    }
+
+    for( UINT i = First; i < m_pHeader->EntryCount && m_pEntries[i].NameHash == Hash; i++ )
+    {
+        if( Key == m_pStrings + m_pEntries[i].Name )
+        {
+            *pIndex = i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+
+
+BOOL AssetArchive::GetView( UINT Index, const BYTE** ppData, size_t* pSize ) const
+{
+    XMASSERT( Index < GetEntryCount() );
+    XMASSERT( ppData );
+    XMASSERT( pSize );
+
+    const AssetArchiveEntry& Entry = m_pEntries[Index];
+    if( Entry.Compression != AssetStored )
+        return FALSE;
+
+    *ppData = m_File.GetData() + Entry.Offset;
+    *pSize = static_cast<size_t>( Entry.Size );
+    return TRUE;
+}
+
+
+
+BOOL AssetArchive::GetFile( const char* Name, const BYTE** ppData, size_t* pSize ) const
+{
+    UINT Index;
+    return Find( Name, &Index ) && GetView( Index, ppData, pSize );
+}
+
+
+
+BOOL AssetArchive::Extract( UINT Index, std::vector<BYTE>* pOut ) const
+{
+    XMASSERT( Index < GetEntryCount() );
+    XMASSERT( pOut );
+
+    const AssetArchiveEntry& Entry = m_pEntries[Index];
+    const BYTE* pData = m_File.GetData() + Entry.Offset;
+
+    pOut->resize( static_cast<size_t>( Entry.OriginalSize ) );
+    if( Entry.OriginalSize == 0 )
+        return TRUE;
+
+    if( Entry.Compression == AssetStored )
+    {
+        memcpy( &( *pOut )[0], pData, pOut->size() );
+        return TRUE;
+    }
+
+    if( !DecompressLz4Block( pData, static_cast<size_t>( Entry.Size ), &( *pOut )[0], pOut->size() ) )
+    {
+        pOut->clear();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Packing.
+//-----------------------------------------------------------------------------
+static inline UINT64 AlignArchiveOffset( UINT64 Offset )
+{
+    return ( Offset + AssetArchiveAlignment - 1 ) & ~UINT64( AssetArchiveAlignment - 1 );
+}
+
+
+
+BOOL BuildAssetArchive( const std::vector<AssetArchiveSource>& Sources, std::vector<BYTE>* pImage,
+                        UINT MinSavingFraction )
+{
+    XMASSERT( pImage );
+
+    struct PackedEntry
+    {
+        std::string Key;
+        UINT Source;
+        AssetArchiveEntry Entry;
+        std::vector<BYTE> Compressed;
+    };
+
+    std::vector<PackedEntry> Packed( Sources.size() );
+    for( size_t i = 0; i < Sources.size(); i++ )
+    {
+        PackedEntry& Item = Packed[i];
+        const std::vector<BYTE>& Data = Sources[i].Data;
+
+        Item.Key = MakeAssetKey( Sources[i].Name.c_str() );
+        Item.Source = static_cast<UINT>( i );
+        memset( &Item.Entry, 0, sizeof( Item.Entry ) );
+        Item.Entry.NameHash = HashAssetKey( Item.Key );
+        Item.Entry.OriginalSize = Data.size();
+        Item.Entry.ContentHash = ComputeContentHash( Data.empty() ? NULL : &Data[0], Data.size() );
+        Item.Entry.Compression = AssetStored;
+        Item.Entry.Size = Data.size();
+
+        if( Sources[i].Compression == AssetLz4 && !Data.empty() )
+        {
+            Item.Compressed.resize( GetLz4CompressBound( Data.size() ) );
+            size_t Size = CompressLz4Block( &Data[0], Data.size(), &Item.Compressed[0], Item.Compressed.size() );
+            if( Size > 0 && Size <= Data.size() - Data.size() / ( std::max )( MinSavingFraction, 1u ) )
+            {
+                Item.Compressed.resize( Size );
+                Item.Entry.Compression = AssetLz4;
+                Item.Entry.Size = Size;
+            }
+            else
+            {
+                std::vector<BYTE>().swap( Item.Compressed );
+            }
+        }
+    }
+
+    std::sort( Packed.begin(), Packed.end(), []( const PackedEntry& a, const PackedEntry& b )
+    {
+        return a.Entry.NameHash != b.Entry.NameHash ? a.Entry.NameHash < b.Entry.NameHash : a.Key < b.Key;
+    } );
+
+    for( size_t i = 1; i < Packed.size(); i++ )
+    {
+        if( Packed[i].Key == Packed[i - 1].Key )
+        {
+            pImage->clear();
+            return FALSE;
+        }
+    }
+
+    // Blobs in table order, then the table, then the names.
+    UINT64 Offset = AlignArchiveOffset( sizeof( AssetArchiveHeader ) );
+    UINT64 StringSize = 0;
+    for( size_t i = 0; i < Packed.size(); i++ )
+    {
+        Packed[i].Entry.Offset = Offset;
+        Packed[i].Entry.Name = static_cast<UINT>( StringSize );
+        Offset = AlignArchiveOffset( Offset + Packed[i].Entry.Size );
+        StringSize += Packed[i].Key.size() + 1;
+    }
+
+    AssetArchiveHeader Header;
+    memset( ( VOID* )&Header, 0, sizeof( Header ) );
+    Header.Magic = AssetArchiveMagic;
+    Header.Version = AssetArchiveVersion;
+    Header.EntryCount = static_cast<UINT>( Packed.size() );
+    Header.EntryOffset = Offset;
+    Header.StringOffset = Offset + Packed.size() * sizeof( AssetArchiveEntry );
+    Header.StringSize = StringSize;
+    Header.FileSize = Header.StringOffset + StringSize;
+
+    pImage->assign( static_cast<size_t>( Header.FileSize ), 0 );
+    BYTE* pData = &( *pImage )[0];
+    memcpy( pData, &Header, sizeof( Header ) );
+
+    for( size_t i = 0; i < Packed.size(); i++ )
+    {
+        const PackedEntry& Item = Packed[i];
+        const std::vector<BYTE>& Blob = Item.Entry.Compression == AssetStored ? Sources[Item.Source].Data : Item.Compressed;
+        if( !Blob.empty() )
+            memcpy( pData + Item.Entry.Offset, &Blob[0], Blob.size() );
+
+        memcpy( pData + Header.EntryOffset + i * sizeof( AssetArchiveEntry ), &Item.Entry, sizeof( AssetArchiveEntry ) );
+        memcpy( pData + Header.StringOffset + Item.Entry.Name, Item.Key.c_str(), Item.Key.size() + 1 );
+    }
+
+    return TRUE;
+}
+
+}; // namespace
@@ -0,0 +1,159 @@
+//-------------------------------------------------------------------------------------
+// AssetArchive.h
+//
+// One file holding many assets (compiled shaders, meshes, textures) so a
+// start opens and maps a single file instead of thousands of loose ones.
+//
+// Layout (little endian; the blobs and the table are aligned to
+// AssetArchiveAlignment bytes from the start of the file, so a blob is as
+// aligned in the mapping as a buffer from the heap):
+//
+//   AssetArchiveHeader
+//   blobs           one per entry, stored or LZ4 compressed
+//   entries         EntryCount AssetArchiveEntry, sorted by NameHash
+//   strings         NUL terminated entry names, referenced by offset
+//
+// An entry is found by the 64-bit hash of its name, with a binary search of
+// the sorted table, and then by comparing the name itself. Names are asset
+// paths relative to the packed directory, normalized by MakeAssetKey:
+// slashes, no "." or "dir/.." segments, lower case, so lookups behave like
+// the case insensitive file system the demos run on.
+//
+// A stored entry is handed out as a view into the mapping, without a copy.
+// An LZ4 entry (the LZ4 block format, one block per entry) has to be
+// extracted into memory first; the packer only keeps compression where it
+// saves enough, and is told not to compress the assets meant to be used in
+// place.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _ASSET_ARCHIVE_H_
+#define _ASSET_ARCHIVE_H_
+
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+namespace XNA
+{
+
+static const UINT AssetArchiveMagic = 0x4b415058;       // "XPAK"
+static const UINT AssetArchiveVersion = 1;
+static const UINT AssetArchiveAlignment = 64;
+
+enum AssetCompression
+{
+    AssetStored = 0,
+    AssetLz4 = 1,
+};
+
+struct AssetArchiveHeader
+{
+    UINT Magic;
+    UINT Version;
+    UINT EntryCount;
+    UINT Reserved;
+    UINT64 FileSize;
+    UINT64 EntryOffset;
+    UINT64 StringOffset;
+    UINT64 StringSize;
+};
+
+struct AssetArchiveEntry
+{
+    UINT64 NameHash;            // HashAssetKey of the name.
+    UINT64 Offset;              // Of the blob, from the start of the archive.
+    UINT64 Size;                // Bytes in the archive.
+    UINT64 OriginalSize;        // Bytes once extracted; Size if stored.
+    UINT64 ContentHash;         // ComputeContentHash of the original bytes.
+    UINT Name;                  // Offset in the string section.
+    UINT Compression;           // AssetCompression.
+};
+
+//-----------------------------------------------------------------------------
+// A mapped archive.
+//-----------------------------------------------------------------------------
+class AssetArchive
+{
+public:
+    AssetArchive();
+    ~AssetArchive();
+
+    // Maps an archive and checks its header and table: every blob and name
+    // inside the file, the entries sorted. Returns FALSE otherwise.
+    BOOL Open( const char* FileName );
+    VOID Close();
+
+    BOOL IsOpen() const;
+    UINT GetEntryCount() const;
+    const AssetArchiveEntry* GetEntries() const;
+    const char* GetName( UINT Index ) const;
+
+    // Index of the entry of an asset path (normalized by MakeAssetKey).
+    BOOL Find( const char* Name, UINT* pIndex ) const;
+
+    // Bytes of a stored entry in the mapping. FALSE for a compressed one.
+    BOOL GetView( UINT Index, const BYTE** ppData, size_t* pSize ) const;
+
+    // Find and GetView.
+    BOOL GetFile( const char* Name, const BYTE** ppData, size_t* pSize ) const;
+
+    // Copies or decompresses an entry. Returns FALSE if the compressed data
+    // is corrupt.
+    BOOL Extract( UINT Index, std::vector<BYTE>* pOut ) const;
+
+private:
+    AssetArchive( const AssetArchive& rhs );
+    AssetArchive& operator=( const AssetArchive& rhs );
+
+private:
+    MappedFile m_File;
+    const AssetArchiveHeader* m_pHeader;
+    const AssetArchiveEntry* m_pEntries;
+    const char* m_pStrings;
+};
+
+//-----------------------------------------------------------------------------
+// Packing.
+//-----------------------------------------------------------------------------
+struct AssetArchiveSource
+{
+    std::string Name;           // Asset path; stored as MakeAssetKey( Name ).
+    std::vector<BYTE> Data;
+    UINT Compression;           // AssetCompression wanted for this entry.
+};
+
+// Archive image of the sources. LZ4 is only kept for an entry when it saves
+// at least 1/MinSavingFraction of its size; otherwise it is stored. Returns
+// FALSE if two sources have the same name.
+BOOL BuildAssetArchive( const std::vector<AssetArchiveSource>& Sources, std::vector<BYTE>* pImage,
+                        UINT MinSavingFraction = 8 );
+
+// Path with backslashes turned into slashes, without "." and "dir/.."
+// segments or repeated separators.
+std::string NormalizeAssetPath( const char* Path );
+
+// NormalizeAssetPath in ASCII lower case: the name of an asset in an archive.
+std::string MakeAssetKey( const char* Path );
+
+UINT64 HashAssetKey( const std::string& Key );
+
+//-----------------------------------------------------------------------------
+// LZ4 block format, without the frame around it.
+//-----------------------------------------------------------------------------
+
+// Largest compressed size of Size bytes.
+size_t GetLz4CompressBound( size_t Size );
+
+// Compresses into pDst and returns the compressed size, 0 if it does not fit
+// in DstCapacity.
+size_t CompressLz4Block( const BYTE* pSrc, size_t SrcSize, BYTE* pDst, size_t DstCapacity );
+
+// Decompresses exactly DstSize bytes. Returns FALSE on corrupt input, which
+// is never read or written out of bounds.
+BOOL DecompressLz4Block( const BYTE* pSrc, size_t SrcSize, BYTE* pDst, size_t DstSize );
+
+}; // namespace
+
+#endif
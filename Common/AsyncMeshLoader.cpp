@@ -0,0 +1,202 @@
+//-------------------------------------------------------------------------------------
+// AsyncMeshLoader.cpp
+//
+// Worker threads and completion queue of the asynchronous mesh loads.
+//-------------------------------------------------------------------------------------
+
+#include "AsyncMeshLoader.h"
+#include "ParallelFor.h"
+
+namespace XNA
+{
+
+static inline DOUBLE ElapsedMilliseconds( std::chrono::high_resolution_clock::time_point From,
+                                          std::chrono::high_resolution_clock::time_point To )
+{
+    return std::chrono::duration<DOUBLE, std::milli>( To - From ).count();
+}
+
+
+
+AsyncMeshLoader::AsyncMeshLoader()
+    : m_pLoad( NULL ),
+      m_pContext( NULL ),
+      m_LoadThreadCount( 1 ),
+      m_Loading( 0 ),
+      m_NextHandle( 1 ),
+      m_Stopping( FALSE )
+{
+}
+
+
+
+AsyncMeshLoader::~AsyncMeshLoader()
+{
+    Stop();
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID AsyncMeshLoader::Start( MeshLoadFunction pLoad, VOID* pContext, UINT WorkerCount )
+{
+    XMASSERT( pLoad );
+
+    Stop();
+
+    UINT HardwareThreads = GetWorkerThreadCount();
+    if( WorkerCount == 0 )
+        WorkerCount = ( std::max )( HardwareThreads / 2, 1u );
+
+    m_pLoad = pLoad;
+    m_pContext = pContext;
+    m_LoadThreadCount = ( std::max )( HardwareThreads / WorkerCount, 1u );
+
+    m_Workers.reserve( WorkerCount );
+    for( UINT i = 0; i < WorkerCount; i++ )
+        m_Workers.push_back( std::thread( &AsyncMeshLoader::WorkerMain, this ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID AsyncMeshLoader::Stop()
+{
+    {
+        std::lock_guard<std::mutex> Lock( m_Mutex );
+        m_Stopping = TRUE;
+        m_Requests.clear();
+    }
+    m_Wake.notify_all();
+
+    for( size_t i = 0; i < m_Workers.size(); i++ )
+        m_Workers[i].join();
+    m_Workers.clear();
+
+    std::lock_guard<std::mutex> Lock( m_Mutex );
+    m_Completed.clear();
+    m_Stopping = FALSE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+MeshLoadHandle AsyncMeshLoader::Request( const char* FileName )
+{
+    XMASSERT( FileName );
+
+    if( m_Workers.empty() )
+        return 0;
+
+    PendingRequest Pending;
+    Pending.FileName = FileName;
+    Pending.Queued = Clock::now();
+
+    {
+        std::lock_guard<std::mutex> Lock( m_Mutex );
+        Pending.Handle = m_NextHandle++;
+        if( m_NextHandle == 0 )
+            m_NextHandle = 1;
+        m_Requests.push_back( Pending );
+    }
+    m_Wake.notify_one();
+
+    return Pending.Handle;
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT AsyncMeshLoader::DrainCompleted( std::vector<MeshLoadResult>* pOut, UINT MaxCount )
+{
+    XMASSERT( pOut );
+
+    std::lock_guard<std::mutex> Lock( m_Mutex );
+
+    Clock::time_point Now = Clock::now();
+    UINT Count = 0;
+    while( Count < MaxCount && !m_Completed.empty() )
+    {
+        CompletedLoad& Completed = m_Completed.front();
+        Completed.Result.QueueMilliseconds = ElapsedMilliseconds( Completed.Finished, Now );
+        pOut->push_back( std::move( Completed.Result ) );
+        m_Completed.pop_front();
+        Count++;
+    }
+
+    return Count;
+}
+
+
+
+UINT AsyncMeshLoader::GetQueueDepth() const
+{
+    std::lock_guard<std::mutex> Lock( m_Mutex );
+    return static_cast<UINT>( m_Requests.size() );
+}
+
+
+
+UINT AsyncMeshLoader::GetCompletedCount() const
+{
+    std::lock_guard<std::mutex> Lock( m_Mutex );
+    return static_cast<UINT>( m_Completed.size() );
+}
+
+
+
+UINT AsyncMeshLoader::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> Lock( m_Mutex );
+    return static_cast<UINT>( m_Requests.size() + m_Completed.size() ) + m_Loading;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Takes the oldest request, loads it outside the lock and appends the result
+// to the completion queue, until Stop.
+//-----------------------------------------------------------------------------
+VOID AsyncMeshLoader::WorkerMain()
+{
+    std::unique_lock<std::mutex> Lock( m_Mutex );
+
+    for( ;; )
+    {
+        while( !m_Stopping && m_Requests.empty() )
+            m_Wake.wait( Lock );
+
+        if( m_Stopping )
+            return;
+
+        PendingRequest Pending = m_Requests.front();
+        m_Requests.pop_front();
+        m_Loading++;
+        Lock.unlock();
+
+        CompletedLoad Completed;
+        Completed.Result.Handle = Pending.Handle;
+        Completed.Result.FileName = Pending.FileName;
+
+        Clock::time_point Started = Clock::now();
+        std::shared_ptr<MeshCache> Cache( new MeshCache );
+        Completed.Result.Succeeded = m_pLoad( Pending.FileName.c_str(), m_LoadThreadCount, &Completed.Result.Mesh,
+                                              Cache.get(), m_pContext );
+        if( !Completed.Result.Succeeded )
+            Completed.Result.Mesh = ImportedMesh();
+        else if( Cache->IsOpen() )
+            Completed.Result.Cache = Cache;
+        Completed.Finished = Clock::now();
+
+        Completed.Result.WaitMilliseconds = ElapsedMilliseconds( Pending.Queued, Started );
+        Completed.Result.LoadMilliseconds = ElapsedMilliseconds( Started, Completed.Finished );
+        Completed.Result.QueueMilliseconds = 0.0;
+
+        Lock.lock();
+        m_Loading--;
+        if( !m_Stopping )
+            m_Completed.push_back( std::move( Completed ) );
+    }
+}
+
+}; // namespace
@@ -0,0 +1,135 @@
+//-------------------------------------------------------------------------------------
+// AsyncMeshLoader.h
+//
+// Loads mesh files on worker threads so the frame loop never waits for a
+// parse. Request returns a handle at once; the file is read and converted to
+// an ImportedMesh by a worker, and the finished mesh goes into a completion
+// queue. The main thread drains that queue once per frame (UpdateScene) and
+// creates the GPU buffers there, since the immediate context is not free
+// threaded. Until its mesh comes out of the queue, the caller draws whatever
+// placeholder it likes.
+//
+// How a file is loaded is up to the caller (OBJ through the mesh cache, the
+// other formats through Assimp); the loader only owns the threads and the two
+// queues. Every result carries how long it waited for a worker and how long
+// the load itself took, and the depth of both queues can be read at any time.
+//
+// A load may leave the vertices and indices in a mapped mesh cache instead of
+// copying them into the ImportedMesh; the result then keeps the cache open
+// until the caller has created its buffers from the mapping.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _ASYNC_MESH_LOADER_H_
+#define _ASYNC_MESH_LOADER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <memory>
+#include <vector>
+#include "ImportedMesh.h"
+#include "MeshCache.h"
+
+namespace XNA
+{
+
+// 0 is never a valid handle.
+typedef UINT MeshLoadHandle;
+
+// Loads FileName into pOut on a worker thread. ThreadCount is the share of
+// the hardware threads this load may use for its own parallel work. A load
+// that opens *pCache and leaves the vertices and indices there hands the
+// cache over with the result.
+typedef BOOL ( *MeshLoadFunction )( const char* FileName, UINT ThreadCount, ImportedMesh* pOut, MeshCache* pCache,
+                                    VOID* pContext );
+
+struct MeshLoadResult
+{
+    MeshLoadHandle Handle;
+    std::string FileName;
+    BOOL Succeeded;             // FALSE leaves Mesh empty.
+    ImportedMesh Mesh;
+    std::shared_ptr<const MeshCache> Cache;     // Set if the vertices and indices are there, not in Mesh.
+    DOUBLE WaitMilliseconds;    // From Request until a worker took it.
+    DOUBLE LoadMilliseconds;    // Parse and conversion on the worker.
+    DOUBLE QueueMilliseconds;   // From the end of the load until it was drained.
+};
+
+//-----------------------------------------------------------------------------
+// Worker threads with a request queue and a completion queue.
+//-----------------------------------------------------------------------------
+class AsyncMeshLoader
+{
+public:
+    AsyncMeshLoader();
+    ~AsyncMeshLoader();
+
+    // Starts WorkerCount threads (0: half the hardware threads, at least 1)
+    // calling pLoad for each request. Every load gets an equal share of the
+    // hardware threads, so concurrent loads do not oversubscribe the CPU.
+    VOID Start( MeshLoadFunction pLoad, VOID* pContext, UINT WorkerCount = 0 );
+
+    // Waits for the loads in progress and drops the requests no worker has
+    // taken yet and the results not drained yet. Called by the destructor.
+    VOID Stop();
+
+    // Queues a file and returns at once; 0 if the loader is not started.
+    MeshLoadHandle Request( const char* FileName );
+
+    // Moves up to MaxCount finished loads, oldest first, to the end of pOut.
+    // Meant for the main thread, once per frame; MaxCount spreads the buffer
+    // uploads of many assets over several frames. Returns how many it moved.
+    UINT DrainCompleted( std::vector<MeshLoadResult>* pOut, UINT MaxCount = 0xffffffff );
+
+    // Requests no worker has taken yet.
+    UINT GetQueueDepth() const;
+
+    // Finished loads waiting to be drained.
+    UINT GetCompletedCount() const;
+
+    // Requests not drained yet: queued, loading or finished.
+    UINT GetPendingCount() const;
+
+private:
+    typedef std::chrono::high_resolution_clock Clock;
+
+    struct PendingRequest
+    {
+        MeshLoadHandle Handle;
+        std::string FileName;
+        Clock::time_point Queued;
+    };
+
+    struct CompletedLoad
+    {
+        MeshLoadResult Result;
+        Clock::time_point Finished;
+    };
+
+    VOID WorkerMain();
+
+    AsyncMeshLoader( const AsyncMeshLoader& rhs );
+    AsyncMeshLoader& operator=( const AsyncMeshLoader& rhs );
+
+private:
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Wake;
+    std::deque<PendingRequest> m_Requests;
+    std::deque<CompletedLoad> m_Completed;
+    std::vector<std::thread> m_Workers;
+    MeshLoadFunction m_pLoad;
+    VOID* m_pContext;
+    UINT m_LoadThreadCount;
+    UINT m_Loading;
+    MeshLoadHandle m_NextHandle;
+    BOOL m_Stopping;
+};
+
+}; // namespace
+
+#endif
@@ -8,10 +8,25 @@ Batch::Batch( ID3D11Device** device, ID3D11DeviceContext** deviceContext, ID3D11
 	m_deviceContext( deviceContext ),
 	m_vb( vertexBuffer ),
 	m_ib( indexBuffer ),
-	m_indexCount( indexCount ),
 	m_stride( stride ),
-	m_offset( offset ),
-	mMaterial( material )
+	m_offset( offset )
+{
+	BatchSubmesh submesh;
+	submesh.startIndex = 0;
+	submesh.indexCount = indexCount;
+	submesh.baseVertex = 0;
+	submesh.material = material;
+	m_submeshes.push_back( submesh );
+}
+
+Batch::Batch( ID3D11Device** device, ID3D11DeviceContext** deviceContext, ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer, const std::vector<BatchSubmesh>& submeshes, UINT stride, UINT offset ) :
+	m_device( device ),
+	m_deviceContext( deviceContext ),
+	m_vb( vertexBuffer ),
+	m_ib( indexBuffer ),
+	m_submeshes( submeshes ),
+	m_stride( stride ),
+	m_offset( offset )
 {
 
 }
@@ -43,9 +58,6 @@ void Batch::Draw( const XMMATRIX& worldMatrix, const XMMATRIX& wvmMatrix, Consta
 	XMStoreFloat4x4( &constants.m_World, worldTransposed );
 	XMStoreFloat4x4( &constants.m_WorldInvTranspose, worldInvTranspose );
 	XMStoreFloat4x4( &constants.m_WorldViewProj, wvmTransposed );
-	constants.mMaterial = mMaterial;
-	constantBuffer->Data = constants;
-	constantBuffer->ApplyChanges( *m_deviceContext );
 
 	auto buffer = constantBuffer->Buffer();
 	( *m_deviceContext )->VSSetConstantBuffers( 0, 1, &buffer );
@@ -57,6 +69,14 @@ void Batch::Draw( const XMMATRIX& worldMatrix, const XMMATRIX& wvmMatrix, Consta
 	// インデックスバッファのセット
 	( *m_deviceContext )->IASetIndexBuffer( m_ib, DXGI_FORMAT_R32_UINT, 0 );
 
-	// 描画
-	( *m_deviceContext )->DrawIndexed( m_indexCount, 0, 0 );
-}
\ No newline at end of file
+	// 描画: the buffers stay bound, only the material changes between submeshes
+	for ( size_t i = 0; i < m_submeshes.size(); i++ )
+	{
+		const BatchSubmesh& submesh = m_submeshes[i];
+		constants.mMaterial = submesh.material;
+		constantBuffer->Data = constants;
+		constantBuffer->ApplyChanges( *m_deviceContext );
+
+		( *m_deviceContext )->DrawIndexed( submesh.indexCount, submesh.startIndex, submesh.baseVertex );
+	}
+}
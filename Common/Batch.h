@@ -14,10 +14,22 @@ struct ConstantsPerObject
 	Material mMaterial;
 };
 
+// Range of the index buffer drawn with one material, as DrawIndexed takes it.
+struct BatchSubmesh
+{
+	UINT startIndex;
+	UINT indexCount;
+	INT baseVertex;
+	Material material;
+};
+
 class Batch
 {
 public:
 	Batch( ID3D11Device** device, ID3D11DeviceContext** deviceContext, ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer, UINT indexCount, UINT stride, UINT offset, Material material );
+
+	// Several submeshes in one vertex and index buffer, bound once per Draw.
+	Batch( ID3D11Device** device, ID3D11DeviceContext** deviceContext, ID3D11Buffer* vertexBuffer, ID3D11Buffer* indexBuffer, const std::vector<BatchSubmesh>& submeshes, UINT stride, UINT offset );
 	~Batch();
 
 	void Release();
@@ -31,9 +43,8 @@ private:
 	ID3D11Buffer* m_vb;
 	ID3D11Buffer* m_ib;
 
-	Material mMaterial;
+	std::vector<BatchSubmesh> m_submeshes;
 
-	UINT m_indexCount;
 	UINT m_stride;
 	UINT m_offset;
-};
\ No newline at end of file
+};
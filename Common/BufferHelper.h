@@ -14,16 +14,28 @@ public:
 			return false;
 		}
 
+		return CreateVertexBuffer( device, &( vertices[0] ), static_cast<UINT>( vertices.size() ), vertexBuffer );
+	}
+
+	// From memory the caller keeps, such as a mapped MeshCache: no copy on the CPU side.
+	static bool CreateVertexBuffer( ID3D11Device** device, const T* vertices, UINT count, ID3D11Buffer** vertexBuffer )
+	{
+		if ( count == 0 )
+		{
+
+			return false;
+		}
+
 		D3D11_BUFFER_DESC vbd;
 
 		vbd.Usage = D3D11_USAGE_IMMUTABLE;
-		vbd.ByteWidth = sizeof( T ) * vertices.size();
+		vbd.ByteWidth = sizeof( T ) * count;
 		vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 		vbd.CPUAccessFlags = 0;
 		vbd.MiscFlags = 0;
 
 		D3D11_SUBRESOURCE_DATA vinitData;
-		vinitData.pSysMem = &( vertices[0] );
+		vinitData.pSysMem = vertices;
 
 		HR( ( *device )->CreateBuffer( &vbd, &vinitData, vertexBuffer ) );
 
@@ -38,16 +50,27 @@ public:
 			return false;
 		}
 
+		return CreateIndexBuffer( device, &( indices[0] ), static_cast<UINT>( indices.size() ), indexBuffer );
+	}
+
+	static bool CreateIndexBuffer( ID3D11Device** device, const T* indices, UINT count, ID3D11Buffer** indexBuffer )
+	{
+		if ( count == 0 )
+		{
+
+			return false;
+		}
+
 		D3D11_BUFFER_DESC ibd;
 
 		ibd.Usage = D3D11_USAGE_IMMUTABLE;
-		ibd.ByteWidth = sizeof( T ) * indices.size();
+		ibd.ByteWidth = sizeof( T ) * count;
 		ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 		ibd.CPUAccessFlags = 0;
 		ibd.MiscFlags = 0;
 
 		D3D11_SUBRESOURCE_DATA iinitData;
-		iinitData.pSysMem = &( indices[0] );
+		iinitData.pSysMem = indices;
 
 		HR( ( *device )->CreateBuffer( &ibd, &iinitData, indexBuffer ) );
 
@@ -182,6 +182,25 @@ void Camera::Walk(float d)
 	XMStoreFloat3(&mPosition, XMVectorMultiplyAdd(s, l, p));
 }
 
+void Camera::Strafe(float d, const XNA::CollisionMesh& world, float radius)
+{
+	Move(XMVectorReplicate(d)*XMLoadFloat3(&mRight), world, radius);
+}
+
+void Camera::Walk(float d, const XNA::CollisionMesh& world, float radius)
+{
+	Move(XMVectorReplicate(d)*XMLoadFloat3(&mLook), world, radius);
+}
+
+void Camera::Move(FXMVECTOR displacement, const XNA::CollisionMesh& world, float radius)
+{
+	XNA::Sphere body;
+	body.Center = mPosition;
+	body.Radius = radius;
+
+	XMStoreFloat3(&mPosition, world.MoveSphere(&body, displacement));
+}
+
 void Camera::Pitch(float angle)
 {
 	// Rotate up and look vector about the right vector.
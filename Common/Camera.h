@@ -12,6 +12,7 @@
 #define CAMERA_H
 
 #include "d3dUtil.h"
+#include "CollisionMesh.h"
 
 class Camera
 {
@@ -62,6 +63,11 @@ public:
 	void Strafe(float d);
 	void Walk(float d);
 
+	// Strafe/Walk the camera a distance d, sliding along the triangles of world
+	// instead of passing through them. The camera is a sphere of the given radius.
+	void Strafe(float d, const XNA::CollisionMesh& world, float radius);
+	void Walk(float d, const XNA::CollisionMesh& world, float radius);
+
 	// Rotate the camera.
 	void Pitch(float angle);
 	void RotateY(float angle);
@@ -69,6 +75,9 @@ public:
 	// After modifying camera position/orientation, call to rebuild the view matrix.
 	void UpdateViewMatrix();
 
+private:
+	void Move(FXMVECTOR displacement, const XNA::CollisionMesh& world, float radius);
+
 private:
 
 	// Camera coordinate system with coordinates relative to world space.
@@ -0,0 +1,555 @@
+//-------------------------------------------------------------------------------------
+// CollisionMesh.cpp
+//
+// Swept sphere queries against a static triangle mesh.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "CollisionMesh.h"
+#include "ParallelFor.h"
+
+namespace XNA
+{
+
+// Deep enough for any tree built from a 32 bit triangle count: the median
+// split keeps the depth logarithmic, and the traversal pushes at most one node
+// per level.
+static const UINT MaxStackDepth = 64;
+
+// Distance MoveSphere keeps from the surfaces it stops at, relative to the
+// sphere radius, so the next sweep does not start in contact.
+static const FLOAT SkinFraction = 0.01f;
+
+// Movers per ParallelFor task.
+static const UINT MinSpheresPerTask = 16;
+
+
+
+static inline FLOAT GetComponent( const XMFLOAT3& v, UINT Axis )
+{
+    return ( &v.x )[Axis];
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Entry time of the center moving from Origin by Displacement (as
+// InvDisplacement, its reciprocal) into the box grown by Grow in every
+// direction. Returns FALSE if it misses the box within [0, MaxTime].
+//-----------------------------------------------------------------------------
+static inline BOOL SweepPointBox( FXMVECTOR Origin, FXMVECTOR InvDisplacement, FXMVECTOR Grow, const XMFLOAT3& Min,
+                                  const XMFLOAT3& Max, FLOAT MaxTime, FLOAT* pTime )
+{
+    XMVECTOR T1 = ( XMLoadFloat3( &Min ) - Grow - Origin ) * InvDisplacement;
+    XMVECTOR T2 = ( XMLoadFloat3( &Max ) + Grow - Origin ) * InvDisplacement;
+
+    XMVECTOR TNear = XMVectorMin( T1, T2 );
+    XMVECTOR TFar = XMVectorMax( T1, T2 );
+
+    TNear = XMVectorMax( XMVectorMax( XMVectorSplatX( TNear ), XMVectorSplatY( TNear ) ), XMVectorSplatZ( TNear ) );
+    TFar = XMVectorMin( XMVectorMin( XMVectorSplatX( TFar ), XMVectorSplatY( TFar ) ), XMVectorSplatZ( TFar ) );
+
+    FLOAT Near = XMVectorGetX( TNear );
+    FLOAT Far = XMVectorGetX( TFar );
+
+    if( Near > Far || Far < 0.0f || Near > MaxTime )
+        return FALSE;
+
+    *pTime = Near;
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Squared distance from Point to the box, 0 inside.
+//-----------------------------------------------------------------------------
+static inline FLOAT PointBoxDistanceSq( FXMVECTOR Point, const XMFLOAT3& Min, const XMFLOAT3& Max )
+{
+    XMVECTOR Clamped = XMVectorMin( XMVectorMax( Point, XMLoadFloat3( &Min ) ), XMLoadFloat3( &Max ) );
+    return XMVectorGetX( XMVector3LengthSq( Point - Clamped ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Point of the triangle nearest P (Ericson, Real-Time Collision Detection
+// 5.1.5), and which corner, edge or inside of the triangle it is on, numbered
+// as ClosestHit::Feature.
+//-----------------------------------------------------------------------------
+static XMVECTOR ClosestPointOnTriangle( FXMVECTOR P, FXMVECTOR A, FXMVECTOR B, CXMVECTOR C, UINT* pFeature )
+{
+    XMVECTOR AB = B - A;
+    XMVECTOR AC = C - A;
+    XMVECTOR AP = P - A;
+
+    FLOAT D1 = XMVectorGetX( XMVector3Dot( AB, AP ) );
+    FLOAT D2 = XMVectorGetX( XMVector3Dot( AC, AP ) );
+    if( D1 <= 0.0f && D2 <= 0.0f )
+    {
+        *pFeature = 0;
+        return A;
+    }
+
+    XMVECTOR BP = P - B;
+    FLOAT D3 = XMVectorGetX( XMVector3Dot( AB, BP ) );
+    FLOAT D4 = XMVectorGetX( XMVector3Dot( AC, BP ) );
+    if( D3 >= 0.0f && D4 <= D3 )
+    {
+        *pFeature = 1;
+        return B;
+    }
+
+    FLOAT VC = D1 * D4 - D3 * D2;
+    if( VC <= 0.0f && D1 >= 0.0f && D3 <= 0.0f )
+    {
+        *pFeature = 3;
+        return A + AB * ( D1 / ( D1 - D3 ) );
+    }
+
+    XMVECTOR CP = P - C;
+    FLOAT D5 = XMVectorGetX( XMVector3Dot( AB, CP ) );
+    FLOAT D6 = XMVectorGetX( XMVector3Dot( AC, CP ) );
+    if( D6 >= 0.0f && D5 <= D6 )
+    {
+        *pFeature = 2;
+        return C;
+    }
+
+    FLOAT VB = D5 * D2 - D1 * D6;
+    if( VB <= 0.0f && D2 >= 0.0f && D6 <= 0.0f )
+    {
+        *pFeature = 5;
+        return A + AC * ( D2 / ( D2 - D6 ) );
+    }
+
+    FLOAT VA = D3 * D6 - D5 * D4;
+    if( VA <= 0.0f && ( D4 - D3 ) >= 0.0f && ( D5 - D6 ) >= 0.0f )
+    {
+        *pFeature = 4;
+        return B + ( C - B ) * ( ( D4 - D3 ) / ( ( D4 - D3 ) + ( D5 - D6 ) ) );
+    }
+
+    // Degenerate triangles end up here with a zero denominator; any of their
+    // corners will do.
+    FLOAT Denominator = VA + VB + VC;
+    if( Denominator <= 0.0f )
+    {
+        *pFeature = 0;
+        return A;
+    }
+
+    *pFeature = 6;
+    FLOAT InvDenominator = 1.0f / Denominator;
+    return A + AB * ( VB * InvDenominator ) + AC * ( VC * InvDenominator );
+}
+
+
+
+//-----------------------------------------------------------------------------
+CollisionMesh::CollisionMesh( UINT LeafSize ) :
+    m_LeafSize( LeafSize ? LeafSize : 1 )
+{
+}
+
+
+
+CollisionMesh::~CollisionMesh()
+{
+}
+
+
+
+UINT CollisionMesh::GetTriangleCount() const
+{
+    return UINT( m_Triangles.size() );
+}
+
+
+
+UINT CollisionMesh::GetNodeCount() const
+{
+    return UINT( m_Nodes.size() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Build the subtree of m_TriangleIds[First, First + Count) and return its
+// node, with pTriangles and pCentroids indexed by triangle.
+//-----------------------------------------------------------------------------
+UINT CollisionMesh::BuildNode( const Triangle* pTriangles, const XMFLOAT3* pCentroids, UINT First, UINT Count )
+{
+    UINT NodeId = UINT( m_Nodes.size() );
+    m_Nodes.push_back( Node() );
+
+    XMVECTOR Min = XMVectorReplicate( FLT_MAX );
+    XMVECTOR Max = XMVectorReplicate( -FLT_MAX );
+    XMVECTOR CentroidMin = Min;
+    XMVECTOR CentroidMax = Max;
+
+    for( UINT i = First; i < First + Count; i++ )
+    {
+        UINT Id = m_TriangleIds[i];
+        const Triangle& T = pTriangles[Id];
+
+        XMVECTOR V0 = XMLoadFloat3( &T.V0 );
+        XMVECTOR V1 = XMLoadFloat3( &T.V1 );
+        XMVECTOR V2 = XMLoadFloat3( &T.V2 );
+        Min = XMVectorMin( Min, XMVectorMin( V0, XMVectorMin( V1, V2 ) ) );
+        Max = XMVectorMax( Max, XMVectorMax( V0, XMVectorMax( V1, V2 ) ) );
+
+        XMVECTOR Centroid = XMLoadFloat3( &pCentroids[Id] );
+        CentroidMin = XMVectorMin( CentroidMin, Centroid );
+        CentroidMax = XMVectorMax( CentroidMax, Centroid );
+    }
+
+    Node& N = m_Nodes[NodeId];
+    XMStoreFloat3( &N.Min, Min );
+    XMStoreFloat3( &N.Max, Max );
+    N.First = First;
+    N.Count = Count;
+    N.SecondChild = 0;
+
+    if( Count <= m_LeafSize )
+        return NodeId;
+
+    // Split at the median of the centroids along their longest axis.
+    XMFLOAT3 Size;
+    XMStoreFloat3( &Size, CentroidMax - CentroidMin );
+
+    UINT Axis = 0;
+    if( Size.y > GetComponent( Size, Axis ) )
+        Axis = 1;
+    if( Size.z > GetComponent( Size, Axis ) )
+        Axis = 2;
+
+    UINT Half = Count / 2;
+    UINT* pIds = m_TriangleIds.data();
+
+    std::nth_element( pIds + First, pIds + First + Half, pIds + First + Count, [&]( UINT a, UINT b )
+    {
+        return GetComponent( pCentroids[a], Axis ) < GetComponent( pCentroids[b], Axis );
+    } );
+
+    BuildNode( pTriangles, pCentroids, First, Half );
+    UINT SecondChild = BuildNode( pTriangles, pCentroids, First + Half, Count - Half );
+
+    // m_Nodes may have been reallocated.
+    m_Nodes[NodeId].SecondChild = SecondChild;
+
+    return NodeId;
+}
+
+
+
+VOID CollisionMesh::Build( const XMFLOAT3* pPositions, UINT Stride, const UINT* pIndices, UINT TriangleCount )
+{
+    XMASSERT( pPositions || TriangleCount == 0 );
+    XMASSERT( pIndices || TriangleCount == 0 );
+    XMASSERT( Stride >= sizeof( XMFLOAT3 ) );
+
+    const BYTE* pBytes = reinterpret_cast<const BYTE*>( pPositions );
+
+    std::vector<Triangle> Triangles( TriangleCount );
+    std::vector<XMFLOAT3> Centroids( TriangleCount );
+
+    for( UINT i = 0; i < TriangleCount; i++ )
+    {
+        Triangle& T = Triangles[i];
+        T.V0 = *reinterpret_cast<const XMFLOAT3*>( pBytes + size_t( pIndices[3 * i] ) * Stride );
+        T.V1 = *reinterpret_cast<const XMFLOAT3*>( pBytes + size_t( pIndices[3 * i + 1] ) * Stride );
+        T.V2 = *reinterpret_cast<const XMFLOAT3*>( pBytes + size_t( pIndices[3 * i + 2] ) * Stride );
+
+        XMVECTOR V0 = XMLoadFloat3( &T.V0 );
+        XMVECTOR V1 = XMLoadFloat3( &T.V1 );
+        XMVECTOR V2 = XMLoadFloat3( &T.V2 );
+
+        // Degenerate triangles get a zero plane (the normal of a zero vector is
+        // zero), which never rejects them.
+        XMVECTOR N = XMVector3Normalize( XMVector3Cross( V1 - V0, V2 - V0 ) );
+        XMStoreFloat4( &T.Plane, XMVectorSetW( N, -XMVectorGetX( XMVector3Dot( N, V0 ) ) ) );
+
+        XMStoreFloat3( &Centroids[i], ( V0 + V1 + V2 ) * ( 1.0f / 3.0f ) );
+    }
+
+    m_Nodes.clear();
+    m_TriangleIds.resize( TriangleCount );
+    for( UINT i = 0; i < TriangleCount; i++ )
+        m_TriangleIds[i] = i;
+
+    if( TriangleCount > 0 )
+    {
+        m_Nodes.reserve( 2 * ( TriangleCount / m_LeafSize + 1 ) );
+        BuildNode( Triangles.data(), Centroids.data(), 0, TriangleCount );
+    }
+
+    m_Triangles.resize( TriangleCount );
+    for( UINT i = 0; i < TriangleCount; i++ )
+        m_Triangles[i] = Triangles[m_TriangleIds[i]];
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL CollisionMesh::SweepSphere( const Sphere* pVolume, FXMVECTOR Displacement, SweepHit* pHit ) const
+{
+    XMASSERT( pVolume );
+    XMASSERT( pHit );
+
+    if( m_Nodes.empty() )
+        return FALSE;
+
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    FLOAT Radius = pVolume->Radius;
+    XMVECTOR Grow = XMVectorReplicate( Radius );
+
+    // Components too small to invert are nudged so the slab products stay
+    // finite; the slabs they give are just very wide.
+    static const XMVECTOR Tiny =
+    {
+        1e-20f, 1e-20f, 1e-20f, 1e-20f
+    };
+    XMVECTOR InvDisplacement = XMVectorReciprocal(
+        XMVectorSelect( Displacement, Tiny, XMVectorLess( XMVectorAbs( Displacement ), Tiny ) ) );
+
+    FLOAT BestTime = 1.0f;
+    XMVECTOR BestNormal = XMVectorZero();
+    UINT BestTriangle = 0;
+    BOOL Hit = FALSE;
+
+    UINT Stack[MaxStackDepth];
+    UINT StackSize = 0;
+
+    FLOAT Time;
+    if( SweepPointBox( Center, InvDisplacement, Grow, m_Nodes[0].Min, m_Nodes[0].Max, BestTime, &Time ) )
+        Stack[StackSize++] = 0;
+
+    while( StackSize > 0 )
+    {
+        const Node& N = m_Nodes[Stack[--StackSize]];
+
+        if( N.SecondChild == 0 )
+        {
+            for( UINT i = N.First; i < N.First + N.Count; i++ )
+            {
+                const Triangle& T = m_Triangles[i];
+
+                // Skip the triangle if the sphere stays on one side of its plane,
+                // farther than the radius, until the best contact so far.
+                XMVECTOR Plane = XMLoadFloat4( &T.Plane );
+                FLOAT Start = XMVectorGetX( XMVector3Dot( Plane, Center ) ) + T.Plane.w;
+                FLOAT End = Start + BestTime * XMVectorGetX( XMVector3Dot( Plane, Displacement ) );
+                if( ( std::min )( Start, End ) > Radius || ( std::max )( Start, End ) < -Radius )
+                    continue;
+
+                XMVECTOR Normal;
+                if( IntersectSweptSphereTriangle( pVolume, Displacement, XMLoadFloat3( &T.V0 ), XMLoadFloat3( &T.V1 ),
+                                                  XMLoadFloat3( &T.V2 ), &Time, &Normal ) &&
+                    ( !Hit || Time < BestTime ) )
+                {
+                    BestTime = Time;
+                    BestNormal = Normal;
+                    BestTriangle = i;
+                    Hit = TRUE;
+                }
+            }
+            continue;
+        }
+
+        // Visit the child the sphere enters first first; it is pushed last.
+        UINT First = UINT( &N - &m_Nodes[0] ) + 1;
+        UINT Second = N.SecondChild;
+
+        FLOAT FirstTime, SecondTime;
+        BOOL HitFirst = SweepPointBox( Center, InvDisplacement, Grow, m_Nodes[First].Min, m_Nodes[First].Max,
+                                       BestTime, &FirstTime );
+        BOOL HitSecond = SweepPointBox( Center, InvDisplacement, Grow, m_Nodes[Second].Min, m_Nodes[Second].Max,
+                                        BestTime, &SecondTime );
+
+        if( HitFirst && HitSecond )
+        {
+            XMASSERT( StackSize + 2 <= MaxStackDepth );
+            if( FirstTime <= SecondTime )
+            {
+                Stack[StackSize++] = Second;
+                Stack[StackSize++] = First;
+            }
+            else
+            {
+                Stack[StackSize++] = First;
+                Stack[StackSize++] = Second;
+            }
+        }
+        else if( HitFirst )
+        {
+            Stack[StackSize++] = First;
+        }
+        else if( HitSecond )
+        {
+            Stack[StackSize++] = Second;
+        }
+    }
+
+    if( !Hit )
+        return FALSE;
+
+    pHit->Time = BestTime;
+    XMStoreFloat3( &pHit->Normal, BestNormal );
+    pHit->Triangle = m_TriangleIds[BestTriangle];
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Collide and slide: move to just before the contact, then continue with the
+// remaining displacement projected onto the contact plane.
+//-----------------------------------------------------------------------------
+XMVECTOR CollisionMesh::MoveSphere( const Sphere* pVolume, FXMVECTOR Displacement, UINT MaxIterations ) const
+{
+    XMASSERT( pVolume );
+
+    Sphere Moving = *pVolume;
+    XMVECTOR Center = XMLoadFloat3( &Moving.Center );
+    XMVECTOR Remaining = Displacement;
+    FLOAT Skin = SkinFraction * Moving.Radius;
+
+    for( UINT i = 0; i < MaxIterations; i++ )
+    {
+        FLOAT Length = XMVectorGetX( XMVector3Length( Remaining ) );
+        if( Length <= 0.0f )
+            break;
+
+        XMStoreFloat3( &Moving.Center, Center );
+
+        SweepHit Hit;
+        if( !SweepSphere( &Moving, Remaining, &Hit ) )
+            return Center + Remaining;
+
+        FLOAT Travel = ( std::max )( Hit.Time * Length - Skin, 0.0f );
+        Center += Remaining * ( Travel / Length );
+
+        XMVECTOR Normal = XMLoadFloat3( &Hit.Normal );
+        Remaining *= 1.0f - Hit.Time;
+        Remaining -= Normal * XMVector3Dot( Remaining, Normal );
+
+        // Stop rather than be pushed back out of a corner.
+        if( XMVectorGetX( XMVector3Dot( Remaining, Displacement ) ) <= 0.0f )
+            break;
+    }
+
+    return Center;
+}
+
+
+
+VOID CollisionMesh::MoveSpheres( Sphere* pVolumes, const XMFLOAT3* pDisplacements, UINT Count, UINT ThreadCount ) const
+{
+    XMASSERT( pVolumes || Count == 0 );
+    XMASSERT( pDisplacements || Count == 0 );
+
+    ParallelFor( Count, ThreadCount, MinSpheresPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT i = Begin; i < End; i++ )
+        {
+            XMVECTOR Center = MoveSphere( &pVolumes[i], XMLoadFloat3( &pDisplacements[i] ) );
+            XMStoreFloat3( &pVolumes[i].Center, Center );
+        }
+    } );
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL CollisionMesh::FindClosestPoint( FXMVECTOR Point, FLOAT MaxDistance, ClosestHit* pHit ) const
+{
+    XMASSERT( pHit );
+    XMASSERT( MaxDistance >= 0.0f );
+
+    if( m_Nodes.empty() )
+        return FALSE;
+
+    // Squared distance of the closest point so far, or the limit.
+    FLOAT BestSq = MaxDistance < FLT_MAX ? MaxDistance * MaxDistance : FLT_MAX;
+    FLOAT Best = MaxDistance;
+    XMVECTOR BestPoint = XMVectorZero();
+    UINT BestTriangle = 0;
+    UINT BestFeature = 0;
+    BOOL Hit = FALSE;
+
+    UINT Stack[MaxStackDepth];
+    UINT StackSize = 0;
+
+    if( PointBoxDistanceSq( Point, m_Nodes[0].Min, m_Nodes[0].Max ) <= BestSq )
+        Stack[StackSize++] = 0;
+
+    while( StackSize > 0 )
+    {
+        const Node& N = m_Nodes[Stack[--StackSize]];
+
+        // The node may have been pushed before a closer point was found.
+        if( PointBoxDistanceSq( Point, N.Min, N.Max ) > BestSq )
+            continue;
+
+        if( N.SecondChild == 0 )
+        {
+            for( UINT i = N.First; i < N.First + N.Count; i++ )
+            {
+                const Triangle& T = m_Triangles[i];
+
+                FLOAT PlaneDistance = XMVectorGetX( XMVector3Dot( XMLoadFloat4( &T.Plane ), Point ) ) + T.Plane.w;
+                if( fabsf( PlaneDistance ) > Best )
+                    continue;
+
+                UINT Feature;
+                XMVECTOR Nearest = ClosestPointOnTriangle( Point, XMLoadFloat3( &T.V0 ), XMLoadFloat3( &T.V1 ),
+                                                           XMLoadFloat3( &T.V2 ), &Feature );
+
+                FLOAT DistanceSq = XMVectorGetX( XMVector3LengthSq( Point - Nearest ) );
+                if( DistanceSq <= BestSq )
+                {
+                    BestSq = DistanceSq;
+                    Best = sqrtf( DistanceSq );
+                    BestPoint = Nearest;
+                    BestTriangle = i;
+                    BestFeature = Feature;
+                    Hit = TRUE;
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first; it is pushed last.
+        UINT First = UINT( &N - &m_Nodes[0] ) + 1;
+        UINT Second = N.SecondChild;
+
+        FLOAT FirstSq = PointBoxDistanceSq( Point, m_Nodes[First].Min, m_Nodes[First].Max );
+        FLOAT SecondSq = PointBoxDistanceSq( Point, m_Nodes[Second].Min, m_Nodes[Second].Max );
+
+        if( FirstSq > SecondSq )
+        {
+            std::swap( First, Second );
+            std::swap( FirstSq, SecondSq );
+        }
+
+        XMASSERT( StackSize + 2 <= MaxStackDepth );
+        if( SecondSq <= BestSq )
+            Stack[StackSize++] = Second;
+        if( FirstSq <= BestSq )
+            Stack[StackSize++] = First;
+    }
+
+    if( !Hit )
+        return FALSE;
+
+    XMStoreFloat3( &pHit->Point, BestPoint );
+    pHit->Distance = Best;
+    pHit->Triangle = m_TriangleIds[BestTriangle];
+    pHit->Feature = BestFeature;
+    return TRUE;
+}
+
+}; // namespace
@@ -0,0 +1,114 @@
+//-------------------------------------------------------------------------------------
+// CollisionMesh.h
+//
+// Static triangle mesh for moving spheres through level geometry: swept sphere
+// queries that return the time and normal of the first contact, and a slide
+// response that moves a sphere along the surfaces it runs into, as a first
+// person camera or a character controller does.
+//
+// The triangles are kept in a bounding volume hierarchy built top down with
+// median splits on the longest axis of the triangle centroids. A sweep walks
+// the nodes whose boxes, grown by the sphere radius, the moving center passes
+// through, nearer child first, and stops descending once a node is farther
+// than the closest contact found so far. The triangles of a leaf are stored
+// next to each other with their planes, so most of them are rejected by the
+// distance of the sweep to the plane before IntersectSweptSphereTriangle runs.
+// Closest point queries walk the same tree, nearer child first, skipping the
+// nodes farther than the closest point found so far.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _COLLISION_MESH_H_
+#define _COLLISION_MESH_H_
+
+#include <vector>
+#include "xnacollision.h"
+
+namespace XNA
+{
+
+struct SweepHit
+{
+    FLOAT Time;                 // Fraction of the displacement traveled, in [0, 1].
+    XMFLOAT3 Normal;            // Unit contact normal, pointing towards the sphere.
+    UINT Triangle;              // Index of the triangle in the Build arrays.
+};
+
+struct ClosestHit
+{
+    XMFLOAT3 Point;             // Nearest point on the mesh.
+    FLOAT Distance;
+    UINT Triangle;              // Index of the triangle in the Build arrays.
+    UINT Feature;               // 0 to 2 for the corners V0 to V2, 3 to 5 for the edges
+                                // V0V1, V1V2 and V2V0, 6 for the inside of the triangle.
+};
+
+class CollisionMesh
+{
+public:
+    // LeafSize is the largest number of triangles stored in a leaf.
+    CollisionMesh( UINT LeafSize = 4 );
+    ~CollisionMesh();
+
+    // Indexed triangle list: pIndices holds 3 * TriangleCount indices of
+    // positions Stride bytes apart.
+    VOID Build( const XMFLOAT3* pPositions, UINT Stride, const UINT* pIndices, UINT TriangleCount );
+
+    // First contact of the sphere moving along Displacement, see
+    // IntersectSweptSphereTriangle. Returns FALSE if it moves freely.
+    BOOL SweepSphere( const Sphere* pVolume, FXMVECTOR Displacement, SweepHit* pHit ) const;
+
+    // Center of the sphere after moving along Displacement: on contact the
+    // sphere stops a small distance short of the surface and the rest of the
+    // displacement, with the part into the surface removed, is tried again, at
+    // most MaxIterations times.
+    XMVECTOR MoveSphere( const Sphere* pVolume, FXMVECTOR Displacement, UINT MaxIterations = 4 ) const;
+
+    // MoveSphere for many spheres, moving the centers in place. ThreadCount 0
+    // uses every hardware thread.
+    VOID MoveSpheres( Sphere* pVolumes, const XMFLOAT3* pDisplacements, UINT Count, UINT ThreadCount = 0 ) const;
+
+    // Point of the mesh nearest Point, if it is within MaxDistance. Returns
+    // FALSE if there is none that close.
+    BOOL FindClosestPoint( FXMVECTOR Point, FLOAT MaxDistance, ClosestHit* pHit ) const;
+
+    UINT GetTriangleCount() const;
+    UINT GetNodeCount() const;
+
+private:
+    // Nodes are in depth first order: the first child of an inner node is the
+    // node right after it.
+    struct Node
+    {
+        XMFLOAT3 Min;
+        UINT First;             // First triangle of the subtree in m_Triangles.
+        XMFLOAT3 Max;
+        UINT Count;             // Number of triangles in the subtree.
+        UINT SecondChild;       // 0 for leaves.
+    };
+
+    struct Triangle
+    {
+        XMFLOAT3 V0, V1, V2;
+        XMFLOAT4 Plane;         // Unit normal and distance.
+    };
+
+    UINT BuildNode( const Triangle* pTriangles, const XMFLOAT3* pCentroids, UINT First, UINT Count );
+
+    CollisionMesh( const CollisionMesh& rhs );
+    CollisionMesh& operator=( const CollisionMesh& rhs );
+
+private:
+    UINT m_LeafSize;
+
+    std::vector<Node> m_Nodes;
+
+    // Triangles in tree order, and their indices in the Build arrays.
+    std::vector<Triangle> m_Triangles;
+    std::vector<UINT> m_TriangleIds;
+};
+
+}; // namespace
+
+#endif
@@ -0,0 +1,965 @@
+//-------------------------------------------------------------------------------------
+// ConvexCollision.cpp
+//
+// GJK and EPA over support mapped convex shapes.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "ConvexCollision.h"
+
+namespace XNA
+{
+
+static const UINT MaxGjkIterations = 64;
+static const UINT MaxEpaIterations = 64;
+
+// Every EPA iteration adds one vertex; a closed triangulated polytope of V
+// vertices has 2V - 4 faces. The slack covers the faces of an iteration that
+// are added before the last ones of the horizon are.
+static const UINT MaxEpaVertices = 4 + MaxEpaIterations;
+static const UINT MaxEpaFaces = 2 * MaxEpaVertices + 64;
+
+// GJK stops once an iteration brings the squared distance down by less than
+// this fraction of it.
+static const FLOAT GjkTolerance = 1e-6f;
+
+// EPA stops once a support point is less than this fraction of the size of the
+// Minkowski difference beyond the nearest face.
+static const FLOAT EpaTolerance = 1e-4f;
+
+
+
+//-----------------------------------------------------------------------------
+ConvexHullShape::ConvexHullShape()
+{
+}
+
+
+
+ConvexHullShape::ConvexHullShape( const XMFLOAT3* pPoints, UINT Count, UINT Stride )
+{
+    SetPoints( pPoints, Count, Stride );
+}
+
+
+
+VOID ConvexHullShape::SetPoints( const XMFLOAT3* pPoints, UINT Count, UINT Stride )
+{
+    XMASSERT( pPoints || Count == 0 );
+    XMASSERT( Stride >= sizeof( XMFLOAT3 ) );
+
+    const BYTE* pBytes = reinterpret_cast<const BYTE*>( pPoints );
+
+    m_Points.resize( Count );
+    for( UINT i = 0; i < Count; i++ )
+        m_Points[i] = *reinterpret_cast<const XMFLOAT3*>( pBytes + size_t( i ) * Stride );
+}
+
+
+
+UINT ConvexHullShape::GetPointCount() const
+{
+    return UINT( m_Points.size() );
+}
+
+
+
+const XMFLOAT3* ConvexHullShape::GetPoints() const
+{
+    return m_Points.data();
+}
+
+
+
+XMVECTOR ConvexHullShape::LocalSupport( FXMVECTOR Direction ) const
+{
+    XMASSERT( !m_Points.empty() );
+
+    XMFLOAT3 D;
+    XMStoreFloat3( &D, Direction );
+
+    const XMFLOAT3* pBest = &m_Points[0];
+    FLOAT Best = -FLT_MAX;
+
+    for( size_t i = 0; i < m_Points.size(); i++ )
+    {
+        const XMFLOAT3& P = m_Points[i];
+        FLOAT Dot = P.x * D.x + P.y * D.y + P.z * D.z;
+        if( Dot > Best )
+        {
+            Best = Dot;
+            pBest = &P;
+        }
+    }
+
+    return XMLoadFloat3( pBest );
+}
+
+
+
+//-----------------------------------------------------------------------------
+SphereShape::SphereShape( FLOAT Radius ) :
+    m_Radius( Radius )
+{
+    XMASSERT( Radius >= 0.0f );
+}
+
+
+
+XMVECTOR SphereShape::LocalSupport( FXMVECTOR Direction ) const
+{
+    FLOAT LengthSq = XMVectorGetX( XMVector3LengthSq( Direction ) );
+    if( LengthSq <= 0.0f )
+        return XMVectorSet( m_Radius, 0.0f, 0.0f, 0.0f );
+
+    return Direction * ( m_Radius / sqrtf( LengthSq ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+BoxShape::BoxShape( const XMFLOAT3& Extents ) :
+    m_Extents( Extents )
+{
+}
+
+
+
+XMVECTOR BoxShape::LocalSupport( FXMVECTOR Direction ) const
+{
+    XMVECTOR Extents = XMLoadFloat3( &m_Extents );
+
+    return XMVectorSelect( -Extents, Extents, XMVectorGreaterOrEqual( Direction, XMVectorZero() ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// The queries run in the local space of A.
+//-----------------------------------------------------------------------------
+struct RelativeFrame
+{
+    XMMATRIX BToA;              // Rotation from the space of B into that of A.
+    XMMATRIX AToB;
+    XMMATRIX AToWorld;
+    XMVECTOR Translation;       // Position of B in the space of A.
+};
+
+// A vertex of the Minkowski difference with the points of A and B it is made
+// of, both in the space of A, and the point of B in its own space.
+struct SupportPoint
+{
+    XMVECTOR W;
+    XMVECTOR A;
+    XMVECTOR B;
+    XMVECTOR LocalB;
+};
+
+struct Simplex
+{
+    UINT Count;
+    SupportPoint V[4];
+    FLOAT Bary[4];              // Weights of the point nearest the origin.
+};
+
+// Nearest point of a sub-simplex: Count vertices of a Simplex, by index.
+struct SimplexSolution
+{
+    UINT Count;
+    UINT Index[3];
+    FLOAT Bary[3];
+    FLOAT DistSq;
+};
+
+
+
+static inline FLOAT Dot3( FXMVECTOR A, FXMVECTOR B )
+{
+    return XMVectorGetX( XMVector3Dot( A, B ) );
+}
+
+
+
+static VOID ComputeRelativeFrame( const ConvexObject* pA, const ConvexObject* pB, RelativeFrame* pOut )
+{
+    XMMATRIX RotationA = XMMatrixRotationQuaternion( XMLoadFloat4( &pA->Orientation ) );
+    XMMATRIX RotationB = XMMatrixRotationQuaternion( XMLoadFloat4( &pB->Orientation ) );
+    XMMATRIX WorldToA = XMMatrixTranspose( RotationA );
+
+    pOut->BToA = XMMatrixMultiply( RotationB, WorldToA );
+    pOut->AToB = XMMatrixTranspose( pOut->BToA );
+    pOut->AToWorld = RotationA;
+    pOut->Translation = XMVector3TransformNormal( XMLoadFloat3( &pB->Position ) - XMLoadFloat3( &pA->Position ),
+                                                  WorldToA );
+}
+
+
+
+static inline VOID ComputeSupport( const ConvexObject* pA, const ConvexObject* pB, const RelativeFrame& F,
+                                   FXMVECTOR Direction, SupportPoint* pOut )
+{
+    pOut->A = pA->pShape->LocalSupport( Direction );
+    pOut->LocalB = pB->pShape->LocalSupport( XMVector3TransformNormal( -Direction, F.AToB ) );
+    pOut->B = XMVector3TransformNormal( pOut->LocalB, F.BToA ) + F.Translation;
+    pOut->W = pOut->A - pOut->B;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Nearest point to the origin of the segment (i0, i1) of the simplex.
+//-----------------------------------------------------------------------------
+static VOID SolveSegment( const Simplex& S, UINT i0, UINT i1, SimplexSolution* pOut )
+{
+    XMVECTOR A = S.V[i0].W;
+    XMVECTOR AB = S.V[i1].W - A;
+
+    FLOAT LengthSq = Dot3( AB, AB );
+    FLOAT t = LengthSq > 0.0f ? -Dot3( A, AB ) / LengthSq : 0.0f;
+
+    if( t <= 0.0f )
+    {
+        pOut->Count = 1;
+        pOut->Index[0] = i0;
+        pOut->Bary[0] = 1.0f;
+        pOut->DistSq = Dot3( A, A );
+    }
+    else if( t >= 1.0f )
+    {
+        pOut->Count = 1;
+        pOut->Index[0] = i1;
+        pOut->Bary[0] = 1.0f;
+        pOut->DistSq = Dot3( S.V[i1].W, S.V[i1].W );
+    }
+    else
+    {
+        XMVECTOR P = A + AB * t;
+        pOut->Count = 2;
+        pOut->Index[0] = i0;
+        pOut->Index[1] = i1;
+        pOut->Bary[0] = 1.0f - t;
+        pOut->Bary[1] = t;
+        pOut->DistSq = Dot3( P, P );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Nearest point to the origin of the triangle (i0, i1, i2) of the simplex, from
+// the Voronoi region of the triangle the origin is in.
+//-----------------------------------------------------------------------------
+static VOID SolveTriangle( const Simplex& S, UINT i0, UINT i1, UINT i2, SimplexSolution* pOut )
+{
+    XMVECTOR A = S.V[i0].W;
+    XMVECTOR B = S.V[i1].W;
+    XMVECTOR C = S.V[i2].W;
+    XMVECTOR AB = B - A;
+    XMVECTOR AC = C - A;
+
+    FLOAT d1 = -Dot3( AB, A );
+    FLOAT d2 = -Dot3( AC, A );
+    FLOAT d3 = -Dot3( AB, B );
+    FLOAT d4 = -Dot3( AC, B );
+    FLOAT d5 = -Dot3( AB, C );
+    FLOAT d6 = -Dot3( AC, C );
+
+    FLOAT va = d3 * d6 - d5 * d4;
+    FLOAT vb = d5 * d2 - d1 * d6;
+    FLOAT vc = d1 * d4 - d3 * d2;
+
+    // A flat triangle has no face region; the nearest point is on an edge.
+    FLOAT Area = va + vb + vc;
+    if( Area <= 1e-12f * Dot3( AB, AB ) * Dot3( AC, AC ) )
+    {
+        SimplexSolution Edge;
+        SolveSegment( S, i0, i1, pOut );
+        SolveSegment( S, i1, i2, &Edge );
+        if( Edge.DistSq < pOut->DistSq )
+            *pOut = Edge;
+        SolveSegment( S, i2, i0, &Edge );
+        if( Edge.DistSq < pOut->DistSq )
+            *pOut = Edge;
+        return;
+    }
+
+    if( ( d1 <= 0.0f && d2 <= 0.0f ) || ( d3 >= 0.0f && d4 <= d3 ) || ( d6 >= 0.0f && d5 <= d6 ) )
+    {
+        // Vertex regions.
+        UINT Index = ( d1 <= 0.0f && d2 <= 0.0f ) ? i0 : ( ( d3 >= 0.0f && d4 <= d3 ) ? i1 : i2 );
+        pOut->Count = 1;
+        pOut->Index[0] = Index;
+        pOut->Bary[0] = 1.0f;
+        pOut->DistSq = Dot3( S.V[Index].W, S.V[Index].W );
+    }
+    else if( vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f )
+    {
+        SolveSegment( S, i0, i1, pOut );
+    }
+    else if( vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f )
+    {
+        SolveSegment( S, i0, i2, pOut );
+    }
+    else if( va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f )
+    {
+        SolveSegment( S, i1, i2, pOut );
+    }
+    else
+    {
+        FLOAT v = vb / Area;
+        FLOAT w = vc / Area;
+        XMVECTOR P = A + AB * v + AC * w;
+
+        pOut->Count = 3;
+        pOut->Index[0] = i0;
+        pOut->Index[1] = i1;
+        pOut->Index[2] = i2;
+        pOut->Bary[0] = 1.0f - v - w;
+        pOut->Bary[1] = v;
+        pOut->Bary[2] = w;
+        pOut->DistSq = Dot3( P, P );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Nearest point to the origin of the tetrahedron: the nearest of those of the
+// faces the origin is outside of. Returns FALSE if it is inside all of them.
+//-----------------------------------------------------------------------------
+static BOOL SolveTetrahedron( const Simplex& S, SimplexSolution* pOut )
+{
+    static const UINT Faces[4][4] =
+    {
+        { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 },
+    };
+
+    XMVECTOR A = S.V[0].W;
+    XMVECTOR AB = S.V[1].W - A;
+    XMVECTOR AC = S.V[2].W - A;
+    XMVECTOR AD = S.V[3].W - A;
+
+    // A flat tetrahedron has no inside.
+    FLOAT Volume = Dot3( AB, XMVector3Cross( AC, AD ) );
+    FLOAT Scale = Dot3( AB, AB ) * Dot3( AC, AC ) * Dot3( AD, AD );
+    BOOL Flat = Volume * Volume <= 1e-12f * Scale;
+
+    BOOL Outside = FALSE;
+
+    for( UINT f = 0; f < 4; f++ )
+    {
+        XMVECTOR P0 = S.V[Faces[f][0]].W;
+        XMVECTOR N = XMVector3Cross( S.V[Faces[f][1]].W - P0, S.V[Faces[f][2]].W - P0 );
+
+        // The origin is outside the face when it is on the other side of its
+        // plane than the fourth vertex.
+        FLOAT SignOrigin = -Dot3( P0, N );
+        FLOAT SignOpposite = Dot3( S.V[Faces[f][3]].W - P0, N );
+        if( !Flat && SignOrigin * SignOpposite >= 0.0f )
+            continue;
+
+        SimplexSolution Face;
+        SolveTriangle( S, Faces[f][0], Faces[f][1], Faces[f][2], &Face );
+        if( !Outside || Face.DistSq < pOut->DistSq )
+            *pOut = Face;
+        Outside = TRUE;
+    }
+
+    return Outside;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Reduce the simplex to the vertices of its nearest point to the origin and
+// return that point. Returns FALSE if the simplex is a tetrahedron containing
+// the origin, which is then left as is.
+//-----------------------------------------------------------------------------
+static BOOL SolveSimplex( Simplex* pS, XMVECTOR* pNearest )
+{
+    SimplexSolution Solution;
+
+    switch( pS->Count )
+    {
+    case 1:
+        Solution.Count = 1;
+        Solution.Index[0] = 0;
+        Solution.Bary[0] = 1.0f;
+        break;
+
+    case 2:
+        SolveSegment( *pS, 0, 1, &Solution );
+        break;
+
+    case 3:
+        SolveTriangle( *pS, 0, 1, 2, &Solution );
+        break;
+
+    default:
+        XMASSERT( pS->Count == 4 );
+        if( !SolveTetrahedron( *pS, &Solution ) )
+        {
+            *pNearest = XMVectorZero();
+            return FALSE;
+        }
+        break;
+    }
+
+    SupportPoint Kept[3];
+    for( UINT i = 0; i < Solution.Count; i++ )
+        Kept[i] = pS->V[Solution.Index[i]];
+
+    XMVECTOR Nearest = XMVectorZero();
+    for( UINT i = 0; i < Solution.Count; i++ )
+    {
+        pS->V[i] = Kept[i];
+        pS->Bary[i] = Solution.Bary[i];
+        Nearest += Kept[i].W * Solution.Bary[i];
+    }
+    pS->Count = Solution.Count;
+
+    *pNearest = Nearest;
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// GJK from the simplex in *pS (empty for a cold start). Returns TRUE if the
+// objects intersect. Otherwise *pNearest is the point of A - B nearest the
+// origin, as weighted by pS->Bary, unless EarlyOut stopped the search at the
+// first separating direction.
+//-----------------------------------------------------------------------------
+static BOOL RunGjk( const ConvexObject* pA, const ConvexObject* pB, const RelativeFrame& F, BOOL EarlyOut,
+                    Simplex* pS, XMVECTOR* pNearest, UINT* pIterations )
+{
+    *pIterations = 0;
+
+    if( pS->Count == 0 )
+    {
+        // Start from the direction between the objects.
+        XMVECTOR Direction = -F.Translation;
+        if( Dot3( Direction, Direction ) <= 0.0f )
+            Direction = XMVectorSet( 1.0f, 0.0f, 0.0f, 0.0f );
+
+        ComputeSupport( pA, pB, F, Direction, &pS->V[0] );
+        pS->Count = 1;
+    }
+
+    XMVECTOR V;
+    if( !SolveSimplex( pS, &V ) )
+        return TRUE;
+
+    for( UINT Iteration = 0; Iteration < MaxGjkIterations; Iteration++ )
+    {
+        *pIterations = Iteration + 1;
+
+        FLOAT MaxSq = 0.0f;
+        for( UINT i = 0; i < pS->Count; i++ )
+            MaxSq = ( std::max )( MaxSq, Dot3( pS->V[i].W, pS->V[i].W ) );
+
+        // The origin is on the simplex, within rounding.
+        FLOAT VV = Dot3( V, V );
+        if( VV <= 1e-12f * MaxSq )
+            return TRUE;
+
+        SupportPoint P;
+        ComputeSupport( pA, pB, F, -V, &P );
+
+        FLOAT VW = Dot3( V, P.W );
+
+        // -V separates the origin from A - B.
+        if( EarlyOut && VW > 0.0f )
+        {
+            *pNearest = V;
+            return FALSE;
+        }
+
+        // No point of A - B is much nearer than V.
+        if( VV - VW <= GjkTolerance * VV )
+        {
+            *pNearest = V;
+            return FALSE;
+        }
+
+        for( UINT i = 0; i < pS->Count; i++ )
+        {
+            if( XMVector3Equal( pS->V[i].W, P.W ) )
+            {
+                *pNearest = V;
+                return FALSE;
+            }
+        }
+
+        pS->V[pS->Count++] = P;
+
+        XMVECTOR Previous = V;
+        if( !SolveSimplex( pS, &V ) )
+            return TRUE;
+
+        // Rounding keeps the simplex from getting any nearer.
+        if( Dot3( V, V ) >= VV )
+        {
+            *pNearest = Dot3( V, V ) > VV ? Previous : V;
+            return FALSE;
+        }
+    }
+
+    *pNearest = V;
+    return FALSE;
+}
+
+
+
+static VOID LoadCache( const GjkCache* pCache, const RelativeFrame& F, Simplex* pS )
+{
+    pS->Count = 0;
+    if( !pCache )
+        return;
+
+    XMASSERT( pCache->Count <= 4 );
+
+    for( UINT i = 0; i < pCache->Count; i++ )
+    {
+        SupportPoint& P = pS->V[i];
+        P.A = XMLoadFloat3( &pCache->LocalA[i] );
+        P.LocalB = XMLoadFloat3( &pCache->LocalB[i] );
+        P.B = XMVector3TransformNormal( P.LocalB, F.BToA ) + F.Translation;
+        P.W = P.A - P.B;
+    }
+    pS->Count = pCache->Count;
+}
+
+
+
+static VOID StoreCache( const Simplex& S, GjkCache* pCache )
+{
+    if( !pCache )
+        return;
+
+    for( UINT i = 0; i < S.Count; i++ )
+    {
+        XMStoreFloat3( &pCache->LocalA[i], S.V[i].A );
+        XMStoreFloat3( &pCache->LocalB[i], S.V[i].LocalB );
+    }
+    pCache->Count = S.Count;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL IntersectConvexConvex( const ConvexObject* pA, const ConvexObject* pB, GjkCache* pCache )
+{
+    XMASSERT( pA && pA->pShape );
+    XMASSERT( pB && pB->pShape );
+
+    RelativeFrame F;
+    ComputeRelativeFrame( pA, pB, &F );
+
+    Simplex S;
+    LoadCache( pCache, F, &S );
+
+    XMVECTOR V;
+    UINT Iterations;
+    BOOL Result = RunGjk( pA, pB, F, TRUE, &S, &V, &Iterations );
+
+    StoreCache( S, pCache );
+    return Result;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL ComputeConvexDistance( const ConvexObject* pA, const ConvexObject* pB, GjkCache* pCache, ConvexDistance* pOut )
+{
+    XMASSERT( pA && pA->pShape );
+    XMASSERT( pB && pB->pShape );
+    XMASSERT( pOut );
+
+    RelativeFrame F;
+    ComputeRelativeFrame( pA, pB, &F );
+
+    Simplex S;
+    LoadCache( pCache, F, &S );
+
+    XMVECTOR V;
+    BOOL Result = RunGjk( pA, pB, F, FALSE, &S, &V, &pOut->Iterations );
+
+    StoreCache( S, pCache );
+
+    if( Result )
+    {
+        pOut->Distance = 0.0f;
+        return TRUE;
+    }
+
+    XMVECTOR PointA = XMVectorZero();
+    XMVECTOR PointB = XMVectorZero();
+    for( UINT i = 0; i < S.Count; i++ )
+    {
+        PointA += S.V[i].A * S.Bary[i];
+        PointB += S.V[i].B * S.Bary[i];
+    }
+
+    XMVECTOR Position = XMLoadFloat3( &pA->Position );
+
+    pOut->Distance = XMVectorGetX( XMVector3Length( V ) );
+    XMStoreFloat3( &pOut->PointA, XMVector3TransformNormal( PointA, F.AToWorld ) + Position );
+    XMStoreFloat3( &pOut->PointB, XMVector3TransformNormal( PointB, F.AToWorld ) + Position );
+    return FALSE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// EPA polytope.
+//-----------------------------------------------------------------------------
+struct EpaFace
+{
+    UINT V[3];                  // Counter clockwise seen from outside.
+    XMVECTOR Normal;            // Unit, outwards; zero for slivers.
+    FLOAT Dist;                 // Of the plane from the origin; FLT_MAX for slivers.
+    BOOL Alive;
+};
+
+struct EpaPolytope
+{
+    SupportPoint Vertices[MaxEpaVertices];
+    UINT VertexCount;
+
+    EpaFace Faces[MaxEpaFaces];
+    UINT FaceCount;
+};
+
+
+
+static BOOL AddFace( EpaPolytope* pP, UINT a, UINT b, UINT c )
+{
+    // Reuse the slot of a removed face.
+    UINT Slot = pP->FaceCount;
+    for( UINT i = 0; i < pP->FaceCount; i++ )
+    {
+        if( !pP->Faces[i].Alive )
+        {
+            Slot = i;
+            break;
+        }
+    }
+
+    if( Slot == MaxEpaFaces )
+        return FALSE;
+    if( Slot == pP->FaceCount )
+        pP->FaceCount++;
+
+    EpaFace& F = pP->Faces[Slot];
+    F.V[0] = a;
+    F.V[1] = b;
+    F.V[2] = c;
+    F.Alive = TRUE;
+
+    XMVECTOR A = pP->Vertices[a].W;
+    XMVECTOR N = XMVector3Cross( pP->Vertices[b].W - A, pP->Vertices[c].W - A );
+    FLOAT LengthSq = Dot3( N, N );
+
+    if( LengthSq > 0.0f )
+    {
+        F.Normal = N * ( 1.0f / sqrtf( LengthSq ) );
+        F.Dist = Dot3( F.Normal, A );
+    }
+    else
+    {
+        F.Normal = XMVectorZero();
+        F.Dist = FLT_MAX;
+    }
+
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Grow the GJK simplex of touching or barely overlapping objects into a
+// tetrahedron, with support points in directions off its line or plane.
+// ScaleSq is the squared size of the simplex so far. Returns FALSE if A - B
+// is flat.
+//-----------------------------------------------------------------------------
+static BOOL ExpandToTetrahedron( const ConvexObject* pA, const ConvexObject* pB, const RelativeFrame& F,
+                                 EpaPolytope* pP, FLOAT ScaleSq )
+{
+    FLOAT Epsilon = 1e-10f * ScaleSq;
+
+    if( pP->VertexCount == 1 )
+    {
+        for( UINT i = 0; i < 6 && pP->VertexCount == 1; i++ )
+        {
+            FLOAT Sign = ( i & 1 ) ? -1.0f : 1.0f;
+            XMVECTOR Direction = XMVectorSet( i / 2 == 0 ? Sign : 0.0f, i / 2 == 1 ? Sign : 0.0f,
+                                              i / 2 == 2 ? Sign : 0.0f, 0.0f );
+
+            SupportPoint& P = pP->Vertices[1];
+            ComputeSupport( pA, pB, F, Direction, &P );
+            if( XMVectorGetX( XMVector3LengthSq( P.W - pP->Vertices[0].W ) ) > Epsilon )
+                pP->VertexCount = 2;
+        }
+    }
+
+    if( pP->VertexCount == 2 )
+    {
+        XMVECTOR W0 = pP->Vertices[0].W;
+        XMVECTOR Line = pP->Vertices[1].W - W0;
+
+        // Two directions perpendicular to the line.
+        XMFLOAT3 L;
+        XMStoreFloat3( &L, XMVectorAbs( Line ) );
+        XMVECTOR Axis = ( L.x <= L.y && L.x <= L.z ) ? XMVectorSet( 1.0f, 0.0f, 0.0f, 0.0f ) :
+                        ( L.y <= L.z ) ? XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f ) : XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f );
+        XMVECTOR Perp1 = XMVector3Cross( Line, Axis );
+        XMVECTOR Perp2 = XMVector3Cross( Line, Perp1 );
+        XMVECTOR Directions[4] = { Perp1, -Perp1, Perp2, -Perp2 };
+
+        FLOAT LineSq = Dot3( Line, Line );
+
+        for( UINT i = 0; i < 4 && pP->VertexCount == 2; i++ )
+        {
+            SupportPoint& P = pP->Vertices[2];
+            ComputeSupport( pA, pB, F, Directions[i], &P );
+
+            XMVECTOR Offset = XMVector3Cross( P.W - W0, Line );
+            if( Dot3( Offset, Offset ) > Epsilon * LineSq )
+                pP->VertexCount = 3;
+        }
+    }
+
+    if( pP->VertexCount == 3 )
+    {
+        XMVECTOR W0 = pP->Vertices[0].W;
+        XMVECTOR N = XMVector3Cross( pP->Vertices[1].W - W0, pP->Vertices[2].W - W0 );
+        XMVECTOR Directions[2] = { N, -N };
+
+        FLOAT NSq = Dot3( N, N );
+
+        for( UINT i = 0; i < 2 && pP->VertexCount == 3; i++ )
+        {
+            SupportPoint& P = pP->Vertices[3];
+            ComputeSupport( pA, pB, F, Directions[i], &P );
+
+            FLOAT Height = Dot3( P.W - W0, N );
+            if( Height * Height > Epsilon * NSq )
+                pP->VertexCount = 4;
+        }
+    }
+
+    return pP->VertexCount == 4;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// EPA from the simplex GJK ended with, which contains the origin. Fills in the
+// depth, normal and points of *pOut in the space of A and returns the number of
+// iterations.
+//-----------------------------------------------------------------------------
+static UINT RunEpa( const ConvexObject* pA, const ConvexObject* pB, const RelativeFrame& F, const Simplex& S,
+                    ConvexPenetration* pOut, XMVECTOR* pNormal, XMVECTOR* pPointA, XMVECTOR* pPointB )
+{
+    EpaPolytope P;
+    P.VertexCount = S.Count;
+    P.FaceCount = 0;
+
+    FLOAT ScaleSq = 0.0f;
+    for( UINT i = 0; i < S.Count; i++ )
+    {
+        P.Vertices[i] = S.V[i];
+        ScaleSq = ( std::max )( ScaleSq, Dot3( S.V[i].W, S.V[i].W ) );
+    }
+
+    if( P.VertexCount < 4 && !ExpandToTetrahedron( pA, pB, F, &P, ScaleSq ) )
+    {
+        // Flat objects in contact.
+        pOut->Depth = 0.0f;
+        *pNormal = XMVectorSet( 0.0f, 1.0f, 0.0f, 0.0f );
+        *pPointA = P.Vertices[0].A;
+        *pPointB = P.Vertices[0].B;
+        return 0;
+    }
+
+    // The tolerance scales with the size of A - B.
+    for( UINT i = 0; i < 4; i++ )
+        ScaleSq = ( std::max )( ScaleSq, Dot3( P.Vertices[i].W, P.Vertices[i].W ) );
+
+    // Faces of the tetrahedron, turned outwards.
+    XMVECTOR Centroid = ( P.Vertices[0].W + P.Vertices[1].W + P.Vertices[2].W + P.Vertices[3].W ) * 0.25f;
+    XMVECTOR N = XMVector3Cross( P.Vertices[1].W - P.Vertices[0].W, P.Vertices[2].W - P.Vertices[0].W );
+    if( Dot3( N, Centroid - P.Vertices[0].W ) > 0.0f )
+        std::swap( P.Vertices[1], P.Vertices[2] );
+
+    AddFace( &P, 0, 1, 2 );
+    AddFace( &P, 0, 3, 1 );
+    AddFace( &P, 0, 2, 3 );
+    AddFace( &P, 1, 3, 2 );
+
+    FLOAT Tolerance = EpaTolerance * sqrtf( ScaleSq );
+
+    UINT Nearest = 0;
+    UINT Iteration = 0;
+
+    for( ;; )
+    {
+        Nearest = MaxEpaFaces;
+        for( UINT i = 0; i < P.FaceCount; i++ )
+        {
+            if( P.Faces[i].Alive && ( Nearest == MaxEpaFaces || P.Faces[i].Dist < P.Faces[Nearest].Dist ) )
+                Nearest = i;
+        }
+        XMASSERT( Nearest != MaxEpaFaces );
+
+        if( Iteration == MaxEpaIterations || P.VertexCount == MaxEpaVertices )
+            break;
+
+        const EpaFace& Face = P.Faces[Nearest];
+        if( Face.Dist == FLT_MAX )
+            break;
+
+        SupportPoint& W = P.Vertices[P.VertexCount];
+        ComputeSupport( pA, pB, F, Face.Normal, &W );
+
+        // A - B does not reach meaningfully beyond the nearest face.
+        if( Dot3( W.W, Face.Normal ) - Face.Dist <= Tolerance )
+            break;
+
+        Iteration++;
+        UINT NewVertex = P.VertexCount++;
+
+        // Remove the faces the new vertex sees; the edges they do not share
+        // with each other form the horizon.
+        UINT Edges[MaxEpaFaces * 3][2];
+        UINT EdgeCount = 0;
+
+        for( UINT i = 0; i < P.FaceCount; i++ )
+        {
+            EpaFace& Visible = P.Faces[i];
+            if( !Visible.Alive || Dot3( Visible.Normal, W.W - P.Vertices[Visible.V[0]].W ) <= 0.0f )
+                continue;
+
+            Visible.Alive = FALSE;
+
+            for( UINT e = 0; e < 3; e++ )
+            {
+                UINT a = Visible.V[e];
+                UINT b = Visible.V[( e + 1 ) % 3];
+
+                UINT Twin = EdgeCount;
+                for( UINT k = 0; k < EdgeCount; k++ )
+                {
+                    if( Edges[k][0] == b && Edges[k][1] == a )
+                    {
+                        Twin = k;
+                        break;
+                    }
+                }
+
+                if( Twin < EdgeCount )
+                {
+                    Edges[Twin][0] = Edges[EdgeCount - 1][0];
+                    Edges[Twin][1] = Edges[EdgeCount - 1][1];
+                    EdgeCount--;
+                }
+                else
+                {
+                    Edges[EdgeCount][0] = a;
+                    Edges[EdgeCount][1] = b;
+                    EdgeCount++;
+                }
+            }
+        }
+
+        BOOL Full = FALSE;
+        for( UINT e = 0; e < EdgeCount && !Full; e++ )
+            Full = !AddFace( &P, Edges[e][0], Edges[e][1], NewVertex );
+
+        if( Full )
+        {
+            Nearest = MaxEpaFaces;
+            for( UINT i = 0; i < P.FaceCount; i++ )
+            {
+                if( P.Faces[i].Alive && ( Nearest == MaxEpaFaces || P.Faces[i].Dist < P.Faces[Nearest].Dist ) )
+                    Nearest = i;
+            }
+            break;
+        }
+    }
+
+    // The deepest points are the projection of the origin on the nearest face,
+    // in barycentric coordinates of its vertices.
+    const EpaFace& Face = P.Faces[Nearest];
+    const SupportPoint& V0 = P.Vertices[Face.V[0]];
+    const SupportPoint& V1 = P.Vertices[Face.V[1]];
+    const SupportPoint& V2 = P.Vertices[Face.V[2]];
+
+    XMVECTOR Projection = Face.Normal * Face.Dist;
+    XMVECTOR E1 = V1.W - V0.W;
+    XMVECTOR E2 = V2.W - V0.W;
+    XMVECTOR E0 = Projection - V0.W;
+
+    FLOAT d11 = Dot3( E1, E1 );
+    FLOAT d12 = Dot3( E1, E2 );
+    FLOAT d22 = Dot3( E2, E2 );
+    FLOAT d01 = Dot3( E0, E1 );
+    FLOAT d02 = Dot3( E0, E2 );
+    FLOAT Denom = d11 * d22 - d12 * d12;
+
+    FLOAT v = 0.0f, w = 0.0f;
+    if( Denom > 0.0f )
+    {
+        v = ( d22 * d01 - d12 * d02 ) / Denom;
+        w = ( d11 * d02 - d12 * d01 ) / Denom;
+    }
+    FLOAT u = 1.0f - v - w;
+
+    pOut->Depth = ( std::max )( Face.Dist, 0.0f );
+    *pNormal = Face.Normal;
+    *pPointA = V0.A * u + V1.A * v + V2.A * w;
+    *pPointB = V0.B * u + V1.B * v + V2.B * w;
+    return Iteration;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL ComputeConvexPenetration( const ConvexObject* pA, const ConvexObject* pB, GjkCache* pCache,
+                               ConvexPenetration* pOut )
+{
+    XMASSERT( pA && pA->pShape );
+    XMASSERT( pB && pB->pShape );
+    XMASSERT( pOut );
+
+    RelativeFrame F;
+    ComputeRelativeFrame( pA, pB, &F );
+
+    Simplex S;
+    LoadCache( pCache, F, &S );
+
+    XMVECTOR V;
+    UINT GjkIterations;
+    BOOL Result = RunGjk( pA, pB, F, TRUE, &S, &V, &GjkIterations );
+
+    StoreCache( S, pCache );
+
+    if( !Result )
+        return FALSE;
+
+    XMVECTOR Normal, PointA, PointB;
+    UINT EpaIterations = RunEpa( pA, pB, F, S, pOut, &Normal, &PointA, &PointB );
+
+    XMVECTOR Position = XMLoadFloat3( &pA->Position );
+
+    XMStoreFloat3( &pOut->Normal, XMVector3TransformNormal( Normal, F.AToWorld ) );
+    XMStoreFloat3( &pOut->PointA, XMVector3TransformNormal( PointA, F.AToWorld ) + Position );
+    XMStoreFloat3( &pOut->PointB, XMVector3TransformNormal( PointB, F.AToWorld ) + Position );
+    pOut->Iterations = GjkIterations + EpaIterations;
+    return TRUE;
+}
+
+}; // namespace
@@ -0,0 +1,140 @@
+//-------------------------------------------------------------------------------------
+// ConvexCollision.h
+//
+// Narrowphase for arbitrary convex shapes given by their support mapping (the
+// farthest point of the shape along a direction), such as the convex hulls of
+// imported collision proxies.
+//
+// GJK finds the point of the Minkowski difference A - B nearest the origin: the
+// shapes are disjoint when that point is not the origin, and its distance is
+// the distance between them. When they overlap, EPA expands the final GJK
+// simplex into a polytope until it finds the face of A - B nearest the origin,
+// which gives the penetration depth and normal.
+//
+// Both work on the shapes in the local space of A, and keep the simplex in the
+// local spaces of the two shapes, where it stays valid as the objects move. A
+// GjkCache passed along for a persistent pair starts the next query from the
+// simplex the last one ended with, which usually answers it in one or two
+// iterations instead of rebuilding the simplex from scratch.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _CONVEX_COLLISION_H_
+#define _CONVEX_COLLISION_H_
+
+#include <vector>
+#include "xnacollision.h"
+
+namespace XNA
+{
+
+//-----------------------------------------------------------------------------
+// Support mapped shapes, in their local space.
+//-----------------------------------------------------------------------------
+class ConvexShape
+{
+public:
+    virtual ~ConvexShape() {}
+
+    // A point of the shape farthest along Direction (not necessarily unit).
+    virtual XMVECTOR LocalSupport( FXMVECTOR Direction ) const = 0;
+};
+
+// Convex hull of a point set. The points do not have to be the hull vertices
+// only, but every point costs a dot product per support query.
+class ConvexHullShape : public ConvexShape
+{
+public:
+    ConvexHullShape();
+    ConvexHullShape( const XMFLOAT3* pPoints, UINT Count, UINT Stride = sizeof( XMFLOAT3 ) );
+
+    VOID SetPoints( const XMFLOAT3* pPoints, UINT Count, UINT Stride = sizeof( XMFLOAT3 ) );
+
+    UINT GetPointCount() const;
+    const XMFLOAT3* GetPoints() const;
+
+    virtual XMVECTOR LocalSupport( FXMVECTOR Direction ) const;
+
+private:
+    std::vector<XMFLOAT3> m_Points;
+};
+
+class SphereShape : public ConvexShape
+{
+public:
+    SphereShape( FLOAT Radius );
+
+    virtual XMVECTOR LocalSupport( FXMVECTOR Direction ) const;
+
+private:
+    FLOAT m_Radius;
+};
+
+class BoxShape : public ConvexShape
+{
+public:
+    BoxShape( const XMFLOAT3& Extents );
+
+    virtual XMVECTOR LocalSupport( FXMVECTOR Direction ) const;
+
+private:
+    XMFLOAT3 m_Extents;
+};
+
+//-----------------------------------------------------------------------------
+// A shape placed in the world.
+//-----------------------------------------------------------------------------
+struct ConvexObject
+{
+    const ConvexShape* pShape;
+    XMFLOAT3 Position;
+    XMFLOAT4 Orientation;       // Unit quaternion.
+};
+
+// Simplex a query of a pair ended with, for the next query of the same pair.
+// Count 0 means no history. LocalA and LocalB are in the local spaces of the
+// shapes, so the cache must be used with the objects in the same order.
+struct GjkCache
+{
+    UINT Count;
+    XMFLOAT3 LocalA[4];
+    XMFLOAT3 LocalB[4];
+};
+
+struct ConvexDistance
+{
+    FLOAT Distance;
+    XMFLOAT3 PointA;            // Nearest points, in world space.
+    XMFLOAT3 PointB;
+    UINT Iterations;
+};
+
+struct ConvexPenetration
+{
+    FLOAT Depth;
+    XMFLOAT3 Normal;            // Unit, from A towards B: moving B by Depth * Normal separates them.
+    XMFLOAT3 PointA;            // Deepest points, in world space.
+    XMFLOAT3 PointB;
+    UINT Iterations;            // GJK and EPA iterations.
+};
+
+//-----------------------------------------------------------------------------
+// Queries. pCache may be NULL; otherwise it is read and updated.
+//-----------------------------------------------------------------------------
+
+// Returns TRUE if the objects intersect. Stops as soon as a separating
+// direction is found, without computing the distance.
+BOOL IntersectConvexConvex( const ConvexObject* pA, const ConvexObject* pB, GjkCache* pCache = NULL );
+
+// Returns TRUE if the objects intersect, in which case pOut->Distance is 0 and
+// the points are unspecified.
+BOOL ComputeConvexDistance( const ConvexObject* pA, const ConvexObject* pB, GjkCache* pCache, ConvexDistance* pOut );
+
+// Returns FALSE if the objects do not intersect, leaving *pOut unchanged.
+BOOL ComputeConvexPenetration( const ConvexObject* pA, const ConvexObject* pB, GjkCache* pCache,
+                               ConvexPenetration* pOut );
+
+}; // namespace
+
+#endif
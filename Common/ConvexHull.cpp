@@ -0,0 +1,843 @@
+//-------------------------------------------------------------------------------------
+// ConvexHull.cpp
+//
+// Quickhull over triangles.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <queue>
+#include "ConvexHull.h"
+
+namespace XNA
+{
+
+static const UINT None = 0xffffffff;
+
+// Outside point arrays larger than this are freed with their face instead of
+// being kept for the next face in the slot.
+static const size_t MaxKeptCapacity = 4096;
+
+// Points less than this fraction of the size of the input above a face are
+// inside. Lloyd's quickhull uses 3 double epsilons; the planes here are
+// stored as floats, which loses a few more bits.
+static const FLOAT RelativeTolerance = 8.0f * FLT_EPSILON;
+
+
+
+//-----------------------------------------------------------------------------
+// Working state of a build. Adjacent[i] is the face across the edge from V[i]
+// to V[(i + 1) % 3]. Each face keeps copies of the points above it, so that
+// handing them to the new faces reads them in order rather than all over the
+// input; Farthest is the one farthest above it.
+//-----------------------------------------------------------------------------
+struct OutsidePoint
+{
+    XMFLOAT3 Position;
+    UINT Index;
+};
+
+struct HullFace
+{
+    UINT V[3];
+    UINT Adjacent[3];
+    XMFLOAT4 Plane;
+    std::vector<OutsidePoint> Outside;
+    UINT Farthest;
+    FLOAT FarthestDistance;
+    UINT Version;               // Incremented when the face is removed.
+    UINT Visited;               // Iteration that last found the face visible.
+    BOOL Alive;
+};
+
+// Edge of a visible face whose neighbor across, Outside, is not visible.
+struct HorizonEdge
+{
+    UINT A, B;
+    UINT Outside;
+};
+
+// Faces with points above them, farthest point first. Entries of removed
+// faces are skipped when they come up.
+struct HullQueueEntry
+{
+    FLOAT Distance;
+    UINT Face;
+    UINT Version;
+
+    bool operator<( const HullQueueEntry& rhs ) const
+    {
+        return Distance < rhs.Distance || ( Distance == rhs.Distance && Face > rhs.Face );
+    }
+};
+
+struct HorizonStackEntry
+{
+    UINT Face;
+    UINT FirstEdge;
+    UINT Step;
+};
+
+struct HullState
+{
+    const XMFLOAT3* pPoints;
+    UINT Stride;
+    FLOAT Tolerance;
+
+    std::vector<HullFace> Faces;
+    std::vector<UINT> FreeFaces;
+    UINT AliveFaces;
+    UINT Iteration;
+
+    std::priority_queue<HullQueueEntry> Queue;
+
+    // Scratch of an iteration.
+    std::vector<UINT> Visible;
+    std::vector<HorizonEdge> Horizon;
+    std::vector<HorizonStackEntry> Stack;
+    std::vector<UINT> NewFaces;
+    std::vector<OutsidePoint> Orphans;
+};
+
+
+
+//-----------------------------------------------------------------------------
+static inline XMVECTOR LoadPoint( const XMFLOAT3* pPoints, UINT Stride, UINT i )
+{
+    return XMLoadFloat3( ( const XMFLOAT3* )( ( const BYTE* )pPoints + ( size_t )i * Stride ) );
+}
+
+
+
+static inline XMVECTOR HullPoint( const HullState& S, UINT i )
+{
+    return LoadPoint( S.pPoints, S.Stride, i );
+}
+
+
+
+static inline FLOAT PlaneDistance( const HullFace& F, FXMVECTOR Point )
+{
+    return XMVectorGetX( XMVector3Dot( XMLoadFloat4( &F.Plane ), Point ) ) + F.Plane.w;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Whether the face is visible from Eye, that is whether Eye is above its
+// plane at all. Measured from a corner of the face in double precision: the
+// float distance loses bits to the distance of the face from the origin, and
+// a face wrongly kept leaves a fold that the thin new faces next to it can
+// make much deeper than the error itself.
+//-----------------------------------------------------------------------------
+static inline BOOL IsVisible( const HullState& S, const HullFace& F, const XMFLOAT3& Eye )
+{
+    XMFLOAT3 Corner;
+    XMStoreFloat3( &Corner, HullPoint( S, F.V[0] ) );
+
+    double Distance = double( F.Plane.x ) * ( double( Eye.x ) - Corner.x ) +
+                      double( F.Plane.y ) * ( double( Eye.y ) - Corner.y ) +
+                      double( F.Plane.z ) * ( double( Eye.z ) - Corner.z );
+
+    return Distance > 0.0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// New face A, B, C, reusing the slot of a removed one when there is one. The
+// plane is computed in double precision: the faces of a dense hull are small
+// and its points far from the origin.
+//-----------------------------------------------------------------------------
+static UINT AddFace( HullState& S, UINT A, UINT B, UINT C )
+{
+    UINT Index;
+
+    if( !S.FreeFaces.empty() )
+    {
+        Index = S.FreeFaces.back();
+        S.FreeFaces.pop_back();
+    }
+    else
+    {
+        Index = UINT( S.Faces.size() );
+        S.Faces.resize( Index + 1 );
+        S.Faces[Index].Version = 0;
+    }
+
+    HullFace& F = S.Faces[Index];
+    F.V[0] = A;
+    F.V[1] = B;
+    F.V[2] = C;
+    F.Adjacent[0] = F.Adjacent[1] = F.Adjacent[2] = None;
+    F.Farthest = None;
+    F.FarthestDistance = 0.0f;
+    F.Visited = 0;
+    F.Alive = TRUE;
+
+    XMFLOAT3 P[3];
+    for( UINT i = 0; i < 3; i++ )
+        XMStoreFloat3( &P[i], HullPoint( S, F.V[i] ) );
+
+    double E1[3] = { double( P[1].x ) - P[0].x, double( P[1].y ) - P[0].y, double( P[1].z ) - P[0].z };
+    double E2[3] = { double( P[2].x ) - P[0].x, double( P[2].y ) - P[0].y, double( P[2].z ) - P[0].z };
+    double N[3] = { E1[1] * E2[2] - E1[2] * E2[1], E1[2] * E2[0] - E1[0] * E2[2], E1[0] * E2[1] - E1[1] * E2[0] };
+
+    double Length = sqrt( N[0] * N[0] + N[1] * N[1] + N[2] * N[2] );
+    if( Length > 0.0 )
+    {
+        N[0] /= Length;
+        N[1] /= Length;
+        N[2] /= Length;
+    }
+
+    // Through the centroid, which balances the rounding of the three corners.
+    double D = -( N[0] * ( double( P[0].x ) + P[1].x + P[2].x ) + N[1] * ( double( P[0].y ) + P[1].y + P[2].y ) +
+                  N[2] * ( double( P[0].z ) + P[1].z + P[2].z ) ) / 3.0;
+
+    F.Plane = XMFLOAT4( FLOAT( N[0] ), FLOAT( N[1] ), FLOAT( N[2] ), FLOAT( D ) );
+
+    S.AliveFaces++;
+    return Index;
+}
+
+
+
+static VOID RemoveFace( HullState& S, UINT Index )
+{
+    HullFace& F = S.Faces[Index];
+    F.Alive = FALSE;
+    F.Version++;
+
+    if( F.Outside.capacity() > MaxKeptCapacity )
+        std::vector<OutsidePoint>().swap( F.Outside );
+    else
+        F.Outside.clear();
+
+    S.FreeFaces.push_back( Index );
+    S.AliveFaces--;
+}
+
+
+
+static inline VOID AddOutside( HullState& S, UINT Face, const OutsidePoint& Point, FLOAT Distance )
+{
+    HullFace& F = S.Faces[Face];
+
+    F.Outside.push_back( Point );
+
+    if( F.Farthest == None || Distance > F.FarthestDistance )
+    {
+        F.Farthest = Point.Index;
+        F.FarthestDistance = Distance;
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Give the point to the first of the faces it is above; a point above none of
+// them is inside the hull for good.
+//-----------------------------------------------------------------------------
+static inline VOID AssignPoint( HullState& S, const OutsidePoint& Point, const UINT* pFaces, UINT FaceCount )
+{
+    XMVECTOR P = XMLoadFloat3( &Point.Position );
+
+    for( UINT i = 0; i < FaceCount; i++ )
+    {
+        FLOAT Distance = PlaneDistance( S.Faces[pFaces[i]], P );
+        if( Distance > S.Tolerance )
+        {
+            AddOutside( S, pFaces[i], Point, Distance );
+            return;
+        }
+    }
+}
+
+
+
+static VOID QueueFace( HullState& S, UINT Index )
+{
+    const HullFace& F = S.Faces[Index];
+
+    if( !F.Outside.empty() )
+    {
+        HullQueueEntry Entry = { F.FarthestDistance, Index, F.Version };
+        S.Queue.push( Entry );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Take the farthest point off the face as if it were inside, and queue the
+// face again with the next one.
+//-----------------------------------------------------------------------------
+static VOID DropFarthest( HullState& S, UINT Index )
+{
+    HullFace& F = S.Faces[Index];
+    UINT Dropped = F.Farthest;
+
+    F.Farthest = None;
+    F.FarthestDistance = 0.0f;
+
+    size_t Kept = 0;
+    for( size_t i = 0; i < F.Outside.size(); i++ )
+    {
+        if( F.Outside[i].Index == Dropped )
+            continue;
+
+        F.Outside[Kept++] = F.Outside[i];
+
+        FLOAT Distance = PlaneDistance( F, XMLoadFloat3( &F.Outside[i].Position ) );
+        if( F.Farthest == None || Distance > F.FarthestDistance )
+        {
+            F.Farthest = F.Outside[i].Index;
+            F.FarthestDistance = Distance;
+        }
+    }
+
+    F.Outside.resize( Kept );
+    QueueFace( S, Index );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Find the faces Eye is above, starting from Start, and the edges of their
+// border in order around it: a face is entered from one of its edges and its
+// other edges are walked starting after that one. Returns FALSE if rounding
+// made the visible faces anything else than a disk, with a single closed
+// horizon.
+//-----------------------------------------------------------------------------
+static BOOL FindHorizon( HullState& S, UINT Start, const XMFLOAT3& Eye )
+{
+    S.Visible.clear();
+    S.Horizon.clear();
+    S.Stack.clear();
+
+    S.Faces[Start].Visited = S.Iteration;
+    S.Visible.push_back( Start );
+
+    HorizonStackEntry First = { Start, 0, 0 };
+    S.Stack.push_back( First );
+
+    while( !S.Stack.empty() )
+    {
+        HorizonStackEntry& Top = S.Stack.back();
+
+        if( Top.Step == 3 )
+        {
+            S.Stack.pop_back();
+            continue;
+        }
+
+        UINT Face = Top.Face;
+        UINT Edge = ( Top.FirstEdge + Top.Step ) % 3;
+        Top.Step++;
+
+        UINT Neighbor = S.Faces[Face].Adjacent[Edge];
+        if( S.Faces[Neighbor].Visited == S.Iteration )
+            continue;
+
+        if( IsVisible( S, S.Faces[Neighbor], Eye ) )
+        {
+            S.Faces[Neighbor].Visited = S.Iteration;
+            S.Visible.push_back( Neighbor );
+
+            UINT Back = 0;
+            while( S.Faces[Neighbor].Adjacent[Back] != Face )
+                Back++;
+
+            HorizonStackEntry Next = { Neighbor, ( Back + 1 ) % 3, 0 };
+            S.Stack.push_back( Next );
+        }
+        else
+        {
+            const HullFace& F = S.Faces[Face];
+            HorizonEdge Horizon = { F.V[Edge], F.V[( Edge + 1 ) % 3], Neighbor };
+            S.Horizon.push_back( Horizon );
+        }
+    }
+
+    UINT Count = UINT( S.Horizon.size() );
+    if( Count < 3 )
+        return FALSE;
+
+    for( UINT i = 0; i < Count; i++ )
+    {
+        if( S.Horizon[i].B != S.Horizon[( i + 1 ) % Count].A )
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Replace the visible faces by a cone from the horizon to Eye and hand their
+// points to the new faces.
+//-----------------------------------------------------------------------------
+static VOID AddEye( HullState& S, UINT Eye )
+{
+    S.Orphans.clear();
+
+    for( size_t i = 0; i < S.Visible.size(); i++ )
+    {
+        const std::vector<OutsidePoint>& Outside = S.Faces[S.Visible[i]].Outside;
+
+        for( size_t j = 0; j < Outside.size(); j++ )
+        {
+            if( Outside[j].Index != Eye )
+                S.Orphans.push_back( Outside[j] );
+        }
+
+        RemoveFace( S, S.Visible[i] );
+    }
+
+    UINT Count = UINT( S.Horizon.size() );
+    S.NewFaces.resize( Count );
+
+    for( UINT i = 0; i < Count; i++ )
+    {
+        const HorizonEdge& E = S.Horizon[i];
+        UINT Face = AddFace( S, E.A, E.B, Eye );
+        S.NewFaces[i] = Face;
+
+        // The face that stays has the edge the other way around.
+        S.Faces[Face].Adjacent[0] = E.Outside;
+
+        HullFace& Outside = S.Faces[E.Outside];
+        for( UINT j = 0; j < 3; j++ )
+        {
+            if( Outside.V[j] == E.B && Outside.V[( j + 1 ) % 3] == E.A )
+                Outside.Adjacent[j] = Face;
+        }
+    }
+
+    // Edge 1 runs from B to the eye, edge 2 from the eye to A, and the horizon
+    // edges follow each other.
+    for( UINT i = 0; i < Count; i++ )
+    {
+        HullFace& F = S.Faces[S.NewFaces[i]];
+        F.Adjacent[1] = S.NewFaces[( i + 1 ) % Count];
+        F.Adjacent[2] = S.NewFaces[( i + Count - 1 ) % Count];
+    }
+
+    for( size_t i = 0; i < S.Orphans.size(); i++ )
+        AssignPoint( S, S.Orphans[i], &S.NewFaces[0], Count );
+
+    for( UINT i = 0; i < Count; i++ )
+        QueueFace( S, S.NewFaces[i] );
+}
+
+
+
+//-----------------------------------------------------------------------------
+ConvexHull::ConvexHull() :
+    m_MaxOutsideDistance( 0.0f )
+{
+}
+
+
+
+ConvexHull::~ConvexHull()
+{
+}
+
+
+
+VOID ConvexHull::Build( const XMFLOAT3* pPoints, UINT Count, UINT Stride, UINT MaxVertices )
+{
+    XMASSERT( pPoints );
+    XMASSERT( Count > 0 );
+    XMASSERT( Stride >= sizeof( XMFLOAT3 ) );
+    XMASSERT( MaxVertices == 0 || MaxVertices >= 4 );
+
+    m_Vertices.clear();
+    m_Indices.clear();
+    m_MaxOutsideDistance = 0.0f;
+
+    // Points with the smallest and largest x, y and z.
+    UINT Extremes[6] = { 0, 0, 0, 0, 0, 0 };
+    XMFLOAT3 Min, Max;
+    XMStoreFloat3( &Min, LoadPoint( pPoints, Stride, 0 ) );
+    Max = Min;
+
+    for( UINT i = 1; i < Count; i++ )
+    {
+        XMFLOAT3 P;
+        XMStoreFloat3( &P, LoadPoint( pPoints, Stride, i ) );
+
+        for( UINT Axis = 0; Axis < 3; Axis++ )
+        {
+            FLOAT Value = ( &P.x )[Axis];
+
+            if( Value < ( &Min.x )[Axis] )
+            {
+                ( &Min.x )[Axis] = Value;
+                Extremes[Axis * 2] = i;
+            }
+
+            if( Value > ( &Max.x )[Axis] )
+            {
+                ( &Max.x )[Axis] = Value;
+                Extremes[Axis * 2 + 1] = i;
+            }
+        }
+    }
+
+    FLOAT Size = ( std::max )( fabsf( Min.x ), fabsf( Max.x ) ) + ( std::max )( fabsf( Min.y ), fabsf( Max.y ) ) +
+                 ( std::max )( fabsf( Min.z ), fabsf( Max.z ) );
+    FLOAT Tolerance = RelativeTolerance * Size;
+
+    // The two extreme points farthest apart.
+    UINT I0 = Extremes[0], I1 = Extremes[1];
+    FLOAT BestSq = -1.0f;
+
+    for( UINT i = 0; i < 6; i++ )
+    {
+        for( UINT j = i + 1; j < 6; j++ )
+        {
+            FLOAT DistanceSq = XMVectorGetX( XMVector3LengthSq( LoadPoint( pPoints, Stride, Extremes[i] ) -
+                                                                LoadPoint( pPoints, Stride, Extremes[j] ) ) );
+            if( DistanceSq > BestSq )
+            {
+                BestSq = DistanceSq;
+                I0 = Extremes[i];
+                I1 = Extremes[j];
+            }
+        }
+    }
+
+    XMVECTOR P0 = LoadPoint( pPoints, Stride, I0 );
+    XMVECTOR P1 = LoadPoint( pPoints, Stride, I1 );
+
+    if( sqrtf( BestSq ) <= Tolerance )
+    {
+        m_Vertices.resize( 1 );
+        XMStoreFloat3( &m_Vertices[0], P0 );
+        return;
+    }
+
+    // The point farthest from the line through them.
+    XMVECTOR Direction = XMVector3Normalize( P1 - P0 );
+    UINT I2 = I0;
+    BestSq = 0.0f;
+
+    for( UINT i = 0; i < Count; i++ )
+    {
+        FLOAT DistanceSq = XMVectorGetX( XMVector3LengthSq( XMVector3Cross( LoadPoint( pPoints, Stride, i ) - P0, Direction ) ) );
+        if( DistanceSq > BestSq )
+        {
+            BestSq = DistanceSq;
+            I2 = i;
+        }
+    }
+
+    if( sqrtf( BestSq ) <= Tolerance )
+    {
+        m_Vertices.resize( 2 );
+        XMStoreFloat3( &m_Vertices[0], P0 );
+        XMStoreFloat3( &m_Vertices[1], P1 );
+        return;
+    }
+
+    // The point farthest from the plane through the three.
+    XMVECTOR P2 = LoadPoint( pPoints, Stride, I2 );
+    XMVECTOR Normal = XMVector3Normalize( XMVector3Cross( P1 - P0, P2 - P0 ) );
+    UINT I3 = I0;
+    FLOAT Best = 0.0f, BestSigned = 0.0f;
+
+    for( UINT i = 0; i < Count; i++ )
+    {
+        FLOAT Distance = XMVectorGetX( XMVector3Dot( LoadPoint( pPoints, Stride, i ) - P0, Normal ) );
+        if( fabsf( Distance ) > Best )
+        {
+            Best = fabsf( Distance );
+            BestSigned = Distance;
+            I3 = i;
+        }
+    }
+
+    if( Best <= Tolerance )
+    {
+        BuildPlanar( pPoints, Count, Stride, MaxVertices, P0, Normal, Direction );
+        return;
+    }
+
+    // Wind the first face so that the fourth point is below it.
+    if( BestSigned > 0.0f )
+        std::swap( I1, I2 );
+
+    HullState S;
+    S.pPoints = pPoints;
+    S.Stride = Stride;
+    S.Tolerance = Tolerance;
+    S.AliveFaces = 0;
+    S.Iteration = 0;
+
+    UINT Tetrahedron[4][3] = { { I0, I1, I2 }, { I0, I3, I1 }, { I0, I2, I3 }, { I1, I3, I2 } };
+    UINT Faces[4];
+
+    for( UINT f = 0; f < 4; f++ )
+        Faces[f] = AddFace( S, Tetrahedron[f][0], Tetrahedron[f][1], Tetrahedron[f][2] );
+
+    for( UINT f = 0; f < 4; f++ )
+    {
+        for( UINT e = 0; e < 3; e++ )
+        {
+            UINT A = Tetrahedron[f][e];
+            UINT B = Tetrahedron[f][( e + 1 ) % 3];
+
+            for( UINT g = 0; g < 4; g++ )
+            {
+                for( UINT k = 0; k < 3; k++ )
+                {
+                    if( Tetrahedron[g][k] == B && Tetrahedron[g][( k + 1 ) % 3] == A )
+                        S.Faces[Faces[f]].Adjacent[e] = Faces[g];
+                }
+            }
+        }
+    }
+
+    for( UINT i = 0; i < Count; i++ )
+    {
+        if( i != I0 && i != I1 && i != I2 && i != I3 )
+        {
+            OutsidePoint Point;
+            XMStoreFloat3( &Point.Position, LoadPoint( pPoints, Stride, i ) );
+            Point.Index = i;
+            AssignPoint( S, Point, Faces, 4 );
+        }
+    }
+
+    for( UINT f = 0; f < 4; f++ )
+        QueueFace( S, Faces[f] );
+
+    while( !S.Queue.empty() )
+    {
+        HullQueueEntry Top = S.Queue.top();
+        const HullFace& F = S.Faces[Top.Face];
+
+        if( !F.Alive || F.Version != Top.Version )
+        {
+            S.Queue.pop();
+            continue;
+        }
+
+        // A closed triangulated surface with F faces has F / 2 + 2 vertices.
+        if( MaxVertices > 0 && S.AliveFaces / 2 + 2 >= MaxVertices )
+        {
+            m_MaxOutsideDistance = Top.Distance;
+            break;
+        }
+
+        S.Queue.pop();
+
+        UINT Eye = F.Farthest;
+        S.Iteration++;
+
+        XMFLOAT3 EyePoint;
+        XMStoreFloat3( &EyePoint, HullPoint( S, Eye ) );
+
+        if( FindHorizon( S, Top.Face, EyePoint ) )
+            AddEye( S, Eye );
+        else
+            DropFarthest( S, Top.Face );
+    }
+
+    // Number the vertices the faces use.
+    std::vector<UINT> Remap( Count, None );
+
+    m_Indices.reserve( S.AliveFaces * 3 );
+
+    for( size_t f = 0; f < S.Faces.size(); f++ )
+    {
+        const HullFace& Face = S.Faces[f];
+        if( !Face.Alive )
+            continue;
+
+        for( UINT i = 0; i < 3; i++ )
+        {
+            UINT& Vertex = Remap[Face.V[i]];
+            if( Vertex == None )
+            {
+                XMFLOAT3 Position;
+                XMStoreFloat3( &Position, HullPoint( S, Face.V[i] ) );
+
+                Vertex = UINT( m_Vertices.size() );
+                m_Vertices.push_back( Position );
+            }
+
+            m_Indices.push_back( Vertex );
+        }
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Hull of points in the plane through Origin: the 2D hull (Andrew's monotone
+// chain) in the basis Axis, Normal x Axis, cut down to the vertex budget by
+// removing the vertices that span the smallest triangles with their
+// neighbors, and triangulated as a fan on both sides.
+//-----------------------------------------------------------------------------
+struct PlanarPoint
+{
+    FLOAT X, Y;
+    UINT Index;
+
+    bool operator<( const PlanarPoint& rhs ) const
+    {
+        return X < rhs.X || ( X == rhs.X && Y < rhs.Y );
+    }
+};
+
+
+
+static inline FLOAT Cross2( const PlanarPoint& O, const PlanarPoint& A, const PlanarPoint& B )
+{
+    return ( A.X - O.X ) * ( B.Y - O.Y ) - ( A.Y - O.Y ) * ( B.X - O.X );
+}
+
+
+
+VOID ConvexHull::BuildPlanar( const XMFLOAT3* pPoints, UINT Count, UINT Stride, UINT MaxVertices, FXMVECTOR Origin,
+                              FXMVECTOR Normal, FXMVECTOR Axis )
+{
+    XMVECTOR Axis2 = XMVector3Cross( Normal, Axis );
+
+    std::vector<PlanarPoint> Points( Count );
+    for( UINT i = 0; i < Count; i++ )
+    {
+        XMVECTOR P = LoadPoint( pPoints, Stride, i ) - Origin;
+        Points[i].X = XMVectorGetX( XMVector3Dot( P, Axis ) );
+        Points[i].Y = XMVectorGetX( XMVector3Dot( P, Axis2 ) );
+        Points[i].Index = i;
+    }
+
+    std::sort( Points.begin(), Points.end() );
+
+    // Lower chain left to right, then upper chain back: counterclockwise in
+    // the plane basis.
+    std::vector<PlanarPoint> Hull( 2 * Count );
+    UINT Size = 0;
+
+    for( UINT i = 0; i < Count; i++ )
+    {
+        while( Size >= 2 && Cross2( Hull[Size - 2], Hull[Size - 1], Points[i] ) <= 0.0f )
+            Size--;
+        Hull[Size++] = Points[i];
+    }
+
+    for( UINT i = Count - 1, Lower = Size + 1; i-- > 0; )
+    {
+        while( Size >= Lower && Cross2( Hull[Size - 2], Hull[Size - 1], Points[i] ) <= 0.0f )
+            Size--;
+        Hull[Size++] = Points[i];
+    }
+
+    // The last point is the first one again.
+    Hull.resize( Size - 1 );
+
+    std::vector<PlanarPoint> Removed;
+
+    while( MaxVertices > 0 && Hull.size() > ( std::max )( MaxVertices, 3u ) )
+    {
+        size_t N = Hull.size();
+        size_t Smallest = 0;
+        FLOAT SmallestArea = FLT_MAX;
+
+        for( size_t i = 0; i < N; i++ )
+        {
+            FLOAT Area = Cross2( Hull[( i + N - 1 ) % N], Hull[i], Hull[( i + 1 ) % N] );
+            if( Area < SmallestArea )
+            {
+                SmallestArea = Area;
+                Smallest = i;
+            }
+        }
+
+        Removed.push_back( Hull[Smallest] );
+        Hull.erase( Hull.begin() + Smallest );
+    }
+
+    // Every point is inside the full polygon, so the farthest one outside an
+    // edge of the cut down polygon is one of the removed vertices.
+    for( size_t r = 0; r < Removed.size(); r++ )
+    {
+        for( size_t i = 0; i < Hull.size(); i++ )
+        {
+            const PlanarPoint& A = Hull[i];
+            const PlanarPoint& B = Hull[( i + 1 ) % Hull.size()];
+            FLOAT Length = sqrtf( ( B.X - A.X ) * ( B.X - A.X ) + ( B.Y - A.Y ) * ( B.Y - A.Y ) );
+
+            if( Length > 0.0f )
+                m_MaxOutsideDistance = ( std::max )( m_MaxOutsideDistance, -Cross2( A, B, Removed[r] ) / Length );
+        }
+    }
+
+    UINT N = UINT( Hull.size() );
+    m_Vertices.resize( N );
+    for( UINT i = 0; i < N; i++ )
+        XMStoreFloat3( &m_Vertices[i], LoadPoint( pPoints, Stride, Hull[i].Index ) );
+
+    // The fan ( 0, i, i + 1 ) faces along Normal, ( 0, i + 1, i ) away from it.
+    for( UINT i = 1; i + 1 < N; i++ )
+    {
+        UINT Front[6] = { 0, i + 1, i, 0, i, i + 1 };
+        m_Indices.insert( m_Indices.end(), Front, Front + 6 );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT ConvexHull::GetVertexCount() const
+{
+    return UINT( m_Vertices.size() );
+}
+
+
+
+const XMFLOAT3* ConvexHull::GetVertices() const
+{
+    return m_Vertices.empty() ? NULL : &m_Vertices[0];
+}
+
+
+
+UINT ConvexHull::GetTriangleCount() const
+{
+    return UINT( m_Indices.size() / 3 );
+}
+
+
+
+const UINT* ConvexHull::GetIndices() const
+{
+    return m_Indices.empty() ? NULL : &m_Indices[0];
+}
+
+
+
+FLOAT ConvexHull::GetMaxOutsideDistance() const
+{
+    return m_MaxOutsideDistance;
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID ComputeBoundingOrientedBoxFromHull( OrientedBox* pOut, const ConvexHull& Hull )
+{
+    XMASSERT( pOut );
+    XMASSERT( Hull.GetVertexCount() > 0 );
+
+    ComputeBoundingOrientedBoxFromPoints( pOut, Hull.GetVertexCount(), Hull.GetVertices(), sizeof( XMFLOAT3 ) );
+}
+
+}; // namespace
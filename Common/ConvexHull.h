@@ -0,0 +1,78 @@
+//-------------------------------------------------------------------------------------
+// ConvexHull.h
+//
+// 3D convex hull of a point set (quickhull), for building cheap collision and
+// culling proxies from imported meshes.
+//
+// The hull starts as the tetrahedron of four extreme points. Every point
+// outside it is assigned to one face it lies above; then the point farthest
+// from the hull is added, the faces it sees are replaced by a cone of new
+// faces from their horizon to it, and the points of the removed faces are
+// handed to the new ones, until no point is left outside. Because the
+// farthest point always comes first, stopping at a vertex budget gives the
+// hull of the most significant points. Points within a small tolerance
+// (relative to the size of the input) of a face count as inside, so nearly
+// coplanar points do not split faces into slivers.
+//
+// Coplanar input gives a flat, two sided polygon and collinear input a single
+// segment. The result can be passed to ConvexHullShape, and to
+// ComputeBoundingOrientedBoxFromPoints, which runs in time linear in the
+// number of points: on dense meshes the hull has orders of magnitude fewer.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _CONVEX_HULL_H_
+#define _CONVEX_HULL_H_
+
+#include <vector>
+#include "xnacollision.h"
+
+namespace XNA
+{
+
+class ConvexHull
+{
+public:
+    ConvexHull();
+    ~ConvexHull();
+
+    // Hull of Count points Stride bytes apart. MaxVertices limits the number
+    // of hull vertices (at least 4, 0 for no limit); a hull cut short by it
+    // does not contain every point, see GetMaxOutsideDistance.
+    VOID Build( const XMFLOAT3* pPoints, UINT Count, UINT Stride = sizeof( XMFLOAT3 ), UINT MaxVertices = 0 );
+
+    UINT GetVertexCount() const;
+    const XMFLOAT3* GetVertices() const;
+
+    // Triangle list over the vertices, wound clockwise seen from outside (the
+    // Direct3D front face), so cross( V1 - V0, V2 - V0 ) points out of the hull.
+    UINT GetTriangleCount() const;
+    const UINT* GetIndices() const;
+
+    // Distance above the hull of the farthest point a vertex budget left out,
+    // measured to the face the point was assigned to (so it can be slightly
+    // below the true distance). 0 for a complete hull.
+    FLOAT GetMaxOutsideDistance() const;
+
+private:
+    VOID BuildPlanar( const XMFLOAT3* pPoints, UINT Count, UINT Stride, UINT MaxVertices, FXMVECTOR Origin,
+                      FXMVECTOR Normal, FXMVECTOR Axis );
+
+    ConvexHull( const ConvexHull& rhs );
+    ConvexHull& operator=( const ConvexHull& rhs );
+
+private:
+    std::vector<XMFLOAT3> m_Vertices;
+    std::vector<UINT> m_Indices;
+    FLOAT m_MaxOutsideDistance;
+};
+
+// ComputeBoundingOrientedBoxFromPoints over the hull vertices: the axes come
+// from the shape of the hull instead of the distribution of the points inside
+// it, and the box contains every point the hull contains.
+VOID ComputeBoundingOrientedBoxFromHull( OrientedBox* pOut, const ConvexHull& Hull );
+
+}; // namespace
+
+#endif
@@ -0,0 +1,290 @@
+//-------------------------------------------------------------------------------------
+// CullingHierarchy.cpp
+//
+// Bounding volume hierarchy for view frustum culling.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cfloat>
+#include "CullingHierarchy.h"
+
+namespace XNA
+{
+
+// Deep enough for any tree built from a 32 bit object count: the median split
+// keeps the depth logarithmic, and the traversal pushes at most one node per
+// level.
+static const UINT MaxStackDepth = 64;
+
+
+
+//-----------------------------------------------------------------------------
+// Center/extents box around Min/Max. The extents are taken from the larger
+// side so that rounding of the center never leaves a point of Min/Max outside.
+//-----------------------------------------------------------------------------
+static inline VOID BoxFromMinMax( AxisAlignedBox* pOut, FXMVECTOR Min, FXMVECTOR Max )
+{
+    XMVECTOR Center = ( Min + Max ) * 0.5f;
+    XMVECTOR Extents = XMVectorMax( Max - Center, Center - Min );
+
+    XMStoreFloat3( &pOut->Center, Center );
+    XMStoreFloat3( &pOut->Extents, Extents );
+}
+
+
+
+static inline FLOAT GetComponent( const XMFLOAT3& v, UINT Axis )
+{
+    return ( &v.x )[Axis];
+}
+
+
+
+//-----------------------------------------------------------------------------
+CullingHierarchy::CullingHierarchy( UINT LeafSize ) :
+    m_LeafSize( LeafSize ? LeafSize : 1 ),
+    m_NodesVisited( 0 )
+{
+}
+
+
+
+CullingHierarchy::~CullingHierarchy()
+{
+}
+
+
+
+UINT CullingHierarchy::GetObjectCount() const
+{
+    return UINT( m_Objects.size() );
+}
+
+
+
+UINT CullingHierarchy::GetNodeCount() const
+{
+    return UINT( m_Nodes.size() );
+}
+
+
+
+UINT CullingHierarchy::GetNodesVisited() const
+{
+    return m_NodesVisited;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Bounds of the objects m_Objects[First, First + Count), with pBoxes indexed
+// by object.
+//-----------------------------------------------------------------------------
+VOID CullingHierarchy::ComputeBounds( const AxisAlignedBox* pBoxes, UINT First, UINT Count,
+                                      AxisAlignedBox* pOut ) const
+{
+    XMVECTOR Min = XMVectorReplicate( FLT_MAX );
+    XMVECTOR Max = XMVectorReplicate( -FLT_MAX );
+
+    for( UINT i = First; i < First + Count; i++ )
+    {
+        const AxisAlignedBox& Box = pBoxes[m_Objects[i]];
+        XMVECTOR Center = XMLoadFloat3( &Box.Center );
+        XMVECTOR Extents = XMLoadFloat3( &Box.Extents );
+
+        Min = XMVectorMin( Min, Center - Extents );
+        Max = XMVectorMax( Max, Center + Extents );
+    }
+
+    BoxFromMinMax( pOut, Min, Max );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Build the subtree of m_Objects[First, First + Count) and return its node.
+//-----------------------------------------------------------------------------
+UINT CullingHierarchy::BuildNode( const AxisAlignedBox* pBoxes, UINT First, UINT Count )
+{
+    UINT NodeId = UINT( m_Nodes.size() );
+    m_Nodes.push_back( Node() );
+
+    Node& N = m_Nodes[NodeId];
+    N.First = First;
+    N.Count = Count;
+    N.SecondChild = 0;
+    ComputeBounds( pBoxes, First, Count, &N.Box );
+
+    if( Count <= m_LeafSize )
+        return NodeId;
+
+    // Split at the median of the box centers along their longest axis.
+    XMVECTOR Min = XMVectorReplicate( FLT_MAX );
+    XMVECTOR Max = XMVectorReplicate( -FLT_MAX );
+    for( UINT i = First; i < First + Count; i++ )
+    {
+        XMVECTOR Center = XMLoadFloat3( &pBoxes[m_Objects[i]].Center );
+        Min = XMVectorMin( Min, Center );
+        Max = XMVectorMax( Max, Center );
+    }
+
+    XMFLOAT3 Size;
+    XMStoreFloat3( &Size, Max - Min );
+
+    UINT Axis = 0;
+    if( Size.y > GetComponent( Size, Axis ) )
+        Axis = 1;
+    if( Size.z > GetComponent( Size, Axis ) )
+        Axis = 2;
+
+    UINT Half = Count / 2;
+    UINT* pObjects = m_Objects.data();
+
+    std::nth_element( pObjects + First, pObjects + First + Half, pObjects + First + Count, [&]( UINT a, UINT b )
+    {
+        return GetComponent( pBoxes[a].Center, Axis ) < GetComponent( pBoxes[b].Center, Axis );
+    } );
+
+    BuildNode( pBoxes, First, Half );
+    UINT SecondChild = BuildNode( pBoxes, First + Half, Count - Half );
+
+    // m_Nodes may have been reallocated.
+    m_Nodes[NodeId].SecondChild = SecondChild;
+
+    return NodeId;
+}
+
+
+
+VOID CullingHierarchy::Build( const AxisAlignedBox* pBoxes, UINT Count )
+{
+    XMASSERT( pBoxes || Count == 0 );
+
+    m_Nodes.clear();
+    m_Objects.resize( Count );
+    for( UINT i = 0; i < Count; i++ )
+        m_Objects[i] = i;
+
+    if( Count > 0 )
+    {
+        m_Nodes.reserve( 2 * ( Count / m_LeafSize + 1 ) );
+        BuildNode( pBoxes, 0, Count );
+    }
+
+    m_Boxes.resize( Count );
+    for( UINT i = 0; i < Count; i++ )
+        m_Boxes[i] = pBoxes[m_Objects[i]];
+
+    m_NodeLastPlane.assign( m_Nodes.size(), 0 );
+    m_ObjectLastPlane.assign( Count, 0 );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Children come after their parent, so walking the nodes backwards sees every
+// child before its parent.
+//-----------------------------------------------------------------------------
+VOID CullingHierarchy::Refit( const AxisAlignedBox* pBoxes )
+{
+    XMASSERT( pBoxes || m_Objects.empty() );
+
+    for( size_t i = 0; i < m_Objects.size(); i++ )
+        m_Boxes[i] = pBoxes[m_Objects[i]];
+
+    for( size_t i = m_Nodes.size(); i-- > 0; )
+    {
+        Node& N = m_Nodes[i];
+
+        if( N.SecondChild == 0 )
+        {
+            ComputeBounds( pBoxes, N.First, N.Count, &N.Box );
+            continue;
+        }
+
+        const AxisAlignedBox& A = m_Nodes[i + 1].Box;
+        const AxisAlignedBox& B = m_Nodes[N.SecondChild].Box;
+
+        XMVECTOR CenterA = XMLoadFloat3( &A.Center );
+        XMVECTOR ExtentsA = XMLoadFloat3( &A.Extents );
+        XMVECTOR CenterB = XMLoadFloat3( &B.Center );
+        XMVECTOR ExtentsB = XMLoadFloat3( &B.Extents );
+
+        BoxFromMinMax( &N.Box, XMVectorMin( CenterA - ExtentsA, CenterB - ExtentsB ),
+                       XMVectorMax( CenterA + ExtentsA, CenterB + ExtentsB ) );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT CullingHierarchy::Cull( FrustumCuller* pCuller, std::vector<UINT>* pVisible )
+{
+    XMASSERT( pCuller );
+    XMASSERT( pVisible );
+
+    m_NodesVisited = 0;
+
+    if( m_Nodes.empty() )
+        return 0;
+
+    size_t Start = pVisible->size();
+
+    UINT Stack[MaxStackDepth];
+    UINT MaskStack[MaxStackDepth];
+    UINT Top = 0;
+
+    Stack[Top] = 0;
+    MaskStack[Top] = FrustumCuller::AllPlanes;
+    Top++;
+
+    while( Top > 0 )
+    {
+        Top--;
+        UINT NodeId = Stack[Top];
+        UINT PlaneMask = MaskStack[Top];
+
+        // Descend into the first child right away, keep the second for later.
+        for( ;; )
+        {
+            const Node& N = m_Nodes[NodeId];
+            m_NodesVisited++;
+
+            UINT Straddled;
+            INT Result = pCuller->CullAxisAlignedBox( &N.Box, &m_NodeLastPlane[NodeId], PlaneMask, &Straddled );
+
+            if( Result == 0 )
+                break;
+
+            if( Straddled == 0 )
+            {
+                // Completely inside: the whole subtree is visible.
+                pVisible->insert( pVisible->end(), m_Objects.begin() + N.First,
+                                  m_Objects.begin() + N.First + N.Count );
+                break;
+            }
+
+            if( N.SecondChild == 0 )
+            {
+                for( UINT i = N.First; i < N.First + N.Count; i++ )
+                {
+                    if( pCuller->CullAxisAlignedBox( &m_Boxes[i], &m_ObjectLastPlane[i], Straddled ) )
+                        pVisible->push_back( m_Objects[i] );
+                }
+                break;
+            }
+
+            XMASSERT( Top < MaxStackDepth );
+            Stack[Top] = N.SecondChild;
+            MaskStack[Top] = Straddled;
+            Top++;
+
+            NodeId = NodeId + 1;
+            PlaneMask = Straddled;
+        }
+    }
+
+    return UINT( pVisible->size() - Start );
+}
+
+}; // namespace
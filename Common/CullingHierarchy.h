@@ -0,0 +1,91 @@
+//-------------------------------------------------------------------------------------
+// CullingHierarchy.h
+//
+// Bounding volume hierarchy over the axis aligned boxes of scene objects, for
+// view frustum culling with a FrustumCuller.
+//
+// The traversal passes the mask of planes a node straddles down to its
+// children, so deeper nodes only test the planes their parent is not already
+// inside of. Once a node is completely inside the frustum its whole subtree is
+// visible: the objects of every subtree are stored contiguously, so they are
+// appended to the visible list without testing anything below it.
+//
+// The tree is built top down with median splits on the longest axis of the
+// box centers, in depth first order. Refit() updates the bounds after objects
+// moved; rebuild when they moved far enough for the tree to get loose.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _CULLING_HIERARCHY_H_
+#define _CULLING_HIERARCHY_H_
+
+#include <vector>
+#include "xnacollision.h"
+#include "FrustumCuller.h"
+
+namespace XNA
+{
+
+class CullingHierarchy
+{
+public:
+    // LeafSize is the largest number of objects stored in a leaf.
+    CullingHierarchy( UINT LeafSize = 4 );
+    ~CullingHierarchy();
+
+    VOID Build( const AxisAlignedBox* pBoxes, UINT Count );
+
+    // Update the node bounds from new object boxes (same count and indexing as
+    // the last Build).
+    VOID Refit( const AxisAlignedBox* pBoxes );
+
+    // Append the indices of the objects that are not outside the planes of
+    // pCuller to pVisible, in no particular order. Returns the number of
+    // objects appended. Every node and object keeps its last rejecting plane
+    // for the culler's plane coherency.
+    UINT Cull( FrustumCuller* pCuller, std::vector<UINT>* pVisible );
+
+    UINT GetObjectCount() const;
+    UINT GetNodeCount() const;
+
+    // Number of nodes the last Cull tested.
+    UINT GetNodesVisited() const;
+
+private:
+    // Nodes are in depth first order: the first child of an inner node is the
+    // node right after it.
+    struct Node
+    {
+        AxisAlignedBox Box;
+        UINT First;             // First object of the subtree in m_Objects.
+        UINT Count;             // Number of objects in the subtree.
+        UINT SecondChild;       // 0 for leaves.
+    };
+
+    UINT BuildNode( const AxisAlignedBox* pBoxes, UINT First, UINT Count );
+    VOID ComputeBounds( const AxisAlignedBox* pBoxes, UINT First, UINT Count, AxisAlignedBox* pOut ) const;
+
+    CullingHierarchy( const CullingHierarchy& rhs );
+    CullingHierarchy& operator=( const CullingHierarchy& rhs );
+
+private:
+    UINT m_LeafSize;
+
+    std::vector<Node> m_Nodes;
+
+    // Object indices in tree order, and their boxes in the same order for the
+    // leaf tests.
+    std::vector<UINT> m_Objects;
+    std::vector<AxisAlignedBox> m_Boxes;
+
+    // Last rejecting plane of every node and every object (in tree order).
+    std::vector<BYTE> m_NodeLastPlane;
+    std::vector<BYTE> m_ObjectLastPlane;
+
+    UINT m_NodesVisited;
+};
+
+}; // namespace
+
+#endif
@@ -0,0 +1,966 @@
+//-------------------------------------------------------------------------------------
+// DynamicAabbTree.cpp
+//
+// Dynamic bounding volume tree broadphase for moving objects, built on the XNA
+// collision library.
+//
+// The insertion heuristic and the rotations follow Erin Catto's b2DynamicTree
+// (Box2D), which in turn is based on Bullet's btDbvt.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include "DynamicAabbTree.h"
+
+namespace XNA
+{
+
+//-----------------------------------------------------------------------------
+// Small helpers working on the min/max form stored in the nodes.
+//-----------------------------------------------------------------------------
+static inline FLOAT SurfaceArea( const XMFLOAT3& Min, const XMFLOAT3& Max )
+{
+    FLOAT wx = Max.x - Min.x;
+    FLOAT wy = Max.y - Min.y;
+    FLOAT wz = Max.z - Min.z;
+
+    return 2.0f * ( wx * wy + wy * wz + wz * wx );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Traversal stack. A balanced tree never gets past the fixed part; a deeper
+// one (a degenerate tree) spills to the heap instead of overflowing it.
+//-----------------------------------------------------------------------------
+class NodeStack
+{
+public:
+    NodeStack() : m_Top( 0 ) {}
+
+    BOOL IsEmpty() const
+    {
+        return m_Top == 0;
+    }
+
+    VOID Push( UINT NodeId )
+    {
+        if( m_Top < FixedSize )
+            m_Fixed[m_Top] = NodeId;
+        else
+            m_Overflow.push_back( NodeId );
+        m_Top++;
+    }
+
+    UINT Pop()
+    {
+        m_Top--;
+        if( m_Top < FixedSize )
+            return m_Fixed[m_Top];
+        UINT NodeId = m_Overflow.back();
+        m_Overflow.pop_back();
+        return NodeId;
+    }
+
+private:
+    static const UINT FixedSize = 256;
+    UINT m_Fixed[FixedSize];
+    UINT m_Top;
+    std::vector<UINT> m_Overflow;
+};
+
+
+
+static inline VOID Combine( XMFLOAT3* pMin, XMFLOAT3* pMax, const XMFLOAT3& MinA, const XMFLOAT3& MaxA,
+                            const XMFLOAT3& MinB, const XMFLOAT3& MaxB )
+{
+    pMin->x = ( std::min )( MinA.x, MinB.x );
+    pMin->y = ( std::min )( MinA.y, MinB.y );
+    pMin->z = ( std::min )( MinA.z, MinB.z );
+    pMax->x = ( std::max )( MaxA.x, MaxB.x );
+    pMax->y = ( std::max )( MaxA.y, MaxB.y );
+    pMax->z = ( std::max )( MaxA.z, MaxB.z );
+}
+
+
+
+static inline BOOL Overlap( const XMFLOAT3& MinA, const XMFLOAT3& MaxA, const XMFLOAT3& MinB, const XMFLOAT3& MaxB )
+{
+    if( MinA.x > MaxB.x || MinB.x > MaxA.x )
+        return FALSE;
+
+    if( MinA.y > MaxB.y || MinB.y > MaxA.y )
+        return FALSE;
+
+    if( MinA.z > MaxB.z || MinB.z > MaxA.z )
+        return FALSE;
+
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// One axis of the MoveProxy test: the tight extent must lie inside the fat
+// one, and the fat one may not reach further than Slack plus the predicted
+// displacement past it on either side.
+//-----------------------------------------------------------------------------
+static inline BOOL FitsFatBox( FLOAT Min, FLOAT Max, FLOAT Center, FLOAT Extent, FLOAT Displacement, FLOAT Slack )
+{
+    FLOAT Lo = Center - Extent;
+    FLOAT Hi = Center + Extent;
+    FLOAT Limit = Slack + fabsf( Displacement );
+
+    return Min <= Lo && Hi <= Max && Min >= Lo - Limit && Max <= Hi + Limit;
+}
+
+
+
+static inline UINT64 PackPair( UINT A, UINT B )
+{
+    return ( A < B ) ? ( ( UINT64( A ) << 32 ) | B ) : ( ( UINT64( B ) << 32 ) | A );
+}
+
+
+
+static inline ProxyPair UnpackPair( UINT64 Key )
+{
+    ProxyPair Pair;
+    Pair.ProxyA = UINT( Key >> 32 );
+    Pair.ProxyB = UINT( Key & 0xffffffff );
+    return Pair;
+}
+
+
+
+//-----------------------------------------------------------------------------
+DynamicAabbTree::DynamicAabbTree( FLOAT Margin, FLOAT DisplacementScale ) :
+    m_Root( NullProxy ),
+    m_FreeList( NullProxy ),
+    m_ProxyCount( 0 ),
+    m_Margin( Margin ),
+    m_DisplacementScale( DisplacementScale )
+{
+    XMASSERT( Margin >= 0.0f );
+    XMASSERT( DisplacementScale >= 0.0f );
+}
+
+
+
+DynamicAabbTree::~DynamicAabbTree()
+{
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Node pool. Freed nodes are chained through Parent.
+//-----------------------------------------------------------------------------
+UINT DynamicAabbTree::AllocateNode()
+{
+    if( m_FreeList == NullProxy )
+    {
+        Node Empty = Node();
+        Empty.Height = -1;
+
+        Proxy EmptyProxy = Proxy();
+
+        m_Nodes.push_back( Empty );
+        m_Proxies.push_back( EmptyProxy );
+        m_Nodes.back().Parent = m_FreeList;
+        m_FreeList = UINT( m_Nodes.size() - 1 );
+    }
+
+    UINT NodeId = m_FreeList;
+    Node* pNode = &m_Nodes[NodeId];
+
+    m_FreeList = pNode->Parent;
+
+    pNode->Parent = NullProxy;
+    pNode->Child1 = NullProxy;
+    pNode->Child2 = NullProxy;
+    pNode->Height = 0;
+    pNode->Moved = FALSE;
+    m_Proxies[NodeId].pUserData = NULL;
+
+    return NodeId;
+}
+
+
+
+VOID DynamicAabbTree::FreeNode( UINT NodeId )
+{
+    XMASSERT( NodeId < m_Nodes.size() );
+
+    m_Nodes[NodeId].Parent = m_FreeList;
+    m_Nodes[NodeId].Height = -1;
+    m_FreeList = NodeId;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Grow the tight box by the margin and extend it along the displacement.
+//-----------------------------------------------------------------------------
+VOID DynamicAabbTree::ComputeFatBox( Node* pNode, const AxisAlignedBox* pBox, FXMVECTOR Displacement ) const
+{
+    XMVECTOR Center = XMLoadFloat3( &pBox->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pBox->Extents ) + XMVectorReplicate( m_Margin );
+
+    XMVECTOR Min = Center - Extents;
+    XMVECTOR Max = Center + Extents;
+
+    XMVECTOR D = Displacement * XMVectorReplicate( m_DisplacementScale );
+    Min += XMVectorMin( D, XMVectorZero() );
+    Max += XMVectorMax( D, XMVectorZero() );
+
+    XMStoreFloat3( &pNode->Min, Min );
+    XMStoreFloat3( &pNode->Max, Max );
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT DynamicAabbTree::CreateProxy( const AxisAlignedBox* pBox, VOID* pUserData )
+{
+    XMASSERT( pBox );
+
+    UINT ProxyId = AllocateNode();
+    Node* pNode = &m_Nodes[ProxyId];
+
+    m_Proxies[ProxyId].TightBox = *pBox;
+    m_Proxies[ProxyId].pUserData = pUserData;
+    pNode->Moved = TRUE;
+    ComputeFatBox( pNode, pBox, XMVectorZero() );
+
+    InsertLeaf( ProxyId );
+
+    m_MoveBuffer.push_back( ProxyId );
+    m_ProxyCount++;
+
+    return ProxyId;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// The leaf leaves the tree right away; the node id is only recycled once
+// UpdatePairs has reported the pairs it was part of.
+//-----------------------------------------------------------------------------
+VOID DynamicAabbTree::DestroyProxy( UINT ProxyId )
+{
+    XMASSERT( ProxyId < m_Nodes.size() );
+    XMASSERT( m_Nodes[ProxyId].Height == 0 );
+
+    RemoveLeaf( ProxyId );
+
+    // Mark the node so that it is neither queried nor freed twice.
+    m_Nodes[ProxyId].Height = -2;
+    m_Nodes[ProxyId].Moved = FALSE;
+
+    m_DestroyBuffer.push_back( ProxyId );
+    m_ProxyCount--;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Update the tight box of a proxy. Returns TRUE if the proxy had to be
+// re-inserted (its tight box escaped the fat box).
+//-----------------------------------------------------------------------------
+BOOL DynamicAabbTree::MoveProxy( UINT ProxyId, const AxisAlignedBox* pBox, FXMVECTOR Displacement )
+{
+    XMASSERT( ProxyId < m_Nodes.size() );
+    XMASSERT( m_Nodes[ProxyId].Height == 0 );
+    XMASSERT( pBox );
+
+    Node* pNode = &m_Nodes[ProxyId];
+    m_Proxies[ProxyId].TightBox = *pBox;
+
+    // Also refit when the fat box has become far too large for the object,
+    // otherwise a fast object that stopped keeps reporting stale pairs. The
+    // trailing side is allowed the predicted displacement as well, so a
+    // steadily moving object is only re-inserted when it reaches the front.
+    // Plain floats: this runs for every proxy every frame.
+    XMFLOAT3 D;
+    XMStoreFloat3( &D, Displacement );
+    FLOAT Slack = 5.0f * m_Margin;
+    if( FitsFatBox( pNode->Min.x, pNode->Max.x, pBox->Center.x, pBox->Extents.x, D.x * m_DisplacementScale, Slack ) &&
+        FitsFatBox( pNode->Min.y, pNode->Max.y, pBox->Center.y, pBox->Extents.y, D.y * m_DisplacementScale, Slack ) &&
+        FitsFatBox( pNode->Min.z, pNode->Max.z, pBox->Center.z, pBox->Extents.z, D.z * m_DisplacementScale, Slack ) )
+        return FALSE;
+
+    RemoveLeaf( ProxyId );
+
+    pNode = &m_Nodes[ProxyId];
+    ComputeFatBox( pNode, pBox, Displacement );
+
+    InsertLeaf( ProxyId );
+
+    pNode = &m_Nodes[ProxyId];
+    if( !pNode->Moved )
+    {
+        pNode->Moved = TRUE;
+        m_MoveBuffer.push_back( ProxyId );
+    }
+
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID* DynamicAabbTree::GetUserData( UINT ProxyId ) const
+{
+    XMASSERT( ProxyId < m_Nodes.size() );
+    return m_Proxies[ProxyId].pUserData;
+}
+
+
+
+const AxisAlignedBox* DynamicAabbTree::GetTightBox( UINT ProxyId ) const
+{
+    XMASSERT( ProxyId < m_Nodes.size() );
+    return &m_Proxies[ProxyId].TightBox;
+}
+
+
+
+VOID DynamicAabbTree::GetFatBox( UINT ProxyId, AxisAlignedBox* pOut ) const
+{
+    XMASSERT( ProxyId < m_Nodes.size() );
+    XMASSERT( pOut );
+
+    XMVECTOR Min = XMLoadFloat3( &m_Nodes[ProxyId].Min );
+    XMVECTOR Max = XMLoadFloat3( &m_Nodes[ProxyId].Max );
+
+    XMStoreFloat3( &pOut->Center, ( Min + Max ) * 0.5f );
+    XMStoreFloat3( &pOut->Extents, ( Max - Min ) * 0.5f );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Insert a leaf, choosing the sibling with the surface area heuristic.
+//-----------------------------------------------------------------------------
+VOID DynamicAabbTree::InsertLeaf( UINT Leaf )
+{
+    if( m_Root == NullProxy )
+    {
+        m_Root = Leaf;
+        m_Nodes[m_Root].Parent = NullProxy;
+        return;
+    }
+
+    // Find the best sibling for this leaf.
+    XMFLOAT3 LeafMin = m_Nodes[Leaf].Min;
+    XMFLOAT3 LeafMax = m_Nodes[Leaf].Max;
+
+    UINT Index = m_Root;
+    while( m_Nodes[Index].Height > 0 )
+    {
+        const Node& N = m_Nodes[Index];
+        UINT Child1 = N.Child1;
+        UINT Child2 = N.Child2;
+
+        FLOAT Area = SurfaceArea( N.Min, N.Max );
+
+        XMFLOAT3 CombinedMin, CombinedMax;
+        Combine( &CombinedMin, &CombinedMax, N.Min, N.Max, LeafMin, LeafMax );
+        FLOAT CombinedArea = SurfaceArea( CombinedMin, CombinedMax );
+
+        // Cost of creating a new parent for this node and the new leaf.
+        FLOAT Cost = 2.0f * CombinedArea;
+
+        // Minimum cost of pushing the leaf further down the tree.
+        FLOAT InheritanceCost = 2.0f * ( CombinedArea - Area );
+
+        // Cost of descending into each child.
+        FLOAT ChildCost[2];
+        UINT Children[2] = { Child1, Child2 };
+
+        for( INT i = 0; i < 2; i++ )
+        {
+            const Node& C = m_Nodes[Children[i]];
+
+            XMFLOAT3 Min, Max;
+            Combine( &Min, &Max, C.Min, C.Max, LeafMin, LeafMax );
+
+            if( C.Height == 0 )
+            {
+                ChildCost[i] = SurfaceArea( Min, Max ) + InheritanceCost;
+            }
+            else
+            {
+                FLOAT OldArea = SurfaceArea( C.Min, C.Max );
+                FLOAT NewArea = SurfaceArea( Min, Max );
+                ChildCost[i] = ( NewArea - OldArea ) + InheritanceCost;
+            }
+        }
+
+        // Descend according to the minimum cost.
+        if( Cost < ChildCost[0] && Cost < ChildCost[1] )
+            break;
+
+        Index = ( ChildCost[0] < ChildCost[1] ) ? Child1 : Child2;
+    }
+
+    UINT Sibling = Index;
+
+    // Create a new parent.
+    UINT OldParent = m_Nodes[Sibling].Parent;
+    UINT NewParent = AllocateNode();
+
+    Node* pNewParent = &m_Nodes[NewParent];
+    pNewParent->Parent = OldParent;
+    pNewParent->Height = m_Nodes[Sibling].Height + 1;
+    Combine( &pNewParent->Min, &pNewParent->Max, m_Nodes[Sibling].Min, m_Nodes[Sibling].Max, LeafMin, LeafMax );
+    pNewParent->Child1 = Sibling;
+    pNewParent->Child2 = Leaf;
+
+    if( OldParent != NullProxy )
+    {
+        // The sibling was not the root.
+        if( m_Nodes[OldParent].Child1 == Sibling )
+            m_Nodes[OldParent].Child1 = NewParent;
+        else
+            m_Nodes[OldParent].Child2 = NewParent;
+    }
+    else
+    {
+        // The sibling was the root.
+        m_Root = NewParent;
+    }
+
+    m_Nodes[Sibling].Parent = NewParent;
+    m_Nodes[Leaf].Parent = NewParent;
+
+    // Walk back up the tree fixing heights and boxes. The new parent is
+    // always balanced; above it the walk stops at the first node that does
+    // not change.
+    Index = NewParent;
+    Refit( &Index );
+    Index = m_Nodes[Index].Parent;
+    while( Index != NullProxy && Refit( &Index ) )
+        Index = m_Nodes[Index].Parent;
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID DynamicAabbTree::RemoveLeaf( UINT Leaf )
+{
+    if( Leaf == m_Root )
+    {
+        m_Root = NullProxy;
+        return;
+    }
+
+    UINT Parent = m_Nodes[Leaf].Parent;
+    UINT GrandParent = m_Nodes[Parent].Parent;
+    UINT Sibling = ( m_Nodes[Parent].Child1 == Leaf ) ? m_Nodes[Parent].Child2 : m_Nodes[Parent].Child1;
+
+    if( GrandParent != NullProxy )
+    {
+        // Destroy the parent and connect the sibling to the grand parent.
+        if( m_Nodes[GrandParent].Child1 == Parent )
+            m_Nodes[GrandParent].Child1 = Sibling;
+        else
+            m_Nodes[GrandParent].Child2 = Sibling;
+
+        m_Nodes[Sibling].Parent = GrandParent;
+        FreeNode( Parent );
+
+        // Adjust the ancestor bounds, up to the first one that does not change.
+        UINT Index = GrandParent;
+        while( Index != NullProxy && Refit( &Index ) )
+            Index = m_Nodes[Index].Parent;
+    }
+    else
+    {
+        m_Root = Sibling;
+        m_Nodes[Sibling].Parent = NullProxy;
+        FreeNode( Parent );
+    }
+
+    m_Nodes[Leaf].Parent = NullProxy;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Balance the node, then recompute its box and height from its children.
+// *pIndex gets the new root of the subtree. Returns FALSE if nothing changed:
+// no rotation, the same box and the same height, so the ancestors are left
+// as they are as well.
+//-----------------------------------------------------------------------------
+BOOL DynamicAabbTree::Refit( UINT* pIndex )
+{
+    UINT Top = Balance( *pIndex );
+
+    Node* pNode = &m_Nodes[Top];
+    const Node& C1 = m_Nodes[pNode->Child1];
+    const Node& C2 = m_Nodes[pNode->Child2];
+
+    XMFLOAT3 Min, Max;
+    Combine( &Min, &Max, C1.Min, C1.Max, C2.Min, C2.Max );
+    INT Height = 1 + ( std::max )( C1.Height, C2.Height );
+
+    BOOL Changed = Top != *pIndex || Height != pNode->Height || memcmp( &Min, &pNode->Min, sizeof( Min ) ) != 0 ||
+                   memcmp( &Max, &pNode->Max, sizeof( Max ) ) != 0;
+
+    pNode->Min = Min;
+    pNode->Max = Max;
+    pNode->Height = Height;
+    *pIndex = Top;
+    return Changed;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Perform a left or right rotation if node A is imbalanced.
+// Returns the new root of the subtree.
+//-----------------------------------------------------------------------------
+UINT DynamicAabbTree::Balance( UINT iA )
+{
+    XMASSERT( iA != NullProxy );
+
+    Node* A = &m_Nodes[iA];
+    if( A->Height < 2 )
+        return iA;
+
+    UINT iB = A->Child1;
+    UINT iC = A->Child2;
+    Node* B = &m_Nodes[iB];
+    Node* C = &m_Nodes[iC];
+
+    INT BalanceFactor = C->Height - B->Height;
+
+    // Rotate C up.
+    if( BalanceFactor > 1 )
+    {
+        UINT iF = C->Child1;
+        UINT iG = C->Child2;
+        Node* F = &m_Nodes[iF];
+        Node* G = &m_Nodes[iG];
+
+        // Swap A and C.
+        C->Child1 = iA;
+        C->Parent = A->Parent;
+        A->Parent = iC;
+
+        // A's old parent should point to C.
+        if( C->Parent != NullProxy )
+        {
+            if( m_Nodes[C->Parent].Child1 == iA )
+                m_Nodes[C->Parent].Child1 = iC;
+            else
+                m_Nodes[C->Parent].Child2 = iC;
+        }
+        else
+        {
+            m_Root = iC;
+        }
+
+        // Rotate.
+        if( F->Height > G->Height )
+        {
+            C->Child2 = iF;
+            A->Child2 = iG;
+            G->Parent = iA;
+            Combine( &A->Min, &A->Max, B->Min, B->Max, G->Min, G->Max );
+            Combine( &C->Min, &C->Max, A->Min, A->Max, F->Min, F->Max );
+
+            A->Height = 1 + ( std::max )( B->Height, G->Height );
+            C->Height = 1 + ( std::max )( A->Height, F->Height );
+        }
+        else
+        {
+            C->Child2 = iG;
+            A->Child2 = iF;
+            F->Parent = iA;
+            Combine( &A->Min, &A->Max, B->Min, B->Max, F->Min, F->Max );
+            Combine( &C->Min, &C->Max, A->Min, A->Max, G->Min, G->Max );
+
+            A->Height = 1 + ( std::max )( B->Height, F->Height );
+            C->Height = 1 + ( std::max )( A->Height, G->Height );
+        }
+
+        return iC;
+    }
+
+    // Rotate B up.
+    if( BalanceFactor < -1 )
+    {
+        UINT iD = B->Child1;
+        UINT iE = B->Child2;
+        Node* D = &m_Nodes[iD];
+        Node* E = &m_Nodes[iE];
+
+        // Swap A and B.
+        B->Child1 = iA;
+        B->Parent = A->Parent;
+        A->Parent = iB;
+
+        // A's old parent should point to B.
+        if( B->Parent != NullProxy )
+        {
+            if( m_Nodes[B->Parent].Child1 == iA )
+                m_Nodes[B->Parent].Child1 = iB;
+            else
+                m_Nodes[B->Parent].Child2 = iB;
+        }
+        else
+        {
+            m_Root = iB;
+        }
+
+        // Rotate.
+        if( D->Height > E->Height )
+        {
+            B->Child2 = iD;
+            A->Child1 = iE;
+            E->Parent = iA;
+            Combine( &A->Min, &A->Max, C->Min, C->Max, E->Min, E->Max );
+            Combine( &B->Min, &B->Max, A->Min, A->Max, D->Min, D->Max );
+
+            A->Height = 1 + ( std::max )( C->Height, E->Height );
+            B->Height = 1 + ( std::max )( A->Height, D->Height );
+        }
+        else
+        {
+            B->Child2 = iE;
+            A->Child1 = iD;
+            D->Parent = iA;
+            Combine( &A->Min, &A->Max, C->Min, C->Max, D->Min, D->Max );
+            Combine( &B->Min, &B->Max, A->Min, A->Max, E->Min, E->Max );
+
+            A->Height = 1 + ( std::max )( C->Height, D->Height );
+            B->Height = 1 + ( std::max )( A->Height, E->Height );
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Top down rebuild: the leaves are split in halves at the median of their
+// centers along the longest axis of the centers, recursively. The leaves keep
+// their ids, only the internal nodes are allocated again.
+//-----------------------------------------------------------------------------
+VOID DynamicAabbTree::Rebuild()
+{
+    std::vector<UINT> Leaves;
+    Leaves.reserve( m_ProxyCount );
+
+    for( UINT i = 0; i < UINT( m_Nodes.size() ); i++ )
+    {
+        if( m_Nodes[i].Height == 0 )
+            Leaves.push_back( i );
+        else if( m_Nodes[i].Height > 0 )
+            FreeNode( i );
+    }
+
+    m_Root = Leaves.empty() ? NullProxy : BuildSubtree( &Leaves[0], UINT( Leaves.size() ), NullProxy );
+}
+
+
+
+UINT DynamicAabbTree::BuildSubtree( UINT* pLeaves, UINT Count, UINT Parent )
+{
+    XMASSERT( Count > 0 );
+
+    if( Count == 1 )
+    {
+        m_Nodes[pLeaves[0]].Parent = Parent;
+        return pLeaves[0];
+    }
+
+    // Bounds of the centers, doubled.
+    XMFLOAT3 Min( FLT_MAX, FLT_MAX, FLT_MAX );
+    XMFLOAT3 Max( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+    for( UINT i = 0; i < Count; i++ )
+    {
+        const Node& N = m_Nodes[pLeaves[i]];
+        XMFLOAT3 Center( N.Min.x + N.Max.x, N.Min.y + N.Max.y, N.Min.z + N.Max.z );
+        Combine( &Min, &Max, Min, Max, Center, Center );
+    }
+
+    FLOAT wx = Max.x - Min.x;
+    FLOAT wy = Max.y - Min.y;
+    FLOAT wz = Max.z - Min.z;
+    INT Axis = ( wx >= wy && wx >= wz ) ? 0 : ( wy >= wz ) ? 1 : 2;
+
+    const Node* pNodes = &m_Nodes[0];
+    UINT Half = Count / 2;
+    std::nth_element( pLeaves, pLeaves + Half, pLeaves + Count, [pNodes, Axis]( UINT a, UINT b )
+    {
+        return ( &pNodes[a].Min.x )[Axis] + ( &pNodes[a].Max.x )[Axis] <
+               ( &pNodes[b].Min.x )[Axis] + ( &pNodes[b].Max.x )[Axis];
+    } );
+
+    UINT NodeId = AllocateNode();
+    m_Nodes[NodeId].Parent = Parent;
+
+    UINT Child1 = BuildSubtree( pLeaves, Half, NodeId );
+    UINT Child2 = BuildSubtree( pLeaves + Half, Count - Half, NodeId );
+
+    Node* pNode = &m_Nodes[NodeId];
+    const Node& C1 = m_Nodes[Child1];
+    const Node& C2 = m_Nodes[Child2];
+    pNode->Child1 = Child1;
+    pNode->Child2 = Child2;
+    pNode->Height = 1 + ( std::max )( C1.Height, C2.Height );
+    Combine( &pNode->Min, &pNode->Max, C1.Min, C1.Max, C2.Min, C2.Max );
+
+    return NodeId;
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID DynamicAabbTree::Query( const AxisAlignedBox* pBox, std::vector<UINT>* pResults ) const
+{
+    XMASSERT( pBox );
+    XMASSERT( pResults );
+
+    if( m_Root == NullProxy )
+        return;
+
+    XMFLOAT3 Min( pBox->Center.x - pBox->Extents.x, pBox->Center.y - pBox->Extents.y,
+                  pBox->Center.z - pBox->Extents.z );
+    XMFLOAT3 Max( pBox->Center.x + pBox->Extents.x, pBox->Center.y + pBox->Extents.y,
+                  pBox->Center.z + pBox->Extents.z );
+
+    NodeStack Stack;
+    Stack.Push( m_Root );
+
+    while( !Stack.IsEmpty() )
+    {
+        UINT NodeId = Stack.Pop();
+        const Node& N = m_Nodes[NodeId];
+
+        if( !Overlap( N.Min, N.Max, Min, Max ) )
+            continue;
+
+        if( N.Height == 0 )
+        {
+            pResults->push_back( NodeId );
+        }
+        else
+        {
+            Stack.Push( N.Child1 );
+            Stack.Push( N.Child2 );
+        }
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Find the pairs of all proxies that moved since the last call and merge them
+// with the persistent pair list. Pairs between proxies that did not move can
+// not have changed because their fat boxes did not change.
+//-----------------------------------------------------------------------------
+VOID DynamicAabbTree::UpdatePairs( std::vector<ProxyPair>* pAdded, std::vector<ProxyPair>* pRemoved )
+{
+    if( pAdded )
+        pAdded->clear();
+    if( pRemoved )
+        pRemoved->clear();
+
+    // Nothing moved, nothing changed: the merge would only copy the pairs.
+    if( m_MoveBuffer.empty() && m_DestroyBuffer.empty() )
+        return;
+
+    m_Candidates.clear();
+
+    // Query the tree with the fat box of every moved proxy.
+    NodeStack Stack;
+    for( size_t i = 0; i < m_MoveBuffer.size(); i++ )
+    {
+        UINT QueryId = m_MoveBuffer[i];
+        const Node& Q = m_Nodes[QueryId];
+
+        if( Q.Height != 0 || !Q.Moved )
+            continue;
+
+        if( m_Root != NullProxy )
+            Stack.Push( m_Root );
+
+        while( !Stack.IsEmpty() )
+        {
+            UINT NodeId = Stack.Pop();
+            const Node& N = m_Nodes[NodeId];
+
+            if( !Overlap( N.Min, N.Max, Q.Min, Q.Max ) )
+                continue;
+
+            if( N.Height > 0 )
+            {
+                Stack.Push( N.Child1 );
+                Stack.Push( N.Child2 );
+                continue;
+            }
+
+            if( NodeId == QueryId )
+                continue;
+
+            // Both proxies moved: only the lower id reports the pair.
+            if( N.Moved && NodeId < QueryId )
+                continue;
+
+            m_Candidates.push_back( PackPair( QueryId, NodeId ) );
+        }
+    }
+
+    std::sort( m_Candidates.begin(), m_Candidates.end() );
+
+    // Merge: old pairs between two unmoved live proxies are kept as they are,
+    // old pairs touching a moved or destroyed proxy survive only if they were
+    // found again.
+    m_Merged.clear();
+    m_Merged.reserve( m_Pairs.size() + m_Candidates.size() );
+
+    size_t i = 0, j = 0;
+    while( i < m_Pairs.size() || j < m_Candidates.size() )
+    {
+        if( j == m_Candidates.size() || ( i < m_Pairs.size() && m_Pairs[i] < m_Candidates[j] ) )
+        {
+            ProxyPair Pair = UnpackPair( m_Pairs[i] );
+            const Node& A = m_Nodes[Pair.ProxyA];
+            const Node& B = m_Nodes[Pair.ProxyB];
+
+            if( A.Height == 0 && B.Height == 0 && !A.Moved && !B.Moved )
+                m_Merged.push_back( m_Pairs[i] );
+            else if( pRemoved )
+                pRemoved->push_back( Pair );
+
+            i++;
+        }
+        else if( i == m_Pairs.size() || m_Candidates[j] < m_Pairs[i] )
+        {
+            m_Merged.push_back( m_Candidates[j] );
+
+            if( pAdded )
+                pAdded->push_back( UnpackPair( m_Candidates[j] ) );
+
+            j++;
+        }
+        else
+        {
+            // Found again.
+            m_Merged.push_back( m_Candidates[j] );
+            i++;
+            j++;
+        }
+    }
+
+    m_Pairs.swap( m_Merged );
+
+    // Reset the move buffer.
+    for( size_t k = 0; k < m_MoveBuffer.size(); k++ )
+        m_Nodes[m_MoveBuffer[k]].Moved = FALSE;
+
+    m_MoveBuffer.clear();
+
+    // The destroyed proxies have been reported, their ids may now be recycled.
+    for( size_t k = 0; k < m_DestroyBuffer.size(); k++ )
+        FreeNode( m_DestroyBuffer[k] );
+
+    m_DestroyBuffer.clear();
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT DynamicAabbTree::GetPairCount() const
+{
+    return UINT( m_Pairs.size() );
+}
+
+
+
+ProxyPair DynamicAabbTree::GetPair( UINT Index ) const
+{
+    XMASSERT( Index < m_Pairs.size() );
+    return UnpackPair( m_Pairs[Index] );
+}
+
+
+
+UINT DynamicAabbTree::GetProxyCount() const
+{
+    return m_ProxyCount;
+}
+
+
+
+INT DynamicAabbTree::GetHeight() const
+{
+    if( m_Root == NullProxy )
+        return 0;
+
+    return m_Nodes[m_Root].Height;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Sum of the node surface areas relative to the root surface area. Lower is
+// better.
+//-----------------------------------------------------------------------------
+FLOAT DynamicAabbTree::GetAreaRatio() const
+{
+    if( m_Root == NullProxy )
+        return 0.0f;
+
+    FLOAT RootArea = SurfaceArea( m_Nodes[m_Root].Min, m_Nodes[m_Root].Max );
+
+    FLOAT TotalArea = 0.0f;
+    for( size_t i = 0; i < m_Nodes.size(); i++ )
+    {
+        // Skip free nodes and destroyed leaves that are not recycled yet.
+        const Node& N = m_Nodes[i];
+        if( N.Height < 0 )
+            continue;
+
+        TotalArea += SurfaceArea( N.Min, N.Max );
+    }
+
+    return ( RootArea > 0.0f ) ? TotalArea / RootArea : 0.0f;
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT FilterPairsAxisAlignedBox( const DynamicAabbTree* pTree, const ProxyPair* pPairs, UINT Count,
+                                std::vector<ProxyPair>* pOut )
+{
+    XMASSERT( pTree );
+    XMASSERT( pPairs || Count == 0 );
+    XMASSERT( pOut );
+
+    UINT Kept = 0;
+
+    for( UINT i = 0; i < Count; i++ )
+    {
+        if( IntersectAxisAlignedBoxAxisAlignedBox( pTree->GetTightBox( pPairs[i].ProxyA ),
+                                                   pTree->GetTightBox( pPairs[i].ProxyB ) ) )
+        {
+            pOut->push_back( pPairs[i] );
+            Kept++;
+        }
+    }
+
+    return Kept;
+}
+
+}; // namespace
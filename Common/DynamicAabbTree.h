@@ -0,0 +1,151 @@
+//-------------------------------------------------------------------------------------
+// DynamicAabbTree.h
+//
+// Dynamic bounding volume tree broadphase for moving objects, built on the XNA
+// collision library.
+//
+// Every proxy is stored as a leaf holding a "fat" axis aligned box: the tight
+// box of the object grown by a margin and by the predicted displacement. While
+// the tight box stays inside the fat box the tree is not touched, so objects
+// that move a little every frame cost almost nothing. Leaves that escape are
+// removed and re-inserted, and the tree is kept balanced with AVL style
+// rotations on the way back up.
+//
+// UpdatePairs() queries the tree once per re-inserted proxy and compares the
+// result against the pairs of the previous call, so only new and removed
+// overlaps are reported. The pairs are fat box overlaps; use the tight boxes
+// (or the user data) with the narrowphase routines in xnacollision.h to get
+// the real contacts, see FilterPairsAxisAlignedBox().
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _DYNAMIC_AABB_TREE_H_
+#define _DYNAMIC_AABB_TREE_H_
+
+#include <vector>
+#include "xnacollision.h"
+
+namespace XNA
+{
+
+//-----------------------------------------------------------------------------
+// A pair of overlapping proxies. ProxyA is always less than ProxyB.
+//-----------------------------------------------------------------------------
+struct ProxyPair
+{
+    UINT ProxyA;
+    UINT ProxyB;
+};
+
+class DynamicAabbTree
+{
+public:
+    static const UINT NullProxy = 0xffffffff;
+
+    // Margin is added on every side of the tight box of a proxy.
+    // DisplacementScale scales the displacement passed to MoveProxy before the
+    // fat box is extended in the direction of motion: with the displacement of
+    // one frame, the number of frames of steady motion the fat box covers.
+    DynamicAabbTree( FLOAT Margin = 0.1f, FLOAT DisplacementScale = 2.0f );
+    ~DynamicAabbTree();
+
+    // Proxy management.
+    UINT CreateProxy( const AxisAlignedBox* pBox, VOID* pUserData );
+    VOID DestroyProxy( UINT ProxyId );
+    BOOL MoveProxy( UINT ProxyId, const AxisAlignedBox* pBox, FXMVECTOR Displacement );
+
+    VOID* GetUserData( UINT ProxyId ) const;
+    const AxisAlignedBox* GetTightBox( UINT ProxyId ) const;
+    VOID GetFatBox( UINT ProxyId, AxisAlignedBox* pOut ) const;
+
+    // Rebuild the internal nodes top down. Inserting many proxies one by one
+    // in no particular order leaves a tree several times more costly to query
+    // than one split at the medians; call it after creating them in bulk.
+    // Proxy ids do not change.
+    VOID Rebuild();
+
+    // Report the pairs that started and stopped overlapping since the last call.
+    // Either output may be NULL.
+    VOID UpdatePairs( std::vector<ProxyPair>* pAdded, std::vector<ProxyPair>* pRemoved );
+
+    // All pairs currently overlapping (as of the last UpdatePairs).
+    UINT GetPairCount() const;
+    ProxyPair GetPair( UINT Index ) const;
+
+    // Append the proxies whose fat boxes overlap the box.
+    VOID Query( const AxisAlignedBox* pBox, std::vector<UINT>* pResults ) const;
+
+    // Rebuild quality statistics.
+    UINT GetProxyCount() const;
+    INT GetHeight() const;
+    FLOAT GetAreaRatio() const;
+
+private:
+    // Only what the traversals touch lives in the node, so that a query
+    // streams through as few cache lines as possible.
+    struct Node
+    {
+        XMFLOAT3 Min;
+        UINT Parent;                // Next free node when the node is on the free list.
+        XMFLOAT3 Max;
+        INT Height;                 // 0 for leaves, -1 for free nodes.
+        UINT Child1;
+        UINT Child2;
+        BOOL Moved;
+    };
+
+    // Per leaf data, indexed like m_Nodes.
+    struct Proxy
+    {
+        AxisAlignedBox TightBox;
+        VOID* pUserData;
+    };
+
+    UINT AllocateNode();
+    VOID FreeNode( UINT NodeId );
+    VOID InsertLeaf( UINT Leaf );
+    VOID RemoveLeaf( UINT Leaf );
+    UINT Balance( UINT NodeId );
+    BOOL Refit( UINT* pIndex );
+    UINT BuildSubtree( UINT* pLeaves, UINT Count, UINT Parent );
+    VOID ComputeFatBox( Node* pNode, const AxisAlignedBox* pBox, FXMVECTOR Displacement ) const;
+
+    DynamicAabbTree( const DynamicAabbTree& rhs );
+    DynamicAabbTree& operator=( const DynamicAabbTree& rhs );
+
+private:
+    std::vector<Node> m_Nodes;
+    std::vector<Proxy> m_Proxies;
+    UINT m_Root;
+    UINT m_FreeList;
+    UINT m_ProxyCount;
+
+    FLOAT m_Margin;
+    FLOAT m_DisplacementScale;
+
+    // Proxies created or re-inserted since the last UpdatePairs.
+    std::vector<UINT> m_MoveBuffer;
+
+    // Proxies destroyed since the last UpdatePairs. Their nodes are kept off
+    // the free list until then so the ids are not recycled too early.
+    std::vector<UINT> m_DestroyBuffer;
+
+    // Sorted overlapping pairs, packed as (ProxyA << 32) | ProxyB.
+    std::vector<UINT64> m_Pairs;
+    std::vector<UINT64> m_Candidates;
+    std::vector<UINT64> m_Merged;
+};
+
+
+
+//-----------------------------------------------------------------------------
+// Narrowphase helper: keep only the pairs whose tight boxes really intersect
+// (IntersectAxisAlignedBoxAxisAlignedBox). Returns the number of pairs kept.
+//-----------------------------------------------------------------------------
+UINT FilterPairsAxisAlignedBox( const DynamicAabbTree* pTree, const ProxyPair* pPairs, UINT Count,
+                                std::vector<ProxyPair>* pOut );
+
+}; // namespace
+
+#endif
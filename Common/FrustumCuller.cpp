@@ -0,0 +1,363 @@
+//-------------------------------------------------------------------------------------
+// FrustumCuller.cpp
+//
+// View frustum culling with plane coherency, octant tests and plane masking.
+//-------------------------------------------------------------------------------------
+
+#include <cmath>
+#include "FrustumCuller.h"
+
+namespace XNA
+{
+
+//-----------------------------------------------------------------------------
+// The volumes as seen by the plane loop: a center and the half length of the
+// projection of the volume onto a plane normal.
+//-----------------------------------------------------------------------------
+struct CullSphereVolume
+{
+    XMFLOAT3 Center;
+    FLOAT Radius;
+
+    FLOAT ProjectedRadius( const FrustumCuller::CullPlane& ) const
+    {
+        return Radius;
+    }
+};
+
+struct CullBoxVolume
+{
+    XMFLOAT3 Center;
+    XMFLOAT3 Extents;
+
+    // Distance from the center to the corner farthest along the normal.
+    FLOAT ProjectedRadius( const FrustumCuller::CullPlane& P ) const
+    {
+        return Extents.x * P.AbsNormal.x + Extents.y * P.AbsNormal.y + Extents.z * P.AbsNormal.z;
+    }
+};
+
+struct CullOrientedBoxVolume
+{
+    XMFLOAT3 Center;
+    XMFLOAT3 Axis[3];           // Box axes scaled by the extents.
+
+    FLOAT ProjectedRadius( const FrustumCuller::CullPlane& P ) const
+    {
+        FLOAT r = 0.0f;
+        for( UINT i = 0; i < 3; i++ )
+            r += fabsf( Axis[i].x * P.Plane.x + Axis[i].y * P.Plane.y + Axis[i].z * P.Plane.z );
+        return r;
+    }
+};
+
+
+
+//-----------------------------------------------------------------------------
+// Returns 0 when the volume is outside the plane, 1 when it straddles it and
+// 2 when it is inside.
+//-----------------------------------------------------------------------------
+template<class Volume>
+static inline INT TestPlane( const Volume& V, const FrustumCuller::CullPlane& P )
+{
+    FLOAT Dist = V.Center.x * P.Plane.x + V.Center.y * P.Plane.y + V.Center.z * P.Plane.z + P.Plane.w;
+    FLOAT Radius = V.ProjectedRadius( P );
+
+    if( Dist > Radius )
+        return 0;
+
+    if( Dist < -Radius )
+        return 2;
+
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Test the planes of PlaneMask, the last rejecting plane first unless plane
+// coherency is off.
+//-----------------------------------------------------------------------------
+template<class Volume>
+static inline INT CullVolume( const FrustumCuller::CullPlane* pPlanes, const Volume& V, BYTE* pLastPlane,
+                              BOOL PlaneCoherency, UINT PlaneMask, UINT* pOutMask, UINT64* pPlanesTested )
+{
+    UINT Straddled = 0;
+    UINT Tested = 0;
+
+    UINT First = *pLastPlane;
+    if( PlaneCoherency && First < 6 && ( PlaneMask & ( 1 << First ) ) )
+    {
+        Tested++;
+        INT Result = TestPlane( V, pPlanes[First] );
+        if( Result == 0 )
+        {
+            *pPlanesTested += Tested;
+            if( pOutMask )
+                *pOutMask = 0;
+            return 0;
+        }
+
+        if( Result == 1 )
+            Straddled |= 1 << First;
+
+        PlaneMask &= ~( 1 << First );
+    }
+
+    for( UINT i = 0; PlaneMask; i++, PlaneMask >>= 1 )
+    {
+        if( !( PlaneMask & 1 ) )
+            continue;
+
+        Tested++;
+        INT Result = TestPlane( V, pPlanes[i] );
+        if( Result == 0 )
+        {
+            *pLastPlane = BYTE( i );
+            *pPlanesTested += Tested;
+            if( pOutMask )
+                *pOutMask = 0;
+            return 0;
+        }
+
+        if( Result == 1 )
+            Straddled |= 1 << i;
+    }
+
+    *pPlanesTested += Tested;
+    if( pOutMask )
+        *pOutMask = Straddled;
+
+    return Straddled ? 1 : 2;
+}
+
+
+
+static inline VOID LoadVolume( CullSphereVolume* pOut, const Sphere* pVolume )
+{
+    pOut->Center = pVolume->Center;
+    pOut->Radius = pVolume->Radius;
+}
+
+
+
+static inline VOID LoadVolume( CullBoxVolume* pOut, const AxisAlignedBox* pVolume )
+{
+    pOut->Center = pVolume->Center;
+    pOut->Extents = pVolume->Extents;
+}
+
+
+
+static inline VOID LoadVolume( CullOrientedBoxVolume* pOut, const OrientedBox* pVolume )
+{
+    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+
+    XMMATRIX R = XMMatrixRotationQuaternion( Orientation );
+
+    pOut->Center = pVolume->Center;
+    XMStoreFloat3( &pOut->Axis[0], R.r[0] * XMVectorReplicate( pVolume->Extents.x ) );
+    XMStoreFloat3( &pOut->Axis[1], R.r[1] * XMVectorReplicate( pVolume->Extents.y ) );
+    XMStoreFloat3( &pOut->Axis[2], R.r[2] * XMVectorReplicate( pVolume->Extents.z ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+FrustumCuller::FrustumCuller() :
+    m_PlaneCoherency( TRUE ),
+    m_VolumesTested( 0 ),
+    m_PlanesTested( 0 )
+{
+    // Accept everything until the planes are set.
+    for( UINT i = 0; i < 6; i++ )
+    {
+        m_Planes[i].Plane = XMFLOAT4( 0.0f, 0.0f, 0.0f, -1.0f );
+        m_Planes[i].AbsNormal = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+    }
+}
+
+
+
+FrustumCuller::~FrustumCuller()
+{
+}
+
+
+
+VOID FrustumCuller::SetFrustum( const Frustum* pVolume )
+{
+    XMASSERT( pVolume );
+
+    XMVECTOR Planes[6];
+    ComputePlanesFromFrustum( pVolume, &Planes[0], &Planes[1], &Planes[2], &Planes[3], &Planes[4], &Planes[5] );
+
+    SetPlanes( Planes[0], Planes[1], Planes[2], Planes[3], Planes[4], Planes[5] );
+}
+
+
+
+VOID FrustumCuller::SetPlanes( FXMVECTOR Plane0, FXMVECTOR Plane1, FXMVECTOR Plane2, CXMVECTOR Plane3,
+                               CXMVECTOR Plane4, CXMVECTOR Plane5 )
+{
+    XMVECTOR Planes[6] = { Plane0, Plane1, Plane2, Plane3, Plane4, Plane5 };
+
+    for( UINT i = 0; i < 6; i++ )
+    {
+        XMStoreFloat4( &m_Planes[i].Plane, Planes[i] );
+        XMStoreFloat3( &m_Planes[i].AbsNormal, XMVectorAbs( Planes[i] ) );
+    }
+}
+
+
+
+VOID FrustumCuller::EnablePlaneCoherency( BOOL Enable )
+{
+    m_PlaneCoherency = Enable;
+}
+
+
+
+VOID FrustumCuller::ResetStats()
+{
+    m_VolumesTested = 0;
+    m_PlanesTested = 0;
+}
+
+
+
+UINT64 FrustumCuller::GetVolumesTested() const
+{
+    return m_VolumesTested;
+}
+
+
+
+UINT64 FrustumCuller::GetPlanesTested() const
+{
+    return m_PlanesTested;
+}
+
+
+
+//-----------------------------------------------------------------------------
+INT FrustumCuller::CullSphere( const Sphere* pVolume, BYTE* pLastPlane, UINT PlaneMask, UINT* pOutMask )
+{
+    XMASSERT( pVolume );
+    XMASSERT( pLastPlane );
+
+    CullSphereVolume V;
+    LoadVolume( &V, pVolume );
+
+    m_VolumesTested++;
+    return CullVolume( m_Planes, V, pLastPlane, m_PlaneCoherency, PlaneMask, pOutMask, &m_PlanesTested );
+}
+
+
+
+INT FrustumCuller::CullAxisAlignedBox( const AxisAlignedBox* pVolume, BYTE* pLastPlane, UINT PlaneMask,
+                                       UINT* pOutMask )
+{
+    XMASSERT( pVolume );
+    XMASSERT( pLastPlane );
+
+    CullBoxVolume V;
+    LoadVolume( &V, pVolume );
+
+    m_VolumesTested++;
+    return CullVolume( m_Planes, V, pLastPlane, m_PlaneCoherency, PlaneMask, pOutMask, &m_PlanesTested );
+}
+
+
+
+INT FrustumCuller::CullOrientedBox( const OrientedBox* pVolume, BYTE* pLastPlane, UINT PlaneMask, UINT* pOutMask )
+{
+    XMASSERT( pVolume );
+    XMASSERT( pLastPlane );
+
+    CullOrientedBoxVolume V;
+    LoadVolume( &V, pVolume );
+
+    m_VolumesTested++;
+    return CullVolume( m_Planes, V, pLastPlane, m_PlaneCoherency, PlaneMask, pOutMask, &m_PlanesTested );
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID FrustumCuller::ResizeState( UINT Count )
+{
+    if( m_LastPlane.size() != Count )
+        m_LastPlane.assign( Count, 0 );
+}
+
+
+
+template<class Volume, class Source>
+static UINT CullArray( const FrustumCuller::CullPlane* pPlanes, const Source* pVolumes, UINT Count,
+                       BYTE* pLastPlanes, BOOL PlaneCoherency, BYTE* pResults, UINT64* pPlanesTested )
+{
+    UINT Visible = 0;
+    UINT64 PlanesTested = 0;
+
+    for( UINT i = 0; i < Count; i++ )
+    {
+        Volume V;
+        LoadVolume( &V, &pVolumes[i] );
+
+        INT Result = CullVolume( pPlanes, V, &pLastPlanes[i], PlaneCoherency, FrustumCuller::AllPlanes, NULL,
+                                 &PlanesTested );
+
+        pResults[i] = BYTE( Result );
+        Visible += ( Result != 0 );
+    }
+
+    *pPlanesTested += PlanesTested;
+
+    return Visible;
+}
+
+
+
+UINT FrustumCuller::CullSpheres( const Sphere* pVolumes, UINT Count, BYTE* pResults )
+{
+    XMASSERT( pVolumes || Count == 0 );
+    XMASSERT( pResults || Count == 0 );
+
+    ResizeState( Count );
+    m_VolumesTested += Count;
+
+    return CullArray<CullSphereVolume>( m_Planes, pVolumes, Count, m_LastPlane.data(), m_PlaneCoherency, pResults,
+                                        &m_PlanesTested );
+}
+
+
+
+UINT FrustumCuller::CullAxisAlignedBoxes( const AxisAlignedBox* pVolumes, UINT Count, BYTE* pResults )
+{
+    XMASSERT( pVolumes || Count == 0 );
+    XMASSERT( pResults || Count == 0 );
+
+    ResizeState( Count );
+    m_VolumesTested += Count;
+
+    return CullArray<CullBoxVolume>( m_Planes, pVolumes, Count, m_LastPlane.data(), m_PlaneCoherency, pResults,
+                                     &m_PlanesTested );
+}
+
+
+
+UINT FrustumCuller::CullOrientedBoxes( const OrientedBox* pVolumes, UINT Count, BYTE* pResults )
+{
+    XMASSERT( pVolumes || Count == 0 );
+    XMASSERT( pResults || Count == 0 );
+
+    ResizeState( Count );
+    m_VolumesTested += Count;
+
+    return CullArray<CullOrientedBoxVolume>( m_Planes, pVolumes, Count, m_LastPlane.data(), m_PlaneCoherency,
+                                             pResults, &m_PlanesTested );
+}
+
+}; // namespace
@@ -0,0 +1,105 @@
+//-------------------------------------------------------------------------------------
+// FrustumCuller.h
+//
+// View frustum culling of many volumes against the same six planes, for when
+// the same objects are culled frame after frame. Gives the same answers as the
+// Intersect*6Planes routines in xnacollision.h (0 = outside, 1 = intersecting,
+// 2 = inside) while testing fewer planes:
+//
+// - Plane coherency: the plane that rejected a volume is remembered (one byte
+//   of state per volume) and tested first the next time. A camera moves little
+//   between frames, so the same plane usually rejects the volume again after a
+//   single test.
+// - Octant test: the absolute value of every plane normal is computed once in
+//   SetPlanes. The projected radius of an axis aligned box (the distance from
+//   its center to the corner nearest or farthest along the normal, whose
+//   octant follows from the signs of the normal) is then a single dot product.
+// - Plane masking: a volume only has to be tested against the planes its
+//   parent straddles. The planes a volume straddles are returned as a mask to
+//   pass down to its children; a mask of zero means fully inside, and nothing
+//   below it needs testing at all.
+//
+// Planes are numbered 0-5 in the order of ComputePlanesFromFrustum (near, far,
+// right, left, top, bottom). Outside is the positive side of a plane.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _FRUSTUM_CULLER_H_
+#define _FRUSTUM_CULLER_H_
+
+#include <vector>
+#include "xnacollision.h"
+
+namespace XNA
+{
+
+class FrustumCuller
+{
+public:
+    // Plane masks have bit i set when plane i has to be tested.
+    static const UINT AllPlanes = 0x3f;
+
+    FrustumCuller();
+    ~FrustumCuller();
+
+    VOID SetFrustum( const Frustum* pVolume );
+    VOID SetPlanes( FXMVECTOR Plane0, FXMVECTOR Plane1, FXMVECTOR Plane2, CXMVECTOR Plane3, CXMVECTOR Plane4,
+                    CXMVECTOR Plane5 );
+
+    // Test one volume against the planes in PlaneMask, starting with plane
+    // *pLastPlane (0-5, any value is fine the first time). When the volume is
+    // rejected *pLastPlane is set to the rejecting plane. pOutMask may be NULL,
+    // otherwise it receives the planes of PlaneMask the volume straddles (zero
+    // unless the return value is 1).
+    INT CullSphere( const Sphere* pVolume, BYTE* pLastPlane, UINT PlaneMask = AllPlanes, UINT* pOutMask = NULL );
+    INT CullAxisAlignedBox( const AxisAlignedBox* pVolume, BYTE* pLastPlane, UINT PlaneMask = AllPlanes,
+                            UINT* pOutMask = NULL );
+    INT CullOrientedBox( const OrientedBox* pVolume, BYTE* pLastPlane, UINT PlaneMask = AllPlanes,
+                         UINT* pOutMask = NULL );
+
+    // Cull a whole array, keeping the last rejecting plane of every volume in
+    // the culler. The state is reset whenever Count changes, so keep one culler
+    // per array. pResults receives one result per volume (0, 1 or 2); returns
+    // the number of volumes that are not outside.
+    UINT CullSpheres( const Sphere* pVolumes, UINT Count, BYTE* pResults );
+    UINT CullAxisAlignedBoxes( const AxisAlignedBox* pVolumes, UINT Count, BYTE* pResults );
+    UINT CullOrientedBoxes( const OrientedBox* pVolumes, UINT Count, BYTE* pResults );
+
+    // Plane coherency (on by default) can be turned off to measure what it
+    // saves; the planes are then tested in order and *pLastPlane is only
+    // written.
+    VOID EnablePlaneCoherency( BOOL Enable );
+
+    // Number of volume and plane tests since the last ResetStats.
+    VOID ResetStats();
+    UINT64 GetVolumesTested() const;
+    UINT64 GetPlanesTested() const;
+
+    // A plane with the data SetPlanes precomputes for the tests.
+    struct CullPlane
+    {
+        XMFLOAT4 Plane;
+        XMFLOAT3 AbsNormal;     // Picks the extreme corner of a box along the normal.
+    };
+
+private:
+    VOID ResizeState( UINT Count );
+
+    FrustumCuller( const FrustumCuller& rhs );
+    FrustumCuller& operator=( const FrustumCuller& rhs );
+
+private:
+    CullPlane m_Planes[6];
+    BOOL m_PlaneCoherency;
+
+    // Last rejecting plane of every volume of the Cull*s arrays.
+    std::vector<BYTE> m_LastPlane;
+
+    UINT64 m_VolumesTested;
+    UINT64 m_PlanesTested;
+};
+
+}; // namespace
+
+#endif
@@ -0,0 +1,122 @@
+//-------------------------------------------------------------------------------------
+// ImportedMesh.h
+//
+// Format independent result of the mesh importers: one indexed triangle list
+// with a full vertex (attributes a file does not have are zero), split into
+// subsets that each draw with one material.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _IMPORTED_MESH_H_
+#define _IMPORTED_MESH_H_
+
+#include <cfloat>
+#include <string>
+#include <vector>
+#include "xnacollision.h"
+
+namespace XNA
+{
+
+struct ImportedVertex
+{
+    XMFLOAT3 Position;
+    XMFLOAT3 Normal;
+    XMFLOAT2 TexCoord;
+};
+
+struct ImportedMaterial
+{
+    std::string Name;
+    XMFLOAT3 Ambient;
+    XMFLOAT3 Diffuse;
+    XMFLOAT3 Specular;
+    FLOAT SpecularPower;
+    FLOAT Opacity;
+    std::string DiffuseMap;     // Texture file names as given in the file.
+    std::string NormalMap;
+};
+
+// Indices [FirstIndex, FirstIndex + IndexCount) of the mesh, drawn with
+// Materials[Material]. The indices are relative to BaseVertex, as the
+// BaseVertexLocation of DrawIndexed: a mesh merged from several parts keeps
+// the indices of every part as they were. Bounds are those of the vertices
+// the subset draws.
+struct ImportedSubset
+{
+    UINT Material;
+    UINT FirstIndex;
+    UINT IndexCount;
+    UINT BaseVertex;
+    AxisAlignedBox Bounds;
+};
+
+struct ImportedMesh
+{
+    std::vector<ImportedVertex> Vertices;
+    std::vector<UINT> Indices;
+    std::vector<ImportedSubset> Subsets;
+    std::vector<ImportedMaterial> Materials;
+    BOOL HasNormals;
+    BOOL HasTexCoords;
+
+    // One per vertex, w the sign of the bitangent; empty unless
+    // GenerateImportedTangents (MeshTangents.h) filled it.
+    std::vector<XMFLOAT4> Tangents;
+
+    ImportedMesh() : HasNormals( FALSE ), HasTexCoords( FALSE ) {}
+
+    VOID Clear()
+    {
+        Vertices.clear();
+        Indices.clear();
+        Subsets.clear();
+        Materials.clear();
+        HasNormals = FALSE;
+        HasTexCoords = FALSE;
+        Tangents.clear();
+    }
+};
+
+// Material with the defaults of the OBJ format (white diffuse, no specular).
+inline VOID InitializeImportedMaterial( ImportedMaterial* pMaterial, const std::string& Name )
+{
+    pMaterial->Name = Name;
+    pMaterial->Ambient = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+    pMaterial->Diffuse = XMFLOAT3( 1.0f, 1.0f, 1.0f );
+    pMaterial->Specular = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+    pMaterial->SpecularPower = 0.0f;
+    pMaterial->Opacity = 1.0f;
+    pMaterial->DiffuseMap.clear();
+    pMaterial->NormalMap.clear();
+}
+
+// Recomputes the bounds of every subset from the vertices it draws.
+inline VOID ComputeImportedSubsetBounds( ImportedMesh* pMesh )
+{
+    for( size_t s = 0; s < pMesh->Subsets.size(); s++ )
+    {
+        ImportedSubset& Subset = pMesh->Subsets[s];
+        const ImportedVertex* pVertices = pMesh->Vertices.data() + Subset.BaseVertex;
+        XMVECTOR Min = XMVectorReplicate( FLT_MAX );
+        XMVECTOR Max = XMVectorReplicate( -FLT_MAX );
+
+        for( UINT i = 0; i < Subset.IndexCount; i++ )
+        {
+            XMVECTOR P = XMLoadFloat3( &pVertices[pMesh->Indices[Subset.FirstIndex + i]].Position );
+            Min = XMVectorMin( Min, P );
+            Max = XMVectorMax( Max, P );
+        }
+
+        if( Subset.IndexCount == 0 )
+            Min = Max = XMVectorZero();
+
+        XMStoreFloat3( &Subset.Bounds.Center, ( Min + Max ) * 0.5f );
+        XMStoreFloat3( &Subset.Bounds.Extents, ( Max - Min ) * 0.5f );
+    }
+}
+
+}; // namespace
+
+#endif
@@ -0,0 +1,317 @@
+//-------------------------------------------------------------------------------------
+// MappedFile.cpp
+//
+// CreateFileMapping on Windows, mmap everywhere else.
+//-------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "MappedFile.h"
+
+#if !defined( _WIN32 )
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace XNA
+{
+
+static const UINT64 HashPrime1 = 11400714785074694791ULL;
+static const UINT64 HashPrime2 = 14029467366897019727ULL;
+static const UINT64 HashPrime3 = 1609587929392839161ULL;
+static const UINT64 HashPrime4 = 9650029242287828579ULL;
+static const UINT64 HashPrime5 = 2870177450012600261ULL;
+
+
+
+MappedFile::MappedFile() :
+    m_pData( NULL ),
+    m_Size( 0 ),
+    m_Open( FALSE )
+{
+#if defined( _WIN32 )
+    m_File = INVALID_HANDLE_VALUE;
+    m_Mapping = NULL;
+#endif
+}
+
+
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL MappedFile::Open( const char* FileName )
+{
+    XMASSERT( FileName );
+
+    Close();
+
+#if defined( _WIN32 )
+    m_File = CreateFileA( FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if( m_File == INVALID_HANDLE_VALUE )
+        return FALSE;
+
+    LARGE_INTEGER Size;
+    if( !GetFileSizeEx( m_File, &Size ) || ( unsigned long long )Size.QuadPart > ( size_t )-1 )
+    {
+        Close();
+        return FALSE;
+    }
+    m_Size = ( size_t )Size.QuadPart;
+
+    // A zero length file cannot be mapped.
+    if( m_Size > 0 )
+    {
+        m_Mapping = CreateFileMappingA( m_File, NULL, PAGE_READONLY, 0, 0, NULL );
+        if( !m_Mapping )
+        {
+            Close();
+            return FALSE;
+        }
+
+        m_pData = ( const BYTE* )MapViewOfFile( m_Mapping, FILE_MAP_READ, 0, 0, 0 );
+        if( !m_pData )
+        {
+            Close();
+            return FALSE;
+        }
+    }
+#else
+    int File = open( FileName, O_RDONLY );
+    if( File < 0 )
+        return FALSE;
+
+    struct stat Status;
+    if( fstat( File, &Status ) != 0 || !S_ISREG( Status.st_mode ) )
+    {
+        close( File );
+        return FALSE;
+    }
+    m_Size = ( size_t )Status.st_size;
+
+    if( m_Size > 0 )
+    {
+        void* pView = mmap( NULL, m_Size, PROT_READ, MAP_PRIVATE, File, 0 );
+        if( pView == MAP_FAILED )
+        {
+            close( File );
+            m_Size = 0;
+            return FALSE;
+        }
+
+        // The loaders read front to back; ask for aggressive read ahead.
+        madvise( pView, m_Size, MADV_SEQUENTIAL );
+        m_pData = ( const BYTE* )pView;
+    }
+
+    // The mapping keeps its own reference to the file.
+    close( File );
+#endif
+
+    m_Open = TRUE;
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID MappedFile::Close()
+{
+#if defined( _WIN32 )
+    if( m_pData )
+        UnmapViewOfFile( m_pData );
+    if( m_Mapping )
+        CloseHandle( m_Mapping );
+    if( m_File != INVALID_HANDLE_VALUE )
+        CloseHandle( m_File );
+    m_Mapping = NULL;
+    m_File = INVALID_HANDLE_VALUE;
+#else
+    if( m_pData )
+        munmap( ( void* )m_pData, m_Size );
+#endif
+
+    m_pData = NULL;
+    m_Size = 0;
+    m_Open = FALSE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL MappedFile::IsOpen() const
+{
+    return m_Open;
+}
+
+
+
+const BYTE* MappedFile::GetData() const
+{
+    return m_pData;
+}
+
+
+
+size_t MappedFile::GetSize() const
+{
+    return m_Size;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// XXH64.
+//-----------------------------------------------------------------------------
+static inline UINT64 RotateLeft( UINT64 x, int r )
+{
+    return ( x << r ) | ( x >> ( 64 - r ) );
+}
+
+
+
+static inline UINT64 Read64( const BYTE* p )
+{
+    UINT64 Value;
+    memcpy( &Value, p, sizeof( Value ) );
+    return Value;
+}
+
+
+
+static inline UINT64 HashRound( UINT64 Acc, UINT64 Input )
+{
+    Acc += Input * HashPrime2;
+    Acc = RotateLeft( Acc, 31 );
+    return Acc * HashPrime1;
+}
+
+
+
+static inline UINT64 HashMergeRound( UINT64 Acc, UINT64 Value )
+{
+    Acc ^= HashRound( 0, Value );
+    return Acc * HashPrime1 + HashPrime4;
+}
+
+
+
+UINT64 ComputeContentHash( const VOID* pData, size_t Size, UINT64 Seed )
+{
+    XMASSERT( pData || Size == 0 );
+
+    const BYTE* p = ( const BYTE* )pData;
+    const BYTE* pEnd = p + Size;
+    UINT64 Hash;
+
+    if( Size >= 32 )
+    {
+        UINT64 V1 = Seed + HashPrime1 + HashPrime2;
+        UINT64 V2 = Seed + HashPrime2;
+        UINT64 V3 = Seed;
+        UINT64 V4 = Seed - HashPrime1;
+
+        const BYTE* pLimit = pEnd - 32;
+        do
+        {
+            V1 = HashRound( V1, Read64( p ) );
+            V2 = HashRound( V2, Read64( p + 8 ) );
+            V3 = HashRound( V3, Read64( p + 16 ) );
+            V4 = HashRound( V4, Read64( p + 24 ) );
+            p += 32;
+        }
+        while( p <= pLimit );
+
+        Hash = RotateLeft( V1, 1 ) + RotateLeft( V2, 7 ) + RotateLeft( V3, 12 ) + RotateLeft( V4, 18 );
+        Hash = HashMergeRound( Hash, V1 );
+        Hash = HashMergeRound( Hash, V2 );
+        Hash = HashMergeRound( Hash, V3 );
+        Hash = HashMergeRound( Hash, V4 );
+    }
+    else
+    {
+        Hash = Seed + HashPrime5;
+    }
+
+    Hash += Size;
+
+    for( ; p + 8 <= pEnd; p += 8 )
+    {
+        Hash ^= HashRound( 0, Read64( p ) );
+        Hash = RotateLeft( Hash, 27 ) * HashPrime1 + HashPrime4;
+    }
+
+    if( p + 4 <= pEnd )
+    {
+        UINT Value;
+        memcpy( &Value, p, sizeof( Value ) );
+        Hash ^= ( UINT64 )Value * HashPrime1;
+        Hash = RotateLeft( Hash, 23 ) * HashPrime2 + HashPrime3;
+        p += 4;
+    }
+
+    for( ; p < pEnd; p++ )
+    {
+        Hash ^= *p * HashPrime5;
+        Hash = RotateLeft( Hash, 11 ) * HashPrime1;
+    }
+
+    Hash ^= Hash >> 33;
+    Hash *= HashPrime2;
+    Hash ^= Hash >> 29;
+    Hash *= HashPrime3;
+    Hash ^= Hash >> 32;
+    return Hash;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL ComputeFileHash( const char* FileName, UINT64* pHash, UINT64* pSize )
+{
+    XMASSERT( pHash && pSize );
+
+    MappedFile File;
+    if( !File.Open( FileName ) )
+        return FALSE;
+
+    *pHash = ComputeContentHash( File.GetData(), File.GetSize() );
+    *pSize = File.GetSize();
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL WriteFileAtomic( const char* FileName, const VOID* pData, size_t Size )
+{
+    XMASSERT( FileName && ( pData || Size == 0 ) );
+
+    std::string Temporary = std::string( FileName ) + ".tmp";
+    FILE* pFile = fopen( Temporary.c_str(), "wb" );
+    if( !pFile )
+        return FALSE;
+
+    BOOL Written = Size == 0 || fwrite( pData, 1, Size, pFile ) == Size;
+    Written = ( fclose( pFile ) == 0 ) && Written;
+
+#if defined( _WIN32 )
+    Written = Written && MoveFileExA( Temporary.c_str(), FileName, MOVEFILE_REPLACE_EXISTING );
+#else
+    Written = Written && rename( Temporary.c_str(), FileName ) == 0;
+#endif
+
+    if( !Written )
+        remove( Temporary.c_str() );
+    return Written;
+}
+
+}; // namespace
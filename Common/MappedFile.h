@@ -0,0 +1,66 @@
+//-------------------------------------------------------------------------------------
+// MappedFile.h
+//
+// Read only view of a whole file mapped into memory, so loaders can parse it
+// in place: no read calls, no copy into a buffer, and pages the parser does
+// not touch are never read from disk. Also the content hash and the atomic
+// write shared by the mesh cache and the asset archive.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <cstddef>
+#include "xnacollision.h"
+
+namespace XNA
+{
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Returns FALSE if the file cannot be opened or mapped. An empty file
+    // opens with a NULL view.
+    BOOL Open( const char* FileName );
+    VOID Close();
+
+    BOOL IsOpen() const;
+    const BYTE* GetData() const;
+    size_t GetSize() const;
+
+private:
+    MappedFile( const MappedFile& rhs );
+    MappedFile& operator=( const MappedFile& rhs );
+
+private:
+    const BYTE* m_pData;
+    size_t m_Size;
+    BOOL m_Open;
+#if defined( _WIN32 )
+    HANDLE m_File;
+    HANDLE m_Mapping;
+#endif
+};
+
+//-----------------------------------------------------------------------------
+// 64-bit hash of a block of memory (four lane multiply and rotate, in the
+// manner of xxHash64), several GB/s so validating a cache costs a fraction of
+// parsing its source.
+//-----------------------------------------------------------------------------
+UINT64 ComputeContentHash( const VOID* pData, size_t Size, UINT64 Seed = 0 );
+
+// Hash and size of a file, FALSE if it cannot be read.
+BOOL ComputeFileHash( const char* FileName, UINT64* pHash, UINT64* pSize );
+
+// Writes a file under a temporary name and renames it over FileName, so a
+// reader never maps a partly written one.
+BOOL WriteFileAtomic( const char* FileName, const VOID* pData, size_t Size );
+
+}; // namespace
+
+#endif
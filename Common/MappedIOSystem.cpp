@@ -0,0 +1,285 @@
+//-------------------------------------------------------------------------------------
+// MappedIOSystem.cpp
+//
+// Memory backed Assimp IOSystem and its read only stream.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "MappedIOSystem.h"
+#include "IOStream.hpp"
+
+namespace XNA
+{
+
+//-----------------------------------------------------------------------------
+// Read only stream over a block of memory it does not own.
+//-----------------------------------------------------------------------------
+class MappedIOStream : public Assimp::IOStream
+{
+public:
+    MappedIOStream( const BYTE* pData, size_t Size )
+        : m_pData( pData ),
+          m_Size( Size ),
+          m_Position( 0 )
+    {
+    }
+
+    size_t Read( void* pvBuffer, size_t pSize, size_t pCount )
+    {
+        if( pSize == 0 || pCount == 0 )
+            return 0;
+
+        size_t Count = ( std::min )( pCount, ( m_Size - m_Position ) / pSize );
+        if( Count > 0 )
+        {
+            memcpy( pvBuffer, m_pData + m_Position, Count * pSize );
+            m_Position += Count * pSize;
+        }
+        return Count;
+    }
+
+    size_t Write( const void* pvBuffer, size_t pSize, size_t pCount )
+    {
+        return 0;
+    }
+
+    // The offset from aiOrigin_END is negative, in size_t.
+    aiReturn Seek( size_t pOffset, aiOrigin pOrigin )
+    {
+        size_t Position;
+        switch( pOrigin )
+        {
+        case aiOrigin_SET:
+            Position = pOffset;
+            break;
+        case aiOrigin_CUR:
+            Position = m_Position + pOffset;
+            break;
+        case aiOrigin_END:
+            Position = m_Size + pOffset;
+            break;
+        default:
+            return aiReturn_FAILURE;
+        }
+
+        if( Position > m_Size )
+            return aiReturn_FAILURE;
+
+        m_Position = Position;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const
+    {
+        return m_Position;
+    }
+
+    size_t FileSize() const
+    {
+        return m_Size;
+    }
+
+    void Flush()
+    {
+    }
+
+private:
+    const BYTE* m_pData;
+    size_t m_Size;
+    size_t m_Position;
+};
+
+
+
+MappedIOSystem::MappedIOSystem()
+{
+}
+
+
+
+MappedIOSystem::~MappedIOSystem()
+{
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID MappedIOSystem::Mount( const char* Path, const VOID* pData, size_t Size )
+{
+    XMASSERT( Path );
+    XMASSERT( pData || Size == 0 );
+
+    FileView View;
+    View.pData = static_cast<const BYTE*>( pData );
+    View.Size = Size;
+    m_Mounted[NormalizeAssetPath( Path )] = View;
+}
+
+
+
+VOID MappedIOSystem::MountArchive( const AssetArchive* pArchive )
+{
+    XMASSERT( pArchive );
+    m_Archives.push_back( pArchive );
+}
+
+
+
+const AssetArchive* MappedIOSystem::FindArchive( const char* Path ) const
+{
+    XMASSERT( Path );
+
+    std::string Normalized = NormalizeAssetPath( Path );
+    for( size_t i = 0; i < m_Archives.size(); i++ )
+    {
+        UINT Index;
+        if( m_Archives[i]->Find( Normalized.c_str(), &Index ) )
+            return m_Archives[i];
+    }
+    return NULL;
+}
+
+
+
+VOID MappedIOSystem::Clear()
+{
+    m_Mounted.clear();
+    m_Archives.clear();
+    m_Extracted.clear();
+    m_Mapped.clear();
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Mounted blocks first, then the archives, then the files already mapped,
+// then the disk. A compressed archive entry is extracted once and kept.
+//-----------------------------------------------------------------------------
+BOOL MappedIOSystem::Find( const std::string& Path, FileView* pView ) const
+{
+    std::map<std::string, FileView>::const_iterator Mounted = m_Mounted.find( Path );
+    if( Mounted != m_Mounted.end() )
+    {
+        *pView = Mounted->second;
+        return TRUE;
+    }
+
+    for( size_t i = 0; i < m_Archives.size(); i++ )
+    {
+        UINT Index;
+        if( !m_Archives[i]->Find( Path.c_str(), &Index ) )
+            continue;
+
+        if( m_Archives[i]->GetView( Index, &pView->pData, &pView->Size ) )
+            return TRUE;
+
+        std::map<std::string, std::vector<BYTE> >::iterator Extracted = m_Extracted.find( Path );
+        if( Extracted == m_Extracted.end() )
+        {
+            std::vector<BYTE> Data;
+            if( !m_Archives[i]->Extract( Index, &Data ) )
+                return FALSE;
+            Extracted = m_Extracted.insert( std::make_pair( Path, std::move( Data ) ) ).first;
+        }
+
+        pView->pData = Extracted->second.empty() ? NULL : &Extracted->second[0];
+        pView->Size = Extracted->second.size();
+        return TRUE;
+    }
+
+    std::map<std::string, std::unique_ptr<MappedFile> >::const_iterator Mapped = m_Mapped.find( Path );
+    if( Mapped == m_Mapped.end() )
+    {
+        std::unique_ptr<MappedFile> File( new MappedFile );
+        if( !File->Open( Path.c_str() ) )
+            return FALSE;
+
+        Mapped = m_Mapped.insert( std::make_pair( Path, std::move( File ) ) ).first;
+    }
+
+    pView->pData = Mapped->second->GetData();
+    pView->Size = Mapped->second->GetSize();
+    return TRUE;
+}
+
+
+
+BOOL MappedIOSystem::GetFile( const char* Path, const BYTE** ppData, size_t* pSize ) const
+{
+    XMASSERT( ppData );
+    XMASSERT( pSize );
+
+    FileView View;
+    if( !Find( NormalizeAssetPath( Path ), &View ) )
+        return FALSE;
+
+    *ppData = View.pData;
+    *pSize = View.Size;
+    return TRUE;
+}
+
+
+
+UINT MappedIOSystem::GetMappedFileCount() const
+{
+    return static_cast<UINT>( m_Mapped.size() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+bool MappedIOSystem::Exists( const char* pFile ) const
+{
+    FileView View;
+    return Find( NormalizeAssetPath( pFile ), &View ) != FALSE;
+}
+
+
+
+char MappedIOSystem::getOsSeparator() const
+{
+#if defined( _WIN32 )
+    return '\\';
+#else
+    return '/';
+#endif
+}
+
+
+
+Assimp::IOStream* MappedIOSystem::Open( const char* pFile, const char* pMode )
+{
+    XMASSERT( pFile );
+    XMASSERT( pMode );
+
+    if( strpbrk( pMode, "wa+" ) )
+        return NULL;
+
+    FileView View;
+    if( !Find( NormalizeAssetPath( pFile ), &View ) )
+        return NULL;
+
+    return new MappedIOStream( View.pData, View.Size );
+}
+
+
+
+void MappedIOSystem::Close( Assimp::IOStream* pFile )
+{
+    delete pFile;
+}
+
+
+
+bool MappedIOSystem::ComparePaths( const char* one, const char* second ) const
+{
+#if defined( _WIN32 )
+    return _stricmp( NormalizeAssetPath( one ).c_str(), NormalizeAssetPath( second ).c_str() ) == 0;
+#else
+    return NormalizeAssetPath( one ) == NormalizeAssetPath( second );
+#endif
+}
+
+}; // namespace
@@ -0,0 +1,102 @@
+//-------------------------------------------------------------------------------------
+// MappedIOSystem.h
+//
+// Assimp::IOSystem that serves reads from memory instead of the stdio files of
+// Assimp's default one. A path is looked up first among the blocks mounted
+// with Mount, then in the asset archives mounted with MountArchive, then
+// among the files this IOSystem already mapped, and only then on disk, where
+// the file is mapped once and kept mapped: the Exists and the repeated Opens
+// an importer does for the same file (one to sniff the format, one to read
+// it, the OBJ and its MTL libraries) cost one open and one mapping per file
+// instead of an fopen, fseek, ftell, fread and fclose each time.
+//
+// Assimp still copies what it reads into its own buffers, that is the
+// IOStream interface; the copy comes straight from the mapping, there is no
+// stdio buffer in between (a compressed archive entry is extracted first,
+// once). GetFile hands the same views out to the rest of the loader,
+// textures for instance, without going through a stream at all.
+//
+// Paths are compared after turning backslashes into slashes and removing "."
+// and "dir/.." segments, so "meshes\suzanne.mtl" and "meshes/./suzanne.mtl"
+// are the same file. One instance serves one Importer at a time: the
+// directory stack of IOSystem is per instance. The mapped files stay mapped
+// until Clear or destruction, so several imports through the same instance
+// share them.
+//
+// The Importer owns the IOSystem it is given and deletes it; hand it over
+// with SetIOHandler and take it back with SetIOHandler( NULL ) before the
+// Importer goes away (ImportSceneFromFile does).
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _MAPPED_IO_SYSTEM_H_
+#define _MAPPED_IO_SYSTEM_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AssetArchive.h"
+#include "MappedFile.h"
+#include "IOSystem.hpp"
+
+namespace XNA
+{
+
+class MappedIOSystem : public Assimp::IOSystem
+{
+public:
+    MappedIOSystem();
+    ~MappedIOSystem();
+
+    // Serves Path from the Size bytes at pData, which must stay valid as
+    // long as this IOSystem or a stream it opened is in use. Replaces a
+    // block mounted before under the same path.
+    VOID Mount( const char* Path, const VOID* pData, size_t Size );
+
+    // Serves the entries of an archive, which must stay open as long as this
+    // IOSystem or a stream it opened is in use. Archives mounted first win.
+    VOID MountArchive( const AssetArchive* pArchive );
+
+    // The first mounted archive holding Path, NULL if none does.
+    const AssetArchive* FindArchive( const char* Path ) const;
+
+    // Unmounts every block and archive and unmaps every file.
+    VOID Clear();
+
+    // Contents of Path, mounted or mapped from disk. FALSE if neither.
+    BOOL GetFile( const char* Path, const BYTE** ppData, size_t* pSize ) const;
+
+    // Number of files mapped from disk so far.
+    UINT GetMappedFileCount() const;
+
+    // Assimp::IOSystem. Open only supports reading ("r", "rb", "rt").
+    bool Exists( const char* pFile ) const;
+    char getOsSeparator() const;
+    Assimp::IOStream* Open( const char* pFile, const char* pMode = "rb" );
+    void Close( Assimp::IOStream* pFile );
+    bool ComparePaths( const char* one, const char* second ) const;
+
+private:
+    struct FileView
+    {
+        const BYTE* pData;
+        size_t Size;
+    };
+
+    BOOL Find( const std::string& Path, FileView* pView ) const;
+
+    MappedIOSystem( const MappedIOSystem& rhs );
+    MappedIOSystem& operator=( const MappedIOSystem& rhs );
+
+private:
+    std::map<std::string, FileView> m_Mounted;
+    std::vector<const AssetArchive*> m_Archives;
+    mutable std::map<std::string, std::vector<BYTE> > m_Extracted;
+    mutable std::map<std::string, std::unique_ptr<MappedFile> > m_Mapped;
+};
+
+}; // namespace
+
+#endif
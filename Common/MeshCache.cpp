@@ -0,0 +1,521 @@
+//-------------------------------------------------------------------------------------
+// MeshCache.cpp
+//
+// Mesh cache images: building, validation and the cached OBJ import.
+//-------------------------------------------------------------------------------------
+
+#include <cstring>
+#include "MeshCache.h"
+#include "ObjLoader.h"
+
+namespace XNA
+{
+
+static_assert( sizeof( MeshCacheHeader ) == 128, "MeshCacheHeader layout is part of the file format" );
+static_assert( sizeof( ImportedVertex ) == 32, "ImportedVertex layout is part of the file format" );
+
+
+
+//-----------------------------------------------------------------------------
+// Image building.
+//-----------------------------------------------------------------------------
+UINT64 GetMeshCacheOptionsKey( const MeshMissingNormalOptions* pOptions )
+{
+    if( !pOptions )
+        return 0;
+
+    // Member by member, so padding never reaches the hash.
+    FLOAT Values[6] =
+    {
+        pOptions->Weld.PositionEpsilon, pOptions->Weld.NormalEpsilon, pOptions->Weld.TexCoordEpsilon,
+        pOptions->Normals.CreaseAngle, ( FLOAT )pOptions->Normals.Weighting, pOptions->Normals.PositionEpsilon,
+    };
+    UINT64 Key = ComputeContentHash( Values, sizeof( Values ) );
+    return Key ? Key : 1;
+}
+
+
+
+static inline UINT64 AlignSection( UINT64 Offset )
+{
+    return ( Offset + MeshCacheAlignment - 1 ) & ~( UINT64 )( MeshCacheAlignment - 1 );
+}
+
+
+
+static UINT AddString( std::string& Strings, const std::string& Value )
+{
+    if( Value.empty() )
+        return 0;
+
+    UINT Offset = ( UINT )Strings.size();
+    Strings.append( Value.c_str(), Value.size() + 1 );
+    return Offset;
+}
+
+
+
+VOID BuildMeshCacheImage( const ImportedMesh& Mesh, const std::vector<std::string>& Dependencies,
+                          const UINT64* pHashes, const UINT64* pSizes, std::vector<BYTE>* pImage,
+                          UINT64 OptionsKey )
+{
+    XMASSERT( pImage );
+    XMASSERT( Dependencies.empty() || ( pHashes && pSizes ) );
+
+    // Offset 0 is the empty string.
+    std::string Strings( 1, '\0' );
+
+    std::vector<MeshCacheSubset> Subsets( Mesh.Subsets.size() );
+    for( size_t i = 0; i < Subsets.size(); i++ )
+    {
+        Subsets[i].Material = Mesh.Subsets[i].Material;
+        Subsets[i].FirstIndex = Mesh.Subsets[i].FirstIndex;
+        Subsets[i].IndexCount = Mesh.Subsets[i].IndexCount;
+        Subsets[i].BaseVertex = Mesh.Subsets[i].BaseVertex;
+        Subsets[i].BoundsCenter = Mesh.Subsets[i].Bounds.Center;
+        Subsets[i].BoundsExtents = Mesh.Subsets[i].Bounds.Extents;
+    }
+
+    std::vector<MeshCacheMaterial> Materials( Mesh.Materials.size() );
+    for( size_t i = 0; i < Materials.size(); i++ )
+    {
+        const ImportedMaterial& Material = Mesh.Materials[i];
+        Materials[i].Ambient = Material.Ambient;
+        Materials[i].Diffuse = Material.Diffuse;
+        Materials[i].Specular = Material.Specular;
+        Materials[i].SpecularPower = Material.SpecularPower;
+        Materials[i].Opacity = Material.Opacity;
+        Materials[i].Name = AddString( Strings, Material.Name );
+        Materials[i].DiffuseMap = AddString( Strings, Material.DiffuseMap );
+        Materials[i].NormalMap = AddString( Strings, Material.NormalMap );
+    }
+
+    std::vector<MeshCacheDependency> Files( Dependencies.size() );
+    for( size_t i = 0; i < Files.size(); i++ )
+    {
+        Files[i].Hash = pHashes[i];
+        Files[i].Size = pSizes[i];
+        Files[i].Path = AddString( Strings, Dependencies[i] );
+        Files[i].Reserved = 0;
+    }
+
+    MeshCacheHeader Header;
+    memset( ( VOID* )&Header, 0, sizeof( Header ) );
+    Header.Magic = MeshCacheMagic;
+    Header.Version = MeshCacheVersion;
+    Header.Flags = ( Mesh.HasNormals ? MeshCacheHasNormals : 0 ) | ( Mesh.HasTexCoords ? MeshCacheHasTexCoords : 0 );
+    Header.VertexStride = sizeof( ImportedVertex );
+    Header.VertexCount = ( UINT )Mesh.Vertices.size();
+    Header.IndexCount = ( UINT )Mesh.Indices.size();
+    Header.SubsetCount = ( UINT )Subsets.size();
+    Header.MaterialCount = ( UINT )Materials.size();
+    Header.DependencyCount = ( UINT )Files.size();
+    Header.StringSize = ( UINT )Strings.size();
+    Header.OptionsKey = OptionsKey;
+
+    AxisAlignedBox Bounds;
+    Bounds.Center = Bounds.Extents = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+    if( !Mesh.Vertices.empty() )
+        ComputeBoundingAxisAlignedBoxFromPoints( &Bounds, Header.VertexCount, &Mesh.Vertices[0].Position,
+                                                 sizeof( ImportedVertex ) );
+    Header.BoundsCenter = Bounds.Center;
+    Header.BoundsExtents = Bounds.Extents;
+
+    UINT64 Offset = AlignSection( sizeof( MeshCacheHeader ) );
+    Header.VertexOffset = Offset;
+    Offset = AlignSection( Offset + ( UINT64 )Header.VertexCount * sizeof( ImportedVertex ) );
+    Header.IndexOffset = Offset;
+    Offset = AlignSection( Offset + ( UINT64 )Header.IndexCount * sizeof( UINT ) );
+    Header.SubsetOffset = Offset;
+    Offset = AlignSection( Offset + Subsets.size() * sizeof( MeshCacheSubset ) );
+    Header.MaterialOffset = Offset;
+    Offset = AlignSection( Offset + Materials.size() * sizeof( MeshCacheMaterial ) );
+    Header.DependencyOffset = Offset;
+    Offset = AlignSection( Offset + Files.size() * sizeof( MeshCacheDependency ) );
+    Header.StringOffset = Offset;
+    Header.FileSize = Offset + Strings.size();
+
+    pImage->assign( ( size_t )Header.FileSize, 0 );
+    BYTE* pData = &( *pImage )[0];
+    memcpy( pData, &Header, sizeof( Header ) );
+    if( !Mesh.Vertices.empty() )
+        memcpy( pData + Header.VertexOffset, &Mesh.Vertices[0], Mesh.Vertices.size() * sizeof( ImportedVertex ) );
+    if( !Mesh.Indices.empty() )
+        memcpy( pData + Header.IndexOffset, &Mesh.Indices[0], Mesh.Indices.size() * sizeof( UINT ) );
+    if( !Subsets.empty() )
+        memcpy( pData + Header.SubsetOffset, &Subsets[0], Subsets.size() * sizeof( MeshCacheSubset ) );
+    if( !Materials.empty() )
+        memcpy( pData + Header.MaterialOffset, &Materials[0], Materials.size() * sizeof( MeshCacheMaterial ) );
+    if( !Files.empty() )
+        memcpy( pData + Header.DependencyOffset, &Files[0], Files.size() * sizeof( MeshCacheDependency ) );
+    memcpy( pData + Header.StringOffset, Strings.data(), Strings.size() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// MeshCache.
+//-----------------------------------------------------------------------------
+MeshCache::MeshCache() :
+    m_pData( NULL ),
+    m_pHeader( NULL )
+{
+}
+
+
+
+MeshCache::~MeshCache()
+{
+}
+
+
+
+static inline BOOL IsSectionValid( UINT64 Offset, UINT64 Count, UINT64 ElementSize, UINT64 Size )
+{
+    return Offset % MeshCacheAlignment == 0 && Offset <= Size && Count * ElementSize <= Size - Offset;
+}
+
+
+
+BOOL MeshCache::Attach( const BYTE* pData, size_t Size )
+{
+    if( Size < sizeof( MeshCacheHeader ) )
+        return FALSE;
+
+    const MeshCacheHeader* pHeader = ( const MeshCacheHeader* )pData;
+    if( pHeader->Magic != MeshCacheMagic || pHeader->Version != MeshCacheVersion ||
+        pHeader->VertexStride != sizeof( ImportedVertex ) || pHeader->FileSize != Size )
+        return FALSE;
+
+    if( !IsSectionValid( pHeader->VertexOffset, pHeader->VertexCount, sizeof( ImportedVertex ), Size ) ||
+        !IsSectionValid( pHeader->IndexOffset, pHeader->IndexCount, sizeof( UINT ), Size ) ||
+        !IsSectionValid( pHeader->SubsetOffset, pHeader->SubsetCount, sizeof( MeshCacheSubset ), Size ) ||
+        !IsSectionValid( pHeader->MaterialOffset, pHeader->MaterialCount, sizeof( MeshCacheMaterial ), Size ) ||
+        !IsSectionValid( pHeader->DependencyOffset, pHeader->DependencyCount, sizeof( MeshCacheDependency ), Size ) ||
+        !IsSectionValid( pHeader->StringOffset, pHeader->StringSize, 1, Size ) )
+        return FALSE;
+
+    UINT StringSize = pHeader->StringSize;
+    if( StringSize == 0 || pData[pHeader->StringOffset + StringSize - 1] != 0 )
+        return FALSE;
+
+    const MeshCacheSubset* pSubsets = ( const MeshCacheSubset* )( pData + pHeader->SubsetOffset );
+    for( UINT i = 0; i < pHeader->SubsetCount; i++ )
+    {
+        if( pSubsets[i].Material >= pHeader->MaterialCount ||
+            ( UINT64 )pSubsets[i].FirstIndex + pSubsets[i].IndexCount > pHeader->IndexCount ||
+            pSubsets[i].BaseVertex > pHeader->VertexCount )
+            return FALSE;
+    }
+
+    const MeshCacheMaterial* pMaterials = ( const MeshCacheMaterial* )( pData + pHeader->MaterialOffset );
+    for( UINT i = 0; i < pHeader->MaterialCount; i++ )
+    {
+        if( pMaterials[i].Name >= StringSize || pMaterials[i].DiffuseMap >= StringSize ||
+            pMaterials[i].NormalMap >= StringSize )
+            return FALSE;
+    }
+
+    const MeshCacheDependency* pFiles = ( const MeshCacheDependency* )( pData + pHeader->DependencyOffset );
+    for( UINT i = 0; i < pHeader->DependencyCount; i++ )
+    {
+        if( pFiles[i].Path >= StringSize )
+            return FALSE;
+    }
+
+    m_pData = pData;
+    m_pHeader = pHeader;
+    return TRUE;
+}
+
+
+
+BOOL MeshCache::Open( const char* FileName )
+{
+    Close();
+
+    if( !m_File.Open( FileName ) )
+        return FALSE;
+
+    if( !Attach( m_File.GetData(), m_File.GetSize() ) )
+    {
+        Close();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+
+
+BOOL MeshCache::Open( std::vector<BYTE>& Image )
+{
+    Close();
+
+    m_Image.swap( Image );
+    if( m_Image.empty() || !Attach( &m_Image[0], m_Image.size() ) )
+    {
+        Close();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+
+
+VOID MeshCache::Close()
+{
+    m_File.Close();
+    std::vector<BYTE>().swap( m_Image );
+    m_pData = NULL;
+    m_pHeader = NULL;
+}
+
+
+
+BOOL MeshCache::IsOpen() const
+{
+    return m_pHeader != NULL;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL MeshCache::IsCurrent( const std::string& Directory ) const
+{
+    if( !m_pHeader )
+        return FALSE;
+
+    const MeshCacheDependency* pFiles = GetDependencies();
+    for( UINT i = 0; i < m_pHeader->DependencyCount; i++ )
+    {
+        UINT64 Hash, Size;
+        if( !ComputeFileHash( ( Directory + GetString( pFiles[i].Path ) ).c_str(), &Hash, &Size ) ||
+            Hash != pFiles[i].Hash || Size != pFiles[i].Size )
+            return FALSE;
+    }
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT MeshCache::GetVertexCount() const
+{
+    return m_pHeader ? m_pHeader->VertexCount : 0;
+}
+
+
+
+const ImportedVertex* MeshCache::GetVertices() const
+{
+    return m_pHeader ? ( const ImportedVertex* )( m_pData + m_pHeader->VertexOffset ) : NULL;
+}
+
+
+
+UINT MeshCache::GetIndexCount() const
+{
+    return m_pHeader ? m_pHeader->IndexCount : 0;
+}
+
+
+
+const UINT* MeshCache::GetIndices() const
+{
+    return m_pHeader ? ( const UINT* )( m_pData + m_pHeader->IndexOffset ) : NULL;
+}
+
+
+
+UINT MeshCache::GetSubsetCount() const
+{
+    return m_pHeader ? m_pHeader->SubsetCount : 0;
+}
+
+
+
+const MeshCacheSubset* MeshCache::GetSubsets() const
+{
+    return m_pHeader ? ( const MeshCacheSubset* )( m_pData + m_pHeader->SubsetOffset ) : NULL;
+}
+
+
+
+UINT MeshCache::GetMaterialCount() const
+{
+    return m_pHeader ? m_pHeader->MaterialCount : 0;
+}
+
+
+
+VOID MeshCache::GetMaterial( UINT Index, ImportedMaterial* pOut ) const
+{
+    XMASSERT( Index < GetMaterialCount() );
+    XMASSERT( pOut );
+
+    const MeshCacheMaterial& Material = ( ( const MeshCacheMaterial* )( m_pData + m_pHeader->MaterialOffset ) )[Index];
+    pOut->Name = GetString( Material.Name );
+    pOut->Ambient = Material.Ambient;
+    pOut->Diffuse = Material.Diffuse;
+    pOut->Specular = Material.Specular;
+    pOut->SpecularPower = Material.SpecularPower;
+    pOut->Opacity = Material.Opacity;
+    pOut->DiffuseMap = GetString( Material.DiffuseMap );
+    pOut->NormalMap = GetString( Material.NormalMap );
+}
+
+
+
+UINT MeshCache::GetDependencyCount() const
+{
+    return m_pHeader ? m_pHeader->DependencyCount : 0;
+}
+
+
+
+const MeshCacheDependency* MeshCache::GetDependencies() const
+{
+    return m_pHeader ? ( const MeshCacheDependency* )( m_pData + m_pHeader->DependencyOffset ) : NULL;
+}
+
+
+
+const char* MeshCache::GetString( UINT Offset ) const
+{
+    XMASSERT( m_pHeader && Offset < m_pHeader->StringSize );
+    return ( const char* )( m_pData + m_pHeader->StringOffset + Offset );
+}
+
+
+
+BOOL MeshCache::HasNormals() const
+{
+    return m_pHeader && ( m_pHeader->Flags & MeshCacheHasNormals );
+}
+
+
+
+BOOL MeshCache::HasTexCoords() const
+{
+    return m_pHeader && ( m_pHeader->Flags & MeshCacheHasTexCoords );
+}
+
+
+
+UINT64 MeshCache::GetOptionsKey() const
+{
+    return m_pHeader ? m_pHeader->OptionsKey : 0;
+}
+
+
+
+VOID MeshCache::GetBounds( AxisAlignedBox* pOut ) const
+{
+    XMASSERT( m_pHeader );
+    XMASSERT( pOut );
+
+    pOut->Center = m_pHeader->BoundsCenter;
+    pOut->Extents = m_pHeader->BoundsExtents;
+}
+
+
+
+VOID MeshCache::GetSubsets( std::vector<ImportedSubset>* pOut ) const
+{
+    XMASSERT( pOut );
+
+    pOut->resize( GetSubsetCount() );
+    for( UINT i = 0; i < GetSubsetCount(); i++ )
+    {
+        ( *pOut )[i].Material = GetSubsets()[i].Material;
+        ( *pOut )[i].FirstIndex = GetSubsets()[i].FirstIndex;
+        ( *pOut )[i].IndexCount = GetSubsets()[i].IndexCount;
+        ( *pOut )[i].BaseVertex = GetSubsets()[i].BaseVertex;
+        ( *pOut )[i].Bounds.Center = GetSubsets()[i].BoundsCenter;
+        ( *pOut )[i].Bounds.Extents = GetSubsets()[i].BoundsExtents;
+    }
+}
+
+
+
+VOID MeshCache::GetMaterials( std::vector<ImportedMaterial>* pOut ) const
+{
+    XMASSERT( pOut );
+
+    pOut->resize( GetMaterialCount() );
+    for( UINT i = 0; i < GetMaterialCount(); i++ )
+        GetMaterial( i, &( *pOut )[i] );
+}
+
+
+
+VOID MeshCache::GetMesh( ImportedMesh* pOut ) const
+{
+    XMASSERT( pOut );
+
+    pOut->Clear();
+    if( !m_pHeader )
+        return;
+
+    pOut->Vertices.assign( GetVertices(), GetVertices() + GetVertexCount() );
+    pOut->Indices.assign( GetIndices(), GetIndices() + GetIndexCount() );
+
+    GetSubsets( &pOut->Subsets );
+    GetMaterials( &pOut->Materials );
+    pOut->HasNormals = HasNormals();
+    pOut->HasTexCoords = HasTexCoords();
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL LoadObjFileCached( const char* FileName, MeshCache* pCache, UINT ThreadCount,
+                        const MeshMissingNormalOptions* pOptions )
+{
+    XMASSERT( FileName );
+    XMASSERT( pCache );
+
+    std::string CacheName = std::string( FileName ) + ".meshcache";
+    std::string Directory( FileName );
+    size_t Separator = Directory.find_last_of( "/\\" );
+    Directory.resize( Separator == std::string::npos ? 0 : Separator + 1 );
+
+    UINT64 OptionsKey = GetMeshCacheOptionsKey( pOptions );
+    if( pCache->Open( CacheName.c_str() ) && pCache->GetOptionsKey() == OptionsKey && pCache->IsCurrent( Directory ) )
+        return TRUE;
+    pCache->Close();
+
+    // The OBJ is hashed before it is read, so a change while importing is
+    // seen on the next run rather than recorded as imported.
+    std::vector<std::string> Dependencies( 1, std::string( FileName + Directory.size() ) );
+    std::vector<UINT64> Hashes( 1 ), Sizes( 1 );
+    if( !ComputeFileHash( FileName, &Hashes[0], &Sizes[0] ) )
+        return FALSE;
+
+    ImportedMesh Mesh;
+    if( !LoadObjFile( FileName, &Mesh, ThreadCount, &Dependencies ) )
+        return FALSE;
+    if( pOptions )
+        FillMissingNormals( &Mesh, *pOptions, ThreadCount );
+
+    // A material library that cannot be hashed keeps a zero hash, which
+    // makes the cache stale: the mesh is imported again next time.
+    Hashes.resize( Dependencies.size(), 0 );
+    Sizes.resize( Dependencies.size(), 0 );
+    for( size_t i = 1; i < Dependencies.size(); i++ )
+    {
+        if( !ComputeFileHash( ( Directory + Dependencies[i] ).c_str(), &Hashes[i], &Sizes[i] ) )
+            Hashes[i] = Sizes[i] = 0;
+    }
+
+    std::vector<BYTE> Image;
+    BuildMeshCacheImage( Mesh, Dependencies, &Hashes[0], &Sizes[0], &Image, OptionsKey );
+
+    if( WriteFileAtomic( CacheName.c_str(), Image.empty() ? NULL : &Image[0], Image.size() ) && pCache->Open( CacheName.c_str() ) )
+        return TRUE;
+
+    // Read only location: serve the image from memory.
+    return pCache->Open( Image );
+}
+
+}; // namespace
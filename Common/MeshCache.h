@@ -0,0 +1,186 @@
+//-------------------------------------------------------------------------------------
+// MeshCache.h
+//
+// Binary image of an ImportedMesh, written the first time a mesh file is
+// imported and memory mapped on the next runs instead of parsing the file
+// again. The vertex and index arrays are used in place: they can be handed to
+// CreateBuffer straight from the mapped file, without a copy.
+//
+// Layout (little endian, every section aligned to MeshCacheAlignment bytes
+// from the start of the file, so the arrays are aligned in the mapping):
+//
+//   MeshCacheHeader
+//   vertices        VertexCount ImportedVertex
+//   indices         IndexCount UINT
+//   subsets         SubsetCount MeshCacheSubset
+//   materials       MaterialCount MeshCacheMaterial
+//   dependencies    DependencyCount MeshCacheDependency
+//   strings         NUL terminated, referenced by offset
+//
+// The dependencies are the files the mesh was imported from (the mesh file
+// first, then for instance its MTL files), by name relative to the mesh file
+// and with a hash of their contents. The cache is current while every one of
+// them still hashes the same, so touching a file without changing it does
+// not invalidate the cache and restoring an older file does. A mesh read
+// without normals can be cached welded and with smooth normals; the header
+// keeps a key of the options, and a cache built with other ones is stale.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _MESH_CACHE_H_
+#define _MESH_CACHE_H_
+
+#include <string>
+#include <vector>
+#include "ImportedMesh.h"
+#include "MappedFile.h"
+#include "MeshWeld.h"
+
+namespace XNA
+{
+
+static const UINT MeshCacheMagic = 0x4843534d;         // "MSCH"
+static const UINT MeshCacheVersion = 3;
+static const UINT MeshCacheAlignment = 64;
+
+static const UINT MeshCacheHasNormals = 0x1;
+static const UINT MeshCacheHasTexCoords = 0x2;
+
+struct MeshCacheHeader
+{
+    UINT Magic;
+    UINT Version;
+    UINT64 FileSize;
+    UINT Flags;
+    UINT VertexStride;          // sizeof( ImportedVertex ) of the writer.
+    UINT VertexCount;
+    UINT IndexCount;
+    UINT SubsetCount;
+    UINT MaterialCount;
+    UINT DependencyCount;
+    UINT StringSize;
+    XMFLOAT3 BoundsCenter;      // Axis aligned bounds of all the vertices.
+    XMFLOAT3 BoundsExtents;
+    UINT64 VertexOffset;
+    UINT64 IndexOffset;
+    UINT64 SubsetOffset;
+    UINT64 MaterialOffset;
+    UINT64 DependencyOffset;
+    UINT64 StringOffset;
+    UINT64 OptionsKey;          // GetMeshCacheOptionsKey of the processing applied.
+};
+
+struct MeshCacheSubset
+{
+    UINT Material;
+    UINT FirstIndex;
+    UINT IndexCount;
+    UINT BaseVertex;
+    XMFLOAT3 BoundsCenter;      // Bounds of the vertices the subset draws.
+    XMFLOAT3 BoundsExtents;
+};
+
+struct MeshCacheMaterial
+{
+    XMFLOAT3 Ambient;
+    XMFLOAT3 Diffuse;
+    XMFLOAT3 Specular;
+    FLOAT SpecularPower;
+    FLOAT Opacity;
+    UINT Name;                  // Offsets in the string section.
+    UINT DiffuseMap;
+    UINT NormalMap;
+};
+
+struct MeshCacheDependency
+{
+    UINT64 Hash;                // ComputeContentHash of the file.
+    UINT64 Size;
+    UINT Path;                  // Offset in the string section.
+    UINT Reserved;
+};
+
+//-----------------------------------------------------------------------------
+// A mapped (or, if it could not be written, in memory) cache image.
+//-----------------------------------------------------------------------------
+class MeshCache
+{
+public:
+    MeshCache();
+    ~MeshCache();
+
+    // Maps a cache file. Returns FALSE if it cannot be read or is not a
+    // complete cache of this version; it is not checked against its sources.
+    BOOL Open( const char* FileName );
+
+    // Takes over an image built by BuildMeshCacheImage.
+    BOOL Open( std::vector<BYTE>& Image );
+
+    VOID Close();
+
+    // TRUE between a successful Open and Close.
+    BOOL IsOpen() const;
+
+    // TRUE if every dependency, looked up relative to Directory (empty, or
+    // ending with a separator), still has the contents the cache was built
+    // from.
+    BOOL IsCurrent( const std::string& Directory ) const;
+
+    UINT GetVertexCount() const;
+    const ImportedVertex* GetVertices() const;
+    UINT GetIndexCount() const;
+    const UINT* GetIndices() const;
+    UINT GetSubsetCount() const;
+    const MeshCacheSubset* GetSubsets() const;
+    UINT GetMaterialCount() const;
+    VOID GetMaterial( UINT Index, ImportedMaterial* pOut ) const;
+    UINT GetDependencyCount() const;
+    const MeshCacheDependency* GetDependencies() const;
+    const char* GetString( UINT Offset ) const;
+    BOOL HasNormals() const;
+    BOOL HasTexCoords() const;
+    UINT64 GetOptionsKey() const;
+    VOID GetBounds( AxisAlignedBox* pOut ) const;
+
+    // The subsets and materials as ImportedMesh has them.
+    VOID GetSubsets( std::vector<ImportedSubset>* pOut ) const;
+    VOID GetMaterials( std::vector<ImportedMaterial>* pOut ) const;
+
+    // Copies the cached mesh out.
+    VOID GetMesh( ImportedMesh* pOut ) const;
+
+private:
+    BOOL Attach( const BYTE* pData, size_t Size );
+
+    MeshCache( const MeshCache& rhs );
+    MeshCache& operator=( const MeshCache& rhs );
+
+private:
+    MappedFile m_File;
+    std::vector<BYTE> m_Image;
+    const BYTE* m_pData;
+    const MeshCacheHeader* m_pHeader;
+};
+
+// Key of the processing a cache was built with: 0 for a mesh cached as read,
+// otherwise a hash of the options.
+UINT64 GetMeshCacheOptionsKey( const MeshMissingNormalOptions* pOptions );
+
+// Cache image of a mesh and the files it was imported from. The dependency
+// names are stored as given; pHashes and pSizes are parallel to them.
+VOID BuildMeshCacheImage( const ImportedMesh& Mesh, const std::vector<std::string>& Dependencies,
+                          const UINT64* pHashes, const UINT64* pSizes, std::vector<BYTE>* pImage,
+                          UINT64 OptionsKey = 0 );
+
+// Opens the cache of an OBJ file (FileName with ".meshcache" appended) if it
+// is current and was built with pOptions; otherwise loads the OBJ with
+// LoadObjFile, applies FillMissingNormals with pOptions (unless NULL), writes
+// the cache and opens it, or keeps the image in memory if it cannot be
+// written. Returns FALSE if the OBJ cannot be loaded.
+BOOL LoadObjFileCached( const char* FileName, MeshCache* pCache, UINT ThreadCount = 0,
+                        const MeshMissingNormalOptions* pOptions = NULL );
+
+}; // namespace
+
+#endif
@@ -0,0 +1,792 @@
+//-------------------------------------------------------------------------------------
+// MeshCodec.cpp
+//
+// Index and vertex buffer codecs. The index decoder is scalar: each triangle
+// depends on the FIFOs the previous one left. The vertex decoder unpacks,
+// transposes and sums with SSE2 where the target has it.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include "MeshCodec.h"
+
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define MESH_CODEC_SSE2
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+#endif
+
+namespace XNA
+{
+
+static const UINT FifoSize = 16;
+static const UINT EdgeCodeCount = 15;          // Edge FIFO positions a code can name; 15 means no edge.
+static const UINT VertexNext = 0;              // Vertex codes: the next unused vertex,
+static const UINT VertexExplicit = 15;         // a varint, or 1 to 14: a position in the vertex FIFO.
+static const UINT GroupSize = 16;
+static const UINT MaxVarintSize = 5;
+
+// Bytes a group takes in each mode, before escapes.
+static const UINT GroupModeSize[4] = { 0, 4, 8, 16 };
+static const UINT MaxGroupSize = 8 + GroupSize;    // 4 bits with every byte escaped.
+
+
+
+//-----------------------------------------------------------------------------
+// Index codec.
+//-----------------------------------------------------------------------------
+
+// The state the encoder and the decoder both keep.
+struct IndexCodecState
+{
+    UINT Edges[FifoSize][2];
+    UINT Vertices[FifoSize];
+    UINT EdgeOffset;
+    UINT VertexOffset;
+    UINT Next;
+    UINT Last;
+
+    IndexCodecState() : EdgeOffset( 0 ), VertexOffset( 0 ), Next( 0 ), Last( 0 )
+    {
+        memset( Edges, 0, sizeof( Edges ) );
+        memset( Vertices, 0, sizeof( Vertices ) );
+    }
+
+    // Pushes the edge as the triangle on its other side has it.
+    void PushEdge( UINT a, UINT b )
+    {
+        Edges[EdgeOffset & ( FifoSize - 1 )][0] = a;
+        Edges[EdgeOffset & ( FifoSize - 1 )][1] = b;
+        EdgeOffset++;
+    }
+
+    void PushVertex( UINT v )
+    {
+        Vertices[VertexOffset & ( FifoSize - 1 )] = v;
+        VertexOffset++;
+    }
+
+    // Position 0 is the most recent.
+    const UINT* GetEdge( UINT Position ) const
+    {
+        return Edges[( EdgeOffset - 1 - Position ) & ( FifoSize - 1 )];
+    }
+
+    UINT GetVertex( UINT Position ) const
+    {
+        return Vertices[( VertexOffset - 1 - Position ) & ( FifoSize - 1 )];
+    }
+};
+
+
+
+static inline UINT ZigZag32( INT Value )
+{
+    return ( ( UINT )Value << 1 ) ^ ( UINT )( Value >> 31 );
+}
+
+static inline INT UnZigZag32( UINT Value )
+{
+    return ( INT )( Value >> 1 ) ^ -( INT )( Value & 1 );
+}
+
+
+
+static void WriteVarint( UINT Value, std::vector<BYTE>* pOut )
+{
+    while( Value >= 0x80 )
+    {
+        pOut->push_back( ( BYTE )( Value | 0x80 ) );
+        Value >>= 7;
+    }
+    pOut->push_back( ( BYTE )Value );
+}
+
+
+
+static inline BOOL ReadVarint( const BYTE** ppData, const BYTE* pEnd, UINT* pValue )
+{
+    const BYTE* p = *ppData;
+    UINT Value = 0;
+    for( UINT Shift = 0; Shift < 7 * MaxVarintSize; Shift += 7 )
+    {
+        if( p == pEnd )
+            return FALSE;
+        BYTE b = *p++;
+        Value |= ( UINT )( b & 0x7f ) << Shift;
+        if( b < 0x80 )
+        {
+            *ppData = p;
+            *pValue = Value;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Code of vertex v, and its update of the state; an explicit vertex goes to
+// pData.
+//-----------------------------------------------------------------------------
+static UINT EncodeVertex( IndexCodecState* pState, UINT v, std::vector<BYTE>* pData )
+{
+    if( v == pState->Next )
+    {
+        pState->Next++;
+        pState->PushVertex( v );
+        return VertexNext;
+    }
+
+    for( UINT i = 0; i < VertexExplicit - 1; i++ )
+    {
+        if( pState->GetVertex( i ) == v )
+            return i + 1;
+    }
+
+    WriteVarint( ZigZag32( ( INT )( v - pState->Last ) ), pData );
+    pState->Last = v;
+    pState->PushVertex( v );
+    return VertexExplicit;
+}
+
+
+
+static inline BOOL DecodeVertex( IndexCodecState* pState, UINT Code, const BYTE** ppData, const BYTE* pEnd, UINT* pVertex )
+{
+    if( Code == VertexNext )
+    {
+        *pVertex = pState->Next++;
+        pState->PushVertex( *pVertex );
+    }
+    else if( Code < VertexExplicit )
+    {
+        *pVertex = pState->GetVertex( Code - 1 );
+    }
+    else
+    {
+        UINT Delta;
+        if( !ReadVarint( ppData, pEnd, &Delta ) )
+            return FALSE;
+        *pVertex = pState->Last + ( UINT )UnZigZag32( Delta );
+        pState->Last = *pVertex;
+        pState->PushVertex( *pVertex );
+    }
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+size_t GetIndexCodecBound( UINT IndexCount )
+{
+    size_t TriangleCount = IndexCount / 3;
+    return 1 + TriangleCount * ( 2 + 3 * MaxVarintSize );
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL EncodeIndexBuffer( const UINT* pIndices, UINT IndexCount, std::vector<BYTE>* pOut )
+{
+    XMASSERT( pOut );
+    XMASSERT( IndexCount == 0 || pIndices );
+
+    if( IndexCount % 3 != 0 )
+        return FALSE;
+
+    UINT TriangleCount = IndexCount / 3;
+    std::vector<BYTE> Data;
+    pOut->assign( 1 + TriangleCount, 0 );
+    ( *pOut )[0] = MeshIndexCodecTag;
+
+    IndexCodecState State;
+    for( UINT t = 0; t < TriangleCount; t++ )
+    {
+        UINT a = pIndices[3 * t], b = pIndices[3 * t + 1], c = pIndices[3 * t + 2];
+
+        // A recent edge of the triangle, rotated to be a, b.
+        UINT Edge = EdgeCodeCount;
+        for( UINT i = 0; i < EdgeCodeCount && Edge == EdgeCodeCount; i++ )
+        {
+            const UINT* e = State.GetEdge( i );
+            UINT Rotated[3] = { a, b, c };
+            for( UINT r = 0; r < 3; r++ )
+            {
+                if( e[0] == Rotated[r] && e[1] == Rotated[( r + 1 ) % 3] )
+                {
+                    a = Rotated[r];
+                    b = Rotated[( r + 1 ) % 3];
+                    c = Rotated[( r + 2 ) % 3];
+                    Edge = i;
+                    break;
+                }
+            }
+        }
+
+        BYTE Code;
+        if( Edge < EdgeCodeCount )
+        {
+            Code = ( BYTE )( ( Edge << 4 ) | EncodeVertex( &State, c, &Data ) );
+        }
+        else
+        {
+            // The second byte goes first: the decoder reads it before the
+            // varints of the vertices.
+            size_t Second = Data.size();
+            Data.push_back( 0 );
+            UINT CodeA = EncodeVertex( &State, a, &Data );
+            UINT CodeB = EncodeVertex( &State, b, &Data );
+            UINT CodeC = EncodeVertex( &State, c, &Data );
+            Data[Second] = ( BYTE )( ( CodeB << 4 ) | CodeC );
+            Code = ( BYTE )( 0xf0 | CodeA );
+            State.PushEdge( b, a );
+        }
+        State.PushEdge( c, b );
+        State.PushEdge( a, c );
+        ( *pOut )[1 + t] = Code;
+    }
+
+    pOut->insert( pOut->end(), Data.begin(), Data.end() );
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL DecodeIndexBuffer( UINT* pIndices, UINT IndexCount, const BYTE* pSrc, size_t SrcSize )
+{
+    XMASSERT( IndexCount == 0 || pIndices );
+
+    UINT TriangleCount = IndexCount / 3;
+    if( IndexCount % 3 != 0 || SrcSize < 1 + ( size_t )TriangleCount || pSrc[0] != MeshIndexCodecTag )
+        return FALSE;
+
+    const BYTE* pCodes = pSrc + 1;
+    const BYTE* pData = pCodes + TriangleCount;
+    const BYTE* pEnd = pSrc + SrcSize;
+
+    IndexCodecState State;
+    for( UINT t = 0; t < TriangleCount; t++ )
+    {
+        UINT Code = pCodes[t];
+        UINT a, b, c;
+        if( ( Code >> 4 ) < EdgeCodeCount )
+        {
+            const UINT* e = State.GetEdge( Code >> 4 );
+            a = e[0];
+            b = e[1];
+            if( !DecodeVertex( &State, Code & 15, &pData, pEnd, &c ) )
+                return FALSE;
+        }
+        else
+        {
+            if( pData == pEnd )
+                return FALSE;
+            UINT Second = *pData++;
+            if( !DecodeVertex( &State, Code & 15, &pData, pEnd, &a ) ||
+                !DecodeVertex( &State, Second >> 4, &pData, pEnd, &b ) ||
+                !DecodeVertex( &State, Second & 15, &pData, pEnd, &c ) )
+                return FALSE;
+            State.PushEdge( b, a );
+        }
+        State.PushEdge( c, b );
+        State.PushEdge( a, c );
+
+        pIndices[3 * t] = a;
+        pIndices[3 * t + 1] = b;
+        pIndices[3 * t + 2] = c;
+    }
+
+    return pData == pEnd;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Vertex codec.
+//-----------------------------------------------------------------------------
+
+static inline BYTE ZigZag8( BYTE Delta )
+{
+    return ( BYTE )( ( Delta << 1 ) ^ ( ( signed char )Delta >> 7 ) );
+}
+
+static inline BYTE UnZigZag8( BYTE Value )
+{
+    return ( BYTE )( ( Value >> 1 ) ^ -( Value & 1 ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Appends a plane of GroupCount groups: a 2 bit mode per group, then the
+// groups.
+//-----------------------------------------------------------------------------
+static void EncodePlane( const BYTE* pPlane, UINT GroupCount, std::vector<BYTE>* pOut )
+{
+    size_t Header = pOut->size();
+    pOut->resize( Header + ( GroupCount + 3 ) / 4, 0 );
+
+    for( UINT g = 0; g < GroupCount; g++ )
+    {
+        const BYTE* pGroup = pPlane + GroupSize * g;
+
+        // Cheapest mode, escapes included.
+        UINT Size[4] = { 0, GroupModeSize[1], GroupModeSize[2], GroupModeSize[3] };
+        for( UINT j = 0; j < GroupSize; j++ )
+        {
+            Size[0] += pGroup[j] != 0 ? GroupSize + 1 : 0;
+            Size[1] += pGroup[j] >= 3 ? 1 : 0;
+            Size[2] += pGroup[j] >= 15 ? 1 : 0;
+        }
+        UINT Mode = 0;
+        for( UINT m = 1; m < 4; m++ )
+            Mode = Size[m] < Size[Mode] ? m : Mode;
+
+        ( *pOut )[Header + g / 4] |= ( BYTE )( Mode << ( 2 * ( g % 4 ) ) );
+        if( Mode == 3 )
+        {
+            pOut->insert( pOut->end(), pGroup, pGroup + GroupSize );
+        }
+        else if( Mode != 0 )
+        {
+            UINT Bits = Mode == 1 ? 2 : 4;
+            UINT PerByte = 8 / Bits;
+            BYTE Max = ( BYTE )( ( 1 << Bits ) - 1 );
+            for( UINT j = 0; j < GroupSize; j += PerByte )
+            {
+                BYTE Packed = 0;
+                for( UINT k = 0; k < PerByte; k++ )
+                    Packed |= ( BYTE )( ( pGroup[j + k] < Max ? pGroup[j + k] : Max ) << ( Bits * k ) );
+                pOut->push_back( Packed );
+            }
+            for( UINT j = 0; j < GroupSize; j++ )
+            {
+                if( pGroup[j] >= Max )
+                    pOut->push_back( pGroup[j] );
+            }
+        }
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// One group of the given mode into pGroup. Returns the end of the group in
+// the data, or NULL if it does not fit before pEnd.
+//-----------------------------------------------------------------------------
+static const BYTE* DecodeGroup( const BYTE* pData, const BYTE* pEnd, BYTE* pGroup, UINT Mode )
+{
+    if( ( size_t )( pEnd - pData ) < GroupModeSize[Mode] )
+        return NULL;
+
+    if( Mode == 0 )
+    {
+        memset( pGroup, 0, GroupSize );
+        return pData;
+    }
+    else if( Mode == 3 )
+    {
+        memcpy( pGroup, pData, GroupSize );
+        return pData + GroupSize;
+    }
+
+    UINT Bits = Mode == 1 ? 2 : 4;
+    UINT PerByte = 8 / Bits;
+    BYTE Max = ( BYTE )( ( 1 << Bits ) - 1 );
+    const BYTE* pPacked = pData;
+    pData += GroupModeSize[Mode];
+    for( UINT j = 0; j < GroupSize; j++ )
+    {
+        pGroup[j] = ( BYTE )( ( pPacked[j / PerByte] >> ( Bits * ( j % PerByte ) ) ) & Max );
+
+        // The bytes at the maximum follow the group, in order.
+        if( pGroup[j] == Max )
+        {
+            if( pData == pEnd )
+                return NULL;
+            pGroup[j] = *pData++;
+        }
+    }
+    return pData;
+}
+
+
+
+#if defined( MESH_CODEC_SSE2 )
+
+static inline UINT LowestBit( UINT Mask )
+{
+#if defined( _MSC_VER )
+    unsigned long Index;
+    _BitScanForward( &Index, Mask );
+    return Index;
+#else
+    return ( UINT )__builtin_ctz( Mask );
+#endif
+}
+
+
+
+//-----------------------------------------------------------------------------
+// DecodeGroup where 16 bytes can be read at pData.
+//-----------------------------------------------------------------------------
+static inline const BYTE* DecodeGroupSse2( const BYTE* pData, const BYTE* pEnd, BYTE* pGroup, UINT Mode )
+{
+    __m128i Values;
+    UINT Escapes;
+    if( Mode == 0 )
+    {
+        _mm_storeu_si128( ( __m128i* )pGroup, _mm_setzero_si128() );
+        return pData;
+    }
+    else if( Mode == 3 )
+    {
+        _mm_storeu_si128( ( __m128i* )pGroup, _mm_loadu_si128( ( const __m128i* )pData ) );
+        return pData + GroupSize;
+    }
+    else if( Mode == 1 )
+    {
+        // Byte j of the group is in byte j / 4, at bit 2 * ( j % 4 ): every
+        // byte is spread four times and each copy shifted by its own amount,
+        // two at a time in 16 bit lanes.
+        INT Packed;
+        memcpy( &Packed, pData, sizeof( Packed ) );
+        __m128i Spread = _mm_cvtsi32_si128( Packed );
+        Spread = _mm_unpacklo_epi8( Spread, Spread );
+        Spread = _mm_unpacklo_epi16( Spread, Spread );
+        const __m128i Low = _mm_set1_epi32( 0x00000003 );
+        Values = _mm_and_si128( Spread, Low );
+        Values = _mm_or_si128( Values, _mm_and_si128( _mm_srli_epi16( Spread, 2 ), _mm_slli_si128( Low, 1 ) ) );
+        Values = _mm_or_si128( Values, _mm_and_si128( _mm_srli_epi16( Spread, 4 ), _mm_slli_si128( Low, 2 ) ) );
+        Values = _mm_or_si128( Values, _mm_and_si128( _mm_srli_epi16( Spread, 6 ), _mm_slli_si128( Low, 3 ) ) );
+        Escapes = ( UINT )_mm_movemask_epi8( _mm_cmpeq_epi8( Values, _mm_set1_epi8( 3 ) ) );
+    }
+    else
+    {
+        // Byte j in byte j / 2, at bit 4 * ( j % 2 ).
+        __m128i Spread = _mm_loadl_epi64( ( const __m128i* )pData );
+        Spread = _mm_unpacklo_epi8( Spread, Spread );
+        const __m128i Low = _mm_set1_epi16( 0x000f );
+        Values = _mm_and_si128( Spread, Low );
+        Values = _mm_or_si128( Values, _mm_and_si128( _mm_srli_epi16( Spread, 4 ), _mm_slli_epi16( Low, 8 ) ) );
+        Escapes = ( UINT )_mm_movemask_epi8( _mm_cmpeq_epi8( Values, _mm_set1_epi8( 15 ) ) );
+    }
+
+    _mm_storeu_si128( ( __m128i* )pGroup, Values );
+    pData += GroupModeSize[Mode];
+
+    // The bytes at the maximum follow the group, in order.
+    while( Escapes != 0 )
+    {
+        if( pData == pEnd )
+            return NULL;
+        pGroup[LowestBit( Escapes )] = *pData++;
+        Escapes &= Escapes - 1;
+    }
+    return pData;
+}
+
+#endif
+
+
+
+//-----------------------------------------------------------------------------
+// The GroupCount groups of a plane into pPlane. Returns the end of the plane
+// in the data, or NULL if it does not fit before pEnd.
+//-----------------------------------------------------------------------------
+static const BYTE* DecodePlane( const BYTE* pData, const BYTE* pEnd, BYTE* pPlane, UINT GroupCount )
+{
+    UINT HeaderSize = ( GroupCount + 3 ) / 4;
+    if( ( size_t )( pEnd - pData ) < HeaderSize )
+        return NULL;
+    const BYTE* pHeader = pData;
+    pData += HeaderSize;
+
+    UINT g = 0;
+#if defined( MESH_CODEC_SSE2 )
+    // Four groups per header byte while the largest four fit: none of them
+    // can then fail or read past pEnd.
+    for( ; g + 4 <= GroupCount && ( size_t )( pEnd - pData ) >= 4 * MaxGroupSize; g += 4 )
+    {
+        UINT Modes = pHeader[g / 4];
+        BYTE* pGroup = pPlane + GroupSize * g;
+        pData = DecodeGroupSse2( pData, pEnd, pGroup, Modes & 3 );
+        pData = DecodeGroupSse2( pData, pEnd, pGroup + GroupSize, ( Modes >> 2 ) & 3 );
+        pData = DecodeGroupSse2( pData, pEnd, pGroup + 2 * GroupSize, ( Modes >> 4 ) & 3 );
+        pData = DecodeGroupSse2( pData, pEnd, pGroup + 3 * GroupSize, Modes >> 6 );
+    }
+#endif
+    for( ; g < GroupCount && pData; g++ )
+        pData = DecodeGroup( pData, pEnd, pPlane + GroupSize * g, ( pHeader[g / 4] >> ( 2 * ( g % 4 ) ) ) & 3 );
+    return pData;
+}
+
+
+
+//-----------------------------------------------------------------------------
+size_t GetVertexCodecBound( UINT VertexCount, UINT Stride )
+{
+    size_t BlockCount = ( VertexCount + MeshCodecBlockVertices - 1 ) / MeshCodecBlockVertices;
+    size_t PlaneSize = ( MeshCodecBlockVertices / GroupSize + 3 ) / 4 + MeshCodecBlockVertices;
+    return 1 + BlockCount * Stride * PlaneSize;
+}
+
+
+
+static inline BOOL IsCodecStride( UINT Stride )
+{
+    return Stride > 0 && Stride <= MeshCodecMaxStride && Stride % 4 == 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL EncodeVertexBuffer( const void* pVertices, UINT VertexCount, UINT Stride, std::vector<BYTE>* pOut )
+{
+    XMASSERT( pOut );
+    XMASSERT( VertexCount == 0 || pVertices );
+
+    if( !IsCodecStride( Stride ) )
+        return FALSE;
+
+    pOut->clear();
+    pOut->reserve( GetVertexCodecBound( VertexCount, Stride ) );
+    pOut->push_back( MeshVertexCodecTag );
+
+    const BYTE* pSrc = static_cast<const BYTE*>( pVertices );
+    BYTE Previous[MeshCodecMaxStride] = {};
+    BYTE Plane[MeshCodecBlockVertices];
+    for( UINT Base = 0; Base < VertexCount; Base += MeshCodecBlockVertices )
+    {
+        UINT Count = ( std::min )( VertexCount - Base, MeshCodecBlockVertices );
+        UINT GroupCount = ( Count + GroupSize - 1 ) / GroupSize;
+        memset( Plane, 0, sizeof( Plane ) );
+        for( UINT k = 0; k < Stride; k++ )
+        {
+            BYTE Last = Previous[k];
+            for( UINT i = 0; i < Count; i++ )
+            {
+                BYTE Value = pSrc[( size_t )( Base + i ) * Stride + k];
+                Plane[i] = ZigZag8( ( BYTE )( Value - Last ) );
+                Last = Value;
+            }
+            Previous[k] = Last;
+            EncodePlane( Plane, GroupCount, pOut );
+        }
+    }
+    return TRUE;
+}
+
+
+
+#if defined( MESH_CODEC_SSE2 )
+
+// The low 4 bytes of x.
+static inline void StoreWord( BYTE* p, __m128i x )
+{
+    _mm_store_ss( ( float* )p, _mm_castsi128_ps( x ) );
+}
+
+
+
+static inline __m128i UnZigZag8( __m128i x )
+{
+    __m128i Sign = _mm_sub_epi8( _mm_setzero_si128(), _mm_and_si128( x, _mm_set1_epi8( 1 ) ) );
+    return _mm_xor_si128( _mm_and_si128( _mm_srli_epi16( x, 1 ), _mm_set1_epi8( 0x7f ) ), Sign );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Four planes of Count differences into bytes 0 to 3 of the vertices at pDst,
+// after the bytes pLast of the previous vertex, which get the bytes of the
+// last one.
+//-----------------------------------------------------------------------------
+static void SumPlanes4( const BYTE ( *pPlanes )[MeshCodecBlockVertices], UINT Count, BYTE* pLast, BYTE* pDst, UINT Stride )
+{
+    INT LastWord;
+    memcpy( &LastWord, pLast, sizeof( LastWord ) );
+    __m128i Last = _mm_set1_epi32( LastWord );
+    for( UINT v = 0; v < Count; v += GroupSize )
+    {
+        // Transposes 16 vertices of the four planes: four bytes per vertex,
+        // four vertices per register.
+        __m128i r0 = _mm_loadu_si128( ( const __m128i* )( pPlanes[0] + v ) );
+        __m128i r1 = _mm_loadu_si128( ( const __m128i* )( pPlanes[1] + v ) );
+        __m128i r2 = _mm_loadu_si128( ( const __m128i* )( pPlanes[2] + v ) );
+        __m128i r3 = _mm_loadu_si128( ( const __m128i* )( pPlanes[3] + v ) );
+        __m128i t0 = _mm_unpacklo_epi8( r0, r1 );
+        __m128i t1 = _mm_unpackhi_epi8( r0, r1 );
+        __m128i t2 = _mm_unpacklo_epi8( r2, r3 );
+        __m128i t3 = _mm_unpackhi_epi8( r2, r3 );
+        __m128i Quads[4] =
+        {
+            _mm_unpacklo_epi16( t0, t2 ), _mm_unpackhi_epi16( t0, t2 ),
+            _mm_unpacklo_epi16( t1, t3 ), _mm_unpackhi_epi16( t1, t3 ),
+        };
+
+        for( UINT q = 0; q < 4; q++ )
+        {
+            // A running sum over the four vertices, bytes wrapping as in the
+            // encoder.
+            __m128i x = UnZigZag8( Quads[q] );
+            x = _mm_add_epi8( x, _mm_slli_si128( x, 4 ) );
+            x = _mm_add_epi8( x, _mm_slli_si128( x, 8 ) );
+            x = _mm_add_epi8( x, Last );
+            Last = _mm_shuffle_epi32( x, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+
+            UINT First = v + 4 * q;
+            BYTE* pVertex = pDst + ( size_t )First * Stride;
+            if( First + 4 <= Count )
+            {
+                StoreWord( pVertex, x );
+                StoreWord( pVertex + Stride, _mm_shuffle_epi32( x, _MM_SHUFFLE( 1, 1, 1, 1 ) ) );
+                StoreWord( pVertex + 2 * Stride, _mm_shuffle_epi32( x, _MM_SHUFFLE( 2, 2, 2, 2 ) ) );
+                StoreWord( pVertex + 3 * Stride, Last );
+                continue;
+            }
+            for( UINT i = First; i < Count; i++, pVertex += Stride )
+            {
+                StoreWord( pVertex, x );
+                x = _mm_srli_si128( x, 4 );
+            }
+        }
+    }
+    LastWord = _mm_cvtsi128_si32( Last );
+    memcpy( pLast, &LastWord, sizeof( LastWord ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// SumPlanes4 for 16 planes: a whole 16 x 16 transpose, and one 16 byte store
+// per vertex.
+//-----------------------------------------------------------------------------
+static void SumPlanes16( const BYTE ( *pPlanes )[MeshCodecBlockVertices], UINT Count, BYTE* pLast, BYTE* pDst, UINT Stride )
+{
+    __m128i Last = _mm_loadu_si128( ( const __m128i* )pLast );
+    for( UINT v = 0; v < Count; v += GroupSize )
+    {
+        // Pairs of planes, then quads, then eight, then all 16: a[] holds
+        // vertices 0-7 and 8-15 of two planes, b[] four vertices of four
+        // planes, c[] two vertices of eight planes.
+        __m128i a[16];
+        for( UINT p = 0; p < 16; p += 2 )
+        {
+            __m128i r0 = _mm_loadu_si128( ( const __m128i* )( pPlanes[p] + v ) );
+            __m128i r1 = _mm_loadu_si128( ( const __m128i* )( pPlanes[p + 1] + v ) );
+            a[p] = _mm_unpacklo_epi8( r0, r1 );
+            a[p + 1] = _mm_unpackhi_epi8( r0, r1 );
+        }
+
+        __m128i b[4][4];
+        for( UINT g = 0; g < 4; g++ )
+        {
+            b[g][0] = _mm_unpacklo_epi16( a[4 * g], a[4 * g + 2] );
+            b[g][1] = _mm_unpackhi_epi16( a[4 * g], a[4 * g + 2] );
+            b[g][2] = _mm_unpacklo_epi16( a[4 * g + 1], a[4 * g + 3] );
+            b[g][3] = _mm_unpackhi_epi16( a[4 * g + 1], a[4 * g + 3] );
+        }
+
+        __m128i Vertices[16];
+        for( UINT q = 0; q < 4; q++ )
+        {
+            __m128i c0 = _mm_unpacklo_epi32( b[0][q], b[1][q] );
+            __m128i c1 = _mm_unpackhi_epi32( b[0][q], b[1][q] );
+            __m128i c2 = _mm_unpacklo_epi32( b[2][q], b[3][q] );
+            __m128i c3 = _mm_unpackhi_epi32( b[2][q], b[3][q] );
+            Vertices[4 * q] = _mm_unpacklo_epi64( c0, c2 );
+            Vertices[4 * q + 1] = _mm_unpackhi_epi64( c0, c2 );
+            Vertices[4 * q + 2] = _mm_unpacklo_epi64( c1, c3 );
+            Vertices[4 * q + 3] = _mm_unpackhi_epi64( c1, c3 );
+        }
+
+        UINT End = ( std::min )( GroupSize, Count - v );
+        BYTE* pVertex = pDst + ( size_t )v * Stride;
+        for( UINT i = 0; i < End; i++, pVertex += Stride )
+        {
+            Last = _mm_add_epi8( Last, UnZigZag8( Vertices[i] ) );
+            _mm_storeu_si128( ( __m128i* )pVertex, Last );
+        }
+    }
+    _mm_storeu_si128( ( __m128i* )pLast, Last );
+}
+
+#endif
+
+
+
+//-----------------------------------------------------------------------------
+// Lanes planes of Count differences into bytes 0 to Lanes - 1 of the
+// vertices at pDst, after the bytes pLast of the previous vertex.
+//-----------------------------------------------------------------------------
+static void SumPlanes( const BYTE ( *pPlanes )[MeshCodecBlockVertices], UINT Lanes, UINT Count, BYTE* pLast, BYTE* pDst,
+                       UINT Stride )
+{
+#if defined( MESH_CODEC_SSE2 )
+    if( Lanes == 16 )
+    {
+        SumPlanes16( pPlanes, Count, pLast, pDst, Stride );
+        return;
+    }
+    for( UINT k = 0; k < Lanes; k += 4 )
+        SumPlanes4( pPlanes + k, Count, pLast + k, pDst + k, Stride );
+#else
+    for( UINT i = 0; i < Count; i++ )
+    {
+        for( UINT k = 0; k < Lanes; k++ )
+        {
+            pLast[k] = ( BYTE )( pLast[k] + UnZigZag8( pPlanes[k][i] ) );
+            pDst[( size_t )i * Stride + k] = pLast[k];
+        }
+    }
+#endif
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL DecodeVertexBuffer( void* pVertices, UINT VertexCount, UINT Stride, const BYTE* pSrc, size_t SrcSize )
+{
+    XMASSERT( VertexCount == 0 || pVertices );
+
+    if( !IsCodecStride( Stride ) || SrcSize < 1 || pSrc[0] != MeshVertexCodecTag )
+        return FALSE;
+
+    const BYTE* pData = pSrc + 1;
+    const BYTE* pEnd = pSrc + SrcSize;
+    BYTE* pDst = static_cast<BYTE*>( pVertices );
+
+    // Bytes of the previous vertex; the planes of 16 bytes of the vertices
+    // of a block at a time, then of the 4 byte words left.
+    BYTE Last[MeshCodecMaxStride] = {};
+    BYTE Planes[16][MeshCodecBlockVertices];
+
+    for( UINT Base = 0; Base < VertexCount; Base += MeshCodecBlockVertices )
+    {
+        UINT Count = ( std::min )( VertexCount - Base, MeshCodecBlockVertices );
+        UINT GroupCount = ( Count + GroupSize - 1 ) / GroupSize;
+        BYTE* pBlock = pDst + ( size_t )Base * Stride;
+        for( UINT k = 0; k < Stride; )
+        {
+            UINT Lanes = Stride - k >= 16 ? 16 : 4;
+            for( UINT p = 0; p < Lanes; p++ )
+            {
+                pData = DecodePlane( pData, pEnd, Planes[p], GroupCount );
+                if( !pData )
+                    return FALSE;
+            }
+            SumPlanes( Planes, Lanes, Count, Last + k, pBlock + k, Stride );
+            k += Lanes;
+        }
+    }
+
+    return pData == pEnd;
+}
+
+}; // namespace
@@ -0,0 +1,99 @@
+//-------------------------------------------------------------------------------------
+// MeshCodec.h
+//
+// Lossless compression of vertex and index buffers for assets on disk, with
+// decoders that write straight into the array handed to
+// BufferHelper::CreateVertexBuffer / CreateIndexBuffer.
+//
+// Indices: every triangle is one code byte. A FIFO of the last 16 edges and
+// one of the last 16 vertices follow the decoder: a triangle sharing a recent
+// edge codes the edge by its position in the FIFO and the third vertex as the
+// next unused vertex, a position in the vertex FIFO or a varint delta from
+// the last explicit vertex. Triangles without a shared edge code
+// their three vertices the same way. A triangle may come out rotated (same
+// winding, another first vertex), so flat shading from the first vertex can
+// differ. Meshes with some locality take one to two bytes per triangle,
+// before any general purpose compression.
+//
+// Vertices: blocks of MeshCodecBlockVertices vertices, each stored as byte
+// planes (byte k of every vertex of the block, for every k in the stride).
+// A plane holds the differences with the previous vertex, zigzag coded so
+// small changes either way are small bytes, in groups of 16 bytes stored
+// with 0, 2, 4 or 8 bits each; a 2 or 4 bit value at its maximum is followed
+// by the byte itself. Floats that change slowly from vertex to vertex have
+// mostly zero high bytes. The decoder unpacks the groups, transposes the
+// planes back into vertices and sums the differences with SSE2, 16 planes
+// at a time (4 for what is left of the stride).
+//
+// The two are meant to go into an AssetArchive entry, where LZ4 on top still
+// finds repetitions the byte coding leaves.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _MESH_CODEC_H_
+#define _MESH_CODEC_H_
+
+#include <vector>
+#include "xnacollision.h"
+
+namespace XNA
+{
+
+static const BYTE MeshIndexCodecTag = 0xe1;    // First byte of an encoded index buffer.
+static const BYTE MeshVertexCodecTag = 0xa1;   // First byte of an encoded vertex buffer.
+static const UINT MeshCodecBlockVertices = 256;
+static const UINT MeshCodecMaxStride = 256;
+
+//-----------------------------------------------------------------------------
+// Indices, three per triangle.
+//-----------------------------------------------------------------------------
+
+// Largest encoded size of IndexCount indices.
+size_t GetIndexCodecBound( UINT IndexCount );
+
+// Replaces *pOut with the encoded indices. Returns FALSE if IndexCount is not
+// a multiple of 3.
+BOOL EncodeIndexBuffer( const UINT* pIndices, UINT IndexCount, std::vector<BYTE>* pOut );
+
+// Decodes exactly IndexCount indices. Returns FALSE on corrupt input, which
+// is never read out of bounds.
+BOOL DecodeIndexBuffer( UINT* pIndices, UINT IndexCount, const BYTE* pSrc, size_t SrcSize );
+
+//-----------------------------------------------------------------------------
+// Vertices of any layout; Stride must be a multiple of 4, at most
+// MeshCodecMaxStride.
+//-----------------------------------------------------------------------------
+
+// Largest encoded size of VertexCount vertices.
+size_t GetVertexCodecBound( UINT VertexCount, UINT Stride );
+
+// Replaces *pOut with the encoded vertices. Returns FALSE for a stride the
+// codec does not take.
+BOOL EncodeVertexBuffer( const void* pVertices, UINT VertexCount, UINT Stride, std::vector<BYTE>* pOut );
+
+// Decodes exactly VertexCount vertices. Returns FALSE on corrupt input, which
+// is never read out of bounds.
+BOOL DecodeVertexBuffer( void* pVertices, UINT VertexCount, UINT Stride, const BYTE* pSrc, size_t SrcSize );
+
+//-----------------------------------------------------------------------------
+// Into vectors ready for BufferHelper<T>.
+//-----------------------------------------------------------------------------
+template <class T>
+BOOL DecodeVertexBuffer( std::vector<T>* pVertices, UINT VertexCount, const BYTE* pSrc, size_t SrcSize )
+{
+    XMASSERT( pVertices );
+    pVertices->resize( VertexCount );
+    return DecodeVertexBuffer( VertexCount ? &( *pVertices )[0] : NULL, VertexCount, sizeof( T ), pSrc, SrcSize );
+}
+
+inline BOOL DecodeIndexBuffer( std::vector<UINT>* pIndices, UINT IndexCount, const BYTE* pSrc, size_t SrcSize )
+{
+    XMASSERT( pIndices );
+    pIndices->resize( IndexCount );
+    return DecodeIndexBuffer( IndexCount ? &( *pIndices )[0] : NULL, IndexCount, pSrc, SrcSize );
+}
+
+}; // namespace
+
+#endif
@@ -0,0 +1,91 @@
+//-------------------------------------------------------------------------------------
+// MeshLoader.cpp
+//
+// The arena of the loaded meshes; the loader itself is templated in the header.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "MeshLoader.h"
+
+namespace XNA
+{
+
+MeshArena::MeshArena()
+    : m_pData( NULL ),
+      m_Size( 0 )
+{
+}
+
+
+
+MeshArena::~MeshArena()
+{
+    Clear();
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID* MeshArena::Reset( size_t Size )
+{
+    Clear();
+
+    // One byte at least, so an empty mesh still has an address.
+    size_t Allocated = ( ( std::max )( Size, ( size_t )1 ) + 15 ) & ~( size_t )15;
+#if defined( _WIN32 )
+    m_pData = _aligned_malloc( Allocated, 16 );
+#else
+    if( posix_memalign( &m_pData, 16, Allocated ) != 0 )
+        m_pData = NULL;
+#endif
+    if( m_pData )
+        m_Size = Size;
+    return m_pData;
+}
+
+
+
+VOID MeshArena::Clear()
+{
+#if defined( _WIN32 )
+    _aligned_free( m_pData );
+#else
+    free( m_pData );
+#endif
+    m_pData = NULL;
+    m_Size = 0;
+}
+
+
+
+VOID* MeshArena::GetData() const
+{
+    return m_pData;
+}
+
+
+
+size_t MeshArena::GetSize() const
+{
+    return m_Size;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL IsObjFileName( const char* FileName )
+{
+    XMASSERT( FileName );
+
+    size_t Length = strlen( FileName );
+    if( Length < 4 )
+        return FALSE;
+
+    const char* pExtension = FileName + Length - 4;
+    return pExtension[0] == '.' && ( pExtension[1] | 0x20 ) == 'o' && ( pExtension[2] | 0x20 ) == 'b' &&
+           ( pExtension[3] | 0x20 ) == 'j';
+}
+
+}; // namespace
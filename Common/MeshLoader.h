@@ -0,0 +1,513 @@
+//-------------------------------------------------------------------------------------
+// MeshLoader.h
+//
+// Loads a mesh file straight into the vertex struct a demo draws with, the
+// vertices and the indices in one allocation.
+//
+// The vertex layout is a compile time choice: LoadMeshFromFile<Vertex> reads
+// the offsets of the attributes from MeshVertexLayout<Vertex>, which every
+// vertex struct loaded specializes, and only converts the attributes the
+// struct has. The vertices are converted in one pass, the positions four at a
+// time with SSE where the target has it (a 16 byte load per vertex and a 12
+// byte store, or a single 16 byte store when another attribute follows the
+// position) along with the subset bounds. Attributes the file does not have
+// are zero; members of the struct the layout does not name are left for the
+// caller to fill.
+//
+// GetMeshFileSource is the one place that picks how a file is read: OBJ files
+// packed in an archive mounted on the MappedIOSystem through
+// LoadObjArchiveEntry, loose OBJ files through LoadObjFileCached and
+// converted from the mapped cache, other formats through Assimp, the meshes
+// of the scene converted in parallel by ConvertSceneMeshes as ImportScene
+// does, which uses the same conversion for ImportedVertex. The ImportedMesh
+// overload of LoadMeshFromFile, for callers that edit the mesh after loading
+// it, reads the same way and can leave a cached mesh in its mapping.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _MESH_LOADER_H_
+#define _MESH_LOADER_H_
+
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "ImportedMesh.h"
+#include "MeshCache.h"
+#include "MeshWeld.h"
+#include "ObjLoader.h"
+#include "SceneImporter.h"
+#include "mesh.h"
+#include "scene.h"
+
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __SSE__ )
+#include <xmmintrin.h>
+#define MESH_LOADER_SSE
+#endif
+
+namespace XNA
+{
+
+class AssetArchive;
+class MappedIOSystem;
+
+//-----------------------------------------------------------------------------
+// Byte offsets of the attributes of a vertex struct, -1 for the ones it does
+// not have. Specialize it for every vertex struct loaded, for instance:
+//
+//   template<> struct MeshVertexLayout<Vertex::PosNormal>
+//   {
+//       static const INT Position = offsetof( Vertex::PosNormal, Position );
+//       static const INT Normal = offsetof( Vertex::PosNormal, Normal );
+//       static const INT TexCoord = -1;
+//   };
+//
+// Position, Normal are three floats, TexCoord two.
+//-----------------------------------------------------------------------------
+template <class Vertex> struct MeshVertexLayout;
+
+template <> struct MeshVertexLayout<ImportedVertex>
+{
+    static const INT Position = offsetof( ImportedVertex, Position );
+    static const INT Normal = offsetof( ImportedVertex, Normal );
+    static const INT TexCoord = offsetof( ImportedVertex, TexCoord );
+};
+
+// TRUE if FileName ends in ".obj", in any case.
+BOOL IsObjFileName( const char* FileName );
+
+enum MeshFileSource
+{
+    MeshFileObjArchive,     // OBJ in an archive mounted on the IOSystem, parsed from the archive.
+    MeshFileObjCache,       // Loose OBJ, through its mesh cache.
+    MeshFileScene,          // Any other format, through Assimp.
+};
+
+// How LoadMeshFromFile reads FileName. *ppArchive gets the archive holding a
+// MeshFileObjArchive, NULL otherwise. pIOSystem may be NULL.
+MeshFileSource GetMeshFileSource( const char* FileName, const MappedIOSystem* pIOSystem,
+                                  const AssetArchive** ppArchive );
+
+//-----------------------------------------------------------------------------
+// One 16 byte aligned block of memory.
+//-----------------------------------------------------------------------------
+class MeshArena
+{
+public:
+    MeshArena();
+    ~MeshArena();
+
+    // Frees the block and allocates Size bytes. NULL if out of memory.
+    VOID* Reset( size_t Size );
+    VOID Clear();
+
+    VOID* GetData() const;
+    size_t GetSize() const;
+
+private:
+    MeshArena( const MeshArena& rhs );
+    MeshArena& operator=( const MeshArena& rhs );
+
+private:
+    VOID* m_pData;
+    size_t m_Size;
+};
+
+//-----------------------------------------------------------------------------
+// A loaded mesh: VertexCount vertices, then IndexCount indices, in Arena.
+// Subsets and materials as in ImportedMesh.
+//-----------------------------------------------------------------------------
+template <class Vertex>
+struct LoadedMesh
+{
+    MeshArena Arena;
+    Vertex* pVertices;
+    UINT* pIndices;
+    UINT VertexCount;
+    UINT IndexCount;
+    std::vector<ImportedSubset> Subsets;
+    std::vector<ImportedMaterial> Materials;
+    BOOL HasNormals;
+    BOOL HasTexCoords;
+
+    LoadedMesh() { Clear(); }
+
+    // Replaces the vertices and indices with uninitialized ones.
+    BOOL Allocate( UINT NewVertexCount, UINT NewIndexCount )
+    {
+        size_t IndexOffset = ( ( size_t )NewVertexCount * sizeof( Vertex ) + 15 ) & ~( size_t )15;
+        BYTE* pData = static_cast<BYTE*>( Arena.Reset( IndexOffset + ( size_t )NewIndexCount * sizeof( UINT ) ) );
+        if( !pData )
+        {
+            Clear();
+            return FALSE;
+        }
+
+        pVertices = reinterpret_cast<Vertex*>( pData );
+        pIndices = reinterpret_cast<UINT*>( pData + IndexOffset );
+        VertexCount = NewVertexCount;
+        IndexCount = NewIndexCount;
+        return TRUE;
+    }
+
+    VOID Clear()
+    {
+        Arena.Clear();
+        pVertices = NULL;
+        pIndices = NULL;
+        VertexCount = 0;
+        IndexCount = 0;
+        Subsets.clear();
+        Materials.clear();
+        HasNormals = FALSE;
+        HasTexCoords = FALSE;
+    }
+};
+
+//-----------------------------------------------------------------------------
+// The attribute at Offset of a vertex. The passes of the attributes a layout
+// does not have (Offset -1) are never run but still compiled.
+//-----------------------------------------------------------------------------
+template <INT Offset>
+inline BYTE* GetMeshAttribute( BYTE* pVertex )
+{
+    return pVertex + ( Offset < 0 ? 0 : Offset );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// The floats of an aiVector3D array. aiVector3D is declared packed, but Assimp
+// allocates the arrays with new[], so the floats are aligned.
+//-----------------------------------------------------------------------------
+inline const FLOAT* GetMeshFloats( const VOID* pVectors )
+{
+    return static_cast<const FLOAT*>( pVectors );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Whether the position can be stored as 16 bytes: the 4 bytes past it belong
+// to an attribute written after it (the normal or the texture coordinate).
+//-----------------------------------------------------------------------------
+template <class Layout>
+struct MeshWidePosition
+{
+    static const bool Value = Layout::Position >= 0 && ( Layout::Normal == Layout::Position + 12 ||
+                                                         Layout::TexCoord == Layout::Position + 12 );
+};
+
+//-----------------------------------------------------------------------------
+// The attributes of vertex Index other than the position, zero if their array
+// is NULL.
+//-----------------------------------------------------------------------------
+template <class Layout>
+inline VOID CopyMeshVertexAttributes( const FLOAT* pNormals, const FLOAT* pTexCoords, size_t Index, BYTE* pVertex )
+{
+    if( Layout::Normal >= 0 )
+    {
+        if( pNormals )
+            memcpy( GetMeshAttribute<Layout::Normal>( pVertex ), pNormals + 3 * Index, 3 * sizeof( FLOAT ) );
+        else
+            memset( GetMeshAttribute<Layout::Normal>( pVertex ), 0, 3 * sizeof( FLOAT ) );
+    }
+
+    if( Layout::TexCoord >= 0 )
+    {
+        if( pTexCoords )
+            memcpy( GetMeshAttribute<Layout::TexCoord>( pVertex ), pTexCoords + 3 * Index, 2 * sizeof( FLOAT ) );
+        else
+            memset( GetMeshAttribute<Layout::TexCoord>( pVertex ), 0, 2 * sizeof( FLOAT ) );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Converts Count vertices in one pass. NULL normals or texture coordinates
+// are zero. pBounds, if not NULL, gets the bounds of the positions.
+//
+// The positions go four at a time through SSE where the target has it, with
+// their bounds; the other attributes are fixed size moves the compiler turns
+// into one or two stores. One pass writes each vertex once: a pass per
+// attribute streams the whole vertex array through the cache again for each
+// attribute, and the copy is bound by memory, not by instructions.
+//-----------------------------------------------------------------------------
+template <class Vertex>
+inline VOID CopyMeshVertices( const aiVector3D* pPositions, const aiVector3D* pNormals, const aiVector3D* pTexCoords,
+                              size_t Count, Vertex* pOut, AxisAlignedBox* pBounds )
+{
+    typedef MeshVertexLayout<Vertex> Layout;
+    static_assert( std::is_trivially_copyable<Vertex>::value, "mesh vertices are written as bytes" );
+    static_assert( Layout::Position < 0 || Layout::Position + 12 <= INT( sizeof( Vertex ) ), "bad position offset" );
+    static_assert( Layout::Normal < 0 || Layout::Normal + 12 <= INT( sizeof( Vertex ) ), "bad normal offset" );
+    static_assert( Layout::TexCoord < 0 || Layout::TexCoord + 8 <= INT( sizeof( Vertex ) ), "bad texcoord offset" );
+    static_assert( sizeof( aiVector3D ) == 3 * sizeof( FLOAT ), "aiVector3D arrays are read as packed floats" );
+
+    const FLOAT* pSrc = GetMeshFloats( pPositions );
+    const FLOAT* pNormalSrc = GetMeshFloats( pNormals );
+    const FLOAT* pTexCoordSrc = GetMeshFloats( pTexCoords );
+    BYTE* pDst = reinterpret_cast<BYTE*>( pOut );
+
+    FLOAT Min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    FLOAT Max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    size_t i = 0;
+
+#if defined( MESH_LOADER_SSE )
+    __m128 MinV = _mm_set1_ps( FLT_MAX );
+    __m128 MaxV = _mm_set1_ps( -FLT_MAX );
+
+    // The loads of a block of four stay inside its 12 floats: the fourth
+    // vertex is loaded one float early and shifted down.
+    for( ; i + 4 <= Count; i += 4, pSrc += 12, pDst += 4 * sizeof( Vertex ) )
+    {
+        __m128 V[4];
+        V[0] = _mm_loadu_ps( pSrc );
+        V[1] = _mm_loadu_ps( pSrc + 3 );
+        V[2] = _mm_loadu_ps( pSrc + 6 );
+        V[3] = _mm_loadu_ps( pSrc + 8 );
+        V[3] = _mm_shuffle_ps( V[3], V[3], _MM_SHUFFLE( 3, 3, 2, 1 ) );
+
+        MinV = _mm_min_ps( MinV, _mm_min_ps( _mm_min_ps( V[0], V[1] ), _mm_min_ps( V[2], V[3] ) ) );
+        MaxV = _mm_max_ps( MaxV, _mm_max_ps( _mm_max_ps( V[0], V[1] ), _mm_max_ps( V[2], V[3] ) ) );
+
+        for( UINT k = 0; k < 4; k++ )
+        {
+            BYTE* pVertex = pDst + k * sizeof( Vertex );
+            if( MeshWidePosition<Layout>::Value )
+            {
+                _mm_storeu_ps( reinterpret_cast<FLOAT*>( GetMeshAttribute<Layout::Position>( pVertex ) ), V[k] );
+            }
+            else if( Layout::Position >= 0 )
+            {
+                FLOAT* pPosition = reinterpret_cast<FLOAT*>( GetMeshAttribute<Layout::Position>( pVertex ) );
+                _mm_storel_pi( reinterpret_cast<__m64*>( pPosition ), V[k] );
+                _mm_store_ss( pPosition + 2, _mm_movehl_ps( V[k], V[k] ) );
+            }
+            CopyMeshVertexAttributes<Layout>( pNormalSrc, pTexCoordSrc, i + k, pVertex );
+        }
+    }
+
+    if( i > 0 )
+    {
+        FLOAT Lanes[4];
+        _mm_storeu_ps( Lanes, MinV );
+        memcpy( Min, Lanes, sizeof( Min ) );
+        _mm_storeu_ps( Lanes, MaxV );
+        memcpy( Max, Lanes, sizeof( Max ) );
+    }
+#endif
+
+    for( ; i < Count; i++, pSrc += 3, pDst += sizeof( Vertex ) )
+    {
+        if( Layout::Position >= 0 )
+            memcpy( GetMeshAttribute<Layout::Position>( pDst ), pSrc, 3 * sizeof( FLOAT ) );
+        CopyMeshVertexAttributes<Layout>( pNormalSrc, pTexCoordSrc, i, pDst );
+
+        for( UINT k = 0; k < 3; k++ )
+        {
+            Min[k] = pSrc[k] < Min[k] ? pSrc[k] : Min[k];
+            Max[k] = pSrc[k] > Max[k] ? pSrc[k] : Max[k];
+        }
+    }
+
+    if( pBounds )
+    {
+        // No vertices: an empty box at the origin.
+        XMVECTOR MinV = Count ? XMVectorSet( Min[0], Min[1], Min[2], 0.0f ) : XMVectorZero();
+        XMVECTOR MaxV = Count ? XMVectorSet( Max[0], Max[1], Max[2], 0.0f ) : XMVectorZero();
+        XMStoreFloat3( &pBounds->Center, ( MinV + MaxV ) * 0.5f );
+        XMStoreFloat3( &pBounds->Extents, ( MaxV - MinV ) * 0.5f );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// SceneVertexConverter of a vertex struct.
+//-----------------------------------------------------------------------------
+template <class Vertex>
+VOID ConvertSceneVertices( const aiMesh* pMesh, VOID* pVertices, AxisAlignedBox* pBounds )
+{
+    CopyMeshVertices( pMesh->mVertices, pMesh->HasNormals() ? pMesh->mNormals : NULL,
+                      pMesh->HasTextureCoords( 0 ) ? pMesh->mTextureCoords[0] : NULL, pMesh->mNumVertices,
+                      static_cast<Vertex*>( pVertices ), pBounds );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Converts every mesh of a scene. Returns FALSE as ImportScene does.
+//-----------------------------------------------------------------------------
+template <class Vertex>
+BOOL LoadScene( const aiScene* pScene, LoadedMesh<Vertex>* pOut, UINT ThreadCount = 0 )
+{
+    XMASSERT( pScene );
+    XMASSERT( pOut );
+
+    pOut->Clear();
+    UINT VertexCount, IndexCount;
+    if( !PrepareSceneMeshes( pScene, &pOut->Subsets, &pOut->Materials, &pOut->HasNormals, &pOut->HasTexCoords,
+                             &VertexCount, &IndexCount ) ||
+        !pOut->Allocate( VertexCount, IndexCount ) ||
+        !ConvertSceneMeshes( pScene, &ConvertSceneVertices<Vertex>, sizeof( Vertex ), pOut->pVertices, pOut->pIndices,
+                             pOut->Subsets.empty() ? NULL : &pOut->Subsets[0], ThreadCount ) )
+    {
+        pOut->Clear();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Converts Count ImportedVertex, which already has every attribute.
+//-----------------------------------------------------------------------------
+template <class Vertex>
+inline VOID CopyImportedVertices( const ImportedVertex* pIn, size_t Count, Vertex* pOut )
+{
+    typedef MeshVertexLayout<Vertex> Layout;
+    static_assert( std::is_trivially_copyable<Vertex>::value, "mesh vertices are written as bytes" );
+
+    if( std::is_same<Vertex, ImportedVertex>::value )
+    {
+        if( Count )
+            memcpy( pOut, pIn, Count * sizeof( ImportedVertex ) );
+        return;
+    }
+
+    BYTE* pBase = reinterpret_cast<BYTE*>( pOut );
+    for( size_t i = 0; i < Count; i++, pBase += sizeof( Vertex ) )
+    {
+        if( Layout::Position >= 0 )
+            memcpy( GetMeshAttribute<Layout::Position>( pBase ), &pIn[i].Position, sizeof( XMFLOAT3 ) );
+        if( Layout::Normal >= 0 )
+            memcpy( GetMeshAttribute<Layout::Normal>( pBase ), &pIn[i].Normal, sizeof( XMFLOAT3 ) );
+        if( Layout::TexCoord >= 0 )
+            memcpy( GetMeshAttribute<Layout::TexCoord>( pBase ), &pIn[i].TexCoord, sizeof( XMFLOAT2 ) );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Converts an ImportedMesh.
+//-----------------------------------------------------------------------------
+template <class Vertex>
+BOOL LoadImportedMesh( const ImportedMesh& Mesh, LoadedMesh<Vertex>* pOut )
+{
+    XMASSERT( pOut );
+
+    pOut->Clear();
+    if( !pOut->Allocate( UINT( Mesh.Vertices.size() ), UINT( Mesh.Indices.size() ) ) )
+        return FALSE;
+
+    CopyImportedVertices( Mesh.Vertices.data(), Mesh.Vertices.size(), pOut->pVertices );
+    if( !Mesh.Indices.empty() )
+        memcpy( pOut->pIndices, Mesh.Indices.data(), Mesh.Indices.size() * sizeof( UINT ) );
+
+    pOut->Subsets = Mesh.Subsets;
+    pOut->Materials = Mesh.Materials;
+    pOut->HasNormals = Mesh.HasNormals;
+    pOut->HasTexCoords = Mesh.HasTexCoords;
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Converts a mesh cache, from its mapping.
+//-----------------------------------------------------------------------------
+template <class Vertex>
+BOOL LoadMeshCache( const MeshCache& Cache, LoadedMesh<Vertex>* pOut )
+{
+    XMASSERT( pOut );
+
+    pOut->Clear();
+    if( !pOut->Allocate( Cache.GetVertexCount(), Cache.GetIndexCount() ) )
+        return FALSE;
+
+    CopyImportedVertices( Cache.GetVertices(), Cache.GetVertexCount(), pOut->pVertices );
+    if( Cache.GetIndexCount() )
+        memcpy( pOut->pIndices, Cache.GetIndices(), Cache.GetIndexCount() * sizeof( UINT ) );
+
+    Cache.GetSubsets( &pOut->Subsets );
+    Cache.GetMaterials( &pOut->Materials );
+    pOut->HasNormals = Cache.HasNormals();
+    pOut->HasTexCoords = Cache.HasTexCoords();
+    return TRUE;
+}
+
+
+
+template <class Vertex>
+BOOL LoadSceneRead( const aiScene* pScene, UINT ThreadCount, VOID* pContext )
+{
+    return LoadScene( pScene, static_cast<LoadedMesh<Vertex>*>( pContext ), ThreadCount );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Reads FileName as GetMeshFileSource says; PostProcessFlags and pTimings
+// only apply to Assimp, as for ImportSceneFromFile. Returns FALSE if the file
+// cannot be read or converted.
+//-----------------------------------------------------------------------------
+template <class Vertex>
+BOOL LoadMeshFromFile( const char* FileName, UINT PostProcessFlags, LoadedMesh<Vertex>* pOut, UINT ThreadCount = 0,
+                       SceneImportTimings* pTimings = NULL, MappedIOSystem* pIOSystem = NULL )
+{
+    XMASSERT( FileName );
+    XMASSERT( pOut );
+
+    const AssetArchive* pArchive;
+    MeshFileSource Source = GetMeshFileSource( FileName, pIOSystem, &pArchive );
+
+    BOOL Loaded;
+    if( Source == MeshFileObjArchive )
+    {
+        ImportedMesh Mesh;
+        Loaded = LoadObjArchiveEntry( *pArchive, FileName, &Mesh, ThreadCount ) && LoadImportedMesh( Mesh, pOut );
+    }
+    else if( Source == MeshFileObjCache )
+    {
+        MeshCache Cache;
+        Loaded = LoadObjFileCached( FileName, &Cache, ThreadCount ) && LoadMeshCache( Cache, pOut );
+    }
+    else
+    {
+        Loaded = ReadSceneFile( FileName, PostProcessFlags, &LoadSceneRead<Vertex>, pOut, ThreadCount, pTimings,
+                                pIOSystem );
+    }
+
+    if( !Loaded )
+        pOut->Clear();
+    return Loaded;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// The same into an ImportedMesh. With pCache, a loose OBJ stays in its mesh
+// cache: *pCache is left open and pOut only gets the subsets, materials and
+// flags, the vertices and indices are read in place from the mapping (for
+// instance to create the buffers with). Without it, or for any other source,
+// everything goes into pOut and *pCache is closed. With pNormalOptions, a
+// mesh read without normals gets them through FillMissingNormals; the mesh
+// cache keeps it that way, so the next runs still read it in place.
+//
+// This overload and GetMeshFileSource use MappedIOSystem and are defined in
+// SceneImporter.cpp, with ImportSceneFromFile: this header only needs the
+// Assimp types, not the library.
+//-----------------------------------------------------------------------------
+BOOL LoadMeshFromFile( const char* FileName, UINT PostProcessFlags, ImportedMesh* pOut, MeshCache* pCache,
+                       UINT ThreadCount = 0, SceneImportTimings* pTimings = NULL, MappedIOSystem* pIOSystem = NULL,
+                       const MeshMissingNormalOptions* pNormalOptions = NULL );
+
+}; // namespace
+
+#endif
@@ -0,0 +1,313 @@
+//-------------------------------------------------------------------------------------
+// MeshTangents.cpp
+//
+// MikkTSpace compatible tangents. The vector helpers are scalar and do the
+// operations in the order of mikktspace.c, so the results round the same
+// way.
+//-------------------------------------------------------------------------------------
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include "MeshTangents.h"
+#include "ParallelFor.h"
+
+namespace XNA
+{
+
+static const UINT MinTrianglesPerTask = 8 * 1024;
+static const UINT MinVerticesPerTask = 8 * 1024;
+
+// Corner flags.
+static const BYTE CornerPreservesOrientation = 1;   // Positive area in texture space.
+static const BYTE CornerHasDirection = 2;           // The triangle has a tangent direction.
+
+//-----------------------------------------------------------------------------
+// Scalar float3 helpers, as the SVec3 functions of mikktspace.c.
+//-----------------------------------------------------------------------------
+static inline XMFLOAT3 Add3( const XMFLOAT3& a, const XMFLOAT3& b )
+{
+    return XMFLOAT3( a.x + b.x, a.y + b.y, a.z + b.z );
+}
+
+static inline XMFLOAT3 Sub3( const XMFLOAT3& a, const XMFLOAT3& b )
+{
+    return XMFLOAT3( a.x - b.x, a.y - b.y, a.z - b.z );
+}
+
+static inline XMFLOAT3 Scale3( FLOAT s, const XMFLOAT3& a )
+{
+    return XMFLOAT3( s * a.x, s * a.y, s * a.z );
+}
+
+static inline FLOAT Dot3( const XMFLOAT3& a, const XMFLOAT3& b )
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline BOOL NotZero( FLOAT f )
+{
+    return fabsf( f ) > FLT_MIN;
+}
+
+static inline BOOL NotZero3( const XMFLOAT3& a )
+{
+    return NotZero( a.x ) || NotZero( a.y ) || NotZero( a.z );
+}
+
+static inline XMFLOAT3 Normalize3( const XMFLOAT3& a )
+{
+    return Scale3( 1.0f / sqrtf( Dot3( a, a ) ), a );
+}
+
+// a without its component along the unit vector n, normalized if not zero.
+static inline XMFLOAT3 ProjectNormalize3( const XMFLOAT3& a, const XMFLOAT3& n )
+{
+    XMFLOAT3 p = Sub3( a, Scale3( Dot3( n, a ), n ) );
+    return NotZero3( p ) ? Normalize3( p ) : p;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Any unit vector perpendicular to n, for vertices without a direction.
+//-----------------------------------------------------------------------------
+static XMFLOAT3 GetPerpendicular( const XMFLOAT3& n )
+{
+    XMFLOAT3 Axis = fabsf( n.x ) < 0.9f ? XMFLOAT3( 1.0f, 0.0f, 0.0f ) : XMFLOAT3( 0.0f, 1.0f, 0.0f );
+    XMFLOAT3 p = ProjectNormalize3( Axis, n );
+    return NotZero3( p ) ? p : XMFLOAT3( 1.0f, 0.0f, 0.0f );
+}
+
+
+
+static inline const XMFLOAT3& GetFloat3( const BYTE* pBase, UINT Stride, UINT Index )
+{
+    return *reinterpret_cast<const XMFLOAT3*>( pBase + ( size_t )Stride * Index );
+}
+
+static inline const XMFLOAT2& GetFloat2( const BYTE* pBase, UINT Stride, UINT Index )
+{
+    return *reinterpret_cast<const XMFLOAT2*>( pBase + ( size_t )Stride * Index );
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT GenerateTangents( const MeshTangentInput& Input, UINT* pOutIndices, std::vector<XMFLOAT4>* pTangents,
+                       std::vector<UINT>* pSplitSources, UINT ThreadCount )
+{
+    XMASSERT( pTangents );
+    XMASSERT( pSplitSources );
+    XMASSERT( Input.IndexCount == 0 || ( Input.pIndices && pOutIndices ) );
+
+    UINT VertexCount = Input.VertexCount;
+    UINT TriangleCount = Input.IndexCount / 3;
+    UINT CornerCount = TriangleCount * 3;
+    const UINT* pIndices = Input.pIndices;
+
+    // Per corner: the direction of the triangle projected onto the plane of
+    // the corner normal, times the angle at the corner, and the flags of the
+    // triangle.
+    std::vector<XMFLOAT3> Weighted( CornerCount );
+    std::vector<BYTE> Flags( CornerCount, 0 );
+    ParallelFor( TriangleCount, ThreadCount, MinTrianglesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT t = Begin; t < End; t++ )
+        {
+            const UINT* pCorner = pIndices + 3 * t;
+            if( pCorner[0] >= VertexCount || pCorner[1] >= VertexCount || pCorner[2] >= VertexCount )
+            {
+                for( UINT k = 0; k < 3; k++ )
+                    Weighted[3 * t + k] = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+                continue;
+            }
+
+            XMFLOAT3 P[3];
+            XMFLOAT2 T[3];
+            for( UINT k = 0; k < 3; k++ )
+            {
+                P[k] = GetFloat3( Input.pPositions, Input.Stride, pCorner[k] );
+                T[k] = GetFloat2( Input.pTexCoords, Input.Stride, pCorner[k] );
+            }
+
+            // InitTriInfo: the first order derivative of the position along u.
+            FLOAT t21x = T[1].x - T[0].x;
+            FLOAT t21y = T[1].y - T[0].y;
+            FLOAT t31x = T[2].x - T[0].x;
+            FLOAT t31y = T[2].y - T[0].y;
+            XMFLOAT3 d1 = Sub3( P[1], P[0] );
+            XMFLOAT3 d2 = Sub3( P[2], P[0] );
+            FLOAT SignedAreaSTx2 = t21x * t31y - t21y * t31x;
+            XMFLOAT3 Os = Sub3( Scale3( t31y, d1 ), Scale3( t21y, d2 ) );
+            XMFLOAT3 Ot = Add3( Scale3( -t31x, d1 ), Scale3( t21x, d2 ) );
+
+            BYTE Flag = SignedAreaSTx2 > 0.0f ? CornerPreservesOrientation : 0;
+            if( NotZero( SignedAreaSTx2 ) )
+            {
+                FLOAT LengthOs = sqrtf( Dot3( Os, Os ) );
+                FLOAT LengthOt = sqrtf( Dot3( Ot, Ot ) );
+                FLOAT Sign = ( Flag & CornerPreservesOrientation ) ? 1.0f : -1.0f;
+                if( NotZero( LengthOs ) )
+                    Os = Scale3( Sign / LengthOs, Os );
+                if( NotZero( LengthOs ) && NotZero( LengthOt ) )
+                    Flag |= CornerHasDirection;
+            }
+
+            // EvalTspace: the contribution of the triangle at each corner.
+            for( UINT k = 0; k < 3; k++ )
+            {
+                UINT c = 3 * t + k;
+                Flags[c] = Flag;
+                if( !( Flag & CornerHasDirection ) )
+                {
+                    Weighted[c] = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+                    continue;
+                }
+
+                const XMFLOAT3& n = GetFloat3( Input.pNormals, Input.Stride, pCorner[k] );
+                XMFLOAT3 Direction = ProjectNormalize3( Os, n );
+
+                XMFLOAT3 v1 = ProjectNormalize3( Sub3( P[( k + 2 ) % 3], P[k] ), n );
+                XMFLOAT3 v2 = ProjectNormalize3( Sub3( P[( k + 1 ) % 3], P[k] ), n );
+                FLOAT Cos = Dot3( v1, v2 );
+                Cos = Cos > 1.0f ? 1.0f : ( Cos < -1.0f ? -1.0f : Cos );
+                Weighted[c] = Scale3( acosf( Cos ), Direction );
+            }
+        }
+    } );
+
+    // The corners of every vertex, in index order.
+    std::vector<UINT> First( VertexCount + 1, 0 );
+    for( UINT c = 0; c < CornerCount; c++ )
+    {
+        if( pIndices[c] < VertexCount )
+            First[pIndices[c] + 1]++;
+    }
+    for( UINT v = 0; v < VertexCount; v++ )
+        First[v + 1] += First[v];
+
+    std::vector<UINT> Corners( First[VertexCount] );
+    {
+        std::vector<UINT> Next( First.begin(), First.end() - 1 );
+        for( UINT c = 0; c < CornerCount; c++ )
+        {
+            if( pIndices[c] < VertexCount )
+                Corners[Next[pIndices[c]]++] = c;
+        }
+    }
+
+    // Per vertex: the sum of each orientation. The vertex keeps the
+    // preserving one if its triangles have it, and a vertex with both is
+    // split; triangles without a direction go with the vertex.
+    std::vector<XMFLOAT4> Tangents( VertexCount );
+    std::vector<XMFLOAT4> Mirrored( VertexCount );
+    std::vector<BYTE> Split( VertexCount, 0 );
+    ParallelFor( VertexCount, ThreadCount, MinVerticesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT v = Begin; v < End; v++ )
+        {
+            XMFLOAT3 Sum[2] = { XMFLOAT3( 0.0f, 0.0f, 0.0f ), XMFLOAT3( 0.0f, 0.0f, 0.0f ) };
+            BOOL Used[2] = { FALSE, FALSE };
+            for( UINT i = First[v]; i < First[v + 1]; i++ )
+            {
+                UINT c = Corners[i];
+                if( !( Flags[c] & CornerHasDirection ) )
+                    continue;
+
+                UINT o = ( Flags[c] & CornerPreservesOrientation ) ? 0 : 1;
+                Sum[o] = Add3( Sum[o], Weighted[c] );
+                Used[o] = TRUE;
+            }
+
+            const XMFLOAT3& n = GetFloat3( Input.pNormals, Input.Stride, v );
+            for( UINT o = 0; o < 2; o++ )
+                Sum[o] = NotZero3( Sum[o] ) ? Normalize3( Sum[o] ) : GetPerpendicular( n );
+
+            UINT Kept = Used[0] || !Used[1] ? 0 : 1;
+            Tangents[v] = XMFLOAT4( Sum[Kept].x, Sum[Kept].y, Sum[Kept].z, Kept == 0 ? 1.0f : -1.0f );
+            Mirrored[v] = XMFLOAT4( Sum[1].x, Sum[1].y, Sum[1].z, -1.0f );
+            Split[v] = Used[0] && Used[1];
+        }
+    } );
+
+    // The mirrored halves of the split vertices are appended in vertex order.
+    pSplitSources->clear();
+    std::vector<UINT> SplitIndex( VertexCount, 0 );
+    for( UINT v = 0; v < VertexCount; v++ )
+    {
+        if( Split[v] )
+        {
+            SplitIndex[v] = VertexCount + ( UINT )pSplitSources->size();
+            pSplitSources->push_back( v );
+        }
+    }
+
+    UINT SplitCount = ( UINT )pSplitSources->size();
+    Tangents.resize( VertexCount + SplitCount );
+    for( UINT i = 0; i < SplitCount; i++ )
+        Tangents[VertexCount + i] = Mirrored[( *pSplitSources )[i]];
+
+    ParallelFor( Input.IndexCount, ThreadCount, MinTrianglesPerTask * 3, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT c = Begin; c < End; c++ )
+        {
+            UINT v = pIndices[c];
+            BOOL Mirror = c < CornerCount && v < VertexCount && Split[v] && ( Flags[c] & CornerHasDirection ) &&
+                          !( Flags[c] & CornerPreservesOrientation );
+            pOutIndices[c] = Mirror ? SplitIndex[v] : v;
+        }
+    } );
+
+    pTangents->swap( Tangents );
+    return SplitCount;
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT GenerateImportedTangents( ImportedMesh* pMesh, UINT ThreadCount )
+{
+    XMASSERT( pMesh );
+
+    pMesh->Tangents.clear();
+    if( pMesh->Vertices.empty() )
+        return 0;
+
+    // Absolute indices, as for the other passes over the subsets.
+    std::vector<UINT> Absolute( pMesh->Indices );
+    std::vector<UINT> Base( pMesh->Indices.size(), 0 );
+    for( size_t s = 0; s < pMesh->Subsets.size(); s++ )
+    {
+        const ImportedSubset& Subset = pMesh->Subsets[s];
+        for( UINT i = Subset.FirstIndex; i < Subset.FirstIndex + Subset.IndexCount; i++ )
+        {
+            Absolute[i] += Subset.BaseVertex;
+            Base[i] = Subset.BaseVertex;
+        }
+    }
+
+    const BYTE* pBase = reinterpret_cast<const BYTE*>( &pMesh->Vertices[0] );
+    MeshTangentInput Input;
+    Input.pPositions = pBase + offsetof( ImportedVertex, Position );
+    Input.pNormals = pBase + offsetof( ImportedVertex, Normal );
+    Input.pTexCoords = pBase + offsetof( ImportedVertex, TexCoord );
+    Input.Stride = sizeof( ImportedVertex );
+    Input.VertexCount = ( UINT )pMesh->Vertices.size();
+    Input.pIndices = Absolute.empty() ? NULL : &Absolute[0];
+    Input.IndexCount = ( UINT )Absolute.size();
+
+    std::vector<UINT> Indices( Absolute.size() );
+    std::vector<UINT> Sources;
+    UINT Added = GenerateTangents( Input, Indices.empty() ? NULL : &Indices[0], &pMesh->Tangents, &Sources,
+                                   ThreadCount );
+
+    pMesh->Vertices.reserve( pMesh->Vertices.size() + Added );
+    for( UINT i = 0; i < Added; i++ )
+        pMesh->Vertices.push_back( pMesh->Vertices[Sources[i]] );
+    for( size_t i = 0; i < Indices.size(); i++ )
+        pMesh->Indices[i] = Indices[i] - Base[i];
+    return Added;
+}
+
+}; // namespace
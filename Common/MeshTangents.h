@@ -0,0 +1,111 @@
+//-------------------------------------------------------------------------------------
+// MeshTangents.h
+//
+// Tangent frames for normal mapping, computed as MikkTSpace computes them:
+//
+//   - every triangle gets the direction of increasing u from its positions
+//     and texture coordinates, and an orientation from the sign of its area
+//     in texture space;
+//   - at every corner that direction is projected onto the plane of the
+//     corner normal and weighted by the angle of the triangle at the corner,
+//     with the edges projected onto the same plane;
+//   - the weighted directions of the corners of a vertex are summed per
+//     orientation and normalized. W is the sign of the bitangent:
+//     bitangent = w * cross( normal, tangent ).
+//
+// A vertex used by triangles of both orientations (mirrored texture
+// coordinates) needs two tangents and is split. Triangles without a
+// direction (no area in texture space) take the tangent of their vertex.
+//
+// Vertices are identified by their index, where MikkTSpace compares their
+// attributes: indexed meshes whose equal vertices are merged (the OBJ reader,
+// WeldImportedMesh) give the same groups. MikkTSpace also splits a vertex
+// whose triangles are not connected through edges; this does not.
+//
+// The triangles are processed in parallel; each vertex sums its corners in
+// index order, so the tangents are the same bits for any thread count.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _MESH_TANGENTS_H_
+#define _MESH_TANGENTS_H_
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "ImportedMesh.h"
+
+namespace XNA
+{
+
+//-----------------------------------------------------------------------------
+// Vertex attributes read through a stride, so any vertex struct can be used.
+// The indices are absolute.
+//-----------------------------------------------------------------------------
+struct MeshTangentInput
+{
+    const BYTE* pPositions;     // XMFLOAT3
+    const BYTE* pNormals;       // XMFLOAT3
+    const BYTE* pTexCoords;     // XMFLOAT2
+    UINT Stride;
+    UINT VertexCount;
+    const UINT* pIndices;
+    UINT IndexCount;            // Three per triangle.
+};
+
+//-----------------------------------------------------------------------------
+// Tangents of Input. *pTangents gets one per output vertex: the VertexCount
+// input vertices, then the ones split off, each a copy of the input vertex
+// (*pSplitSources)[i]. pOutIndices gets the IndexCount indices into them.
+// Returns the number of vertices split off.
+//-----------------------------------------------------------------------------
+UINT GenerateTangents( const MeshTangentInput& Input, UINT* pOutIndices, std::vector<XMFLOAT4>* pTangents,
+                       std::vector<UINT>* pSplitSources, UINT ThreadCount = 0 );
+
+//-----------------------------------------------------------------------------
+// Fills pMesh->Tangents, one per vertex, appending the vertices split off.
+// Returns the number of vertices added.
+//-----------------------------------------------------------------------------
+UINT GenerateImportedTangents( ImportedMesh* pMesh, UINT ThreadCount = 0 );
+
+//-----------------------------------------------------------------------------
+// The same for GeometryGenerator::MeshData (or any mesh with a Vertices
+// vector of Position, Normal, TangentU and TexC and an Indices vector). The
+// sign is dropped: TangentU has no w.
+//-----------------------------------------------------------------------------
+template <class MeshData>
+UINT GenerateMeshDataTangents( MeshData* pMesh, UINT ThreadCount = 0 )
+{
+    XMASSERT( pMesh );
+    if( pMesh->Vertices.empty() || pMesh->Indices.empty() )
+        return 0;
+
+    typedef typename std::remove_reference<decltype( pMesh->Vertices[0] )>::type Vertex;
+    const BYTE* pBase = reinterpret_cast<const BYTE*>( &pMesh->Vertices[0] );
+    MeshTangentInput Input;
+    Input.pPositions = pBase + offsetof( Vertex, Position );
+    Input.pNormals = pBase + offsetof( Vertex, Normal );
+    Input.pTexCoords = pBase + offsetof( Vertex, TexC );
+    Input.Stride = sizeof( Vertex );
+    Input.VertexCount = ( UINT )pMesh->Vertices.size();
+    Input.pIndices = &pMesh->Indices[0];
+    Input.IndexCount = ( UINT )pMesh->Indices.size();
+
+    std::vector<UINT> Indices( Input.IndexCount );
+    std::vector<XMFLOAT4> Tangents;
+    std::vector<UINT> Sources;
+    UINT Added = GenerateTangents( Input, &Indices[0], &Tangents, &Sources, ThreadCount );
+
+    pMesh->Vertices.reserve( Tangents.size() );
+    for( UINT i = 0; i < Added; i++ )
+        pMesh->Vertices.push_back( pMesh->Vertices[Sources[i]] );
+    for( size_t v = 0; v < Tangents.size(); v++ )
+        pMesh->Vertices[v].TangentU = XMFLOAT3( Tangents[v].x, Tangents[v].y, Tangents[v].z );
+    pMesh->Indices.swap( Indices );
+    return Added;
+}
+
+}; // namespace
+
+#endif
@@ -0,0 +1,498 @@
+//-------------------------------------------------------------------------------------
+// MeshWeld.cpp
+//
+// Vertex welding and smooth normals of imported meshes.
+//-------------------------------------------------------------------------------------
+
+#include <cmath>
+#include <cstring>
+#include "MeshWeld.h"
+#include "ParallelFor.h"
+
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define MESH_WELD_SSE2
+#endif
+
+namespace XNA
+{
+
+static const UINT EmptyEntry = 0xffffffff;
+static const UINT MinVerticesPerTask = 16 * 1024;
+static const UINT MinPositionsPerTask = 4 * 1024;
+
+// Cells further than this from the origin are clamped, so the conversion to
+// integers cannot overflow.
+static const FLOAT MaxCell = 1073741824.0f;
+
+static_assert( sizeof( ImportedVertex ) == 8 * sizeof( FLOAT ), "the vertices are quantized as two float4" );
+
+//-----------------------------------------------------------------------------
+// The cells of the position, normal and texture coordinate of a vertex, in
+// the order of the floats of ImportedVertex.
+//-----------------------------------------------------------------------------
+struct WeldKey
+{
+    INT Cell[8];
+};
+
+struct WeldEntry
+{
+    UINT Hash;
+    UINT Vertex;
+};
+
+static inline UINT HashWeldKey( const WeldKey& Key )
+{
+    UINT Hash = 0;
+    for( UINT i = 0; i < 8; i++ )
+    {
+        Hash = ( Hash ^ ( UINT )Key.Cell[i] ) * 0x9E3779B1u;
+        Hash ^= Hash >> 15;
+    }
+    return Hash;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Scale of each float of ImportedVertex onto its grid, 0 for the attributes
+// left out.
+//-----------------------------------------------------------------------------
+static VOID GetWeldScale( FLOAT PositionEpsilon, FLOAT NormalEpsilon, FLOAT TexCoordEpsilon, FLOAT* pScale )
+{
+    FLOAT Position = 1.0f / PositionEpsilon;
+    FLOAT Normal = NormalEpsilon > 0.0f ? 1.0f / NormalEpsilon : 0.0f;
+    FLOAT TexCoord = TexCoordEpsilon > 0.0f ? 1.0f / TexCoordEpsilon : 0.0f;
+    FLOAT Scale[8] = { Position, Position, Position, Normal, Normal, Normal, TexCoord, TexCoord };
+    memcpy( pScale, Scale, sizeof( Scale ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Keys and hashes of the vertices [Begin, End). Cells are rounded to the
+// nearest integer; NaN goes to the last cell.
+//-----------------------------------------------------------------------------
+static VOID QuantizeVertices( const ImportedVertex* pVertices, UINT Begin, UINT End, const FLOAT* pScale,
+                              WeldKey* pKeys, UINT* pHashes )
+{
+    UINT i = Begin;
+
+#if defined( MESH_WELD_SSE2 )
+    __m128 Scale0 = _mm_loadu_ps( pScale );
+    __m128 Scale1 = _mm_loadu_ps( pScale + 4 );
+    __m128 Max = _mm_set1_ps( MaxCell );
+    __m128 Min = _mm_set1_ps( -MaxCell );
+
+    for( ; i < End; i++ )
+    {
+        const FLOAT* pFloats = &pVertices[i].Position.x;
+        __m128 A = _mm_mul_ps( _mm_loadu_ps( pFloats ), Scale0 );
+        __m128 B = _mm_mul_ps( _mm_loadu_ps( pFloats + 4 ), Scale1 );
+
+        // _mm_min_ps returns its second operand for NaN.
+        A = _mm_max_ps( _mm_min_ps( A, Max ), Min );
+        B = _mm_max_ps( _mm_min_ps( B, Max ), Min );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pKeys[i].Cell ), _mm_cvtps_epi32( A ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pKeys[i].Cell + 4 ), _mm_cvtps_epi32( B ) );
+        pHashes[i] = HashWeldKey( pKeys[i] );
+    }
+#endif
+
+    for( ; i < End; i++ )
+    {
+        const FLOAT* pFloats = &pVertices[i].Position.x;
+        for( UINT k = 0; k < 8; k++ )
+        {
+            FLOAT Value = pFloats[k] * pScale[k];
+            Value = Value < MaxCell ? Value : MaxCell;
+            Value = Value > -MaxCell ? Value : -MaxCell;
+            pKeys[i].Cell[k] = ( INT )std::nearbyint( Value );
+        }
+        pHashes[i] = HashWeldKey( pKeys[i] );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// pRepresentatives[v] is the first vertex with the key of v. Task t inserts
+// the vertices whose hash falls into part t of the table, in order, so the
+// first vertex of a key is the same for any thread count.
+//-----------------------------------------------------------------------------
+static VOID FindWeldRepresentatives( const ImportedVertex* pVertices, UINT Count, const FLOAT* pScale,
+                                     UINT ThreadCount, UINT* pRepresentatives )
+{
+    std::vector<WeldKey> Keys( Count );
+    std::vector<UINT> Hashes( Count );
+    ParallelFor( Count, ThreadCount, MinVerticesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        QuantizeVertices( pVertices, Begin, End, pScale, &Keys[0], &Hashes[0] );
+    } );
+
+    // The slots hold the hash next to the vertex, so that probing past other
+    // keys does not read their vertex.
+    UINT PartCount = GetParallelTaskCount( Count, ThreadCount, MinVerticesPerTask );
+    ParallelFor( PartCount, PartCount, 1, [&]( UINT Begin, UINT End, UINT )
+    {
+        std::vector<WeldEntry> Table;
+        for( UINT Part = Begin; Part < End; Part++ )
+        {
+            UINT Members = 0;
+            for( UINT v = 0; v < Count; v++ )
+            {
+                if( ( UINT )( ( ( UINT64 )Hashes[v] * PartCount ) >> 32 ) == Part )
+                    Members++;
+            }
+
+            size_t Capacity = 16;
+            while( Capacity < ( size_t )Members * 2 )
+                Capacity *= 2;
+            size_t Mask = Capacity - 1;
+            WeldEntry Empty = { 0, EmptyEntry };
+            Table.assign( Capacity, Empty );
+
+            for( UINT v = 0; v < Count; v++ )
+            {
+                UINT Hash = Hashes[v];
+                if( ( UINT )( ( ( UINT64 )Hash * PartCount ) >> 32 ) != Part )
+                    continue;
+
+                size_t Slot = Hash & Mask;
+                while( Table[Slot].Vertex != EmptyEntry &&
+                       ( Table[Slot].Hash != Hash || memcmp( &Keys[Table[Slot].Vertex], &Keys[v], sizeof( WeldKey ) ) != 0 ) )
+                {
+                    Slot = ( Slot + 1 ) & Mask;
+                }
+
+                if( Table[Slot].Vertex == EmptyEntry )
+                {
+                    Table[Slot].Hash = Hash;
+                    Table[Slot].Vertex = v;
+                }
+                pRepresentatives[v] = Table[Slot].Vertex;
+            }
+        }
+    } );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Calls Func( FirstIndex, IndexCount, BaseVertex ) for every range of the
+// indices, the whole index buffer with base 0 if there are no subsets.
+//-----------------------------------------------------------------------------
+template <typename Function>
+static VOID ForEachIndexRange( const ImportedMesh& Mesh, Function Func )
+{
+    if( Mesh.Subsets.empty() )
+    {
+        Func( 0u, ( UINT )Mesh.Indices.size(), 0u );
+        return;
+    }
+
+    for( size_t s = 0; s < Mesh.Subsets.size(); s++ )
+        Func( Mesh.Subsets[s].FirstIndex, Mesh.Subsets[s].IndexCount, Mesh.Subsets[s].BaseVertex );
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT WeldImportedMesh( ImportedMesh* pMesh, const MeshWeldOptions& Options, UINT ThreadCount )
+{
+    XMASSERT( pMesh );
+    XMASSERT( Options.PositionEpsilon > 0.0f );
+
+    // The tangents are those of the vertices before.
+    pMesh->Tangents.clear();
+
+    UINT Count = ( UINT )pMesh->Vertices.size();
+    if( Count == 0 )
+        return 0;
+
+    FLOAT Scale[8];
+    GetWeldScale( Options.PositionEpsilon, pMesh->HasNormals ? Options.NormalEpsilon : 0.0f,
+                  pMesh->HasTexCoords ? Options.TexCoordEpsilon : 0.0f, Scale );
+
+    std::vector<UINT> Remap( Count );
+    FindWeldRepresentatives( &pMesh->Vertices[0], Count, Scale, ThreadCount, &Remap[0] );
+
+    // The vertices kept are compacted in order: count them per block, then
+    // copy them, then point every merged vertex at the copy of the one it
+    // merged with.
+    UINT TaskCount = GetParallelTaskCount( Count, ThreadCount, MinVerticesPerTask );
+    std::vector<UINT> TaskFirst( TaskCount + 1, 0 );
+    ParallelFor( Count, ThreadCount, MinVerticesPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        UINT Kept = 0;
+        for( UINT v = Begin; v < End; v++ )
+            Kept += Remap[v] == v;
+        TaskFirst[Task + 1] = Kept;
+    } );
+    for( UINT t = 0; t < TaskCount; t++ )
+        TaskFirst[t + 1] += TaskFirst[t];
+
+    UINT KeptCount = TaskFirst[TaskCount];
+    std::vector<ImportedVertex> Vertices( KeptCount );
+    std::vector<UINT> NewIndex( Count );
+    ParallelFor( Count, ThreadCount, MinVerticesPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        UINT Next = TaskFirst[Task];
+        for( UINT v = Begin; v < End; v++ )
+        {
+            if( Remap[v] == v )
+            {
+                Vertices[Next] = pMesh->Vertices[v];
+                NewIndex[v] = Next++;
+            }
+        }
+    } );
+    ParallelFor( Count, ThreadCount, MinVerticesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT v = Begin; v < End; v++ )
+            Remap[v] = NewIndex[Remap[v]];
+    } );
+
+    UINT* pIndices = pMesh->Indices.empty() ? NULL : &pMesh->Indices[0];
+    ForEachIndexRange( *pMesh, [&]( UINT FirstIndex, UINT IndexCount, UINT BaseVertex )
+    {
+        ParallelFor( IndexCount, ThreadCount, MinVerticesPerTask, [&]( UINT Begin, UINT End, UINT )
+        {
+            for( UINT i = FirstIndex + Begin; i < FirstIndex + End; i++ )
+                pIndices[i] = Remap[BaseVertex + pIndices[i]];
+        } );
+    } );
+
+    for( size_t s = 0; s < pMesh->Subsets.size(); s++ )
+        pMesh->Subsets[s].BaseVertex = 0;
+
+    pMesh->Vertices.swap( Vertices );
+    return Count - KeptCount;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Normal of a corner: the weighted face normals around its position whose
+// angle to its own face is within the crease. Zero if they sum to zero.
+//-----------------------------------------------------------------------------
+static inline XMVECTOR SumCornerNormal( UINT Corner, const UINT* pGroup, UINT GroupSize, const XMFLOAT3* pFaceNormals,
+                                        const FLOAT* pWeights, FLOAT CosCrease )
+{
+    XMVECTOR Face = XMLoadFloat3( &pFaceNormals[Corner / 3] );
+    XMVECTOR Sum = XMVectorZero();
+    for( UINT k = 0; k < GroupSize; k++ )
+    {
+        XMVECTOR Other = XMLoadFloat3( &pFaceNormals[pGroup[k] / 3] );
+        if( XMVectorGetX( XMVector3Dot( Face, Other ) ) >= CosCrease )
+            Sum += Other * pWeights[pGroup[k]];
+    }
+
+    XMVECTOR LengthSq = XMVector3LengthSq( Sum );
+    return XMVectorGetX( LengthSq ) > 0.0f ? Sum / XMVectorSqrt( LengthSq ) : XMVectorZero();
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT GenerateSmoothNormals( ImportedMesh* pMesh, const MeshNormalOptions& Options, UINT ThreadCount )
+{
+    XMASSERT( pMesh );
+    XMASSERT( Options.PositionEpsilon > 0.0f );
+
+    UINT Count = ( UINT )pMesh->Vertices.size();
+    UINT CornerCount = ( UINT )pMesh->Indices.size();
+    pMesh->HasNormals = TRUE;
+    pMesh->Tangents.clear();
+    if( Count == 0 || CornerCount == 0 )
+        return 0;
+
+    // Absolute vertex of every corner. Triangles are three consecutive corners.
+    std::vector<UINT> CornerVertex( CornerCount, EmptyEntry );
+    const UINT* pIndices = &pMesh->Indices[0];
+    ForEachIndexRange( *pMesh, [&]( UINT FirstIndex, UINT IndexCount, UINT BaseVertex )
+    {
+        ParallelFor( IndexCount, ThreadCount, MinVerticesPerTask, [&]( UINT Begin, UINT End, UINT )
+        {
+            for( UINT i = FirstIndex + Begin; i < FirstIndex + End; i++ )
+                CornerVertex[i] = BaseVertex + pIndices[i];
+        } );
+    } );
+
+    // Unit face normals, and the weight of each face at each of its corners.
+    const ImportedVertex* pVertices = &pMesh->Vertices[0];
+    UINT TriangleCount = CornerCount / 3;
+    std::vector<XMFLOAT3> FaceNormals( TriangleCount );
+    std::vector<FLOAT> Weights( CornerCount, 0.0f );
+    ParallelFor( TriangleCount, ThreadCount, MinVerticesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT t = Begin; t < End; t++ )
+        {
+            const UINT* pCorner = &CornerVertex[3 * t];
+            if( pCorner[0] >= Count || pCorner[1] >= Count || pCorner[2] >= Count )
+            {
+                FaceNormals[t] = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+                continue;
+            }
+
+            XMVECTOR P[3];
+            for( UINT k = 0; k < 3; k++ )
+                P[k] = XMLoadFloat3( &pVertices[pCorner[k]].Position );
+
+            XMVECTOR Cross = XMVector3Cross( P[1] - P[0], P[2] - P[0] );
+            FLOAT DoubleArea = XMVectorGetX( XMVector3Length( Cross ) );
+            if( !( DoubleArea > 0.0f ) )
+            {
+                FaceNormals[t] = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+                continue;
+            }
+            XMStoreFloat3( &FaceNormals[t], Cross / XMVectorReplicate( DoubleArea ) );
+
+            for( UINT k = 0; k < 3; k++ )
+            {
+                if( Options.Weighting == MeshNormalsByArea )
+                {
+                    Weights[3 * t + k] = DoubleArea;
+                    continue;
+                }
+
+                XMVECTOR E1 = XMVector3Normalize( P[( k + 1 ) % 3] - P[k] );
+                XMVECTOR E2 = XMVector3Normalize( P[( k + 2 ) % 3] - P[k] );
+                FLOAT Cos = XMVectorGetX( XMVector3Dot( E1, E2 ) );
+                Cos = Cos < -1.0f ? -1.0f : ( Cos > 1.0f ? 1.0f : Cos );
+                Weights[3 * t + k] = std::acos( Cos );
+            }
+        }
+    } );
+
+    // The corners around every position, in corner order: a counting sort on
+    // the first vertex with the position of each corner.
+    std::vector<UINT> Position( Count );
+    {
+        FLOAT Scale[8];
+        GetWeldScale( Options.PositionEpsilon, 0.0f, 0.0f, Scale );
+        FindWeldRepresentatives( pVertices, Count, Scale, ThreadCount, &Position[0] );
+    }
+
+    std::vector<UINT> GroupFirst( Count + 1, 0 );
+    for( UINT c = 0; c < TriangleCount * 3; c++ )
+    {
+        if( CornerVertex[c] < Count )
+            GroupFirst[Position[CornerVertex[c]] + 1]++;
+    }
+    for( UINT v = 0; v < Count; v++ )
+        GroupFirst[v + 1] += GroupFirst[v];
+
+    std::vector<UINT> GroupCorners( GroupFirst[Count] );
+    {
+        std::vector<UINT> Next( GroupFirst.begin(), GroupFirst.end() - 1 );
+        for( UINT c = 0; c < TriangleCount * 3; c++ )
+        {
+            if( CornerVertex[c] < Count )
+                GroupCorners[Next[Position[CornerVertex[c]]]++] = c;
+        }
+    }
+
+    // Per position: the normal of each corner, and the slot of the corner in
+    // its vertex, 0 for the first normal of the vertex and one more for each
+    // other normal. All the corners of a vertex are in the group of its
+    // position, so the slot counts of a vertex are only touched by one task.
+    FLOAT CosCrease = Options.CreaseAngle >= XM_PI ? -2.0f : std::cos( Options.CreaseAngle );
+    std::vector<XMFLOAT3> CornerNormals( CornerCount );
+    std::vector<UINT> CornerSlot( CornerCount, 0 );
+    std::vector<BYTE> CornerCreates( CornerCount, 0 );
+    std::vector<UINT> SlotCount( Count, 0 );
+    ParallelFor( Count, ThreadCount, MinPositionsPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT g = Begin; g < End; g++ )
+        {
+            const UINT* pGroup = GroupCorners.empty() ? NULL : &GroupCorners[0] + GroupFirst[g];
+            UINT GroupSize = GroupFirst[g + 1] - GroupFirst[g];
+
+            for( UINT k = 0; k < GroupSize; k++ )
+            {
+                UINT c = pGroup[k];
+                XMStoreFloat3( &CornerNormals[c], SumCornerNormal( c, pGroup, GroupSize, &FaceNormals[0], &Weights[0],
+                                                                   CosCrease ) );
+
+                UINT Vertex = CornerVertex[c];
+                UINT Same = k;
+                for( UINT j = 0; j < k && Same == k; j++ )
+                {
+                    UINT Other = pGroup[j];
+                    if( CornerVertex[Other] == Vertex &&
+                        memcmp( &CornerNormals[Other], &CornerNormals[c], sizeof( XMFLOAT3 ) ) == 0 )
+                    {
+                        Same = j;
+                    }
+                }
+
+                if( Same < k )
+                {
+                    CornerSlot[c] = CornerSlot[pGroup[Same]];
+                }
+                else
+                {
+                    CornerSlot[c] = SlotCount[Vertex]++;
+                    CornerCreates[c] = 1;
+                }
+            }
+        }
+    } );
+
+    // The vertices split off are appended in vertex order.
+    std::vector<UINT> FirstAdded( Count );
+    UINT AddedCount = 0;
+    for( UINT v = 0; v < Count; v++ )
+    {
+        FirstAdded[v] = Count + AddedCount;
+        AddedCount += SlotCount[v] > 1 ? SlotCount[v] - 1 : 0;
+    }
+
+    pMesh->Vertices.resize( Count + AddedCount );
+    ImportedVertex* pOut = &pMesh->Vertices[0];
+    UINT* pOutIndices = &pMesh->Indices[0];
+    ParallelFor( CornerCount, ThreadCount, MinVerticesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT c = Begin; c < End; c++ )
+        {
+            UINT Vertex = CornerVertex[c];
+            if( Vertex >= Count || c >= TriangleCount * 3 )
+                continue;
+
+            UINT Target = CornerSlot[c] == 0 ? Vertex : FirstAdded[Vertex] + CornerSlot[c] - 1;
+            if( CornerCreates[c] )
+            {
+                // Only the members other tasks do not write: the first slot
+                // of the vertex writes its normal meanwhile.
+                if( Target != Vertex )
+                {
+                    pOut[Target].Position = pOut[Vertex].Position;
+                    pOut[Target].TexCoord = pOut[Vertex].TexCoord;
+                }
+                pOut[Target].Normal = CornerNormals[c];
+            }
+            pOutIndices[c] += Target - Vertex;
+        }
+    } );
+
+    return AddedCount;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL FillMissingNormals( ImportedMesh* pMesh, const MeshMissingNormalOptions& Options, UINT ThreadCount )
+{
+    XMASSERT( pMesh );
+
+    if( pMesh->HasNormals )
+        return FALSE;
+
+    WeldImportedMesh( pMesh, Options.Weld, ThreadCount );
+    GenerateSmoothNormals( pMesh, Options.Normals, ThreadCount );
+    return TRUE;
+}
+
+}; // namespace
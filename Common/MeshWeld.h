@@ -0,0 +1,90 @@
+//-------------------------------------------------------------------------------------
+// MeshWeld.h
+//
+// Clean up of imported meshes: merging the vertices a file split (OBJ files
+// written with one vertex per face corner) and smooth normals for the meshes
+// that have none.
+//
+// Welding quantizes the attributes of every vertex onto a grid of their
+// epsilon, four floats at a time with SSE2 where the target has it, and
+// merges the vertices that fall into the same cells through a hash table.
+// The table is split by hash, one part per thread, and each part takes its
+// vertices in order: the first vertex of a cell is kept, and the result does
+// not depend on the thread count. Two vertices closer than the epsilon but on
+// both sides of a cell border stay apart.
+//
+// Smooth normals are summed over the faces around each position (not each
+// vertex, so texture seams get the same normal on both sides), weighted by
+// the area or by the angle of the face at the corner. Faces whose normal is
+// further than the crease angle from the face of a corner are left out of
+// the sum of that corner; a vertex whose corners end up with different
+// normals is split. The positions are processed in parallel.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _MESH_WELD_H_
+#define _MESH_WELD_H_
+
+#include "ImportedMesh.h"
+
+namespace XNA
+{
+
+// Cell sizes of the attributes compared by WeldImportedMesh. An epsilon of
+// 0 or less leaves the attribute out of the comparison (the vertex kept
+// decides it); so does a mesh without normals or texture coordinates.
+struct MeshWeldOptions
+{
+    FLOAT PositionEpsilon;
+    FLOAT NormalEpsilon;
+    FLOAT TexCoordEpsilon;
+
+    MeshWeldOptions() : PositionEpsilon( 1e-5f ), NormalEpsilon( 1e-3f ), TexCoordEpsilon( 1e-5f ) {}
+};
+
+enum MeshNormalWeighting
+{
+    MeshNormalsByArea,      // Larger faces count more.
+    MeshNormalsByAngle,     // Faces count by their angle at the vertex: independent of the tessellation.
+};
+
+struct MeshNormalOptions
+{
+    FLOAT CreaseAngle;              // Radians; XM_PI smooths every edge.
+    MeshNormalWeighting Weighting;
+    FLOAT PositionEpsilon;          // Corners in the same cell of this size share their faces.
+
+    MeshNormalOptions() : CreaseAngle( XM_PI ), Weighting( MeshNormalsByAngle ), PositionEpsilon( 1e-5f ) {}
+};
+
+// Merges the vertices whose attributes fall into the same cells and remaps
+// the indices. The subsets keep their indices but get BaseVertex 0: the
+// indices become absolute. Tangents are cleared. Returns the number of
+// vertices removed.
+// ThreadCount 0 uses every hardware thread.
+UINT WeldImportedMesh( ImportedMesh* pMesh, const MeshWeldOptions& Options, UINT ThreadCount = 0 );
+
+// Replaces the normals of every vertex the indices reference with smooth
+// normals and sets HasNormals. Vertices split at creases are appended;
+// tangents are cleared.
+// Returns the number of vertices added. The result does not depend on the
+// thread count.
+UINT GenerateSmoothNormals( ImportedMesh* pMesh, const MeshNormalOptions& Options, UINT ThreadCount = 0 );
+
+// What a loader does to a mesh read without normals: weld it, then smooth
+// the normals over the welded faces. The mesh cache keeps the result, keyed
+// by these options.
+struct MeshMissingNormalOptions
+{
+    MeshWeldOptions Weld;
+    MeshNormalOptions Normals;
+};
+
+// Welds pMesh and generates its normals as Options say if it has none.
+// Returns FALSE, and leaves the mesh alone, if it already has normals.
+BOOL FillMissingNormals( ImportedMesh* pMesh, const MeshMissingNormalOptions& Options, UINT ThreadCount = 0 );
+
+}; // namespace
+
+#endif
@@ -0,0 +1,953 @@
+//-------------------------------------------------------------------------------------
+// ObjLoader.cpp
+//
+// Parallel chunked OBJ parsing, v/vt/vn tuple merging and MTL parsing.
+//-------------------------------------------------------------------------------------
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include "ObjLoader.h"
+#include "AssetArchive.h"
+#include "MappedFile.h"
+#include "ParallelFor.h"
+
+namespace XNA
+{
+
+// Smallest chunk worth a thread of its own.
+static const size_t MinChunkSize = 256 * 1024;
+
+// Attribute a face corner does not give.
+static const INT NoIndex = -1;
+
+static const UINT NoMaterial = 0xffffffff;
+static const UINT EmptyEntry = 0xffffffff;
+
+// The powers of ten a double holds exactly.
+static const DOUBLE PowersOf10[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const INT MaxExactPower = 22;
+
+
+
+//-----------------------------------------------------------------------------
+// Parsed content of one chunk of the file. Corner indices are 0 based and
+// absolute, except those listed in RelativeCorners (negative in the file),
+// which count from the first element of the chunk until they are resolved.
+//-----------------------------------------------------------------------------
+struct ObjCorner
+{
+    INT Index[3];               // Position, texture coordinate and normal.
+};
+
+struct ObjMaterialSwitch
+{
+    UINT Face;                  // First face of the chunk drawn with the material.
+    UINT Material;              // Index in the mesh, once resolved.
+    std::string Name;
+};
+
+struct ObjChunk
+{
+    const char* pBegin;
+    const char* pEnd;
+    std::vector<XMFLOAT3> Positions;
+    std::vector<XMFLOAT2> TexCoords;
+    std::vector<XMFLOAT3> Normals;
+    std::vector<ObjCorner> Corners;
+    std::vector<UINT> FaceSizes;            // Corners of every face.
+    std::vector<UINT> RelativeCorners;      // 3 * corner + attribute.
+    std::vector<ObjMaterialSwitch> Materials;
+    std::vector<std::string> Libraries;
+    BOOL Valid;
+};
+
+struct ObjTupleEntry
+{
+    INT Index[3];
+    UINT Vertex;                // EmptyEntry for a free slot.
+};
+
+
+
+//-----------------------------------------------------------------------------
+// Tokens.
+//-----------------------------------------------------------------------------
+static inline BOOL IsDigit( char c )
+{
+    return ( UINT )( c - '0' ) < 10;
+}
+
+
+
+static inline const char* SkipSpaces( const char* p, const char* pEnd )
+{
+    while( p < pEnd && ( *p == ' ' || *p == '\t' ) )
+        p++;
+    return p;
+}
+
+
+
+static inline const char* SkipToken( const char* p, const char* pEnd )
+{
+    while( p < pEnd && *p != ' ' && *p != '\t' )
+        p++;
+    return p;
+}
+
+
+
+static inline BOOL IsKeyword( const char* pKey, size_t Length, const char* Keyword )
+{
+    return strlen( Keyword ) == Length && memcmp( pKey, Keyword, Length ) == 0;
+}
+
+
+
+// The rest of the line without surrounding blanks.
+static std::string GetRestOfLine( const char* p, const char* pEnd )
+{
+    p = SkipSpaces( p, pEnd );
+    while( pEnd > p && ( pEnd[-1] == ' ' || pEnd[-1] == '\t' ) )
+        pEnd--;
+    return std::string( p, pEnd );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Decimal number in the C locale, with optional exponent. Up to 19
+// significant digits are gathered in an integer and scaled by an exact power
+// of ten, which rounds correctly in double precision for the numbers
+// exporters write; longer exponents fall back to pow.
+//-----------------------------------------------------------------------------
+static BOOL ParseFloat( const char*& p, const char* pEnd, FLOAT* pValue )
+{
+    p = SkipSpaces( p, pEnd );
+
+    BOOL Negative = FALSE;
+    if( p < pEnd && ( *p == '-' || *p == '+' ) )
+    {
+        Negative = ( *p == '-' );
+        p++;
+    }
+
+    UINT64 Mantissa = 0;
+    UINT Digits = 0;
+    INT Exponent = 0;
+    BOOL Any = FALSE;
+
+    for( ; p < pEnd && IsDigit( *p ); p++ )
+    {
+        Any = TRUE;
+        if( Digits < 19 )
+        {
+            Mantissa = Mantissa * 10 + ( *p - '0' );
+            Digits += ( Mantissa != 0 );
+        }
+        else
+        {
+            Exponent++;
+        }
+    }
+
+    if( p < pEnd && *p == '.' )
+    {
+        for( p++; p < pEnd && IsDigit( *p ); p++ )
+        {
+            Any = TRUE;
+            if( Digits < 19 )
+            {
+                Mantissa = Mantissa * 10 + ( *p - '0' );
+                Digits += ( Mantissa != 0 );
+                Exponent--;
+            }
+        }
+    }
+
+    if( !Any )
+        return FALSE;
+
+    if( p < pEnd && ( *p == 'e' || *p == 'E' ) )
+    {
+        const char* q = p + 1;
+        BOOL NegativeExponent = FALSE;
+        if( q < pEnd && ( *q == '-' || *q == '+' ) )
+        {
+            NegativeExponent = ( *q == '-' );
+            q++;
+        }
+
+        if( q < pEnd && IsDigit( *q ) )
+        {
+            INT Value = 0;
+            for( ; q < pEnd && IsDigit( *q ); q++ )
+            {
+                if( Value < 100000 )
+                    Value = Value * 10 + ( *q - '0' );
+            }
+            Exponent += NegativeExponent ? -Value : Value;
+            p = q;
+        }
+    }
+
+    DOUBLE Value = ( DOUBLE )Mantissa;
+    if( Mantissa != 0 && Exponent != 0 )
+    {
+        if( Exponent < 0 && Exponent >= -MaxExactPower )
+            Value /= PowersOf10[-Exponent];
+        else if( Exponent > 0 && Exponent <= MaxExactPower )
+            Value *= PowersOf10[Exponent];
+        else
+            Value *= pow( 10.0, Exponent );
+    }
+
+    *pValue = ( FLOAT )( Negative ? -Value : Value );
+    return TRUE;
+}
+
+
+
+// Reads Count numbers, of which the ones after the first Required may be
+// missing (as in "vt u") and are then 0.
+static BOOL ParseFloats( const char* p, const char* pEnd, FLOAT* pValues, UINT Count, UINT Required )
+{
+    for( UINT i = 0; i < Count; i++ )
+    {
+        if( i >= Required && SkipSpaces( p, pEnd ) == pEnd )
+        {
+            pValues[i] = 0.0f;
+            continue;
+        }
+
+        if( !ParseFloat( p, pEnd, &pValues[i] ) )
+            return FALSE;
+    }
+    return TRUE;
+}
+
+
+
+// OBJ element index: 1 based, or negative to count back from the last one.
+static inline BOOL ParseIndex( const char*& p, const char* pEnd, INT* pValue )
+{
+    BOOL Negative = FALSE;
+    if( p < pEnd && *p == '-' )
+    {
+        Negative = TRUE;
+        p++;
+    }
+
+    if( p >= pEnd || !IsDigit( *p ) )
+        return FALSE;
+
+    UINT64 Value = 0;
+    for( ; p < pEnd && IsDigit( *p ); p++ )
+    {
+        Value = Value * 10 + ( *p - '0' );
+        if( Value > INT_MAX )
+            return FALSE;
+    }
+
+    if( Value == 0 )
+        return FALSE;
+
+    *pValue = Negative ? -( INT )Value : ( INT )Value;
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// OBJ statements.
+//-----------------------------------------------------------------------------
+static BOOL ParseFace( const char* p, const char* pEnd, ObjChunk* pChunk )
+{
+    size_t FirstCorner = pChunk->Corners.size();
+    size_t FirstRelative = pChunk->RelativeCorners.size();
+
+    size_t Counts[3] = { pChunk->Positions.size(), pChunk->TexCoords.size(), pChunk->Normals.size() };
+
+    for( ;; )
+    {
+        p = SkipSpaces( p, pEnd );
+        if( p == pEnd )
+            break;
+
+        INT Index[3] = { 0, 0, 0 };
+        if( !ParseIndex( p, pEnd, &Index[0] ) )
+            return FALSE;
+
+        if( p < pEnd && *p == '/' )
+        {
+            p++;
+            if( p < pEnd && *p != '/' && !ParseIndex( p, pEnd, &Index[1] ) )
+                return FALSE;
+
+            if( p < pEnd && *p == '/' )
+            {
+                p++;
+                if( !ParseIndex( p, pEnd, &Index[2] ) )
+                    return FALSE;
+            }
+        }
+
+        if( p < pEnd && *p != ' ' && *p != '\t' )
+            return FALSE;
+
+        ObjCorner Corner;
+        size_t CornerIndex = pChunk->Corners.size();
+        for( UINT a = 0; a < 3; a++ )
+        {
+            if( Index[a] > 0 )
+            {
+                Corner.Index[a] = Index[a] - 1;
+            }
+            else if( Index[a] < 0 )
+            {
+                Corner.Index[a] = ( INT )Counts[a] + Index[a];
+                pChunk->RelativeCorners.push_back( ( UINT )( 3 * CornerIndex + a ) );
+            }
+            else
+            {
+                Corner.Index[a] = NoIndex;
+            }
+        }
+        pChunk->Corners.push_back( Corner );
+    }
+
+    UINT Count = ( UINT )( pChunk->Corners.size() - FirstCorner );
+    if( Count < 3 )
+    {
+        // Not a polygon: drop it.
+        pChunk->Corners.resize( FirstCorner );
+        pChunk->RelativeCorners.resize( FirstRelative );
+        return TRUE;
+    }
+
+    pChunk->FaceSizes.push_back( Count );
+    return TRUE;
+}
+
+
+
+static BOOL ParseObjLine( const char* p, const char* pEnd, ObjChunk* pChunk )
+{
+    p = SkipSpaces( p, pEnd );
+    if( p == pEnd || *p == '#' )
+        return TRUE;
+
+    const char* pKey = p;
+    p = SkipToken( p, pEnd );
+    size_t KeyLength = p - pKey;
+
+    if( pKey[0] == 'v' )
+    {
+        FLOAT Values[3];
+        if( KeyLength == 1 )
+        {
+            if( !ParseFloats( p, pEnd, Values, 3, 3 ) )
+                return FALSE;
+            pChunk->Positions.push_back( XMFLOAT3( Values[0], Values[1], Values[2] ) );
+        }
+        else if( KeyLength == 2 && pKey[1] == 't' )
+        {
+            if( !ParseFloats( p, pEnd, Values, 2, 1 ) )
+                return FALSE;
+            pChunk->TexCoords.push_back( XMFLOAT2( Values[0], Values[1] ) );
+        }
+        else if( KeyLength == 2 && pKey[1] == 'n' )
+        {
+            if( !ParseFloats( p, pEnd, Values, 3, 3 ) )
+                return FALSE;
+            pChunk->Normals.push_back( XMFLOAT3( Values[0], Values[1], Values[2] ) );
+        }
+        return TRUE;
+    }
+
+    if( KeyLength == 1 && pKey[0] == 'f' )
+        return ParseFace( p, pEnd, pChunk );
+
+    if( IsKeyword( pKey, KeyLength, "usemtl" ) )
+    {
+        ObjMaterialSwitch Switch;
+        Switch.Face = ( UINT )pChunk->FaceSizes.size();
+        Switch.Material = NoMaterial;
+        Switch.Name = GetRestOfLine( p, pEnd );
+        pChunk->Materials.push_back( Switch );
+        return TRUE;
+    }
+
+    if( IsKeyword( pKey, KeyLength, "mtllib" ) )
+    {
+        for( ;; )
+        {
+            p = SkipSpaces( p, pEnd );
+            if( p == pEnd )
+                break;
+            const char* pName = p;
+            p = SkipToken( p, pEnd );
+            pChunk->Libraries.push_back( std::string( pName, p ) );
+        }
+        return TRUE;
+    }
+
+    // Groups, objects, smoothing groups and everything else.
+    return TRUE;
+}
+
+
+
+static VOID ParseObjChunk( ObjChunk* pChunk )
+{
+    const char* p = pChunk->pBegin;
+    const char* pEnd = pChunk->pEnd;
+
+    while( p < pEnd )
+    {
+        const char* pLineEnd = ( const char* )memchr( p, '\n', pEnd - p );
+        const char* pNext = pLineEnd ? pLineEnd + 1 : pEnd;
+        if( !pLineEnd )
+            pLineEnd = pEnd;
+        if( pLineEnd > p && pLineEnd[-1] == '\r' )
+            pLineEnd--;
+
+        if( !ParseObjLine( p, pLineEnd, pChunk ) )
+        {
+            pChunk->Valid = FALSE;
+            return;
+        }
+
+        p = pNext;
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Open addressing table from v/vt/vn tuples to output vertices.
+//-----------------------------------------------------------------------------
+static inline UINT HashTuple( const INT* pIndex )
+{
+    UINT Hash = ( UINT )pIndex[0] * 0x9E3779B1u;
+    Hash ^= ( UINT )pIndex[1] * 0x85EBCA77u;
+    Hash ^= ( UINT )pIndex[2] * 0xC2B2AE3Du;
+    return Hash ^ ( Hash >> 15 );
+}
+
+
+
+static VOID ResizeTupleTable( std::vector<ObjTupleEntry>& Table, size_t Capacity )
+{
+    std::vector<ObjTupleEntry> Old;
+    Old.swap( Table );
+
+    ObjTupleEntry Empty;
+    Empty.Index[0] = Empty.Index[1] = Empty.Index[2] = NoIndex;
+    Empty.Vertex = EmptyEntry;
+    Table.assign( Capacity, Empty );
+
+    size_t Mask = Capacity - 1;
+    for( size_t i = 0; i < Old.size(); i++ )
+    {
+        if( Old[i].Vertex == EmptyEntry )
+            continue;
+
+        size_t Slot = HashTuple( Old[i].Index ) & Mask;
+        while( Table[Slot].Vertex != EmptyEntry )
+            Slot = ( Slot + 1 ) & Mask;
+        Table[Slot] = Old[i];
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Material index by name, added to the mesh on first use.
+//-----------------------------------------------------------------------------
+static UINT FindMaterial( const std::string& Name, std::map<std::string, UINT>& Names, ImportedMesh* pOut )
+{
+    std::map<std::string, UINT>::iterator it = Names.find( Name );
+    if( it != Names.end() )
+        return it->second;
+
+    UINT Material = ( UINT )pOut->Materials.size();
+    pOut->Materials.resize( Material + 1 );
+    InitializeImportedMaterial( &pOut->Materials.back(), Name );
+    Names[Name] = Material;
+    return Material;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// ParseObj, leaving a partial mesh on failure.
+//-----------------------------------------------------------------------------
+static BOOL ParseObjText( const char* pText, size_t Size, ImportedMesh* pOut,
+                          std::vector<std::string>* pMaterialLibraries, UINT ThreadCount )
+{
+
+    // One chunk per task, each ending after a line break.
+    UINT ChunkCount = GetParallelTaskCount( ( UINT )( std::min )( Size / MinChunkSize, ( size_t )UINT_MAX ), ThreadCount );
+
+    std::vector<ObjChunk> Chunks( ChunkCount );
+    const char* pEnd = pText + Size;
+    for( UINT c = 0; c < ChunkCount; c++ )
+    {
+        ObjChunk& Chunk = Chunks[c];
+        Chunk.pBegin = c ? Chunks[c - 1].pEnd : pText;
+        Chunk.Valid = TRUE;
+
+        if( c + 1 == ChunkCount )
+        {
+            Chunk.pEnd = pEnd;
+            continue;
+        }
+
+        const char* pSplit = ( std::max )( pText + ( size_t )( ( UINT64 )Size * ( c + 1 ) / ChunkCount ), Chunk.pBegin );
+        const char* pLineEnd = ( const char* )memchr( pSplit, '\n', pEnd - pSplit );
+        Chunk.pEnd = pLineEnd ? pLineEnd + 1 : pEnd;
+    }
+
+    ParallelFor( ChunkCount, ThreadCount, 1, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT c = Begin; c < End; c++ )
+            ParseObjChunk( &Chunks[c] );
+    } );
+
+    // Where the elements of every chunk start, and the resolved relative
+    // indices.
+    size_t Totals[3] = { 0, 0, 0 };
+    UINT64 IndexCount = 0;
+    for( UINT c = 0; c < ChunkCount; c++ )
+    {
+        ObjChunk& Chunk = Chunks[c];
+        if( !Chunk.Valid )
+            return FALSE;
+
+        for( size_t i = 0; i < Chunk.RelativeCorners.size(); i++ )
+        {
+            UINT a = Chunk.RelativeCorners[i] % 3;
+            INT& Index = Chunk.Corners[Chunk.RelativeCorners[i] / 3].Index[a];
+            Index += ( INT )Totals[a];
+            if( Index < 0 )
+                return FALSE;
+        }
+
+        Totals[0] += Chunk.Positions.size();
+        Totals[1] += Chunk.TexCoords.size();
+        Totals[2] += Chunk.Normals.size();
+        if( Totals[0] > INT_MAX || Totals[1] > INT_MAX || Totals[2] > INT_MAX )
+            return FALSE;
+
+        IndexCount += 3 * ( Chunk.Corners.size() - 2 * Chunk.FaceSizes.size() );
+
+        if( pMaterialLibraries )
+            pMaterialLibraries->insert( pMaterialLibraries->end(), Chunk.Libraries.begin(), Chunk.Libraries.end() );
+    }
+
+    if( IndexCount > UINT_MAX )
+        return FALSE;
+
+    std::vector<XMFLOAT3> Positions;
+    std::vector<XMFLOAT2> TexCoords;
+    std::vector<XMFLOAT3> Normals;
+    Positions.reserve( Totals[0] );
+    TexCoords.reserve( Totals[1] );
+    Normals.reserve( Totals[2] );
+    for( UINT c = 0; c < ChunkCount; c++ )
+    {
+        ObjChunk& Chunk = Chunks[c];
+        Positions.insert( Positions.end(), Chunk.Positions.begin(), Chunk.Positions.end() );
+        TexCoords.insert( TexCoords.end(), Chunk.TexCoords.begin(), Chunk.TexCoords.end() );
+        Normals.insert( Normals.end(), Chunk.Normals.begin(), Chunk.Normals.end() );
+        std::vector<XMFLOAT3>().swap( Chunk.Positions );
+        std::vector<XMFLOAT2>().swap( Chunk.TexCoords );
+        std::vector<XMFLOAT3>().swap( Chunk.Normals );
+    }
+
+    // Materials in order of first use, and their triangle counts, so every
+    // subset gets one range of the index buffer. Faces before the first
+    // usemtl get a default material.
+    std::map<std::string, UINT> MaterialNames;
+    std::vector<UINT> MaterialIndexCounts;
+    UINT Current = NoMaterial;
+    UINT Default = NoMaterial;
+    for( UINT c = 0; c < ChunkCount; c++ )
+    {
+        ObjChunk& Chunk = Chunks[c];
+        size_t Switch = 0;
+        for( UINT f = 0; f <= Chunk.FaceSizes.size(); f++ )
+        {
+            for( ; Switch < Chunk.Materials.size() && Chunk.Materials[Switch].Face == f; Switch++ )
+            {
+                Current = FindMaterial( Chunk.Materials[Switch].Name, MaterialNames, pOut );
+                Chunk.Materials[Switch].Material = Current;
+            }
+
+            if( f == Chunk.FaceSizes.size() )
+                break;
+
+            if( Current == NoMaterial )
+            {
+                Default = FindMaterial( "default", MaterialNames, pOut );
+                Current = Default;
+            }
+
+            MaterialIndexCounts.resize( pOut->Materials.size(), 0 );
+            MaterialIndexCounts[Current] += 3 * ( Chunk.FaceSizes[f] - 2 );
+        }
+    }
+    MaterialIndexCounts.resize( pOut->Materials.size(), 0 );
+
+    std::vector<UINT> MaterialOffsets( pOut->Materials.size() );
+    UINT Offset = 0;
+    for( UINT m = 0; m < pOut->Materials.size(); m++ )
+    {
+        MaterialOffsets[m] = Offset;
+        if( MaterialIndexCounts[m] > 0 )
+        {
+            ImportedSubset Subset;
+            Subset.Material = m;
+            Subset.FirstIndex = Offset;
+            Subset.IndexCount = MaterialIndexCounts[m];
+            Subset.BaseVertex = 0;
+            pOut->Subsets.push_back( Subset );
+        }
+        Offset += MaterialIndexCounts[m];
+    }
+
+    // Merge the corners into vertices and write the triangle fans.
+    size_t Capacity = 64;
+    size_t Expected = ( std::max )( Totals[0], ( std::max )( Totals[1], Totals[2] ) );
+    while( Capacity < 2 * Expected )
+        Capacity *= 2;
+
+    std::vector<ObjTupleEntry> Table;
+    ResizeTupleTable( Table, Capacity );
+    size_t Mask = Capacity - 1;
+
+    pOut->Vertices.reserve( Expected );
+    pOut->Indices.resize( ( size_t )IndexCount );
+
+    BOOL HasNormals = FALSE;
+    BOOL HasTexCoords = FALSE;
+    UINT* pIndices = pOut->Indices.empty() ? NULL : &pOut->Indices[0];
+    Current = Default;
+
+    for( UINT c = 0; c < ChunkCount; c++ )
+    {
+        const ObjChunk& Chunk = Chunks[c];
+        const ObjCorner* pCorner = Chunk.Corners.empty() ? NULL : &Chunk.Corners[0];
+        size_t Switch = 0;
+
+        for( UINT f = 0; f < Chunk.FaceSizes.size(); f++ )
+        {
+            for( ; Switch < Chunk.Materials.size() && Chunk.Materials[Switch].Face == f; Switch++ )
+                Current = Chunk.Materials[Switch].Material;
+
+            UINT* pOutIndex = pIndices + MaterialOffsets[Current];
+            UINT CornerCount = Chunk.FaceSizes[f];
+            UINT First = 0;
+            UINT Previous = 0;
+
+            for( UINT k = 0; k < CornerCount; k++, pCorner++ )
+            {
+                const INT* pIndex = pCorner->Index;
+                if( ( UINT )pIndex[0] >= Totals[0] ||
+                    ( pIndex[1] != NoIndex && ( UINT )pIndex[1] >= Totals[1] ) ||
+                    ( pIndex[2] != NoIndex && ( UINT )pIndex[2] >= Totals[2] ) )
+                    return FALSE;
+
+                size_t Slot = HashTuple( pIndex ) & Mask;
+                for( ;; )
+                {
+                    ObjTupleEntry& Entry = Table[Slot];
+                    if( Entry.Vertex == EmptyEntry )
+                    {
+                        Entry.Index[0] = pIndex[0];
+                        Entry.Index[1] = pIndex[1];
+                        Entry.Index[2] = pIndex[2];
+                        Entry.Vertex = ( UINT )pOut->Vertices.size();
+
+                        ImportedVertex Vertex;
+                        Vertex.Position = Positions[pIndex[0]];
+                        Vertex.TexCoord = XMFLOAT2( 0.0f, 0.0f );
+                        Vertex.Normal = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+                        if( pIndex[1] != NoIndex )
+                        {
+                            Vertex.TexCoord = TexCoords[pIndex[1]];
+                            HasTexCoords = TRUE;
+                        }
+                        if( pIndex[2] != NoIndex )
+                        {
+                            Vertex.Normal = Normals[pIndex[2]];
+                            HasNormals = TRUE;
+                        }
+                        pOut->Vertices.push_back( Vertex );
+                        break;
+                    }
+
+                    if( Entry.Index[0] == pIndex[0] && Entry.Index[1] == pIndex[1] && Entry.Index[2] == pIndex[2] )
+                        break;
+
+                    Slot = ( Slot + 1 ) & Mask;
+                }
+
+                UINT Vertex = Table[Slot].Vertex;
+                if( k == 0 )
+                {
+                    First = Vertex;
+                }
+                else if( k >= 2 )
+                {
+                    pOutIndex[0] = First;
+                    pOutIndex[1] = Previous;
+                    pOutIndex[2] = Vertex;
+                    pOutIndex += 3;
+                }
+                Previous = Vertex;
+
+                // Keep the load factor under one half.
+                if( 2 * pOut->Vertices.size() > Capacity )
+                {
+                    Capacity *= 2;
+                    Mask = Capacity - 1;
+                    ResizeTupleTable( Table, Capacity );
+                }
+            }
+
+            MaterialOffsets[Current] += 3 * ( CornerCount - 2 );
+        }
+    }
+
+    pOut->HasNormals = HasNormals;
+    pOut->HasTexCoords = HasTexCoords;
+    ComputeImportedSubsetBounds( pOut );
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL ParseObj( const char* pText, size_t Size, ImportedMesh* pOut, std::vector<std::string>* pMaterialLibraries,
+               UINT ThreadCount )
+{
+    XMASSERT( pText || Size == 0 );
+    XMASSERT( pOut );
+
+    pOut->Clear();
+    if( ParseObjText( pText, Size, pOut, pMaterialLibraries, ThreadCount ) )
+        return TRUE;
+
+    pOut->Clear();
+    return FALSE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL ParseMtl( const char* pText, size_t Size, ImportedMesh* pMesh )
+{
+    XMASSERT( pText || Size == 0 );
+    XMASSERT( pMesh );
+
+    ImportedMaterial* pMaterial = NULL;
+    const char* p = pText;
+    const char* pEnd = pText + Size;
+
+    while( p < pEnd )
+    {
+        const char* pLineEnd = ( const char* )memchr( p, '\n', pEnd - p );
+        const char* pNext = pLineEnd ? pLineEnd + 1 : pEnd;
+        if( !pLineEnd )
+            pLineEnd = pEnd;
+        if( pLineEnd > p && pLineEnd[-1] == '\r' )
+            pLineEnd--;
+
+        const char* q = SkipSpaces( p, pLineEnd );
+        const char* pKey = q;
+        q = SkipToken( q, pLineEnd );
+        size_t KeyLength = q - pKey;
+        p = pNext;
+
+        if( KeyLength == 0 || *pKey == '#' )
+            continue;
+
+        if( IsKeyword( pKey, KeyLength, "newmtl" ) )
+        {
+            // Materials the mesh does not use are skipped.
+            std::string Name = GetRestOfLine( q, pLineEnd );
+            pMaterial = NULL;
+            for( size_t m = 0; m < pMesh->Materials.size(); m++ )
+            {
+                if( pMesh->Materials[m].Name == Name )
+                    pMaterial = &pMesh->Materials[m];
+            }
+            continue;
+        }
+
+        if( !pMaterial )
+            continue;
+
+        FLOAT Values[3];
+        XMFLOAT3* pColor = NULL;
+        if( IsKeyword( pKey, KeyLength, "Ka" ) )
+            pColor = &pMaterial->Ambient;
+        else if( IsKeyword( pKey, KeyLength, "Kd" ) )
+            pColor = &pMaterial->Diffuse;
+        else if( IsKeyword( pKey, KeyLength, "Ks" ) )
+            pColor = &pMaterial->Specular;
+
+        if( pColor )
+        {
+            // "Kd r" is a grey.
+            if( !ParseFloat( q, pLineEnd, &Values[0] ) )
+                return FALSE;
+            if( SkipSpaces( q, pLineEnd ) == pLineEnd )
+                Values[1] = Values[2] = Values[0];
+            else if( !ParseFloats( q, pLineEnd, &Values[1], 2, 2 ) )
+                return FALSE;
+            *pColor = XMFLOAT3( Values[0], Values[1], Values[2] );
+        }
+        else if( IsKeyword( pKey, KeyLength, "Ns" ) )
+        {
+            if( !ParseFloat( q, pLineEnd, &pMaterial->SpecularPower ) )
+                return FALSE;
+        }
+        else if( IsKeyword( pKey, KeyLength, "d" ) )
+        {
+            if( !ParseFloat( q, pLineEnd, &pMaterial->Opacity ) )
+                return FALSE;
+        }
+        else if( IsKeyword( pKey, KeyLength, "Tr" ) )
+        {
+            if( !ParseFloat( q, pLineEnd, &Values[0] ) )
+                return FALSE;
+            pMaterial->Opacity = 1.0f - Values[0];
+        }
+        else if( IsKeyword( pKey, KeyLength, "map_Kd" ) || IsKeyword( pKey, KeyLength, "map_Bump" ) ||
+                 IsKeyword( pKey, KeyLength, "map_bump" ) || IsKeyword( pKey, KeyLength, "bump" ) ||
+                 IsKeyword( pKey, KeyLength, "norm" ) )
+        {
+            BOOL Diffuse = IsKeyword( pKey, KeyLength, "map_Kd" );
+
+            // The file name is the last token; options such as -bm come first.
+            const char* pName = pLineEnd;
+            while( pName > q && ( pName[-1] == ' ' || pName[-1] == '\t' ) )
+                pName--;
+            const char* pNameEnd = pName;
+            while( pName > q && pName[-1] != ' ' && pName[-1] != '\t' )
+                pName--;
+
+            ( Diffuse ? pMaterial->DiffuseMap : pMaterial->NormalMap ).assign( pName, pNameEnd );
+        }
+    }
+
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL LoadObjFile( const char* FileName, ImportedMesh* pOut, UINT ThreadCount,
+                  std::vector<std::string>* pMaterialLibraries )
+{
+    XMASSERT( FileName );
+    XMASSERT( pOut );
+
+    MappedFile File;
+    if( !File.Open( FileName ) )
+        return FALSE;
+
+    std::vector<std::string> Libraries;
+    if( !ParseObj( ( const char* )File.GetData(), File.GetSize(), pOut, &Libraries, ThreadCount ) )
+        return FALSE;
+    File.Close();
+
+    // Material libraries are relative to the OBJ file.
+    std::string Directory( FileName );
+    size_t Separator = Directory.find_last_of( "/\\" );
+    Directory.resize( Separator == std::string::npos ? 0 : Separator + 1 );
+
+    for( size_t i = 0; i < Libraries.size(); i++ )
+    {
+        MappedFile Library;
+        if( !Library.Open( ( Directory + Libraries[i] ).c_str() ) )
+            continue;
+
+        ParseMtl( ( const char* )Library.GetData(), Library.GetSize(), pOut );
+        if( pMaterialLibraries )
+            pMaterialLibraries->push_back( Libraries[i] );
+    }
+
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// View of an archive entry, extracted into Storage if it is compressed.
+//-----------------------------------------------------------------------------
+static BOOL GetArchiveText( const AssetArchive& Archive, const char* Name, std::vector<BYTE>* pStorage,
+                            const char** ppText, size_t* pSize )
+{
+    UINT Index;
+    if( !Archive.Find( Name, &Index ) )
+        return FALSE;
+
+    const BYTE* pData;
+    if( !Archive.GetView( Index, &pData, pSize ) )
+    {
+        if( !Archive.Extract( Index, pStorage ) )
+            return FALSE;
+        pData = pStorage->empty() ? NULL : &( *pStorage )[0];
+        *pSize = pStorage->size();
+    }
+
+    *ppText = reinterpret_cast<const char*>( pData );
+    return TRUE;
+}
+
+
+
+BOOL LoadObjArchiveEntry( const AssetArchive& Archive, const char* Name, ImportedMesh* pOut, UINT ThreadCount,
+                          std::vector<std::string>* pMaterialLibraries )
+{
+    XMASSERT( Name );
+    XMASSERT( pOut );
+
+    std::vector<BYTE> Storage;
+    const char* pText;
+    size_t Size;
+    if( !GetArchiveText( Archive, Name, &Storage, &pText, &Size ) )
+        return FALSE;
+
+    std::vector<std::string> Libraries;
+    if( !ParseObj( pText, Size, pOut, &Libraries, ThreadCount ) )
+        return FALSE;
+
+    std::string Directory( Name );
+    size_t Separator = Directory.find_last_of( "/\\" );
+    Directory.resize( Separator == std::string::npos ? 0 : Separator + 1 );
+
+    for( size_t i = 0; i < Libraries.size(); i++ )
+    {
+        if( !GetArchiveText( Archive, ( Directory + Libraries[i] ).c_str(), &Storage, &pText, &Size ) )
+            continue;
+
+        ParseMtl( pText, Size, pOut );
+        if( pMaterialLibraries )
+            pMaterialLibraries->push_back( Libraries[i] );
+    }
+
+    return TRUE;
+}
+
+}; // namespace
@@ -0,0 +1,59 @@
+//-------------------------------------------------------------------------------------
+// ObjLoader.h
+//
+// Wavefront OBJ and MTL reader for the meshes the demos import, without
+// going through Assimp.
+//
+// The file is memory mapped and cut into one chunk per thread at line
+// boundaries. Every chunk is parsed on its own into v, vt and vn arrays and a
+// list of face corners, with a locale independent number parser. Negative
+// (relative) indices are resolved once the chunks know where their elements
+// start. A single pass then merges equal v/vt/vn tuples through a hash table,
+// writes the vertices and the triangle fans of the faces straight into the
+// output, and groups the triangles by material.
+//
+// Coordinates, winding and texture coordinates are kept as they are in the
+// file (as Assimp does without aiProcess_FlipUVs or aiProcess_MakeLeftHanded).
+// Line continuations, free form geometry, lines and points are not supported;
+// unknown statements are skipped.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _OBJ_LOADER_H_
+#define _OBJ_LOADER_H_
+
+#include <string>
+#include <vector>
+#include "ImportedMesh.h"
+
+namespace XNA
+{
+
+class AssetArchive;
+
+// Loads an OBJ file and the MTL files it references (relative to the OBJ).
+// Returns FALSE if the file cannot be read or is malformed; missing MTL files
+// leave the materials at their defaults. ThreadCount 0 uses every hardware
+// thread. If pMaterialLibraries is not NULL, the names of the MTL files that
+// were read are appended to it, relative to the OBJ as in the file.
+BOOL LoadObjFile( const char* FileName, ImportedMesh* pOut, UINT ThreadCount = 0,
+                  std::vector<std::string>* pMaterialLibraries = NULL );
+
+// LoadObjFile for an OBJ packed in an asset archive, its MTL files looked up
+// in the same archive. Stored entries are parsed in place in the mapping.
+BOOL LoadObjArchiveEntry( const AssetArchive& Archive, const char* Name, ImportedMesh* pOut, UINT ThreadCount = 0,
+                          std::vector<std::string>* pMaterialLibraries = NULL );
+
+// Parses OBJ text already in memory. The materials of the result only carry
+// their names; the mtllib file names are appended to pMaterialLibraries if it
+// is not NULL.
+BOOL ParseObj( const char* pText, size_t Size, ImportedMesh* pOut, std::vector<std::string>* pMaterialLibraries,
+               UINT ThreadCount = 0 );
+
+// Parses MTL text and fills the materials of pMesh with matching names.
+BOOL ParseMtl( const char* pText, size_t Size, ImportedMesh* pMesh );
+
+}; // namespace
+
+#endif
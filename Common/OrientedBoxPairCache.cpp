@@ -0,0 +1,302 @@
+//-------------------------------------------------------------------------------------
+// OrientedBoxPairCache.cpp
+//
+// Separating axis cache for persistent oriented box pairs.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <utility>
+#include "OrientedBoxPairCache.h"
+
+#if defined( _MSC_VER ) && ( defined( _M_IX86 ) || defined( _M_X64 ) )
+#include <xmmintrin.h>
+#endif
+
+namespace XNA
+{
+
+static const UINT MinCapacity = 64;
+
+// FilterPairs fetches the table slot and the boxes of the pair this far ahead.
+static const UINT PrefetchDistance = 8;
+
+
+
+static inline UINT64 GetPairKey( UINT IdA, UINT IdB )
+{
+    return ( UINT64( ( std::min )( IdA, IdB ) ) << 32 ) | ( std::max )( IdA, IdB );
+}
+
+
+
+static inline UINT HashKey( UINT64 Key, UINT Mask )
+{
+    return UINT( ( Key * 0x9e3779b97f4a7c15ull ) >> 32 ) & Mask;
+}
+
+
+
+static inline VOID Prefetch( const VOID* p )
+{
+#if defined( _MSC_VER ) && ( defined( _M_IX86 ) || defined( _M_X64 ) )
+    _mm_prefetch( static_cast<const char*>( p ), _MM_HINT_T0 );
+#elif defined( __GNUC__ )
+    __builtin_prefetch( p );
+#else
+    ( VOID )p;
+#endif
+}
+
+
+
+//-----------------------------------------------------------------------------
+OrientedBoxPairCache::OrientedBoxPairCache( UINT MaxAge ) :
+    m_MaxAge( MaxAge ? MaxAge : 1 ),
+    m_Frame( 0 ),
+    m_LastSweep( 0 ),
+    m_Count( 0 ),
+    m_Touched( 0 ),
+    m_Tests( 0 ),
+    m_Hits( 0 )
+{
+    Clear();
+}
+
+
+
+OrientedBoxPairCache::~OrientedBoxPairCache()
+{
+}
+
+
+
+VOID OrientedBoxPairCache::Clear()
+{
+    Entry Empty = Entry();
+    Empty.Key = EmptyKey;
+
+    m_Table.assign( MinCapacity, Empty );
+    m_Count = 0;
+    m_Touched = 0;
+}
+
+
+
+UINT OrientedBoxPairCache::GetPairCount() const
+{
+    return m_Count;
+}
+
+
+
+VOID OrientedBoxPairCache::ResetStats()
+{
+    m_Tests = 0;
+    m_Hits = 0;
+}
+
+
+
+UINT64 OrientedBoxPairCache::GetTests() const
+{
+    return m_Tests;
+}
+
+
+
+UINT64 OrientedBoxPairCache::GetHits() const
+{
+    return m_Hits;
+}
+
+
+
+FLOAT OrientedBoxPairCache::GetHitRate() const
+{
+    return m_Tests ? FLOAT( DOUBLE( m_Hits ) / DOUBLE( m_Tests ) ) : 0.0f;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Move the live entries into a table of the given capacity.
+//-----------------------------------------------------------------------------
+VOID OrientedBoxPairCache::Rehash( UINT Capacity )
+{
+    Entry Empty = Entry();
+    Empty.Key = EmptyKey;
+
+    m_Scratch.swap( m_Table );
+    m_Table.assign( Capacity, Empty );
+
+    UINT Mask = Capacity - 1;
+
+    for( size_t i = 0; i < m_Scratch.size(); i++ )
+    {
+        const Entry& E = m_Scratch[i];
+        if( E.Key == EmptyKey )
+            continue;
+
+        UINT Slot = HashKey( E.Key, Mask );
+        while( m_Table[Slot].Key != EmptyKey )
+            Slot = ( Slot + 1 ) & Mask;
+
+        m_Table[Slot] = E;
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Entry of the pair, added with no known axis if it was not there.
+//-----------------------------------------------------------------------------
+OrientedBoxPairCache::Entry* OrientedBoxPairCache::Find( UINT64 Key )
+{
+    if( 4 * ( m_Count + 1 ) > 3 * m_Table.size() )
+        Rehash( UINT( m_Table.size() * 2 ) );
+
+    UINT Mask = UINT( m_Table.size() ) - 1;
+    UINT Slot = HashKey( Key, Mask );
+
+    for( ;; )
+    {
+        Entry& E = m_Table[Slot];
+
+        if( E.Key == Key )
+            return &E;
+
+        if( E.Key == EmptyKey )
+        {
+            E.Key = Key;
+            E.LastFrame = m_Frame - 1;
+            E.Axis = NoAxis;
+            m_Count++;
+            return &E;
+        }
+
+        Slot = ( Slot + 1 ) & Mask;
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL OrientedBoxPairCache::Intersect( UINT IdA, const OrientedBox* pBoxA, UINT IdB, const OrientedBox* pBoxB )
+{
+    XMASSERT( pBoxA );
+    XMASSERT( pBoxB );
+
+    // The axes are numbered relative to the first box, so always test the
+    // pair in the same order.
+    if( IdA > IdB )
+    {
+        std::swap( IdA, IdB );
+        std::swap( pBoxA, pBoxB );
+    }
+
+    Entry* pEntry = Find( GetPairKey( IdA, IdB ) );
+    if( pEntry->LastFrame != m_Frame )
+    {
+        pEntry->LastFrame = m_Frame;
+        m_Touched++;
+    }
+
+    BYTE Axis = pEntry->Axis;
+    BOOL Result = IntersectOrientedBoxOrientedBox( pBoxA, pBoxB, &pEntry->Axis );
+
+    m_Tests++;
+    if( !Result && Axis != NoAxis && pEntry->Axis == Axis )
+        m_Hits++;
+
+    // A pair that intersects has no separating axis to start with next time.
+    if( Result )
+        pEntry->Axis = NoAxis;
+
+    return Result;
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT OrientedBoxPairCache::FilterPairs( const OrientedBox* pBoxes, const ProxyPair* pPairs, UINT Count,
+                                        std::vector<ProxyPair>* pOut )
+{
+    XMASSERT( pBoxes || Count == 0 );
+    XMASSERT( pPairs || Count == 0 );
+    XMASSERT( pOut );
+
+    UINT Kept = 0;
+
+    for( UINT i = 0; i < Count; i++ )
+    {
+        // The table lookups and the boxes are all over memory.
+        if( i + PrefetchDistance < Count )
+        {
+            const ProxyPair& Next = pPairs[i + PrefetchDistance];
+            Prefetch( &m_Table[HashKey( GetPairKey( Next.ProxyA, Next.ProxyB ), UINT( m_Table.size() ) - 1 )] );
+            Prefetch( &pBoxes[Next.ProxyA] );
+            Prefetch( &pBoxes[Next.ProxyB] );
+        }
+
+        const ProxyPair& Pair = pPairs[i];
+
+        if( Intersect( Pair.ProxyA, &pBoxes[Pair.ProxyA], Pair.ProxyB, &pBoxes[Pair.ProxyB] ) )
+        {
+            pOut->push_back( Pair );
+            Kept++;
+        }
+    }
+
+    return Kept;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Linear probing cannot simply clear a slot, so the table is rebuilt from the
+// pairs that are kept. That only happens once the pairs not tested this frame
+// make up a quarter of the table, and at most every MaxAge frames; until then
+// the old pairs stay, which costs nothing but memory.
+//-----------------------------------------------------------------------------
+VOID OrientedBoxPairCache::EndFrame()
+{
+    UINT Stale = m_Count - m_Touched;
+
+    m_Frame++;
+    m_Touched = 0;
+
+    if( 4 * Stale <= m_Count || m_Frame - m_LastSweep < m_MaxAge )
+        return;
+
+    m_LastSweep = m_Frame;
+
+    UINT Kept = 0;
+
+    for( size_t i = 0; i < m_Table.size(); i++ )
+    {
+        Entry& E = m_Table[i];
+        if( E.Key == EmptyKey )
+            continue;
+
+        // Frames since the pair was last tested.
+        if( m_Frame - E.LastFrame > m_MaxAge )
+        {
+            E.Key = EmptyKey;
+            continue;
+        }
+
+        Kept++;
+    }
+
+    if( Kept != m_Count )
+    {
+        UINT Capacity = UINT( m_Table.size() );
+        while( Capacity > MinCapacity && 8 * Kept < Capacity )
+            Capacity /= 2;
+
+        m_Count = Kept;
+        Rehash( Capacity );
+    }
+}
+
+}; // namespace
@@ -0,0 +1,96 @@
+//-------------------------------------------------------------------------------------
+// OrientedBoxPairCache.h
+//
+// Narrowphase cache for oriented box pairs that persist across frames, as the
+// pairs a broadphase reports for resting or slowly moving objects do.
+//
+// The cache remembers, per pair of object ids, the axis that separated the two
+// boxes the last time they were tested. The next test starts with that axis
+// (see the IntersectOrientedBoxOrientedBox overload taking pSeparatingAxis);
+// only when it no longer separates the boxes are the other fourteen axes of
+// the separating axis test run. The result is always the same as
+// IntersectOrientedBoxOrientedBox.
+//
+// The pairs live in an open addressing hash table keyed by the packed ids.
+// Call EndFrame() once per frame: pairs that have not been tested for more
+// than MaxAge frames are dropped (in batches, once there are enough of them),
+// so the table follows the broadphase pairs.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _ORIENTED_BOX_PAIR_CACHE_H_
+#define _ORIENTED_BOX_PAIR_CACHE_H_
+
+#include <vector>
+#include "xnacollision.h"
+#include "DynamicAabbTree.h"
+
+namespace XNA
+{
+
+class OrientedBoxPairCache
+{
+public:
+    // Value of a pair's axis while no separating axis is known.
+    static const BYTE NoAxis = 0xff;
+
+    OrientedBoxPairCache( UINT MaxAge = 4 );
+    ~OrientedBoxPairCache();
+
+    // Same result as IntersectOrientedBoxOrientedBox( pBoxA, pBoxB ); IdA and
+    // IdB identify the pair (in either order).
+    BOOL Intersect( UINT IdA, const OrientedBox* pBoxA, UINT IdB, const OrientedBox* pBoxB );
+
+    // Narrowphase over broadphase pairs indexing pBoxes: append the pairs whose
+    // boxes intersect to pOut. Returns the number of pairs appended.
+    UINT FilterPairs( const OrientedBox* pBoxes, const ProxyPair* pPairs, UINT Count, std::vector<ProxyPair>* pOut );
+
+    // Age the pairs and drop those not tested for more than MaxAge frames.
+    VOID EndFrame();
+
+    VOID Clear();
+    UINT GetPairCount() const;
+
+    // Statistics since the last ResetStats. A hit is a test the cached axis
+    // answered on its own.
+    VOID ResetStats();
+    UINT64 GetTests() const;
+    UINT64 GetHits() const;
+    FLOAT GetHitRate() const;
+
+private:
+    struct Entry
+    {
+        UINT64 Key;             // (lower id << 32) | higher id, EmptyKey when unused.
+        UINT LastFrame;
+        BYTE Axis;
+    };
+
+    static const UINT64 EmptyKey = ~0ull;
+
+    Entry* Find( UINT64 Key );
+    VOID Rehash( UINT Capacity );
+
+    OrientedBoxPairCache( const OrientedBoxPairCache& rhs );
+    OrientedBoxPairCache& operator=( const OrientedBoxPairCache& rhs );
+
+private:
+    UINT m_MaxAge;
+    UINT m_Frame;
+    UINT m_LastSweep;
+
+    // Power of two sized table with linear probing, at most three quarters
+    // full. m_Touched counts the pairs tested in the current frame.
+    std::vector<Entry> m_Table;
+    std::vector<Entry> m_Scratch;
+    UINT m_Count;
+    UINT m_Touched;
+
+    UINT64 m_Tests;
+    UINT64 m_Hits;
+};
+
+}; // namespace
+
+#endif
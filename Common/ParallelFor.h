@@ -0,0 +1,90 @@
+//-------------------------------------------------------------------------------------
+// ParallelFor.h
+//
+// Minimal fork/join helper on top of std::thread. The index range is cut into
+// one contiguous block per task; the calling thread runs the first block and
+// waits for the others. There is no pool: the threads only live for the call,
+// which is fine for the few large batches per frame this is meant for.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _PARALLEL_FOR_H_
+#define _PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace XNA
+{
+
+//-----------------------------------------------------------------------------
+// Number of hardware threads, at least 1.
+//-----------------------------------------------------------------------------
+inline unsigned int GetWorkerThreadCount()
+{
+    unsigned int Count = std::thread::hardware_concurrency();
+    return Count ? Count : 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Number of tasks ParallelFor will use for Count items, so callers can size
+// their per task outputs. ThreadCount 0 means one task per hardware thread.
+// MinPerTask keeps small ranges from being split at all.
+//-----------------------------------------------------------------------------
+inline unsigned int GetParallelTaskCount( unsigned int Count, unsigned int ThreadCount, unsigned int MinPerTask = 1 )
+{
+    if( ThreadCount == 0 )
+        ThreadCount = GetWorkerThreadCount();
+
+    if( MinPerTask == 0 )
+        MinPerTask = 1;
+
+    unsigned int MaxTasks = ( std::max )( Count / MinPerTask, 1u );
+    return ( std::min )( ThreadCount, MaxTasks );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Calls Func( Begin, End, TaskIndex ) for every block of [0, Count). The
+// blocks are in order, task t always gets the t-th block, so results written
+// per task can be concatenated deterministically.
+//-----------------------------------------------------------------------------
+template<typename Function>
+inline void ParallelFor( unsigned int Count, unsigned int ThreadCount, unsigned int MinPerTask, Function Func )
+{
+    if( Count == 0 )
+        return;
+
+    unsigned int TaskCount = GetParallelTaskCount( Count, ThreadCount, MinPerTask );
+
+    if( TaskCount <= 1 )
+    {
+        Func( 0u, Count, 0u );
+        return;
+    }
+
+    std::vector<std::thread> Threads;
+    Threads.reserve( TaskCount - 1 );
+
+    for( unsigned int t = 1; t < TaskCount; t++ )
+    {
+        unsigned int Begin = static_cast<unsigned int>( ( unsigned long long )Count * t / TaskCount );
+        unsigned int End = static_cast<unsigned int>( ( unsigned long long )Count * ( t + 1 ) / TaskCount );
+
+        Threads.push_back( std::thread( [&Func, Begin, End, t]() { Func( Begin, End, t ); } ) );
+    }
+
+    Func( 0u, Count / TaskCount, 0u );
+
+    for( size_t i = 0; i < Threads.size(); i++ )
+        Threads[i].join();
+}
+
+}; // namespace
+
+#endif
@@ -0,0 +1,556 @@
+//-------------------------------------------------------------------------------------
+// SceneImporter.cpp
+//
+// Parallel conversion of Assimp scenes into one merged ImportedMesh, and the
+// parts of MeshLoader.h that need the Assimp library: the choice of reader
+// and the ImportedMesh LoadMeshFromFile.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include "SceneImporter.h"
+#include "MappedIOSystem.h"
+#include "MeshLoader.h"
+#include "ParallelFor.h"
+
+// Assimp
+#include "Importer.hpp"
+#include "ProgressHandler.hpp"
+#include "scene.h"
+#include "postprocess.h"
+
+namespace XNA
+{
+
+typedef std::chrono::high_resolution_clock SceneClock;
+
+struct SceneProcessStep
+{
+    UINT Flag;
+    const char* Name;
+};
+
+// The steps in the order of Assimp's post-processing pipeline, so applying
+// them one at a time gives the scene ReadFile gives with all of them.
+static const SceneProcessStep SceneProcessSteps[] =
+{
+    { aiProcess_ValidateDataStructure, "ValidateDataStructure" },
+    { aiProcess_RemoveComponent, "RemoveComponent" },
+    { aiProcess_RemoveRedundantMaterials, "RemoveRedundantMaterials" },
+    { aiProcess_FindInstances, "FindInstances" },
+    { aiProcess_OptimizeGraph, "OptimizeGraph" },
+    { aiProcess_OptimizeMeshes, "OptimizeMeshes" },
+    { aiProcess_FindDegenerates, "FindDegenerates" },
+    { aiProcess_GenUVCoords, "GenUVCoords" },
+    { aiProcess_TransformUVCoords, "TransformUVCoords" },
+    { aiProcess_PreTransformVertices, "PreTransformVertices" },
+    { aiProcess_Triangulate, "Triangulate" },
+    { aiProcess_SortByPType, "SortByPType" },
+    { aiProcess_FindInvalidData, "FindInvalidData" },
+    { aiProcess_FixInfacingNormals, "FixInfacingNormals" },
+    { aiProcess_SplitByBoneCount, "SplitByBoneCount" },
+    { aiProcess_SplitLargeMeshes, "SplitLargeMeshes" },
+    { aiProcess_GenNormals, "GenNormals" },
+    { aiProcess_GenSmoothNormals, "GenSmoothNormals" },
+    { aiProcess_CalcTangentSpace, "CalcTangentSpace" },
+    { aiProcess_JoinIdenticalVertices, "JoinIdenticalVertices" },
+    { aiProcess_MakeLeftHanded, "MakeLeftHanded" },
+    { aiProcess_FlipUVs, "FlipUVs" },
+    { aiProcess_FlipWindingOrder, "FlipWindingOrder" },
+    { aiProcess_LimitBoneWeights, "LimitBoneWeights" },
+    { aiProcess_ImproveCacheLocality, "ImproveCacheLocality" },
+    { aiProcess_Debone, "Debone" },
+};
+
+
+
+//-----------------------------------------------------------------------------
+// Notes when Assimp starts and ends reading the file and running the
+// post-processing steps.
+//-----------------------------------------------------------------------------
+class SceneStageTimer : public Assimp::ProgressHandler
+{
+public:
+    SceneStageTimer() { Reset(); }
+
+    VOID Reset()
+    {
+        m_ReadDone = FALSE;
+        m_ProcessStarted = FALSE;
+        m_ProcessDone = FALSE;
+    }
+
+    virtual bool Update( float Percentage )
+    {
+        return true;
+    }
+
+    virtual void UpdateFileRead( int CurrentStep, int StepCount )
+    {
+        if( CurrentStep >= StepCount )
+        {
+            m_ReadEnd = SceneClock::now();
+            m_ReadDone = TRUE;
+        }
+    }
+
+    virtual void UpdatePostProcess( int CurrentStep, int StepCount )
+    {
+        if( !m_ProcessStarted )
+        {
+            m_ProcessStart = SceneClock::now();
+            m_ProcessStarted = TRUE;
+        }
+        if( CurrentStep >= StepCount )
+        {
+            m_ProcessEnd = SceneClock::now();
+            m_ProcessDone = TRUE;
+        }
+    }
+
+    BOOL m_ReadDone;
+    BOOL m_ProcessStarted;
+    BOOL m_ProcessDone;
+    SceneClock::time_point m_ReadEnd;
+    SceneClock::time_point m_ProcessStart;
+    SceneClock::time_point m_ProcessEnd;
+};
+
+
+
+static DOUBLE GetMilliseconds( SceneClock::time_point Start, SceneClock::time_point End )
+{
+    return std::chrono::duration<DOUBLE, std::milli>( End - Start ).count();
+}
+
+
+
+static VOID AddSceneStage( SceneImportTimings* pTimings, const char* Name, UINT Flag, DOUBLE Milliseconds )
+{
+    SceneImportStage Stage;
+    Stage.Name = Name;
+    Stage.Flag = Flag;
+    Stage.Milliseconds = Milliseconds;
+    pTimings->Stages.push_back( Stage );
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT GetScenePostProcessFlags( SceneImportProfile Profile )
+{
+    switch( Profile )
+    {
+    case SceneImportFast:
+        return aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenNormals | aiProcess_SortByPType;
+
+    case SceneImportQuality:
+        return aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals |
+               aiProcess_SortByPType | aiProcess_ImproveCacheLocality | aiProcess_OptimizeMeshes |
+               aiProcess_RemoveRedundantMaterials | aiProcess_FindDegenerates | aiProcess_FindInvalidData;
+
+    default:
+        return aiProcess_Triangulate;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Number of indices the triangles and fans of a mesh take. Meshes of
+// triangles only (all of them after aiProcess_Triangulate) are not scanned.
+//-----------------------------------------------------------------------------
+static UINT64 CountSceneMeshIndices( const aiMesh* pMesh )
+{
+    if( pMesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE )
+        return ( UINT64 )pMesh->mNumFaces * 3;
+
+    UINT64 Count = 0;
+    for( UINT f = 0; f < pMesh->mNumFaces; f++ )
+    {
+        if( pMesh->mFaces[f].mNumIndices >= 3 )
+            Count += 3 * ( pMesh->mFaces[f].mNumIndices - 2 );
+    }
+    return Count;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Writes the indices of one mesh into its range of the shared index array.
+// The indices stay relative to the mesh.
+//-----------------------------------------------------------------------------
+static BOOL ConvertSceneFaces( const aiMesh* pMesh, UINT* pIndices )
+{
+    for( UINT f = 0; f < pMesh->mNumFaces; f++ )
+    {
+        const aiFace& Face = pMesh->mFaces[f];
+        if( Face.mNumIndices < 3 )
+            continue;
+
+        for( UINT k = 0; k < Face.mNumIndices; k++ )
+        {
+            if( Face.mIndices[k] >= pMesh->mNumVertices )
+                return FALSE;
+        }
+
+        for( UINT k = 2; k < Face.mNumIndices; k++ )
+        {
+            pIndices[0] = Face.mIndices[0];
+            pIndices[1] = Face.mIndices[k - 1];
+            pIndices[2] = Face.mIndices[k];
+            pIndices += 3;
+        }
+    }
+
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+static VOID ConvertSceneMaterial( const aiMaterial* pMaterial, ImportedMaterial* pOut )
+{
+    aiString Name;
+    pMaterial->Get( AI_MATKEY_NAME, Name );
+    InitializeImportedMaterial( pOut, Name.C_Str() );
+
+    aiColor3D Color;
+    if( pMaterial->Get( AI_MATKEY_COLOR_AMBIENT, Color ) == AI_SUCCESS )
+        pOut->Ambient = XMFLOAT3( Color.r, Color.g, Color.b );
+    if( pMaterial->Get( AI_MATKEY_COLOR_DIFFUSE, Color ) == AI_SUCCESS )
+        pOut->Diffuse = XMFLOAT3( Color.r, Color.g, Color.b );
+    if( pMaterial->Get( AI_MATKEY_COLOR_SPECULAR, Color ) == AI_SUCCESS )
+        pOut->Specular = XMFLOAT3( Color.r, Color.g, Color.b );
+
+    pMaterial->Get( AI_MATKEY_SHININESS, pOut->SpecularPower );
+    pMaterial->Get( AI_MATKEY_OPACITY, pOut->Opacity );
+
+    aiString Path;
+    if( pMaterial->GetTexture( aiTextureType_DIFFUSE, 0, &Path ) == AI_SUCCESS )
+        pOut->DiffuseMap = Path.C_Str();
+
+    // The OBJ importer reads map_bump as a height map.
+    if( pMaterial->GetTexture( aiTextureType_NORMALS, 0, &Path ) == AI_SUCCESS ||
+        pMaterial->GetTexture( aiTextureType_HEIGHT, 0, &Path ) == AI_SUCCESS )
+        pOut->NormalMap = Path.C_Str();
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL PrepareSceneMeshes( const aiScene* pScene, std::vector<ImportedSubset>* pSubsets,
+                         std::vector<ImportedMaterial>* pMaterials, BOOL* pHasNormals, BOOL* pHasTexCoords,
+                         UINT* pVertexCount, UINT* pIndexCount )
+{
+    XMASSERT( pScene );
+    XMASSERT( pSubsets && pMaterials && pHasNormals && pHasTexCoords && pVertexCount && pIndexCount );
+
+    UINT MeshCount = pScene->mNumMeshes;
+    *pHasNormals = FALSE;
+    *pHasTexCoords = FALSE;
+
+    // Ranges of every mesh in the shared arrays.
+    pSubsets->resize( MeshCount );
+    UINT64 VertexCount = 0;
+    UINT64 IndexCount = 0;
+    for( UINT m = 0; m < MeshCount; m++ )
+    {
+        const aiMesh* pMesh = pScene->mMeshes[m];
+        UINT64 MeshIndexCount = CountSceneMeshIndices( pMesh );
+
+        ImportedSubset& Subset = ( *pSubsets )[m];
+        Subset.Material = pMesh->mMaterialIndex;
+        Subset.FirstIndex = ( UINT )IndexCount;
+        Subset.IndexCount = ( UINT )MeshIndexCount;
+        Subset.BaseVertex = ( UINT )VertexCount;
+
+        if( pMesh->HasNormals() )
+            *pHasNormals = TRUE;
+        if( pMesh->HasTextureCoords( 0 ) )
+            *pHasTexCoords = TRUE;
+
+        VertexCount += pMesh->mNumVertices;
+        IndexCount += MeshIndexCount;
+        if( VertexCount > UINT_MAX || IndexCount > UINT_MAX )
+            return FALSE;
+    }
+
+    pMaterials->resize( ( std::max )( pScene->mNumMaterials, 1u ) );
+    InitializeImportedMaterial( &( *pMaterials )[0], "default" );
+    for( UINT i = 0; i < pScene->mNumMaterials; i++ )
+        ConvertSceneMaterial( pScene->mMaterials[i], &( *pMaterials )[i] );
+
+    for( UINT m = 0; m < MeshCount; m++ )
+    {
+        if( ( *pSubsets )[m].Material >= pMaterials->size() )
+            return FALSE;
+    }
+
+    *pVertexCount = ( UINT )VertexCount;
+    *pIndexCount = ( UINT )IndexCount;
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL ConvertSceneMeshes( const aiScene* pScene, SceneVertexConverter pConvert, UINT VertexSize, VOID* pVertices,
+                         UINT* pIndices, ImportedSubset* pSubsets, UINT ThreadCount )
+{
+    XMASSERT( pScene );
+    XMASSERT( pConvert );
+
+    UINT MeshCount = pScene->mNumMeshes;
+
+    // Largest meshes first, so a big one does not start last and keep the
+    // other threads waiting.
+    std::vector<UINT> Order( MeshCount );
+    for( UINT m = 0; m < MeshCount; m++ )
+        Order[m] = m;
+    std::sort( Order.begin(), Order.end(), [pScene]( UINT a, UINT b )
+    {
+        UINT64 SizeA = ( UINT64 )pScene->mMeshes[a]->mNumVertices + pScene->mMeshes[a]->mNumFaces;
+        UINT64 SizeB = ( UINT64 )pScene->mMeshes[b]->mNumVertices + pScene->mMeshes[b]->mNumFaces;
+        return SizeA != SizeB ? SizeA > SizeB : a < b;
+    } );
+
+    // Every task takes the next mesh until none is left.
+    std::atomic<UINT> Next( 0 );
+    std::atomic<UINT> Failed( 0 );
+    UINT TaskCount = GetParallelTaskCount( MeshCount, ThreadCount );
+
+    ParallelFor( TaskCount, TaskCount, 1, [&]( UINT, UINT, UINT )
+    {
+        for( UINT i = Next++; i < MeshCount; i = Next++ )
+        {
+            UINT m = Order[i];
+            ImportedSubset& Subset = pSubsets[m];
+            pConvert( pScene->mMeshes[m], static_cast<BYTE*>( pVertices ) + ( size_t )Subset.BaseVertex * VertexSize,
+                      &Subset.Bounds );
+
+            if( !ConvertSceneFaces( pScene->mMeshes[m], pIndices + Subset.FirstIndex ) )
+                Failed = 1;
+        }
+    } );
+
+    return !Failed;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL ImportScene( const aiScene* pScene, ImportedMesh* pOut, UINT ThreadCount )
+{
+    XMASSERT( pScene );
+    XMASSERT( pOut );
+
+    pOut->Clear();
+    UINT VertexCount, IndexCount;
+    if( PrepareSceneMeshes( pScene, &pOut->Subsets, &pOut->Materials, &pOut->HasNormals, &pOut->HasTexCoords,
+                            &VertexCount, &IndexCount ) )
+    {
+        pOut->Vertices.resize( VertexCount );
+        pOut->Indices.resize( IndexCount );
+        if( ConvertSceneMeshes( pScene, &ConvertSceneVertices<ImportedVertex>, sizeof( ImportedVertex ),
+                                pOut->Vertices.data(), pOut->Indices.data(), pOut->Subsets.data(), ThreadCount ) )
+            return TRUE;
+    }
+
+    pOut->Clear();
+    return FALSE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Reads the file without post-processing, then applies the steps one by one.
+//-----------------------------------------------------------------------------
+static const aiScene* ReadSceneTimed( Assimp::Importer& Importer, const char* FileName, UINT PostProcessFlags,
+                                      SceneImportTimings* pTimings )
+{
+    SceneStageTimer* pTimer = new SceneStageTimer();
+    Importer.SetProgressHandler( pTimer );
+
+    SceneClock::time_point Start = SceneClock::now();
+    const aiScene* pScene = Importer.ReadFile( FileName, 0 );
+    SceneClock::time_point End = SceneClock::now();
+    if( !pScene )
+        return NULL;
+
+    // What ReadFile does after the importer (scene preprocessing and
+    // validation) is counted apart when the handler saw the end of the read.
+    if( pTimer->m_ReadDone )
+    {
+        AddSceneStage( pTimings, "read", 0, GetMilliseconds( Start, pTimer->m_ReadEnd ) );
+        AddSceneStage( pTimings, "preprocess", 0, GetMilliseconds( pTimer->m_ReadEnd, End ) );
+    }
+    else
+    {
+        AddSceneStage( pTimings, "read", 0, GetMilliseconds( Start, End ) );
+    }
+
+    for( UINT i = 0; i < sizeof( SceneProcessSteps ) / sizeof( SceneProcessSteps[0] ); i++ )
+    {
+        const SceneProcessStep& Step = SceneProcessSteps[i];
+        if( !( PostProcessFlags & Step.Flag ) )
+            continue;
+
+        pTimer->Reset();
+        Start = SceneClock::now();
+        pScene = Importer.ApplyPostProcessing( Step.Flag );
+        End = SceneClock::now();
+        if( !pScene )
+            return NULL;
+
+        if( pTimer->m_ProcessStarted && pTimer->m_ProcessDone )
+            AddSceneStage( pTimings, Step.Name, Step.Flag, GetMilliseconds( pTimer->m_ProcessStart, pTimer->m_ProcessEnd ) );
+        else
+            AddSceneStage( pTimings, Step.Name, Step.Flag, GetMilliseconds( Start, End ) );
+    }
+
+    return pScene;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL ReadSceneFile( const char* FileName, UINT PostProcessFlags, SceneReadFunction pRead, VOID* pContext,
+                    UINT ThreadCount, SceneImportTimings* pTimings, MappedIOSystem* pIOSystem )
+{
+    XMASSERT( FileName );
+    XMASSERT( pRead );
+
+    SceneClock::time_point Start = SceneClock::now();
+    if( pTimings )
+        pTimings->Stages.clear();
+
+    // The importer owns the progress handler and deletes it. It would delete
+    // the IOSystem too, so that is taken back once the file is read; the
+    // post-processing does no IO.
+    Assimp::Importer Importer;
+    if( pIOSystem )
+        Importer.SetIOHandler( pIOSystem );
+
+    const aiScene* pScene = pTimings ? ReadSceneTimed( Importer, FileName, PostProcessFlags, pTimings )
+                                     : Importer.ReadFile( FileName, PostProcessFlags );
+    if( pIOSystem )
+        Importer.SetIOHandler( NULL );
+
+    if( !pScene )
+        return FALSE;
+
+    SceneClock::time_point ConvertStart = SceneClock::now();
+    BOOL Result = pRead( pScene, ThreadCount, pContext );
+
+    if( pTimings )
+    {
+        SceneClock::time_point End = SceneClock::now();
+        AddSceneStage( pTimings, "convert", 0, GetMilliseconds( ConvertStart, End ) );
+        pTimings->TotalMilliseconds = GetMilliseconds( Start, End );
+    }
+    return Result;
+}
+
+
+
+static BOOL ImportSceneRead( const aiScene* pScene, UINT ThreadCount, VOID* pContext )
+{
+    return ImportScene( pScene, static_cast<ImportedMesh*>( pContext ), ThreadCount );
+}
+
+
+
+BOOL ImportSceneFromFile( const char* FileName, UINT PostProcessFlags, ImportedMesh* pOut, UINT ThreadCount,
+                          SceneImportTimings* pTimings, MappedIOSystem* pIOSystem )
+{
+    XMASSERT( pOut );
+
+    if( ReadSceneFile( FileName, PostProcessFlags, &ImportSceneRead, pOut, ThreadCount, pTimings, pIOSystem ) )
+        return TRUE;
+
+    pOut->Clear();
+    return FALSE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// MeshLoader.h: the one choice of reader for every LoadMeshFromFile.
+//-----------------------------------------------------------------------------
+MeshFileSource GetMeshFileSource( const char* FileName, const MappedIOSystem* pIOSystem, const AssetArchive** ppArchive )
+{
+    XMASSERT( FileName );
+    XMASSERT( ppArchive );
+
+    *ppArchive = NULL;
+    if( !IsObjFileName( FileName ) )
+        return MeshFileScene;
+
+    *ppArchive = pIOSystem ? pIOSystem->FindArchive( FileName ) : NULL;
+    return *ppArchive ? MeshFileObjArchive : MeshFileObjCache;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// MeshLoader.h: the ImportedMesh overload.
+//-----------------------------------------------------------------------------
+BOOL LoadMeshFromFile( const char* FileName, UINT PostProcessFlags, ImportedMesh* pOut, MeshCache* pCache,
+                       UINT ThreadCount, SceneImportTimings* pTimings, MappedIOSystem* pIOSystem,
+                       const MeshMissingNormalOptions* pNormalOptions )
+{
+    XMASSERT( FileName );
+    XMASSERT( pOut );
+
+    if( pCache )
+        pCache->Close();
+
+    const AssetArchive* pArchive;
+    MeshFileSource Source = GetMeshFileSource( FileName, pIOSystem, &pArchive );
+
+    BOOL Loaded;
+    if( Source == MeshFileObjArchive )
+    {
+        Loaded = LoadObjArchiveEntry( *pArchive, FileName, pOut, ThreadCount );
+        if( Loaded && pNormalOptions )
+            FillMissingNormals( pOut, *pNormalOptions, ThreadCount );
+    }
+    else if( Source == MeshFileObjCache )
+    {
+        MeshCache Cache;
+        MeshCache* pOpened = pCache ? pCache : &Cache;
+        Loaded = LoadObjFileCached( FileName, pOpened, ThreadCount, pNormalOptions );
+
+        if( Loaded && pCache )
+        {
+            // The vertices and indices stay in the mapping.
+            pOut->Clear();
+            pCache->GetSubsets( &pOut->Subsets );
+            pCache->GetMaterials( &pOut->Materials );
+            pOut->HasNormals = pCache->HasNormals();
+            pOut->HasTexCoords = pCache->HasTexCoords();
+        }
+        else if( Loaded )
+        {
+            Cache.GetMesh( pOut );
+        }
+    }
+    else
+    {
+        Loaded = ImportSceneFromFile( FileName, PostProcessFlags, pOut, ThreadCount, pTimings, pIOSystem );
+        if( Loaded && pNormalOptions )
+            FillMissingNormals( pOut, *pNormalOptions, ThreadCount );
+    }
+
+    if( !Loaded )
+    {
+        pOut->Clear();
+        if( pCache )
+            pCache->Close();
+    }
+    return Loaded;
+}
+
+}; // namespace
@@ -0,0 +1,120 @@
+//-------------------------------------------------------------------------------------
+// SceneImporter.h
+//
+// Converts a scene read by Assimp into one ImportedMesh, every aiMesh of it
+// and not only the first one.
+//
+// The vertices of all the meshes go into one vertex array and their indices,
+// as Assimp wrote them, into one index array, so a whole model is one vertex
+// buffer and one index buffer. Subset i is scene->mMeshes[i]: its FirstIndex
+// and IndexCount in the shared index buffer, the BaseVertex its indices are
+// relative to, its material index in the scene and its bounds. Node
+// transforms are not applied; the vertices stay in the space of their mesh,
+// as the importer of the demos always read them.
+//
+// The meshes are converted in parallel, one task per mesh, largest first.
+// Their offsets in the shared arrays are known up front, so every task writes
+// straight into its own range and the result does not depend on the number
+// of threads.
+//
+// Which Assimp post-processing runs is a load option: a profile from
+// GetScenePostProcessFlags or any combination of aiPostProcessSteps. Given a
+// SceneImportTimings, ImportSceneFromFile reports the wall time of the file
+// read, of every post-processing step and of the conversion, to weigh import
+// time against what the steps save at draw time.
+//
+// Given a MappedIOSystem, Assimp reads the file and everything it references
+// through it, from memory mapped files or mounted blocks, instead of stdio.
+//
+// ImportScene fills an ImportedMesh; MeshLoader.h fills the vertex struct of a
+// demo through the same PrepareSceneMeshes and ConvertSceneMeshes.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _SCENE_IMPORTER_H_
+#define _SCENE_IMPORTER_H_
+
+#include <vector>
+#include "ImportedMesh.h"
+#include "postprocess.h"
+
+struct aiMesh;
+struct aiScene;
+
+namespace XNA
+{
+
+class MappedIOSystem;
+
+enum SceneImportProfile
+{
+    SceneImportMinimal,         // Triangulate only, what the demos always loaded with.
+    SceneImportFast,            // Also JoinIdenticalVertices, GenNormals, SortByPType.
+    SceneImportQuality,         // Fast with GenSmoothNormals, plus ImproveCacheLocality,
+                                // OptimizeMeshes, RemoveRedundantMaterials, FindDegenerates
+                                // and FindInvalidData.
+};
+
+// aiPostProcessSteps of a profile.
+UINT GetScenePostProcessFlags( SceneImportProfile Profile );
+
+struct SceneImportStage
+{
+    const char* Name;           // "read", "preprocess", a step such as "JoinIdenticalVertices", "convert".
+    UINT Flag;                  // The aiPostProcessSteps bit of a step, 0 for the others.
+    DOUBLE Milliseconds;
+};
+
+struct SceneImportTimings
+{
+    std::vector<SceneImportStage> Stages;   // In the order they ran.
+    DOUBLE TotalMilliseconds;
+};
+
+// Writes the pMesh->mNumVertices vertices of a mesh at pVertices and the
+// bounds of their positions. MeshLoader.h has one per vertex struct.
+typedef VOID ( *SceneVertexConverter )( const aiMesh* pMesh, VOID* pVertices, AxisAlignedBox* pBounds );
+
+// Called by ReadSceneFile with the scene before the importer frees it.
+typedef BOOL ( *SceneReadFunction )( const aiScene* pScene, UINT ThreadCount, VOID* pContext );
+
+// Converts every mesh of pScene. Faces with more than three corners are
+// drawn as fans, points and lines are dropped. Returns FALSE if a face
+// indexes past its mesh or the scene has more than 4G vertices or indices.
+// ThreadCount 0 uses every hardware thread.
+BOOL ImportScene( const aiScene* pScene, ImportedMesh* pOut, UINT ThreadCount = 0 );
+
+// The two halves of ImportScene, for any vertex struct (see MeshLoader.h).
+// PrepareSceneMeshes fills the subsets but their bounds, the materials, the
+// flags and the total counts; it returns FALSE on the same errors as
+// ImportScene but for bad face indices. ConvertSceneMeshes then writes the
+// vertices, VertexSize bytes each, the indices and the bounds, in parallel
+// as ImportScene does.
+BOOL PrepareSceneMeshes( const aiScene* pScene, std::vector<ImportedSubset>* pSubsets,
+                         std::vector<ImportedMaterial>* pMaterials, BOOL* pHasNormals, BOOL* pHasTexCoords,
+                         UINT* pVertexCount, UINT* pIndexCount );
+BOOL ConvertSceneMeshes( const aiScene* pScene, SceneVertexConverter pConvert, UINT VertexSize, VOID* pVertices,
+                         UINT* pIndices, ImportedSubset* pSubsets, UINT ThreadCount );
+
+// Reads a file with Assimp::Importer and the given aiPostProcessSteps, then
+// hands the scene to pRead. Returns FALSE if the file cannot be read, else
+// what pRead returns. The timings and the IOSystem are those of
+// ImportSceneFromFile.
+BOOL ReadSceneFile( const char* FileName, UINT PostProcessFlags, SceneReadFunction pRead, VOID* pContext,
+                    UINT ThreadCount = 0, SceneImportTimings* pTimings = NULL, MappedIOSystem* pIOSystem = NULL );
+
+// Reads a file with Assimp::Importer and the given aiPostProcessSteps, then
+// converts it with ImportScene. If pTimings is not NULL, the steps are applied
+// one at a time, in the order Assimp runs them, with a ProgressHandler
+// timing each of them; steps that share work inside Assimp (the spatial sort
+// of GenNormals and JoinIdenticalVertices) then each pay for it, so the total
+// can be slightly more than a single ReadFile. If pIOSystem is not NULL the
+// files are read through it, else through Assimp's default IOSystem; the
+// importer gives it back before returning.
+BOOL ImportSceneFromFile( const char* FileName, UINT PostProcessFlags, ImportedMesh* pOut, UINT ThreadCount = 0,
+                          SceneImportTimings* pTimings = NULL, MappedIOSystem* pIOSystem = NULL );
+
+}; // namespace
+
+#endif
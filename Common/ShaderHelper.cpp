@@ -6,8 +6,20 @@
 #include <d3dcompiler.h>
 using namespace std;
 
+ShaderSource ShaderHelper::sSource = NULL;
+void *ShaderHelper::sSourceContext = NULL;
+
+void ShaderHelper::SetShaderSource(ShaderSource source, void *context)
+{
+	sSource = source;
+	sSourceContext = context;
+}
+
 HRESULT ShaderHelper::LoadCompiledShader(const char *filename, ID3DBlob **blob)
 {
+	if (sSource && sSource(filename, blob, sSourceContext) == S_OK)
+		return S_OK;
+
 	ifstream ifs(filename, ios::binary);
 	if (ifs.bad() || ifs.fail())
 	{
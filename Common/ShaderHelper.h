@@ -3,10 +3,22 @@
 #define ShaderHelper_h__
 #include <d3d11.h>
 
+// Creates the blob of a compiled shader kept somewhere else than a loose file (an asset
+// archive for instance). Returns S_OK, or S_FALSE when it does not have the file.
+typedef HRESULT (*ShaderSource)(const char *filename, ID3DBlob **blob, void *context);
+
 class ShaderHelper
 {
 public:
 	static HRESULT ShaderHelper::LoadCompiledShader(const char *filename, ID3DBlob **blob);
+
+	// Compiled shaders are asked to source first, then read from disk. NULL (the default)
+	// only reads loose files.
+	static void SetShaderSource(ShaderSource source, void *context);
+
+private:
+	static ShaderSource sSource;
+	static void *sSourceContext;
 };
 
 #endif // ShaderHelper_h__
\ No newline at end of file
@@ -0,0 +1,504 @@
+//-------------------------------------------------------------------------------------
+// SignedDistanceField.cpp
+//
+// Sparse brick signed distance field baking and sampling.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "SignedDistanceField.h"
+#include "CollisionMesh.h"
+#include "ParallelFor.h"
+
+namespace XNA
+{
+
+static const UINT NoBrick = 0xffffffff;
+
+// Work per ParallelFor task: coarse corners and brick tests are one query
+// each, a stored brick is BrickSamples^3 of them.
+static const UINT MinQueriesPerTask = 64;
+static const UINT MinBricksPerTask = 1;
+
+
+
+//-----------------------------------------------------------------------------
+// Angle weighted pseudo normals of a triangle list, with the vertices welded
+// by position. Only their direction matters, so they are not normalized.
+//-----------------------------------------------------------------------------
+struct PseudoNormals
+{
+    std::vector<XMFLOAT3> Faces;        // Per triangle.
+    std::vector<XMFLOAT3> Edges;        // Per triangle edge, as ClosestHit::Feature - 3.
+    std::vector<XMFLOAT3> Vertices;     // Per welded vertex.
+    std::vector<UINT> Corners;          // Welded vertex of each index.
+};
+
+
+
+static inline XMVECTOR LoadPosition( const XMFLOAT3* pPositions, UINT Stride, UINT i )
+{
+    return XMLoadFloat3( ( const XMFLOAT3* )( ( const BYTE* )pPositions + ( size_t )i * Stride ) );
+}
+
+
+
+static inline VOID AddFloat3( XMFLOAT3& Sum, FXMVECTOR V )
+{
+    XMStoreFloat3( &Sum, XMLoadFloat3( &Sum ) + V );
+}
+
+
+
+static VOID ComputePseudoNormals( const XMFLOAT3* pPositions, UINT Stride, const UINT* pIndices, UINT TriangleCount,
+                                  PseudoNormals* pOut )
+{
+    UINT IndexCount = 3 * TriangleCount;
+    UINT VertexCount = 0;
+    for( UINT i = 0; i < IndexCount; i++ )
+        VertexCount = ( std::max )( VertexCount, pIndices[i] + 1 );
+
+    // Weld: sort the vertices by position and number the distinct positions.
+    std::vector<UINT> Order( VertexCount );
+    for( UINT i = 0; i < VertexCount; i++ )
+        Order[i] = i;
+
+    auto Position = [&]( UINT i ) -> const XMFLOAT3&
+    {
+        return *( const XMFLOAT3* )( ( const BYTE* )pPositions + ( size_t )i * Stride );
+    };
+
+    std::sort( Order.begin(), Order.end(), [&]( UINT a, UINT b )
+    {
+        const XMFLOAT3& A = Position( a );
+        const XMFLOAT3& B = Position( b );
+        if( A.x != B.x )
+            return A.x < B.x;
+        if( A.y != B.y )
+            return A.y < B.y;
+        return A.z < B.z;
+    } );
+
+    std::vector<UINT> Welded( VertexCount );
+    UINT WeldedCount = 0;
+
+    for( UINT i = 0; i < VertexCount; i++ )
+    {
+        if( i > 0 )
+        {
+            const XMFLOAT3& A = Position( Order[i - 1] );
+            const XMFLOAT3& B = Position( Order[i] );
+            if( A.x != B.x || A.y != B.y || A.z != B.z )
+                WeldedCount++;
+        }
+        Welded[Order[i]] = WeldedCount;
+    }
+    WeldedCount++;
+
+    pOut->Corners.resize( IndexCount );
+    for( UINT i = 0; i < IndexCount; i++ )
+        pOut->Corners[i] = Welded[pIndices[i]];
+
+    const XMFLOAT3 Zero( 0.0f, 0.0f, 0.0f );
+    pOut->Faces.assign( TriangleCount, Zero );
+    pOut->Edges.assign( IndexCount, Zero );
+    pOut->Vertices.assign( WeldedCount, Zero );
+
+    // Face normals, and the corner angles they are weighted by at the vertices.
+    for( UINT t = 0; t < TriangleCount; t++ )
+    {
+        XMVECTOR V[3];
+        for( UINT k = 0; k < 3; k++ )
+            V[k] = LoadPosition( pPositions, Stride, pIndices[3 * t + k] );
+
+        XMVECTOR Normal = XMVector3Normalize( XMVector3Cross( V[1] - V[0], V[2] - V[0] ) );
+        XMStoreFloat3( &pOut->Faces[t], Normal );
+
+        for( UINT k = 0; k < 3; k++ )
+        {
+            XMVECTOR E1 = XMVector3Normalize( V[( k + 1 ) % 3] - V[k] );
+            XMVECTOR E2 = XMVector3Normalize( V[( k + 2 ) % 3] - V[k] );
+            FLOAT Cosine = ( std::max )( -1.0f, ( std::min )( 1.0f, XMVectorGetX( XMVector3Dot( E1, E2 ) ) ) );
+
+            AddFloat3( pOut->Vertices[pOut->Corners[3 * t + k]], Normal * acosf( Cosine ) );
+        }
+    }
+
+    // Edges: sort the triangle edges by their welded ends, so the edges shared
+    // by two triangles come next to each other, and sum the normals of each run.
+    std::vector<UINT64> Keys( IndexCount );
+    for( UINT i = 0; i < IndexCount; i++ )
+    {
+        UINT A = pOut->Corners[i];
+        UINT B = pOut->Corners[i - i % 3 + ( i + 1 ) % 3];
+        Keys[i] = ( UINT64( ( std::min )( A, B ) ) << 32 ) | ( std::max )( A, B );
+    }
+
+    Order.resize( IndexCount );
+    for( UINT i = 0; i < IndexCount; i++ )
+        Order[i] = i;
+
+    std::sort( Order.begin(), Order.end(), [&]( UINT a, UINT b )
+    {
+        return Keys[a] < Keys[b] || ( Keys[a] == Keys[b] && a < b );
+    } );
+
+    for( UINT Begin = 0; Begin < IndexCount; )
+    {
+        UINT End = Begin + 1;
+        while( End < IndexCount && Keys[Order[End]] == Keys[Order[Begin]] )
+            End++;
+
+        XMVECTOR Sum = XMVectorZero();
+        for( UINT i = Begin; i < End; i++ )
+            Sum += XMLoadFloat3( &pOut->Faces[Order[i] / 3] );
+
+        for( UINT i = Begin; i < End; i++ )
+            XMStoreFloat3( &pOut->Edges[Order[i]], Sum );
+
+        Begin = End;
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Signed distance at Point. MaxDistance bounds the search; it comes from a
+// neighboring sample (the distance changes no faster than the position), and
+// only rounding can make it too small, in which case the search is repeated.
+//-----------------------------------------------------------------------------
+static FLOAT ComputeSignedDistance( const CollisionMesh& Mesh, const PseudoNormals& Normals, FXMVECTOR Point,
+                                   FLOAT MaxDistance )
+{
+    ClosestHit Hit;
+
+    if( !Mesh.FindClosestPoint( Point, MaxDistance, &Hit ) )
+        Mesh.FindClosestPoint( Point, FLT_MAX, &Hit );
+
+    const XMFLOAT3* pNormal;
+    if( Hit.Feature < 3 )
+        pNormal = &Normals.Vertices[Normals.Corners[3 * Hit.Triangle + Hit.Feature]];
+    else if( Hit.Feature < 6 )
+        pNormal = &Normals.Edges[3 * Hit.Triangle + Hit.Feature - 3];
+    else
+        pNormal = &Normals.Faces[Hit.Triangle];
+
+    FLOAT Side = XMVectorGetX( XMVector3Dot( Point - XMLoadFloat3( &Hit.Point ), XMLoadFloat3( pNormal ) ) );
+    return Side < 0.0f ? -Hit.Distance : Hit.Distance;
+}
+
+
+
+//-----------------------------------------------------------------------------
+SignedDistanceField::SignedDistanceField() :
+    m_Origin( 0.0f, 0.0f, 0.0f ),
+    m_CellSize( 1.0f ),
+    m_InvCellSize( 1.0f )
+{
+    m_BrickCounts[0] = m_BrickCounts[1] = m_BrickCounts[2] = 0;
+}
+
+
+
+SignedDistanceField::~SignedDistanceField()
+{
+}
+
+
+
+VOID SignedDistanceField::Bake( const XMFLOAT3* pPositions, UINT Stride, const UINT* pIndices, UINT TriangleCount,
+                                FLOAT CellSize, FLOAT BandWidth, UINT ThreadCount )
+{
+    XMASSERT( pPositions );
+    XMASSERT( pIndices );
+    XMASSERT( TriangleCount > 0 );
+    XMASSERT( Stride >= sizeof( XMFLOAT3 ) );
+    XMASSERT( CellSize > 0.0f );
+    XMASSERT( BandWidth >= 0.0f );
+
+    CollisionMesh Mesh;
+    Mesh.Build( pPositions, Stride, pIndices, TriangleCount );
+
+    PseudoNormals Normals;
+    ComputePseudoNormals( pPositions, Stride, pIndices, TriangleCount, &Normals );
+
+    // The grid covers the mesh bounds grown by the band and a cell, in whole
+    // bricks.
+    XMVECTOR Min = XMVectorReplicate( FLT_MAX );
+    XMVECTOR Max = XMVectorReplicate( -FLT_MAX );
+    for( UINT i = 0; i < 3 * TriangleCount; i++ )
+    {
+        XMVECTOR P = LoadPosition( pPositions, Stride, pIndices[i] );
+        Min = XMVectorMin( Min, P );
+        Max = XMVectorMax( Max, P );
+    }
+
+    XMVECTOR Margin = XMVectorReplicate( BandWidth + CellSize );
+    Min -= Margin;
+    Max += Margin;
+
+    FLOAT BrickSize = BrickCells * CellSize;
+    XMFLOAT3 Extent;
+    XMStoreFloat3( &Extent, Max - Min );
+
+    for( UINT Axis = 0; Axis < 3; Axis++ )
+        m_BrickCounts[Axis] = ( std::max )( 1u, UINT( ceilf( ( &Extent.x )[Axis] / BrickSize ) ) );
+
+    XMStoreFloat3( &m_Origin, Min );
+    m_CellSize = CellSize;
+    m_InvCellSize = 1.0f / CellSize;
+
+    UINT CX = m_BrickCounts[0] + 1;
+    UINT CY = m_BrickCounts[1] + 1;
+    UINT CZ = m_BrickCounts[2] + 1;
+    UINT BrickCount = GetBrickCount();
+
+    XMVECTOR Origin = Min;
+
+    // Coarse grid.
+    m_Coarse.resize( CX * CY * CZ );
+
+    ParallelFor( UINT( m_Coarse.size() ), ThreadCount, MinQueriesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        XMVECTOR Previous = XMVectorZero();
+        FLOAT Bound = FLT_MAX;
+
+        for( UINT i = Begin; i < End; i++ )
+        {
+            XMVECTOR P = Origin + XMVectorSet( FLOAT( i % CX ), FLOAT( i / CX % CY ), FLOAT( i / ( CX * CY ) ), 0.0f ) *
+                                  BrickSize;
+
+            if( i > Begin )
+                Bound = fabsf( m_Coarse[i - 1] ) + XMVectorGetX( XMVector3Length( P - Previous ) ) * 1.001f;
+
+            m_Coarse[i] = ComputeSignedDistance( Mesh, Normals, P, Bound );
+            Previous = P;
+        }
+    } );
+
+    // A brick is stored if a point closer to the surface than the band can be
+    // in it: the center is less than the band and half a diagonal away.
+    FLOAT HalfDiagonal = 0.5f * sqrtf( 3.0f ) * BrickSize;
+    std::vector<BYTE> Needed( BrickCount );
+
+    ParallelFor( BrickCount, ThreadCount, MinQueriesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT b = Begin; b < End; b++ )
+        {
+            XMVECTOR Center = Origin + ( XMVectorSet( FLOAT( b % m_BrickCounts[0] ),
+                                                      FLOAT( b / m_BrickCounts[0] % m_BrickCounts[1] ),
+                                                      FLOAT( b / ( m_BrickCounts[0] * m_BrickCounts[1] ) ), 0.0f ) +
+                                         XMVectorReplicate( 0.5f ) ) * BrickSize;
+
+            ClosestHit Hit;
+            Needed[b] = Mesh.FindClosestPoint( Center, BandWidth + HalfDiagonal, &Hit ) ? 1 : 0;
+        }
+    } );
+
+    m_BrickTable.resize( BrickCount );
+    std::vector<UINT> Stored;
+
+    for( UINT b = 0; b < BrickCount; b++ )
+    {
+        if( Needed[b] )
+        {
+            m_BrickTable[b] = UINT( Stored.size() );
+            Stored.push_back( b );
+        }
+        else
+        {
+            m_BrickTable[b] = NoBrick;
+        }
+    }
+
+    const UINT SamplesPerBrick = BrickSamples * BrickSamples * BrickSamples;
+    m_Samples.resize( Stored.size() * SamplesPerBrick );
+
+    ParallelFor( UINT( Stored.size() ), ThreadCount, MinBricksPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT s = Begin; s < End; s++ )
+        {
+            UINT b = Stored[s];
+            XMVECTOR Corner = Origin + XMVectorSet( FLOAT( b % m_BrickCounts[0] ),
+                                                    FLOAT( b / m_BrickCounts[0] % m_BrickCounts[1] ),
+                                                    FLOAT( b / ( m_BrickCounts[0] * m_BrickCounts[1] ) ), 0.0f ) *
+                                       BrickSize;
+
+            FLOAT* pSamples = &m_Samples[size_t( s ) * SamplesPerBrick];
+            XMVECTOR Previous = XMVectorZero();
+            FLOAT Bound = FLT_MAX;
+
+            for( UINT i = 0; i < SamplesPerBrick; i++ )
+            {
+                XMVECTOR P = Corner + XMVectorSet( FLOAT( i % BrickSamples ), FLOAT( i / BrickSamples % BrickSamples ),
+                                                   FLOAT( i / ( BrickSamples * BrickSamples ) ), 0.0f ) * CellSize;
+
+                if( i > 0 )
+                    Bound = fabsf( pSamples[i - 1] ) + XMVectorGetX( XMVector3Length( P - Previous ) ) * 1.001f;
+
+                pSamples[i] = ComputeSignedDistance( Mesh, Normals, P, Bound );
+                Previous = P;
+            }
+        }
+    } );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Trilinear interpolation in the cell of the stored brick, or of the coarse
+// grid, around Point, and the gradient of the interpolation.
+//-----------------------------------------------------------------------------
+FLOAT SignedDistanceField::Sample( FXMVECTOR Point, XMVECTOR* pGradient ) const
+{
+    XMASSERT( !m_BrickTable.empty() );
+
+    XMVECTOR Local = ( Point - XMLoadFloat3( &m_Origin ) ) * m_InvCellSize;
+    XMVECTOR Cells = XMVectorSet( FLOAT( m_BrickCounts[0] * BrickCells ), FLOAT( m_BrickCounts[1] * BrickCells ),
+                                  FLOAT( m_BrickCounts[2] * BrickCells ), 0.0f );
+    XMVECTOR Clamped = XMVectorMin( XMVectorMax( Local, XMVectorZero() ), Cells );
+
+    FLOAT Outside = XMVectorGetX( XMVector3Length( Local - Clamped ) ) * m_CellSize;
+
+    XMFLOAT3 C;
+    XMStoreFloat3( &C, Clamped );
+
+    UINT Brick[3];
+    FLOAT F[3];
+    for( UINT Axis = 0; Axis < 3; Axis++ )
+    {
+        FLOAT Value = ( &C.x )[Axis];
+        Brick[Axis] = ( std::min )( UINT( Value ) / BrickCells, m_BrickCounts[Axis] - 1 );
+        F[Axis] = Value - FLOAT( Brick[Axis] * BrickCells );
+    }
+
+    UINT Slot = m_BrickTable[( Brick[2] * m_BrickCounts[1] + Brick[1] ) * m_BrickCounts[0] + Brick[0]];
+
+    const FLOAT* pBase;
+    UINT StrideY, StrideZ;
+    FLOAT Scale;
+
+    if( Slot != NoBrick )
+    {
+        UINT Cell[3];
+        for( UINT Axis = 0; Axis < 3; Axis++ )
+        {
+            Cell[Axis] = ( std::min )( UINT( F[Axis] ), BrickCells - 1 );
+            F[Axis] -= FLOAT( Cell[Axis] );
+        }
+
+        StrideY = BrickSamples;
+        StrideZ = BrickSamples * BrickSamples;
+        pBase = &m_Samples[size_t( Slot ) * BrickSamples * BrickSamples * BrickSamples] + Cell[2] * StrideZ +
+                Cell[1] * StrideY + Cell[0];
+        Scale = m_InvCellSize;
+    }
+    else
+    {
+        for( UINT Axis = 0; Axis < 3; Axis++ )
+            F[Axis] *= 1.0f / BrickCells;
+
+        StrideY = m_BrickCounts[0] + 1;
+        StrideZ = StrideY * ( m_BrickCounts[1] + 1 );
+        pBase = &m_Coarse[Brick[2] * StrideZ + Brick[1] * StrideY + Brick[0]];
+        Scale = m_InvCellSize * ( 1.0f / BrickCells );
+    }
+
+    FLOAT C000 = pBase[0], C100 = pBase[1];
+    FLOAT C010 = pBase[StrideY], C110 = pBase[StrideY + 1];
+    FLOAT C001 = pBase[StrideZ], C101 = pBase[StrideZ + 1];
+    FLOAT C011 = pBase[StrideZ + StrideY], C111 = pBase[StrideZ + StrideY + 1];
+
+    FLOAT U = F[0], V = F[1], W = F[2];
+
+    FLOAT X00 = C000 + ( C100 - C000 ) * U;
+    FLOAT X10 = C010 + ( C110 - C010 ) * U;
+    FLOAT X01 = C001 + ( C101 - C001 ) * U;
+    FLOAT X11 = C011 + ( C111 - C011 ) * U;
+
+    FLOAT Y0 = X00 + ( X10 - X00 ) * V;
+    FLOAT Y1 = X01 + ( X11 - X01 ) * V;
+
+    if( pGradient )
+    {
+        FLOAT DX0 = ( C100 - C000 ) + ( ( C110 - C010 ) - ( C100 - C000 ) ) * V;
+        FLOAT DX1 = ( C101 - C001 ) + ( ( C111 - C011 ) - ( C101 - C001 ) ) * V;
+        FLOAT DX = DX0 + ( DX1 - DX0 ) * W;
+        FLOAT DY = ( X10 - X00 ) + ( ( X11 - X01 ) - ( X10 - X00 ) ) * W;
+        FLOAT DZ = Y1 - Y0;
+
+        *pGradient = XMVectorSet( DX, DY, DZ, 0.0f ) * Scale;
+    }
+
+    return Y0 + ( Y1 - Y0 ) * W + Outside;
+}
+
+
+
+FLOAT SignedDistanceField::GetDistance( FXMVECTOR Point ) const
+{
+    return Sample( Point, NULL );
+}
+
+
+
+FLOAT SignedDistanceField::GetDistance( FXMVECTOR Point, XMVECTOR* pGradient ) const
+{
+    XMASSERT( pGradient );
+
+    return Sample( Point, pGradient );
+}
+
+
+
+BOOL SignedDistanceField::IntersectSphere( const Sphere* pVolume ) const
+{
+    XMASSERT( pVolume );
+
+    return Sample( XMLoadFloat3( &pVolume->Center ), NULL ) < pVolume->Radius;
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID SignedDistanceField::GetBounds( AxisAlignedBox* pOut ) const
+{
+    XMASSERT( pOut );
+
+    XMVECTOR Size = XMVectorSet( FLOAT( m_BrickCounts[0] ), FLOAT( m_BrickCounts[1] ), FLOAT( m_BrickCounts[2] ), 0.0f ) *
+                    ( BrickCells * m_CellSize );
+
+    XMStoreFloat3( &pOut->Center, XMLoadFloat3( &m_Origin ) + Size * 0.5f );
+    XMStoreFloat3( &pOut->Extents, Size * 0.5f );
+}
+
+
+
+FLOAT SignedDistanceField::GetCellSize() const
+{
+    return m_CellSize;
+}
+
+
+
+UINT SignedDistanceField::GetBrickCount() const
+{
+    return m_BrickCounts[0] * m_BrickCounts[1] * m_BrickCounts[2];
+}
+
+
+
+UINT SignedDistanceField::GetStoredBrickCount() const
+{
+    return UINT( m_Samples.size() / ( BrickSamples * BrickSamples * BrickSamples ) );
+}
+
+
+
+size_t SignedDistanceField::GetMemorySize() const
+{
+    return ( m_Coarse.size() + m_Samples.size() ) * sizeof( FLOAT ) + m_BrickTable.size() * sizeof( UINT );
+}
+
+}; // namespace
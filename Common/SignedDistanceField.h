@@ -0,0 +1,97 @@
+//-------------------------------------------------------------------------------------
+// SignedDistanceField.h
+//
+// Signed distance to a static triangle mesh, baked on a grid for soft
+// collision and proximity queries: a lookup and a trilinear blend of eight
+// samples instead of a loop over triangles. The distance is negative inside
+// the mesh.
+//
+// The grid is split into bricks of BrickCells^3 cells. Only the bricks within
+// the band around the surface store their samples (with the samples of their
+// far faces repeated, so a lookup never leaves its brick); everywhere else the
+// field is interpolated from a coarse grid of the distances at the brick
+// corners, which keeps the sign and a rough distance at a fraction of the
+// memory.
+//
+// Baking finds the nearest triangle of every sample with
+// CollisionMesh::FindClosestPoint, in parallel over the bricks. The sign comes
+// from the angle weighted pseudo normal of the triangle, edge or corner the
+// nearest point is on (Baerentzen and Aanaes), which is exact for a closed
+// mesh; vertices at the same position are welded first so that split normals
+// or texture seams do not open it.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _SIGNED_DISTANCE_FIELD_H_
+#define _SIGNED_DISTANCE_FIELD_H_
+
+#include <vector>
+#include "xnacollision.h"
+
+namespace XNA
+{
+
+class SignedDistanceField
+{
+public:
+    // Cells along each side of a brick.
+    static const UINT BrickCells = 8;
+
+    SignedDistanceField();
+    ~SignedDistanceField();
+
+    // Bake the field of a closed indexed triangle list wound so that
+    // cross( V1 - V0, V2 - V0 ) points out of the mesh, on cells of CellSize.
+    // Bricks with samples closer to the surface than BandWidth are stored.
+    // ThreadCount 0 uses every hardware thread.
+    VOID Bake( const XMFLOAT3* pPositions, UINT Stride, const UINT* pIndices, UINT TriangleCount, FLOAT CellSize,
+               FLOAT BandWidth, UINT ThreadCount = 0 );
+
+    // Interpolated distance at Point. Outside the baked bounds (the mesh bounds
+    // grown by the band) the distance to the bounds is added.
+    FLOAT GetDistance( FXMVECTOR Point ) const;
+
+    // Same, with the gradient of the interpolated field, which has about unit
+    // length and points away from the surface.
+    FLOAT GetDistance( FXMVECTOR Point, XMVECTOR* pGradient ) const;
+
+    // Returns TRUE if the sphere reaches into the mesh, up to the error of the
+    // interpolation (about a tenth of a cell near flat surfaces).
+    BOOL IntersectSphere( const Sphere* pVolume ) const;
+
+    VOID GetBounds( AxisAlignedBox* pOut ) const;
+    FLOAT GetCellSize() const;
+    UINT GetBrickCount() const;
+    UINT GetStoredBrickCount() const;
+
+    // Bytes of samples and brick table.
+    size_t GetMemorySize() const;
+
+private:
+    // Samples along each side of a stored brick.
+    static const UINT BrickSamples = BrickCells + 1;
+
+    FLOAT Sample( FXMVECTOR Point, XMVECTOR* pGradient ) const;
+
+    SignedDistanceField( const SignedDistanceField& rhs );
+    SignedDistanceField& operator=( const SignedDistanceField& rhs );
+
+private:
+    XMFLOAT3 m_Origin;          // Minimum corner of the grid.
+    FLOAT m_CellSize;
+    FLOAT m_InvCellSize;
+    UINT m_BrickCounts[3];
+
+    // Distances at the brick corners, x fastest, ( m_BrickCounts + 1 ) per axis.
+    std::vector<FLOAT> m_Coarse;
+
+    // Per brick, x fastest: the first sample of the brick in m_Samples divided
+    // by BrickSamples^3, or ~0 when the brick is not stored.
+    std::vector<UINT> m_BrickTable;
+    std::vector<FLOAT> m_Samples;
+};
+
+}; // namespace
+
+#endif
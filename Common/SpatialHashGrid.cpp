@@ -0,0 +1,436 @@
+//-------------------------------------------------------------------------------------
+// SpatialHashGrid.cpp
+//
+// Uniform hashed grid for sphere and point proximity queries.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "SpatialHashGrid.h"
+#include "ParallelFor.h"
+
+namespace XNA
+{
+
+// Blocks smaller than these are not worth a thread.
+static const UINT MinObjectsPerTask = 16 * 1024;
+static const UINT MinQueriesPerTask = 1024;
+
+// Every Build task keeps a histogram of all buckets, so the number of tasks is
+// also limited to this many per bucket count (the bucket count is at least the
+// object count).
+static const UINT MaxBuildTasksPerBucket = 8;
+
+// Cell coordinates are clamped to this range so that far away (or infinite)
+// positions cannot overflow them.
+static const FLOAT MaxCellCoordinate = 1073741824.0f;
+
+
+
+//-----------------------------------------------------------------------------
+// Cell coordinate of a position along one axis.
+//-----------------------------------------------------------------------------
+static inline INT GetCell( FLOAT Position, FLOAT InvCellSize )
+{
+    FLOAT Cell = floorf( Position * InvCellSize );
+    Cell = ( std::max )( Cell, -MaxCellCoordinate );
+    Cell = ( std::min )( Cell, MaxCellCoordinate );
+
+    return INT( Cell );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Insert two zero bits between each of the low 10 bits of v.
+//-----------------------------------------------------------------------------
+static inline UINT SpreadBits( UINT v )
+{
+    v &= 0x3ff;
+    v = ( v | ( v << 16 ) ) & 0x030000ff;
+    v = ( v | ( v << 8 ) ) & 0x0300f00f;
+    v = ( v | ( v << 4 ) ) & 0x030c30c3;
+    v = ( v | ( v << 2 ) ) & 0x09249249;
+    return v;
+}
+
+
+
+static inline UINT GetBucketCountFor( UINT Count )
+{
+    UINT BucketCount = 1;
+    while( BucketCount < Count && BucketCount < 0x80000000 )
+        BucketCount <<= 1;
+
+    return BucketCount;
+}
+
+
+
+//-----------------------------------------------------------------------------
+SpatialHashGrid::SpatialHashGrid( FLOAT CellSize, UINT ThreadCount ) :
+    m_ThreadCount( ThreadCount ),
+    m_MaxRadius( 0.0f ),
+    m_BucketMask( 0 )
+{
+    SetCellSize( CellSize );
+    m_InvCellSize = 1.0f / m_CellSize;
+    m_BucketStart.assign( 2, 0 );
+}
+
+
+
+SpatialHashGrid::~SpatialHashGrid()
+{
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Takes effect at the next Build; the queries keep using the cells the grid
+// was built with.
+//-----------------------------------------------------------------------------
+VOID SpatialHashGrid::SetCellSize( FLOAT CellSize )
+{
+    XMASSERT( CellSize > 0.0f );
+
+    m_CellSize = CellSize;
+}
+
+
+
+VOID SpatialHashGrid::SetThreadCount( UINT ThreadCount )
+{
+    m_ThreadCount = ThreadCount;
+}
+
+
+
+FLOAT SpatialHashGrid::GetCellSize() const
+{
+    return m_CellSize;
+}
+
+
+
+UINT SpatialHashGrid::GetObjectCount() const
+{
+    return UINT( m_Entries.size() );
+}
+
+
+
+UINT SpatialHashGrid::GetBucketCount() const
+{
+    return m_BucketMask + 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Morton code of the cell, cut to the bucket count. Cells whose coordinates
+// differ by a multiple of the table period share a bucket.
+//-----------------------------------------------------------------------------
+UINT SpatialHashGrid::GetBucket( INT CellX, INT CellY, INT CellZ ) const
+{
+    UINT Code = SpreadBits( UINT( CellX ) ) | ( SpreadBits( UINT( CellY ) ) << 1 ) | ( SpreadBits( UINT( CellZ ) ) << 2 );
+
+    return Code & m_BucketMask;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Call Visit( Entry ) for every stored sphere whose center is in a cell
+// overlapping the box of half size Reach around (X, Y, Z). Every sphere is
+// visited at most once. When there are more cells to look at than spheres,
+// all spheres are visited instead.
+//-----------------------------------------------------------------------------
+template<typename Visitor>
+VOID SpatialHashGrid::VisitCandidates( FLOAT X, FLOAT Y, FLOAT Z, FLOAT Reach, Visitor& Visit ) const
+{
+    INT MinX = GetCell( X - Reach, m_InvCellSize ), MaxX = GetCell( X + Reach, m_InvCellSize );
+    INT MinY = GetCell( Y - Reach, m_InvCellSize ), MaxY = GetCell( Y + Reach, m_InvCellSize );
+    INT MinZ = GetCell( Z - Reach, m_InvCellSize ), MaxZ = GetCell( Z + Reach, m_InvCellSize );
+
+    // Unsigned differences cannot overflow, the coordinates are clamped.
+    UINT64 CellCount = ( UINT64( UINT( MaxX ) - UINT( MinX ) ) + 1 ) * ( UINT64( UINT( MaxY ) - UINT( MinY ) ) + 1 ) *
+                       ( UINT64( UINT( MaxZ ) - UINT( MinZ ) ) + 1 );
+
+    const Entry* pEntries = m_Entries.data();
+
+    if( CellCount >= m_Entries.size() )
+    {
+        for( size_t i = 0; i < m_Entries.size(); i++ )
+            Visit( pEntries[i] );
+        return;
+    }
+
+    const UINT* pBucketStart = m_BucketStart.data();
+
+    for( INT z = MinZ; z <= MaxZ; z++ )
+    {
+        for( INT y = MinY; y <= MaxY; y++ )
+        {
+            for( INT x = MinX; x <= MaxX; x++ )
+            {
+                UINT Bucket = GetBucket( x, y, z );
+
+                // Skip the other cells hashed into the same bucket.
+                for( UINT i = pBucketStart[Bucket]; i < pBucketStart[Bucket + 1]; i++ )
+                {
+                    const Entry& E = pEntries[i];
+                    if( ( E.CellX == x ) & ( E.CellY == y ) & ( E.CellZ == z ) )
+                        Visit( E );
+                }
+            }
+        }
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Counting sort by bucket. Every task counts the buckets of its block of
+// spheres; the per task counts are then turned into the positions of each
+// block within each bucket, so that the scatter keeps the input order within
+// a bucket whatever the number of tasks.
+//-----------------------------------------------------------------------------
+VOID SpatialHashGrid::Build( const Sphere* pSpheres, UINT Count )
+{
+    XMASSERT( pSpheres || Count == 0 );
+
+    m_InvCellSize = 1.0f / m_CellSize;
+    m_Entries.resize( Count );
+    m_MaxRadius = 0.0f;
+
+    if( Count == 0 )
+    {
+        m_BucketMask = 0;
+        m_BucketStart.assign( 2, 0 );
+        return;
+    }
+
+    UINT BucketCount = GetBucketCountFor( Count );
+    m_BucketMask = BucketCount - 1;
+    m_BucketStart.resize( BucketCount + 1 );
+
+    m_Unsorted.resize( Count );
+    m_Buckets.resize( Count );
+
+    UINT MinPerTask = ( std::max )( MinObjectsPerTask, BucketCount / MaxBuildTasksPerBucket );
+    UINT TaskCount = GetParallelTaskCount( Count, m_ThreadCount, MinPerTask );
+
+    m_TaskCounts.resize( size_t( TaskCount ) * BucketCount );
+
+    std::vector<FLOAT> TaskMaxRadius( TaskCount, 0.0f );
+
+    ParallelFor( Count, m_ThreadCount, MinPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        UINT* pCounts = m_TaskCounts.data() + size_t( Task ) * BucketCount;
+        memset( pCounts, 0, BucketCount * sizeof( UINT ) );
+
+        FLOAT MaxRadius = 0.0f;
+
+        for( UINT i = Begin; i < End; i++ )
+        {
+            const Sphere& S = pSpheres[i];
+            XMASSERT( S.Radius >= 0.0f );
+
+            Entry& E = m_Unsorted[i];
+            E.X = S.Center.x;
+            E.Y = S.Center.y;
+            E.Z = S.Center.z;
+            E.Radius = S.Radius;
+            E.CellX = GetCell( S.Center.x, m_InvCellSize );
+            E.CellY = GetCell( S.Center.y, m_InvCellSize );
+            E.CellZ = GetCell( S.Center.z, m_InvCellSize );
+            E.Index = i;
+
+            UINT Bucket = GetBucket( E.CellX, E.CellY, E.CellZ );
+            m_Buckets[i] = Bucket;
+            pCounts[Bucket]++;
+
+            MaxRadius = ( std::max )( MaxRadius, S.Radius );
+        }
+
+        TaskMaxRadius[Task] = MaxRadius;
+    } );
+
+    for( UINT t = 0; t < TaskCount; t++ )
+        m_MaxRadius = ( std::max )( m_MaxRadius, TaskMaxRadius[t] );
+
+    // Offset of every task within each bucket, and the bucket sizes.
+    ParallelFor( BucketCount, m_ThreadCount, MinObjectsPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT b = Begin; b < End; b++ )
+        {
+            UINT Sum = 0;
+            for( UINT t = 0; t < TaskCount; t++ )
+            {
+                UINT& c = m_TaskCounts[size_t( t ) * BucketCount + b];
+                UINT Size = c;
+                c = Sum;
+                Sum += Size;
+            }
+            m_BucketStart[b] = Sum;
+        }
+    } );
+
+    UINT Offset = 0;
+    for( UINT b = 0; b < BucketCount; b++ )
+    {
+        UINT Size = m_BucketStart[b];
+        m_BucketStart[b] = Offset;
+        Offset += Size;
+    }
+    m_BucketStart[BucketCount] = Offset;
+
+    // Same blocks as the counting pass.
+    ParallelFor( Count, m_ThreadCount, MinPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        UINT* pCounts = m_TaskCounts.data() + size_t( Task ) * BucketCount;
+
+        for( UINT i = Begin; i < End; i++ )
+        {
+            UINT Bucket = m_Buckets[i];
+            m_Entries[m_BucketStart[Bucket] + pCounts[Bucket]++] = m_Unsorted[i];
+        }
+    } );
+}
+
+
+
+//-----------------------------------------------------------------------------
+UINT SpatialHashGrid::QuerySphere( const Sphere* pQuery, std::vector<UINT>* pResults ) const
+{
+    XMASSERT( pQuery );
+    XMASSERT( pResults );
+
+    size_t Start = pResults->size();
+
+    FLOAT X = pQuery->Center.x;
+    FLOAT Y = pQuery->Center.y;
+    FLOAT Z = pQuery->Center.z;
+    FLOAT Radius = pQuery->Radius;
+
+    // Same arithmetic as IntersectSphereSphere.
+    auto Visit = [&]( const Entry& E )
+    {
+        FLOAT dx = E.X - X, dy = E.Y - Y, dz = E.Z - Z;
+        FLOAT r = E.Radius + Radius;
+
+        if( dx * dx + dy * dy + dz * dz <= r * r )
+            pResults->push_back( E.Index );
+    };
+
+    VisitCandidates( X, Y, Z, Radius + m_MaxRadius, Visit );
+
+    return UINT( pResults->size() - Start );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Every task collects the results of its block of queries, with the count of
+// each query in pFirst; the blocks are concatenated in order and the counts
+// turned into offsets afterwards.
+//-----------------------------------------------------------------------------
+VOID SpatialHashGrid::QuerySpheres( const Sphere* pQueries, UINT Count, std::vector<UINT>* pFirst,
+                                    std::vector<UINT>* pResults ) const
+{
+    XMASSERT( pQueries || Count == 0 );
+    XMASSERT( pFirst );
+    XMASSERT( pResults );
+
+    pFirst->resize( Count + 1 );
+    pResults->clear();
+
+    UINT TaskCount = GetParallelTaskCount( Count, m_ThreadCount, MinQueriesPerTask );
+    std::vector< std::vector<UINT> > TaskResults( TaskCount );
+
+    UINT* pCounts = pFirst->data();
+
+    ParallelFor( Count, m_ThreadCount, MinQueriesPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        std::vector<UINT>& Out = TaskResults[Task];
+
+        for( UINT q = Begin; q < End; q++ )
+            pCounts[q] = QuerySphere( &pQueries[q], &Out );
+    } );
+
+    UINT Offset = 0;
+    for( UINT q = 0; q < Count; q++ )
+    {
+        UINT Size = pCounts[q];
+        pCounts[q] = Offset;
+        Offset += Size;
+    }
+    pCounts[Count] = Offset;
+
+    pResults->reserve( Offset );
+    for( UINT t = 0; t < TaskCount; t++ )
+        pResults->insert( pResults->end(), TaskResults[t].begin(), TaskResults[t].end() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Every sphere looks at its neighbour cells and keeps the spheres with a
+// larger index, so each pair is found once.
+//-----------------------------------------------------------------------------
+VOID SpatialHashGrid::FindPairs( std::vector<ProxyPair>* pPairs )
+{
+    XMASSERT( pPairs );
+
+    pPairs->clear();
+
+    UINT Count = UINT( m_Entries.size() );
+    if( Count == 0 )
+        return;
+
+    UINT TaskCount = GetParallelTaskCount( Count, m_ThreadCount, MinQueriesPerTask );
+    if( m_TaskPairs.size() < TaskCount )
+        m_TaskPairs.resize( TaskCount );
+
+    ParallelFor( Count, m_ThreadCount, MinQueriesPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        std::vector<ProxyPair>& Out = m_TaskPairs[Task];
+        Out.clear();
+
+        for( UINT k = Begin; k < End; k++ )
+        {
+            const Entry& A = m_Entries[k];
+
+            auto Visit = [&]( const Entry& B )
+            {
+                if( B.Index <= A.Index )
+                    return;
+
+                FLOAT dx = B.X - A.X, dy = B.Y - A.Y, dz = B.Z - A.Z;
+                FLOAT r = A.Radius + B.Radius;
+
+                if( dx * dx + dy * dy + dz * dz <= r * r )
+                {
+                    ProxyPair Pair;
+                    Pair.ProxyA = A.Index;
+                    Pair.ProxyB = B.Index;
+                    Out.push_back( Pair );
+                }
+            };
+
+            VisitCandidates( A.X, A.Y, A.Z, A.Radius + m_MaxRadius, Visit );
+        }
+    } );
+
+    size_t Total = 0;
+    for( UINT t = 0; t < TaskCount; t++ )
+        Total += m_TaskPairs[t].size();
+
+    pPairs->reserve( Total );
+    for( UINT t = 0; t < TaskCount; t++ )
+        pPairs->insert( pPairs->end(), m_TaskPairs[t].begin(), m_TaskPairs[t].end() );
+}
+
+}; // namespace
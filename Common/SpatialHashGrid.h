@@ -0,0 +1,112 @@
+//-------------------------------------------------------------------------------------
+// SpatialHashGrid.h
+//
+// Uniform grid over an array of spheres (or points, as spheres of radius 0)
+// for "everything within this radius" queries, meant for particles and crowds
+// where every object moves every frame and the whole grid is rebuilt.
+//
+// Space is cut into cubic cells, and the cells are hashed into a table of
+// buckets, so the grid needs no bounds and only as much memory as there are
+// objects. The hash interleaves the low bits of the cell coordinates (Morton
+// order), which wraps the table around space periodically but keeps nearby
+// cells in nearby buckets, so neighbour searches stay in cache. Build()
+// counting sorts the objects by bucket: the objects of a bucket are stored
+// contiguously, in the order of the input array. A sphere
+// is stored in the cell of its center only; queries reach out by the largest
+// radius of the grid, so the cells should be about as large as the typical
+// query radius plus the typical object radius. Several cells can share a
+// bucket; each stored object remembers its cell so that hash collisions never
+// produce duplicates.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _SPATIAL_HASH_GRID_H_
+#define _SPATIAL_HASH_GRID_H_
+
+#include <vector>
+#include "xnacollision.h"
+#include "DynamicAabbTree.h"
+
+namespace XNA
+{
+
+class SpatialHashGrid
+{
+public:
+    // ThreadCount 0 uses one thread per hardware thread, 1 runs everything on
+    // the calling thread.
+    SpatialHashGrid( FLOAT CellSize, UINT ThreadCount = 0 );
+    ~SpatialHashGrid();
+
+    // Rebuild the grid from pSpheres[0..Count). The spheres are copied, the
+    // array is not referenced afterwards.
+    VOID Build( const Sphere* pSpheres, UINT Count );
+
+    // Append the indices of the spheres that intersect *pQuery (the same test
+    // as IntersectSphereSphere: touching spheres intersect) to pResults, in no
+    // particular order. Returns the number of indices appended.
+    UINT QuerySphere( const Sphere* pQuery, std::vector<UINT>* pResults ) const;
+
+    // Run Count queries on several threads. The results of query i are
+    // (*pResults)[(*pFirst)[i] .. (*pFirst)[i + 1]); pFirst receives Count + 1
+    // offsets. The output does not depend on the thread count.
+    VOID QuerySpheres( const Sphere* pQueries, UINT Count, std::vector<UINT>* pFirst,
+                       std::vector<UINT>* pResults ) const;
+
+    // Find all intersecting pairs among the spheres of the last Build, with
+    // ProxyA < ProxyB. The order of the pairs does not depend on the thread
+    // count.
+    VOID FindPairs( std::vector<ProxyPair>* pPairs );
+
+    VOID SetCellSize( FLOAT CellSize );
+    VOID SetThreadCount( UINT ThreadCount );
+
+    FLOAT GetCellSize() const;
+    UINT GetObjectCount() const;
+    UINT GetBucketCount() const;
+
+private:
+    // A sphere in bucket order, with its cell.
+    struct Entry
+    {
+        FLOAT X, Y, Z, Radius;
+        INT CellX, CellY, CellZ;
+        UINT Index;
+    };
+
+    UINT GetBucket( INT CellX, INT CellY, INT CellZ ) const;
+
+    template<typename Visitor>
+    VOID VisitCandidates( FLOAT X, FLOAT Y, FLOAT Z, FLOAT Reach, Visitor& Visit ) const;
+
+    SpatialHashGrid( const SpatialHashGrid& rhs );
+    SpatialHashGrid& operator=( const SpatialHashGrid& rhs );
+
+private:
+    FLOAT m_CellSize;
+    FLOAT m_InvCellSize;
+    UINT m_ThreadCount;
+
+    // Largest sphere radius of the last Build.
+    FLOAT m_MaxRadius;
+
+    // Bucket b holds m_Entries[m_BucketStart[b] .. m_BucketStart[b + 1]). The
+    // number of buckets is a power of two, m_BucketMask + 1.
+    UINT m_BucketMask;
+    std::vector<UINT> m_BucketStart;
+    std::vector<Entry> m_Entries;
+
+    // Build scratch: the entries in input order with their buckets, and one
+    // bucket histogram per task.
+    std::vector<Entry> m_Unsorted;
+    std::vector<UINT> m_Buckets;
+    std::vector<UINT> m_TaskCounts;
+
+    // Pairs found by each FindPairs task.
+    std::vector< std::vector<ProxyPair> > m_TaskPairs;
+};
+
+}; // namespace
+
+#endif
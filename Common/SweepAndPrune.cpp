@@ -0,0 +1,360 @@
+//-------------------------------------------------------------------------------------
+// SweepAndPrune.cpp
+//
+// Sweep-and-prune broadphase over an array of axis aligned boxes.
+//-------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include "SweepAndPrune.h"
+#include "ParallelFor.h"
+
+namespace XNA
+{
+
+// Blocks smaller than this are not worth a thread.
+static const UINT MinBoxesPerTask = 1024;
+
+// Give up on the insertion sort once it moved more than this many keys per box.
+static const UINT MaxInsertionMovesPerBox = 8;
+
+// Only switch the sort axis (which throws the previous order away) when
+// another axis spreads the boxes this much better.
+static const FLOAT AxisSwitchRatio = 1.5f;
+
+
+
+//-----------------------------------------------------------------------------
+// Map a float to an unsigned integer with the same ordering.
+//-----------------------------------------------------------------------------
+static inline UINT FloatToSortKey( FLOAT f )
+{
+    UINT u;
+    memcpy( &u, &f, sizeof( u ) );
+
+    return ( u & 0x80000000 ) ? ~u : ( u | 0x80000000 );
+}
+
+
+
+static inline FLOAT GetComponent( const XMFLOAT3& v, UINT Axis )
+{
+    return ( &v.x )[Axis];
+}
+
+
+
+//-----------------------------------------------------------------------------
+SweepAndPrune::SweepAndPrune( UINT ThreadCount ) :
+    m_ThreadCount( ThreadCount ),
+    m_Axis( 0 ),
+    m_RadixSorted( FALSE ),
+    m_InsertionMoves( 0 )
+{
+}
+
+
+
+SweepAndPrune::~SweepAndPrune()
+{
+}
+
+
+
+VOID SweepAndPrune::SetThreadCount( UINT ThreadCount )
+{
+    m_ThreadCount = ThreadCount;
+}
+
+
+
+UINT SweepAndPrune::GetSortAxis() const
+{
+    return m_Axis;
+}
+
+
+
+BOOL SweepAndPrune::WasRadixSorted() const
+{
+    return m_RadixSorted;
+}
+
+
+
+UINT SweepAndPrune::GetInsertionMoves() const
+{
+    return m_InsertionMoves;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Pick the axis along which the box centers are spread the most. The previous
+// order is dropped when the axis changes or the box count is different.
+//-----------------------------------------------------------------------------
+VOID SweepAndPrune::ChooseAxis( const AxisAlignedBox* pBoxes, UINT Count )
+{
+    XMVECTOR Sum = XMVectorZero();
+    XMVECTOR SumSq = XMVectorZero();
+
+    for( UINT i = 0; i < Count; i++ )
+    {
+        XMVECTOR Center = XMLoadFloat3( &pBoxes[i].Center );
+        Sum += Center;
+        SumSq += Center * Center;
+    }
+
+    XMVECTOR InvCount = XMVectorReplicate( 1.0f / FLOAT( Count ) );
+    Sum *= InvCount;
+    XMVECTOR Variance = SumSq * InvCount - Sum * Sum;
+
+    XMFLOAT3 v;
+    XMStoreFloat3( &v, Variance );
+
+    UINT Best = 0;
+    if( v.y > GetComponent( v, Best ) )
+        Best = 1;
+    if( v.z > GetComponent( v, Best ) )
+        Best = 2;
+
+    BOOL Rebuild = ( m_Order.size() != Count );
+
+    if( !Rebuild && Best != m_Axis && GetComponent( v, Best ) > AxisSwitchRatio * GetComponent( v, m_Axis ) )
+        Rebuild = TRUE;
+
+    if( Rebuild )
+    {
+        m_Axis = Best;
+
+        m_Order.resize( Count );
+        for( UINT i = 0; i < Count; i++ )
+            m_Order[i] = i;
+
+        m_RadixSorted = TRUE;
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Fix up the previous order. Returns FALSE (leaving a valid but partially
+// sorted order) once more than MaxMoves keys had to be shifted.
+//-----------------------------------------------------------------------------
+BOOL SweepAndPrune::InsertionSort( UINT MaxMoves )
+{
+    UINT* pKeys = m_Keys.data();
+    UINT* pOrder = m_Order.data();
+    UINT Count = UINT( m_Keys.size() );
+
+    m_InsertionMoves = 0;
+
+    for( UINT i = 1; i < Count; i++ )
+    {
+        UINT Key = pKeys[i];
+        if( pKeys[i - 1] <= Key )
+            continue;
+
+        UINT Index = pOrder[i];
+        UINT j = i;
+
+        do
+        {
+            pKeys[j] = pKeys[j - 1];
+            pOrder[j] = pOrder[j - 1];
+            j--;
+            m_InsertionMoves++;
+        }
+        while( j > 0 && pKeys[j - 1] > Key );
+
+        pKeys[j] = Key;
+        pOrder[j] = Index;
+
+        if( m_InsertionMoves > MaxMoves )
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// LSD radix sort of the keys (and m_Order along with them), three passes of
+// 11, 11 and 10 bits. Passes where every key has the same digit are skipped.
+//-----------------------------------------------------------------------------
+VOID SweepAndPrune::RadixSort()
+{
+    UINT Count = UINT( m_Keys.size() );
+
+    m_TempKeys.resize( Count );
+    m_TempOrder.resize( Count );
+
+    UINT Histogram[3][2048];
+    memset( Histogram, 0, sizeof( Histogram ) );
+
+    const UINT* pKeys = m_Keys.data();
+    for( UINT i = 0; i < Count; i++ )
+    {
+        UINT Key = pKeys[i];
+        Histogram[0][Key & 0x7ff]++;
+        Histogram[1][( Key >> 11 ) & 0x7ff]++;
+        Histogram[2][Key >> 22]++;
+    }
+
+    UINT* pSrcKeys = m_Keys.data();
+    UINT* pSrcOrder = m_Order.data();
+    UINT* pDstKeys = m_TempKeys.data();
+    UINT* pDstOrder = m_TempOrder.data();
+
+    for( UINT Pass = 0; Pass < 3; Pass++ )
+    {
+        UINT Shift = Pass * 11;
+        UINT* pCount = Histogram[Pass];
+
+        if( pCount[( pSrcKeys[0] >> Shift ) & 0x7ff] == Count )
+            continue;
+
+        UINT Offset = 0;
+        for( UINT d = 0; d < 2048; d++ )
+        {
+            UINT c = pCount[d];
+            pCount[d] = Offset;
+            Offset += c;
+        }
+
+        for( UINT i = 0; i < Count; i++ )
+        {
+            UINT Key = pSrcKeys[i];
+            UINT Dst = pCount[( Key >> Shift ) & 0x7ff]++;
+            pDstKeys[Dst] = Key;
+            pDstOrder[Dst] = pSrcOrder[i];
+        }
+
+        std::swap( pSrcKeys, pDstKeys );
+        std::swap( pSrcOrder, pDstOrder );
+    }
+
+    if( pSrcKeys != m_Keys.data() )
+    {
+        m_Keys.swap( m_TempKeys );
+        m_Order.swap( m_TempOrder );
+    }
+}
+
+
+
+//-----------------------------------------------------------------------------
+VOID SweepAndPrune::FindPairs( const AxisAlignedBox* pBoxes, UINT Count, std::vector<ProxyPair>* pPairs )
+{
+    XMASSERT( pBoxes || Count == 0 );
+    XMASSERT( pPairs );
+
+    pPairs->clear();
+    m_RadixSorted = FALSE;
+    m_InsertionMoves = 0;
+
+    if( Count == 0 )
+    {
+        m_Order.clear();
+        return;
+    }
+
+    ChooseAxis( pBoxes, Count );
+
+    const UINT Axis0 = m_Axis;
+    const UINT Axis1 = ( m_Axis + 1 ) % 3;
+    const UINT Axis2 = ( m_Axis + 2 ) % 3;
+
+    // Keys of the new positions, in the order of the previous call.
+    m_Keys.resize( Count );
+
+    ParallelFor( Count, m_ThreadCount, MinBoxesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT k = Begin; k < End; k++ )
+        {
+            const AxisAlignedBox& Box = pBoxes[m_Order[k]];
+            m_Keys[k] = FloatToSortKey( GetComponent( Box.Center, Axis0 ) - GetComponent( Box.Extents, Axis0 ) );
+        }
+    } );
+
+    if( m_RadixSorted || !InsertionSort( Count * MaxInsertionMovesPerBox ) )
+    {
+        RadixSort();
+        m_RadixSorted = TRUE;
+    }
+
+    // Gather the bounds in sorted order so the sweep reads them linearly.
+    for( UINT a = 0; a < 3; a++ )
+    {
+        m_Min[a].resize( Count );
+        m_Max[a].resize( Count );
+    }
+
+    ParallelFor( Count, m_ThreadCount, MinBoxesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        for( UINT k = Begin; k < End; k++ )
+        {
+            const AxisAlignedBox& Box = pBoxes[m_Order[k]];
+
+            // Same arithmetic as IntersectAxisAlignedBoxAxisAlignedBox.
+            m_Min[0][k] = GetComponent( Box.Center, Axis0 ) - GetComponent( Box.Extents, Axis0 );
+            m_Max[0][k] = GetComponent( Box.Center, Axis0 ) + GetComponent( Box.Extents, Axis0 );
+            m_Min[1][k] = GetComponent( Box.Center, Axis1 ) - GetComponent( Box.Extents, Axis1 );
+            m_Max[1][k] = GetComponent( Box.Center, Axis1 ) + GetComponent( Box.Extents, Axis1 );
+            m_Min[2][k] = GetComponent( Box.Center, Axis2 ) - GetComponent( Box.Extents, Axis2 );
+            m_Max[2][k] = GetComponent( Box.Center, Axis2 ) + GetComponent( Box.Extents, Axis2 );
+        }
+    } );
+
+    // Sweep. Every box only looks forward, so each pair is found once.
+    UINT TaskCount = GetParallelTaskCount( Count, m_ThreadCount, MinBoxesPerTask );
+    if( m_TaskPairs.size() < TaskCount )
+        m_TaskPairs.resize( TaskCount );
+
+    ParallelFor( Count, m_ThreadCount, MinBoxesPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        const FLOAT* pMin0 = m_Min[0].data();
+        const FLOAT* pMax0 = m_Max[0].data();
+        const FLOAT* pMin1 = m_Min[1].data();
+        const FLOAT* pMax1 = m_Max[1].data();
+        const FLOAT* pMin2 = m_Min[2].data();
+        const FLOAT* pMax2 = m_Max[2].data();
+        const UINT* pOrder = m_Order.data();
+
+        std::vector<ProxyPair>& Out = m_TaskPairs[Task];
+        Out.clear();
+
+        for( UINT i = Begin; i < End; i++ )
+        {
+            FLOAT Max0 = pMax0[i];
+            FLOAT Min1 = pMin1[i], Max1 = pMax1[i];
+            FLOAT Min2 = pMin2[i], Max2 = pMax2[i];
+
+            for( UINT j = i + 1; j < Count && pMin0[j] <= Max0; j++ )
+            {
+                // Most candidates are rejected and the outcome of each test is
+                // random, so evaluate all four without branching.
+                BOOL Overlap = ( pMin1[j] <= Max1 ) & ( Min1 <= pMax1[j] ) &
+                               ( pMin2[j] <= Max2 ) & ( Min2 <= pMax2[j] );
+                if( !Overlap )
+                    continue;
+
+                ProxyPair Pair;
+                Pair.ProxyA = ( std::min )( pOrder[i], pOrder[j] );
+                Pair.ProxyB = ( std::max )( pOrder[i], pOrder[j] );
+                Out.push_back( Pair );
+            }
+        }
+    } );
+
+    size_t Total = 0;
+    for( UINT t = 0; t < TaskCount; t++ )
+        Total += m_TaskPairs[t].size();
+
+    pPairs->reserve( Total );
+    for( UINT t = 0; t < TaskCount; t++ )
+        pPairs->insert( pPairs->end(), m_TaskPairs[t].begin(), m_TaskPairs[t].end() );
+}
+
+}; // namespace
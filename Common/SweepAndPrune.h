@@ -0,0 +1,83 @@
+//-------------------------------------------------------------------------------------
+// SweepAndPrune.h
+//
+// Sweep-and-prune broadphase over an array of axis aligned boxes, meant for
+// scenes where most objects move every frame (where DynamicAabbTree would
+// re-insert most of its leaves anyway).
+//
+// The boxes are sorted by their minimum on one axis. The order of the previous
+// call is reused and fixed up with an insertion sort, which is close to linear
+// when the objects moved only a little; when too many endpoints cross, or the
+// number of boxes changed, the keys are radix sorted from scratch. The sorted
+// array is then swept in blocks on several threads, every box being tested
+// against the following boxes whose minimum is below its maximum.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifndef _SWEEP_AND_PRUNE_H_
+#define _SWEEP_AND_PRUNE_H_
+
+#include <vector>
+#include "xnacollision.h"
+#include "DynamicAabbTree.h"
+
+namespace XNA
+{
+
+class SweepAndPrune
+{
+public:
+    // ThreadCount 0 uses one thread per hardware thread, 1 runs everything on
+    // the calling thread.
+    SweepAndPrune( UINT ThreadCount = 0 );
+    ~SweepAndPrune();
+
+    // Find all overlapping pairs among pBoxes[0..Count). Pair members are
+    // indices into pBoxes with ProxyA < ProxyB; the overlap test is the same as
+    // IntersectAxisAlignedBoxAxisAlignedBox (touching boxes overlap). The
+    // order of the pairs does not depend on the thread count.
+    VOID FindPairs( const AxisAlignedBox* pBoxes, UINT Count, std::vector<ProxyPair>* pPairs );
+
+    VOID SetThreadCount( UINT ThreadCount );
+
+    // Statistics of the last FindPairs call.
+    UINT GetSortAxis() const;
+    BOOL WasRadixSorted() const;
+    UINT GetInsertionMoves() const;
+
+private:
+    VOID ChooseAxis( const AxisAlignedBox* pBoxes, UINT Count );
+    BOOL InsertionSort( UINT MaxMoves );
+    VOID RadixSort();
+
+    SweepAndPrune( const SweepAndPrune& rhs );
+    SweepAndPrune& operator=( const SweepAndPrune& rhs );
+
+private:
+    UINT m_ThreadCount;
+
+    UINT m_Axis;
+    BOOL m_RadixSorted;
+    UINT m_InsertionMoves;
+
+    // Box indices in sorted order, kept from one call to the next.
+    std::vector<UINT> m_Order;
+
+    // Sort keys (order preserving integer form of the minimum on the sort
+    // axis), in the same order as m_Order, and the radix sort scratch.
+    std::vector<UINT> m_Keys;
+    std::vector<UINT> m_TempKeys;
+    std::vector<UINT> m_TempOrder;
+
+    // Box bounds in sorted order: m_Min[0]/m_Max[0] are on the sort axis.
+    std::vector<FLOAT> m_Min[3];
+    std::vector<FLOAT> m_Max[3];
+
+    // Pairs found by each sweep task.
+    std::vector< std::vector<ProxyPair> > m_TaskPairs;
+};
+
+}; // namespace
+
+#endif
@@ -1,6 +1,7 @@
 #include "TextureMgr.h"
+#include "AssetArchive.h"
 
-TextureMgr::TextureMgr() : md3dDevice(0)
+TextureMgr::TextureMgr() : md3dDevice(0), mArchive(0)
 {
 }
 
@@ -14,9 +15,10 @@ TextureMgr::~TextureMgr()
 	mTextureSRV.clear();
 }
 
-void TextureMgr::Init(ID3D11Device* device)
+void TextureMgr::Init(ID3D11Device* device, const XNA::AssetArchive* archive)
 {
 	md3dDevice = device;
+	mArchive = archive;
 }
 
 ID3D11ShaderResourceView* TextureMgr::CreateTexture(std::wstring filename)
@@ -30,7 +32,27 @@ ID3D11ShaderResourceView* TextureMgr::CreateTexture(std::wstring filename)
 	}
 	else
 	{
-		HR(D3DX11CreateShaderResourceViewFromFile(md3dDevice, filename.c_str(), 0, 0, &srv, 0 ));
+		// Packed textures are decoded straight from the archive mapping.
+		UINT index;
+		const BYTE* data;
+		size_t size;
+		std::vector<BYTE> extracted;
+		char name[MAX_PATH];
+		if( mArchive && WideCharToMultiByte(CP_UTF8, 0, filename.c_str(), -1, name, MAX_PATH, 0, 0) > 0 &&
+			mArchive->Find(name, &index) )
+		{
+			if( !mArchive->GetView(index, &data, &size) )
+			{
+				HR(mArchive->Extract(index, &extracted) ? S_OK : E_FAIL);
+				data = extracted.empty() ? 0 : &extracted[0];
+				size = extracted.size();
+			}
+			HR(D3DX11CreateShaderResourceViewFromMemory(md3dDevice, data, size, 0, 0, &srv, 0 ));
+		}
+		else
+		{
+			HR(D3DX11CreateShaderResourceViewFromFile(md3dDevice, filename.c_str(), 0, 0, &srv, 0 ));
+		}
 
 		mTextureSRV[filename] = srv;
 	}
@@ -4,6 +4,8 @@
 #include "d3dUtil.h"
 #include <map>
 
+namespace XNA { class AssetArchive; }
+
 ///<summary>
 /// Simple texture manager to avoid loading duplicate textures from file.  That can
 /// happen, for example, if multiple meshes reference the same texture filename. 
@@ -14,7 +16,9 @@ public:
 	TextureMgr();
 	~TextureMgr();
 
-	void Init(ID3D11Device* device);
+	// Textures are looked up in archive first (if not NULL), then on disk. The archive must
+	// stay open while textures are created.
+	void Init(ID3D11Device* device, const XNA::AssetArchive* archive = 0);
 
 	ID3D11ShaderResourceView* CreateTexture(std::wstring filename);
 
@@ -24,6 +28,7 @@ private:
 	
 private:
 	ID3D11Device* md3dDevice;
+	const XNA::AssetArchive* mArchive;
 	std::map<std::wstring, ID3D11ShaderResourceView*> mTextureSRV;
 };
 
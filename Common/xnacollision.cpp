@@ -8,9 +8,12 @@
 //-------------------------------------------------------------------------------------
 
 //#include "DXUT.h"
-#include <Windows.h>
 #include <cfloat>
+#include <cmath>
+#include <algorithm>
+#include <vector>
 #include "xnacollision.h"
+#include "ParallelFor.h"
 
 namespace XNA
 {
@@ -38,7 +41,7 @@ static inline BOOL XMVector3AnyTrue( FXMVECTOR V )
     XMVECTOR C;
 
     // Duplicate the fourth element from the first element.
-    C = XMVectorSwizzle( V, 0, 1, 2, 0 );
+    C = XMVectorSwizzle<XM_SWIZZLE_X, XM_SWIZZLE_Y, XM_SWIZZLE_Z, XM_SWIZZLE_X>( V );
 
     return XMComparisonAnyTrue( XMVector4EqualIntR( C, XMVectorTrueInt() ) );
 }
@@ -54,7 +57,7 @@ static inline BOOL XMVector3AllTrue( FXMVECTOR V )
     XMVECTOR C;
 
     // Duplicate the fourth element from the first element.
-    C = XMVectorSwizzle( V, 0, 1, 2, 0 );
+    C = XMVectorSwizzle<XM_SWIZZLE_X, XM_SWIZZLE_Y, XM_SWIZZLE_Z, XM_SWIZZLE_X>( V );
 
     return XMComparisonAllTrue( XMVector4EqualIntR( C, XMVectorTrueInt() ) );
 }
@@ -105,7 +108,7 @@ static inline XMVECTOR TransformPlane( FXMVECTOR Plane, FXMVECTOR Rotation, FXMV
     XMVECTOR Normal = XMVector3Rotate( Plane, Rotation );
     XMVECTOR D = XMVectorSplatW( Plane ) - XMVector3Dot( Normal, Translation );
 
-    return XMVectorInsert( Normal, D, 0, 0, 0, 0, 1 );
+    return XMVectorInsert<0, 0, 0, 0, 1>( Normal, D );
 }
 
 
@@ -164,51 +167,148 @@ static inline XMVECTOR PointOnPlaneInsideTriangle( FXMVECTOR P, FXMVECTOR V0, FX
 
 
 //-----------------------------------------------------------------------------
-// Find the approximate smallest enclosing bounding sphere for a set of 
-// points. Exact computation of the smallest enclosing bounding sphere is 
-// possible but is slower and requires a more complex algorithm.
-// The algorithm is based on  Jack Ritter, "An Efficient Bounding Sphere", 
-// Graphics Gems.
+// Return the point of the triangle (V0, V1, V2) nearest the point P, found
+// from the Voronoi region of the triangle P lies in.
 //-----------------------------------------------------------------------------
-VOID ComputeBoundingSphereFromPoints( Sphere* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride )
+static inline XMVECTOR PointOnTriangleNearestPoint( FXMVECTOR P, FXMVECTOR V0, FXMVECTOR V1, CXMVECTOR V2 )
 {
-    XMASSERT( pOut );
-    XMASSERT( Count > 0 );
-    XMASSERT( pPoints );
+    XMVECTOR E01 = V1 - V0;
+    XMVECTOR E02 = V2 - V0;
+
+    // Vertex region of V0.
+    XMVECTOR P0 = P - V0;
+    FLOAT d1 = XMVectorGetX( XMVector3Dot( E01, P0 ) );
+    FLOAT d2 = XMVectorGetX( XMVector3Dot( E02, P0 ) );
+    if( d1 <= 0.0f && d2 <= 0.0f )
+        return V0;
+
+    // Vertex region of V1.
+    XMVECTOR P1 = P - V1;
+    FLOAT d3 = XMVectorGetX( XMVector3Dot( E01, P1 ) );
+    FLOAT d4 = XMVectorGetX( XMVector3Dot( E02, P1 ) );
+    if( d3 >= 0.0f && d4 <= d3 )
+        return V1;
+
+    // Edge region of V0, V1.
+    FLOAT vc = d1 * d4 - d3 * d2;
+    if( vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f )
+        return V0 + E01 * ( d1 / ( d1 - d3 ) );
+
+    // Vertex region of V2.
+    XMVECTOR P2 = P - V2;
+    FLOAT d5 = XMVectorGetX( XMVector3Dot( E01, P2 ) );
+    FLOAT d6 = XMVectorGetX( XMVector3Dot( E02, P2 ) );
+    if( d6 >= 0.0f && d5 <= d6 )
+        return V2;
+
+    // Edge region of V0, V2.
+    FLOAT vb = d5 * d2 - d1 * d6;
+    if( vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f )
+        return V0 + E02 * ( d2 / ( d2 - d6 ) );
+
+    // Edge region of V1, V2.
+    FLOAT va = d3 * d6 - d5 * d4;
+    if( va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f )
+        return V1 + ( V2 - V1 ) * ( ( d4 - d3 ) / ( ( d4 - d3 ) + ( d5 - d6 ) ) );
+
+    // Inside the face.
+    FLOAT Denom = 1.0f / ( va + vb + vc );
+    return V0 + E01 * ( vb * Denom ) + E02 * ( vc * Denom );
+}
 
-    // Find the points with minimum and maximum x, y, and z
+
+
+//-----------------------------------------------------------------------------
+// Smallest root of A t^2 + B t + C = 0 (A > 0) if it is in [0, MaxT].
+//-----------------------------------------------------------------------------
+static inline BOOL SmallestRootInRange( FLOAT A, FLOAT B, FLOAT C, FLOAT MaxT, FLOAT* pRoot )
+{
+    FLOAT Discriminant = B * B - 4.0f * A * C;
+    if( Discriminant < 0.0f )
+        return FALSE;
+
+    FLOAT t = ( -B - sqrtf( Discriminant ) ) / ( 2.0f * A );
+    if( t < 0.0f || t > MaxT )
+        return FALSE;
+
+    *pRoot = t;
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Bounding volume construction helpers. Each one works on the points
+// [Begin, End) of a strided array, so the serial functions run them over the
+// whole array and the parallel ones over one block per task.
+//-----------------------------------------------------------------------------
+
+// Blocks smaller than this are not worth a thread.
+static const UINT MinPointsPerTask = 64 * 1024;
+
+
+
+static inline XMVECTOR LoadPoint( const XMFLOAT3* pPoints, UINT Stride, UINT i )
+{
+    return XMLoadFloat3( ( const XMFLOAT3* )( ( const BYTE* )pPoints + ( size_t )i * Stride ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Find the points with minimum and maximum x, y and z, stored as MinX, MaxX,
+// MinY, MaxY, MinZ, MaxZ. Ties keep the first point. All three axes are
+// compared at once and the points are picked with selects, so the loop has no
+// data dependent branches.
+//-----------------------------------------------------------------------------
+static VOID FindExtremePoints( const XMFLOAT3* pPoints, UINT Stride, UINT Begin, UINT End, XMVECTOR* pExtremes )
+{
     XMVECTOR MinX, MaxX, MinY, MaxY, MinZ, MaxZ;
 
-    MinX = MaxX = MinY = MaxY = MinZ = MaxZ = XMLoadFloat3( pPoints );
+    MinX = MaxX = MinY = MaxY = MinZ = MaxZ = LoadPoint( pPoints, Stride, Begin );
 
-    for( UINT i = 1; i < Count; i++ )
+    // The x of MinX, the y of MinY and the z of MinZ (and the same for max).
+    XMVECTOR vMin = MinX;
+    XMVECTOR vMax = MaxX;
+
+    for( UINT i = Begin + 1; i < End; i++ )
     {
-        XMVECTOR Point = XMLoadFloat3( ( XMFLOAT3* )( ( BYTE* )pPoints + i * Stride ) );
+        XMVECTOR Point = LoadPoint( pPoints, Stride, i );
 
-        float px = XMVectorGetX( Point );
-        float py = XMVectorGetY( Point );
-        float pz = XMVectorGetZ( Point );
+        XMVECTOR Less = XMVectorLess( Point, vMin );
+        XMVECTOR Greater = XMVectorGreater( Point, vMax );
 
-        if( px < XMVectorGetX( MinX ) )
-            MinX = Point;
+        MinX = XMVectorSelect( MinX, Point, XMVectorSplatX( Less ) );
+        MinY = XMVectorSelect( MinY, Point, XMVectorSplatY( Less ) );
+        MinZ = XMVectorSelect( MinZ, Point, XMVectorSplatZ( Less ) );
 
-        if( px > XMVectorGetX( MaxX ) )
-            MaxX = Point;
+        MaxX = XMVectorSelect( MaxX, Point, XMVectorSplatX( Greater ) );
+        MaxY = XMVectorSelect( MaxY, Point, XMVectorSplatY( Greater ) );
+        MaxZ = XMVectorSelect( MaxZ, Point, XMVectorSplatZ( Greater ) );
 
-        if( py < XMVectorGetY( MinY ) )
-            MinY = Point;
+        vMin = XMVectorSelect( vMin, Point, Less );
+        vMax = XMVectorSelect( vMax, Point, Greater );
+    }
+
+    pExtremes[0] = MinX;
+    pExtremes[1] = MaxX;
+    pExtremes[2] = MinY;
+    pExtremes[3] = MaxY;
+    pExtremes[4] = MinZ;
+    pExtremes[5] = MaxZ;
+}
 
-        if( py > XMVectorGetY( MaxY ) )
-            MaxY = Point;
 
-        if( pz < XMVectorGetZ( MinZ ) )
-            MinZ = Point;
 
-        if( pz > XMVectorGetZ( MaxZ ) )
-            MaxZ = Point;
-    }
+//-----------------------------------------------------------------------------
+// Use the min/max pair that are farthest apart to form the initial sphere.
+//-----------------------------------------------------------------------------
+static VOID InitialSphereFromExtremePoints( const XMVECTOR* pExtremes, XMVECTOR* pCenter, XMVECTOR* pRadius )
+{
+    XMVECTOR MinX = pExtremes[0], MaxX = pExtremes[1];
+    XMVECTOR MinY = pExtremes[2], MaxY = pExtremes[3];
+    XMVECTOR MinZ = pExtremes[4], MaxZ = pExtremes[5];
 
-    // Use the min/max pair that are farthest apart to form the initial sphere.
     XMVECTOR DeltaX = MaxX - MinX;
     XMVECTOR DistX = XMVector3Length( DeltaX );
 
@@ -218,22 +318,19 @@ VOID ComputeBoundingSphereFromPoints( Sphere* pOut, UINT Count, const XMFLOAT3*
     XMVECTOR DeltaZ = MaxZ - MinZ;
     XMVECTOR DistZ = XMVector3Length( DeltaZ );
 
-    XMVECTOR Center;
-    XMVECTOR Radius;
-
     if( XMVector3Greater( DistX, DistY ) )
     {
         if( XMVector3Greater( DistX, DistZ ) )
         {
             // Use min/max x.
-            Center = ( MaxX + MinX ) * 0.5f;
-            Radius = DistX * 0.5f;
+            *pCenter = ( MaxX + MinX ) * 0.5f;
+            *pRadius = DistX * 0.5f;
         }
         else
         {
             // Use min/max z.
-            Center = ( MaxZ + MinZ ) * 0.5f;
-            Radius = DistZ * 0.5f;
+            *pCenter = ( MaxZ + MinZ ) * 0.5f;
+            *pRadius = DistZ * 0.5f;
         }
     }
     else // Y >= X
@@ -241,34 +338,233 @@ VOID ComputeBoundingSphereFromPoints( Sphere* pOut, UINT Count, const XMFLOAT3*
         if( XMVector3Greater( DistY, DistZ ) )
         {
             // Use min/max y.
-            Center = ( MaxY + MinY ) * 0.5f;
-            Radius = DistY * 0.5f;
+            *pCenter = ( MaxY + MinY ) * 0.5f;
+            *pRadius = DistY * 0.5f;
         }
         else
         {
             // Use min/max z.
-            Center = ( MaxZ + MinZ ) * 0.5f;
-            Radius = DistZ * 0.5f;
+            *pCenter = ( MaxZ + MinZ ) * 0.5f;
+            *pRadius = DistZ * 0.5f;
         }
     }
+}
 
-    // Add any points not inside the sphere.
-    for( UINT i = 0; i < Count; i++ )
+
+
+//-----------------------------------------------------------------------------
+// Grow the sphere to include any points not inside it. Most points are inside,
+// so they are tested against the squared radius and the square root is only
+// taken for the few that are not.
+//-----------------------------------------------------------------------------
+static VOID GrowSphere( const XMFLOAT3* pPoints, UINT Stride, UINT Begin, UINT End,
+                        XMVECTOR* pCenter, XMVECTOR* pRadius )
+{
+    XMVECTOR Center = *pCenter;
+    XMVECTOR Radius = *pRadius;
+    XMVECTOR RadiusSq = Radius * Radius;
+
+    for( UINT i = Begin; i < End; i++ )
     {
-        XMVECTOR Point = XMLoadFloat3( ( XMFLOAT3* )( ( BYTE* )pPoints + i * Stride ) );
+        XMVECTOR Point = LoadPoint( pPoints, Stride, i );
 
         XMVECTOR Delta = Point - Center;
 
-        XMVECTOR Dist = XMVector3Length( Delta );
+        XMVECTOR DistSq = XMVector3LengthSq( Delta );
 
-        if( XMVector3Greater( Dist, Radius ) )
+        if( XMVector3Greater( DistSq, RadiusSq ) )
         {
-            // Adjust sphere to include the new point.
-            Radius = ( Radius + Dist ) * 0.5f;
-            Center += ( XMVectorReplicate( 1.0f ) - Radius * XMVectorReciprocal( Dist ) ) * Delta;
+            XMVECTOR Dist = XMVectorSqrt( DistSq );
+
+            if( XMVector3Greater( Dist, Radius ) )
+            {
+                // Adjust sphere to include the new point.
+                Radius = ( Radius + Dist ) * 0.5f;
+                Center += ( XMVectorReplicate( 1.0f ) - Radius * XMVectorReciprocal( Dist ) ) * Delta;
+                RadiusSq = Radius * Radius;
+            }
         }
     }
 
+    *pCenter = Center;
+    *pRadius = Radius;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Grow sphere A (center and radius splatted in all components) to enclose
+// sphere B.
+//-----------------------------------------------------------------------------
+static VOID MergeSpheres( XMVECTOR* pCenterA, XMVECTOR* pRadiusA, FXMVECTOR CenterB, FXMVECTOR RadiusB )
+{
+    XMVECTOR Delta = CenterB - *pCenterA;
+    XMVECTOR Dist = XMVector3Length( Delta );
+
+    // B inside A.
+    if( XMVector3LessOrEqual( Dist + RadiusB, *pRadiusA ) )
+        return;
+
+    // A inside B.
+    if( XMVector3LessOrEqual( Dist + *pRadiusA, RadiusB ) )
+    {
+        *pCenterA = CenterB;
+        *pRadiusA = RadiusB;
+        return;
+    }
+
+    XMVECTOR Radius = ( *pRadiusA + Dist + RadiusB ) * 0.5f;
+    *pCenterA += Delta * ( ( Radius - *pRadiusA ) * XMVectorReciprocal( Dist ) );
+    *pRadiusA = Radius;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Componentwise minimum and maximum of the points. Two pairs of accumulators
+// are used so consecutive points do not wait on each other.
+//-----------------------------------------------------------------------------
+static VOID FindMinMax( const XMFLOAT3* pPoints, UINT Stride, UINT Begin, UINT End,
+                        XMVECTOR* pMin, XMVECTOR* pMax )
+{
+    XMVECTOR vMin0, vMax0, vMin1, vMax1;
+
+    vMin0 = vMax0 = vMin1 = vMax1 = LoadPoint( pPoints, Stride, Begin );
+
+    UINT i = Begin + 1;
+
+    for( ; i + 1 < End; i += 2 )
+    {
+        XMVECTOR Point0 = LoadPoint( pPoints, Stride, i );
+        XMVECTOR Point1 = LoadPoint( pPoints, Stride, i + 1 );
+
+        vMin0 = XMVectorMin( vMin0, Point0 );
+        vMax0 = XMVectorMax( vMax0, Point0 );
+        vMin1 = XMVectorMin( vMin1, Point1 );
+        vMax1 = XMVectorMax( vMax1, Point1 );
+    }
+
+    if( i < End )
+    {
+        XMVECTOR Point = LoadPoint( pPoints, Stride, i );
+
+        vMin0 = XMVectorMin( vMin0, Point );
+        vMax0 = XMVectorMax( vMax0, Point );
+    }
+
+    *pMin = XMVectorMin( vMin0, vMin1 );
+    *pMax = XMVectorMax( vMax0, vMax1 );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Same as FindMinMax, on the points rotated by R.
+//-----------------------------------------------------------------------------
+static VOID FindRotatedMinMax( const XMFLOAT3* pPoints, UINT Stride, UINT Begin, UINT End,
+                               CXMMATRIX R, XMVECTOR* pMin, XMVECTOR* pMax )
+{
+    XMVECTOR vMin0, vMax0, vMin1, vMax1;
+
+    vMin0 = vMax0 = vMin1 = vMax1 = XMVector3TransformNormal( LoadPoint( pPoints, Stride, Begin ), R );
+
+    UINT i = Begin + 1;
+
+    for( ; i + 1 < End; i += 2 )
+    {
+        XMVECTOR Point0 = XMVector3TransformNormal( LoadPoint( pPoints, Stride, i ), R );
+        XMVECTOR Point1 = XMVector3TransformNormal( LoadPoint( pPoints, Stride, i + 1 ), R );
+
+        vMin0 = XMVectorMin( vMin0, Point0 );
+        vMax0 = XMVectorMax( vMax0, Point0 );
+        vMin1 = XMVectorMin( vMin1, Point1 );
+        vMax1 = XMVectorMax( vMax1, Point1 );
+    }
+
+    if( i < End )
+    {
+        XMVECTOR Point = XMVector3TransformNormal( LoadPoint( pPoints, Stride, i ), R );
+
+        vMin0 = XMVectorMin( vMin0, Point );
+        vMax0 = XMVectorMax( vMax0, Point );
+    }
+
+    *pMin = XMVectorMin( vMin0, vMin1 );
+    *pMax = XMVectorMax( vMax0, vMax1 );
+}
+
+
+
+//-----------------------------------------------------------------------------
+static XMVECTOR SumPoints( const XMFLOAT3* pPoints, UINT Stride, UINT Begin, UINT End )
+{
+    XMVECTOR Sum = XMVectorZero();
+
+    for( UINT i = Begin; i < End; i++ )
+        Sum += LoadPoint( pPoints, Stride, i );
+
+    return Sum;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Sum of the squares (xx, yy, zz) and of the cross products (xy, xz, yz) of
+// the points relative to Center. Unlike the min/max loops this one keeps a
+// single accumulator: the eigenvector solve is sensitive to round off, so the
+// points are added in the same order as before.
+//-----------------------------------------------------------------------------
+static VOID SumCovariance( const XMFLOAT3* pPoints, UINT Stride, UINT Begin, UINT End, FXMVECTOR Center,
+                           XMVECTOR* pXX_YY_ZZ, XMVECTOR* pXY_XZ_YZ )
+{
+    XMVECTOR XX_YY_ZZ = XMVectorZero();
+    XMVECTOR XY_XZ_YZ = XMVectorZero();
+
+    for( UINT i = Begin; i < End; i++ )
+    {
+        XMVECTOR Point = LoadPoint( pPoints, Stride, i ) - Center;
+
+        XX_YY_ZZ += Point * Point;
+
+        XMVECTOR XXY = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_0W>( Point, Point );
+        XMVECTOR YZZ = XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0Z, XM_PERMUTE_0Z, XM_PERMUTE_0W>( Point, Point );
+
+        XY_XZ_YZ += XXY * YZZ;
+    }
+
+    *pXX_YY_ZZ = XX_YY_ZZ;
+    *pXY_XZ_YZ = XY_XZ_YZ;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Find the approximate smallest enclosing bounding sphere for a set of 
+// points. Exact computation of the smallest enclosing bounding sphere is 
+// possible but is slower and requires a more complex algorithm (see
+// ComputeMinimumBoundingSphereFromPoints).
+// The algorithm is based on  Jack Ritter, "An Efficient Bounding Sphere", 
+// Graphics Gems.
+//-----------------------------------------------------------------------------
+VOID ComputeBoundingSphereFromPoints( Sphere* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride )
+{
+    XMASSERT( pOut );
+    XMASSERT( Count > 0 );
+    XMASSERT( pPoints );
+
+    // Find the points with minimum and maximum x, y, and z
+    XMVECTOR Extremes[6];
+
+    FindExtremePoints( pPoints, Stride, 0, Count, Extremes );
+
+    XMVECTOR Center;
+    XMVECTOR Radius;
+
+    InitialSphereFromExtremePoints( Extremes, &Center, &Radius );
+
+    // Add any points not inside the sphere.
+    GrowSphere( pPoints, Stride, 0, Count, &Center, &Radius );
+
     XMStoreFloat3( &pOut->Center, Center );
     XMStoreFloat( &pOut->Radius, Radius );
 
@@ -289,15 +585,7 @@ VOID ComputeBoundingAxisAlignedBoxFromPoints( AxisAlignedBox* pOut, UINT Count,
     // Find the minimum and maximum x, y, and z
     XMVECTOR vMin, vMax;
 
-    vMin = vMax = XMLoadFloat3( pPoints );
-
-    for( UINT i = 1; i < Count; i++ )
-    {
-        XMVECTOR Point = XMLoadFloat3( ( XMFLOAT3* )( ( BYTE* )pPoints + i * Stride ) );
-
-        vMin = XMVectorMin( vMin, Point );
-        vMax = XMVectorMax( vMax, Point );
-    }
+    FindMinMax( pPoints, Stride, 0, Count, &vMin, &vMax );
 
     // Store center and extents.
     XMStoreFloat3( &pOut->Center, ( vMin + vMax ) * 0.5f );
@@ -549,61 +837,11 @@ static inline BOOL CalculateEigenVectorsFromCovarianceMatrix( FLOAT Cxx, FLOAT C
 
 
 //-----------------------------------------------------------------------------
-// Find the approximate minimum oriented bounding box containing a set of 
-// points.  Exact computation of minimum oriented bounding box is possible but 
-// is slower and requires a more complex algorithm.
-// The algorithm works by computing the inertia tensor of the points and then
-// using the eigenvectors of the intertia tensor as the axes of the box.
-// Computing the intertia tensor of the convex hull of the points will usually 
-// result in better bounding box but the computation is more complex. 
-// Exact computation of the minimum oriented bounding box is possible but the
-// best know algorithm is O(N^3) and is significanly more complex to implement.
+// Orientation of the box from the sums of SumCovariance: the eigenvectors of
+// the covariance matrix, as a normalized quaternion.
 //-----------------------------------------------------------------------------
-VOID ComputeBoundingOrientedBoxFromPoints( OrientedBox* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride )
+static XMVECTOR OrientationFromCovariance( FXMVECTOR XX_YY_ZZ, FXMVECTOR XY_XZ_YZ )
 {
-    static CONST XMVECTORI32 PermuteXXY =
-                 {
-                    XM_PERMUTE_0X, XM_PERMUTE_0X, XM_PERMUTE_0Y, XM_PERMUTE_0W
-                 };
-    static CONST XMVECTORI32 PermuteYZZ =
-                 {
-                    XM_PERMUTE_0Y, XM_PERMUTE_0Z, XM_PERMUTE_0Z, XM_PERMUTE_0W
-                 };
-
-    XMASSERT( pOut );
-    XMASSERT( Count > 0 );
-    XMASSERT( pPoints );
-
-    XMVECTOR CenterOfMass = XMVectorZero();
-
-    // Compute the center of mass and inertia tensor of the points.
-    for( UINT i = 0; i < Count; i++ )
-    {
-        XMVECTOR Point = XMLoadFloat3( ( XMFLOAT3* )( ( BYTE* )pPoints + i * Stride ) );
-
-        CenterOfMass += Point;
-    }
-
-    CenterOfMass *= XMVectorReciprocal( XMVectorReplicate( FLOAT( Count ) ) );
-
-    // Compute the inertia tensor of the points around the center of mass.
-    // Using the center of mass is not strictly necessary, but will hopefully
-    // improve the stability of finding the eigenvectors.
-    XMVECTOR XX_YY_ZZ = XMVectorZero();
-    XMVECTOR XY_XZ_YZ = XMVectorZero();
-
-    for( UINT i = 0; i < Count; i++ )
-    {
-        XMVECTOR Point = XMLoadFloat3( ( XMFLOAT3* )( ( BYTE* )pPoints + i * Stride ) ) - CenterOfMass;
-
-        XX_YY_ZZ += Point * Point;
-
-        XMVECTOR XXY = XMVectorPermute( Point, Point, PermuteXXY );
-        XMVECTOR YZZ = XMVectorPermute( Point, Point, PermuteYZZ );
-
-        XY_XZ_YZ += XXY * YZZ;
-    }
-
     XMVECTOR v1, v2, v3;
 
     // Compute the eigenvectors of the inertia tensor.
@@ -629,42 +867,26 @@ VOID ComputeBoundingOrientedBoxFromPoints( OrientedBox* pOut, UINT Count, const
 
     if( XMVector4Less( Det, XMVectorZero() ) )
     {
-        const XMVECTORF32 VectorNegativeOne =
-        {
-            -1.0f, -1.0f, -1.0f, -1.0f
-        };
-
-        R.r[0] *= VectorNegativeOne;
-        R.r[1] *= VectorNegativeOne;
-        R.r[2] *= VectorNegativeOne;
+        R.r[0] = XMVectorNegate( R.r[0] );
+        R.r[1] = XMVectorNegate( R.r[1] );
+        R.r[2] = XMVectorNegate( R.r[2] );
     }
 
     // Get the rotation quaternion from the matrix.
     XMVECTOR Orientation = XMQuaternionRotationMatrix( R );
 
     // Make sure it is normal (in case the vectors are slightly non-orthogonal).
-    Orientation = XMQuaternionNormalize( Orientation );
-
-    // Rebuild the rotation matrix from the quaternion.
-    R = XMMatrixRotationQuaternion( Orientation );
-
-    // Build the rotation into the rotated space.
-    XMMATRIX InverseR = XMMatrixTranspose( R );
-
-    // Find the minimum OBB using the eigenvectors as the axes.
-    XMVECTOR vMin, vMax;
-
-    vMin = vMax = XMVector3TransformNormal( XMLoadFloat3( pPoints ), InverseR );
+    return XMQuaternionNormalize( Orientation );
+}
 
-    for( UINT i = 1; i < Count; i++ )
-    {
-        XMVECTOR Point = XMVector3TransformNormal( XMLoadFloat3( ( XMFLOAT3* )( ( BYTE* )pPoints + i * Stride ) ),
-                                                   InverseR );
 
-        vMin = XMVectorMin( vMin, Point );
-        vMax = XMVectorMax( vMax, Point );
-    }
 
+//-----------------------------------------------------------------------------
+// Store the box spanned by vMin and vMax in the rotated space of R.
+//-----------------------------------------------------------------------------
+static VOID StoreOrientedBox( OrientedBox* pOut, FXMVECTOR Orientation, FXMVECTOR vMin, FXMVECTOR vMax,
+                              CXMMATRIX R )
+{
     // Rotate the center into world space.
     XMVECTOR Center = ( vMin + vMax ) * 0.5f;
     Center = XMVector3TransformNormal( Center, R );
@@ -673,66 +895,60 @@ VOID ComputeBoundingOrientedBoxFromPoints( OrientedBox* pOut, UINT Count, const
     XMStoreFloat3( &pOut->Center, Center );
     XMStoreFloat3( &pOut->Extents, ( vMax - vMin ) * 0.5f );
     XMStoreFloat4( &pOut->Orientation, Orientation );
-
-    return;
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Build a frustum from a persepective projection matrix.  The matrix may only
-// contain a projection; any rotation, translation or scale will cause the
-// constructed frustum to be incorrect.
+// Find the approximate minimum oriented bounding box containing a set of 
+// points.  Exact computation of minimum oriented bounding box is possible but 
+// is slower and requires a more complex algorithm.
+// The algorithm works by computing the inertia tensor of the points and then
+// using the eigenvectors of the intertia tensor as the axes of the box.
+// Computing the intertia tensor of the convex hull of the points will usually 
+// result in better bounding box but the computation is more complex. 
+// Exact computation of the minimum oriented bounding box is possible but the
+// best know algorithm is O(N^3) and is significanly more complex to implement.
 //-----------------------------------------------------------------------------
-VOID ComputeFrustumFromProjection( Frustum* pOut, XMMATRIX* pProjection )
+VOID ComputeBoundingOrientedBoxFromPoints( OrientedBox* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride )
 {
     XMASSERT( pOut );
-    XMASSERT( pProjection );
+    XMASSERT( Count > 0 );
+    XMASSERT( pPoints );
 
-    // Corners of the projection frustum in homogenous space.
-    static XMVECTOR HomogenousPoints[6] =
-    {
-        {  1.0f,  0.0f, 1.0f, 1.0f },   // right (at far plane)
-        { -1.0f,  0.0f, 1.0f, 1.0f },   // left
-        {  0.0f,  1.0f, 1.0f, 1.0f },   // top
-        {  0.0f, -1.0f, 1.0f, 1.0f },   // bottom
+    // Compute the center of mass and inertia tensor of the points.
+    XMVECTOR CenterOfMass = SumPoints( pPoints, Stride, 0, Count );
 
-        { 0.0f, 0.0f, 0.0f, 1.0f },     // near
-        { 0.0f, 0.0f, 1.0f, 1.0f }      // far
-    };
+    XMVECTOR InvCount = XMVectorReciprocal( XMVectorReplicate( FLOAT( Count ) ) );
 
-    XMVECTOR Determinant;
-    XMMATRIX matInverse = XMMatrixInverse( &Determinant, *pProjection );
+    CenterOfMass *= InvCount;
 
-    // Compute the frustum corners in world space.
-    XMVECTOR Points[6];
+    // Compute the inertia tensor of the points around the center of mass.
+    // Using the center of mass is not strictly necessary, but will hopefully
+    // improve the stability of finding the eigenvectors.
+    XMVECTOR XX_YY_ZZ, XY_XZ_YZ;
 
-    for( INT i = 0; i < 6; i++ )
-    {
-        // Transform point.
-        Points[i] = XMVector4Transform( HomogenousPoints[i], matInverse );
-    }
+    SumCovariance( pPoints, Stride, 0, Count, CenterOfMass, &XX_YY_ZZ, &XY_XZ_YZ );
 
-    pOut->Origin = XMFLOAT3( 0.0f, 0.0f, 0.0f );
-    pOut->Orientation = XMFLOAT4( 0.0f, 0.0f, 0.0f, 1.0f );
+    // Average the sums; the eigenvectors do not change, but the cubic solved
+    // for the eigenvalues overflows on the raw sums of a few million points.
+    XX_YY_ZZ *= InvCount;
+    XY_XZ_YZ *= InvCount;
 
-    // Compute the slopes.
-    Points[0] = Points[0] * XMVectorReciprocal( XMVectorSplatZ( Points[0] ) );
-    Points[1] = Points[1] * XMVectorReciprocal( XMVectorSplatZ( Points[1] ) );
-    Points[2] = Points[2] * XMVectorReciprocal( XMVectorSplatZ( Points[2] ) );
-    Points[3] = Points[3] * XMVectorReciprocal( XMVectorSplatZ( Points[3] ) );
+    XMVECTOR Orientation = OrientationFromCovariance( XX_YY_ZZ, XY_XZ_YZ );
 
-    pOut->RightSlope = XMVectorGetX( Points[0] );
-    pOut->LeftSlope = XMVectorGetX( Points[1] );
-    pOut->TopSlope = XMVectorGetY( Points[2] );
-    pOut->BottomSlope = XMVectorGetY( Points[3] );
+    // Rebuild the rotation matrix from the quaternion.
+    XMMATRIX R = XMMatrixRotationQuaternion( Orientation );
 
-    // Compute near and far.
-    Points[4] = Points[4] * XMVectorReciprocal( XMVectorSplatW( Points[4] ) );
-    Points[5] = Points[5] * XMVectorReciprocal( XMVectorSplatW( Points[5] ) );
+    // Build the rotation into the rotated space.
+    XMMATRIX InverseR = XMMatrixTranspose( R );
 
-    pOut->Near = XMVectorGetZ( Points[4] );
-    pOut->Far = XMVectorGetZ( Points[5] );
+    // Find the minimum OBB using the eigenvectors as the axes.
+    XMVECTOR vMin, vMax;
+
+    FindRotatedMinMax( pPoints, Stride, 0, Count, InverseR, &vMin, &vMax );
+
+    StoreOrientedBox( pOut, Orientation, vMin, vMax, R );
 
     return;
 }
@@ -740,3089 +956,4916 @@ VOID ComputeFrustumFromProjection( Frustum* pOut, XMMATRIX* pProjection )
 
 
 //-----------------------------------------------------------------------------
-// Build the 6 frustum planes from a frustum.
+// Parallel versions of the bounding volume construction. Every pass over the
+// points is split into one block per task and the per task results are
+// merged in task order, so the result does not depend on thread timing. The
+// per task results are kept as floats because a std::vector of XMVECTOR is
+// not guaranteed to be aligned.
 //-----------------------------------------------------------------------------
-VOID ComputePlanesFromFrustum( const Frustum* pVolume, XMVECTOR* pPlane0, XMVECTOR* pPlane1, XMVECTOR* pPlane2,
-                               XMVECTOR* pPlane3, XMVECTOR* pPlane4, XMVECTOR* pPlane5 )
+static inline FLOAT GetComponent( const XMFLOAT3& v, UINT Axis )
 {
-    XMASSERT( pVolume );
-    XMASSERT( pPlane0 );
-    XMASSERT( pPlane1 );
-    XMASSERT( pPlane2 );
-    XMASSERT( pPlane3 );
-    XMASSERT( pPlane4 );
-    XMASSERT( pPlane5 );
-
-    // Load origin and orientation of the frustum.
-    XMVECTOR Origin = XMLoadFloat3( &pVolume->Origin );
-    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
-
-    // Build the frustum planes.
-    XMVECTOR Plane0 = XMVectorSet( 0.0f, 0.0f, -1.0f, pVolume->Near );
-    XMVECTOR Plane1 = XMVectorSet( 0.0f, 0.0f, 1.0f, -pVolume->Far );
-    XMVECTOR Plane2 = XMVectorSet( 1.0f, 0.0f, -pVolume->RightSlope, 0.0f );
-    XMVECTOR Plane3 = XMVectorSet( -1.0f, 0.0f, pVolume->LeftSlope, 0.0f );
-    XMVECTOR Plane4 = XMVectorSet( 0.0f, 1.0f, -pVolume->TopSlope, 0.0f );
-    XMVECTOR Plane5 = XMVectorSet( 0.0f, -1.0f, pVolume->BottomSlope, 0.0f );
-
-    Plane0 = TransformPlane( Plane0, Orientation, Origin );
-    Plane1 = TransformPlane( Plane1, Orientation, Origin );
-    Plane2 = TransformPlane( Plane2, Orientation, Origin );
-    Plane3 = TransformPlane( Plane3, Orientation, Origin );
-    Plane4 = TransformPlane( Plane4, Orientation, Origin );
-    Plane5 = TransformPlane( Plane5, Orientation, Origin );
-
-    *pPlane0 = XMPlaneNormalize( Plane0 );
-    *pPlane1 = XMPlaneNormalize( Plane1 );
-    *pPlane2 = XMPlaneNormalize( Plane2 );
-    *pPlane3 = XMPlaneNormalize( Plane3 );
-    *pPlane4 = XMPlaneNormalize( Plane4 );
-    *pPlane5 = XMPlaneNormalize( Plane5 );
+    return ( &v.x )[Axis];
 }
 
 
 
-//-----------------------------------------------------------------------------
-// Transform a sphere by an angle preserving transform.
-//-----------------------------------------------------------------------------
-VOID TransformSphere( Sphere* pOut, const Sphere* pIn, FLOAT Scale, FXMVECTOR Rotation, FXMVECTOR Translation )
+VOID ComputeBoundingSphereFromPointsParallel( Sphere* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride,
+                                              UINT ThreadCount )
 {
     XMASSERT( pOut );
-    XMASSERT( pIn );
-    XMASSERT( XMQuaternionIsUnit( Rotation ) );
-
-    // Load the center of the sphere.
-    XMVECTOR Center = XMLoadFloat3( &pIn->Center );
+    XMASSERT( Count > 0 );
+    XMASSERT( pPoints );
 
-    // Transform the center of the sphere.
-    Center = XMVector3Rotate( Center * XMVectorReplicate( Scale ), Rotation ) + Translation;
+    UINT TaskCount = GetParallelTaskCount( Count, ThreadCount, MinPointsPerTask );
 
-    // Store the center sphere.
-    XMStoreFloat3( &pOut->Center, Center );
+    if( TaskCount <= 1 )
+    {
+        ComputeBoundingSphereFromPoints( pOut, Count, pPoints, Stride );
+        return;
+    }
 
-    // Scale the radius of the pshere.
-    pOut->Radius = pIn->Radius * Scale;
+    // Find the points with minimum and maximum x, y, and z of each block.
+    std::vector<XMFLOAT3> TaskExtremes( TaskCount * 6 );
 
-    return;
-}
+    ParallelFor( Count, ThreadCount, MinPointsPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        XMVECTOR Extremes[6];
+        FindExtremePoints( pPoints, Stride, Begin, End, Extremes );
 
+        for( UINT j = 0; j < 6; j++ )
+            XMStoreFloat3( &TaskExtremes[Task * 6 + j], Extremes[j] );
+    } );
 
+    // Earlier blocks win ties, which gives the same points as the serial loop.
+    XMFLOAT3 Extremes3[6];
 
-//-----------------------------------------------------------------------------
-// Transform an axis aligned box by an angle preserving transform.
-//-----------------------------------------------------------------------------
-VOID TransformAxisAlignedBox( AxisAlignedBox* pOut, const AxisAlignedBox* pIn, FLOAT Scale, FXMVECTOR Rotation,
-                              FXMVECTOR Translation )
-{
-    XMASSERT( pOut );
-    XMASSERT( pIn );
-    XMASSERT( XMQuaternionIsUnit( Rotation ) );
+    for( UINT j = 0; j < 6; j++ )
+        Extremes3[j] = TaskExtremes[j];
 
-    static XMVECTOR Offset[8] =
+    for( UINT t = 1; t < TaskCount; t++ )
     {
-        { -1.0f, -1.0f, -1.0f, 0.0f },
-        { -1.0f, -1.0f,  1.0f, 0.0f },
-        { -1.0f,  1.0f, -1.0f, 0.0f },
-        { -1.0f,  1.0f,  1.0f, 0.0f },
-        {  1.0f, -1.0f, -1.0f, 0.0f },
-        {  1.0f, -1.0f,  1.0f, 0.0f },
-        {  1.0f,  1.0f, -1.0f, 0.0f },
-        {  1.0f,  1.0f,  1.0f, 0.0f }
-    };
+        const XMFLOAT3* pTask = &TaskExtremes[t * 6];
 
-    // Load center and extents.
-    XMVECTOR Center = XMLoadFloat3( &pIn->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pIn->Extents );
+        for( UINT Axis = 0; Axis < 3; Axis++ )
+        {
+            if( GetComponent( pTask[Axis * 2], Axis ) < GetComponent( Extremes3[Axis * 2], Axis ) )
+                Extremes3[Axis * 2] = pTask[Axis * 2];
 
-    XMVECTOR VectorScale = XMVectorReplicate( Scale );
+            if( GetComponent( pTask[Axis * 2 + 1], Axis ) > GetComponent( Extremes3[Axis * 2 + 1], Axis ) )
+                Extremes3[Axis * 2 + 1] = pTask[Axis * 2 + 1];
+        }
+    }
 
-    // Compute and transform the corners and find new min/max bounds.
-    XMVECTOR Corner = Center + Extents * Offset[0];
-    Corner = XMVector3Rotate( Corner * VectorScale, Rotation ) + Translation;
+    XMVECTOR Extremes[6];
 
-    XMVECTOR Min, Max;
-    Min = Max = Corner;
+    for( UINT j = 0; j < 6; j++ )
+        Extremes[j] = XMLoadFloat3( &Extremes3[j] );
 
-    for( INT i = 1; i < 8; i++ )
+    XMVECTOR Center;
+    XMVECTOR Radius;
+
+    InitialSphereFromExtremePoints( Extremes, &Center, &Radius );
+
+    // Every block grows its own copy of the initial sphere, then the block
+    // spheres are merged. The result encloses all the points but can be
+    // slightly larger than the one of the serial version.
+    std::vector<Sphere> TaskSpheres( TaskCount );
+
+    ParallelFor( Count, ThreadCount, MinPointsPerTask, [&]( UINT Begin, UINT End, UINT Task )
     {
-        Corner = Center + Extents * Offset[i];
-        Corner = XMVector3Rotate( Corner * VectorScale, Rotation ) + Translation;
+        XMVECTOR TaskCenter = Center;
+        XMVECTOR TaskRadius = Radius;
 
-        Min = XMVectorMin( Min, Corner );
-        Max = XMVectorMax( Max, Corner );
-    }
+        GrowSphere( pPoints, Stride, Begin, End, &TaskCenter, &TaskRadius );
 
-    // Store center and extents.
-    XMStoreFloat3( &pOut->Center, ( Min + Max ) * 0.5f );
-    XMStoreFloat3( &pOut->Extents, ( Max - Min ) * 0.5f );
+        XMStoreFloat3( &TaskSpheres[Task].Center, TaskCenter );
+        XMStoreFloat( &TaskSpheres[Task].Radius, TaskRadius );
+    } );
 
-    return;
+    Center = XMLoadFloat3( &TaskSpheres[0].Center );
+    Radius = XMVectorReplicate( TaskSpheres[0].Radius );
+
+    for( UINT t = 1; t < TaskCount; t++ )
+        MergeSpheres( &Center, &Radius, XMLoadFloat3( &TaskSpheres[t].Center ),
+                      XMVectorReplicate( TaskSpheres[t].Radius ) );
+
+    XMStoreFloat3( &pOut->Center, Center );
+    XMStoreFloat( &pOut->Radius, Radius );
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Transform an oriented box by an angle preserving transform.
+// Same result as ComputeBoundingAxisAlignedBoxFromPoints.
 //-----------------------------------------------------------------------------
-VOID TransformOrientedBox( OrientedBox* pOut, const OrientedBox* pIn, FLOAT Scale, FXMVECTOR Rotation,
-                           FXMVECTOR Translation )
+VOID ComputeBoundingAxisAlignedBoxFromPointsParallel( AxisAlignedBox* pOut, UINT Count, const XMFLOAT3* pPoints,
+                                                      UINT Stride, UINT ThreadCount )
 {
     XMASSERT( pOut );
-    XMASSERT( pIn );
-    XMASSERT( XMQuaternionIsUnit( Rotation ) );
+    XMASSERT( Count > 0 );
+    XMASSERT( pPoints );
 
-    // Load the box.
-    XMVECTOR Center = XMLoadFloat3( &pIn->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pIn->Extents );
-    XMVECTOR Orientation = XMLoadFloat4( &pIn->Orientation );
+    UINT TaskCount = GetParallelTaskCount( Count, ThreadCount, MinPointsPerTask );
 
-    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+    if( TaskCount <= 1 )
+    {
+        ComputeBoundingAxisAlignedBoxFromPoints( pOut, Count, pPoints, Stride );
+        return;
+    }
 
-    // Composite the box rotation and the transform rotation.
-    Orientation = XMQuaternionMultiply( Orientation, Rotation );
+    std::vector<XMFLOAT3> TaskMin( TaskCount );
+    std::vector<XMFLOAT3> TaskMax( TaskCount );
 
-    // Transform the center.
-    XMVECTOR VectorScale = XMVectorReplicate( Scale );
-    Center = XMVector3Rotate( Center * VectorScale, Rotation ) + Translation;
+    ParallelFor( Count, ThreadCount, MinPointsPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        XMVECTOR vMin, vMax;
+        FindMinMax( pPoints, Stride, Begin, End, &vMin, &vMax );
 
-    // Scale the box extents.
-    Extents = Extents * VectorScale;
+        XMStoreFloat3( &TaskMin[Task], vMin );
+        XMStoreFloat3( &TaskMax[Task], vMax );
+    } );
 
-    // Store the box.
-    XMStoreFloat3( &pOut->Center, Center );
-    XMStoreFloat3( &pOut->Extents, Extents );
-    XMStoreFloat4( &pOut->Orientation, Orientation );
+    XMVECTOR vMin = XMLoadFloat3( &TaskMin[0] );
+    XMVECTOR vMax = XMLoadFloat3( &TaskMax[0] );
 
-    return;
+    for( UINT t = 1; t < TaskCount; t++ )
+    {
+        vMin = XMVectorMin( vMin, XMLoadFloat3( &TaskMin[t] ) );
+        vMax = XMVectorMax( vMax, XMLoadFloat3( &TaskMax[t] ) );
+    }
+
+    // Store center and extents.
+    XMStoreFloat3( &pOut->Center, ( vMin + vMax ) * 0.5f );
+    XMStoreFloat3( &pOut->Extents, ( vMax - vMin ) * 0.5f );
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Transform a frustum by an angle preserving transform.
+// Same algorithm as ComputeBoundingOrientedBoxFromPoints. The sums are added
+// up in a different order, so the axes can differ in the last bits.
 //-----------------------------------------------------------------------------
-VOID TransformFrustum( Frustum* pOut, const Frustum* pIn, FLOAT Scale, FXMVECTOR Rotation, FXMVECTOR Translation )
+VOID ComputeBoundingOrientedBoxFromPointsParallel( OrientedBox* pOut, UINT Count, const XMFLOAT3* pPoints,
+                                                   UINT Stride, UINT ThreadCount )
 {
     XMASSERT( pOut );
-    XMASSERT( pIn );
-    XMASSERT( XMQuaternionIsUnit( Rotation ) );
+    XMASSERT( Count > 0 );
+    XMASSERT( pPoints );
 
-    // Load the frustum.
-    XMVECTOR Origin = XMLoadFloat3( &pIn->Origin );
-    XMVECTOR Orientation = XMLoadFloat4( &pIn->Orientation );
+    UINT TaskCount = GetParallelTaskCount( Count, ThreadCount, MinPointsPerTask );
 
-    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+    if( TaskCount <= 1 )
+    {
+        ComputeBoundingOrientedBoxFromPoints( pOut, Count, pPoints, Stride );
+        return;
+    }
 
-    // Composite the frustum rotation and the transform rotation.
-    Orientation = XMQuaternionMultiply( Orientation, Rotation );
+    std::vector<XMFLOAT3> TaskA( TaskCount );
+    std::vector<XMFLOAT3> TaskB( TaskCount );
 
-    // Transform the origin.
-    Origin = XMVector3Rotate( Origin * XMVectorReplicate( Scale ), Rotation ) + Translation;
+    // Center of mass.
+    ParallelFor( Count, ThreadCount, MinPointsPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        XMStoreFloat3( &TaskA[Task], SumPoints( pPoints, Stride, Begin, End ) );
+    } );
 
-    // Store the frustum.
-    XMStoreFloat3( &pOut->Origin, Origin );
-    XMStoreFloat4( &pOut->Orientation, Orientation );
+    XMVECTOR CenterOfMass = XMVectorZero();
 
-    // Scale the near and far distances (the slopes remain the same).
-    pOut->Near = pIn->Near * Scale;
-    pOut->Far = pIn->Far * Scale;
+    for( UINT t = 0; t < TaskCount; t++ )
+        CenterOfMass += XMLoadFloat3( &TaskA[t] );
 
-    // Copy the slopes.
-    pOut->RightSlope = pIn->RightSlope;
-    pOut->LeftSlope = pIn->LeftSlope;
-    pOut->TopSlope = pIn->TopSlope;
-    pOut->BottomSlope = pIn->BottomSlope;
+    XMVECTOR InvCount = XMVectorReciprocal( XMVectorReplicate( FLOAT( Count ) ) );
 
-    return;
-}
+    CenterOfMass *= InvCount;
 
+    // Inertia tensor around the center of mass.
+    ParallelFor( Count, ThreadCount, MinPointsPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        XMVECTOR TaskXX_YY_ZZ, TaskXY_XZ_YZ;
+        SumCovariance( pPoints, Stride, Begin, End, CenterOfMass, &TaskXX_YY_ZZ, &TaskXY_XZ_YZ );
 
+        XMStoreFloat3( &TaskA[Task], TaskXX_YY_ZZ );
+        XMStoreFloat3( &TaskB[Task], TaskXY_XZ_YZ );
+    } );
 
-//-----------------------------------------------------------------------------
-// Point in sphere test.
-//-----------------------------------------------------------------------------
-BOOL IntersectPointSphere( FXMVECTOR Point, const Sphere* pVolume )
-{
-    XMASSERT( pVolume );
+    XMVECTOR XX_YY_ZZ = XMVectorZero();
+    XMVECTOR XY_XZ_YZ = XMVectorZero();
 
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
+    for( UINT t = 0; t < TaskCount; t++ )
+    {
+        XX_YY_ZZ += XMLoadFloat3( &TaskA[t] );
+        XY_XZ_YZ += XMLoadFloat3( &TaskB[t] );
+    }
 
-    XMVECTOR DistanceSquared = XMVector3LengthSq( Point - Center );
-    XMVECTOR RadiusSquared = Radius * Radius;
+    XX_YY_ZZ *= InvCount;
+    XY_XZ_YZ *= InvCount;
 
-    return XMVector4LessOrEqual( DistanceSquared, RadiusSquared );
-}
+    XMVECTOR Orientation = OrientationFromCovariance( XX_YY_ZZ, XY_XZ_YZ );
 
+    XMMATRIX R = XMMatrixRotationQuaternion( Orientation );
+    XMMATRIX InverseR = XMMatrixTranspose( R );
 
+    // Extents along the axes.
+    ParallelFor( Count, ThreadCount, MinPointsPerTask, [&]( UINT Begin, UINT End, UINT Task )
+    {
+        XMVECTOR TaskMin, TaskMax;
+        FindRotatedMinMax( pPoints, Stride, Begin, End, InverseR, &TaskMin, &TaskMax );
 
-//-----------------------------------------------------------------------------
-// Point in axis aligned box test.
-//-----------------------------------------------------------------------------
-BOOL IntersectPointAxisAlignedBox( FXMVECTOR Point, const AxisAlignedBox* pVolume )
-{
-    XMASSERT( pVolume );
+        XMStoreFloat3( &TaskA[Task], TaskMin );
+        XMStoreFloat3( &TaskB[Task], TaskMax );
+    } );
 
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
+    XMVECTOR vMin = XMLoadFloat3( &TaskA[0] );
+    XMVECTOR vMax = XMLoadFloat3( &TaskB[0] );
 
-    return XMVector3InBounds( Point - Center, Extents );
+    for( UINT t = 1; t < TaskCount; t++ )
+    {
+        vMin = XMVectorMin( vMin, XMLoadFloat3( &TaskA[t] ) );
+        vMax = XMVectorMax( vMax, XMLoadFloat3( &TaskB[t] ) );
+    }
+
+    StoreOrientedBox( pOut, Orientation, vMin, vMax, R );
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Point in oriented box test.
+// Exact smallest enclosing sphere, computed in double precision.
 //-----------------------------------------------------------------------------
-BOOL IntersectPointOrientedBox( FXMVECTOR Point, const OrientedBox* pVolume )
+struct Double3
 {
-    XMASSERT( pVolume );
+    DOUBLE x, y, z;
+};
 
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
-    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
+struct ExactSphere
+{
+    Double3 Center;
+    DOUBLE RadiusSq;
+};
 
-    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+// Points this much (relative to the squared radius) outside the sphere still
+// count as inside, so round off on the boundary points does not restart the
+// inner loops.
+static const DOUBLE ExactSphereTolerance = 1.0e-10;
 
-    // Transform the point to be local to the box.
-    XMVECTOR TPoint = XMVector3InverseRotate( Point - Center, Orientation );
 
-    return XMVector3InBounds( TPoint, Extents );
+
+static inline Double3 ToDouble3( const XMFLOAT3& P )
+{
+    Double3 Result = { P.x, P.y, P.z };
+    return Result;
 }
 
 
 
-//-----------------------------------------------------------------------------
-// Point in frustum test.
-//-----------------------------------------------------------------------------
-BOOL IntersectPointFrustum( FXMVECTOR Point, const Frustum* pVolume )
+static inline Double3 Subtract( const Double3& A, const Double3& B )
 {
-    static const XMVECTORU32 SelectW = {XM_SELECT_0, XM_SELECT_0, XM_SELECT_0, XM_SELECT_1};
-    static const XMVECTORU32 SelectZ = {XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0};
-
-    static const XMVECTOR BasePlanes[6] = 
-    {
-        {  0.0f,  0.0f, -1.0f, 0.0f },
-        {  0.0f,  0.0f,  1.0f, 0.0f },
-        {  1.0f,  0.0f,  0.0f, 0.0f },
-        { -1.0f,  0.0f,  0.0f, 0.0f },
-        {  0.0f,  1.0f,  0.0f, 0.0f },
-        {  0.0f, -1.0f,  0.0f, 0.0f },
-    };
+    Double3 Result = { A.x - B.x, A.y - B.y, A.z - B.z };
+    return Result;
+}
 
-    XMASSERT( pVolume );
 
-    // Build frustum planes.
-    XMVECTOR Planes[6];
-    Planes[0] = XMVectorSelect( BasePlanes[0], XMVectorSplatX(  XMLoadFloat( &pVolume->Near ) ),
-                                SelectW );
-    Planes[1] = XMVectorSelect( BasePlanes[1], XMVectorSplatX( -XMLoadFloat( &pVolume->Far ) ),
-                                SelectW );
-    Planes[2] = XMVectorSelect( BasePlanes[2], XMVectorSplatX( -XMLoadFloat( &pVolume->RightSlope ) ),
-                                SelectZ );
-    Planes[3] = XMVectorSelect( BasePlanes[3], XMVectorSplatX(  XMLoadFloat( &pVolume->LeftSlope ) ),
-                                SelectZ );
-    Planes[4] = XMVectorSelect( BasePlanes[4], XMVectorSplatX( -XMLoadFloat( &pVolume->TopSlope ) ),
-                                SelectZ );
-    Planes[5] = XMVectorSelect( BasePlanes[5], XMVectorSplatX(  XMLoadFloat( &pVolume->BottomSlope ) ),
-                                SelectZ );
 
-    // Load origin and orientation.
-    XMVECTOR Origin = XMLoadFloat3( &pVolume->Origin );
-    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
+static inline DOUBLE Dot( const Double3& A, const Double3& B )
+{
+    return A.x * B.x + A.y * B.y + A.z * B.z;
+}
 
-    XMASSERT( XMQuaternionIsUnit( Orientation ) );
 
-    // Transform point into local space of frustum.
-    XMVECTOR TPoint = XMVector3InverseRotate( Point - Origin, Orientation );
 
-    // Set w to one.
-    TPoint = XMVectorInsert( TPoint, XMVectorSplatOne(), 0, 0, 0, 0, 1);
+static inline Double3 Cross( const Double3& A, const Double3& B )
+{
+    Double3 Result = { A.y * B.z - A.z * B.y, A.z * B.x - A.x * B.z, A.x * B.y - A.y * B.x };
+    return Result;
+}
 
-    XMVECTOR Zero = XMVectorZero();
-    XMVECTOR Outside = Zero;
 
-    // Test point against each plane of the frustum.
-    for( INT i = 0; i < 6; i++ )
-    {
-        XMVECTOR Dot = XMVector4Dot( TPoint, Planes[i] );
-        Outside = XMVectorOrInt( Outside, XMVectorGreater( Dot, Zero ) );
-    }
 
-    return XMVector4NotEqualInt( Outside, XMVectorTrueInt() );
+static inline BOOL ExactSphereContains( const ExactSphere& S, const XMFLOAT3& P )
+{
+    Double3 Delta = Subtract( ToDouble3( P ), S.Center );
+    return Dot( Delta, Delta ) <= S.RadiusSq * ( 1.0 + ExactSphereTolerance );
 }
 
 
 
-//-----------------------------------------------------------------------------
-// Compute the intersection of a ray (Origin, Direction) with a triangle 
-// (V0, V1, V2).  Return TRUE if there is an intersection and also set *pDist 
-// to the distance along the ray to the intersection.
-// 
-// The algorithm is based on Moller, Tomas and Trumbore, "Fast, Minimum Storage 
-// Ray-Triangle Intersection", Journal of Graphics Tools, vol. 2, no. 1, 
-// pp 21-28, 1997.
-//-----------------------------------------------------------------------------
-BOOL IntersectRayTriangle( FXMVECTOR Origin, FXMVECTOR Direction, FXMVECTOR V0, CXMVECTOR V1, CXMVECTOR V2,
-                           FLOAT* pDist )
+static VOID ExactSphereFrom1( ExactSphere* pOut, const XMFLOAT3& A )
 {
-    XMASSERT( pDist );
-    XMASSERT( XMVector3IsUnit( Direction ) );
+    pOut->Center = ToDouble3( A );
+    pOut->RadiusSq = 0.0;
+}
 
-    static const XMVECTOR Epsilon =
-    {
-        1e-20f, 1e-20f, 1e-20f, 1e-20f
-    };
 
-    XMVECTOR Zero = XMVectorZero();
 
-    XMVECTOR e1 = V1 - V0;
-    XMVECTOR e2 = V2 - V0;
+static VOID ExactSphereFrom2( ExactSphere* pOut, const XMFLOAT3& A, const XMFLOAT3& B )
+{
+    Double3 a = ToDouble3( A );
+    Double3 ab = Subtract( ToDouble3( B ), a );
 
-    // p = Direction ^ e2;
-    XMVECTOR p = XMVector3Cross( Direction, e2 );
+    pOut->Center.x = a.x + ab.x * 0.5;
+    pOut->Center.y = a.y + ab.y * 0.5;
+    pOut->Center.z = a.z + ab.z * 0.5;
+    pOut->RadiusSq = Dot( ab, ab ) * 0.25;
+}
 
-    // det = e1 * p;
-    XMVECTOR det = XMVector3Dot( e1, p );
 
-    XMVECTOR u, v, t;
 
-    if( XMVector3GreaterOrEqual( det, Epsilon ) )
-    {
-        // Determinate is positive (front side of the triangle).
-        XMVECTOR s = Origin - V0;
+//-----------------------------------------------------------------------------
+// Smallest sphere with A, B and C on its surface (the circumcircle). When the
+// points are (nearly) on a line, the sphere of the farthest pair.
+//-----------------------------------------------------------------------------
+static VOID ExactSphereFrom3( ExactSphere* pOut, const XMFLOAT3& A, const XMFLOAT3& B, const XMFLOAT3& C )
+{
+    Double3 a = ToDouble3( A );
+    Double3 u = Subtract( ToDouble3( B ), a );
+    Double3 v = Subtract( ToDouble3( C ), a );
+    Double3 w = Cross( u, v );
 
-        // u = s * p;
-        u = XMVector3Dot( s, p );
+    DOUBLE uu = Dot( u, u );
+    DOUBLE vv = Dot( v, v );
+    DOUBLE ww = Dot( w, w );
 
-        XMVECTOR NoIntersection = XMVectorLess( u, Zero );
-        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( u, det ) );
+    if( ww <= 1.0e-12 * uu * vv )
+    {
+        Double3 bc = Subtract( v, u );
+        DOUBLE bcbc = Dot( bc, bc );
 
-        // q = s ^ e1;
-        XMVECTOR q = XMVector3Cross( s, e1 );
+        if( uu >= vv && uu >= bcbc )
+            ExactSphereFrom2( pOut, A, B );
+        else if( vv >= bcbc )
+            ExactSphereFrom2( pOut, A, C );
+        else
+            ExactSphereFrom2( pOut, B, C );
+        return;
+    }
 
-        // v = Direction * q;
-        v = XMVector3Dot( Direction, q );
+    Double3 vw = Cross( v, w );
+    Double3 wu = Cross( w, u );
+    DOUBLE Scale = 0.5 / ww;
 
-        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( v, Zero ) );
-        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( u + v, det ) );
+    Double3 Offset =
+    {
+        ( uu * vw.x + vv * wu.x ) * Scale,
+        ( uu * vw.y + vv * wu.y ) * Scale,
+        ( uu * vw.z + vv * wu.z ) * Scale
+    };
 
-        // t = e2 * q;
-        t = XMVector3Dot( e2, q );
+    pOut->Center.x = a.x + Offset.x;
+    pOut->Center.y = a.y + Offset.y;
+    pOut->Center.z = a.z + Offset.z;
+    pOut->RadiusSq = Dot( Offset, Offset );
+}
 
-        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( t, Zero ) );
 
-        if( XMVector4EqualInt( NoIntersection, XMVectorTrueInt() ) )
-            return FALSE;
-    }
-    else if( XMVector3LessOrEqual( det, -Epsilon ) )
-    {
-        // Determinate is negative (back side of the triangle).
-        XMVECTOR s = Origin - V0;
 
-        // u = s * p;
-        u = XMVector3Dot( s, p );
+//-----------------------------------------------------------------------------
+// Sphere with A, B, C and D on its surface. When the points are (nearly) on a
+// plane, the smallest circumcircle of three of them that contains the fourth.
+//-----------------------------------------------------------------------------
+static VOID ExactSphereFrom4( ExactSphere* pOut, const XMFLOAT3& A, const XMFLOAT3& B, const XMFLOAT3& C,
+                              const XMFLOAT3& D )
+{
+    Double3 a = ToDouble3( A );
+    Double3 u = Subtract( ToDouble3( B ), a );
+    Double3 v = Subtract( ToDouble3( C ), a );
+    Double3 w = Subtract( ToDouble3( D ), a );
 
-        XMVECTOR NoIntersection = XMVectorGreater( u, Zero );
-        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( u, det ) );
+    DOUBLE uu = Dot( u, u );
+    DOUBLE vv = Dot( v, v );
+    DOUBLE ww = Dot( w, w );
 
-        // q = s ^ e1;
-        XMVECTOR q = XMVector3Cross( s, e1 );
+    Double3 vw = Cross( v, w );
+    DOUBLE Det = Dot( u, vw );
 
-        // v = Direction * q;
-        v = XMVector3Dot( Direction, q );
+    if( Det * Det <= 1.0e-12 * uu * vv * ww )
+    {
+        const XMFLOAT3* pTriangles[4][4] =
+        {
+            { &A, &B, &C, &D },
+            { &A, &B, &D, &C },
+            { &A, &C, &D, &B },
+            { &B, &C, &D, &A },
+        };
 
-        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( v, Zero ) );
-        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( u + v, det ) );
+        BOOL Found = FALSE;
 
-        // t = e2 * q;
-        t = XMVector3Dot( e2, q );
+        for( UINT i = 0; i < 4; i++ )
+        {
+            ExactSphere S;
+            ExactSphereFrom3( &S, *pTriangles[i][0], *pTriangles[i][1], *pTriangles[i][2] );
 
-        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( t, Zero ) );
+            if( !ExactSphereContains( S, *pTriangles[i][3] ) )
+                continue;
 
-        if ( XMVector4EqualInt( NoIntersection, XMVectorTrueInt() ) )
-            return FALSE;
-    }
-    else
-    {
-        // Parallel ray.
-        return FALSE;
-    }
+            if( !Found || S.RadiusSq < pOut->RadiusSq )
+                *pOut = S;
 
-    XMVECTOR inv_det = XMVectorReciprocal( det );
+            Found = TRUE;
+        }
 
-    t *= inv_det;
+        // Only possible through round off; the caller measures the final
+        // radius from the points anyway.
+        if( !Found )
+            ExactSphereFrom3( pOut, A, B, C );
+        return;
+    }
 
-    // u * inv_det and v * inv_det are the barycentric cooridinates of the intersection.
+    Double3 wu = Cross( w, u );
+    Double3 uv = Cross( u, v );
+    DOUBLE Scale = 0.5 / Det;
 
-    // Store the x-component to *pDist
-    XMStoreFloat( pDist, t );
+    Double3 Offset =
+    {
+        ( uu * vw.x + vv * wu.x + ww * uv.x ) * Scale,
+        ( uu * vw.y + vv * wu.y + ww * uv.y ) * Scale,
+        ( uu * vw.z + vv * wu.z + ww * uv.z ) * Scale
+    };
 
-    return TRUE;
+    pOut->Center.x = a.x + Offset.x;
+    pOut->Center.y = a.y + Offset.y;
+    pOut->Center.z = a.z + Offset.z;
+    pOut->RadiusSq = Dot( Offset, Offset );
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Compute the intersection of a ray (Origin, Direction) with a sphere.
+// Find the smallest enclosing bounding sphere for a set of points.
+// The algorithm is the randomized incremental form of Emo Welzl, "Smallest
+// enclosing disks (balls and ellipsoids)": the points are shuffled and added
+// one at a time; when a point is outside the current sphere it must be on the
+// surface of the new one, which is built again from the points before it with
+// that point fixed on the surface (up to four fixed points). With the points
+// in random order the expected run time is linear, a few times that of
+// ComputeBoundingSphereFromPoints.
 //-----------------------------------------------------------------------------
-BOOL IntersectRaySphere( FXMVECTOR Origin, FXMVECTOR Direction, const Sphere* pVolume, FLOAT* pDist )
+VOID ComputeMinimumBoundingSphereFromPoints( Sphere* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride )
 {
-    XMASSERT( pVolume );
-    XMASSERT( pDist );
-    XMASSERT( XMVector3IsUnit( Direction ) );
+    XMASSERT( pOut );
+    XMASSERT( Count > 0 );
+    XMASSERT( pPoints );
 
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
+    std::vector<XMFLOAT3> Points( Count );
 
-    // l is the vector from the ray origin to the center of the sphere.
-    XMVECTOR l = Center - Origin;
+    for( UINT i = 0; i < Count; i++ )
+        Points[i] = *( const XMFLOAT3* )( ( const BYTE* )pPoints + ( size_t )i * Stride );
 
-    // s is the projection of the l onto the ray direction.
-    XMVECTOR s = XMVector3Dot( l, Direction );
+    // Shuffle with a fixed seed so the result is repeatable.
+    UINT Random = 0x9e3779b9;
 
-    XMVECTOR l2 = XMVector3Dot( l, l );
+    for( UINT i = Count - 1; i > 0; i-- )
+    {
+        Random ^= Random << 13;
+        Random ^= Random >> 17;
+        Random ^= Random << 5;
 
-    XMVECTOR r2 = Radius * Radius;
+        std::swap( Points[i], Points[Random % ( i + 1 )] );
+    }
 
-    // m2 is squared distance from the center of the sphere to the projection.
-    XMVECTOR m2 = l2 - s * s;
+    const XMFLOAT3* P = &Points[0];
 
-    XMVECTOR NoIntersection;
+    ExactSphere S;
+    ExactSphereFrom1( &S, P[0] );
 
-    // If the ray origin is outside the sphere and the center of the sphere is 
-    // behind the ray origin there is no intersection.
-    NoIntersection = XMVectorAndInt( XMVectorLess( s, XMVectorZero() ), XMVectorGreater( l2, r2 ) );
+    for( UINT i = 1; i < Count; i++ )
+    {
+        if( ExactSphereContains( S, P[i] ) )
+            continue;
 
-    // If the squared distance from the center of the sphere to the projection
-    // is greater than the radius squared the ray will miss the sphere.
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( m2, r2 ) );
+        // P[i] is on the surface of the sphere of P[0..i].
+        ExactSphereFrom1( &S, P[i] );
 
-    // The ray hits the sphere, compute the nearest intersection point.
-    XMVECTOR q = XMVectorSqrt( r2 - m2 );
-    XMVECTOR t1 = s - q;
-    XMVECTOR t2 = s + q;
+        for( UINT j = 0; j < i; j++ )
+        {
+            if( ExactSphereContains( S, P[j] ) )
+                continue;
 
-    XMVECTOR OriginInside = XMVectorLessOrEqual( l2, r2 );
-    XMVECTOR t = XMVectorSelect( t1, t2, OriginInside );
+            ExactSphereFrom2( &S, P[i], P[j] );
 
-    if( XMVector4NotEqualInt( NoIntersection, XMVectorTrueInt() ) )
+            for( UINT k = 0; k < j; k++ )
+            {
+                if( ExactSphereContains( S, P[k] ) )
+                    continue;
+
+                ExactSphereFrom3( &S, P[i], P[j], P[k] );
+
+                for( UINT l = 0; l < k; l++ )
+                {
+                    if( ExactSphereContains( S, P[l] ) )
+                        continue;
+
+                    ExactSphereFrom4( &S, P[i], P[j], P[k], P[l] );
+                }
+            }
+        }
+    }
+
+    // Measure the radius from the center rounded to float, and round it up,
+    // so every point is inside the stored sphere.
+    XMFLOAT3 Center( FLOAT( S.Center.x ), FLOAT( S.Center.y ), FLOAT( S.Center.z ) );
+    Double3 c = ToDouble3( Center );
+
+    DOUBLE MaxDistSq = 0.0;
+
+    for( UINT i = 0; i < Count; i++ )
     {
-        // Store the x-component to *pDist.
-        XMStoreFloat( pDist, t );
-        return TRUE;
+        Double3 Delta = Subtract( ToDouble3( P[i] ), c );
+        DOUBLE DistSq = Dot( Delta, Delta );
+
+        if( DistSq > MaxDistSq )
+            MaxDistSq = DistSq;
     }
 
-    return FALSE;
+    DOUBLE Radius = sqrt( MaxDistSq );
+    FLOAT RadiusF = FLOAT( Radius );
+
+    if( DOUBLE( RadiusF ) < Radius )
+        RadiusF += RadiusF * FLT_EPSILON;
+
+    pOut->Center = Center;
+    pOut->Radius = RadiusF;
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Compute the intersection of a ray (Origin, Direction) with an axis aligned 
-// box using the slabs method.
+// Build a frustum from a persepective projection matrix.  The matrix may only
+// contain a projection; any rotation, translation or scale will cause the
+// constructed frustum to be incorrect.
 //-----------------------------------------------------------------------------
-BOOL IntersectRayAxisAlignedBox( FXMVECTOR Origin, FXMVECTOR Direction, const AxisAlignedBox* pVolume, FLOAT* pDist )
+VOID ComputeFrustumFromProjection( Frustum* pOut, XMMATRIX* pProjection )
 {
-    XMASSERT( pVolume );
-    XMASSERT( pDist );
-    XMASSERT( XMVector3IsUnit( Direction ) );
+    XMASSERT( pOut );
+    XMASSERT( pProjection );
 
-    static const XMVECTOR Epsilon =
-    {
-        1e-20f, 1e-20f, 1e-20f, 1e-20f
-    };
-    static const XMVECTOR FltMin =
-    {
-        -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX
-    };
-    static const XMVECTOR FltMax =
+    // Corners of the projection frustum in homogenous space.
+    static XMVECTOR HomogenousPoints[6] =
     {
-        FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX
+        {  1.0f,  0.0f, 1.0f, 1.0f },   // right (at far plane)
+        { -1.0f,  0.0f, 1.0f, 1.0f },   // left
+        {  0.0f,  1.0f, 1.0f, 1.0f },   // top
+        {  0.0f, -1.0f, 1.0f, 1.0f },   // bottom
+
+        { 0.0f, 0.0f, 0.0f, 1.0f },     // near
+        { 0.0f, 0.0f, 1.0f, 1.0f }      // far
     };
 
-    // Load the box.
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
+    XMVECTOR Determinant;
+    XMMATRIX matInverse = XMMatrixInverse( &Determinant, *pProjection );
 
-    // Adjust ray origin to be relative to center of the box.
-    XMVECTOR TOrigin = Center - Origin;
+    // Compute the frustum corners in world space.
+    XMVECTOR Points[6];
 
-    // Compute the dot product againt each axis of the box.
-    // Since the axii are (1,0,0), (0,1,0), (0,0,1) no computation is necessary.
-    XMVECTOR AxisDotOrigin = TOrigin;
-    XMVECTOR AxisDotDirection = Direction;
+    for( INT i = 0; i < 6; i++ )
+    {
+        // Transform point.
+        Points[i] = XMVector4Transform( HomogenousPoints[i], matInverse );
+    }
 
-    // if (fabs(AxisDotDirection) <= Epsilon) the ray is nearly parallel to the slab.
-    XMVECTOR IsParallel = XMVectorLessOrEqual( XMVectorAbs( AxisDotDirection ), Epsilon );
-
-    // Test against all three axii simultaneously.
-    XMVECTOR InverseAxisDotDirection = XMVectorReciprocal( AxisDotDirection );
-    XMVECTOR t1 = ( AxisDotOrigin - Extents ) * InverseAxisDotDirection;
-    XMVECTOR t2 = ( AxisDotOrigin + Extents ) * InverseAxisDotDirection;
-
-    // Compute the max of min(t1,t2) and the min of max(t1,t2) ensuring we don't
-    // use the results from any directions parallel to the slab.
-    XMVECTOR t_min = XMVectorSelect( XMVectorMin( t1, t2 ), FltMin, IsParallel );
-    XMVECTOR t_max = XMVectorSelect( XMVectorMax( t1, t2 ), FltMax, IsParallel );
-
-    // t_min.x = maximum( t_min.x, t_min.y, t_min.z );
-    // t_max.x = minimum( t_max.x, t_max.y, t_max.z );
-    t_min = XMVectorMax( t_min, XMVectorSplatY( t_min ) );  // x = max(x,y)
-    t_min = XMVectorMax( t_min, XMVectorSplatZ( t_min ) );  // x = max(max(x,y),z)
-    t_max = XMVectorMin( t_max, XMVectorSplatY( t_max ) );  // x = min(x,y)
-    t_max = XMVectorMin( t_max, XMVectorSplatZ( t_max ) );  // x = min(min(x,y),z)
+    pOut->Origin = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+    pOut->Orientation = XMFLOAT4( 0.0f, 0.0f, 0.0f, 1.0f );
 
-    // if ( t_min > t_max ) return FALSE;
-    XMVECTOR NoIntersection = XMVectorGreater( XMVectorSplatX( t_min ), XMVectorSplatX( t_max ) );
+    // Compute the slopes.
+    Points[0] = Points[0] * XMVectorReciprocal( XMVectorSplatZ( Points[0] ) );
+    Points[1] = Points[1] * XMVectorReciprocal( XMVectorSplatZ( Points[1] ) );
+    Points[2] = Points[2] * XMVectorReciprocal( XMVectorSplatZ( Points[2] ) );
+    Points[3] = Points[3] * XMVectorReciprocal( XMVectorSplatZ( Points[3] ) );
 
-    // if ( t_max < 0.0f ) return FALSE;
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( XMVectorSplatX( t_max ), XMVectorZero() ) );
+    pOut->RightSlope = XMVectorGetX( Points[0] );
+    pOut->LeftSlope = XMVectorGetX( Points[1] );
+    pOut->TopSlope = XMVectorGetY( Points[2] );
+    pOut->BottomSlope = XMVectorGetY( Points[3] );
 
-    // if (IsParallel && (-Extents > AxisDotOrigin || Extents < AxisDotOrigin)) return FALSE;
-    XMVECTOR ParallelOverlap = XMVectorInBounds( AxisDotOrigin, Extents );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorAndCInt( IsParallel, ParallelOverlap ) );
+    // Compute near and far.
+    Points[4] = Points[4] * XMVectorReciprocal( XMVectorSplatW( Points[4] ) );
+    Points[5] = Points[5] * XMVectorReciprocal( XMVectorSplatW( Points[5] ) );
 
-    if( !XMVector3AnyTrue( NoIntersection ) )
-    {
-        // Store the x-component to *pDist
-        XMStoreFloat( pDist, t_min );
-        return TRUE;
-    }
+    pOut->Near = XMVectorGetZ( Points[4] );
+    pOut->Far = XMVectorGetZ( Points[5] );
 
-    return FALSE;
+    return;
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Compute the intersection of a ray (Origin, Direction) with an oriented box
-// using the slabs method.
+// Build the 6 frustum planes from a frustum.
 //-----------------------------------------------------------------------------
-BOOL IntersectRayOrientedBox( FXMVECTOR Origin, FXMVECTOR Direction, const OrientedBox* pVolume, FLOAT* pDist )
+VOID ComputePlanesFromFrustum( const Frustum* pVolume, XMVECTOR* pPlane0, XMVECTOR* pPlane1, XMVECTOR* pPlane2,
+                               XMVECTOR* pPlane3, XMVECTOR* pPlane4, XMVECTOR* pPlane5 )
 {
     XMASSERT( pVolume );
-    XMASSERT( pDist );
-    XMASSERT( XMVector3IsUnit( Direction ) );
-
-    static const XMVECTOR Epsilon =
-    {
-        1e-20f, 1e-20f, 1e-20f, 1e-20f
-    };
-    static const XMVECTOR FltMin =
-    {
-        -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX
-    };
-    static const XMVECTOR FltMax =
-    {
-        FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX
-    };
-    static const XMVECTORI32 SelectY =
-    {
-        XM_SELECT_0, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0
-    };
-    static const XMVECTORI32 SelectZ =
-    {
-        XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0
-    };
+    XMASSERT( pPlane0 );
+    XMASSERT( pPlane1 );
+    XMASSERT( pPlane2 );
+    XMASSERT( pPlane3 );
+    XMASSERT( pPlane4 );
+    XMASSERT( pPlane5 );
 
-    // Load the box.
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
+    // Load origin and orientation of the frustum.
+    XMVECTOR Origin = XMLoadFloat3( &pVolume->Origin );
     XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
 
-    XMASSERT( XMQuaternionIsUnit( Orientation ) );
-
-    // Get the boxes normalized side directions.
-    XMMATRIX R = XMMatrixRotationQuaternion( Orientation );
-
-    // Adjust ray origin to be relative to center of the box.
-    XMVECTOR TOrigin = Center - Origin;
-
-    // Compute the dot product againt each axis of the box.
-    XMVECTOR AxisDotOrigin = XMVector3Dot( R.r[0], TOrigin );
-    AxisDotOrigin = XMVectorSelect( AxisDotOrigin, XMVector3Dot( R.r[1], TOrigin ), SelectY );
-    AxisDotOrigin = XMVectorSelect( AxisDotOrigin, XMVector3Dot( R.r[2], TOrigin ), SelectZ );
+    // Build the frustum planes.
+    XMVECTOR Plane0 = XMVectorSet( 0.0f, 0.0f, -1.0f, pVolume->Near );
+    XMVECTOR Plane1 = XMVectorSet( 0.0f, 0.0f, 1.0f, -pVolume->Far );
+    XMVECTOR Plane2 = XMVectorSet( 1.0f, 0.0f, -pVolume->RightSlope, 0.0f );
+    XMVECTOR Plane3 = XMVectorSet( -1.0f, 0.0f, pVolume->LeftSlope, 0.0f );
+    XMVECTOR Plane4 = XMVectorSet( 0.0f, 1.0f, -pVolume->TopSlope, 0.0f );
+    XMVECTOR Plane5 = XMVectorSet( 0.0f, -1.0f, pVolume->BottomSlope, 0.0f );
 
-    XMVECTOR AxisDotDirection = XMVector3Dot( R.r[0], Direction );
-    AxisDotDirection = XMVectorSelect( AxisDotDirection, XMVector3Dot( R.r[1], Direction ), SelectY );
-    AxisDotDirection = XMVectorSelect( AxisDotDirection, XMVector3Dot( R.r[2], Direction ), SelectZ );
+    Plane0 = TransformPlane( Plane0, Orientation, Origin );
+    Plane1 = TransformPlane( Plane1, Orientation, Origin );
+    Plane2 = TransformPlane( Plane2, Orientation, Origin );
+    Plane3 = TransformPlane( Plane3, Orientation, Origin );
+    Plane4 = TransformPlane( Plane4, Orientation, Origin );
+    Plane5 = TransformPlane( Plane5, Orientation, Origin );
 
-    // if (fabs(AxisDotDirection) <= Epsilon) the ray is nearly parallel to the slab.
-    XMVECTOR IsParallel = XMVectorLessOrEqual( XMVectorAbs( AxisDotDirection ), Epsilon );
+    *pPlane0 = XMPlaneNormalize( Plane0 );
+    *pPlane1 = XMPlaneNormalize( Plane1 );
+    *pPlane2 = XMPlaneNormalize( Plane2 );
+    *pPlane3 = XMPlaneNormalize( Plane3 );
+    *pPlane4 = XMPlaneNormalize( Plane4 );
+    *pPlane5 = XMPlaneNormalize( Plane5 );
+}
 
-    // Test against all three axes simultaneously.
-    XMVECTOR InverseAxisDotDirection = XMVectorReciprocal( AxisDotDirection );
-    XMVECTOR t1 = ( AxisDotOrigin - Extents ) * InverseAxisDotDirection;
-    XMVECTOR t2 = ( AxisDotOrigin + Extents ) * InverseAxisDotDirection;
 
-    // Compute the max of min(t1,t2) and the min of max(t1,t2) ensuring we don't
-    // use the results from any directions parallel to the slab.
-    XMVECTOR t_min = XMVectorSelect( XMVectorMin( t1, t2 ), FltMin, IsParallel );
-    XMVECTOR t_max = XMVectorSelect( XMVectorMax( t1, t2 ), FltMax, IsParallel );
 
-    // t_min.x = maximum( t_min.x, t_min.y, t_min.z );
-    // t_max.x = minimum( t_max.x, t_max.y, t_max.z );
-    t_min = XMVectorMax( t_min, XMVectorSplatY( t_min ) );  // x = max(x,y)
-    t_min = XMVectorMax( t_min, XMVectorSplatZ( t_min ) );  // x = max(max(x,y),z)
-    t_max = XMVectorMin( t_max, XMVectorSplatY( t_max ) );  // x = min(x,y)
-    t_max = XMVectorMin( t_max, XMVectorSplatZ( t_max ) );  // x = min(min(x,y),z)
+//-----------------------------------------------------------------------------
+// Transform a sphere by an angle preserving transform.
+//-----------------------------------------------------------------------------
+VOID TransformSphere( Sphere* pOut, const Sphere* pIn, FLOAT Scale, FXMVECTOR Rotation, FXMVECTOR Translation )
+{
+    XMASSERT( pOut );
+    XMASSERT( pIn );
+    XMASSERT( XMQuaternionIsUnit( Rotation ) );
 
-    // if ( t_min > t_max ) return FALSE;
-    XMVECTOR NoIntersection = XMVectorGreater( XMVectorSplatX( t_min ), XMVectorSplatX( t_max ) );
+    // Load the center of the sphere.
+    XMVECTOR Center = XMLoadFloat3( &pIn->Center );
 
-    // if ( t_max < 0.0f ) return FALSE;
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( XMVectorSplatX( t_max ), XMVectorZero() ) );
+    // Transform the center of the sphere.
+    Center = XMVector3Rotate( Center * XMVectorReplicate( Scale ), Rotation ) + Translation;
 
-    // if (IsParallel && (-Extents > AxisDotOrigin || Extents < AxisDotOrigin)) return FALSE;
-    XMVECTOR ParallelOverlap = XMVectorInBounds( AxisDotOrigin, Extents );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorAndCInt( IsParallel, ParallelOverlap ) );
+    // Store the center sphere.
+    XMStoreFloat3( &pOut->Center, Center );
 
-    if( !XMVector3AnyTrue( NoIntersection ) )
-    {
-        // Store the x-component to *pDist
-        XMStoreFloat( pDist, t_min );
-        return TRUE;
-    }
+    // Scale the radius of the pshere.
+    pOut->Radius = pIn->Radius * Scale;
 
-    return FALSE;
+    return;
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Test if two triangles intersect.
-//
-// The final test of algorithm is based on Shen, Heng, and Tang, "A Fast 
-// Triangle-Triangle Overlap Test Using Signed Distances", Journal of Graphics 
-// Tools, vol. 8, no. 1, pp 17-23, 2003 and Guigue and Devillers, "Fast and 
-// Robust Triangle-Triangle Overlap Test Using Orientation Predicates", Journal 
-// of Graphics Tools, vol. 8, no. 1, pp 25-32, 2003.
-//
-// The final test could be considered an edge-edge separating plane test with
-// the 9 possible cases narrowed down to the only two pairs of edges that can 
-// actaully result in a seperation.
+// Transform an axis aligned box by an angle preserving transform.
 //-----------------------------------------------------------------------------
-BOOL IntersectTriangleTriangle( FXMVECTOR A0, FXMVECTOR A1, FXMVECTOR A2, CXMVECTOR B0, CXMVECTOR B1, CXMVECTOR B2 )
+VOID TransformAxisAlignedBox( AxisAlignedBox* pOut, const AxisAlignedBox* pIn, FLOAT Scale, FXMVECTOR Rotation,
+                              FXMVECTOR Translation )
 {
-    static const XMVECTOR Epsilon =
-    {
-        1e-20f, 1e-20f, 1e-20f, 1e-20f
-    };
-    static const XMVECTORI32 SelectY =
-    {
-        XM_SELECT_0, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0
-    };
-    static const XMVECTORI32 SelectZ =
-    {
-        XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0
-    };
-    static const XMVECTORI32 Select0111 =
-    {
-        XM_SELECT_0, XM_SELECT_1, XM_SELECT_1, XM_SELECT_1
-    };
-    static const XMVECTORI32 Select1011 =
-    {
-        XM_SELECT_1, XM_SELECT_0, XM_SELECT_1, XM_SELECT_1
-    };
-    static const XMVECTORI32 Select1101 =
+    XMASSERT( pOut );
+    XMASSERT( pIn );
+    XMASSERT( XMQuaternionIsUnit( Rotation ) );
+
+    static XMVECTOR Offset[8] =
     {
-        XM_SELECT_1, XM_SELECT_1, XM_SELECT_0, XM_SELECT_1
+        { -1.0f, -1.0f, -1.0f, 0.0f },
+        { -1.0f, -1.0f,  1.0f, 0.0f },
+        { -1.0f,  1.0f, -1.0f, 0.0f },
+        { -1.0f,  1.0f,  1.0f, 0.0f },
+        {  1.0f, -1.0f, -1.0f, 0.0f },
+        {  1.0f, -1.0f,  1.0f, 0.0f },
+        {  1.0f,  1.0f, -1.0f, 0.0f },
+        {  1.0f,  1.0f,  1.0f, 0.0f }
     };
 
-    XMVECTOR Zero = XMVectorZero();
+    // Load center and extents.
+    XMVECTOR Center = XMLoadFloat3( &pIn->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pIn->Extents );
 
-    // Compute the normal of triangle A.
-    XMVECTOR N1 = XMVector3Cross( A1 - A0, A2 - A0 );
+    XMVECTOR VectorScale = XMVectorReplicate( Scale );
 
-    // Assert that the triangle is not degenerate.
-    XMASSERT( !XMVector3Equal( N1, Zero ) );
+    // Compute and transform the corners and find new min/max bounds.
+    XMVECTOR Corner = Center + Extents * Offset[0];
+    Corner = XMVector3Rotate( Corner * VectorScale, Rotation ) + Translation;
 
-    // Test points of B against the plane of A.
-    XMVECTOR BDist = XMVector3Dot( N1, B0 - A0 );
-    BDist = XMVectorSelect( BDist, XMVector3Dot( N1, B1 - A0 ), SelectY );
-    BDist = XMVectorSelect( BDist, XMVector3Dot( N1, B2 - A0 ), SelectZ );
+    XMVECTOR Min, Max;
+    Min = Max = Corner;
 
-    // Ensure robustness with co-planar triangles by zeroing small distances.
-    UINT BDistIsZeroCR;
-    XMVECTOR BDistIsZero = XMVectorGreaterR( &BDistIsZeroCR, Epsilon, XMVectorAbs( BDist ) );
-    BDist = XMVectorSelect( BDist, Zero, BDistIsZero );
+    for( INT i = 1; i < 8; i++ )
+    {
+        Corner = Center + Extents * Offset[i];
+        Corner = XMVector3Rotate( Corner * VectorScale, Rotation ) + Translation;
 
-    UINT BDistIsLessCR;
-    XMVECTOR BDistIsLess = XMVectorGreaterR( &BDistIsLessCR, Zero, BDist );
+        Min = XMVectorMin( Min, Corner );
+        Max = XMVectorMax( Max, Corner );
+    }
 
-    UINT BDistIsGreaterCR;
-    XMVECTOR BDistIsGreater = XMVectorGreaterR( &BDistIsGreaterCR, BDist, Zero );
+    // Store center and extents.
+    XMStoreFloat3( &pOut->Center, ( Min + Max ) * 0.5f );
+    XMStoreFloat3( &pOut->Extents, ( Max - Min ) * 0.5f );
 
-    // If all the points are on the same side we don't intersect.
-    if( XMComparisonAllTrue( BDistIsLessCR ) || XMComparisonAllTrue( BDistIsGreaterCR ) )
-        return FALSE;
+    return;
+}
 
-    // Compute the normal of triangle B.
-    XMVECTOR N2 = XMVector3Cross( B1 - B0, B2 - B0 );
 
-    // Assert that the triangle is not degenerate.
-    XMASSERT( !XMVector3Equal( N2, Zero ) );
 
-    // Test points of A against the plane of B.
-    XMVECTOR ADist = XMVector3Dot( N2, A0 - B0 );
-    ADist = XMVectorSelect( ADist, XMVector3Dot( N2, A1 - B0 ), SelectY );
-    ADist = XMVectorSelect( ADist, XMVector3Dot( N2, A2 - B0 ), SelectZ );
+//-----------------------------------------------------------------------------
+// Transform an oriented box by an angle preserving transform.
+//-----------------------------------------------------------------------------
+VOID TransformOrientedBox( OrientedBox* pOut, const OrientedBox* pIn, FLOAT Scale, FXMVECTOR Rotation,
+                           FXMVECTOR Translation )
+{
+    XMASSERT( pOut );
+    XMASSERT( pIn );
+    XMASSERT( XMQuaternionIsUnit( Rotation ) );
 
-    // Ensure robustness with co-planar triangles by zeroing small distances.
-    UINT ADistIsZeroCR;
-    XMVECTOR ADistIsZero = XMVectorGreaterR( &ADistIsZeroCR, Epsilon, XMVectorAbs( BDist ) );
-    ADist = XMVectorSelect( ADist, Zero, ADistIsZero );
+    // Load the box.
+    XMVECTOR Center = XMLoadFloat3( &pIn->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pIn->Extents );
+    XMVECTOR Orientation = XMLoadFloat4( &pIn->Orientation );
 
-    UINT ADistIsLessCR;
-    XMVECTOR ADistIsLess = XMVectorGreaterR( &ADistIsLessCR, Zero, ADist );
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
 
-    UINT ADistIsGreaterCR;
-    XMVECTOR ADistIsGreater = XMVectorGreaterR( &ADistIsGreaterCR, ADist, Zero );
+    // Composite the box rotation and the transform rotation.
+    Orientation = XMQuaternionMultiply( Orientation, Rotation );
 
-    // If all the points are on the same side we don't intersect.
-    if( XMComparisonAllTrue( ADistIsLessCR ) || XMComparisonAllTrue( ADistIsGreaterCR ) )
-        return FALSE;
+    // Transform the center.
+    XMVECTOR VectorScale = XMVectorReplicate( Scale );
+    Center = XMVector3Rotate( Center * VectorScale, Rotation ) + Translation;
 
-    // Special case for co-planar triangles.
-    if( XMComparisonAllTrue( ADistIsZeroCR ) || XMComparisonAllTrue( BDistIsZeroCR ) )
-    {
-        XMVECTOR Axis, Dist, MinDist;
+    // Scale the box extents.
+    Extents = Extents * VectorScale;
 
-        // Compute an axis perpindicular to the edge (points out).
-        Axis = XMVector3Cross( N1, A1 - A0 );
-        Dist = XMVector3Dot( Axis, A0 );
+    // Store the box.
+    XMStoreFloat3( &pOut->Center, Center );
+    XMStoreFloat3( &pOut->Extents, Extents );
+    XMStoreFloat4( &pOut->Orientation, Orientation );
 
-        // Test points of B against the axis.
-        MinDist = XMVector3Dot( B0, Axis );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( B1, Axis ) );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( B2, Axis ) );
-        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
-            return FALSE;
+    return;
+}
 
-        // Edge (A1, A2)
-        Axis = XMVector3Cross( N1, A2 - A1 );
-        Dist = XMVector3Dot( Axis, A1 );
 
-        MinDist = XMVector3Dot( B0, Axis );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( B1, Axis ) );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( B2, Axis ) );
-        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
-            return FALSE;
 
-        // Edge (A2, A0)
-        Axis = XMVector3Cross( N1, A0 - A2 );
-        Dist = XMVector3Dot( Axis, A2 );
+//-----------------------------------------------------------------------------
+// Transform a frustum by an angle preserving transform.
+//-----------------------------------------------------------------------------
+VOID TransformFrustum( Frustum* pOut, const Frustum* pIn, FLOAT Scale, FXMVECTOR Rotation, FXMVECTOR Translation )
+{
+    XMASSERT( pOut );
+    XMASSERT( pIn );
+    XMASSERT( XMQuaternionIsUnit( Rotation ) );
 
-        MinDist = XMVector3Dot( B0, Axis );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( B1, Axis ) );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( B2, Axis ) );
-        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
-            return FALSE;
+    // Load the frustum.
+    XMVECTOR Origin = XMLoadFloat3( &pIn->Origin );
+    XMVECTOR Orientation = XMLoadFloat4( &pIn->Orientation );
 
-        // Edge (B0, B1)
-        Axis = XMVector3Cross( N2, B1 - B0 );
-        Dist = XMVector3Dot( Axis, B0 );
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
 
-        MinDist = XMVector3Dot( A0, Axis );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( A1, Axis ) );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( A2, Axis ) );
-        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
-            return FALSE;
+    // Composite the frustum rotation and the transform rotation.
+    Orientation = XMQuaternionMultiply( Orientation, Rotation );
 
-        // Edge (B1, B2)
-        Axis = XMVector3Cross( N2, B2 - B1 );
-        Dist = XMVector3Dot( Axis, B1 );
+    // Transform the origin.
+    Origin = XMVector3Rotate( Origin * XMVectorReplicate( Scale ), Rotation ) + Translation;
 
-        MinDist = XMVector3Dot( A0, Axis );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( A1, Axis ) );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( A2, Axis ) );
-        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
-            return FALSE;
+    // Store the frustum.
+    XMStoreFloat3( &pOut->Origin, Origin );
+    XMStoreFloat4( &pOut->Orientation, Orientation );
 
-        // Edge (B2,B0)
-        Axis = XMVector3Cross( N2, B0 - B2 );
-        Dist = XMVector3Dot( Axis, B2 );
+    // Scale the near and far distances (the slopes remain the same).
+    pOut->Near = pIn->Near * Scale;
+    pOut->Far = pIn->Far * Scale;
 
-        MinDist = XMVector3Dot( A0, Axis );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( A1, Axis ) );
-        MinDist = XMVectorMin( MinDist, XMVector3Dot( A2, Axis ) );
-        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
-            return FALSE;
+    // Copy the slopes.
+    pOut->RightSlope = pIn->RightSlope;
+    pOut->LeftSlope = pIn->LeftSlope;
+    pOut->TopSlope = pIn->TopSlope;
+    pOut->BottomSlope = pIn->BottomSlope;
 
-        return TRUE;
-    }
+    return;
+}
 
-    //
-    // Find the single vertex of A and B (ie the vertex on the opposite side
-    // of the plane from the other two) and reorder the edges so we can compute 
-    // the signed edge/edge distances.
-    //
-    // if ( (V0 >= 0 && V1 <  0 && V2 <  0) ||
-    //      (V0 >  0 && V1 <= 0 && V2 <= 0) ||
-    //      (V0 <= 0 && V1 >  0 && V2 >  0) ||
-    //      (V0 <  0 && V1 >= 0 && V2 >= 0) ) then V0 is singular;
-    //
-    // If our singular vertex is not on the positive side of the plane we reverse
-    // the triangle winding so that the overlap comparisons will compare the 
-    // correct edges with the correct signs.
-    //
-    XMVECTOR ADistIsLessEqual = XMVectorOrInt( ADistIsLess, ADistIsZero );
-    XMVECTOR ADistIsGreaterEqual = XMVectorOrInt( ADistIsGreater, ADistIsZero );
 
-    XMVECTOR AA0, AA1, AA2;
-    bool bPositiveA;
 
-    if( XMVector3AllTrue( XMVectorSelect( ADistIsGreaterEqual, ADistIsLess, Select0111 ) ) ||
-        XMVector3AllTrue( XMVectorSelect( ADistIsGreater, ADistIsLessEqual, Select0111 ) ) )
-    {
-        // A0 is singular, crossing from positive to negative.
-        AA0 = A0; AA1 = A1; AA2 = A2;
-        bPositiveA = true;
-    }
-    else if( XMVector3AllTrue( XMVectorSelect( ADistIsLessEqual, ADistIsGreater, Select0111 ) ) ||
-             XMVector3AllTrue( XMVectorSelect( ADistIsLess, ADistIsGreaterEqual, Select0111 ) ) )
+//-----------------------------------------------------------------------------
+// Batched transforms. Groups of four volumes are processed with one volume per
+// vector lane; the 4x3 part of their four matrices is transposed so that
+// M[r][c] holds element (r, c) of the four matrices.
+//-----------------------------------------------------------------------------
+static const UINT MinVolumesPerTask = 16 * 1024;
+
+
+
+static inline VOID LoadMatrixLanes( XMVECTOR M[4][3], const XMFLOAT4X4* pMatrices )
+{
+    for( UINT r = 0; r < 4; r++ )
     {
-        // A0 is singular, crossing from negative to positive.
-        AA0 = A0; AA1 = A2; AA2 = A1;
-        bPositiveA = false;
+        XMMATRIX Rows;
+        Rows.r[0] = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( pMatrices[0].m[r] ) );
+        Rows.r[1] = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( pMatrices[1].m[r] ) );
+        Rows.r[2] = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( pMatrices[2].m[r] ) );
+        Rows.r[3] = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( pMatrices[3].m[r] ) );
+
+        XMMATRIX Lanes = XMMatrixTranspose( Rows );
+        M[r][0] = Lanes.r[0];
+        M[r][1] = Lanes.r[1];
+        M[r][2] = Lanes.r[2];
     }
-    else if( XMVector3AllTrue( XMVectorSelect( ADistIsGreaterEqual, ADistIsLess, Select1011 ) ) ||
-             XMVector3AllTrue( XMVectorSelect( ADistIsGreater, ADistIsLessEqual, Select1011 ) ) )
+}
+
+
+
+// Transform the points (X[0], X[1], X[2]) of the four lanes.
+static inline VOID TransformPointLanes( XMVECTOR Out[3], const XMVECTOR X[3], const XMVECTOR M[4][3] )
+{
+    for( UINT c = 0; c < 3; c++ )
     {
-        // A1 is singular, crossing from positive to negative.
-        AA0 = A1; AA1 = A2; AA2 = A0;
-        bPositiveA = true;
+        XMVECTOR V = XMVectorMultiplyAdd( X[0], M[0][c], M[3][c] );
+        V = XMVectorMultiplyAdd( X[1], M[1][c], V );
+        Out[c] = XMVectorMultiplyAdd( X[2], M[2][c], V );
     }
-    else if( XMVector3AllTrue( XMVectorSelect( ADistIsLessEqual, ADistIsGreater, Select1011 ) ) ||
-             XMVector3AllTrue( XMVectorSelect( ADistIsLess, ADistIsGreaterEqual, Select1011 ) ) )
+}
+
+
+
+static inline XMVECTOR LoadLanes( const FLOAT* p, UINT i )
+{
+    return XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( p + i ) );
+}
+
+
+
+static inline VOID StoreLanes( FLOAT* p, UINT i, FXMVECTOR V )
+{
+    XMStoreFloat4( reinterpret_cast<XMFLOAT4*>( p + i ), V );
+}
+
+
+
+// Largest length of the three axes of the 4x3 part of a matrix.
+static inline FLOAT GetMaxAxisScale( CXMMATRIX M )
+{
+    XMVECTOR Scale = XMVectorMax( XMVector3LengthSq( M.r[0] ),
+                                  XMVectorMax( XMVector3LengthSq( M.r[1] ), XMVector3LengthSq( M.r[2] ) ) );
+    return XMVectorGetX( XMVectorSqrt( Scale ) );
+}
+
+
+
+static VOID TransformSphereRange( const SphereArrays* pOut, const SphereArrays* pIn, const XMFLOAT4X4* pMatrices,
+                                  UINT Begin, UINT End )
+{
+    UINT i = Begin;
+
+    for( ; i + 4 <= End; i += 4 )
     {
-        // A1 is singular, crossing from negative to positive.
-        AA0 = A1; AA1 = A0; AA2 = A2;
-        bPositiveA = false;
+        XMVECTOR M[4][3];
+        LoadMatrixLanes( M, pMatrices + i );
+
+        XMVECTOR Center[3];
+        for( UINT c = 0; c < 3; c++ )
+            Center[c] = LoadLanes( pIn->pCenter[c], i );
+        XMVECTOR Radius = LoadLanes( pIn->pRadius, i );
+
+        XMVECTOR NewCenter[3];
+        TransformPointLanes( NewCenter, Center, M );
+
+        // Squared length of each matrix row, for the largest scale.
+        XMVECTOR MaxScaleSq = XMVectorZero();
+        for( UINT r = 0; r < 3; r++ )
+        {
+            XMVECTOR ScaleSq = M[r][0] * M[r][0] + M[r][1] * M[r][1] + M[r][2] * M[r][2];
+            MaxScaleSq = XMVectorMax( MaxScaleSq, ScaleSq );
+        }
+
+        for( UINT c = 0; c < 3; c++ )
+            StoreLanes( pOut->pCenter[c], i, NewCenter[c] );
+        StoreLanes( pOut->pRadius, i, Radius * XMVectorSqrt( MaxScaleSq ) );
     }
-    else if( XMVector3AllTrue( XMVectorSelect( ADistIsGreaterEqual, ADistIsLess, Select1101 ) ) ||
-             XMVector3AllTrue( XMVectorSelect( ADistIsGreater, ADistIsLessEqual, Select1101 ) ) )
+
+    for( ; i < End; i++ )
     {
-        // A2 is singular, crossing from positive to negative.
-        AA0 = A2; AA1 = A0; AA2 = A1;
-        bPositiveA = true;
+        XMMATRIX M = XMLoadFloat4x4( &pMatrices[i] );
+
+        XMVECTOR Center = XMVectorSet( pIn->pCenter[0][i], pIn->pCenter[1][i], pIn->pCenter[2][i], 0.0f );
+        FLOAT Radius = pIn->pRadius[i];
+
+        Center = XMVector3Transform( Center, M );
+
+        pOut->pCenter[0][i] = XMVectorGetX( Center );
+        pOut->pCenter[1][i] = XMVectorGetY( Center );
+        pOut->pCenter[2][i] = XMVectorGetZ( Center );
+        pOut->pRadius[i] = Radius * GetMaxAxisScale( M );
     }
-    else if( XMVector3AllTrue( XMVectorSelect( ADistIsLessEqual, ADistIsGreater, Select1101 ) ) ||
-             XMVector3AllTrue( XMVectorSelect( ADistIsLess, ADistIsGreaterEqual, Select1101 ) ) )
+}
+
+
+
+static VOID TransformAxisAlignedBoxRange( const AxisAlignedBoxArrays* pOut, const AxisAlignedBoxArrays* pIn,
+                                          const XMFLOAT4X4* pMatrices, UINT Begin, UINT End )
+{
+    UINT i = Begin;
+
+    for( ; i + 4 <= End; i += 4 )
     {
-        // A2 is singular, crossing from negative to positive.
-        AA0 = A2; AA1 = A1; AA2 = A0;
-        bPositiveA = false;
+        XMVECTOR M[4][3];
+        LoadMatrixLanes( M, pMatrices + i );
+
+        XMVECTOR Center[3], Extents[3];
+        for( UINT c = 0; c < 3; c++ )
+        {
+            Center[c] = LoadLanes( pIn->pCenter[c], i );
+            Extents[c] = LoadLanes( pIn->pExtents[c], i );
+        }
+
+        XMVECTOR NewCenter[3];
+        TransformPointLanes( NewCenter, Center, M );
+
+        // Arvo: each new extent is the dot product of the old extents with a
+        // column of the absolute matrix.
+        XMVECTOR NewExtents[3];
+        for( UINT c = 0; c < 3; c++ )
+        {
+            XMVECTOR V = Extents[0] * XMVectorAbs( M[0][c] );
+            V = XMVectorMultiplyAdd( Extents[1], XMVectorAbs( M[1][c] ), V );
+            NewExtents[c] = XMVectorMultiplyAdd( Extents[2], XMVectorAbs( M[2][c] ), V );
+        }
+
+        for( UINT c = 0; c < 3; c++ )
+        {
+            StoreLanes( pOut->pCenter[c], i, NewCenter[c] );
+            StoreLanes( pOut->pExtents[c], i, NewExtents[c] );
+        }
     }
-    else
+
+    for( ; i < End; i++ )
     {
-        XMASSERT( FALSE );
-        return FALSE;
+        XMMATRIX M = XMLoadFloat4x4( &pMatrices[i] );
+
+        XMVECTOR Center = XMVectorSet( pIn->pCenter[0][i], pIn->pCenter[1][i], pIn->pCenter[2][i], 0.0f );
+        XMVECTOR Extents = XMVectorSet( pIn->pExtents[0][i], pIn->pExtents[1][i], pIn->pExtents[2][i], 0.0f );
+
+        Center = XMVector3Transform( Center, M );
+        Extents = XMVectorAbs( M.r[0] ) * XMVectorSplatX( Extents ) +
+                  XMVectorAbs( M.r[1] ) * XMVectorSplatY( Extents ) +
+                  XMVectorAbs( M.r[2] ) * XMVectorSplatZ( Extents );
+
+        pOut->pCenter[0][i] = XMVectorGetX( Center );
+        pOut->pCenter[1][i] = XMVectorGetY( Center );
+        pOut->pCenter[2][i] = XMVectorGetZ( Center );
+        pOut->pExtents[0][i] = XMVectorGetX( Extents );
+        pOut->pExtents[1][i] = XMVectorGetY( Extents );
+        pOut->pExtents[2][i] = XMVectorGetZ( Extents );
     }
+}
 
-    XMVECTOR BDistIsLessEqual = XMVectorOrInt( BDistIsLess, BDistIsZero );
-    XMVECTOR BDistIsGreaterEqual = XMVectorOrInt( BDistIsGreater, BDistIsZero );
 
-    XMVECTOR BB0, BB1, BB2;
-    bool bPositiveB;
 
-    if( XMVector3AllTrue( XMVectorSelect( BDistIsGreaterEqual, BDistIsLess, Select0111 ) ) ||
-        XMVector3AllTrue( XMVectorSelect( BDistIsGreater, BDistIsLessEqual, Select0111 ) ) )
+//-----------------------------------------------------------------------------
+// The box axes are carried through the matrix and made orthonormal again
+// (Gram-Schmidt on the first two, the third from their cross product, which
+// also undoes mirroring). The new extents bound the projections of the
+// transformed box onto the new axes, so they are exact whenever the matrix
+// keeps the box axes orthogonal.
+//-----------------------------------------------------------------------------
+static VOID TransformOrientedBoxRange( const OrientedBoxArrays* pOut, const OrientedBoxArrays* pIn,
+                                       const XMFLOAT4X4* pMatrices, UINT Begin, UINT End )
+{
+    for( UINT i = Begin; i < End; i++ )
     {
-        // B0 is singular, crossing from positive to negative.
-        BB0 = B0; BB1 = B1; BB2 = B2;
-        bPositiveB = true;
-    }
-    else if( XMVector3AllTrue( XMVectorSelect( BDistIsLessEqual, BDistIsGreater, Select0111 ) ) ||
-             XMVector3AllTrue( XMVectorSelect( BDistIsLess, BDistIsGreaterEqual, Select0111 ) ) )
-    {
-        // B0 is singular, crossing from negative to positive.
-        BB0 = B0; BB1 = B2; BB2 = B1;
-        bPositiveB = false;
-    }
-    else if( XMVector3AllTrue( XMVectorSelect( BDistIsGreaterEqual, BDistIsLess, Select1011 ) ) ||
-             XMVector3AllTrue( XMVectorSelect( BDistIsGreater, BDistIsLessEqual, Select1011 ) ) )
-    {
-        // B1 is singular, crossing from positive to negative.
-        BB0 = B1; BB1 = B2; BB2 = B0;
-        bPositiveB = true;
-    }
-    else if( XMVector3AllTrue( XMVectorSelect( BDistIsLessEqual, BDistIsGreater, Select1011 ) ) ||
-             XMVector3AllTrue( XMVectorSelect( BDistIsLess, BDistIsGreaterEqual, Select1011 ) ) )
-    {
-        // B1 is singular, crossing from negative to positive.
-        BB0 = B1; BB1 = B0; BB2 = B2;
-        bPositiveB = false;
-    }
-    else if( XMVector3AllTrue( XMVectorSelect( BDistIsGreaterEqual, BDistIsLess, Select1101 ) ) ||
-             XMVector3AllTrue( XMVectorSelect( BDistIsGreater, BDistIsLessEqual, Select1101 ) ) )
-    {
-        // B2 is singular, crossing from positive to negative.
-        BB0 = B2; BB1 = B0; BB2 = B1;
-        bPositiveB = true;
-    }
-    else if( XMVector3AllTrue( XMVectorSelect( BDistIsLessEqual, BDistIsGreater, Select1101 ) ) ||
-             XMVector3AllTrue( XMVectorSelect( BDistIsLess, BDistIsGreaterEqual, Select1101 ) ) )
-    {
-        // B2 is singular, crossing from negative to positive.
-        BB0 = B2; BB1 = B1; BB2 = B0;
-        bPositiveB = false;
-    }
-    else
-    {
-        XMASSERT( FALSE );
-        return FALSE;
+        XMMATRIX M = XMLoadFloat4x4( &pMatrices[i] );
+
+        XMVECTOR Center = XMVectorSet( pIn->pCenter[0][i], pIn->pCenter[1][i], pIn->pCenter[2][i], 0.0f );
+        XMVECTOR Extents = XMVectorSet( pIn->pExtents[0][i], pIn->pExtents[1][i], pIn->pExtents[2][i], 0.0f );
+        XMVECTOR Orientation = XMVectorSet( pIn->pOrientation[0][i], pIn->pOrientation[1][i],
+                                            pIn->pOrientation[2][i], pIn->pOrientation[3][i] );
+
+        XMASSERT( XMQuaternionIsUnit( Orientation ) );
+
+        XMMATRIX R = XMMatrixRotationQuaternion( Orientation );
+
+        // Transformed box axes, still scaled by the matrix.
+        XMVECTOR Axis0 = XMVector3TransformNormal( R.r[0], M );
+        XMVECTOR Axis1 = XMVector3TransformNormal( R.r[1], M );
+        XMVECTOR Axis2 = XMVector3TransformNormal( R.r[2], M );
+
+        XMVECTOR U0 = XMVector3Normalize( Axis0 );
+        XMVECTOR U1 = XMVector3Normalize( Axis1 - XMVector3Dot( Axis1, U0 ) * U0 );
+        XMVECTOR U2 = XMVector3Cross( U0, U1 );
+
+        XMMATRIX Frame;
+        Frame.r[0] = U0;
+        Frame.r[1] = U1;
+        Frame.r[2] = U2;
+        Frame.r[3] = XMVectorSet( 0.0f, 0.0f, 0.0f, 1.0f );
+
+        // Half width of the transformed box along each new axis; the transpose
+        // of the frame projects onto the new axes.
+        XMMATRIX Project = XMMatrixTranspose( Frame );
+        XMVECTOR NewExtents = XMVectorAbs( XMVector3TransformNormal( Axis0, Project ) ) * XMVectorSplatX( Extents );
+        NewExtents += XMVectorAbs( XMVector3TransformNormal( Axis1, Project ) ) * XMVectorSplatY( Extents );
+        NewExtents += XMVectorAbs( XMVector3TransformNormal( Axis2, Project ) ) * XMVectorSplatZ( Extents );
+
+        Orientation = XMQuaternionNormalize( XMQuaternionRotationMatrix( Frame ) );
+
+        Center = XMVector3Transform( Center, M );
+
+        XMFLOAT3 C, E;
+        XMFLOAT4 Q;
+        XMStoreFloat3( &C, Center );
+        XMStoreFloat3( &E, NewExtents );
+        XMStoreFloat4( &Q, Orientation );
+
+        pOut->pCenter[0][i] = C.x;
+        pOut->pCenter[1][i] = C.y;
+        pOut->pCenter[2][i] = C.z;
+        pOut->pExtents[0][i] = E.x;
+        pOut->pExtents[1][i] = E.y;
+        pOut->pExtents[2][i] = E.z;
+        pOut->pOrientation[0][i] = Q.x;
+        pOut->pOrientation[1][i] = Q.y;
+        pOut->pOrientation[2][i] = Q.z;
+        pOut->pOrientation[3][i] = Q.w;
     }
+}
 
-    XMVECTOR Delta0, Delta1;
 
-    // Reverse the direction of the test depending on whether the singular vertices are
-    // the same sign or different signs.
-    if( bPositiveA ^ bPositiveB )
+
+//-----------------------------------------------------------------------------
+// Transform Count spheres, each by its own affine matrix.
+//-----------------------------------------------------------------------------
+VOID TransformSpheres( const SphereArrays* pOut, const SphereArrays* pIn, const XMFLOAT4X4* pMatrices, UINT Count,
+                       UINT ThreadCount )
+{
+    XMASSERT( pOut );
+    XMASSERT( pIn );
+    XMASSERT( pMatrices || Count == 0 );
+
+    ParallelFor( Count, ThreadCount, MinVolumesPerTask, [&]( UINT Begin, UINT End, UINT )
     {
-        Delta0 = ( BB0 - AA0 );
-        Delta1 = ( AA0 - BB0 );
-    }
-    else
+        TransformSphereRange( pOut, pIn, pMatrices, Begin, End );
+    } );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Transform Count axis aligned boxes, each by its own affine matrix.
+//-----------------------------------------------------------------------------
+VOID TransformAxisAlignedBoxes( const AxisAlignedBoxArrays* pOut, const AxisAlignedBoxArrays* pIn,
+                                const XMFLOAT4X4* pMatrices, UINT Count, UINT ThreadCount )
+{
+    XMASSERT( pOut );
+    XMASSERT( pIn );
+    XMASSERT( pMatrices || Count == 0 );
+
+    ParallelFor( Count, ThreadCount, MinVolumesPerTask, [&]( UINT Begin, UINT End, UINT )
     {
-        Delta0 = ( AA0 - BB0 );
-        Delta1 = ( BB0 - AA0 );
-    }
+        TransformAxisAlignedBoxRange( pOut, pIn, pMatrices, Begin, End );
+    } );
+}
 
-    // Check if the triangles overlap on the line of intersection between the
-    // planes of the two triangles by finding the signed line distances.
-    XMVECTOR Dist0 = XMVector3Dot( Delta0, XMVector3Cross( ( BB2 - BB0 ), ( AA2 - AA0 ) ) );
-    if( XMVector4Greater( Dist0, Zero ) )
-        return FALSE;
 
-    XMVECTOR Dist1 = XMVector3Dot( Delta1, XMVector3Cross( ( BB1 - BB0 ), ( AA1 - AA0 ) ) );
-    if( XMVector4Greater( Dist1, Zero ) )
-        return FALSE;
 
-    return TRUE;
+//-----------------------------------------------------------------------------
+// Transform Count oriented boxes, each by its own affine matrix.
+//-----------------------------------------------------------------------------
+VOID TransformOrientedBoxes( const OrientedBoxArrays* pOut, const OrientedBoxArrays* pIn,
+                             const XMFLOAT4X4* pMatrices, UINT Count, UINT ThreadCount )
+{
+    XMASSERT( pOut );
+    XMASSERT( pIn );
+    XMASSERT( pMatrices || Count == 0 );
+
+    ParallelFor( Count, ThreadCount, MinVolumesPerTask, [&]( UINT Begin, UINT End, UINT )
+    {
+        TransformOrientedBoxRange( pOut, pIn, pMatrices, Begin, End );
+    } );
 }
 
 
 
 //-----------------------------------------------------------------------------
-BOOL IntersectTriangleSphere( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const Sphere* pVolume )
+// Point in sphere test.
+//-----------------------------------------------------------------------------
+BOOL IntersectPointSphere( FXMVECTOR Point, const Sphere* pVolume )
 {
     XMASSERT( pVolume );
 
-    // Load the sphere.    
     XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
     XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
 
-    // Compute the plane of the triangle (has to be normalized).
-    XMVECTOR N = XMVector3Normalize( XMVector3Cross( V1 - V0, V2 - V0 ) );
+    XMVECTOR DistanceSquared = XMVector3LengthSq( Point - Center );
+    XMVECTOR RadiusSquared = Radius * Radius;
 
-    // Assert that the triangle is not degenerate.
-    XMASSERT( !XMVector3Equal( N, XMVectorZero() ) );
+    return XMVector4LessOrEqual( DistanceSquared, RadiusSquared );
+}
 
-    // Find the nearest feature on the triangle to the sphere.
-    XMVECTOR Dist = XMVector3Dot( Center - V0, N );
 
-    // If the center of the sphere is farther from the plane of the triangle than
-    // the radius of the sphere, then there cannot be an intersection.
-    XMVECTOR NoIntersection = XMVectorLess( Dist, -Radius );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Dist, Radius ) );
 
-    // Project the center of the sphere onto the plane of the triangle.
-    XMVECTOR Point = Center - ( N * Dist );
+//-----------------------------------------------------------------------------
+// Point in axis aligned box test.
+//-----------------------------------------------------------------------------
+BOOL IntersectPointAxisAlignedBox( FXMVECTOR Point, const AxisAlignedBox* pVolume )
+{
+    XMASSERT( pVolume );
 
-    // Is it inside all the edges? If so we intersect because the distance 
-    // to the plane is less than the radius.
-    XMVECTOR Intersection = PointOnPlaneInsideTriangle( Point, V0, V1, V2 );
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
 
-    // Find the nearest point on each edge.
-    XMVECTOR RadiusSq = Radius * Radius;
+    return XMVector3InBounds( Point - Center, Extents );
+}
 
-    // Edge 0,1
-    Point = PointOnLineSegmentNearestPoint( V0, V1, Center );
 
-    // If the distance to the center of the sphere to the point is less than 
-    // the radius of the sphere then it must intersect.
-    Intersection = XMVectorOrInt( Intersection, XMVectorLessOrEqual( XMVector3LengthSq( Center - Point ), RadiusSq ) );
 
-    // Edge 1,2
-    Point = PointOnLineSegmentNearestPoint( V1, V2, Center );
+//-----------------------------------------------------------------------------
+// Point in oriented box test.
+//-----------------------------------------------------------------------------
+BOOL IntersectPointOrientedBox( FXMVECTOR Point, const OrientedBox* pVolume )
+{
+    XMASSERT( pVolume );
 
-    // If the distance to the center of the sphere to the point is less than 
-    // the radius of the sphere then it must intersect.
-    Intersection = XMVectorOrInt( Intersection, XMVectorLessOrEqual( XMVector3LengthSq( Center - Point ), RadiusSq ) );
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
+    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
 
-    // Edge 2,0
-    Point = PointOnLineSegmentNearestPoint( V2, V0, Center );
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
 
-    // If the distance to the center of the sphere to the point is less than 
-    // the radius of the sphere then it must intersect.
-    Intersection = XMVectorOrInt( Intersection, XMVectorLessOrEqual( XMVector3LengthSq( Center - Point ), RadiusSq ) );
+    // Transform the point to be local to the box.
+    XMVECTOR TPoint = XMVector3InverseRotate( Point - Center, Orientation );
 
-    return XMVector4EqualInt( XMVectorAndCInt( Intersection, NoIntersection ), XMVectorTrueInt() );
+    return XMVector3InBounds( TPoint, Extents );
 }
 
 
 
 //-----------------------------------------------------------------------------
-BOOL IntersectTriangleAxisAlignedBox( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const AxisAlignedBox* pVolume )
+// Point in frustum test.
+//-----------------------------------------------------------------------------
+BOOL IntersectPointFrustum( FXMVECTOR Point, const Frustum* pVolume )
 {
+    static const XMVECTORU32 SelectW = {XM_SELECT_0, XM_SELECT_0, XM_SELECT_0, XM_SELECT_1};
+    static const XMVECTORU32 SelectZ = {XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0};
+
+    static const XMVECTOR BasePlanes[6] = 
+    {
+        {  0.0f,  0.0f, -1.0f, 0.0f },
+        {  0.0f,  0.0f,  1.0f, 0.0f },
+        {  1.0f,  0.0f,  0.0f, 0.0f },
+        { -1.0f,  0.0f,  0.0f, 0.0f },
+        {  0.0f,  1.0f,  0.0f, 0.0f },
+        {  0.0f, -1.0f,  0.0f, 0.0f },
+    };
+
     XMASSERT( pVolume );
 
-    static CONST XMVECTORI32 Permute0W1Z0Y0X =
-                 {
-                    XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X
-                 };
-    static CONST XMVECTORI32 Permute0Z0W1X0Y =
-                 {
-                    XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y
-                 };
-    static CONST XMVECTORI32 Permute1Y0X0W0Z =
-                 {
-                    XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z
-                 };
+    // Build frustum planes.
+    XMVECTOR Planes[6];
+    Planes[0] = XMVectorSelect( BasePlanes[0], XMVectorSplatX(  XMLoadFloat( &pVolume->Near ) ),
+                                SelectW );
+    Planes[1] = XMVectorSelect( BasePlanes[1], XMVectorSplatX( -XMLoadFloat( &pVolume->Far ) ),
+                                SelectW );
+    Planes[2] = XMVectorSelect( BasePlanes[2], XMVectorSplatX( -XMLoadFloat( &pVolume->RightSlope ) ),
+                                SelectZ );
+    Planes[3] = XMVectorSelect( BasePlanes[3], XMVectorSplatX(  XMLoadFloat( &pVolume->LeftSlope ) ),
+                                SelectZ );
+    Planes[4] = XMVectorSelect( BasePlanes[4], XMVectorSplatX( -XMLoadFloat( &pVolume->TopSlope ) ),
+                                SelectZ );
+    Planes[5] = XMVectorSelect( BasePlanes[5], XMVectorSplatX(  XMLoadFloat( &pVolume->BottomSlope ) ),
+                                SelectZ );
 
-    XMVECTOR Zero = XMVectorZero();
+    // Load origin and orientation.
+    XMVECTOR Origin = XMLoadFloat3( &pVolume->Origin );
+    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
 
-    // Load the box.
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
 
-    XMVECTOR BoxMin = Center - Extents;
-    XMVECTOR BoxMax = Center + Extents;
+    // Transform point into local space of frustum.
+    XMVECTOR TPoint = XMVector3InverseRotate( Point - Origin, Orientation );
 
-    // Test the axes of the box (in effect test the AAB against the minimal AAB 
-    // around the triangle).
-    XMVECTOR TriMin = XMVectorMin( XMVectorMin( V0, V1 ), V2 );
-    XMVECTOR TriMax = XMVectorMax( XMVectorMax( V0, V1 ), V2 );
+    // Set w to one.
+    TPoint = XMVectorInsert<0, 0, 0, 0, 1>( TPoint, XMVectorSplatOne() );
 
-    // for each i in (x, y, z) if a_min(i) > b_max(i) or b_min(i) > a_max(i) then disjoint
-    XMVECTOR Disjoint = XMVectorOrInt( XMVectorGreater( TriMin, BoxMax ), XMVectorGreater( BoxMin, TriMax ) );
-    if( XMVector3AnyTrue( Disjoint ) )
-        return FALSE;
+    XMVECTOR Zero = XMVectorZero();
+    XMVECTOR Outside = Zero;
 
-    // Test the plane of the triangle.
-    XMVECTOR Normal = XMVector3Cross( V1 - V0, V2 - V0 );
-    XMVECTOR Dist = XMVector3Dot( Normal, V0 );
+    // Test point against each plane of the frustum.
+    for( INT i = 0; i < 6; i++ )
+    {
+        XMVECTOR Dot = XMVector4Dot( TPoint, Planes[i] );
+        Outside = XMVectorOrInt( Outside, XMVectorGreater( Dot, Zero ) );
+    }
 
-    // Assert that the triangle is not degenerate.
-    XMASSERT( !XMVector3Equal( Normal, Zero ) );
+    return XMVector4NotEqualInt( Outside, XMVectorTrueInt() );
+}
 
-    // for each i in (x, y, z) if n(i) >= 0 then v_min(i)=b_min(i), v_max(i)=b_max(i)
-    // else v_min(i)=b_max(i), v_max(i)=b_min(i)
-    XMVECTOR NormalSelect = XMVectorGreater( Normal, Zero );
-    XMVECTOR V_Min = XMVectorSelect( BoxMax, BoxMin, NormalSelect );
-    XMVECTOR V_Max = XMVectorSelect( BoxMin, BoxMax, NormalSelect );
 
-    // if n dot v_min + d > 0 || n dot v_max + d < 0 then disjoint
-    XMVECTOR MinDist = XMVector3Dot( V_Min, Normal );
-    XMVECTOR MaxDist = XMVector3Dot( V_Max, Normal );
 
-    XMVECTOR NoIntersection = XMVectorGreater( MinDist, Dist );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( MaxDist, Dist ) );
+//-----------------------------------------------------------------------------
+// Compute the intersection of a ray (Origin, Direction) with a triangle 
+// (V0, V1, V2).  Return TRUE if there is an intersection and also set *pDist 
+// to the distance along the ray to the intersection.
+// 
+// The algorithm is based on Moller, Tomas and Trumbore, "Fast, Minimum Storage 
+// Ray-Triangle Intersection", Journal of Graphics Tools, vol. 2, no. 1, 
+// pp 21-28, 1997.
+//-----------------------------------------------------------------------------
+BOOL IntersectRayTriangle( FXMVECTOR Origin, FXMVECTOR Direction, FXMVECTOR V0, CXMVECTOR V1, CXMVECTOR V2,
+                           FLOAT* pDist )
+{
+    XMASSERT( pDist );
+    XMASSERT( XMVector3IsUnit( Direction ) );
 
-    // Move the box center to zero to simplify the following tests.
-    XMVECTOR TV0 = V0 - Center;
-    XMVECTOR TV1 = V1 - Center;
-    XMVECTOR TV2 = V2 - Center;
+    static const XMVECTOR Epsilon =
+    {
+        1e-20f, 1e-20f, 1e-20f, 1e-20f
+    };
 
-    // Test the edge/edge axes (3*3).
-    XMVECTOR e0 = TV1 - TV0;
-    XMVECTOR e1 = TV2 - TV1;
-    XMVECTOR e2 = TV0 - TV2;
+    XMVECTOR Zero = XMVectorZero();
 
-    // Make w zero.
-    e0 = XMVectorInsert( e0, Zero, 0, 0, 0, 0, 1 );
-    e1 = XMVectorInsert( e1, Zero, 0, 0, 0, 0, 1 );
-    e2 = XMVectorInsert( e2, Zero, 0, 0, 0, 0, 1 );
+    XMVECTOR e1 = V1 - V0;
+    XMVECTOR e2 = V2 - V0;
 
-    XMVECTOR Axis;
-    XMVECTOR p0, p1, p2;
-    XMVECTOR Min, Max;
-    XMVECTOR Radius;
-
-    // Axis == (1,0,0) x e0 = (0, -e0.z, e0.y)
-    Axis = XMVectorPermute( e0, -e0, Permute0W1Z0Y0X );
-    p0 = XMVector3Dot( TV0, Axis );
-    // p1 = XMVector3Dot( V1, Axis ); // p1 = p0;
-    p2 = XMVector3Dot( TV2, Axis );
-    Min = XMVectorMin( p0, p2 );
-    Max = XMVectorMax( p0, p2 );
-    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
-
-    // Axis == (1,0,0) x e1 = (0, -e1.z, e1.y)
-    Axis = XMVectorPermute( e1, -e1, Permute0W1Z0Y0X );
-    p0 = XMVector3Dot( TV0, Axis );
-    p1 = XMVector3Dot( TV1, Axis );
-    // p2 = XMVector3Dot( V2, Axis ); // p2 = p1;
-    Min = XMVectorMin( p0, p1 );
-    Max = XMVectorMax( p0, p1 );
-    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+    // p = Direction ^ e2;
+    XMVECTOR p = XMVector3Cross( Direction, e2 );
 
-    // Axis == (1,0,0) x e2 = (0, -e2.z, e2.y)
-    Axis = XMVectorPermute( e2, -e2, Permute0W1Z0Y0X );
-    p0 = XMVector3Dot( TV0, Axis );
-    p1 = XMVector3Dot( TV1, Axis );
-    // p2 = XMVector3Dot( V2, Axis ); // p2 = p0;
-    Min = XMVectorMin( p0, p1 );
-    Max = XMVectorMax( p0, p1 );
-    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+    // det = e1 * p;
+    XMVECTOR det = XMVector3Dot( e1, p );
 
-    // Axis == (0,1,0) x e0 = (e0.z, 0, -e0.x)
-    Axis = XMVectorPermute( e0, -e0, Permute0Z0W1X0Y );
-    p0 = XMVector3Dot( TV0, Axis );
-    // p1 = XMVector3Dot( V1, Axis ); // p1 = p0;
-    p2 = XMVector3Dot( TV2, Axis );
-    Min = XMVectorMin( p0, p2 );
-    Max = XMVectorMax( p0, p2 );
-    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+    XMVECTOR u, v, t;
 
-    // Axis == (0,1,0) x e1 = (e1.z, 0, -e1.x)
-    Axis = XMVectorPermute( e1, -e1, Permute0Z0W1X0Y );
-    p0 = XMVector3Dot( TV0, Axis );
-    p1 = XMVector3Dot( TV1, Axis );
-    // p2 = XMVector3Dot( V2, Axis ); // p2 = p1;
-    Min = XMVectorMin( p0, p1 );
-    Max = XMVectorMax( p0, p1 );
-    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+    if( XMVector3GreaterOrEqual( det, Epsilon ) )
+    {
+        // Determinate is positive (front side of the triangle).
+        XMVECTOR s = Origin - V0;
 
-    // Axis == (0,0,1) x e2 = (e2.z, 0, -e2.x)
-    Axis = XMVectorPermute( e2, -e2, Permute0Z0W1X0Y );
-    p0 = XMVector3Dot( TV0, Axis );
-    p1 = XMVector3Dot( TV1, Axis );
-    // p2 = XMVector3Dot( V2, Axis ); // p2 = p0;
-    Min = XMVectorMin( p0, p1 );
-    Max = XMVectorMax( p0, p1 );
-    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+        // u = s * p;
+        u = XMVector3Dot( s, p );
 
-    // Axis == (0,0,1) x e0 = (-e0.y, e0.x, 0)
-    Axis = XMVectorPermute( e0, -e0, Permute1Y0X0W0Z );
-    p0 = XMVector3Dot( TV0, Axis );
-    // p1 = XMVector3Dot( V1, Axis ); // p1 = p0;
-    p2 = XMVector3Dot( TV2, Axis );
-    Min = XMVectorMin( p0, p2 );
-    Max = XMVectorMax( p0, p2 );
-    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+        XMVECTOR NoIntersection = XMVectorLess( u, Zero );
+        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( u, det ) );
 
-    // Axis == (0,0,1) x e1 = (-e1.y, e1.x, 0)
-    Axis = XMVectorPermute( e1, -e1, Permute1Y0X0W0Z );
-    p0 = XMVector3Dot( TV0, Axis );
-    p1 = XMVector3Dot( TV1, Axis );
-    // p2 = XMVector3Dot( V2, Axis ); // p2 = p1;
-    Min = XMVectorMin( p0, p1 );
-    Max = XMVectorMax( p0, p1 );
-    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+        // q = s ^ e1;
+        XMVECTOR q = XMVector3Cross( s, e1 );
 
-    // Axis == (0,0,1) x e2 = (-e2.y, e2.x, 0)
-    Axis = XMVectorPermute( e2, -e2, Permute1Y0X0W0Z );
-    p0 = XMVector3Dot( TV0, Axis );
-    p1 = XMVector3Dot( TV1, Axis );
-    // p2 = XMVector3Dot( V2, Axis ); // p2 = p0;
-    Min = XMVectorMin( p0, p1 );
-    Max = XMVectorMax( p0, p1 );
-    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+        // v = Direction * q;
+        v = XMVector3Dot( Direction, q );
 
-    return XMVector4NotEqualInt( NoIntersection, XMVectorTrueInt() );
-}
+        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( v, Zero ) );
+        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( u + v, det ) );
 
+        // t = e2 * q;
+        t = XMVector3Dot( e2, q );
 
+        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( t, Zero ) );
 
-//-----------------------------------------------------------------------------
-BOOL IntersectTriangleOrientedBox( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const OrientedBox* pVolume )
-{
-    XMASSERT( pVolume );
+        if( XMVector4EqualInt( NoIntersection, XMVectorTrueInt() ) )
+            return FALSE;
+    }
+    else if( XMVector3LessOrEqual( det, -Epsilon ) )
+    {
+        // Determinate is negative (back side of the triangle).
+        XMVECTOR s = Origin - V0;
 
-    // Load the box center & orientation.
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
+        // u = s * p;
+        u = XMVector3Dot( s, p );
 
-    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+        XMVECTOR NoIntersection = XMVectorGreater( u, Zero );
+        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( u, det ) );
 
-    // Transform the triangle vertices into the space of the box.
-    XMVECTOR TV0 = XMVector3InverseRotate( V0 - Center, Orientation );
-    XMVECTOR TV1 = XMVector3InverseRotate( V1 - Center, Orientation );
-    XMVECTOR TV2 = XMVector3InverseRotate( V2 - Center, Orientation );
+        // q = s ^ e1;
+        XMVECTOR q = XMVector3Cross( s, e1 );
 
-    AxisAlignedBox Box;
-    Box.Center = XMFLOAT3( 0.0f, 0.0f, 0.0f );
-    Box.Extents = pVolume->Extents;
+        // v = Direction * q;
+        v = XMVector3Dot( Direction, q );
 
-    // Use the triangle vs axis aligned box intersection routine.
-    return IntersectTriangleAxisAlignedBox( TV0, TV1, TV2, &Box );
-}
+        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( v, Zero ) );
+        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( u + v, det ) );
 
+        // t = e2 * q;
+        t = XMVector3Dot( e2, q );
 
+        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( t, Zero ) );
 
-//-----------------------------------------------------------------------------
-BOOL IntersectSphereSphere( const Sphere* pVolumeA, const Sphere* pVolumeB )
-{
-    XMASSERT( pVolumeA );
-    XMASSERT( pVolumeB );
+        if ( XMVector4EqualInt( NoIntersection, XMVectorTrueInt() ) )
+            return FALSE;
+    }
+    else
+    {
+        // Parallel ray.
+        return FALSE;
+    }
 
-    // Load A.
-    XMVECTOR CenterA = XMLoadFloat3( &pVolumeA->Center );
-    XMVECTOR RadiusA = XMVectorReplicatePtr( &pVolumeA->Radius );
+    XMVECTOR inv_det = XMVectorReciprocal( det );
 
-    // Load B.
-    XMVECTOR CenterB = XMLoadFloat3( &pVolumeB->Center );
-    XMVECTOR RadiusB = XMVectorReplicatePtr( &pVolumeB->Radius );
+    t *= inv_det;
 
-    // Distance squared between centers.    
-    XMVECTOR Delta = CenterB - CenterA;
-    XMVECTOR DistanceSquared = XMVector3LengthSq( Delta );
+    // u * inv_det and v * inv_det are the barycentric cooridinates of the intersection.
 
-    // Sum of the radii sqaured.
-    XMVECTOR RadiusSquared = RadiusA + RadiusB;
-    RadiusSquared = RadiusSquared * RadiusSquared;
+    // Store the x-component to *pDist
+    XMStoreFloat( pDist, t );
 
-    return XMVector4LessOrEqual( DistanceSquared, RadiusSquared );
+    return TRUE;
 }
 
 
 
 //-----------------------------------------------------------------------------
-BOOL IntersectSphereAxisAlignedBox( const Sphere* pVolumeA, const AxisAlignedBox* pVolumeB )
+// Compute the intersection of a ray (Origin, Direction) with a sphere.
+//-----------------------------------------------------------------------------
+BOOL IntersectRaySphere( FXMVECTOR Origin, FXMVECTOR Direction, const Sphere* pVolume, FLOAT* pDist )
 {
-    XMASSERT( pVolumeA );
-    XMASSERT( pVolumeB );
+    XMASSERT( pVolume );
+    XMASSERT( pDist );
+    XMASSERT( XMVector3IsUnit( Direction ) );
 
-    XMVECTOR SphereCenter = XMLoadFloat3( &pVolumeA->Center );
-    XMVECTOR SphereRadius = XMVectorReplicatePtr( &pVolumeA->Radius );
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
 
-    XMVECTOR BoxCenter = XMLoadFloat3( &pVolumeB->Center );
-    XMVECTOR BoxExtents = XMLoadFloat3( &pVolumeB->Extents );
+    // l is the vector from the ray origin to the center of the sphere.
+    XMVECTOR l = Center - Origin;
 
-    XMVECTOR BoxMin = BoxCenter - BoxExtents;
-    XMVECTOR BoxMax = BoxCenter + BoxExtents;
+    // s is the projection of the l onto the ray direction.
+    XMVECTOR s = XMVector3Dot( l, Direction );
 
-    // Find the distance to the nearest point on the box.
-    // for each i in (x, y, z)
-    // if (SphereCenter(i) < BoxMin(i)) d2 += (SphereCenter(i) - BoxMin(i)) ^ 2
-    // else if (SphereCenter(i) > BoxMax(i)) d2 += (SphereCenter(i) - BoxMax(i)) ^ 2
+    XMVECTOR l2 = XMVector3Dot( l, l );
 
-    XMVECTOR d = XMVectorZero();
+    XMVECTOR r2 = Radius * Radius;
 
-    // Compute d for each dimension.
-    XMVECTOR LessThanMin = XMVectorLess( SphereCenter, BoxMin );
-    XMVECTOR GreaterThanMax = XMVectorGreater( SphereCenter, BoxMax );
+    // m2 is squared distance from the center of the sphere to the projection.
+    XMVECTOR m2 = l2 - s * s;
 
-    XMVECTOR MinDelta = SphereCenter - BoxMin;
-    XMVECTOR MaxDelta = SphereCenter - BoxMax;
+    XMVECTOR NoIntersection;
 
-    // Choose value for each dimension based on the comparison.
-    d = XMVectorSelect( d, MinDelta, LessThanMin );
-    d = XMVectorSelect( d, MaxDelta, GreaterThanMax );
+    // If the ray origin is outside the sphere and the center of the sphere is 
+    // behind the ray origin there is no intersection.
+    NoIntersection = XMVectorAndInt( XMVectorLess( s, XMVectorZero() ), XMVectorGreater( l2, r2 ) );
 
-    // Use a dot-product to square them and sum them together.
-    XMVECTOR d2 = XMVector3Dot( d, d );
+    // If the squared distance from the center of the sphere to the projection
+    // is greater than the radius squared the ray will miss the sphere.
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( m2, r2 ) );
 
-    return XMVector4LessOrEqual( d2, XMVectorMultiply( SphereRadius, SphereRadius ) );
+    // The ray hits the sphere, compute the nearest intersection point.
+    XMVECTOR q = XMVectorSqrt( r2 - m2 );
+    XMVECTOR t1 = s - q;
+    XMVECTOR t2 = s + q;
+
+    XMVECTOR OriginInside = XMVectorLessOrEqual( l2, r2 );
+    XMVECTOR t = XMVectorSelect( t1, t2, OriginInside );
+
+    if( XMVector4NotEqualInt( NoIntersection, XMVectorTrueInt() ) )
+    {
+        // Store the x-component to *pDist.
+        XMStoreFloat( pDist, t );
+        return TRUE;
+    }
+
+    return FALSE;
 }
 
 
 
 //-----------------------------------------------------------------------------
-BOOL IntersectSphereOrientedBox( const Sphere* pVolumeA, const OrientedBox* pVolumeB )
+// Compute the intersection of a ray (Origin, Direction) with an axis aligned 
+// box using the slabs method.
+//-----------------------------------------------------------------------------
+BOOL IntersectRayAxisAlignedBox( FXMVECTOR Origin, FXMVECTOR Direction, const AxisAlignedBox* pVolume, FLOAT* pDist )
 {
-    XMASSERT( pVolumeA );
-    XMASSERT( pVolumeB );
+    XMASSERT( pVolume );
+    XMASSERT( pDist );
+    XMASSERT( XMVector3IsUnit( Direction ) );
 
-    XMVECTOR SphereCenter = XMLoadFloat3( &pVolumeA->Center );
-    XMVECTOR SphereRadius = XMVectorReplicatePtr( &pVolumeA->Radius );
+    static const XMVECTOR Epsilon =
+    {
+        1e-20f, 1e-20f, 1e-20f, 1e-20f
+    };
+    static const XMVECTOR FltMin =
+    {
+        -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX
+    };
+    static const XMVECTOR FltMax =
+    {
+        FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX
+    };
 
-    XMVECTOR BoxCenter = XMLoadFloat3( &pVolumeB->Center );
-    XMVECTOR BoxExtents = XMLoadFloat3( &pVolumeB->Extents );
-    XMVECTOR BoxOrientation = XMLoadFloat4( &pVolumeB->Orientation );
+    // Load the box.
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
 
-    XMASSERT( XMQuaternionIsUnit( BoxOrientation ) );
+    // Adjust ray origin to be relative to center of the box.
+    XMVECTOR TOrigin = Center - Origin;
 
-    // Transform the center of the sphere to be local to the box.
-    // BoxMin = -BoxExtents
-    // BoxMax = +BoxExtents
-    SphereCenter = XMVector3InverseRotate( SphereCenter - BoxCenter, BoxOrientation );
+    // Compute the dot product againt each axis of the box.
+    // Since the axii are (1,0,0), (0,1,0), (0,0,1) no computation is necessary.
+    XMVECTOR AxisDotOrigin = TOrigin;
+    XMVECTOR AxisDotDirection = Direction;
 
-    // Find the distance to the nearest point on the box.
-    // for each i in (x, y, z)
-    // if (SphereCenter(i) < BoxMin(i)) d2 += (SphereCenter(i) - BoxMin(i)) ^ 2
-    // else if (SphereCenter(i) > BoxMax(i)) d2 += (SphereCenter(i) - BoxMax(i)) ^ 2
+    // if (fabs(AxisDotDirection) <= Epsilon) the ray is nearly parallel to the slab.
+    XMVECTOR IsParallel = XMVectorLessOrEqual( XMVectorAbs( AxisDotDirection ), Epsilon );
 
-    XMVECTOR d = XMVectorZero();
+    // Test against all three axii simultaneously.
+    XMVECTOR InverseAxisDotDirection = XMVectorReciprocal( AxisDotDirection );
+    XMVECTOR t1 = ( AxisDotOrigin - Extents ) * InverseAxisDotDirection;
+    XMVECTOR t2 = ( AxisDotOrigin + Extents ) * InverseAxisDotDirection;
 
-    // Compute d for each dimension.
-    XMVECTOR LessThanMin = XMVectorLess( SphereCenter, -BoxExtents );
-    XMVECTOR GreaterThanMax = XMVectorGreater( SphereCenter, BoxExtents );
+    // Compute the max of min(t1,t2) and the min of max(t1,t2) ensuring we don't
+    // use the results from any directions parallel to the slab.
+    XMVECTOR t_min = XMVectorSelect( XMVectorMin( t1, t2 ), FltMin, IsParallel );
+    XMVECTOR t_max = XMVectorSelect( XMVectorMax( t1, t2 ), FltMax, IsParallel );
 
-    XMVECTOR MinDelta = SphereCenter + BoxExtents;
-    XMVECTOR MaxDelta = SphereCenter - BoxExtents;
+    // t_min.x = maximum( t_min.x, t_min.y, t_min.z );
+    // t_max.x = minimum( t_max.x, t_max.y, t_max.z );
+    t_min = XMVectorMax( t_min, XMVectorSplatY( t_min ) );  // x = max(x,y)
+    t_min = XMVectorMax( t_min, XMVectorSplatZ( t_min ) );  // x = max(max(x,y),z)
+    t_max = XMVectorMin( t_max, XMVectorSplatY( t_max ) );  // x = min(x,y)
+    t_max = XMVectorMin( t_max, XMVectorSplatZ( t_max ) );  // x = min(min(x,y),z)
 
-    // Choose value for each dimension based on the comparison.
-    d = XMVectorSelect( d, MinDelta, LessThanMin );
-    d = XMVectorSelect( d, MaxDelta, GreaterThanMax );
+    // if ( t_min > t_max ) return FALSE;
+    XMVECTOR NoIntersection = XMVectorGreater( XMVectorSplatX( t_min ), XMVectorSplatX( t_max ) );
 
-    // Use a dot-product to square them and sum them together.
-    XMVECTOR d2 = XMVector3Dot( d, d );
+    // if ( t_max < 0.0f ) return FALSE;
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( XMVectorSplatX( t_max ), XMVectorZero() ) );
 
-    return XMVector4LessOrEqual( d2, XMVectorMultiply( SphereRadius, SphereRadius ) );
+    // if (IsParallel && (-Extents > AxisDotOrigin || Extents < AxisDotOrigin)) return FALSE;
+    XMVECTOR ParallelOverlap = XMVectorInBounds( AxisDotOrigin, Extents );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorAndCInt( IsParallel, ParallelOverlap ) );
+
+    if( !XMVector3AnyTrue( NoIntersection ) )
+    {
+        // Store the x-component to *pDist
+        XMStoreFloat( pDist, t_min );
+        return TRUE;
+    }
+
+    return FALSE;
 }
 
 
 
 //-----------------------------------------------------------------------------
-BOOL IntersectAxisAlignedBoxAxisAlignedBox( const AxisAlignedBox* pVolumeA, const AxisAlignedBox* pVolumeB )
+// Compute the intersection of a ray (Origin, Direction) with an oriented box
+// using the slabs method.
+//-----------------------------------------------------------------------------
+BOOL IntersectRayOrientedBox( FXMVECTOR Origin, FXMVECTOR Direction, const OrientedBox* pVolume, FLOAT* pDist )
 {
-    XMASSERT( pVolumeA );
-    XMASSERT( pVolumeB );
+    XMASSERT( pVolume );
+    XMASSERT( pDist );
+    XMASSERT( XMVector3IsUnit( Direction ) );
 
-    XMVECTOR CenterA = XMLoadFloat3( &pVolumeA->Center );
-    XMVECTOR ExtentsA = XMLoadFloat3( &pVolumeA->Extents );
+    static const XMVECTOR Epsilon =
+    {
+        1e-20f, 1e-20f, 1e-20f, 1e-20f
+    };
+    static const XMVECTOR FltMin =
+    {
+        -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX
+    };
+    static const XMVECTOR FltMax =
+    {
+        FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX
+    };
+    static const XMVECTORU32 SelectY =
+    {
+        XM_SELECT_0, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0
+    };
+    static const XMVECTORU32 SelectZ =
+    {
+        XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0
+    };
 
-    XMVECTOR CenterB = XMLoadFloat3( &pVolumeB->Center );
-    XMVECTOR ExtentsB = XMLoadFloat3( &pVolumeB->Extents );
+    // Load the box.
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
+    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
 
-    XMVECTOR MinA = CenterA - ExtentsA;
-    XMVECTOR MaxA = CenterA + ExtentsA;
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
 
-    XMVECTOR MinB = CenterB - ExtentsB;
-    XMVECTOR MaxB = CenterB + ExtentsB;
+    // Get the boxes normalized side directions.
+    XMMATRIX R = XMMatrixRotationQuaternion( Orientation );
 
-    // for each i in (x, y, z) if a_min(i) > b_max(i) or b_min(i) > a_max(i) then return FALSE
-    XMVECTOR Disjoint = XMVectorOrInt( XMVectorGreater( MinA, MaxB ), XMVectorGreater( MinB, MaxA ) );
+    // Adjust ray origin to be relative to center of the box.
+    XMVECTOR TOrigin = Center - Origin;
 
-    return !XMVector3AnyTrue( Disjoint );
-}
+    // Compute the dot product againt each axis of the box.
+    XMVECTOR AxisDotOrigin = XMVector3Dot( R.r[0], TOrigin );
+    AxisDotOrigin = XMVectorSelect( AxisDotOrigin, XMVector3Dot( R.r[1], TOrigin ), SelectY );
+    AxisDotOrigin = XMVectorSelect( AxisDotOrigin, XMVector3Dot( R.r[2], TOrigin ), SelectZ );
 
+    XMVECTOR AxisDotDirection = XMVector3Dot( R.r[0], Direction );
+    AxisDotDirection = XMVectorSelect( AxisDotDirection, XMVector3Dot( R.r[1], Direction ), SelectY );
+    AxisDotDirection = XMVectorSelect( AxisDotDirection, XMVector3Dot( R.r[2], Direction ), SelectZ );
 
+    // if (fabs(AxisDotDirection) <= Epsilon) the ray is nearly parallel to the slab.
+    XMVECTOR IsParallel = XMVectorLessOrEqual( XMVectorAbs( AxisDotDirection ), Epsilon );
 
-//-----------------------------------------------------------------------------
-BOOL IntersectAxisAlignedBoxOrientedBox( const AxisAlignedBox* pVolumeA, const OrientedBox* pVolumeB )
-{
-    XMASSERT( pVolumeA );
-    XMASSERT( pVolumeB );
+    // Test against all three axes simultaneously.
+    XMVECTOR InverseAxisDotDirection = XMVectorReciprocal( AxisDotDirection );
+    XMVECTOR t1 = ( AxisDotOrigin - Extents ) * InverseAxisDotDirection;
+    XMVECTOR t2 = ( AxisDotOrigin + Extents ) * InverseAxisDotDirection;
 
-    // Make the axis aligned box oriented and do an OBB vs OBB test.
-    OrientedBox BoxA;
+    // Compute the max of min(t1,t2) and the min of max(t1,t2) ensuring we don't
+    // use the results from any directions parallel to the slab.
+    XMVECTOR t_min = XMVectorSelect( XMVectorMin( t1, t2 ), FltMin, IsParallel );
+    XMVECTOR t_max = XMVectorSelect( XMVectorMax( t1, t2 ), FltMax, IsParallel );
 
-    BoxA.Center = pVolumeA->Center;
-    BoxA.Extents = pVolumeA->Extents;
-    BoxA.Orientation.x = 0.0f;
-    BoxA.Orientation.y = 0.0f;
-    BoxA.Orientation.z = 0.0f;
-    BoxA.Orientation.w = 1.0f;
+    // t_min.x = maximum( t_min.x, t_min.y, t_min.z );
+    // t_max.x = minimum( t_max.x, t_max.y, t_max.z );
+    t_min = XMVectorMax( t_min, XMVectorSplatY( t_min ) );  // x = max(x,y)
+    t_min = XMVectorMax( t_min, XMVectorSplatZ( t_min ) );  // x = max(max(x,y),z)
+    t_max = XMVectorMin( t_max, XMVectorSplatY( t_max ) );  // x = min(x,y)
+    t_max = XMVectorMin( t_max, XMVectorSplatZ( t_max ) );  // x = min(min(x,y),z)
 
-    return IntersectOrientedBoxOrientedBox( &BoxA, pVolumeB );
+    // if ( t_min > t_max ) return FALSE;
+    XMVECTOR NoIntersection = XMVectorGreater( XMVectorSplatX( t_min ), XMVectorSplatX( t_max ) );
+
+    // if ( t_max < 0.0f ) return FALSE;
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( XMVectorSplatX( t_max ), XMVectorZero() ) );
+
+    // if (IsParallel && (-Extents > AxisDotOrigin || Extents < AxisDotOrigin)) return FALSE;
+    XMVECTOR ParallelOverlap = XMVectorInBounds( AxisDotOrigin, Extents );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorAndCInt( IsParallel, ParallelOverlap ) );
+
+    if( !XMVector3AnyTrue( NoIntersection ) )
+    {
+        // Store the x-component to *pDist
+        XMStoreFloat( pDist, t_min );
+        return TRUE;
+    }
+
+    return FALSE;
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Fast oriented box / oriented box intersection test using the separating axis 
-// theorem.
+// Test if two triangles intersect.
+//
+// The final test of algorithm is based on Shen, Heng, and Tang, "A Fast 
+// Triangle-Triangle Overlap Test Using Signed Distances", Journal of Graphics 
+// Tools, vol. 8, no. 1, pp 17-23, 2003 and Guigue and Devillers, "Fast and 
+// Robust Triangle-Triangle Overlap Test Using Orientation Predicates", Journal 
+// of Graphics Tools, vol. 8, no. 1, pp 25-32, 2003.
+//
+// The final test could be considered an edge-edge separating plane test with
+// the 9 possible cases narrowed down to the only two pairs of edges that can 
+// actaully result in a seperation.
 //-----------------------------------------------------------------------------
-BOOL IntersectOrientedBoxOrientedBox( const OrientedBox* pVolumeA, const OrientedBox* pVolumeB )
+BOOL IntersectTriangleTriangle( FXMVECTOR A0, FXMVECTOR A1, FXMVECTOR A2, CXMVECTOR B0, CXMVECTOR B1, CXMVECTOR B2 )
 {
-    static CONST XMVECTORI32 Permute0W1Z0Y0X =
-                 {
-                    XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X
-                 };
-    static CONST XMVECTORI32 Permute0Z0W1X0Y =
-                 {
-                    XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y
-                 };
-    static CONST XMVECTORI32 Permute1Y0X0W0Z =
-                 {
-                    XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z
-                 };
-    static CONST XMVECTORI32 PermuteWZYX =
-                 {
-                    XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X
-                 };
-    static CONST XMVECTORI32 PermuteZWXY =
-                 {
-                    XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y
-                 };
-    static CONST XMVECTORI32 PermuteYXWZ =
-                 {
-                    XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z
-                 };
+    static const XMVECTOR Epsilon =
+    {
+        1e-20f, 1e-20f, 1e-20f, 1e-20f
+    };
+    static const XMVECTORU32 SelectY =
+    {
+        XM_SELECT_0, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0
+    };
+    static const XMVECTORU32 SelectZ =
+    {
+        XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0
+    };
+    static const XMVECTORU32 Select0111 =
+    {
+        XM_SELECT_0, XM_SELECT_1, XM_SELECT_1, XM_SELECT_1
+    };
+    static const XMVECTORU32 Select1011 =
+    {
+        XM_SELECT_1, XM_SELECT_0, XM_SELECT_1, XM_SELECT_1
+    };
+    static const XMVECTORU32 Select1101 =
+    {
+        XM_SELECT_1, XM_SELECT_1, XM_SELECT_0, XM_SELECT_1
+    };
 
-    XMASSERT( pVolumeA );
-    XMASSERT( pVolumeB );
+    XMVECTOR Zero = XMVectorZero();
 
-    // Build the 3x3 rotation matrix that defines the orientation of B relative to A.
-    XMVECTOR A_quat = XMLoadFloat4( &pVolumeA->Orientation );
-    XMVECTOR B_quat = XMLoadFloat4( &pVolumeB->Orientation );
+    // Compute the normal of triangle A.
+    XMVECTOR N1 = XMVector3Cross( A1 - A0, A2 - A0 );
 
-    XMASSERT( XMQuaternionIsUnit( A_quat ) );
-    XMASSERT( XMQuaternionIsUnit( B_quat ) );
+    // Assert that the triangle is not degenerate.
+    XMASSERT( !XMVector3Equal( N1, Zero ) );
 
-    XMVECTOR Q = XMQuaternionMultiply( A_quat, XMQuaternionConjugate( B_quat ) );
-    XMMATRIX R = XMMatrixRotationQuaternion( Q );
+    // Test points of B against the plane of A.
+    XMVECTOR BDist = XMVector3Dot( N1, B0 - A0 );
+    BDist = XMVectorSelect( BDist, XMVector3Dot( N1, B1 - A0 ), SelectY );
+    BDist = XMVectorSelect( BDist, XMVector3Dot( N1, B2 - A0 ), SelectZ );
 
-    // Compute the translation of B relative to A.
-    XMVECTOR A_cent = XMLoadFloat3( &pVolumeA->Center );
-    XMVECTOR B_cent = XMLoadFloat3( &pVolumeB->Center );
-    XMVECTOR t = XMVector3InverseRotate( B_cent - A_cent, A_quat );
+    // Ensure robustness with co-planar triangles by zeroing small distances.
+    UINT BDistIsZeroCR;
+    XMVECTOR BDistIsZero = XMVectorGreaterR( &BDistIsZeroCR, Epsilon, XMVectorAbs( BDist ) );
+    BDist = XMVectorSelect( BDist, Zero, BDistIsZero );
 
-    //
-    // h(A) = extents of A.
-    // h(B) = extents of B.
-    //
-    // a(u) = axes of A = (1,0,0), (0,1,0), (0,0,1)
-    // b(u) = axes of B relative to A = (r00,r10,r20), (r01,r11,r21), (r02,r12,r22)
-    //  
-    // For each possible separating axis l:
-    //   d(A) = sum (for i = u,v,w) h(A)(i) * abs( a(i) dot l )
-    //   d(B) = sum (for i = u,v,w) h(B)(i) * abs( b(i) dot l )
-    //   if abs( t dot l ) > d(A) + d(B) then disjoint
-    //
+    UINT BDistIsLessCR;
+    XMVECTOR BDistIsLess = XMVectorGreaterR( &BDistIsLessCR, Zero, BDist );
+
+    UINT BDistIsGreaterCR;
+    XMVECTOR BDistIsGreater = XMVectorGreaterR( &BDistIsGreaterCR, BDist, Zero );
+
+    // If all the points are on the same side we don't intersect.
+    if( XMComparisonAllTrue( BDistIsLessCR ) || XMComparisonAllTrue( BDistIsGreaterCR ) )
+        return FALSE;
+
+    // Compute the normal of triangle B.
+    XMVECTOR N2 = XMVector3Cross( B1 - B0, B2 - B0 );
+
+    // Assert that the triangle is not degenerate.
+    XMASSERT( !XMVector3Equal( N2, Zero ) );
+
+    // Test points of A against the plane of B.
+    XMVECTOR ADist = XMVector3Dot( N2, A0 - B0 );
+    ADist = XMVectorSelect( ADist, XMVector3Dot( N2, A1 - B0 ), SelectY );
+    ADist = XMVectorSelect( ADist, XMVector3Dot( N2, A2 - B0 ), SelectZ );
+
+    // Ensure robustness with co-planar triangles by zeroing small distances.
+    UINT ADistIsZeroCR;
+    XMVECTOR ADistIsZero = XMVectorGreaterR( &ADistIsZeroCR, Epsilon, XMVectorAbs( BDist ) );
+    ADist = XMVectorSelect( ADist, Zero, ADistIsZero );
+
+    UINT ADistIsLessCR;
+    XMVECTOR ADistIsLess = XMVectorGreaterR( &ADistIsLessCR, Zero, ADist );
+
+    UINT ADistIsGreaterCR;
+    XMVECTOR ADistIsGreater = XMVectorGreaterR( &ADistIsGreaterCR, ADist, Zero );
+
+    // If all the points are on the same side we don't intersect.
+    if( XMComparisonAllTrue( ADistIsLessCR ) || XMComparisonAllTrue( ADistIsGreaterCR ) )
+        return FALSE;
+
+    // Special case for co-planar triangles.
+    if( XMComparisonAllTrue( ADistIsZeroCR ) || XMComparisonAllTrue( BDistIsZeroCR ) )
+    {
+        XMVECTOR Axis, Dist, MinDist;
+
+        // Compute an axis perpindicular to the edge (points out).
+        Axis = XMVector3Cross( N1, A1 - A0 );
+        Dist = XMVector3Dot( Axis, A0 );
+
+        // Test points of B against the axis.
+        MinDist = XMVector3Dot( B0, Axis );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( B1, Axis ) );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( B2, Axis ) );
+        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
+            return FALSE;
+
+        // Edge (A1, A2)
+        Axis = XMVector3Cross( N1, A2 - A1 );
+        Dist = XMVector3Dot( Axis, A1 );
+
+        MinDist = XMVector3Dot( B0, Axis );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( B1, Axis ) );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( B2, Axis ) );
+        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
+            return FALSE;
+
+        // Edge (A2, A0)
+        Axis = XMVector3Cross( N1, A0 - A2 );
+        Dist = XMVector3Dot( Axis, A2 );
+
+        MinDist = XMVector3Dot( B0, Axis );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( B1, Axis ) );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( B2, Axis ) );
+        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
+            return FALSE;
+
+        // Edge (B0, B1)
+        Axis = XMVector3Cross( N2, B1 - B0 );
+        Dist = XMVector3Dot( Axis, B0 );
+
+        MinDist = XMVector3Dot( A0, Axis );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( A1, Axis ) );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( A2, Axis ) );
+        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
+            return FALSE;
+
+        // Edge (B1, B2)
+        Axis = XMVector3Cross( N2, B2 - B1 );
+        Dist = XMVector3Dot( Axis, B1 );
+
+        MinDist = XMVector3Dot( A0, Axis );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( A1, Axis ) );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( A2, Axis ) );
+        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
+            return FALSE;
+
+        // Edge (B2,B0)
+        Axis = XMVector3Cross( N2, B0 - B2 );
+        Dist = XMVector3Dot( Axis, B2 );
+
+        MinDist = XMVector3Dot( A0, Axis );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( A1, Axis ) );
+        MinDist = XMVectorMin( MinDist, XMVector3Dot( A2, Axis ) );
+        if( XMVector4GreaterOrEqual( MinDist, Dist ) )
+            return FALSE;
+
+        return TRUE;
+    }
+
+    //
+    // Find the single vertex of A and B (ie the vertex on the opposite side
+    // of the plane from the other two) and reorder the edges so we can compute 
+    // the signed edge/edge distances.
+    //
+    // if ( (V0 >= 0 && V1 <  0 && V2 <  0) ||
+    //      (V0 >  0 && V1 <= 0 && V2 <= 0) ||
+    //      (V0 <= 0 && V1 >  0 && V2 >  0) ||
+    //      (V0 <  0 && V1 >= 0 && V2 >= 0) ) then V0 is singular;
+    //
+    // If our singular vertex is not on the positive side of the plane we reverse
+    // the triangle winding so that the overlap comparisons will compare the 
+    // correct edges with the correct signs.
+    //
+    XMVECTOR ADistIsLessEqual = XMVectorOrInt( ADistIsLess, ADistIsZero );
+    XMVECTOR ADistIsGreaterEqual = XMVectorOrInt( ADistIsGreater, ADistIsZero );
+
+    XMVECTOR AA0, AA1, AA2;
+    bool bPositiveA;
+
+    if( XMVector3AllTrue( XMVectorSelect( ADistIsGreaterEqual, ADistIsLess, Select0111 ) ) ||
+        XMVector3AllTrue( XMVectorSelect( ADistIsGreater, ADistIsLessEqual, Select0111 ) ) )
+    {
+        // A0 is singular, crossing from positive to negative.
+        AA0 = A0; AA1 = A1; AA2 = A2;
+        bPositiveA = true;
+    }
+    else if( XMVector3AllTrue( XMVectorSelect( ADistIsLessEqual, ADistIsGreater, Select0111 ) ) ||
+             XMVector3AllTrue( XMVectorSelect( ADistIsLess, ADistIsGreaterEqual, Select0111 ) ) )
+    {
+        // A0 is singular, crossing from negative to positive.
+        AA0 = A0; AA1 = A2; AA2 = A1;
+        bPositiveA = false;
+    }
+    else if( XMVector3AllTrue( XMVectorSelect( ADistIsGreaterEqual, ADistIsLess, Select1011 ) ) ||
+             XMVector3AllTrue( XMVectorSelect( ADistIsGreater, ADistIsLessEqual, Select1011 ) ) )
+    {
+        // A1 is singular, crossing from positive to negative.
+        AA0 = A1; AA1 = A2; AA2 = A0;
+        bPositiveA = true;
+    }
+    else if( XMVector3AllTrue( XMVectorSelect( ADistIsLessEqual, ADistIsGreater, Select1011 ) ) ||
+             XMVector3AllTrue( XMVectorSelect( ADistIsLess, ADistIsGreaterEqual, Select1011 ) ) )
+    {
+        // A1 is singular, crossing from negative to positive.
+        AA0 = A1; AA1 = A0; AA2 = A2;
+        bPositiveA = false;
+    }
+    else if( XMVector3AllTrue( XMVectorSelect( ADistIsGreaterEqual, ADistIsLess, Select1101 ) ) ||
+             XMVector3AllTrue( XMVectorSelect( ADistIsGreater, ADistIsLessEqual, Select1101 ) ) )
+    {
+        // A2 is singular, crossing from positive to negative.
+        AA0 = A2; AA1 = A0; AA2 = A1;
+        bPositiveA = true;
+    }
+    else if( XMVector3AllTrue( XMVectorSelect( ADistIsLessEqual, ADistIsGreater, Select1101 ) ) ||
+             XMVector3AllTrue( XMVectorSelect( ADistIsLess, ADistIsGreaterEqual, Select1101 ) ) )
+    {
+        // A2 is singular, crossing from negative to positive.
+        AA0 = A2; AA1 = A1; AA2 = A0;
+        bPositiveA = false;
+    }
+    else
+    {
+        XMASSERT( FALSE );
+        return FALSE;
+    }
+
+    XMVECTOR BDistIsLessEqual = XMVectorOrInt( BDistIsLess, BDistIsZero );
+    XMVECTOR BDistIsGreaterEqual = XMVectorOrInt( BDistIsGreater, BDistIsZero );
+
+    XMVECTOR BB0, BB1, BB2;
+    bool bPositiveB;
+
+    if( XMVector3AllTrue( XMVectorSelect( BDistIsGreaterEqual, BDistIsLess, Select0111 ) ) ||
+        XMVector3AllTrue( XMVectorSelect( BDistIsGreater, BDistIsLessEqual, Select0111 ) ) )
+    {
+        // B0 is singular, crossing from positive to negative.
+        BB0 = B0; BB1 = B1; BB2 = B2;
+        bPositiveB = true;
+    }
+    else if( XMVector3AllTrue( XMVectorSelect( BDistIsLessEqual, BDistIsGreater, Select0111 ) ) ||
+             XMVector3AllTrue( XMVectorSelect( BDistIsLess, BDistIsGreaterEqual, Select0111 ) ) )
+    {
+        // B0 is singular, crossing from negative to positive.
+        BB0 = B0; BB1 = B2; BB2 = B1;
+        bPositiveB = false;
+    }
+    else if( XMVector3AllTrue( XMVectorSelect( BDistIsGreaterEqual, BDistIsLess, Select1011 ) ) ||
+             XMVector3AllTrue( XMVectorSelect( BDistIsGreater, BDistIsLessEqual, Select1011 ) ) )
+    {
+        // B1 is singular, crossing from positive to negative.
+        BB0 = B1; BB1 = B2; BB2 = B0;
+        bPositiveB = true;
+    }
+    else if( XMVector3AllTrue( XMVectorSelect( BDistIsLessEqual, BDistIsGreater, Select1011 ) ) ||
+             XMVector3AllTrue( XMVectorSelect( BDistIsLess, BDistIsGreaterEqual, Select1011 ) ) )
+    {
+        // B1 is singular, crossing from negative to positive.
+        BB0 = B1; BB1 = B0; BB2 = B2;
+        bPositiveB = false;
+    }
+    else if( XMVector3AllTrue( XMVectorSelect( BDistIsGreaterEqual, BDistIsLess, Select1101 ) ) ||
+             XMVector3AllTrue( XMVectorSelect( BDistIsGreater, BDistIsLessEqual, Select1101 ) ) )
+    {
+        // B2 is singular, crossing from positive to negative.
+        BB0 = B2; BB1 = B0; BB2 = B1;
+        bPositiveB = true;
+    }
+    else if( XMVector3AllTrue( XMVectorSelect( BDistIsLessEqual, BDistIsGreater, Select1101 ) ) ||
+             XMVector3AllTrue( XMVectorSelect( BDistIsLess, BDistIsGreaterEqual, Select1101 ) ) )
+    {
+        // B2 is singular, crossing from negative to positive.
+        BB0 = B2; BB1 = B1; BB2 = B0;
+        bPositiveB = false;
+    }
+    else
+    {
+        XMASSERT( FALSE );
+        return FALSE;
+    }
+
+    XMVECTOR Delta0, Delta1;
+
+    // Reverse the direction of the test depending on whether the singular vertices are
+    // the same sign or different signs.
+    if( bPositiveA ^ bPositiveB )
+    {
+        Delta0 = ( BB0 - AA0 );
+        Delta1 = ( AA0 - BB0 );
+    }
+    else
+    {
+        Delta0 = ( AA0 - BB0 );
+        Delta1 = ( BB0 - AA0 );
+    }
+
+    // Check if the triangles overlap on the line of intersection between the
+    // planes of the two triangles by finding the signed line distances.
+    XMVECTOR Dist0 = XMVector3Dot( Delta0, XMVector3Cross( ( BB2 - BB0 ), ( AA2 - AA0 ) ) );
+    if( XMVector4Greater( Dist0, Zero ) )
+        return FALSE;
+
+    XMVECTOR Dist1 = XMVector3Dot( Delta1, XMVector3Cross( ( BB1 - BB0 ), ( AA1 - AA0 ) ) );
+    if( XMVector4Greater( Dist1, Zero ) )
+        return FALSE;
+
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL IntersectTriangleSphere( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const Sphere* pVolume )
+{
+    XMASSERT( pVolume );
+
+    // Load the sphere.    
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
+
+    // Compute the plane of the triangle (has to be normalized).
+    XMVECTOR N = XMVector3Normalize( XMVector3Cross( V1 - V0, V2 - V0 ) );
+
+    // Assert that the triangle is not degenerate.
+    XMASSERT( !XMVector3Equal( N, XMVectorZero() ) );
+
+    // Find the nearest feature on the triangle to the sphere.
+    XMVECTOR Dist = XMVector3Dot( Center - V0, N );
+
+    // If the center of the sphere is farther from the plane of the triangle than
+    // the radius of the sphere, then there cannot be an intersection.
+    XMVECTOR NoIntersection = XMVectorLess( Dist, -Radius );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Dist, Radius ) );
+
+    // Project the center of the sphere onto the plane of the triangle.
+    XMVECTOR Point = Center - ( N * Dist );
+
+    // Is it inside all the edges? If so we intersect because the distance 
+    // to the plane is less than the radius.
+    XMVECTOR Intersection = PointOnPlaneInsideTriangle( Point, V0, V1, V2 );
+
+    // Find the nearest point on each edge.
+    XMVECTOR RadiusSq = Radius * Radius;
+
+    // Edge 0,1
+    Point = PointOnLineSegmentNearestPoint( V0, V1, Center );
+
+    // If the distance to the center of the sphere to the point is less than 
+    // the radius of the sphere then it must intersect.
+    Intersection = XMVectorOrInt( Intersection, XMVectorLessOrEqual( XMVector3LengthSq( Center - Point ), RadiusSq ) );
+
+    // Edge 1,2
+    Point = PointOnLineSegmentNearestPoint( V1, V2, Center );
+
+    // If the distance to the center of the sphere to the point is less than 
+    // the radius of the sphere then it must intersect.
+    Intersection = XMVectorOrInt( Intersection, XMVectorLessOrEqual( XMVector3LengthSq( Center - Point ), RadiusSq ) );
+
+    // Edge 2,0
+    Point = PointOnLineSegmentNearestPoint( V2, V0, Center );
+
+    // If the distance to the center of the sphere to the point is less than 
+    // the radius of the sphere then it must intersect.
+    Intersection = XMVectorOrInt( Intersection, XMVectorLessOrEqual( XMVector3LengthSq( Center - Point ), RadiusSq ) );
+
+    return XMVector4EqualInt( XMVectorAndCInt( Intersection, NoIntersection ), XMVectorTrueInt() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Find the first contact of the moving sphere with the face, the edges and the
+// vertices of the triangle. The face is two sided; the sphere can only touch
+// it from the side its center starts on. Edges and vertices are hit where the
+// moving center comes within the radius of the line or the point.
+//-----------------------------------------------------------------------------
+BOOL IntersectSweptSphereTriangle( const Sphere* pVolume, FXMVECTOR Displacement, FXMVECTOR V0, FXMVECTOR V1,
+                                   CXMVECTOR V2, FLOAT* pTime, XMVECTOR* pNormal )
+{
+    XMASSERT( pVolume );
+    XMASSERT( pTime );
+    XMASSERT( pNormal );
+
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    FLOAT Radius = pVolume->Radius;
+    FLOAT RadiusSq = Radius * Radius;
+
+    XMVECTOR E01 = V1 - V0;
+    XMVECTOR E02 = V2 - V0;
+    XMVECTOR N = XMVector3Cross( E01, E02 );
+
+    // Degenerate triangles have no face, and their edges are those of the
+    // neighbouring triangles.
+    FLOAT NLengthSq = XMVectorGetX( XMVector3LengthSq( N ) );
+    if( NLengthSq <= 1e-12f * XMVectorGetX( XMVector3LengthSq( E01 ) * XMVector3LengthSq( E02 ) ) )
+        return FALSE;
+
+    N = N * ( 1.0f / sqrtf( NLengthSq ) );
+
+    // Orient the plane towards the center.
+    FLOAT Dist = XMVectorGetX( XMVector3Dot( Center - V0, N ) );
+    if( Dist < 0.0f )
+    {
+        N = -N;
+        Dist = -Dist;
+    }
+
+    // A sphere that already overlaps the triangle hits it right away, unless it
+    // is moving away from the nearest point.
+    XMVECTOR Nearest = PointOnTriangleNearestPoint( Center, V0, V1, V2 );
+    FLOAT NearestDistSq = XMVectorGetX( XMVector3LengthSq( Center - Nearest ) );
+    if( NearestDistSq <= RadiusSq )
+    {
+        XMVECTOR Normal = ( NearestDistSq > 1e-12f * RadiusSq ) ? XMVector3Normalize( Center - Nearest ) : N;
+        if( XMVectorGetX( XMVector3Dot( Displacement, Normal ) ) >= 0.0f )
+            return FALSE;
+
+        *pTime = 0.0f;
+        *pNormal = Normal;
+        return TRUE;
+    }
+
+    FLOAT MoveSq = XMVectorGetX( XMVector3LengthSq( Displacement ) );
+    if( MoveSq <= 0.0f )
+        return FALSE;
+
+    // The face: the sphere touches the plane at Dist - Radius along the
+    // approach. If that point is inside the triangle nothing else is hit first.
+    FLOAT Approach = -XMVectorGetX( XMVector3Dot( Displacement, N ) );
+    if( Dist >= Radius && Approach > 0.0f && Dist - Radius <= Approach )
+    {
+        FLOAT t = ( Dist - Radius ) / Approach;
+        XMVECTOR Point = Center + Displacement * t - N * Radius;
+
+        if( XMVector4EqualInt( PointOnPlaneInsideTriangle( Point, V0, V1, V2 ), XMVectorTrueInt() ) )
+        {
+            *pTime = t;
+            *pNormal = N;
+            return TRUE;
+        }
+    }
+
+    // The vertices: |Center + t * Displacement - V|^2 = Radius^2.
+    FLOAT Time = 1.0f;
+    XMVECTOR Contact = XMVectorZero();
+    BOOL Hit = FALSE;
+
+    XMVECTOR Vertices[3] = { V0, V1, V2 };
+
+    for( UINT i = 0; i < 3; i++ )
+    {
+        XMVECTOR W = Center - Vertices[i];
+
+        FLOAT B = 2.0f * XMVectorGetX( XMVector3Dot( Displacement, W ) );
+        FLOAT C = XMVectorGetX( XMVector3LengthSq( W ) ) - RadiusSq;
+
+        FLOAT t;
+        if( SmallestRootInRange( MoveSq, B, C, Time, &t ) )
+        {
+            Time = t;
+            Contact = Vertices[i];
+            Hit = TRUE;
+        }
+    }
+
+    // The edges: the distance of the center to the line through the edge is
+    // the radius, and the nearest point of the line is on the edge.
+    for( UINT i = 0; i < 3; i++ )
+    {
+        XMVECTOR Start = Vertices[i];
+        XMVECTOR Edge = Vertices[( i + 1 ) % 3] - Start;
+        XMVECTOR W = Center - Start;
+
+        FLOAT EdgeSq = XMVectorGetX( XMVector3LengthSq( Edge ) );
+        FLOAT EdgeDotMove = XMVectorGetX( XMVector3Dot( Edge, Displacement ) );
+        FLOAT EdgeDotW = XMVectorGetX( XMVector3Dot( Edge, W ) );
+
+        FLOAT A = EdgeSq * MoveSq - EdgeDotMove * EdgeDotMove;
+        FLOAT B = 2.0f * ( EdgeSq * XMVectorGetX( XMVector3Dot( W, Displacement ) ) - EdgeDotW * EdgeDotMove );
+        FLOAT C = EdgeSq * ( XMVectorGetX( XMVector3LengthSq( W ) ) - RadiusSq ) - EdgeDotW * EdgeDotW;
+
+        // Moving along the line, or already within the radius of it: the first
+        // contact with the edge, if any, is at one of its vertices.
+        if( A <= 1e-12f * EdgeSq * MoveSq || C <= 0.0f )
+            continue;
+
+        FLOAT t;
+        if( SmallestRootInRange( A, B, C, Time, &t ) )
+        {
+            FLOAT f = ( EdgeDotW + t * EdgeDotMove ) / EdgeSq;
+            if( f >= 0.0f && f <= 1.0f )
+            {
+                Time = t;
+                Contact = Start + Edge * f;
+                Hit = TRUE;
+            }
+        }
+    }
+
+    if( !Hit )
+        return FALSE;
+
+    *pTime = Time;
+    *pNormal = XMVector3Normalize( Center + Displacement * Time - Contact );
+    return TRUE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL IntersectTriangleAxisAlignedBox( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const AxisAlignedBox* pVolume )
+{
+    XMASSERT( pVolume );
+
+    XMVECTOR Zero = XMVectorZero();
+
+    // Load the box.
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
+
+    XMVECTOR BoxMin = Center - Extents;
+    XMVECTOR BoxMax = Center + Extents;
+
+    // Test the axes of the box (in effect test the AAB against the minimal AAB 
+    // around the triangle).
+    XMVECTOR TriMin = XMVectorMin( XMVectorMin( V0, V1 ), V2 );
+    XMVECTOR TriMax = XMVectorMax( XMVectorMax( V0, V1 ), V2 );
+
+    // for each i in (x, y, z) if a_min(i) > b_max(i) or b_min(i) > a_max(i) then disjoint
+    XMVECTOR Disjoint = XMVectorOrInt( XMVectorGreater( TriMin, BoxMax ), XMVectorGreater( BoxMin, TriMax ) );
+    if( XMVector3AnyTrue( Disjoint ) )
+        return FALSE;
+
+    // Test the plane of the triangle.
+    XMVECTOR Normal = XMVector3Cross( V1 - V0, V2 - V0 );
+    XMVECTOR Dist = XMVector3Dot( Normal, V0 );
+
+    // Assert that the triangle is not degenerate.
+    XMASSERT( !XMVector3Equal( Normal, Zero ) );
+
+    // for each i in (x, y, z) if n(i) >= 0 then v_min(i)=b_min(i), v_max(i)=b_max(i)
+    // else v_min(i)=b_max(i), v_max(i)=b_min(i)
+    XMVECTOR NormalSelect = XMVectorGreater( Normal, Zero );
+    XMVECTOR V_Min = XMVectorSelect( BoxMax, BoxMin, NormalSelect );
+    XMVECTOR V_Max = XMVectorSelect( BoxMin, BoxMax, NormalSelect );
+
+    // if n dot v_min + d > 0 || n dot v_max + d < 0 then disjoint
+    XMVECTOR MinDist = XMVector3Dot( V_Min, Normal );
+    XMVECTOR MaxDist = XMVector3Dot( V_Max, Normal );
+
+    XMVECTOR NoIntersection = XMVectorGreater( MinDist, Dist );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( MaxDist, Dist ) );
+
+    // Move the box center to zero to simplify the following tests.
+    XMVECTOR TV0 = V0 - Center;
+    XMVECTOR TV1 = V1 - Center;
+    XMVECTOR TV2 = V2 - Center;
+
+    // Test the edge/edge axes (3*3).
+    XMVECTOR e0 = TV1 - TV0;
+    XMVECTOR e1 = TV2 - TV1;
+    XMVECTOR e2 = TV0 - TV2;
+
+    // Make w zero.
+    e0 = XMVectorInsert<0, 0, 0, 0, 1>( e0, Zero );
+    e1 = XMVectorInsert<0, 0, 0, 0, 1>( e1, Zero );
+    e2 = XMVectorInsert<0, 0, 0, 0, 1>( e2, Zero );
+
+    XMVECTOR Axis;
+    XMVECTOR p0, p1, p2;
+    XMVECTOR Min, Max;
+    XMVECTOR Radius;
+
+    // Axis == (1,0,0) x e0 = (0, -e0.z, e0.y)
+    Axis = XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( e0, -e0 );
+    p0 = XMVector3Dot( TV0, Axis );
+    // p1 = XMVector3Dot( V1, Axis ); // p1 = p0;
+    p2 = XMVector3Dot( TV2, Axis );
+    Min = XMVectorMin( p0, p2 );
+    Max = XMVectorMax( p0, p2 );
+    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+
+    // Axis == (1,0,0) x e1 = (0, -e1.z, e1.y)
+    Axis = XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( e1, -e1 );
+    p0 = XMVector3Dot( TV0, Axis );
+    p1 = XMVector3Dot( TV1, Axis );
+    // p2 = XMVector3Dot( V2, Axis ); // p2 = p1;
+    Min = XMVectorMin( p0, p1 );
+    Max = XMVectorMax( p0, p1 );
+    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+
+    // Axis == (1,0,0) x e2 = (0, -e2.z, e2.y)
+    Axis = XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( e2, -e2 );
+    p0 = XMVector3Dot( TV0, Axis );
+    p1 = XMVector3Dot( TV1, Axis );
+    // p2 = XMVector3Dot( V2, Axis ); // p2 = p0;
+    Min = XMVectorMin( p0, p1 );
+    Max = XMVectorMax( p0, p1 );
+    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+
+    // Axis == (0,1,0) x e0 = (e0.z, 0, -e0.x)
+    Axis = XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y>( e0, -e0 );
+    p0 = XMVector3Dot( TV0, Axis );
+    // p1 = XMVector3Dot( V1, Axis ); // p1 = p0;
+    p2 = XMVector3Dot( TV2, Axis );
+    Min = XMVectorMin( p0, p2 );
+    Max = XMVectorMax( p0, p2 );
+    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+
+    // Axis == (0,1,0) x e1 = (e1.z, 0, -e1.x)
+    Axis = XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y>( e1, -e1 );
+    p0 = XMVector3Dot( TV0, Axis );
+    p1 = XMVector3Dot( TV1, Axis );
+    // p2 = XMVector3Dot( V2, Axis ); // p2 = p1;
+    Min = XMVectorMin( p0, p1 );
+    Max = XMVectorMax( p0, p1 );
+    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+
+    // Axis == (0,0,1) x e2 = (e2.z, 0, -e2.x)
+    Axis = XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y>( e2, -e2 );
+    p0 = XMVector3Dot( TV0, Axis );
+    p1 = XMVector3Dot( TV1, Axis );
+    // p2 = XMVector3Dot( V2, Axis ); // p2 = p0;
+    Min = XMVectorMin( p0, p1 );
+    Max = XMVectorMax( p0, p1 );
+    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+
+    // Axis == (0,0,1) x e0 = (-e0.y, e0.x, 0)
+    Axis = XMVectorPermute<XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( e0, -e0 );
+    p0 = XMVector3Dot( TV0, Axis );
+    // p1 = XMVector3Dot( V1, Axis ); // p1 = p0;
+    p2 = XMVector3Dot( TV2, Axis );
+    Min = XMVectorMin( p0, p2 );
+    Max = XMVectorMax( p0, p2 );
+    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+
+    // Axis == (0,0,1) x e1 = (-e1.y, e1.x, 0)
+    Axis = XMVectorPermute<XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( e1, -e1 );
+    p0 = XMVector3Dot( TV0, Axis );
+    p1 = XMVector3Dot( TV1, Axis );
+    // p2 = XMVector3Dot( V2, Axis ); // p2 = p1;
+    Min = XMVectorMin( p0, p1 );
+    Max = XMVectorMax( p0, p1 );
+    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+
+    // Axis == (0,0,1) x e2 = (-e2.y, e2.x, 0)
+    Axis = XMVectorPermute<XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( e2, -e2 );
+    p0 = XMVector3Dot( TV0, Axis );
+    p1 = XMVector3Dot( TV1, Axis );
+    // p2 = XMVector3Dot( V2, Axis ); // p2 = p0;
+    Min = XMVectorMin( p0, p1 );
+    Max = XMVectorMax( p0, p1 );
+    Radius = XMVector3Dot( Extents, XMVectorAbs( Axis ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( Min, Radius ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( Max, -Radius ) );
+
+    return XMVector4NotEqualInt( NoIntersection, XMVectorTrueInt() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL IntersectTriangleOrientedBox( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const OrientedBox* pVolume )
+{
+    XMASSERT( pVolume );
+
+    // Load the box center & orientation.
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+
+    // Transform the triangle vertices into the space of the box.
+    XMVECTOR TV0 = XMVector3InverseRotate( V0 - Center, Orientation );
+    XMVECTOR TV1 = XMVector3InverseRotate( V1 - Center, Orientation );
+    XMVECTOR TV2 = XMVector3InverseRotate( V2 - Center, Orientation );
+
+    AxisAlignedBox Box;
+    Box.Center = XMFLOAT3( 0.0f, 0.0f, 0.0f );
+    Box.Extents = pVolume->Extents;
+
+    // Use the triangle vs axis aligned box intersection routine.
+    return IntersectTriangleAxisAlignedBox( TV0, TV1, TV2, &Box );
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL IntersectSphereSphere( const Sphere* pVolumeA, const Sphere* pVolumeB )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+
+    // Load A.
+    XMVECTOR CenterA = XMLoadFloat3( &pVolumeA->Center );
+    XMVECTOR RadiusA = XMVectorReplicatePtr( &pVolumeA->Radius );
+
+    // Load B.
+    XMVECTOR CenterB = XMLoadFloat3( &pVolumeB->Center );
+    XMVECTOR RadiusB = XMVectorReplicatePtr( &pVolumeB->Radius );
+
+    // Distance squared between centers.    
+    XMVECTOR Delta = CenterB - CenterA;
+    XMVECTOR DistanceSquared = XMVector3LengthSq( Delta );
+
+    // Sum of the radii sqaured.
+    XMVECTOR RadiusSquared = RadiusA + RadiusB;
+    RadiusSquared = RadiusSquared * RadiusSquared;
+
+    return XMVector4LessOrEqual( DistanceSquared, RadiusSquared );
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL IntersectSphereAxisAlignedBox( const Sphere* pVolumeA, const AxisAlignedBox* pVolumeB )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+
+    XMVECTOR SphereCenter = XMLoadFloat3( &pVolumeA->Center );
+    XMVECTOR SphereRadius = XMVectorReplicatePtr( &pVolumeA->Radius );
+
+    XMVECTOR BoxCenter = XMLoadFloat3( &pVolumeB->Center );
+    XMVECTOR BoxExtents = XMLoadFloat3( &pVolumeB->Extents );
+
+    XMVECTOR BoxMin = BoxCenter - BoxExtents;
+    XMVECTOR BoxMax = BoxCenter + BoxExtents;
+
+    // Find the distance to the nearest point on the box.
+    // for each i in (x, y, z)
+    // if (SphereCenter(i) < BoxMin(i)) d2 += (SphereCenter(i) - BoxMin(i)) ^ 2
+    // else if (SphereCenter(i) > BoxMax(i)) d2 += (SphereCenter(i) - BoxMax(i)) ^ 2
+
+    XMVECTOR d = XMVectorZero();
+
+    // Compute d for each dimension.
+    XMVECTOR LessThanMin = XMVectorLess( SphereCenter, BoxMin );
+    XMVECTOR GreaterThanMax = XMVectorGreater( SphereCenter, BoxMax );
+
+    XMVECTOR MinDelta = SphereCenter - BoxMin;
+    XMVECTOR MaxDelta = SphereCenter - BoxMax;
+
+    // Choose value for each dimension based on the comparison.
+    d = XMVectorSelect( d, MinDelta, LessThanMin );
+    d = XMVectorSelect( d, MaxDelta, GreaterThanMax );
+
+    // Use a dot-product to square them and sum them together.
+    XMVECTOR d2 = XMVector3Dot( d, d );
+
+    return XMVector4LessOrEqual( d2, XMVectorMultiply( SphereRadius, SphereRadius ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL IntersectSphereOrientedBox( const Sphere* pVolumeA, const OrientedBox* pVolumeB )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+
+    XMVECTOR SphereCenter = XMLoadFloat3( &pVolumeA->Center );
+    XMVECTOR SphereRadius = XMVectorReplicatePtr( &pVolumeA->Radius );
+
+    XMVECTOR BoxCenter = XMLoadFloat3( &pVolumeB->Center );
+    XMVECTOR BoxExtents = XMLoadFloat3( &pVolumeB->Extents );
+    XMVECTOR BoxOrientation = XMLoadFloat4( &pVolumeB->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( BoxOrientation ) );
+
+    // Transform the center of the sphere to be local to the box.
+    // BoxMin = -BoxExtents
+    // BoxMax = +BoxExtents
+    SphereCenter = XMVector3InverseRotate( SphereCenter - BoxCenter, BoxOrientation );
+
+    // Find the distance to the nearest point on the box.
+    // for each i in (x, y, z)
+    // if (SphereCenter(i) < BoxMin(i)) d2 += (SphereCenter(i) - BoxMin(i)) ^ 2
+    // else if (SphereCenter(i) > BoxMax(i)) d2 += (SphereCenter(i) - BoxMax(i)) ^ 2
+
+    XMVECTOR d = XMVectorZero();
+
+    // Compute d for each dimension.
+    XMVECTOR LessThanMin = XMVectorLess( SphereCenter, -BoxExtents );
+    XMVECTOR GreaterThanMax = XMVectorGreater( SphereCenter, BoxExtents );
+
+    XMVECTOR MinDelta = SphereCenter + BoxExtents;
+    XMVECTOR MaxDelta = SphereCenter - BoxExtents;
+
+    // Choose value for each dimension based on the comparison.
+    d = XMVectorSelect( d, MinDelta, LessThanMin );
+    d = XMVectorSelect( d, MaxDelta, GreaterThanMax );
+
+    // Use a dot-product to square them and sum them together.
+    XMVECTOR d2 = XMVector3Dot( d, d );
+
+    return XMVector4LessOrEqual( d2, XMVectorMultiply( SphereRadius, SphereRadius ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL IntersectAxisAlignedBoxAxisAlignedBox( const AxisAlignedBox* pVolumeA, const AxisAlignedBox* pVolumeB )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+
+    XMVECTOR CenterA = XMLoadFloat3( &pVolumeA->Center );
+    XMVECTOR ExtentsA = XMLoadFloat3( &pVolumeA->Extents );
+
+    XMVECTOR CenterB = XMLoadFloat3( &pVolumeB->Center );
+    XMVECTOR ExtentsB = XMLoadFloat3( &pVolumeB->Extents );
+
+    XMVECTOR MinA = CenterA - ExtentsA;
+    XMVECTOR MaxA = CenterA + ExtentsA;
+
+    XMVECTOR MinB = CenterB - ExtentsB;
+    XMVECTOR MaxB = CenterB + ExtentsB;
+
+    // for each i in (x, y, z) if a_min(i) > b_max(i) or b_min(i) > a_max(i) then return FALSE
+    XMVECTOR Disjoint = XMVectorOrInt( XMVectorGreater( MinA, MaxB ), XMVectorGreater( MinB, MaxA ) );
+
+    return !XMVector3AnyTrue( Disjoint );
+}
+
+
+
+//-----------------------------------------------------------------------------
+BOOL IntersectAxisAlignedBoxOrientedBox( const AxisAlignedBox* pVolumeA, const OrientedBox* pVolumeB )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+
+    // Make the axis aligned box oriented and do an OBB vs OBB test.
+    OrientedBox BoxA;
+
+    BoxA.Center = pVolumeA->Center;
+    BoxA.Extents = pVolumeA->Extents;
+    BoxA.Orientation.x = 0.0f;
+    BoxA.Orientation.y = 0.0f;
+    BoxA.Orientation.z = 0.0f;
+    BoxA.Orientation.w = 1.0f;
+
+    return IntersectOrientedBoxOrientedBox( &BoxA, pVolumeB );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Fast oriented box / oriented box intersection test using the separating axis 
+// theorem.
+//-----------------------------------------------------------------------------
+BOOL IntersectOrientedBoxOrientedBox( const OrientedBox* pVolumeA, const OrientedBox* pVolumeB )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+
+    // Build the 3x3 rotation matrix that defines the orientation of B relative to A.
+    XMVECTOR A_quat = XMLoadFloat4( &pVolumeA->Orientation );
+    XMVECTOR B_quat = XMLoadFloat4( &pVolumeB->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( A_quat ) );
+    XMASSERT( XMQuaternionIsUnit( B_quat ) );
+
+    XMVECTOR Q = XMQuaternionMultiply( A_quat, XMQuaternionConjugate( B_quat ) );
+    XMMATRIX R = XMMatrixRotationQuaternion( Q );
+
+    // Compute the translation of B relative to A.
+    XMVECTOR A_cent = XMLoadFloat3( &pVolumeA->Center );
+    XMVECTOR B_cent = XMLoadFloat3( &pVolumeB->Center );
+    XMVECTOR t = XMVector3InverseRotate( B_cent - A_cent, A_quat );
+
+    //
+    // h(A) = extents of A.
+    // h(B) = extents of B.
+    //
+    // a(u) = axes of A = (1,0,0), (0,1,0), (0,0,1)
+    // b(u) = axes of B relative to A = (r00,r10,r20), (r01,r11,r21), (r02,r12,r22)
+    //  
+    // For each possible separating axis l:
+    //   d(A) = sum (for i = u,v,w) h(A)(i) * abs( a(i) dot l )
+    //   d(B) = sum (for i = u,v,w) h(B)(i) * abs( b(i) dot l )
+    //   if abs( t dot l ) > d(A) + d(B) then disjoint
+    //
 
     // Load extents of A and B.
     XMVECTOR h_A = XMLoadFloat3( &pVolumeA->Extents );
     XMVECTOR h_B = XMLoadFloat3( &pVolumeB->Extents );
 
-    // Rows. Note R[0,1,2]X.w = 0.
-    XMVECTOR R0X = R.r[0];
-    XMVECTOR R1X = R.r[1];
-    XMVECTOR R2X = R.r[2];
+    // Rows. Note R[0,1,2]X.w = 0.
+    XMVECTOR R0X = R.r[0];
+    XMVECTOR R1X = R.r[1];
+    XMVECTOR R2X = R.r[2];
+
+    R = XMMatrixTranspose( R );
+
+    // Columns. Note RX[0,1,2].w = 0.
+    XMVECTOR RX0 = R.r[0];
+    XMVECTOR RX1 = R.r[1];
+    XMVECTOR RX2 = R.r[2];
+
+    // Absolute value of rows.
+    XMVECTOR AR0X = XMVectorAbs( R0X );
+    XMVECTOR AR1X = XMVectorAbs( R1X );
+    XMVECTOR AR2X = XMVectorAbs( R2X );
+
+    // Absolute value of columns.
+    XMVECTOR ARX0 = XMVectorAbs( RX0 );
+    XMVECTOR ARX1 = XMVectorAbs( RX1 );
+    XMVECTOR ARX2 = XMVectorAbs( RX2 );
+
+    // Test each of the 15 possible seperating axii.
+    XMVECTOR d, d_A, d_B;
+
+    // l = a(u) = (1, 0, 0)
+    // t dot l = t.x
+    // d(A) = h(A).x
+    // d(B) = h(B) dot abs(r00, r01, r02)
+    d = XMVectorSplatX( t );
+    d_A = XMVectorSplatX( h_A );
+    d_B = XMVector3Dot( h_B, AR0X );
+    XMVECTOR NoIntersection = XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) );
+
+    // l = a(v) = (0, 1, 0)
+    // t dot l = t.y
+    // d(A) = h(A).y
+    // d(B) = h(B) dot abs(r10, r11, r12)
+    d = XMVectorSplatY( t );
+    d_A = XMVectorSplatY( h_A );
+    d_B = XMVector3Dot( h_B, AR1X );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = a(w) = (0, 0, 1)
+    // t dot l = t.z
+    // d(A) = h(A).z
+    // d(B) = h(B) dot abs(r20, r21, r22)
+    d = XMVectorSplatZ( t );
+    d_A = XMVectorSplatZ( h_A );
+    d_B = XMVector3Dot( h_B, AR2X );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = b(u) = (r00, r10, r20)
+    // d(A) = h(A) dot abs(r00, r10, r20)
+    // d(B) = h(B).x
+    d = XMVector3Dot( t, RX0 );
+    d_A = XMVector3Dot( h_A, ARX0 );
+    d_B = XMVectorSplatX( h_B );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = b(v) = (r01, r11, r21)
+    // d(A) = h(A) dot abs(r01, r11, r21)
+    // d(B) = h(B).y
+    d = XMVector3Dot( t, RX1 );
+    d_A = XMVector3Dot( h_A, ARX1 );
+    d_B = XMVectorSplatY( h_B );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = b(w) = (r02, r12, r22)
+    // d(A) = h(A) dot abs(r02, r12, r22)
+    // d(B) = h(B).z
+    d = XMVector3Dot( t, RX2 );
+    d_A = XMVector3Dot( h_A, ARX2 );
+    d_B = XMVectorSplatZ( h_B );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = a(u) x b(u) = (0, -r20, r10)
+    // d(A) = h(A) dot abs(0, r20, r10)
+    // d(B) = h(B) dot abs(0, r02, r01)
+    d = XMVector3Dot( t, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( RX0, -RX0 ) );
+    d_A = XMVector3Dot( h_A, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( ARX0, ARX0 ) );
+    d_B = XMVector3Dot( h_B, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( AR0X, AR0X ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = a(u) x b(v) = (0, -r21, r11)
+    // d(A) = h(A) dot abs(0, r21, r11)
+    // d(B) = h(B) dot abs(r02, 0, r00)
+    d = XMVector3Dot( t, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( RX1, -RX1 ) );
+    d_A = XMVector3Dot( h_A, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( ARX1, ARX1 ) );
+    d_B = XMVector3Dot( h_B, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( AR0X, AR0X ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = a(u) x b(w) = (0, -r22, r12)
+    // d(A) = h(A) dot abs(0, r22, r12)
+    // d(B) = h(B) dot abs(r01, r00, 0)
+    d = XMVector3Dot( t, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( RX2, -RX2 ) );
+    d_A = XMVector3Dot( h_A, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( ARX2, ARX2 ) );
+    d_B = XMVector3Dot( h_B, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( AR0X, AR0X ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = a(v) x b(u) = (r20, 0, -r00)
+    // d(A) = h(A) dot abs(r20, 0, r00)
+    // d(B) = h(B) dot abs(0, r12, r11)
+    d = XMVector3Dot( t, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y>( RX0, -RX0 ) );
+    d_A = XMVector3Dot( h_A, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( ARX0, ARX0 ) );
+    d_B = XMVector3Dot( h_B, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( AR1X, AR1X ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = a(v) x b(v) = (r21, 0, -r01)
+    // d(A) = h(A) dot abs(r21, 0, r01)
+    // d(B) = h(B) dot abs(r12, 0, r10)
+    d = XMVector3Dot( t, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y>( RX1, -RX1 ) );
+    d_A = XMVector3Dot( h_A, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( ARX1, ARX1 ) );
+    d_B = XMVector3Dot( h_B, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( AR1X, AR1X ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = a(v) x b(w) = (r22, 0, -r02)
+    // d(A) = h(A) dot abs(r22, 0, r02)
+    // d(B) = h(B) dot abs(r11, r10, 0)
+    d = XMVector3Dot( t, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y>( RX2, -RX2 ) );
+    d_A = XMVector3Dot( h_A, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( ARX2, ARX2 ) );
+    d_B = XMVector3Dot( h_B, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( AR1X, AR1X ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = a(w) x b(u) = (-r10, r00, 0)
+    // d(A) = h(A) dot abs(r10, r00, 0)
+    // d(B) = h(B) dot abs(0, r22, r21)
+    d = XMVector3Dot( t, XMVectorPermute<XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( RX0, -RX0 ) );
+    d_A = XMVector3Dot( h_A, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( ARX0, ARX0 ) );
+    d_B = XMVector3Dot( h_B, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( AR2X, AR2X ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = a(w) x b(v) = (-r11, r01, 0)
+    // d(A) = h(A) dot abs(r11, r01, 0)
+    // d(B) = h(B) dot abs(r22, 0, r20)
+    d = XMVector3Dot( t, XMVectorPermute<XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( RX1, -RX1 ) );
+    d_A = XMVector3Dot( h_A, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( ARX1, ARX1 ) );
+    d_B = XMVector3Dot( h_B, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( AR2X, AR2X ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // l = a(w) x b(w) = (-r12, r02, 0)
+    // d(A) = h(A) dot abs(r12, r02, 0)
+    // d(B) = h(B) dot abs(r21, r20, 0)
+    d = XMVector3Dot( t, XMVectorPermute<XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( RX2, -RX2 ) );
+    d_A = XMVector3Dot( h_A, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( ARX2, ARX2 ) );
+    d_B = XMVector3Dot( h_B, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( AR2X, AR2X ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, 
+                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+
+    // No seperating axis found, boxes must intersect.
+    return XMVector4NotEqualInt( NoIntersection, XMVectorTrueInt() );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// What the oriented box / oriented box separating axis test needs: the
+// translation t of B relative to A, the extents, the columns RX of the rotation
+// of B relative to A, their absolute values ARX and the absolute values AR of
+// its rows.
+//-----------------------------------------------------------------------------
+struct OrientedBoxPairFrame
+{
+    XMVECTOR t;
+    XMVECTOR h_A;
+    XMVECTOR h_B;
+    XMVECTOR RX[3];
+    XMVECTOR ARX[3];
+    XMVECTOR AR[3];
+};
+
+
+
+static inline VOID ComputeOrientedBoxPairFrame( OrientedBoxPairFrame* pFrame, const OrientedBox* pVolumeA,
+                                                const OrientedBox* pVolumeB )
+{
+    // Same setup as IntersectOrientedBoxOrientedBox.
+    XMVECTOR A_quat = XMLoadFloat4( &pVolumeA->Orientation );
+    XMVECTOR B_quat = XMLoadFloat4( &pVolumeB->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( A_quat ) );
+    XMASSERT( XMQuaternionIsUnit( B_quat ) );
+
+    XMVECTOR Q = XMQuaternionMultiply( A_quat, XMQuaternionConjugate( B_quat ) );
+    XMMATRIX R = XMMatrixRotationQuaternion( Q );
+
+    XMVECTOR A_cent = XMLoadFloat3( &pVolumeA->Center );
+    XMVECTOR B_cent = XMLoadFloat3( &pVolumeB->Center );
+    pFrame->t = XMVector3InverseRotate( B_cent - A_cent, A_quat );
+
+    pFrame->h_A = XMLoadFloat3( &pVolumeA->Extents );
+    pFrame->h_B = XMLoadFloat3( &pVolumeB->Extents );
+
+    pFrame->AR[0] = XMVectorAbs( R.r[0] );
+    pFrame->AR[1] = XMVectorAbs( R.r[1] );
+    pFrame->AR[2] = XMVectorAbs( R.r[2] );
+
+    R = XMMatrixTranspose( R );
+
+    pFrame->RX[0] = R.r[0];
+    pFrame->RX[1] = R.r[1];
+    pFrame->RX[2] = R.r[2];
+    pFrame->ARX[0] = XMVectorAbs( R.r[0] );
+    pFrame->ARX[1] = XMVectorAbs( R.r[1] );
+    pFrame->ARX[2] = XMVectorAbs( R.r[2] );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// One axis of the oriented box / oriented box separating axis test, with the
+// same arithmetic as IntersectOrientedBoxOrientedBox.
+//-----------------------------------------------------------------------------
+static BOOL OrientedBoxAxisSeparates( UINT Axis, const OrientedBoxPairFrame& F )
+{
+    XMVECTOR d, d_A, d_B;
+
+    switch( Axis )
+    {
+    // l = a(u), a(v), a(w)
+    case 0:
+        d = XMVectorSplatX( F.t );
+        d_A = XMVectorSplatX( F.h_A );
+        d_B = XMVector3Dot( F.h_B, F.AR[0] );
+        break;
+    case 1:
+        d = XMVectorSplatY( F.t );
+        d_A = XMVectorSplatY( F.h_A );
+        d_B = XMVector3Dot( F.h_B, F.AR[1] );
+        break;
+    case 2:
+        d = XMVectorSplatZ( F.t );
+        d_A = XMVectorSplatZ( F.h_A );
+        d_B = XMVector3Dot( F.h_B, F.AR[2] );
+        break;
+
+    // l = b(u), b(v), b(w)
+    case 3:
+        d = XMVector3Dot( F.t, F.RX[0] );
+        d_A = XMVector3Dot( F.h_A, F.ARX[0] );
+        d_B = XMVectorSplatX( F.h_B );
+        break;
+    case 4:
+        d = XMVector3Dot( F.t, F.RX[1] );
+        d_A = XMVector3Dot( F.h_A, F.ARX[1] );
+        d_B = XMVectorSplatY( F.h_B );
+        break;
+    case 5:
+        d = XMVector3Dot( F.t, F.RX[2] );
+        d_A = XMVector3Dot( F.h_A, F.ARX[2] );
+        d_B = XMVectorSplatZ( F.h_B );
+        break;
+
+    // l = a(u) x b(u), a(u) x b(v), a(u) x b(w)
+    case 6:
+        d = XMVector3Dot( F.t, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( F.RX[0], -F.RX[0] ) );
+        d_A = XMVector3Dot( F.h_A, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( F.ARX[0], F.ARX[0] ) );
+        d_B = XMVector3Dot( F.h_B, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( F.AR[0], F.AR[0] ) );
+        break;
+    case 7:
+        d = XMVector3Dot( F.t, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( F.RX[1], -F.RX[1] ) );
+        d_A = XMVector3Dot( F.h_A, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( F.ARX[1], F.ARX[1] ) );
+        d_B = XMVector3Dot( F.h_B, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( F.AR[0], F.AR[0] ) );
+        break;
+    case 8:
+        d = XMVector3Dot( F.t, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_1Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( F.RX[2], -F.RX[2] ) );
+        d_A = XMVector3Dot( F.h_A, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( F.ARX[2], F.ARX[2] ) );
+        d_B = XMVector3Dot( F.h_B, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( F.AR[0], F.AR[0] ) );
+        break;
+
+    // l = a(v) x b(u), a(v) x b(v), a(v) x b(w)
+    case 9:
+        d = XMVector3Dot( F.t, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y>( F.RX[0], -F.RX[0] ) );
+        d_A = XMVector3Dot( F.h_A, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( F.ARX[0], F.ARX[0] ) );
+        d_B = XMVector3Dot( F.h_B, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( F.AR[1], F.AR[1] ) );
+        break;
+    case 10:
+        d = XMVector3Dot( F.t, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y>( F.RX[1], -F.RX[1] ) );
+        d_A = XMVector3Dot( F.h_A, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( F.ARX[1], F.ARX[1] ) );
+        d_B = XMVector3Dot( F.h_B, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( F.AR[1], F.AR[1] ) );
+        break;
+    case 11:
+        d = XMVector3Dot( F.t, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_1X, XM_PERMUTE_0Y>( F.RX[2], -F.RX[2] ) );
+        d_A = XMVector3Dot( F.h_A, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( F.ARX[2], F.ARX[2] ) );
+        d_B = XMVector3Dot( F.h_B, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( F.AR[1], F.AR[1] ) );
+        break;
+
+    // l = a(w) x b(u), a(w) x b(v), a(w) x b(w)
+    case 12:
+        d = XMVector3Dot( F.t, XMVectorPermute<XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( F.RX[0], -F.RX[0] ) );
+        d_A = XMVector3Dot( F.h_A, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( F.ARX[0], F.ARX[0] ) );
+        d_B = XMVector3Dot( F.h_B, XMVectorPermute<XM_PERMUTE_0W, XM_PERMUTE_0Z, XM_PERMUTE_0Y, XM_PERMUTE_0X>( F.AR[2], F.AR[2] ) );
+        break;
+    case 13:
+        d = XMVector3Dot( F.t, XMVectorPermute<XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( F.RX[1], -F.RX[1] ) );
+        d_A = XMVector3Dot( F.h_A, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( F.ARX[1], F.ARX[1] ) );
+        d_B = XMVector3Dot( F.h_B, XMVectorPermute<XM_PERMUTE_0Z, XM_PERMUTE_0W, XM_PERMUTE_0X, XM_PERMUTE_0Y>( F.AR[2], F.AR[2] ) );
+        break;
+    default:
+        d = XMVector3Dot( F.t, XMVectorPermute<XM_PERMUTE_1Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( F.RX[2], -F.RX[2] ) );
+        d_A = XMVector3Dot( F.h_A, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( F.ARX[2], F.ARX[2] ) );
+        d_B = XMVector3Dot( F.h_B, XMVectorPermute<XM_PERMUTE_0Y, XM_PERMUTE_0X, XM_PERMUTE_0W, XM_PERMUTE_0Z>( F.AR[2], F.AR[2] ) );
+        break;
+    }
+
+    return XMVector4Greater( XMVectorAbs( d ), XMVectorAdd( d_A, d_B ) );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Oriented box / oriented box test that starts with the axis that separated
+// the boxes last time. Boxes that stay apart from one frame to the next are
+// usually separated by the same axis again, which then costs one axis test
+// instead of fifteen. Otherwise the full test decides, and the separating
+// axis is only searched for when it finds the boxes disjoint.
+//-----------------------------------------------------------------------------
+BOOL IntersectOrientedBoxOrientedBox( const OrientedBox* pVolumeA, const OrientedBox* pVolumeB,
+                                      BYTE* pSeparatingAxis )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+    XMASSERT( pSeparatingAxis );
+
+    UINT First = *pSeparatingAxis;
+    OrientedBoxPairFrame Frame;
+
+    if( First < OrientedBoxAxisCount )
+    {
+        ComputeOrientedBoxPairFrame( &Frame, pVolumeA, pVolumeB );
+
+        if( OrientedBoxAxisSeparates( First, Frame ) )
+            return FALSE;
+    }
+
+    if( IntersectOrientedBoxOrientedBox( pVolumeA, pVolumeB ) )
+        return TRUE;
+
+    if( First >= OrientedBoxAxisCount )
+        ComputeOrientedBoxPairFrame( &Frame, pVolumeA, pVolumeB );
+
+    for( UINT Axis = 0; Axis < OrientedBoxAxisCount; Axis++ )
+    {
+        if( Axis != First && OrientedBoxAxisSeparates( Axis, Frame ) )
+        {
+            *pSeparatingAxis = BYTE( Axis );
+            break;
+        }
+    }
+
+    return FALSE;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Exact triangle vs frustum test.
+// Return values: 0 = no intersection, 
+//                1 = intersection, 
+//                2 = triangle is completely inside frustum
+//-----------------------------------------------------------------------------
+INT IntersectTriangleFrustum( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const Frustum* pVolume )
+{
+    XMASSERT( pVolume );
+
+    // Build the frustum planes (NOTE: D is negated from the usual).
+    XMVECTOR Planes[6];
+    Planes[0] = XMVectorSet( 0.0f, 0.0f, -1.0f, -pVolume->Near );
+    Planes[1] = XMVectorSet( 0.0f, 0.0f, 1.0f, pVolume->Far );
+    Planes[2] = XMVectorSet( 1.0f, 0.0f, -pVolume->RightSlope, 0.0f );
+    Planes[3] = XMVectorSet( -1.0f, 0.0f, pVolume->LeftSlope, 0.0f );
+    Planes[4] = XMVectorSet( 0.0f, 1.0f, -pVolume->TopSlope, 0.0f );
+    Planes[5] = XMVectorSet( 0.0f, -1.0f, pVolume->BottomSlope, 0.0f );
+
+    // Load origin and orientation of the frustum.
+    XMVECTOR Origin = XMLoadFloat3( &pVolume->Origin );
+    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+
+    // Transform triangle into the local space of frustum.
+    XMVECTOR TV0 = XMVector3InverseRotate( V0 - Origin, Orientation );
+    XMVECTOR TV1 = XMVector3InverseRotate( V1 - Origin, Orientation );
+    XMVECTOR TV2 = XMVector3InverseRotate( V2 - Origin, Orientation );
+
+    // Test each vertex of the triangle against the frustum planes.
+    XMVECTOR Outside = XMVectorFalseInt();
+    XMVECTOR InsideAll = XMVectorTrueInt();
+
+    for( INT i = 0; i < 6; i++ )
+    {
+        XMVECTOR Dist0 = XMVector3Dot( TV0, Planes[i] );
+        XMVECTOR Dist1 = XMVector3Dot( TV1, Planes[i] );
+        XMVECTOR Dist2 = XMVector3Dot( TV2, Planes[i] );
+
+        XMVECTOR MinDist = XMVectorMin( Dist0, Dist1 );
+        MinDist = XMVectorMin( MinDist, Dist2 );
+        XMVECTOR MaxDist = XMVectorMax( Dist0, Dist1 );
+        MaxDist = XMVectorMax( MaxDist, Dist2 );
+
+        XMVECTOR PlaneDist = XMVectorSplatW( Planes[i] );
+
+        // Outside the plane?
+        Outside = XMVectorOrInt( Outside, XMVectorGreater( MinDist, PlaneDist ) );
+
+        // Fully inside the plane?
+        InsideAll = XMVectorAndInt( InsideAll, XMVectorLessOrEqual( MaxDist, PlaneDist ) );
+    }
+
+    // If the triangle is outside any of the planes it is outside. 
+    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+        return 0;
+
+    // If the triangle is inside all planes it is fully inside.
+    if ( XMVector4EqualInt( InsideAll, XMVectorTrueInt() ) )
+        return 2;
+
+    // Build the corners of the frustum.
+    XMVECTOR RightTop = XMVectorSet( pVolume->RightSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    XMVECTOR RightBottom = XMVectorSet( pVolume->RightSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR LeftTop = XMVectorSet( pVolume->LeftSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    XMVECTOR LeftBottom = XMVectorSet( pVolume->LeftSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR Near = XMVectorReplicatePtr( &pVolume->Near );
+    XMVECTOR Far = XMVectorReplicatePtr( &pVolume->Far );
+
+    XMVECTOR Corners[8];
+    Corners[0] = RightTop * Near;
+    Corners[1] = RightBottom * Near;
+    Corners[2] = LeftTop * Near;
+    Corners[3] = LeftBottom * Near;
+    Corners[4] = RightTop * Far;
+    Corners[5] = RightBottom * Far;
+    Corners[6] = LeftTop * Far;
+    Corners[7] = LeftBottom * Far;
+
+    // Test the plane of the triangle.
+    XMVECTOR Normal = XMVector3Cross( V1 - V0, V2 - V0 );
+    XMVECTOR Dist = XMVector3Dot( Normal, V0 );
+
+    XMVECTOR MinDist, MaxDist;
+    MinDist = MaxDist = XMVector3Dot( Corners[0], Normal );
+    for( INT i = 1; i < 8; i++ )
+    {
+        XMVECTOR Temp = XMVector3Dot( Corners[i], Normal );
+        MinDist = XMVectorMin( MinDist, Temp );
+        MaxDist = XMVectorMax( MaxDist, Temp );
+    }
+
+    Outside = XMVectorOrInt( XMVectorGreater( MinDist, Dist ), XMVectorLess( MaxDist, Dist ) );   
+    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+        return 0;
+
+    // Check the edge/edge axes (3*6).
+    XMVECTOR TriangleEdgeAxis[3];
+    TriangleEdgeAxis[0] = V1 - V0;
+    TriangleEdgeAxis[1] = V2 - V1;
+    TriangleEdgeAxis[2] = V0 - V2;
+
+    XMVECTOR FrustumEdgeAxis[6];
+    FrustumEdgeAxis[0] = RightTop;
+    FrustumEdgeAxis[1] = RightBottom;
+    FrustumEdgeAxis[2] = LeftTop;
+    FrustumEdgeAxis[3] = LeftBottom;
+    FrustumEdgeAxis[4] = RightTop - LeftTop;
+    FrustumEdgeAxis[5] = LeftBottom - LeftTop;
+
+    for( INT i = 0; i < 3; i++ )
+    {
+        for( INT j = 0; j < 6; j++ )
+        {
+            // Compute the axis we are going to test.
+            XMVECTOR Axis = XMVector3Cross( TriangleEdgeAxis[i], FrustumEdgeAxis[j] );
+
+            // Find the min/max of the projection of the triangle onto the axis.
+            XMVECTOR MinA, MaxA;
+
+            XMVECTOR Dist0 = XMVector3Dot( V0, Axis );
+            XMVECTOR Dist1 = XMVector3Dot( V1, Axis );
+            XMVECTOR Dist2 = XMVector3Dot( V2, Axis );
+
+            MinA = XMVectorMin( Dist0, Dist1 );
+            MinA = XMVectorMin( MinA, Dist2 );
+            MaxA = XMVectorMax( Dist0, Dist1 );
+            MaxA = XMVectorMax( MaxA, Dist2 );
+
+            // Find the min/max of the projection of the frustum onto the axis.
+            XMVECTOR MinB, MaxB;
+
+            MinB = MaxB = XMVector3Dot( Axis, Corners[0] );
+
+            for( INT k = 1; k < 8; k++ )
+            {
+                XMVECTOR Temp = XMVector3Dot( Axis, Corners[k] );
+                MinB = XMVectorMin( MinB, Temp );
+                MaxB = XMVectorMax( MaxB, Temp );
+            }
+
+            // if (MinA > MaxB || MinB > MaxA) reject;
+            Outside = XMVectorOrInt( Outside, XMVectorGreater( MinA, MaxB ) );
+            Outside = XMVectorOrInt( Outside, XMVectorGreater( MinB, MaxA ) );
+        }
+    }
+
+    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+        return 0;
+
+    // If we did not find a separating plane then the triangle must intersect the frustum.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Exact sphere vs frustum test.  The algorithm first checks the sphere against
+// the planes of the frustum, then if the plane checks were indeterminate finds
+// the nearest feature (plane, line, point) on the frustum to the center of the
+// sphere and compares the distance to the nearest feature to the radius of the 
+// sphere (it is so cool that all the comment lines above are the same length).
+// Return values: 0 = no intersection, 
+//                1 = intersection, 
+//                2 = sphere is completely inside frustum
+//-----------------------------------------------------------------------------
+INT IntersectSphereFrustum( const Sphere* pVolumeA, const Frustum* pVolumeB )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+
+    XMVECTOR Zero = XMVectorZero();
+
+    // Build the frustum planes.
+    XMVECTOR Planes[6];
+    Planes[0] = XMVectorSet( 0.0f, 0.0f, -1.0f, pVolumeB->Near );
+    Planes[1] = XMVectorSet( 0.0f, 0.0f, 1.0f, -pVolumeB->Far );
+    Planes[2] = XMVectorSet( 1.0f, 0.0f, -pVolumeB->RightSlope, 0.0f );
+    Planes[3] = XMVectorSet( -1.0f, 0.0f, pVolumeB->LeftSlope, 0.0f );
+    Planes[4] = XMVectorSet( 0.0f, 1.0f, -pVolumeB->TopSlope, 0.0f );
+    Planes[5] = XMVectorSet( 0.0f, -1.0f, pVolumeB->BottomSlope, 0.0f );
+
+    // Normalize the planes so we can compare to the sphere radius.
+    Planes[2] = XMVector3Normalize( Planes[2] );
+    Planes[3] = XMVector3Normalize( Planes[3] );
+    Planes[4] = XMVector3Normalize( Planes[4] );
+    Planes[5] = XMVector3Normalize( Planes[5] );
+
+    // Load origin and orientation of the frustum.
+    XMVECTOR Origin = XMLoadFloat3( &pVolumeB->Origin );
+    XMVECTOR Orientation = XMLoadFloat4( &pVolumeB->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+
+    // Load the sphere.
+    XMVECTOR Center = XMLoadFloat3( &pVolumeA->Center );
+    XMVECTOR Radius = XMVectorReplicatePtr( &pVolumeA->Radius );
+
+    // Transform the center of the sphere into the local space of frustum.
+    Center = XMVector3InverseRotate( Center - Origin, Orientation );
+
+    // Set w of the center to one so we can dot4 with the plane.
+    Center = XMVectorInsert<0, 0, 0, 0, 1>( Center, XMVectorSplatOne() );
+
+    // Check against each plane of the frustum.
+    XMVECTOR Outside = XMVectorFalseInt();
+    XMVECTOR InsideAll = XMVectorTrueInt();
+    XMVECTOR CenterInsideAll = XMVectorTrueInt();
+
+    XMVECTOR Dist[6];
+
+    for( INT i = 0; i < 6; i++ )
+    {
+        Dist[i] = XMVector4Dot( Center, Planes[i] );
+
+        // Outside the plane?
+        Outside = XMVectorOrInt( Outside, XMVectorGreater( Dist[i], Radius ) );
+
+        // Fully inside the plane?
+        InsideAll = XMVectorAndInt( InsideAll, XMVectorLessOrEqual( Dist[i], -Radius ) );
+
+        // Check if the center is inside the plane.
+        CenterInsideAll = XMVectorAndInt( CenterInsideAll, XMVectorLessOrEqual( Dist[i], Zero ) );
+    }
+
+    // If the sphere is outside any of the planes it is outside. 
+    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+        return 0;
+
+    // If the sphere is inside all planes it is fully inside.
+    if ( XMVector4EqualInt( InsideAll, XMVectorTrueInt() ) )
+        return 2;
+
+    // If the center of the sphere is inside all planes and the sphere intersects 
+    // one or more planes then it must intersect.
+    if ( XMVector4EqualInt( CenterInsideAll, XMVectorTrueInt() ) )
+        return 1;
+
+    // The sphere may be outside the frustum or intersecting the frustum.
+    // Find the nearest feature (face, edge, or corner) on the frustum 
+    // to the sphere.
+
+    // The faces adjacent to each face are:
+    static const INT adjacent_faces[6][4] =
+    {
+        { 2, 3, 4, 5 },    // 0
+        { 2, 3, 4, 5 },    // 1
+        { 0, 1, 4, 5 },    // 2
+        { 0, 1, 4, 5 },    // 3
+        { 0, 1, 2, 3 },    // 4
+        { 0, 1, 2, 3 }
+    };  // 5
+
+    XMVECTOR Intersects = XMVectorFalseInt();
+
+    // Check to see if the nearest feature is one of the planes.
+    for( INT i = 0; i < 6; i++ )
+    {
+        // Find the nearest point on the plane to the center of the sphere.
+        XMVECTOR Point = Center - (Planes[i] * Dist[i]);
+
+        // Set w of the point to one.
+        Point = XMVectorInsert<0, 0, 0, 0, 1>( Point, XMVectorSplatOne() );
+        
+        // If the point is inside the face (inside the adjacent planes) then
+        // this plane is the nearest feature.
+        XMVECTOR InsideFace = XMVectorTrueInt();
+        
+        for ( INT j = 0; j < 4; j++ )
+        {
+            INT plane_index = adjacent_faces[i][j];
+
+            InsideFace = XMVectorAndInt( InsideFace,
+                           XMVectorLessOrEqual( XMVector4Dot( Point, Planes[plane_index] ), Zero ) );
+        }
+     
+        // Since we have already checked distance from the plane we know that the
+        // sphere must intersect if this plane is the nearest feature.
+        Intersects = XMVectorOrInt( Intersects, 
+                                    XMVectorAndInt( XMVectorGreater( Dist[i], Zero ), InsideFace ) );
+    }
+
+    if ( XMVector4EqualInt( Intersects, XMVectorTrueInt() ) )
+        return 1;
+
+    // Build the corners of the frustum.
+    XMVECTOR RightTop = XMVectorSet( pVolumeB->RightSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    XMVECTOR RightBottom = XMVectorSet( pVolumeB->RightSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR LeftTop = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    XMVECTOR LeftBottom = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR Near = XMVectorReplicatePtr( &pVolumeB->Near );
+    XMVECTOR Far = XMVectorReplicatePtr( &pVolumeB->Far );
+
+    XMVECTOR Corners[8];
+    Corners[0] = RightTop * Near;
+    Corners[1] = RightBottom * Near;
+    Corners[2] = LeftTop * Near;
+    Corners[3] = LeftBottom * Near;
+    Corners[4] = RightTop * Far;
+    Corners[5] = RightBottom * Far;
+    Corners[6] = LeftTop * Far;
+    Corners[7] = LeftBottom * Far;
+
+    // The Edges are:
+    static const INT edges[12][2] =
+    {
+        { 0, 1 }, { 2, 3 }, { 0, 2 }, { 1, 3 },    // Near plane
+        { 4, 5 }, { 6, 7 }, { 4, 6 }, { 5, 7 },    // Far plane
+        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+    }; // Near to far
+
+    XMVECTOR RadiusSq = Radius * Radius;
+
+    // Check to see if the nearest feature is one of the edges (or corners).
+    for( INT i = 0; i < 12; i++ )
+    {
+        INT ei0 = edges[i][0];
+        INT ei1 = edges[i][1];
+
+        // Find the nearest point on the edge to the center of the sphere.
+        // The corners of the frustum are included as the endpoints of the edges.
+        XMVECTOR Point = PointOnLineSegmentNearestPoint( Corners[ei0], Corners[ei1], Center );
+
+        XMVECTOR Delta = Center - Point;
+
+        XMVECTOR DistSq = XMVector3Dot( Delta, Delta );
+
+        // If the distance to the center of the sphere to the point is less than 
+        // the radius of the sphere then it must intersect.
+        Intersects = XMVectorOrInt( Intersects, XMVectorLessOrEqual( DistSq, RadiusSq ) );
+    }
+
+    if ( XMVector4EqualInt( Intersects, XMVectorTrueInt() ) )
+        return 1;
+
+    // The sphere must be outside the frustum.
+    return 0;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Exact axis alinged box vs frustum test.  Constructs an oriented box and uses
+// the oriented box vs frustum test.
+//
+// Return values: 0 = no intersection, 
+//                1 = intersection, 
+//                2 = box is completely inside frustum
+//-----------------------------------------------------------------------------
+INT IntersectAxisAlignedBoxFrustum( const AxisAlignedBox* pVolumeA, const Frustum* pVolumeB )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+
+    // Make the axis aligned box oriented and do an OBB vs frustum test.
+    OrientedBox BoxA;
+
+    BoxA.Center = pVolumeA->Center;
+    BoxA.Extents = pVolumeA->Extents;
+    BoxA.Orientation.x = 0.0f;
+    BoxA.Orientation.y = 0.0f;
+    BoxA.Orientation.z = 0.0f;
+    BoxA.Orientation.w = 1.0f;
+
+    return IntersectOrientedBoxFrustum( &BoxA, pVolumeB );
+}
+
+
+//-----------------------------------------------------------------------------
+// Exact oriented box vs frustum test.
+// Return values: 0 = no intersection, 
+//                1 = intersection, 
+//                2 = box is completely inside frustum
+//-----------------------------------------------------------------------------
+INT IntersectOrientedBoxFrustum( const OrientedBox* pVolumeA, const Frustum* pVolumeB )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+
+    static const XMVECTORU32 SelectY =
+    {
+        XM_SELECT_0, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0
+    };
+    static const XMVECTORU32 SelectZ =
+    {
+        XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0
+    };
+
+    XMVECTOR Zero = XMVectorZero();
+
+    // Build the frustum planes.
+    XMVECTOR Planes[6];
+    Planes[0] = XMVectorSet( 0.0f, 0.0f, -1.0f, pVolumeB->Near );
+    Planes[1] = XMVectorSet( 0.0f, 0.0f, 1.0f, -pVolumeB->Far );
+    Planes[2] = XMVectorSet( 1.0f, 0.0f, -pVolumeB->RightSlope, 0.0f );
+    Planes[3] = XMVectorSet( -1.0f, 0.0f, pVolumeB->LeftSlope, 0.0f );
+    Planes[4] = XMVectorSet( 0.0f, 1.0f, -pVolumeB->TopSlope, 0.0f );
+    Planes[5] = XMVectorSet( 0.0f, -1.0f, pVolumeB->BottomSlope, 0.0f );
+
+    // Load origin and orientation of the frustum.
+    XMVECTOR Origin = XMLoadFloat3( &pVolumeB->Origin );
+    XMVECTOR FrustumOrientation = XMLoadFloat4( &pVolumeB->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( FrustumOrientation ) );
+
+    // Load the box.
+    XMVECTOR Center = XMLoadFloat3( &pVolumeA->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pVolumeA->Extents );
+    XMVECTOR BoxOrientation = XMLoadFloat4( &pVolumeA->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( BoxOrientation ) );
+
+    // Transform the oriented box into the space of the frustum in order to 
+    // minimize the number of transforms we have to do.
+    Center = XMVector3InverseRotate( Center - Origin, FrustumOrientation );
+    BoxOrientation = XMQuaternionMultiply( BoxOrientation, XMQuaternionConjugate( FrustumOrientation ) );
+
+    // Set w of the center to one so we can dot4 with the plane.
+    Center = XMVectorInsert<0, 0, 0, 0, 1>( Center, XMVectorSplatOne() );
+
+    // Build the 3x3 rotation matrix that defines the box axes.
+    XMMATRIX R = XMMatrixRotationQuaternion( BoxOrientation );
+
+    // Check against each plane of the frustum.
+    XMVECTOR Outside = XMVectorFalseInt();
+    XMVECTOR InsideAll = XMVectorTrueInt();
+    XMVECTOR CenterInsideAll = XMVectorTrueInt();
+
+    for( INT i = 0; i < 6; i++ )
+    {
+        // Compute the distance to the center of the box.
+        XMVECTOR Dist = XMVector4Dot( Center, Planes[i] );
+
+        // Project the axes of the box onto the normal of the plane.  Half the
+        // length of the projection (sometime called the "radius") is equal to
+        // h(u) * abs(n dot b(u))) + h(v) * abs(n dot b(v)) + h(w) * abs(n dot b(w))
+        // where h(i) are extents of the box, n is the plane normal, and b(i) are the 
+        // axes of the box.
+        XMVECTOR Radius = XMVector3Dot( Planes[i], R.r[0] );
+        Radius = XMVectorSelect( Radius, XMVector3Dot( Planes[i], R.r[1] ), SelectY );
+        Radius = XMVectorSelect( Radius, XMVector3Dot( Planes[i], R.r[2] ), SelectZ );
+        Radius = XMVector3Dot( Extents, XMVectorAbs( Radius ) );
+
+        // Outside the plane?
+        Outside = XMVectorOrInt( Outside, XMVectorGreater( Dist, Radius ) );
+
+        // Fully inside the plane?
+        InsideAll = XMVectorAndInt( InsideAll, XMVectorLessOrEqual( Dist, -Radius ) );
+
+        // Check if the center is inside the plane.
+        CenterInsideAll = XMVectorAndInt( CenterInsideAll, XMVectorLessOrEqual( Dist, Zero ) );
+    }
+
+    // If the box is outside any of the planes it is outside. 
+    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+        return 0;
+
+    // If the box is inside all planes it is fully inside.
+    if ( XMVector4EqualInt( InsideAll, XMVectorTrueInt() ) )
+        return 2;
+
+    // If the center of the box is inside all planes and the box intersects 
+    // one or more planes then it must intersect.
+    if ( XMVector4EqualInt( CenterInsideAll, XMVectorTrueInt() ) )
+        return 1;
+
+    // Build the corners of the frustum.
+    XMVECTOR RightTop = XMVectorSet( pVolumeB->RightSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    XMVECTOR RightBottom = XMVectorSet( pVolumeB->RightSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR LeftTop = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    XMVECTOR LeftBottom = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR Near = XMVectorReplicatePtr( &pVolumeB->Near );
+    XMVECTOR Far = XMVectorReplicatePtr( &pVolumeB->Far );
 
-    R = XMMatrixTranspose( R );
+    XMVECTOR Corners[8];
+    Corners[0] = RightTop * Near;
+    Corners[1] = RightBottom * Near;
+    Corners[2] = LeftTop * Near;
+    Corners[3] = LeftBottom * Near;
+    Corners[4] = RightTop * Far;
+    Corners[5] = RightBottom * Far;
+    Corners[6] = LeftTop * Far;
+    Corners[7] = LeftBottom * Far;
 
-    // Columns. Note RX[0,1,2].w = 0.
-    XMVECTOR RX0 = R.r[0];
-    XMVECTOR RX1 = R.r[1];
-    XMVECTOR RX2 = R.r[2];
+    // Test against box axes (3)
+    {
+        // Find the min/max values of the projection of the frustum onto each axis.
+        XMVECTOR FrustumMin, FrustumMax;
 
-    // Absolute value of rows.
-    XMVECTOR AR0X = XMVectorAbs( R0X );
-    XMVECTOR AR1X = XMVectorAbs( R1X );
-    XMVECTOR AR2X = XMVectorAbs( R2X );
+        FrustumMin = XMVector3Dot( Corners[0], R.r[0] );
+        FrustumMin = XMVectorSelect( FrustumMin, XMVector3Dot( Corners[0], R.r[1] ), SelectY );
+        FrustumMin = XMVectorSelect( FrustumMin, XMVector3Dot( Corners[0], R.r[2] ), SelectZ );
+        FrustumMax = FrustumMin;
 
-    // Absolute value of columns.
-    XMVECTOR ARX0 = XMVectorAbs( RX0 );
-    XMVECTOR ARX1 = XMVectorAbs( RX1 );
-    XMVECTOR ARX2 = XMVectorAbs( RX2 );
+        for( INT i = 1; i < 8; i++ )
+        {
+            XMVECTOR Temp = XMVector3Dot( Corners[i], R.r[0] );
+            Temp = XMVectorSelect( Temp, XMVector3Dot( Corners[i], R.r[1] ), SelectY );
+            Temp = XMVectorSelect( Temp, XMVector3Dot( Corners[i], R.r[2] ), SelectZ );
 
-    // Test each of the 15 possible seperating axii.
-    XMVECTOR d, d_A, d_B;
+            FrustumMin = XMVectorMin( FrustumMin, Temp );
+            FrustumMax = XMVectorMax( FrustumMax, Temp );
+        }
 
-    // l = a(u) = (1, 0, 0)
-    // t dot l = t.x
-    // d(A) = h(A).x
-    // d(B) = h(B) dot abs(r00, r01, r02)
-    d = XMVectorSplatX( t );
-    d_A = XMVectorSplatX( h_A );
-    d_B = XMVector3Dot( h_B, AR0X );
-    XMVECTOR NoIntersection = XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) );
+        // Project the center of the box onto the axes.
+        XMVECTOR BoxDist = XMVector3Dot( Center, R.r[0] );
+        BoxDist = XMVectorSelect( BoxDist, XMVector3Dot( Center, R.r[1] ), SelectY );
+        BoxDist = XMVectorSelect( BoxDist, XMVector3Dot( Center, R.r[2] ), SelectZ );
 
-    // l = a(v) = (0, 1, 0)
-    // t dot l = t.y
-    // d(A) = h(A).y
-    // d(B) = h(B) dot abs(r10, r11, r12)
-    d = XMVectorSplatY( t );
-    d_A = XMVectorSplatY( h_A );
-    d_B = XMVector3Dot( h_B, AR1X );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+        // The projection of the box onto the axis is just its Center and Extents.
+        // if (min > box_max || max < box_min) reject;
+        XMVECTOR Result = XMVectorOrInt( XMVectorGreater( FrustumMin, BoxDist + Extents ),
+                                          XMVectorLess( FrustumMax, BoxDist - Extents ) );
 
-    // l = a(w) = (0, 0, 1)
-    // t dot l = t.z
-    // d(A) = h(A).z
-    // d(B) = h(B) dot abs(r20, r21, r22)
-    d = XMVectorSplatZ( t );
-    d_A = XMVectorSplatZ( h_A );
-    d_B = XMVector3Dot( h_B, AR2X );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+        if( XMVector3AnyTrue( Result ) )
+            return 0;
+    }
 
-    // l = b(u) = (r00, r10, r20)
-    // d(A) = h(A) dot abs(r00, r10, r20)
-    // d(B) = h(B).x
-    d = XMVector3Dot( t, RX0 );
-    d_A = XMVector3Dot( h_A, ARX0 );
-    d_B = XMVectorSplatX( h_B );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+    // Test against edge/edge axes (3*6).
+    XMVECTOR FrustumEdgeAxis[6];
 
-    // l = b(v) = (r01, r11, r21)
-    // d(A) = h(A) dot abs(r01, r11, r21)
-    // d(B) = h(B).y
-    d = XMVector3Dot( t, RX1 );
-    d_A = XMVector3Dot( h_A, ARX1 );
-    d_B = XMVectorSplatY( h_B );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+    FrustumEdgeAxis[0] = RightTop;
+    FrustumEdgeAxis[1] = RightBottom;
+    FrustumEdgeAxis[2] = LeftTop;
+    FrustumEdgeAxis[3] = LeftBottom;
+    FrustumEdgeAxis[4] = RightTop - LeftTop;
+    FrustumEdgeAxis[5] = LeftBottom - LeftTop;
 
-    // l = b(w) = (r02, r12, r22)
-    // d(A) = h(A) dot abs(r02, r12, r22)
-    // d(B) = h(B).z
-    d = XMVector3Dot( t, RX2 );
-    d_A = XMVector3Dot( h_A, ARX2 );
-    d_B = XMVectorSplatZ( h_B );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+    for( INT i = 0; i < 3; i++ )
+    {
+        for( INT j = 0; j < 6; j++ )
+        {
+            // Compute the axis we are going to test.
+            XMVECTOR Axis = XMVector3Cross( R.r[i], FrustumEdgeAxis[j] );
 
-    // l = a(u) x b(u) = (0, -r20, r10)
-    // d(A) = h(A) dot abs(0, r20, r10)
-    // d(B) = h(B) dot abs(0, r02, r01)
-    d = XMVector3Dot( t, XMVectorPermute( RX0, -RX0, Permute0W1Z0Y0X ) );
-    d_A = XMVector3Dot( h_A, XMVectorPermute( ARX0, ARX0, PermuteWZYX ) );
-    d_B = XMVector3Dot( h_B, XMVectorPermute( AR0X, AR0X, PermuteWZYX ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+            // Find the min/max values of the projection of the frustum onto the axis.
+            XMVECTOR FrustumMin, FrustumMax;
 
-    // l = a(u) x b(v) = (0, -r21, r11)
-    // d(A) = h(A) dot abs(0, r21, r11)
-    // d(B) = h(B) dot abs(r02, 0, r00)
-    d = XMVector3Dot( t, XMVectorPermute( RX1, -RX1, Permute0W1Z0Y0X ) );
-    d_A = XMVector3Dot( h_A, XMVectorPermute( ARX1, ARX1, PermuteWZYX ) );
-    d_B = XMVector3Dot( h_B, XMVectorPermute( AR0X, AR0X, PermuteZWXY ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+            FrustumMin = FrustumMax = XMVector3Dot( Axis, Corners[0] );
 
-    // l = a(u) x b(w) = (0, -r22, r12)
-    // d(A) = h(A) dot abs(0, r22, r12)
-    // d(B) = h(B) dot abs(r01, r00, 0)
-    d = XMVector3Dot( t, XMVectorPermute( RX2, -RX2, Permute0W1Z0Y0X ) );
-    d_A = XMVector3Dot( h_A, XMVectorPermute( ARX2, ARX2, PermuteWZYX ) );
-    d_B = XMVector3Dot( h_B, XMVectorPermute( AR0X, AR0X, PermuteYXWZ ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+            for( INT k = 1; k < 8; k++ )
+            {
+                XMVECTOR Temp = XMVector3Dot( Axis, Corners[k] );
+                FrustumMin = XMVectorMin( FrustumMin, Temp );
+                FrustumMax = XMVectorMax( FrustumMax, Temp );
+            }
 
-    // l = a(v) x b(u) = (r20, 0, -r00)
-    // d(A) = h(A) dot abs(r20, 0, r00)
-    // d(B) = h(B) dot abs(0, r12, r11)
-    d = XMVector3Dot( t, XMVectorPermute( RX0, -RX0, Permute0Z0W1X0Y ) );
-    d_A = XMVector3Dot( h_A, XMVectorPermute( ARX0, ARX0, PermuteZWXY ) );
-    d_B = XMVector3Dot( h_B, XMVectorPermute( AR1X, AR1X, PermuteWZYX ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+            // Project the center of the box onto the axis.
+            XMVECTOR Dist = XMVector3Dot( Center, Axis );
 
-    // l = a(v) x b(v) = (r21, 0, -r01)
-    // d(A) = h(A) dot abs(r21, 0, r01)
-    // d(B) = h(B) dot abs(r12, 0, r10)
-    d = XMVector3Dot( t, XMVectorPermute( RX1, -RX1, Permute0Z0W1X0Y ) );
-    d_A = XMVector3Dot( h_A, XMVectorPermute( ARX1, ARX1, PermuteZWXY ) );
-    d_B = XMVector3Dot( h_B, XMVectorPermute( AR1X, AR1X, PermuteZWXY ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+            // Project the axes of the box onto the axis to find the "radius" of the box.
+            XMVECTOR Radius = XMVector3Dot( Axis, R.r[0] );
+            Radius = XMVectorSelect( Radius, XMVector3Dot( Axis, R.r[1] ), SelectY );
+            Radius = XMVectorSelect( Radius, XMVector3Dot( Axis, R.r[2] ), SelectZ );
+            Radius = XMVector3Dot( Extents, XMVectorAbs( Radius ) );
+
+            // if (center > max + radius || center < min - radius) reject;
+            Outside = XMVectorOrInt( Outside, XMVectorGreater( Dist, FrustumMax + Radius ) );
+            Outside = XMVectorOrInt( Outside, XMVectorLess( Dist, FrustumMin - Radius ) );
+        }
+    }
+
+    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+        return 0;
+
+    // If we did not find a separating plane then the box must intersect the frustum.
+    return 1;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Exact frustum vs frustum test.
+// Return values: 0 = no intersection, 
+//                1 = intersection, 
+//                2 = frustum A is completely inside frustum B
+//-----------------------------------------------------------------------------
+INT IntersectFrustumFrustum( const Frustum* pVolumeA, const Frustum* pVolumeB )
+{
+    XMASSERT( pVolumeA );
+    XMASSERT( pVolumeB );
+
+    // Load origin and orientation of frustum B.
+    XMVECTOR OriginB = XMLoadFloat3( &pVolumeB->Origin );
+    XMVECTOR OrientationB = XMLoadFloat4( &pVolumeB->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( OrientationB ) );
+
+    // Build the planes of frustum B.
+    XMVECTOR AxisB[6];
+    AxisB[0] = XMVectorSet( 0.0f, 0.0f, -1.0f, 0.0f );
+    AxisB[1] = XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f );
+    AxisB[2] = XMVectorSet( 1.0f, 0.0f, -pVolumeB->RightSlope, 0.0f );
+    AxisB[3] = XMVectorSet( -1.0f, 0.0f, pVolumeB->LeftSlope, 0.0f );
+    AxisB[4] = XMVectorSet( 0.0f, 1.0f, -pVolumeB->TopSlope, 0.0f );
+    AxisB[5] = XMVectorSet( 0.0f, -1.0f, pVolumeB->BottomSlope, 0.0f );
+
+    XMVECTOR PlaneDistB[6];
+    PlaneDistB[0] = -XMVectorReplicatePtr( &pVolumeB->Near );
+    PlaneDistB[1] = XMVectorReplicatePtr( &pVolumeB->Far );
+    PlaneDistB[2] = XMVectorZero();
+    PlaneDistB[3] = XMVectorZero();
+    PlaneDistB[4] = XMVectorZero();
+    PlaneDistB[5] = XMVectorZero();
+
+    // Load origin and orientation of frustum A.
+    XMVECTOR OriginA = XMLoadFloat3( &pVolumeA->Origin );
+    XMVECTOR OrientationA = XMLoadFloat4( &pVolumeA->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( OrientationA ) );
+
+    // Transform frustum A into the space of the frustum B in order to 
+    // minimize the number of transforms we have to do.
+    OriginA = XMVector3InverseRotate( OriginA - OriginB, OrientationB );
+    OrientationA = XMQuaternionMultiply( OrientationA, XMQuaternionConjugate( OrientationB ) );
+
+    // Build the corners of frustum A (in the local space of B).
+    XMVECTOR RightTopA = XMVectorSet( pVolumeA->RightSlope, pVolumeA->TopSlope, 1.0f, 0.0f );
+    XMVECTOR RightBottomA = XMVectorSet( pVolumeA->RightSlope, pVolumeA->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR LeftTopA = XMVectorSet( pVolumeA->LeftSlope, pVolumeA->TopSlope, 1.0f, 0.0f );
+    XMVECTOR LeftBottomA = XMVectorSet( pVolumeA->LeftSlope, pVolumeA->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR NearA = XMVectorReplicatePtr( &pVolumeA->Near );
+    XMVECTOR FarA = XMVectorReplicatePtr( &pVolumeA->Far );
+
+    RightTopA = XMVector3Rotate( RightTopA, OrientationA );
+    RightBottomA = XMVector3Rotate( RightBottomA, OrientationA );
+    LeftTopA = XMVector3Rotate( LeftTopA, OrientationA );
+    LeftBottomA = XMVector3Rotate( LeftBottomA, OrientationA );
+
+    XMVECTOR CornersA[8];
+    CornersA[0] = OriginA + RightTopA * NearA;
+    CornersA[1] = OriginA + RightBottomA * NearA;
+    CornersA[2] = OriginA + LeftTopA * NearA;
+    CornersA[3] = OriginA + LeftBottomA * NearA;
+    CornersA[4] = OriginA + RightTopA * FarA;
+    CornersA[5] = OriginA + RightBottomA * FarA;
+    CornersA[6] = OriginA + LeftTopA * FarA;
+    CornersA[7] = OriginA + LeftBottomA * FarA;
+
+    // Check frustum A against each plane of frustum B.
+    XMVECTOR Outside = XMVectorFalseInt();
+    XMVECTOR InsideAll = XMVectorTrueInt();
 
-    // l = a(v) x b(w) = (r22, 0, -r02)
-    // d(A) = h(A) dot abs(r22, 0, r02)
-    // d(B) = h(B) dot abs(r11, r10, 0)
-    d = XMVector3Dot( t, XMVectorPermute( RX2, -RX2, Permute0Z0W1X0Y ) );
-    d_A = XMVector3Dot( h_A, XMVectorPermute( ARX2, ARX2, PermuteZWXY ) );
-    d_B = XMVector3Dot( h_B, XMVectorPermute( AR1X, AR1X, PermuteYXWZ ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+    for( INT i = 0; i < 6; i++ )
+    {
+        // Find the min/max projection of the frustum onto the plane normal.
+        XMVECTOR Min, Max;
 
-    // l = a(w) x b(u) = (-r10, r00, 0)
-    // d(A) = h(A) dot abs(r10, r00, 0)
-    // d(B) = h(B) dot abs(0, r22, r21)
-    d = XMVector3Dot( t, XMVectorPermute( RX0, -RX0, Permute1Y0X0W0Z ) );
-    d_A = XMVector3Dot( h_A, XMVectorPermute( ARX0, ARX0, PermuteYXWZ ) );
-    d_B = XMVector3Dot( h_B, XMVectorPermute( AR2X, AR2X, PermuteWZYX ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+        Min = Max = XMVector3Dot( AxisB[i], CornersA[0] );
 
-    // l = a(w) x b(v) = (-r11, r01, 0)
-    // d(A) = h(A) dot abs(r11, r01, 0)
-    // d(B) = h(B) dot abs(r22, 0, r20)
-    d = XMVector3Dot( t, XMVectorPermute( RX1, -RX1, Permute1Y0X0W0Z ) );
-    d_A = XMVector3Dot( h_A, XMVectorPermute( ARX1, ARX1, PermuteYXWZ ) );
-    d_B = XMVector3Dot( h_B, XMVectorPermute( AR2X, AR2X, PermuteZWXY ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+        for( INT j = 1; j < 8; j++ )
+        {
+            XMVECTOR Temp = XMVector3Dot( AxisB[i], CornersA[j] );
+            Min = XMVectorMin( Min, Temp );
+            Max = XMVectorMax( Max, Temp );
+        }
 
-    // l = a(w) x b(w) = (-r12, r02, 0)
-    // d(A) = h(A) dot abs(r12, r02, 0)
-    // d(B) = h(B) dot abs(r21, r20, 0)
-    d = XMVector3Dot( t, XMVectorPermute( RX2, -RX2, Permute1Y0X0W0Z ) );
-    d_A = XMVector3Dot( h_A, XMVectorPermute( ARX2, ARX2, PermuteYXWZ ) );
-    d_B = XMVector3Dot( h_B, XMVectorPermute( AR2X, AR2X, PermuteYXWZ ) );
-    NoIntersection = XMVectorOrInt( NoIntersection, 
-                                    XMVectorGreater( XMVectorAbs(d), XMVectorAdd( d_A, d_B ) ) );
+        // Outside the plane?
+        Outside = XMVectorOrInt( Outside, XMVectorGreater( Min, PlaneDistB[i] ) );
 
-    // No seperating axis found, boxes must intersect.
-    return XMVector4NotEqualInt( NoIntersection, XMVectorTrueInt() );
-}
+        // Fully inside the plane?
+        InsideAll = XMVectorAndInt( InsideAll, XMVectorLessOrEqual( Max, PlaneDistB[i] ) );
+    }
 
+    // If the frustum A is outside any of the planes of frustum B it is outside. 
+    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+        return 0;
 
+    // If frustum A is inside all planes of frustum B it is fully inside.
+    if ( XMVector4EqualInt( InsideAll, XMVectorTrueInt() ) )
+        return 2;
 
-//-----------------------------------------------------------------------------
-// Exact triangle vs frustum test.
-// Return values: 0 = no intersection, 
-//                1 = intersection, 
-//                2 = triangle is completely inside frustum
-//-----------------------------------------------------------------------------
-INT IntersectTriangleFrustum( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const Frustum* pVolume )
-{
-    XMASSERT( pVolume );
+    // Build the corners of frustum B.
+    XMVECTOR RightTopB = XMVectorSet( pVolumeB->RightSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    XMVECTOR RightBottomB = XMVectorSet( pVolumeB->RightSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR LeftTopB = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
+    XMVECTOR LeftBottomB = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR NearB = XMVectorReplicatePtr( &pVolumeB->Near );
+    XMVECTOR FarB = XMVectorReplicatePtr( &pVolumeB->Far );
 
-    // Build the frustum planes (NOTE: D is negated from the usual).
-    XMVECTOR Planes[6];
-    Planes[0] = XMVectorSet( 0.0f, 0.0f, -1.0f, -pVolume->Near );
-    Planes[1] = XMVectorSet( 0.0f, 0.0f, 1.0f, pVolume->Far );
-    Planes[2] = XMVectorSet( 1.0f, 0.0f, -pVolume->RightSlope, 0.0f );
-    Planes[3] = XMVectorSet( -1.0f, 0.0f, pVolume->LeftSlope, 0.0f );
-    Planes[4] = XMVectorSet( 0.0f, 1.0f, -pVolume->TopSlope, 0.0f );
-    Planes[5] = XMVectorSet( 0.0f, -1.0f, pVolume->BottomSlope, 0.0f );
+    XMVECTOR CornersB[8];
+    CornersB[0] = RightTopB * NearB;
+    CornersB[1] = RightBottomB * NearB;
+    CornersB[2] = LeftTopB * NearB;
+    CornersB[3] = LeftBottomB * NearB;
+    CornersB[4] = RightTopB * FarB;
+    CornersB[5] = RightBottomB * FarB;
+    CornersB[6] = LeftTopB * FarB;
+    CornersB[7] = LeftBottomB * FarB;
 
-    // Load origin and orientation of the frustum.
-    XMVECTOR Origin = XMLoadFloat3( &pVolume->Origin );
-    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
+    // Build the planes of frustum A (in the local space of B).
+    XMVECTOR AxisA[6];
+    XMVECTOR PlaneDistA[6];
 
-    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+    AxisA[0] = XMVectorSet( 0.0f, 0.0f, -1.0f, 0.0f );
+    AxisA[1] = XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f );
+    AxisA[2] = XMVectorSet( 1.0f, 0.0f, -pVolumeA->RightSlope, 0.0f );
+    AxisA[3] = XMVectorSet( -1.0f, 0.0f, pVolumeA->LeftSlope, 0.0f );
+    AxisA[4] = XMVectorSet( 0.0f, 1.0f, -pVolumeA->TopSlope, 0.0f );
+    AxisA[5] = XMVectorSet( 0.0f, -1.0f, pVolumeA->BottomSlope, 0.0f );
 
-    // Transform triangle into the local space of frustum.
-    XMVECTOR TV0 = XMVector3InverseRotate( V0 - Origin, Orientation );
-    XMVECTOR TV1 = XMVector3InverseRotate( V1 - Origin, Orientation );
-    XMVECTOR TV2 = XMVector3InverseRotate( V2 - Origin, Orientation );
+    AxisA[0] = XMVector3Rotate( AxisA[0], OrientationA );
+    AxisA[1] = -AxisA[0];
+    AxisA[2] = XMVector3Rotate( AxisA[2], OrientationA );
+    AxisA[3] = XMVector3Rotate( AxisA[3], OrientationA );
+    AxisA[4] = XMVector3Rotate( AxisA[4], OrientationA );
+    AxisA[5] = XMVector3Rotate( AxisA[5], OrientationA );
 
-    // Test each vertex of the triangle against the frustum planes.
-    XMVECTOR Outside = XMVectorFalseInt();
-    XMVECTOR InsideAll = XMVectorTrueInt();
+    PlaneDistA[0] = XMVector3Dot( AxisA[0], CornersA[0] );  // Re-use corner on near plane.
+    PlaneDistA[1] = XMVector3Dot( AxisA[1], CornersA[4] );  // Re-use corner on far plane.
+    PlaneDistA[2] = XMVector3Dot( AxisA[2], OriginA );
+    PlaneDistA[3] = XMVector3Dot( AxisA[3], OriginA );
+    PlaneDistA[4] = XMVector3Dot( AxisA[4], OriginA );
+    PlaneDistA[5] = XMVector3Dot( AxisA[5], OriginA );
 
+    // Check each axis of frustum A for a seperating plane (5).
     for( INT i = 0; i < 6; i++ )
     {
-        XMVECTOR Dist0 = XMVector3Dot( TV0, Planes[i] );
-        XMVECTOR Dist1 = XMVector3Dot( TV1, Planes[i] );
-        XMVECTOR Dist2 = XMVector3Dot( TV2, Planes[i] );
+        // Find the minimum projection of the frustum onto the plane normal.
+        XMVECTOR Min;
 
-        XMVECTOR MinDist = XMVectorMin( Dist0, Dist1 );
-        MinDist = XMVectorMin( MinDist, Dist2 );
-        XMVECTOR MaxDist = XMVectorMax( Dist0, Dist1 );
-        MaxDist = XMVectorMax( MaxDist, Dist2 );
+        Min = XMVector3Dot( AxisA[i], CornersB[0] );
 
-        XMVECTOR PlaneDist = XMVectorSplatW( Planes[i] );
+        for( INT j = 1; j < 8; j++ )
+        {
+            XMVECTOR Temp = XMVector3Dot( AxisA[i], CornersB[j] );
+            Min = XMVectorMin( Min, Temp );
+        }
 
         // Outside the plane?
-        Outside = XMVectorOrInt( Outside, XMVectorGreater( MinDist, PlaneDist ) );
-
-        // Fully inside the plane?
-        InsideAll = XMVectorAndInt( InsideAll, XMVectorLessOrEqual( MaxDist, PlaneDist ) );
+        Outside = XMVectorOrInt( Outside, XMVectorGreater( Min, PlaneDistA[i] ) );
     }
 
-    // If the triangle is outside any of the planes it is outside. 
+    // If the frustum B is outside any of the planes of frustum A it is outside. 
     if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
         return 0;
 
-    // If the triangle is inside all planes it is fully inside.
-    if ( XMVector4EqualInt( InsideAll, XMVectorTrueInt() ) )
-        return 2;
+    // Check edge/edge axes (6 * 6).
+    XMVECTOR FrustumEdgeAxisA[6];
+    FrustumEdgeAxisA[0] = RightTopA;
+    FrustumEdgeAxisA[1] = RightBottomA;
+    FrustumEdgeAxisA[2] = LeftTopA;
+    FrustumEdgeAxisA[3] = LeftBottomA;
+    FrustumEdgeAxisA[4] = RightTopA - LeftTopA;
+    FrustumEdgeAxisA[5] = LeftBottomA - LeftTopA;
 
-    // Build the corners of the frustum.
-    XMVECTOR RightTop = XMVectorSet( pVolume->RightSlope, pVolume->TopSlope, 1.0f, 0.0f );
-    XMVECTOR RightBottom = XMVectorSet( pVolume->RightSlope, pVolume->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR LeftTop = XMVectorSet( pVolume->LeftSlope, pVolume->TopSlope, 1.0f, 0.0f );
-    XMVECTOR LeftBottom = XMVectorSet( pVolume->LeftSlope, pVolume->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR Near = XMVectorReplicatePtr( &pVolume->Near );
-    XMVECTOR Far = XMVectorReplicatePtr( &pVolume->Far );
+    XMVECTOR FrustumEdgeAxisB[6];
+    FrustumEdgeAxisB[0] = RightTopB;
+    FrustumEdgeAxisB[1] = RightBottomB;
+    FrustumEdgeAxisB[2] = LeftTopB;
+    FrustumEdgeAxisB[3] = LeftBottomB;
+    FrustumEdgeAxisB[4] = RightTopB - LeftTopB;
+    FrustumEdgeAxisB[5] = LeftBottomB - LeftTopB;
 
-    XMVECTOR Corners[8];
-    Corners[0] = RightTop * Near;
-    Corners[1] = RightBottom * Near;
-    Corners[2] = LeftTop * Near;
-    Corners[3] = LeftBottom * Near;
-    Corners[4] = RightTop * Far;
-    Corners[5] = RightBottom * Far;
-    Corners[6] = LeftTop * Far;
-    Corners[7] = LeftBottom * Far;
+    for( INT i = 0; i < 6; i++ )
+    {
+        for( INT j = 0; j < 6; j++ )
+        {
+            // Compute the axis we are going to test.
+            XMVECTOR Axis = XMVector3Cross( FrustumEdgeAxisA[i], FrustumEdgeAxisB[j] );
 
-    // Test the plane of the triangle.
-    XMVECTOR Normal = XMVector3Cross( V1 - V0, V2 - V0 );
-    XMVECTOR Dist = XMVector3Dot( Normal, V0 );
+            // Find the min/max values of the projection of both frustums onto the axis.
+            XMVECTOR MinA, MaxA;
+            XMVECTOR MinB, MaxB;
 
-    XMVECTOR MinDist, MaxDist;
-    MinDist = MaxDist = XMVector3Dot( Corners[0], Normal );
-    for( INT i = 1; i < 8; i++ )
-    {
-        XMVECTOR Temp = XMVector3Dot( Corners[i], Normal );
-        MinDist = XMVectorMin( MinDist, Temp );
-        MaxDist = XMVectorMax( MaxDist, Temp );
+            MinA = MaxA = XMVector3Dot( Axis, CornersA[0] );
+            MinB = MaxB = XMVector3Dot( Axis, CornersB[0] );
+
+            for( INT k = 1; k < 8; k++ )
+            {
+                XMVECTOR TempA = XMVector3Dot( Axis, CornersA[k] );
+                MinA = XMVectorMin( MinA, TempA );
+                MaxA = XMVectorMax( MaxA, TempA );
+
+                XMVECTOR TempB = XMVector3Dot( Axis, CornersB[k] );
+                MinB = XMVectorMin( MinB, TempB );
+                MaxB = XMVectorMax( MaxB, TempB );
+            }
+
+            // if (MinA > MaxB || MinB > MaxA) reject
+            Outside = XMVectorOrInt( Outside, XMVectorGreater( MinA, MaxB ) );
+            Outside = XMVectorOrInt( Outside, XMVectorGreater( MinB, MaxA ) );
+        }
     }
 
-    Outside = XMVectorOrInt( XMVectorGreater( MinDist, Dist ), XMVectorLess( MaxDist, Dist ) );   
+    // If there is a seperating plane, then the frustums do not intersect.
     if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
         return 0;
 
-    // Check the edge/edge axes (3*6).
-    XMVECTOR TriangleEdgeAxis[3];
-    TriangleEdgeAxis[0] = V1 - V0;
-    TriangleEdgeAxis[1] = V2 - V1;
-    TriangleEdgeAxis[2] = V0 - V2;
+    // If we did not find a separating plane then the frustums intersect.
+    return 1;
+}
 
-    XMVECTOR FrustumEdgeAxis[6];
-    FrustumEdgeAxis[0] = RightTop;
-    FrustumEdgeAxis[1] = RightBottom;
-    FrustumEdgeAxis[2] = LeftTop;
-    FrustumEdgeAxis[3] = LeftBottom;
-    FrustumEdgeAxis[4] = RightTop - LeftTop;
-    FrustumEdgeAxis[5] = LeftBottom - LeftTop;
 
-    for( INT i = 0; i < 3; i++ )
-    {
-        for( INT j = 0; j < 6; j++ )
-        {
-            // Compute the axis we are going to test.
-            XMVECTOR Axis = XMVector3Cross( TriangleEdgeAxis[i], FrustumEdgeAxis[j] );
 
-            // Find the min/max of the projection of the triangle onto the axis.
-            XMVECTOR MinA, MaxA;
+//-----------------------------------------------------------------------------
+static inline void FastIntersectTrianglePlane( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, CXMVECTOR Plane,
+                                        XMVECTOR& Outside, XMVECTOR& Inside )
+{
+    // Plane0
+    XMVECTOR Dist0 = XMVector4Dot( V0, Plane );
+    XMVECTOR Dist1 = XMVector4Dot( V1, Plane );
+    XMVECTOR Dist2 = XMVector4Dot( V2, Plane );
+
+    XMVECTOR MinDist = XMVectorMin( Dist0, Dist1 );
+    MinDist = XMVectorMin( MinDist, Dist2 );
+
+    XMVECTOR MaxDist = XMVectorMax( Dist0, Dist1 );
+    MaxDist = XMVectorMax( MaxDist, Dist2 );
+
+    XMVECTOR Zero = XMVectorZero();
+
+    // Outside the plane?
+    Outside = XMVectorGreater( MinDist, Zero );
+
+    // Fully inside the plane?
+    Inside = XMVectorLess( MaxDist, Zero );
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Test a triangle vs 6 planes (typically forming a frustum).
+// Return values: 0 = no intersection, 
+//                1 = may be intersecting, 
+//                2 = triangle is inside all planes
+//-----------------------------------------------------------------------------
+INT IntersectTriangle6Planes( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, CXMVECTOR Plane0, CXMVECTOR Plane1,
+                              CXMVECTOR Plane2, CXMVECTOR Plane3, CXMVECTOR Plane4, CXMVECTOR Plane5 )
+{
+    XMVECTOR One = XMVectorSplatOne();
+
+    // Set w of the points to one so we can dot4 with a plane.
+    XMVECTOR TV0 = XMVectorInsert<0, 0, 0, 0, 1>( V0, One );
+    XMVECTOR TV1 = XMVectorInsert<0, 0, 0, 0, 1>( V1, One );
+    XMVECTOR TV2 = XMVectorInsert<0, 0, 0, 0, 1>( V2, One );
+
+    XMVECTOR Outside, Inside;
 
-            XMVECTOR Dist0 = XMVector3Dot( V0, Axis );
-            XMVECTOR Dist1 = XMVector3Dot( V1, Axis );
-            XMVECTOR Dist2 = XMVector3Dot( V2, Axis );
+    // Test against each plane.
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane0, Outside, Inside );
 
-            MinA = XMVectorMin( Dist0, Dist1 );
-            MinA = XMVectorMin( MinA, Dist2 );
-            MaxA = XMVectorMax( Dist0, Dist1 );
-            MaxA = XMVectorMax( MaxA, Dist2 );
+    XMVECTOR AnyOutside = Outside;
+    XMVECTOR AllInside = Inside;
 
-            // Find the min/max of the projection of the frustum onto the axis.
-            XMVECTOR MinB, MaxB;
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane1, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-            MinB = MaxB = XMVector3Dot( Axis, Corners[0] );
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane2, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-            for( INT k = 1; k < 8; k++ )
-            {
-                XMVECTOR Temp = XMVector3Dot( Axis, Corners[k] );
-                MinB = XMVectorMin( MinB, Temp );
-                MaxB = XMVectorMax( MaxB, Temp );
-            }
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane3, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-            // if (MinA > MaxB || MinB > MaxA) reject;
-            Outside = XMVectorOrInt( Outside, XMVectorGreater( MinA, MaxB ) );
-            Outside = XMVectorOrInt( Outside, XMVectorGreater( MinB, MaxA ) );
-        }
-    }
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane4, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane5, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
+
+    // If the triangle is outside any plane it is outside.
+    if ( XMVector4EqualInt( AnyOutside, XMVectorTrueInt() ) )
         return 0;
 
-    // If we did not find a separating plane then the triangle must intersect the frustum.
+    // If the triangle is inside all planes it is inside.
+    if ( XMVector4EqualInt( AllInside, XMVectorTrueInt() ) )
+        return 2;
+
+    // The triangle is not inside all planes or outside a plane, it may intersect.
     return 1;
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Exact sphere vs frustum test.  The algorithm first checks the sphere against
-// the planes of the frustum, then if the plane checks were indeterminate finds
-// the nearest feature (plane, line, point) on the frustum to the center of the
-// sphere and compares the distance to the nearest feature to the radius of the 
-// sphere (it is so cool that all the comment lines above are the same length).
-// Return values: 0 = no intersection, 
-//                1 = intersection, 
-//                2 = sphere is completely inside frustum
-//-----------------------------------------------------------------------------
-INT IntersectSphereFrustum( const Sphere* pVolumeA, const Frustum* pVolumeB )
+static inline void FastIntersectSpherePlane( FXMVECTOR Center, FXMVECTOR Radius, FXMVECTOR Plane,
+                                      XMVECTOR& Outside, XMVECTOR& Inside )
 {
-    XMASSERT( pVolumeA );
-    XMASSERT( pVolumeB );
+    XMVECTOR Dist = XMVector4Dot( Center, Plane );
 
-    XMVECTOR Zero = XMVectorZero();
+    // Outside the plane?
+    Outside = XMVectorGreater( Dist, Radius );
 
-    // Build the frustum planes.
-    XMVECTOR Planes[6];
-    Planes[0] = XMVectorSet( 0.0f, 0.0f, -1.0f, pVolumeB->Near );
-    Planes[1] = XMVectorSet( 0.0f, 0.0f, 1.0f, -pVolumeB->Far );
-    Planes[2] = XMVectorSet( 1.0f, 0.0f, -pVolumeB->RightSlope, 0.0f );
-    Planes[3] = XMVectorSet( -1.0f, 0.0f, pVolumeB->LeftSlope, 0.0f );
-    Planes[4] = XMVectorSet( 0.0f, 1.0f, -pVolumeB->TopSlope, 0.0f );
-    Planes[5] = XMVectorSet( 0.0f, -1.0f, pVolumeB->BottomSlope, 0.0f );
+    // Fully inside the plane?
+    Inside = XMVectorLess( Dist, -Radius );
+}
 
-    // Normalize the planes so we can compare to the sphere radius.
-    Planes[2] = XMVector3Normalize( Planes[2] );
-    Planes[3] = XMVector3Normalize( Planes[3] );
-    Planes[4] = XMVector3Normalize( Planes[4] );
-    Planes[5] = XMVector3Normalize( Planes[5] );
 
-    // Load origin and orientation of the frustum.
-    XMVECTOR Origin = XMLoadFloat3( &pVolumeB->Origin );
-    XMVECTOR Orientation = XMLoadFloat4( &pVolumeB->Orientation );
 
-    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+//-----------------------------------------------------------------------------
+// Test a sphere vs 6 planes (typically forming a frustum).
+// Return values: 0 = no intersection, 
+//                1 = may be intersecting, 
+//                2 = sphere is inside all planes
+//-----------------------------------------------------------------------------
+INT IntersectSphere6Planes( const Sphere* pVolume, FXMVECTOR Plane0, FXMVECTOR Plane1, FXMVECTOR Plane2,
+                            CXMVECTOR Plane3, CXMVECTOR Plane4, CXMVECTOR Plane5 )
+{
+    XMASSERT( pVolume );
 
     // Load the sphere.
-    XMVECTOR Center = XMLoadFloat3( &pVolumeA->Center );
-    XMVECTOR Radius = XMVectorReplicatePtr( &pVolumeA->Radius );
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
 
-    // Transform the center of the sphere into the local space of frustum.
-    Center = XMVector3InverseRotate( Center - Origin, Orientation );
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = XMVectorInsert<0, 0, 0, 0, 1>( Center, XMVectorSplatOne() );
 
-    // Set w of the center to one so we can dot4 with the plane.
-    Center = XMVectorInsert( Center, XMVectorSplatOne(), 0, 0, 0, 0, 1);
+    XMVECTOR Outside, Inside;
 
-    // Check against each plane of the frustum.
-    XMVECTOR Outside = XMVectorFalseInt();
-    XMVECTOR InsideAll = XMVectorTrueInt();
-    XMVECTOR CenterInsideAll = XMVectorTrueInt();
+    // Test against each plane.
+    FastIntersectSpherePlane( Center, Radius, Plane0, Outside, Inside );
 
-    XMVECTOR Dist[6];
+    XMVECTOR AnyOutside = Outside;
+    XMVECTOR AllInside = Inside;
 
-    for( INT i = 0; i < 6; i++ )
-    {
-        Dist[i] = XMVector4Dot( Center, Planes[i] );
+    FastIntersectSpherePlane( Center, Radius, Plane1, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-        // Outside the plane?
-        Outside = XMVectorOrInt( Outside, XMVectorGreater( Dist[i], Radius ) );
+    FastIntersectSpherePlane( Center, Radius, Plane2, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-        // Fully inside the plane?
-        InsideAll = XMVectorAndInt( InsideAll, XMVectorLessOrEqual( Dist[i], -Radius ) );
+    FastIntersectSpherePlane( Center, Radius, Plane3, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-        // Check if the center is inside the plane.
-        CenterInsideAll = XMVectorAndInt( CenterInsideAll, XMVectorLessOrEqual( Dist[i], Zero ) );
-    }
+    FastIntersectSpherePlane( Center, Radius, Plane4, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    // If the sphere is outside any of the planes it is outside. 
-    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+    FastIntersectSpherePlane( Center, Radius, Plane5, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
+
+    // If the sphere is outside any plane it is outside.
+    if ( XMVector4EqualInt( AnyOutside, XMVectorTrueInt() ) )
         return 0;
 
-    // If the sphere is inside all planes it is fully inside.
-    if ( XMVector4EqualInt( InsideAll, XMVectorTrueInt() ) )
+    // If the sphere is inside all planes it is inside.
+    if ( XMVector4EqualInt( AllInside, XMVectorTrueInt() ) )
         return 2;
 
-    // If the center of the sphere is inside all planes and the sphere intersects 
-    // one or more planes then it must intersect.
-    if ( XMVector4EqualInt( CenterInsideAll, XMVectorTrueInt() ) )
-        return 1;
+    // The sphere is not inside all planes or outside a plane, it may intersect.
+    return 1;
+}
 
-    // The sphere may be outside the frustum or intersecting the frustum.
-    // Find the nearest feature (face, edge, or corner) on the frustum 
-    // to the sphere.
 
-    // The faces adjacent to each face are:
-    static const INT adjacent_faces[6][4] =
-    {
-        { 2, 3, 4, 5 },    // 0
-        { 2, 3, 4, 5 },    // 1
-        { 0, 1, 4, 5 },    // 2
-        { 0, 1, 4, 5 },    // 3
-        { 0, 1, 2, 3 },    // 4
-        { 0, 1, 2, 3 }
-    };  // 5
 
-    XMVECTOR Intersects = XMVectorFalseInt();
+//-----------------------------------------------------------------------------
+static inline void FastIntersectAxisAlignedBoxPlane( FXMVECTOR Center, FXMVECTOR Extents, FXMVECTOR Plane,
+                                              XMVECTOR& Outside, XMVECTOR& Inside )
+{
+    // Compute the distance to the center of the box.
+    XMVECTOR Dist = XMVector4Dot( Center, Plane );
 
-    // Check to see if the nearest feature is one of the planes.
-    for( INT i = 0; i < 6; i++ )
-    {
-        // Find the nearest point on the plane to the center of the sphere.
-        XMVECTOR Point = Center - (Planes[i] * Dist[i]);
+    // Project the axes of the box onto the normal of the plane.  Half the
+    // length of the projection (sometime called the "radius") is equal to
+    // h(u) * abs(n dot b(u))) + h(v) * abs(n dot b(v)) + h(w) * abs(n dot b(w))
+    // where h(i) are extents of the box, n is the plane normal, and b(i) are the 
+    // axes of the box. In this case b(i) = [(1,0,0), (0,1,0), (0,0,1)].
+    XMVECTOR Radius = XMVector3Dot( Extents, XMVectorAbs( Plane ) );
 
-        // Set w of the point to one.
-        Point = XMVectorInsert( Point, XMVectorSplatOne(), 0, 0, 0, 0, 1 );
-        
-        // If the point is inside the face (inside the adjacent planes) then
-        // this plane is the nearest feature.
-        XMVECTOR InsideFace = XMVectorTrueInt();
-        
-        for ( INT j = 0; j < 4; j++ )
-        {
-            INT plane_index = adjacent_faces[i][j];
+    // Outside the plane?
+    Outside = XMVectorGreater( Dist, Radius );
 
-            InsideFace = XMVectorAndInt( InsideFace,
-                           XMVectorLessOrEqual( XMVector4Dot( Point, Planes[plane_index] ), Zero ) );
-        }
-     
-        // Since we have already checked distance from the plane we know that the
-        // sphere must intersect if this plane is the nearest feature.
-        Intersects = XMVectorOrInt( Intersects, 
-                                    XMVectorAndInt( XMVectorGreater( Dist[i], Zero ), InsideFace ) );
-    }
+    // Fully inside the plane?
+    Inside = XMVectorLess( Dist, -Radius );
+}
 
-    if ( XMVector4EqualInt( Intersects, XMVectorTrueInt() ) )
-        return 1;
 
-    // Build the corners of the frustum.
-    XMVECTOR RightTop = XMVectorSet( pVolumeB->RightSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
-    XMVECTOR RightBottom = XMVectorSet( pVolumeB->RightSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR LeftTop = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
-    XMVECTOR LeftBottom = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR Near = XMVectorReplicatePtr( &pVolumeB->Near );
-    XMVECTOR Far = XMVectorReplicatePtr( &pVolumeB->Far );
 
-    XMVECTOR Corners[8];
-    Corners[0] = RightTop * Near;
-    Corners[1] = RightBottom * Near;
-    Corners[2] = LeftTop * Near;
-    Corners[3] = LeftBottom * Near;
-    Corners[4] = RightTop * Far;
-    Corners[5] = RightBottom * Far;
-    Corners[6] = LeftTop * Far;
-    Corners[7] = LeftBottom * Far;
+//-----------------------------------------------------------------------------
+// Test an axis alinged box vs 6 planes (typically forming a frustum).
+// Return values: 0 = no intersection, 
+//                1 = may be intersecting, 
+//                2 = box is inside all planes
+//-----------------------------------------------------------------------------
+INT IntersectAxisAlignedBox6Planes( const AxisAlignedBox* pVolume, FXMVECTOR Plane0, FXMVECTOR Plane1,
+                                    FXMVECTOR Plane2, CXMVECTOR Plane3, CXMVECTOR Plane4, CXMVECTOR Plane5 )
+{
+    XMASSERT( pVolume );
+
+    // Load the box.
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
 
-    // The Edges are:
-    static const INT edges[12][2] =
-    {
-        { 0, 1 }, { 2, 3 }, { 0, 2 }, { 1, 3 },    // Near plane
-        { 4, 5 }, { 6, 7 }, { 4, 6 }, { 5, 7 },    // Far plane
-        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
-    }; // Near to far
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = XMVectorInsert<0, 0, 0, 0, 1>( Center, XMVectorSplatOne() );
 
-    XMVECTOR RadiusSq = Radius * Radius;
+    XMVECTOR Outside, Inside;
 
-    // Check to see if the nearest feature is one of the edges (or corners).
-    for( INT i = 0; i < 12; i++ )
-    {
-        INT ei0 = edges[i][0];
-        INT ei1 = edges[i][1];
+    // Test against each plane.
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane0, Outside, Inside );
 
-        // Find the nearest point on the edge to the center of the sphere.
-        // The corners of the frustum are included as the endpoints of the edges.
-        XMVECTOR Point = PointOnLineSegmentNearestPoint( Corners[ei0], Corners[ei1], Center );
+    XMVECTOR AnyOutside = Outside;
+    XMVECTOR AllInside = Inside;
 
-        XMVECTOR Delta = Center - Point;
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane1, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-        XMVECTOR DistSq = XMVector3Dot( Delta, Delta );
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane2, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-        // If the distance to the center of the sphere to the point is less than 
-        // the radius of the sphere then it must intersect.
-        Intersects = XMVectorOrInt( Intersects, XMVectorLessOrEqual( DistSq, RadiusSq ) );
-    }
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane3, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    if ( XMVector4EqualInt( Intersects, XMVectorTrueInt() ) )
-        return 1;
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane4, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    // The sphere must be outside the frustum.
-    return 0;
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane5, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
+
+    // If the box is outside any plane it is outside.
+    if ( XMVector4EqualInt( AnyOutside, XMVectorTrueInt() ) )
+        return 0;
+
+    // If the box is inside all planes it is inside.
+    if ( XMVector4EqualInt( AllInside, XMVectorTrueInt() ) )
+        return 2;
+
+    // The box is not inside all planes or outside a plane, it may intersect.
+    return 1;
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Exact axis alinged box vs frustum test.  Constructs an oriented box and uses
-// the oriented box vs frustum test.
-//
-// Return values: 0 = no intersection, 
-//                1 = intersection, 
-//                2 = box is completely inside frustum
-//-----------------------------------------------------------------------------
-INT IntersectAxisAlignedBoxFrustum( const AxisAlignedBox* pVolumeA, const Frustum* pVolumeB )
+static inline void FastIntersectOrientedBoxPlane( FXMVECTOR Center, FXMVECTOR Extents, FXMVECTOR Axis0, CXMVECTOR Axis1,
+                                          CXMVECTOR Axis2, CXMVECTOR Plane, XMVECTOR& Outside, XMVECTOR& Inside )
 {
-    XMASSERT( pVolumeA );
-    XMASSERT( pVolumeB );
+    // Compute the distance to the center of the box.
+    XMVECTOR Dist = XMVector4Dot( Center, Plane );
 
-    // Make the axis aligned box oriented and do an OBB vs frustum test.
-    OrientedBox BoxA;
+    // Project the axes of the box onto the normal of the plane.  Half the
+    // length of the projection (sometime called the "radius") is equal to
+    // h(u) * abs(n dot b(u))) + h(v) * abs(n dot b(v)) + h(w) * abs(n dot b(w))
+    // where h(i) are extents of the box, n is the plane normal, and b(i) are the 
+    // axes of the box.
+    XMVECTOR Radius = XMVector3Dot( Plane, Axis0 );
+    Radius = XMVectorInsert<0, 0, 1, 0, 0>( Radius, XMVector3Dot( Plane, Axis1 ) );
+    Radius = XMVectorInsert<0, 0, 0, 1, 0>( Radius, XMVector3Dot( Plane, Axis2 ) );
+    Radius = XMVector3Dot( Extents, XMVectorAbs( Radius ) );
 
-    BoxA.Center = pVolumeA->Center;
-    BoxA.Extents = pVolumeA->Extents;
-    BoxA.Orientation.x = 0.0f;
-    BoxA.Orientation.y = 0.0f;
-    BoxA.Orientation.z = 0.0f;
-    BoxA.Orientation.w = 1.0f;
+    // Outside the plane?
+    Outside = XMVectorGreater( Dist, Radius );
 
-    return IntersectOrientedBoxFrustum( &BoxA, pVolumeB );
+    // Fully inside the plane?
+    Inside = XMVectorLess( Dist, -Radius );
 }
 
 
+
 //-----------------------------------------------------------------------------
-// Exact oriented box vs frustum test.
+// Test an oriented box vs 6 planes (typically forming a frustum).
 // Return values: 0 = no intersection, 
-//                1 = intersection, 
-//                2 = box is completely inside frustum
+//                1 = may be intersecting, 
+//                2 = box is inside all planes
 //-----------------------------------------------------------------------------
-INT IntersectOrientedBoxFrustum( const OrientedBox* pVolumeA, const Frustum* pVolumeB )
+INT IntersectOrientedBox6Planes( const OrientedBox* pVolume, FXMVECTOR Plane0, FXMVECTOR Plane1, FXMVECTOR Plane2,
+                                 CXMVECTOR Plane3, CXMVECTOR Plane4, CXMVECTOR Plane5 )
 {
-    XMASSERT( pVolumeA );
-    XMASSERT( pVolumeB );
-
-    static const XMVECTORI32 SelectY =
-    {
-        XM_SELECT_0, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0
-    };
-    static const XMVECTORI32 SelectZ =
-    {
-        XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0
-    };
-
-    XMVECTOR Zero = XMVectorZero();
-
-    // Build the frustum planes.
-    XMVECTOR Planes[6];
-    Planes[0] = XMVectorSet( 0.0f, 0.0f, -1.0f, pVolumeB->Near );
-    Planes[1] = XMVectorSet( 0.0f, 0.0f, 1.0f, -pVolumeB->Far );
-    Planes[2] = XMVectorSet( 1.0f, 0.0f, -pVolumeB->RightSlope, 0.0f );
-    Planes[3] = XMVectorSet( -1.0f, 0.0f, pVolumeB->LeftSlope, 0.0f );
-    Planes[4] = XMVectorSet( 0.0f, 1.0f, -pVolumeB->TopSlope, 0.0f );
-    Planes[5] = XMVectorSet( 0.0f, -1.0f, pVolumeB->BottomSlope, 0.0f );
-
-    // Load origin and orientation of the frustum.
-    XMVECTOR Origin = XMLoadFloat3( &pVolumeB->Origin );
-    XMVECTOR FrustumOrientation = XMLoadFloat4( &pVolumeB->Orientation );
-
-    XMASSERT( XMQuaternionIsUnit( FrustumOrientation ) );
+    XMASSERT( pVolume );
 
     // Load the box.
-    XMVECTOR Center = XMLoadFloat3( &pVolumeA->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pVolumeA->Extents );
-    XMVECTOR BoxOrientation = XMLoadFloat4( &pVolumeA->Orientation );
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
+    XMVECTOR BoxOrientation = XMLoadFloat4( &pVolume->Orientation );
 
     XMASSERT( XMQuaternionIsUnit( BoxOrientation ) );
 
-    // Transform the oriented box into the space of the frustum in order to 
-    // minimize the number of transforms we have to do.
-    Center = XMVector3InverseRotate( Center - Origin, FrustumOrientation );
-    BoxOrientation = XMQuaternionMultiply( BoxOrientation, XMQuaternionConjugate( FrustumOrientation ) );
-
-    // Set w of the center to one so we can dot4 with the plane.
-    Center = XMVectorInsert( Center, XMVectorSplatOne(), 0, 0, 0, 0, 1);
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = XMVectorInsert<0, 0, 0, 0, 1>( Center, XMVectorSplatOne() );
 
     // Build the 3x3 rotation matrix that defines the box axes.
     XMMATRIX R = XMMatrixRotationQuaternion( BoxOrientation );
 
-    // Check against each plane of the frustum.
-    XMVECTOR Outside = XMVectorFalseInt();
-    XMVECTOR InsideAll = XMVectorTrueInt();
-    XMVECTOR CenterInsideAll = XMVectorTrueInt();
-
-    for( INT i = 0; i < 6; i++ )
-    {
-        // Compute the distance to the center of the box.
-        XMVECTOR Dist = XMVector4Dot( Center, Planes[i] );
-
-        // Project the axes of the box onto the normal of the plane.  Half the
-        // length of the projection (sometime called the "radius") is equal to
-        // h(u) * abs(n dot b(u))) + h(v) * abs(n dot b(v)) + h(w) * abs(n dot b(w))
-        // where h(i) are extents of the box, n is the plane normal, and b(i) are the 
-        // axes of the box.
-        XMVECTOR Radius = XMVector3Dot( Planes[i], R.r[0] );
-        Radius = XMVectorSelect( Radius, XMVector3Dot( Planes[i], R.r[1] ), SelectY );
-        Radius = XMVectorSelect( Radius, XMVector3Dot( Planes[i], R.r[2] ), SelectZ );
-        Radius = XMVector3Dot( Extents, XMVectorAbs( Radius ) );
-
-        // Outside the plane?
-        Outside = XMVectorOrInt( Outside, XMVectorGreater( Dist, Radius ) );
-
-        // Fully inside the plane?
-        InsideAll = XMVectorAndInt( InsideAll, XMVectorLessOrEqual( Dist, -Radius ) );
+    XMVECTOR Outside, Inside;
 
-        // Check if the center is inside the plane.
-        CenterInsideAll = XMVectorAndInt( CenterInsideAll, XMVectorLessOrEqual( Dist, Zero ) );
-    }
+    // Test against each plane.
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane0, Outside, Inside );
 
-    // If the box is outside any of the planes it is outside. 
-    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
-        return 0;
+    XMVECTOR AnyOutside = Outside;
+    XMVECTOR AllInside = Inside;
 
-    // If the box is inside all planes it is fully inside.
-    if ( XMVector4EqualInt( InsideAll, XMVectorTrueInt() ) )
-        return 2;
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane1, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    // If the center of the box is inside all planes and the box intersects 
-    // one or more planes then it must intersect.
-    if ( XMVector4EqualInt( CenterInsideAll, XMVectorTrueInt() ) )
-        return 1;
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane2, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    // Build the corners of the frustum.
-    XMVECTOR RightTop = XMVectorSet( pVolumeB->RightSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
-    XMVECTOR RightBottom = XMVectorSet( pVolumeB->RightSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR LeftTop = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
-    XMVECTOR LeftBottom = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR Near = XMVectorReplicatePtr( &pVolumeB->Near );
-    XMVECTOR Far = XMVectorReplicatePtr( &pVolumeB->Far );
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane3, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    XMVECTOR Corners[8];
-    Corners[0] = RightTop * Near;
-    Corners[1] = RightBottom * Near;
-    Corners[2] = LeftTop * Near;
-    Corners[3] = LeftBottom * Near;
-    Corners[4] = RightTop * Far;
-    Corners[5] = RightBottom * Far;
-    Corners[6] = LeftTop * Far;
-    Corners[7] = LeftBottom * Far;
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane4, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    // Test against box axes (3)
-    {
-        // Find the min/max values of the projection of the frustum onto each axis.
-        XMVECTOR FrustumMin, FrustumMax;
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane5, Outside, Inside );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-        FrustumMin = XMVector3Dot( Corners[0], R.r[0] );
-        FrustumMin = XMVectorSelect( FrustumMin, XMVector3Dot( Corners[0], R.r[1] ), SelectY );
-        FrustumMin = XMVectorSelect( FrustumMin, XMVector3Dot( Corners[0], R.r[2] ), SelectZ );
-        FrustumMax = FrustumMin;
+    // If the box is outside any plane it is outside.
+    if ( XMVector4EqualInt( AnyOutside, XMVectorTrueInt() ) )
+        return 0;
 
-        for( INT i = 1; i < 8; i++ )
-        {
-            XMVECTOR Temp = XMVector3Dot( Corners[i], R.r[0] );
-            Temp = XMVectorSelect( Temp, XMVector3Dot( Corners[i], R.r[1] ), SelectY );
-            Temp = XMVectorSelect( Temp, XMVector3Dot( Corners[i], R.r[2] ), SelectZ );
+    // If the box is inside all planes it is inside.
+    if ( XMVector4EqualInt( AllInside, XMVectorTrueInt() ) )
+        return 2;
 
-            FrustumMin = XMVectorMin( FrustumMin, Temp );
-            FrustumMax = XMVectorMax( FrustumMax, Temp );
-        }
+    // The box is not inside all planes or outside a plane, it may intersect.
+    return 1;
+}
 
-        // Project the center of the box onto the axes.
-        XMVECTOR BoxDist = XMVector3Dot( Center, R.r[0] );
-        BoxDist = XMVectorSelect( BoxDist, XMVector3Dot( Center, R.r[1] ), SelectY );
-        BoxDist = XMVectorSelect( BoxDist, XMVector3Dot( Center, R.r[2] ), SelectZ );
 
-        // The projection of the box onto the axis is just its Center and Extents.
-        // if (min > box_max || max < box_min) reject;
-        XMVECTOR Result = XMVectorOrInt( XMVectorGreater( FrustumMin, BoxDist + Extents ),
-                                          XMVectorLess( FrustumMax, BoxDist - Extents ) );
 
-        if( XMVector3AnyTrue( Result ) )
-            return 0;
-    }
+//-----------------------------------------------------------------------------
+static inline void FastIntersectFrustumPlane( FXMVECTOR Point0, FXMVECTOR Point1, FXMVECTOR Point2, CXMVECTOR Point3,
+                                      CXMVECTOR Point4, CXMVECTOR Point5, CXMVECTOR Point6, CXMVECTOR Point7,
+                                      CXMVECTOR Plane, XMVECTOR& Outside, XMVECTOR& Inside )
+{
+    // Find the min/max projection of the frustum onto the plane normal.
+    XMVECTOR Min, Max, Dist;
 
-    // Test against edge/edge axes (3*6).
-    XMVECTOR FrustumEdgeAxis[6];
+    Min = Max = XMVector3Dot( Plane, Point0 );
 
-    FrustumEdgeAxis[0] = RightTop;
-    FrustumEdgeAxis[1] = RightBottom;
-    FrustumEdgeAxis[2] = LeftTop;
-    FrustumEdgeAxis[3] = LeftBottom;
-    FrustumEdgeAxis[4] = RightTop - LeftTop;
-    FrustumEdgeAxis[5] = LeftBottom - LeftTop;
+    Dist = XMVector3Dot( Plane, Point1 );
+    Min = XMVectorMin( Min, Dist );
+    Max = XMVectorMax( Max, Dist );
 
-    for( INT i = 0; i < 3; i++ )
-    {
-        for( INT j = 0; j < 6; j++ )
-        {
-            // Compute the axis we are going to test.
-            XMVECTOR Axis = XMVector3Cross( R.r[i], FrustumEdgeAxis[j] );
+    Dist = XMVector3Dot( Plane, Point2 );
+    Min = XMVectorMin( Min, Dist );
+    Max = XMVectorMax( Max, Dist );
 
-            // Find the min/max values of the projection of the frustum onto the axis.
-            XMVECTOR FrustumMin, FrustumMax;
+    Dist = XMVector3Dot( Plane, Point3 );
+    Min = XMVectorMin( Min, Dist );
+    Max = XMVectorMax( Max, Dist );
 
-            FrustumMin = FrustumMax = XMVector3Dot( Axis, Corners[0] );
+    Dist = XMVector3Dot( Plane, Point4 );
+    Min = XMVectorMin( Min, Dist );
+    Max = XMVectorMax( Max, Dist );
 
-            for( INT k = 1; k < 8; k++ )
-            {
-                XMVECTOR Temp = XMVector3Dot( Axis, Corners[k] );
-                FrustumMin = XMVectorMin( FrustumMin, Temp );
-                FrustumMax = XMVectorMax( FrustumMax, Temp );
-            }
+    Dist = XMVector3Dot( Plane, Point5 );
+    Min = XMVectorMin( Min, Dist );
+    Max = XMVectorMax( Max, Dist );
 
-            // Project the center of the box onto the axis.
-            XMVECTOR Dist = XMVector3Dot( Center, Axis );
+    Dist = XMVector3Dot( Plane, Point6 );
+    Min = XMVectorMin( Min, Dist );
+    Max = XMVectorMax( Max, Dist );
 
-            // Project the axes of the box onto the axis to find the "radius" of the box.
-            XMVECTOR Radius = XMVector3Dot( Axis, R.r[0] );
-            Radius = XMVectorSelect( Radius, XMVector3Dot( Axis, R.r[1] ), SelectY );
-            Radius = XMVectorSelect( Radius, XMVector3Dot( Axis, R.r[2] ), SelectZ );
-            Radius = XMVector3Dot( Extents, XMVectorAbs( Radius ) );
+    Dist = XMVector3Dot( Plane, Point7 );
+    Min = XMVectorMin( Min, Dist );
+    Max = XMVectorMax( Max, Dist );
 
-            // if (center > max + radius || center < min - radius) reject;
-            Outside = XMVectorOrInt( Outside, XMVectorGreater( Dist, FrustumMax + Radius ) );
-            Outside = XMVectorOrInt( Outside, XMVectorLess( Dist, FrustumMin - Radius ) );
-        }
-    }
+    XMVECTOR PlaneDist = -XMVectorSplatW( Plane );
 
-    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
-        return 0;
+    // Outside the plane?
+    Outside = XMVectorGreater( Min, PlaneDist );
 
-    // If we did not find a separating plane then the box must intersect the frustum.
-    return 1;
+    // Fully inside the plane?
+    Inside = XMVectorLess( Max, PlaneDist );
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Exact frustum vs frustum test.
+// Test a frustum vs 6 planes (typically forming another frustum).
 // Return values: 0 = no intersection, 
-//                1 = intersection, 
-//                2 = frustum A is completely inside frustum B
+//                1 = may be intersecting, 
+//                2 = frustum is inside all planes
 //-----------------------------------------------------------------------------
-INT IntersectFrustumFrustum( const Frustum* pVolumeA, const Frustum* pVolumeB )
+INT IntersectFrustum6Planes( const Frustum* pVolume, FXMVECTOR Plane0, FXMVECTOR Plane1, FXMVECTOR Plane2,
+                             CXMVECTOR Plane3, CXMVECTOR Plane4, CXMVECTOR Plane5 )
 {
-    XMASSERT( pVolumeA );
-    XMASSERT( pVolumeB );
-
-    // Load origin and orientation of frustum B.
-    XMVECTOR OriginB = XMLoadFloat3( &pVolumeB->Origin );
-    XMVECTOR OrientationB = XMLoadFloat4( &pVolumeB->Orientation );
-
-    XMASSERT( XMQuaternionIsUnit( OrientationB ) );
+    XMASSERT( pVolume );
 
-    // Build the planes of frustum B.
-    XMVECTOR AxisB[6];
-    AxisB[0] = XMVectorSet( 0.0f, 0.0f, -1.0f, 0.0f );
-    AxisB[1] = XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f );
-    AxisB[2] = XMVectorSet( 1.0f, 0.0f, -pVolumeB->RightSlope, 0.0f );
-    AxisB[3] = XMVectorSet( -1.0f, 0.0f, pVolumeB->LeftSlope, 0.0f );
-    AxisB[4] = XMVectorSet( 0.0f, 1.0f, -pVolumeB->TopSlope, 0.0f );
-    AxisB[5] = XMVectorSet( 0.0f, -1.0f, pVolumeB->BottomSlope, 0.0f );
+    // Load origin and orientation of the frustum.
+    XMVECTOR Origin = XMLoadFloat3( &pVolume->Origin );
+    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
 
-    XMVECTOR PlaneDistB[6];
-    PlaneDistB[0] = -XMVectorReplicatePtr( &pVolumeB->Near );
-    PlaneDistB[1] = XMVectorReplicatePtr( &pVolumeB->Far );
-    PlaneDistB[2] = XMVectorZero();
-    PlaneDistB[3] = XMVectorZero();
-    PlaneDistB[4] = XMVectorZero();
-    PlaneDistB[5] = XMVectorZero();
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
 
-    // Load origin and orientation of frustum A.
-    XMVECTOR OriginA = XMLoadFloat3( &pVolumeA->Origin );
-    XMVECTOR OrientationA = XMLoadFloat4( &pVolumeA->Orientation );
+    // Set w of the origin to one so we can dot4 with a plane.
+    Origin = XMVectorInsert<0, 0, 0, 0, 1>( Origin, XMVectorSplatOne() );
 
-    XMASSERT( XMQuaternionIsUnit( OrientationA ) );
+    // Build the corners of the frustum (in world space).
+    XMVECTOR RightTop = XMVectorSet( pVolume->RightSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    XMVECTOR RightBottom = XMVectorSet( pVolume->RightSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR LeftTop = XMVectorSet( pVolume->LeftSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    XMVECTOR LeftBottom = XMVectorSet( pVolume->LeftSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR Near = XMVectorSet( pVolume->Near, pVolume->Near, pVolume->Near, 0.0f );
+    XMVECTOR Far = XMVectorSet( pVolume->Far, pVolume->Far, pVolume->Far, 0.0f );
 
-    // Transform frustum A into the space of the frustum B in order to 
-    // minimize the number of transforms we have to do.
-    OriginA = XMVector3InverseRotate( OriginA - OriginB, OrientationB );
-    OrientationA = XMQuaternionMultiply( OrientationA, XMQuaternionConjugate( OrientationB ) );
+    RightTop = XMVector3Rotate( RightTop, Orientation );
+    RightBottom = XMVector3Rotate( RightBottom, Orientation );
+    LeftTop = XMVector3Rotate( LeftTop, Orientation );
+    LeftBottom = XMVector3Rotate( LeftBottom, Orientation );
 
-    // Build the corners of frustum A (in the local space of B).
-    XMVECTOR RightTopA = XMVectorSet( pVolumeA->RightSlope, pVolumeA->TopSlope, 1.0f, 0.0f );
-    XMVECTOR RightBottomA = XMVectorSet( pVolumeA->RightSlope, pVolumeA->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR LeftTopA = XMVectorSet( pVolumeA->LeftSlope, pVolumeA->TopSlope, 1.0f, 0.0f );
-    XMVECTOR LeftBottomA = XMVectorSet( pVolumeA->LeftSlope, pVolumeA->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR NearA = XMVectorReplicatePtr( &pVolumeA->Near );
-    XMVECTOR FarA = XMVectorReplicatePtr( &pVolumeA->Far );
+    XMVECTOR Corners0 = Origin + RightTop * Near;
+    XMVECTOR Corners1 = Origin + RightBottom * Near;
+    XMVECTOR Corners2 = Origin + LeftTop * Near;
+    XMVECTOR Corners3 = Origin + LeftBottom * Near;
+    XMVECTOR Corners4 = Origin + RightTop * Far;
+    XMVECTOR Corners5 = Origin + RightBottom * Far;
+    XMVECTOR Corners6 = Origin + LeftTop * Far;
+    XMVECTOR Corners7 = Origin + LeftBottom * Far;
 
-    RightTopA = XMVector3Rotate( RightTopA, OrientationA );
-    RightBottomA = XMVector3Rotate( RightBottomA, OrientationA );
-    LeftTopA = XMVector3Rotate( LeftTopA, OrientationA );
-    LeftBottomA = XMVector3Rotate( LeftBottomA, OrientationA );
+    XMVECTOR Outside, Inside;
 
-    XMVECTOR CornersA[8];
-    CornersA[0] = OriginA + RightTopA * NearA;
-    CornersA[1] = OriginA + RightBottomA * NearA;
-    CornersA[2] = OriginA + LeftTopA * NearA;
-    CornersA[3] = OriginA + LeftBottomA * NearA;
-    CornersA[4] = OriginA + RightTopA * FarA;
-    CornersA[5] = OriginA + RightBottomA * FarA;
-    CornersA[6] = OriginA + LeftTopA * FarA;
-    CornersA[7] = OriginA + LeftBottomA * FarA;
+    // Test against each plane.
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane0, Outside, Inside );
 
-    // Check frustum A against each plane of frustum B.
-    XMVECTOR Outside = XMVectorFalseInt();
-    XMVECTOR InsideAll = XMVectorTrueInt();
+    XMVECTOR AnyOutside = Outside;
+    XMVECTOR AllInside = Inside;
 
-    for( INT i = 0; i < 6; i++ )
-    {
-        // Find the min/max projection of the frustum onto the plane normal.
-        XMVECTOR Min, Max;
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane1, Outside, Inside );
 
-        Min = Max = XMVector3Dot( AxisB[i], CornersA[0] );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-        for( INT j = 1; j < 8; j++ )
-        {
-            XMVECTOR Temp = XMVector3Dot( AxisB[i], CornersA[j] );
-            Min = XMVectorMin( Min, Temp );
-            Max = XMVectorMax( Max, Temp );
-        }
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane2, Outside, Inside );
 
-        // Outside the plane?
-        Outside = XMVectorOrInt( Outside, XMVectorGreater( Min, PlaneDistB[i] ) );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-        // Fully inside the plane?
-        InsideAll = XMVectorAndInt( InsideAll, XMVectorLessOrEqual( Max, PlaneDistB[i] ) );
-    }
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane3, Outside, Inside );
 
-    // If the frustum A is outside any of the planes of frustum B it is outside. 
-    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
-        return 0;
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    // If frustum A is inside all planes of frustum B it is fully inside.
-    if ( XMVector4EqualInt( InsideAll, XMVectorTrueInt() ) )
-        return 2;
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane4, Outside, Inside );
 
-    // Build the corners of frustum B.
-    XMVECTOR RightTopB = XMVectorSet( pVolumeB->RightSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
-    XMVECTOR RightBottomB = XMVectorSet( pVolumeB->RightSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR LeftTopB = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->TopSlope, 1.0f, 0.0f );
-    XMVECTOR LeftBottomB = XMVectorSet( pVolumeB->LeftSlope, pVolumeB->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR NearB = XMVectorReplicatePtr( &pVolumeB->Near );
-    XMVECTOR FarB = XMVectorReplicatePtr( &pVolumeB->Far );
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    XMVECTOR CornersB[8];
-    CornersB[0] = RightTopB * NearB;
-    CornersB[1] = RightBottomB * NearB;
-    CornersB[2] = LeftTopB * NearB;
-    CornersB[3] = LeftBottomB * NearB;
-    CornersB[4] = RightTopB * FarB;
-    CornersB[5] = RightBottomB * FarB;
-    CornersB[6] = LeftTopB * FarB;
-    CornersB[7] = LeftBottomB * FarB;
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane5, Outside, Inside );
 
-    // Build the planes of frustum A (in the local space of B).
-    XMVECTOR AxisA[6];
-    XMVECTOR PlaneDistA[6];
+    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
+    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    AxisA[0] = XMVectorSet( 0.0f, 0.0f, -1.0f, 0.0f );
-    AxisA[1] = XMVectorSet( 0.0f, 0.0f, 1.0f, 0.0f );
-    AxisA[2] = XMVectorSet( 1.0f, 0.0f, -pVolumeA->RightSlope, 0.0f );
-    AxisA[3] = XMVectorSet( -1.0f, 0.0f, pVolumeA->LeftSlope, 0.0f );
-    AxisA[4] = XMVectorSet( 0.0f, 1.0f, -pVolumeA->TopSlope, 0.0f );
-    AxisA[5] = XMVectorSet( 0.0f, -1.0f, pVolumeA->BottomSlope, 0.0f );
+    // If the frustum is outside any plane it is outside.
+    if ( XMVector4EqualInt( AnyOutside, XMVectorTrueInt() ) )
+        return 0;
 
-    AxisA[0] = XMVector3Rotate( AxisA[0], OrientationA );
-    AxisA[1] = -AxisA[0];
-    AxisA[2] = XMVector3Rotate( AxisA[2], OrientationA );
-    AxisA[3] = XMVector3Rotate( AxisA[3], OrientationA );
-    AxisA[4] = XMVector3Rotate( AxisA[4], OrientationA );
-    AxisA[5] = XMVector3Rotate( AxisA[5], OrientationA );
+    // If the frustum is inside all planes it is inside.
+    if ( XMVector4EqualInt( AllInside, XMVectorTrueInt() ) )
+        return 2;
 
-    PlaneDistA[0] = XMVector3Dot( AxisA[0], CornersA[0] );  // Re-use corner on near plane.
-    PlaneDistA[1] = XMVector3Dot( AxisA[1], CornersA[4] );  // Re-use corner on far plane.
-    PlaneDistA[2] = XMVector3Dot( AxisA[2], OriginA );
-    PlaneDistA[3] = XMVector3Dot( AxisA[3], OriginA );
-    PlaneDistA[4] = XMVector3Dot( AxisA[4], OriginA );
-    PlaneDistA[5] = XMVector3Dot( AxisA[5], OriginA );
+    // The frustum is not inside all planes or outside a plane, it may intersect.
+    return 1;
+}
 
-    // Check each axis of frustum A for a seperating plane (5).
-    for( INT i = 0; i < 6; i++ )
-    {
-        // Find the minimum projection of the frustum onto the plane normal.
-        XMVECTOR Min;
 
-        Min = XMVector3Dot( AxisA[i], CornersB[0] );
 
-        for( INT j = 1; j < 8; j++ )
-        {
-            XMVECTOR Temp = XMVector3Dot( AxisA[i], CornersB[j] );
-            Min = XMVectorMin( Min, Temp );
-        }
+//-----------------------------------------------------------------------------
+INT IntersectTrianglePlane( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, CXMVECTOR Plane )
+{
+    XMVECTOR One = XMVectorSplatOne();
 
-        // Outside the plane?
-        Outside = XMVectorOrInt( Outside, XMVectorGreater( Min, PlaneDistA[i] ) );
-    }
+    XMASSERT( XMPlaneIsUnit( Plane ) );
 
-    // If the frustum B is outside any of the planes of frustum A it is outside. 
+    // Set w of the points to one so we can dot4 with a plane.
+    XMVECTOR TV0 = XMVectorInsert<0, 0, 0, 0, 1>( V0, One );
+    XMVECTOR TV1 = XMVectorInsert<0, 0, 0, 0, 1>( V1, One );
+    XMVECTOR TV2 = XMVectorInsert<0, 0, 0, 0, 1>( V2, One );
+
+    XMVECTOR Outside, Inside;
+    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane, Outside, Inside );
+
+    // If the triangle is outside any plane it is outside.
     if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
         return 0;
 
-    // Check edge/edge axes (6 * 6).
-    XMVECTOR FrustumEdgeAxisA[6];
-    FrustumEdgeAxisA[0] = RightTopA;
-    FrustumEdgeAxisA[1] = RightBottomA;
-    FrustumEdgeAxisA[2] = LeftTopA;
-    FrustumEdgeAxisA[3] = LeftBottomA;
-    FrustumEdgeAxisA[4] = RightTopA - LeftTopA;
-    FrustumEdgeAxisA[5] = LeftBottomA - LeftTopA;
+    // If the triangle is inside all planes it is inside.
+    if ( XMVector4EqualInt( Inside, XMVectorTrueInt() ) )
+        return 2;
 
-    XMVECTOR FrustumEdgeAxisB[6];
-    FrustumEdgeAxisB[0] = RightTopB;
-    FrustumEdgeAxisB[1] = RightBottomB;
-    FrustumEdgeAxisB[2] = LeftTopB;
-    FrustumEdgeAxisB[3] = LeftBottomB;
-    FrustumEdgeAxisB[4] = RightTopB - LeftTopB;
-    FrustumEdgeAxisB[5] = LeftBottomB - LeftTopB;
+    // The triangle is not inside all planes or outside a plane it intersects.
+    return 1;
+}
 
-    for( INT i = 0; i < 6; i++ )
-    {
-        for( INT j = 0; j < 6; j++ )
-        {
-            // Compute the axis we are going to test.
-            XMVECTOR Axis = XMVector3Cross( FrustumEdgeAxisA[i], FrustumEdgeAxisB[j] );
 
-            // Find the min/max values of the projection of both frustums onto the axis.
-            XMVECTOR MinA, MaxA;
-            XMVECTOR MinB, MaxB;
 
-            MinA = MaxA = XMVector3Dot( Axis, CornersA[0] );
-            MinB = MaxB = XMVector3Dot( Axis, CornersB[0] );
+//-----------------------------------------------------------------------------
+INT IntersectSpherePlane( const Sphere* pVolume, FXMVECTOR Plane )
+{
+    XMASSERT( pVolume );
+    XMASSERT( XMPlaneIsUnit( Plane ) );
 
-            for( INT k = 1; k < 8; k++ )
-            {
-                XMVECTOR TempA = XMVector3Dot( Axis, CornersA[k] );
-                MinA = XMVectorMin( MinA, TempA );
-                MaxA = XMVectorMax( MaxA, TempA );
+    // Load the sphere.
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
 
-                XMVECTOR TempB = XMVector3Dot( Axis, CornersB[k] );
-                MinB = XMVectorMin( MinB, TempB );
-                MaxB = XMVectorMax( MaxB, TempB );
-            }
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = XMVectorInsert<0, 0, 0, 0, 1>( Center, XMVectorSplatOne() );
 
-            // if (MinA > MaxB || MinB > MaxA) reject
-            Outside = XMVectorOrInt( Outside, XMVectorGreater( MinA, MaxB ) );
-            Outside = XMVectorOrInt( Outside, XMVectorGreater( MinB, MaxA ) );
-        }
-    }
+    XMVECTOR Outside, Inside;
+    FastIntersectSpherePlane( Center, Radius, Plane, Outside, Inside );
 
-    // If there is a seperating plane, then the frustums do not intersect.
+    // If the sphere is outside any plane it is outside.
     if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
         return 0;
 
-    // If we did not find a separating plane then the frustums intersect.
+    // If the sphere is inside all planes it is inside.
+    if ( XMVector4EqualInt( Inside, XMVectorTrueInt() ) )
+        return 2;
+
+    // The sphere is not inside all planes or outside a plane it intersects.
     return 1;
 }
 
 
 
 //-----------------------------------------------------------------------------
-static inline void FastIntersectTrianglePlane( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, CXMVECTOR Plane,
-                                        XMVECTOR& Outside, XMVECTOR& Inside )
+INT IntersectAxisAlignedBoxPlane( const AxisAlignedBox* pVolume, FXMVECTOR Plane )
 {
-    // Plane0
-    XMVECTOR Dist0 = XMVector4Dot( V0, Plane );
-    XMVECTOR Dist1 = XMVector4Dot( V1, Plane );
-    XMVECTOR Dist2 = XMVector4Dot( V2, Plane );
+    XMASSERT( pVolume );
+    XMASSERT( XMPlaneIsUnit( Plane ) );
 
-    XMVECTOR MinDist = XMVectorMin( Dist0, Dist1 );
-    MinDist = XMVectorMin( MinDist, Dist2 );
+    // Load the box.
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
 
-    XMVECTOR MaxDist = XMVectorMax( Dist0, Dist1 );
-    MaxDist = XMVectorMax( MaxDist, Dist2 );
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = XMVectorInsert<0, 0, 0, 0, 1>( Center, XMVectorSplatOne() );
 
-    XMVECTOR Zero = XMVectorZero();
+    XMVECTOR Outside, Inside;
+    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane, Outside, Inside );
 
-    // Outside the plane?
-    Outside = XMVectorGreater( MinDist, Zero );
+    // If the box is outside any plane it is outside.
+    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+        return 0;
 
-    // Fully inside the plane?
-    Inside = XMVectorLess( MaxDist, Zero );
+    // If the box is inside all planes it is inside.
+    if ( XMVector4EqualInt( Inside, XMVectorTrueInt() ) )
+        return 2;
+
+    // The box is not inside all planes or outside a plane it intersects.
+    return 1;
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Test a triangle vs 6 planes (typically forming a frustum).
-// Return values: 0 = no intersection, 
-//                1 = may be intersecting, 
-//                2 = triangle is inside all planes
-//-----------------------------------------------------------------------------
-INT IntersectTriangle6Planes( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, CXMVECTOR Plane0, CXMVECTOR Plane1,
-                              CXMVECTOR Plane2, CXMVECTOR Plane3, CXMVECTOR Plane4, CXMVECTOR Plane5 )
+INT IntersectOrientedBoxPlane( const OrientedBox* pVolume, FXMVECTOR Plane )
 {
-    XMVECTOR One = XMVectorSplatOne();
+    XMASSERT( pVolume );
+    XMASSERT( XMPlaneIsUnit( Plane ) );
 
-    // Set w of the points to one so we can dot4 with a plane.
-    XMVECTOR TV0 = XMVectorInsert(V0, One, 0, 0, 0, 0, 1);
-    XMVECTOR TV1 = XMVectorInsert(V1, One, 0, 0, 0, 0, 1);
-    XMVECTOR TV2 = XMVectorInsert(V2, One, 0, 0, 0, 0, 1);
+    // Load the box.
+    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
+    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
+    XMVECTOR BoxOrientation = XMLoadFloat4( &pVolume->Orientation );
+
+    XMASSERT( XMQuaternionIsUnit( BoxOrientation ) );
+
+    // Set w of the center to one so we can dot4 with a plane.
+    Center = XMVectorInsert<0, 0, 0, 0, 1>( Center, XMVectorSplatOne() );
+
+    // Build the 3x3 rotation matrix that defines the box axes.
+    XMMATRIX R = XMMatrixRotationQuaternion( BoxOrientation );
 
     XMVECTOR Outside, Inside;
+    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane, Outside, Inside );
 
-    // Test against each plane.
-    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane0, Outside, Inside );
+    // If the box is outside any plane it is outside.
+    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
+        return 0;
 
-    XMVECTOR AnyOutside = Outside;
-    XMVECTOR AllInside = Inside;
+    // If the box is inside all planes it is inside.
+    if ( XMVector4EqualInt( Inside, XMVectorTrueInt() ) )
+        return 2;
 
-    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane1, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    // The box is not inside all planes or outside a plane it intersects.
+    return 1;
+}
 
-    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane2, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane3, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane4, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+//-----------------------------------------------------------------------------
+INT IntersectFrustumPlane( const Frustum* pVolume, FXMVECTOR Plane )
+{
+    XMASSERT( pVolume );
+    XMASSERT( XMPlaneIsUnit( Plane ) );
 
-    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane5, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    // Load origin and orientation of the frustum.
+    XMVECTOR Origin = XMLoadFloat3( &pVolume->Origin );
+    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
 
-    // If the triangle is outside any plane it is outside.
-    if ( XMVector4EqualInt( AnyOutside, XMVectorTrueInt() ) )
+    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+
+    // Set w of the origin to one so we can dot4 with a plane.
+    Origin = XMVectorInsert<0, 0, 0, 0, 1>( Origin, XMVectorSplatOne() );
+
+    // Build the corners of the frustum (in world space).
+    XMVECTOR RightTop = XMVectorSet( pVolume->RightSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    XMVECTOR RightBottom = XMVectorSet( pVolume->RightSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR LeftTop = XMVectorSet( pVolume->LeftSlope, pVolume->TopSlope, 1.0f, 0.0f );
+    XMVECTOR LeftBottom = XMVectorSet( pVolume->LeftSlope, pVolume->BottomSlope, 1.0f, 0.0f );
+    XMVECTOR Near = XMVectorSet( pVolume->Near, pVolume->Near, pVolume->Near, 0.0f );
+    XMVECTOR Far = XMVectorSet( pVolume->Far, pVolume->Far, pVolume->Far, 0.0f );
+
+    RightTop = XMVector3Rotate( RightTop, Orientation );
+    RightBottom = XMVector3Rotate( RightBottom, Orientation );
+    LeftTop = XMVector3Rotate( LeftTop, Orientation );
+    LeftBottom = XMVector3Rotate( LeftBottom, Orientation );
+
+    XMVECTOR Corners0 = Origin + RightTop * Near;
+    XMVECTOR Corners1 = Origin + RightBottom * Near;
+    XMVECTOR Corners2 = Origin + LeftTop * Near;
+    XMVECTOR Corners3 = Origin + LeftBottom * Near;
+    XMVECTOR Corners4 = Origin + RightTop * Far;
+    XMVECTOR Corners5 = Origin + RightBottom * Far;
+    XMVECTOR Corners6 = Origin + LeftTop * Far;
+    XMVECTOR Corners7 = Origin + LeftBottom * Far;
+
+    XMVECTOR Outside, Inside;
+    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
+                               Corners4, Corners5, Corners6, Corners7, 
+                               Plane, Outside, Inside );
+
+    // If the frustum is outside any plane it is outside.
+    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
         return 0;
 
-    // If the triangle is inside all planes it is inside.
-    if ( XMVector4EqualInt( AllInside, XMVectorTrueInt() ) )
+    // If the frustum is inside all planes it is inside.
+    if ( XMVector4EqualInt( Inside, XMVectorTrueInt() ) )
         return 2;
 
-    // The triangle is not inside all planes or outside a plane, it may intersect.
+    // The frustum is not inside all planes or outside a plane it intersects.
     return 1;
 }
 
 
 
 //-----------------------------------------------------------------------------
-static inline void FastIntersectSpherePlane( FXMVECTOR Center, FXMVECTOR Radius, FXMVECTOR Plane,
-                                      XMVECTOR& Outside, XMVECTOR& Inside )
+// Ray packets. The kernels below work on structure of arrays data: each
+// argument is an array of three vectors holding the x, y and z of four
+// lanes, so one call tests four ray/primitive combinations at once. The
+// single ray/primitive side of a test is splatted across the lanes.
+//-----------------------------------------------------------------------------
+static const XMVECTORU32 g_LaneMasks[16] =
 {
-    XMVECTOR Dist = XMVector4Dot( Center, Plane );
+    { XM_SELECT_0, XM_SELECT_0, XM_SELECT_0, XM_SELECT_0 },
+    { XM_SELECT_1, XM_SELECT_0, XM_SELECT_0, XM_SELECT_0 },
+    { XM_SELECT_0, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0 },
+    { XM_SELECT_1, XM_SELECT_1, XM_SELECT_0, XM_SELECT_0 },
+    { XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0 },
+    { XM_SELECT_1, XM_SELECT_0, XM_SELECT_1, XM_SELECT_0 },
+    { XM_SELECT_0, XM_SELECT_1, XM_SELECT_1, XM_SELECT_0 },
+    { XM_SELECT_1, XM_SELECT_1, XM_SELECT_1, XM_SELECT_0 },
+    { XM_SELECT_0, XM_SELECT_0, XM_SELECT_0, XM_SELECT_1 },
+    { XM_SELECT_1, XM_SELECT_0, XM_SELECT_0, XM_SELECT_1 },
+    { XM_SELECT_0, XM_SELECT_1, XM_SELECT_0, XM_SELECT_1 },
+    { XM_SELECT_1, XM_SELECT_1, XM_SELECT_0, XM_SELECT_1 },
+    { XM_SELECT_0, XM_SELECT_0, XM_SELECT_1, XM_SELECT_1 },
+    { XM_SELECT_1, XM_SELECT_0, XM_SELECT_1, XM_SELECT_1 },
+    { XM_SELECT_0, XM_SELECT_1, XM_SELECT_1, XM_SELECT_1 },
+    { XM_SELECT_1, XM_SELECT_1, XM_SELECT_1, XM_SELECT_1 },
+};
 
-    // Outside the plane?
-    Outside = XMVectorGreater( Dist, Radius );
 
-    // Fully inside the plane?
-    Inside = XMVectorLess( Dist, -Radius );
+
+//-----------------------------------------------------------------------------
+// Convert between a 4-bit lane mask and a vector control mask.
+//-----------------------------------------------------------------------------
+static inline XMVECTOR LaneMaskToControl( UINT Mask )
+{
+    return g_LaneMasks[Mask & 15];
+}
+
+
+
+static inline UINT ControlToLaneMask( FXMVECTOR Control )
+{
+#if defined(_XM_SSE_INTRINSICS_) && !defined(_XM_NO_INTRINSICS_)
+    return UINT( _mm_movemask_ps( Control ) );
+#else
+    return ( XMVectorGetIntX( Control ) & 1 ) | ( ( XMVectorGetIntY( Control ) & 1 ) << 1 ) |
+           ( ( XMVectorGetIntZ( Control ) & 1 ) << 2 ) | ( ( XMVectorGetIntW( Control ) & 1 ) << 3 );
+#endif
+}
+
+
+
+//-----------------------------------------------------------------------------
+static inline VOID SplatVector3( XMVECTOR* pOut, FXMVECTOR V )
+{
+    pOut[0] = XMVectorSplatX( V );
+    pOut[1] = XMVectorSplatY( V );
+    pOut[2] = XMVectorSplatZ( V );
+}
+
+
+
+static inline XMVECTOR Dot3SoA( const XMVECTOR* A, const XMVECTOR* B )
+{
+    return A[0] * B[0] + A[1] * B[1] + A[2] * B[2];
 }
 
 
 
-//-----------------------------------------------------------------------------
-// Test a sphere vs 6 planes (typically forming a frustum).
-// Return values: 0 = no intersection, 
-//                1 = may be intersecting, 
-//                2 = sphere is inside all planes
-//-----------------------------------------------------------------------------
-INT IntersectSphere6Planes( const Sphere* pVolume, FXMVECTOR Plane0, FXMVECTOR Plane1, FXMVECTOR Plane2,
-                            CXMVECTOR Plane3, CXMVECTOR Plane4, CXMVECTOR Plane5 )
+static inline VOID Cross3SoA( XMVECTOR* pOut, const XMVECTOR* A, const XMVECTOR* B )
 {
-    XMASSERT( pVolume );
-
-    // Load the sphere.
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
+    pOut[0] = A[1] * B[2] - A[2] * B[1];
+    pOut[1] = A[2] * B[0] - A[0] * B[2];
+    pOut[2] = A[0] * B[1] - A[1] * B[0];
+}
 
-    // Set w of the center to one so we can dot4 with a plane.
-    Center = XMVectorInsert( Center, XMVectorSplatOne(), 0, 0, 0, 0, 1);
 
-    XMVECTOR Outside, Inside;
 
-    // Test against each plane.
-    FastIntersectSpherePlane( Center, Radius, Plane0, Outside, Inside );
+//-----------------------------------------------------------------------------
+// Four lanes of IntersectRayTriangle. Returns the control mask of the lanes
+// that hit, *pDist receives the distance of every lane.
+//-----------------------------------------------------------------------------
+static inline XMVECTOR IntersectRayTriangleSoA( const XMVECTOR* Origin, const XMVECTOR* Direction, const XMVECTOR* V0,
+                                                const XMVECTOR* V1, const XMVECTOR* V2, XMVECTOR* pDist )
+{
+    static const XMVECTOR Epsilon =
+    {
+        1e-20f, 1e-20f, 1e-20f, 1e-20f
+    };
 
-    XMVECTOR AnyOutside = Outside;
-    XMVECTOR AllInside = Inside;
+    XMVECTOR Zero = XMVectorZero();
 
-    FastIntersectSpherePlane( Center, Radius, Plane1, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    XMVECTOR e1[3], e2[3], s[3], p[3], q[3];
+    for( INT i = 0; i < 3; i++ )
+    {
+        e1[i] = V1[i] - V0[i];
+        e2[i] = V2[i] - V0[i];
+        s[i] = Origin[i] - V0[i];
+    }
 
-    FastIntersectSpherePlane( Center, Radius, Plane2, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    Cross3SoA( p, Direction, e2 );
+    XMVECTOR det = Dot3SoA( e1, p );
 
-    FastIntersectSpherePlane( Center, Radius, Plane3, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    XMVECTOR u = Dot3SoA( s, p );
+    Cross3SoA( q, s, e1 );
+    XMVECTOR v = Dot3SoA( Direction, q );
+    XMVECTOR t = Dot3SoA( e2, q );
+    XMVECTOR uv = u + v;
 
-    FastIntersectSpherePlane( Center, Radius, Plane4, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    // Front side (det >= Epsilon): 0 <= u <= det, v >= 0, u + v <= det, t >= 0.
+    XMVECTOR Front = XMVectorGreaterOrEqual( det, Epsilon );
+    XMVECTOR FrontMiss = XMVectorOrInt( XMVectorLess( u, Zero ), XMVectorGreater( u, det ) );
+    FrontMiss = XMVectorOrInt( FrontMiss, XMVectorLess( v, Zero ) );
+    FrontMiss = XMVectorOrInt( FrontMiss, XMVectorGreater( uv, det ) );
+    FrontMiss = XMVectorOrInt( FrontMiss, XMVectorLess( t, Zero ) );
 
-    FastIntersectSpherePlane( Center, Radius, Plane5, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    // Back side (det <= -Epsilon): the same with all the comparisons reversed.
+    XMVECTOR Back = XMVectorLessOrEqual( det, -Epsilon );
+    XMVECTOR BackMiss = XMVectorOrInt( XMVectorGreater( u, Zero ), XMVectorLess( u, det ) );
+    BackMiss = XMVectorOrInt( BackMiss, XMVectorGreater( v, Zero ) );
+    BackMiss = XMVectorOrInt( BackMiss, XMVectorLess( uv, det ) );
+    BackMiss = XMVectorOrInt( BackMiss, XMVectorGreater( t, Zero ) );
 
-    // If the sphere is outside any plane it is outside.
-    if ( XMVector4EqualInt( AnyOutside, XMVectorTrueInt() ) )
-        return 0;
+    // Lanes with a parallel ray are neither front nor back.
+    XMVECTOR Hit = XMVectorOrInt( XMVectorAndCInt( Front, FrontMiss ), XMVectorAndCInt( Back, BackMiss ) );
 
-    // If the sphere is inside all planes it is inside.
-    if ( XMVector4EqualInt( AllInside, XMVectorTrueInt() ) )
-        return 2;
+    *pDist = t * XMVectorReciprocal( det );
 
-    // The sphere is not inside all planes or outside a plane, it may intersect.
-    return 1;
+    return Hit;
 }
 
 
 
 //-----------------------------------------------------------------------------
-static inline void FastIntersectAxisAlignedBoxPlane( FXMVECTOR Center, FXMVECTOR Extents, FXMVECTOR Plane,
-                                              XMVECTOR& Outside, XMVECTOR& Inside )
+// Four lanes of IntersectRaySphere.
+//-----------------------------------------------------------------------------
+static inline XMVECTOR IntersectRaySphereSoA( const XMVECTOR* Origin, const XMVECTOR* Direction, const XMVECTOR* Center,
+                                              FXMVECTOR Radius, XMVECTOR* pDist )
 {
-    // Compute the distance to the center of the box.
-    XMVECTOR Dist = XMVector4Dot( Center, Plane );
+    // l is the vector from the ray origin to the center of the sphere.
+    XMVECTOR l[3];
+    for( INT i = 0; i < 3; i++ )
+        l[i] = Center[i] - Origin[i];
 
-    // Project the axes of the box onto the normal of the plane.  Half the
-    // length of the projection (sometime called the "radius") is equal to
-    // h(u) * abs(n dot b(u))) + h(v) * abs(n dot b(v)) + h(w) * abs(n dot b(w))
-    // where h(i) are extents of the box, n is the plane normal, and b(i) are the 
-    // axes of the box. In this case b(i) = [(1,0,0), (0,1,0), (0,0,1)].
-    XMVECTOR Radius = XMVector3Dot( Extents, XMVectorAbs( Plane ) );
+    // s is the projection of the l onto the ray direction.
+    XMVECTOR s = Dot3SoA( l, Direction );
+    XMVECTOR l2 = Dot3SoA( l, l );
+    XMVECTOR r2 = Radius * Radius;
 
-    // Outside the plane?
-    Outside = XMVectorGreater( Dist, Radius );
+    // m2 is squared distance from the center of the sphere to the projection.
+    XMVECTOR m2 = l2 - s * s;
 
-    // Fully inside the plane?
-    Inside = XMVectorLess( Dist, -Radius );
+    XMVECTOR NoIntersection = XMVectorAndInt( XMVectorLess( s, XMVectorZero() ), XMVectorGreater( l2, r2 ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( m2, r2 ) );
+
+    // Clamp so that the lanes that miss do not produce NaNs.
+    XMVECTOR q = XMVectorSqrt( XMVectorMax( r2 - m2, XMVectorZero() ) );
+
+    XMVECTOR OriginInside = XMVectorLessOrEqual( l2, r2 );
+    *pDist = XMVectorSelect( s - q, s + q, OriginInside );
+
+    return XMVectorNotEqualInt( NoIntersection, XMVectorTrueInt() );
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Test an axis alinged box vs 6 planes (typically forming a frustum).
-// Return values: 0 = no intersection, 
-//                1 = may be intersecting, 
-//                2 = box is inside all planes
+// Four lanes of IntersectRayAxisAlignedBox (slabs method).
 //-----------------------------------------------------------------------------
-INT IntersectAxisAlignedBox6Planes( const AxisAlignedBox* pVolume, FXMVECTOR Plane0, FXMVECTOR Plane1,
-                                    FXMVECTOR Plane2, CXMVECTOR Plane3, CXMVECTOR Plane4, CXMVECTOR Plane5 )
+static inline XMVECTOR IntersectRayAxisAlignedBoxSoA( const XMVECTOR* Origin, const XMVECTOR* Direction,
+                                                      const XMVECTOR* Center, const XMVECTOR* Extents, XMVECTOR* pDist )
 {
-    XMASSERT( pVolume );
-
-    // Load the box.
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
-
-    // Set w of the center to one so we can dot4 with a plane.
-    Center = XMVectorInsert( Center, XMVectorSplatOne(), 0, 0, 0, 0, 1 );
-
-    XMVECTOR Outside, Inside;
-
-    // Test against each plane.
-    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane0, Outside, Inside );
+    static const XMVECTOR Epsilon =
+    {
+        1e-20f, 1e-20f, 1e-20f, 1e-20f
+    };
+    static const XMVECTOR FltMin =
+    {
+        -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX
+    };
+    static const XMVECTOR FltMax =
+    {
+        FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX
+    };
 
-    XMVECTOR AnyOutside = Outside;
-    XMVECTOR AllInside = Inside;
+    XMVECTOR t_min = FltMin;
+    XMVECTOR t_max = FltMax;
+    XMVECTOR NoIntersection = XMVectorFalseInt();
 
-    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane1, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    for( INT i = 0; i < 3; i++ )
+    {
+        // Ray origin relative to the center of the box.
+        XMVECTOR TOrigin = Center[i] - Origin[i];
 
-    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane2, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+        XMVECTOR IsParallel = XMVectorLessOrEqual( XMVectorAbs( Direction[i] ), Epsilon );
 
-    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane3, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+        XMVECTOR InverseDirection = XMVectorReciprocal( Direction[i] );
+        XMVECTOR t1 = ( TOrigin - Extents[i] ) * InverseDirection;
+        XMVECTOR t2 = ( TOrigin + Extents[i] ) * InverseDirection;
 
-    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane4, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+        t_min = XMVectorMax( t_min, XMVectorSelect( XMVectorMin( t1, t2 ), FltMin, IsParallel ) );
+        t_max = XMVectorMin( t_max, XMVectorSelect( XMVectorMax( t1, t2 ), FltMax, IsParallel ) );
 
-    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane5, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+        // A ray parallel to the slab misses if its origin is outside the slab.
+        XMVECTOR ParallelOverlap = XMVectorInBounds( TOrigin, Extents[i] );
+        NoIntersection = XMVectorOrInt( NoIntersection, XMVectorAndCInt( IsParallel, ParallelOverlap ) );
+    }
 
-    // If the box is outside any plane it is outside.
-    if ( XMVector4EqualInt( AnyOutside, XMVectorTrueInt() ) )
-        return 0;
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorGreater( t_min, t_max ) );
+    NoIntersection = XMVectorOrInt( NoIntersection, XMVectorLess( t_max, XMVectorZero() ) );
 
-    // If the box is inside all planes it is inside.
-    if ( XMVector4EqualInt( AllInside, XMVectorTrueInt() ) )
-        return 2;
+    *pDist = t_min;
 
-    // The box is not inside all planes or outside a plane, it may intersect.
-    return 1;
+    return XMVectorNotEqualInt( NoIntersection, XMVectorTrueInt() );
 }
 
 
 
 //-----------------------------------------------------------------------------
-static inline void FastIntersectOrientedBoxPlane( FXMVECTOR Center, FXMVECTOR Extents, FXMVECTOR Axis0, CXMVECTOR Axis1,
-                                          CXMVECTOR Axis2, CXMVECTOR Plane, XMVECTOR& Outside, XMVECTOR& Inside )
+// Keep the distance of the active lanes that hit and return their lane mask.
+//-----------------------------------------------------------------------------
+static inline UINT ResolvePacketHits( FXMVECTOR Hit, UINT ActiveMask, FXMVECTOR t, XMVECTOR* pDist )
 {
-    // Compute the distance to the center of the box.
-    XMVECTOR Dist = XMVector4Dot( Center, Plane );
+    XMVECTOR Mask = XMVectorAndInt( Hit, LaneMaskToControl( ActiveMask ) );
 
-    // Project the axes of the box onto the normal of the plane.  Half the
-    // length of the projection (sometime called the "radius") is equal to
-    // h(u) * abs(n dot b(u))) + h(v) * abs(n dot b(v)) + h(w) * abs(n dot b(w))
-    // where h(i) are extents of the box, n is the plane normal, and b(i) are the 
-    // axes of the box.
-    XMVECTOR Radius = XMVector3Dot( Plane, Axis0 );
-    Radius = XMVectorInsert( Radius, XMVector3Dot( Plane, Axis1 ), 0, 0, 1, 0, 0 );
-    Radius = XMVectorInsert( Radius, XMVector3Dot( Plane, Axis2 ), 0, 0, 0, 1, 0 );
-    Radius = XMVector3Dot( Extents, XMVectorAbs( Radius ) );
-
-    // Outside the plane?
-    Outside = XMVectorGreater( Dist, Radius );
+    *pDist = XMVectorSelect( *pDist, t, Mask );
 
-    // Fully inside the plane?
-    Inside = XMVectorLess( Dist, -Radius );
+    return ControlToLaneMask( Mask );
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Test an oriented box vs 6 planes (typically forming a frustum).
-// Return values: 0 = no intersection, 
-//                1 = may be intersecting, 
-//                2 = box is inside all planes
+// Gather component Axis of Count structures, Stride bytes apart, into the lanes
+// of a vector. Missing lanes repeat the first element.
 //-----------------------------------------------------------------------------
-INT IntersectOrientedBox6Planes( const OrientedBox* pVolume, FXMVECTOR Plane0, FXMVECTOR Plane1, FXMVECTOR Plane2,
-                                 CXMVECTOR Plane3, CXMVECTOR Plane4, CXMVECTOR Plane5 )
+static inline XMVECTOR GatherLanes( UINT Count, const FLOAT* pFirst, UINT Stride )
 {
-    XMASSERT( pVolume );
+    XMASSERT( Count >= 1 && Count <= 4 );
 
-    // Load the box.
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
-    XMVECTOR BoxOrientation = XMLoadFloat4( &pVolume->Orientation );
+    FLOAT Lanes[4];
+    for( UINT i = 0; i < 4; i++ )
+    {
+        UINT Source = ( i < Count ) ? i : 0;
+        Lanes[i] = *( const FLOAT* )( ( const BYTE* )pFirst + Source * Stride );
+    }
 
-    XMASSERT( XMQuaternionIsUnit( BoxOrientation ) );
+    return XMVectorSet( Lanes[0], Lanes[1], Lanes[2], Lanes[3] );
+}
 
-    // Set w of the center to one so we can dot4 with a plane.
-    Center = XMVectorInsert( Center, XMVectorSplatOne(), 0, 0, 0, 0, 1 );
 
-    // Build the 3x3 rotation matrix that defines the box axes.
-    XMMATRIX R = XMMatrixRotationQuaternion( BoxOrientation );
 
-    XMVECTOR Outside, Inside;
+//-----------------------------------------------------------------------------
+VOID LoadRayPacket( RayPacket4* pOut, UINT Count, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections )
+{
+    XMASSERT( pOut );
+    XMASSERT( pOrigins );
+    XMASSERT( pDirections );
 
-    // Test against each plane.
-    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane0, Outside, Inside );
+    for( UINT i = 0; i < 3; i++ )
+    {
+        pOut->Origin[i] = GatherLanes( Count, &pOrigins->x + i, sizeof( XMFLOAT3 ) );
+        pOut->Direction[i] = GatherLanes( Count, &pDirections->x + i, sizeof( XMFLOAT3 ) );
+    }
+}
 
-    XMVECTOR AnyOutside = Outside;
-    XMVECTOR AllInside = Inside;
 
-    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane1, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane2, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+VOID LoadRayPacket( RayPacket8* pOut, UINT Count, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections )
+{
+    XMASSERT( pOut );
+    XMASSERT( Count >= 1 && Count <= 8 );
 
-    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane3, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    LoadRayPacket( &pOut->Packet[0], ( Count < 4 ) ? Count : 4, pOrigins, pDirections );
 
-    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane4, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    if( Count > 4 )
+        LoadRayPacket( &pOut->Packet[1], Count - 4, pOrigins + 4, pDirections + 4 );
+    else
+        pOut->Packet[1] = pOut->Packet[0];
+}
 
-    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane5, Outside, Inside );
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    // If the box is outside any plane it is outside.
-    if ( XMVector4EqualInt( AnyOutside, XMVectorTrueInt() ) )
-        return 0;
 
-    // If the box is inside all planes it is inside.
-    if ( XMVector4EqualInt( AllInside, XMVectorTrueInt() ) )
-        return 2;
+//-----------------------------------------------------------------------------
+VOID LoadSpherePacket( SpherePacket4* pOut, UINT Count, const Sphere* pSpheres )
+{
+    XMASSERT( pOut );
+    XMASSERT( pSpheres );
 
-    // The box is not inside all planes or outside a plane, it may intersect.
-    return 1;
+    for( UINT i = 0; i < 3; i++ )
+        pOut->Center[i] = GatherLanes( Count, &pSpheres->Center.x + i, sizeof( Sphere ) );
+
+    pOut->Radius = GatherLanes( Count, &pSpheres->Radius, sizeof( Sphere ) );
 }
 
 
 
-//-----------------------------------------------------------------------------
-static inline void FastIntersectFrustumPlane( FXMVECTOR Point0, FXMVECTOR Point1, FXMVECTOR Point2, CXMVECTOR Point3,
-                                      CXMVECTOR Point4, CXMVECTOR Point5, CXMVECTOR Point6, CXMVECTOR Point7,
-                                      CXMVECTOR Plane, XMVECTOR& Outside, XMVECTOR& Inside )
+VOID LoadSpherePacket( SpherePacket8* pOut, UINT Count, const Sphere* pSpheres )
 {
-    // Find the min/max projection of the frustum onto the plane normal.
-    XMVECTOR Min, Max, Dist;
+    XMASSERT( pOut );
+    XMASSERT( Count >= 1 && Count <= 8 );
 
-    Min = Max = XMVector3Dot( Plane, Point0 );
+    LoadSpherePacket( &pOut->Packet[0], ( Count < 4 ) ? Count : 4, pSpheres );
 
-    Dist = XMVector3Dot( Plane, Point1 );
-    Min = XMVectorMin( Min, Dist );
-    Max = XMVectorMax( Max, Dist );
+    if( Count > 4 )
+        LoadSpherePacket( &pOut->Packet[1], Count - 4, pSpheres + 4 );
+    else
+        pOut->Packet[1] = pOut->Packet[0];
+}
 
-    Dist = XMVector3Dot( Plane, Point2 );
-    Min = XMVectorMin( Min, Dist );
-    Max = XMVectorMax( Max, Dist );
 
-    Dist = XMVector3Dot( Plane, Point3 );
-    Min = XMVectorMin( Min, Dist );
-    Max = XMVectorMax( Max, Dist );
 
-    Dist = XMVector3Dot( Plane, Point4 );
-    Min = XMVectorMin( Min, Dist );
-    Max = XMVectorMax( Max, Dist );
+//-----------------------------------------------------------------------------
+VOID LoadAxisAlignedBoxPacket( AxisAlignedBoxPacket4* pOut, UINT Count, const AxisAlignedBox* pBoxes )
+{
+    XMASSERT( pOut );
+    XMASSERT( pBoxes );
 
-    Dist = XMVector3Dot( Plane, Point5 );
-    Min = XMVectorMin( Min, Dist );
-    Max = XMVectorMax( Max, Dist );
+    for( UINT i = 0; i < 3; i++ )
+    {
+        pOut->Center[i] = GatherLanes( Count, &pBoxes->Center.x + i, sizeof( AxisAlignedBox ) );
+        pOut->Extents[i] = GatherLanes( Count, &pBoxes->Extents.x + i, sizeof( AxisAlignedBox ) );
+    }
+}
 
-    Dist = XMVector3Dot( Plane, Point6 );
-    Min = XMVectorMin( Min, Dist );
-    Max = XMVectorMax( Max, Dist );
 
-    Dist = XMVector3Dot( Plane, Point7 );
-    Min = XMVectorMin( Min, Dist );
-    Max = XMVectorMax( Max, Dist );
 
-    XMVECTOR PlaneDist = -XMVectorSplatW( Plane );
+VOID LoadAxisAlignedBoxPacket( AxisAlignedBoxPacket8* pOut, UINT Count, const AxisAlignedBox* pBoxes )
+{
+    XMASSERT( pOut );
+    XMASSERT( Count >= 1 && Count <= 8 );
 
-    // Outside the plane?
-    Outside = XMVectorGreater( Min, PlaneDist );
+    LoadAxisAlignedBoxPacket( &pOut->Packet[0], ( Count < 4 ) ? Count : 4, pBoxes );
 
-    // Fully inside the plane?
-    Inside = XMVectorLess( Max, PlaneDist );
+    if( Count > 4 )
+        LoadAxisAlignedBoxPacket( &pOut->Packet[1], Count - 4, pBoxes + 4 );
+    else
+        pOut->Packet[1] = pOut->Packet[0];
 }
 
 
 
 //-----------------------------------------------------------------------------
-// Test a frustum vs 6 planes (typically forming another frustum).
-// Return values: 0 = no intersection, 
-//                1 = may be intersecting, 
-//                2 = frustum is inside all planes
-//-----------------------------------------------------------------------------
-INT IntersectFrustum6Planes( const Frustum* pVolume, FXMVECTOR Plane0, FXMVECTOR Plane1, FXMVECTOR Plane2,
-                             CXMVECTOR Plane3, CXMVECTOR Plane4, CXMVECTOR Plane5 )
+VOID LoadTrianglePacket( TrianglePacket4* pOut, UINT Count, const XMFLOAT3* pTriangles )
 {
-    XMASSERT( pVolume );
+    XMASSERT( pOut );
+    XMASSERT( pTriangles );
 
-    // Load origin and orientation of the frustum.
-    XMVECTOR Origin = XMLoadFloat3( &pVolume->Origin );
-    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
+    const UINT Stride = 3 * sizeof( XMFLOAT3 );
 
-    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+    for( UINT i = 0; i < 3; i++ )
+    {
+        pOut->V0[i] = GatherLanes( Count, &pTriangles[0].x + i, Stride );
+        pOut->V1[i] = GatherLanes( Count, &pTriangles[1].x + i, Stride );
+        pOut->V2[i] = GatherLanes( Count, &pTriangles[2].x + i, Stride );
+    }
+}
 
-    // Set w of the origin to one so we can dot4 with a plane.
-    Origin = XMVectorInsert( Origin, XMVectorSplatOne(), 0, 0, 0, 0, 1 );
 
-    // Build the corners of the frustum (in world space).
-    XMVECTOR RightTop = XMVectorSet( pVolume->RightSlope, pVolume->TopSlope, 1.0f, 0.0f );
-    XMVECTOR RightBottom = XMVectorSet( pVolume->RightSlope, pVolume->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR LeftTop = XMVectorSet( pVolume->LeftSlope, pVolume->TopSlope, 1.0f, 0.0f );
-    XMVECTOR LeftBottom = XMVectorSet( pVolume->LeftSlope, pVolume->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR Near = XMVectorSet( pVolume->Near, pVolume->Near, pVolume->Near, 0.0f );
-    XMVECTOR Far = XMVectorSet( pVolume->Far, pVolume->Far, pVolume->Far, 0.0f );
 
-    RightTop = XMVector3Rotate( RightTop, Orientation );
-    RightBottom = XMVector3Rotate( RightBottom, Orientation );
-    LeftTop = XMVector3Rotate( LeftTop, Orientation );
-    LeftBottom = XMVector3Rotate( LeftBottom, Orientation );
+VOID LoadTrianglePacket( TrianglePacket8* pOut, UINT Count, const XMFLOAT3* pTriangles )
+{
+    XMASSERT( pOut );
+    XMASSERT( Count >= 1 && Count <= 8 );
 
-    XMVECTOR Corners0 = Origin + RightTop * Near;
-    XMVECTOR Corners1 = Origin + RightBottom * Near;
-    XMVECTOR Corners2 = Origin + LeftTop * Near;
-    XMVECTOR Corners3 = Origin + LeftBottom * Near;
-    XMVECTOR Corners4 = Origin + RightTop * Far;
-    XMVECTOR Corners5 = Origin + RightBottom * Far;
-    XMVECTOR Corners6 = Origin + LeftTop * Far;
-    XMVECTOR Corners7 = Origin + LeftBottom * Far;
+    LoadTrianglePacket( &pOut->Packet[0], ( Count < 4 ) ? Count : 4, pTriangles );
 
-    XMVECTOR Outside, Inside;
+    if( Count > 4 )
+        LoadTrianglePacket( &pOut->Packet[1], Count - 4, pTriangles + 12 );
+    else
+        pOut->Packet[1] = pOut->Packet[0];
+}
 
-    // Test against each plane.
-    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
-                               Corners4, Corners5, Corners6, Corners7, 
-                               Plane0, Outside, Inside );
 
-    XMVECTOR AnyOutside = Outside;
-    XMVECTOR AllInside = Inside;
 
-    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
-                               Corners4, Corners5, Corners6, Corners7, 
-                               Plane1, Outside, Inside );
+//-----------------------------------------------------------------------------
+// Several rays against one primitive.
+//-----------------------------------------------------------------------------
+UINT IntersectRayPacketTriangle( const RayPacket4* pRays, UINT ActiveMask, FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2,
+                                 XMVECTOR* pDist )
+{
+    XMASSERT( pRays );
+    XMASSERT( pDist );
 
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    XMVECTOR A[3], B[3], C[3];
+    SplatVector3( A, V0 );
+    SplatVector3( B, V1 );
+    SplatVector3( C, V2 );
 
-    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
-                               Corners4, Corners5, Corners6, Corners7, 
-                               Plane2, Outside, Inside );
+    XMVECTOR t;
+    XMVECTOR Hit = IntersectRayTriangleSoA( pRays->Origin, pRays->Direction, A, B, C, &t );
 
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    return ResolvePacketHits( Hit, ActiveMask, t, pDist );
+}
 
-    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
-                               Corners4, Corners5, Corners6, Corners7, 
-                               Plane3, Outside, Inside );
 
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
 
-    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
-                               Corners4, Corners5, Corners6, Corners7, 
-                               Plane4, Outside, Inside );
+UINT IntersectRayPacketTriangle( const RayPacket8* pRays, UINT ActiveMask, FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2,
+                                 XMVECTOR* pDist )
+{
+    XMASSERT( pRays );
+    XMASSERT( pDist );
 
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    XMVECTOR A[3], B[3], C[3];
+    SplatVector3( A, V0 );
+    SplatVector3( B, V1 );
+    SplatVector3( C, V2 );
 
-    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
-                               Corners4, Corners5, Corners6, Corners7, 
-                               Plane5, Outside, Inside );
+    UINT Result = 0;
+    for( UINT h = 0; h < 2; h++ )
+    {
+        XMVECTOR t;
+        XMVECTOR Hit = IntersectRayTriangleSoA( pRays->Packet[h].Origin, pRays->Packet[h].Direction, A, B, C, &t );
+        Result |= ResolvePacketHits( Hit, ActiveMask >> ( 4 * h ), t, &pDist[h] ) << ( 4 * h );
+    }
 
-    AnyOutside = XMVectorOrInt( AnyOutside, Outside );
-    AllInside = XMVectorAndInt( AllInside, Inside );
+    return Result;
+}
 
-    // If the frustum is outside any plane it is outside.
-    if ( XMVector4EqualInt( AnyOutside, XMVectorTrueInt() ) )
-        return 0;
 
-    // If the frustum is inside all planes it is inside.
-    if ( XMVector4EqualInt( AllInside, XMVectorTrueInt() ) )
-        return 2;
 
-    // The frustum is not inside all planes or outside a plane, it may intersect.
-    return 1;
-}
+UINT IntersectRayPacketSphere( const RayPacket4* pRays, UINT ActiveMask, const Sphere* pVolume, XMVECTOR* pDist )
+{
+    XMASSERT( pRays );
+    XMASSERT( pVolume );
+    XMASSERT( pDist );
 
+    XMVECTOR Center[3];
+    SplatVector3( Center, XMLoadFloat3( &pVolume->Center ) );
+    XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
 
+    XMVECTOR t;
+    XMVECTOR Hit = IntersectRaySphereSoA( pRays->Origin, pRays->Direction, Center, Radius, &t );
 
-//-----------------------------------------------------------------------------
-INT IntersectTrianglePlane( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, CXMVECTOR Plane )
-{
-    XMVECTOR One = XMVectorSplatOne();
+    return ResolvePacketHits( Hit, ActiveMask, t, pDist );
+}
 
-    XMASSERT( XMPlaneIsUnit( Plane ) );
 
-    // Set w of the points to one so we can dot4 with a plane.
-    XMVECTOR TV0 = XMVectorInsert(V0, One, 0, 0, 0, 0, 1);
-    XMVECTOR TV1 = XMVectorInsert(V1, One, 0, 0, 0, 0, 1);
-    XMVECTOR TV2 = XMVectorInsert(V2, One, 0, 0, 0, 0, 1);
 
-    XMVECTOR Outside, Inside;
-    FastIntersectTrianglePlane( TV0, TV1, TV2, Plane, Outside, Inside );
+UINT IntersectRayPacketSphere( const RayPacket8* pRays, UINT ActiveMask, const Sphere* pVolume, XMVECTOR* pDist )
+{
+    XMASSERT( pRays );
+    XMASSERT( pVolume );
+    XMASSERT( pDist );
 
-    // If the triangle is outside any plane it is outside.
-    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
-        return 0;
+    XMVECTOR Center[3];
+    SplatVector3( Center, XMLoadFloat3( &pVolume->Center ) );
+    XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
 
-    // If the triangle is inside all planes it is inside.
-    if ( XMVector4EqualInt( Inside, XMVectorTrueInt() ) )
-        return 2;
+    UINT Result = 0;
+    for( UINT h = 0; h < 2; h++ )
+    {
+        XMVECTOR t;
+        XMVECTOR Hit = IntersectRaySphereSoA( pRays->Packet[h].Origin, pRays->Packet[h].Direction, Center, Radius, &t );
+        Result |= ResolvePacketHits( Hit, ActiveMask >> ( 4 * h ), t, &pDist[h] ) << ( 4 * h );
+    }
 
-    // The triangle is not inside all planes or outside a plane it intersects.
-    return 1;
+    return Result;
 }
 
 
 
-//-----------------------------------------------------------------------------
-INT IntersectSpherePlane( const Sphere* pVolume, FXMVECTOR Plane )
+UINT IntersectRayPacketAxisAlignedBox( const RayPacket4* pRays, UINT ActiveMask, const AxisAlignedBox* pVolume,
+                                       XMVECTOR* pDist )
 {
+    XMASSERT( pRays );
     XMASSERT( pVolume );
-    XMASSERT( XMPlaneIsUnit( Plane ) );
+    XMASSERT( pDist );
 
-    // Load the sphere.
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Radius = XMVectorReplicatePtr( &pVolume->Radius );
+    XMVECTOR Center[3], Extents[3];
+    SplatVector3( Center, XMLoadFloat3( &pVolume->Center ) );
+    SplatVector3( Extents, XMLoadFloat3( &pVolume->Extents ) );
 
-    // Set w of the center to one so we can dot4 with a plane.
-    Center = XMVectorInsert( Center, XMVectorSplatOne(), 0, 0, 0, 0, 1 );
+    XMVECTOR t;
+    XMVECTOR Hit = IntersectRayAxisAlignedBoxSoA( pRays->Origin, pRays->Direction, Center, Extents, &t );
 
-    XMVECTOR Outside, Inside;
-    FastIntersectSpherePlane( Center, Radius, Plane, Outside, Inside );
+    return ResolvePacketHits( Hit, ActiveMask, t, pDist );
+}
 
-    // If the sphere is outside any plane it is outside.
-    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
-        return 0;
 
-    // If the sphere is inside all planes it is inside.
-    if ( XMVector4EqualInt( Inside, XMVectorTrueInt() ) )
-        return 2;
 
-    // The sphere is not inside all planes or outside a plane it intersects.
-    return 1;
+UINT IntersectRayPacketAxisAlignedBox( const RayPacket8* pRays, UINT ActiveMask, const AxisAlignedBox* pVolume,
+                                       XMVECTOR* pDist )
+{
+    XMASSERT( pRays );
+    XMASSERT( pVolume );
+    XMASSERT( pDist );
+
+    XMVECTOR Center[3], Extents[3];
+    SplatVector3( Center, XMLoadFloat3( &pVolume->Center ) );
+    SplatVector3( Extents, XMLoadFloat3( &pVolume->Extents ) );
+
+    UINT Result = 0;
+    for( UINT h = 0; h < 2; h++ )
+    {
+        XMVECTOR t;
+        XMVECTOR Hit = IntersectRayAxisAlignedBoxSoA( pRays->Packet[h].Origin, pRays->Packet[h].Direction, Center,
+                                                      Extents, &t );
+        Result |= ResolvePacketHits( Hit, ActiveMask >> ( 4 * h ), t, &pDist[h] ) << ( 4 * h );
+    }
+
+    return Result;
 }
 
 
 
 //-----------------------------------------------------------------------------
-INT IntersectAxisAlignedBoxPlane( const AxisAlignedBox* pVolume, FXMVECTOR Plane )
+// One ray against several primitives.
+//-----------------------------------------------------------------------------
+UINT IntersectRayTrianglePacket( FXMVECTOR Origin, FXMVECTOR Direction, const TrianglePacket4* pTriangles,
+                                 UINT ActiveMask, XMVECTOR* pDist )
 {
-    XMASSERT( pVolume );
-    XMASSERT( XMPlaneIsUnit( Plane ) );
+    XMASSERT( pTriangles );
+    XMASSERT( pDist );
 
-    // Load the box.
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
+    XMVECTOR O[3], D[3];
+    SplatVector3( O, Origin );
+    SplatVector3( D, Direction );
 
-    // Set w of the center to one so we can dot4 with a plane.
-    Center = XMVectorInsert( Center, XMVectorSplatOne(), 0, 0, 0, 0, 1);
+    XMVECTOR t;
+    XMVECTOR Hit = IntersectRayTriangleSoA( O, D, pTriangles->V0, pTriangles->V1, pTriangles->V2, &t );
 
-    XMVECTOR Outside, Inside;
-    FastIntersectAxisAlignedBoxPlane( Center, Extents, Plane, Outside, Inside );
+    return ResolvePacketHits( Hit, ActiveMask, t, pDist );
+}
 
-    // If the box is outside any plane it is outside.
-    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
-        return 0;
 
-    // If the box is inside all planes it is inside.
-    if ( XMVector4EqualInt( Inside, XMVectorTrueInt() ) )
-        return 2;
 
-    // The box is not inside all planes or outside a plane it intersects.
-    return 1;
+UINT IntersectRayTrianglePacket( FXMVECTOR Origin, FXMVECTOR Direction, const TrianglePacket8* pTriangles,
+                                 UINT ActiveMask, XMVECTOR* pDist )
+{
+    XMASSERT( pTriangles );
+    XMASSERT( pDist );
+
+    XMVECTOR O[3], D[3];
+    SplatVector3( O, Origin );
+    SplatVector3( D, Direction );
+
+    UINT Result = 0;
+    for( UINT h = 0; h < 2; h++ )
+    {
+        const TrianglePacket4& Tri = pTriangles->Packet[h];
+
+        XMVECTOR t;
+        XMVECTOR Hit = IntersectRayTriangleSoA( O, D, Tri.V0, Tri.V1, Tri.V2, &t );
+        Result |= ResolvePacketHits( Hit, ActiveMask >> ( 4 * h ), t, &pDist[h] ) << ( 4 * h );
+    }
+
+    return Result;
 }
 
 
 
-//-----------------------------------------------------------------------------
-INT IntersectOrientedBoxPlane( const OrientedBox* pVolume, FXMVECTOR Plane )
+UINT IntersectRaySpherePacket( FXMVECTOR Origin, FXMVECTOR Direction, const SpherePacket4* pVolumes,
+                               UINT ActiveMask, XMVECTOR* pDist )
 {
-    XMASSERT( pVolume );
-    XMASSERT( XMPlaneIsUnit( Plane ) );
+    XMASSERT( pVolumes );
+    XMASSERT( pDist );
+    XMASSERT( XMVector3IsUnit( Direction ) );
 
-    // Load the box.
-    XMVECTOR Center = XMLoadFloat3( &pVolume->Center );
-    XMVECTOR Extents = XMLoadFloat3( &pVolume->Extents );
-    XMVECTOR BoxOrientation = XMLoadFloat4( &pVolume->Orientation );
+    XMVECTOR O[3], D[3];
+    SplatVector3( O, Origin );
+    SplatVector3( D, Direction );
 
-    XMASSERT( XMQuaternionIsUnit( BoxOrientation ) );
+    XMVECTOR t;
+    XMVECTOR Hit = IntersectRaySphereSoA( O, D, pVolumes->Center, pVolumes->Radius, &t );
 
-    // Set w of the center to one so we can dot4 with a plane.
-    Center = XMVectorInsert( Center, XMVectorSplatOne(), 0, 0, 0, 0, 1);
+    return ResolvePacketHits( Hit, ActiveMask, t, pDist );
+}
 
-    // Build the 3x3 rotation matrix that defines the box axes.
-    XMMATRIX R = XMMatrixRotationQuaternion( BoxOrientation );
 
-    XMVECTOR Outside, Inside;
-    FastIntersectOrientedBoxPlane( Center, Extents, R.r[0], R.r[1], R.r[2], Plane, Outside, Inside );
 
-    // If the box is outside any plane it is outside.
-    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
-        return 0;
+UINT IntersectRaySpherePacket( FXMVECTOR Origin, FXMVECTOR Direction, const SpherePacket8* pVolumes,
+                               UINT ActiveMask, XMVECTOR* pDist )
+{
+    XMASSERT( pVolumes );
+    XMASSERT( pDist );
+    XMASSERT( XMVector3IsUnit( Direction ) );
 
-    // If the box is inside all planes it is inside.
-    if ( XMVector4EqualInt( Inside, XMVectorTrueInt() ) )
-        return 2;
+    XMVECTOR O[3], D[3];
+    SplatVector3( O, Origin );
+    SplatVector3( D, Direction );
 
-    // The box is not inside all planes or outside a plane it intersects.
-    return 1;
+    UINT Result = 0;
+    for( UINT h = 0; h < 2; h++ )
+    {
+        XMVECTOR t;
+        XMVECTOR Hit = IntersectRaySphereSoA( O, D, pVolumes->Packet[h].Center, pVolumes->Packet[h].Radius, &t );
+        Result |= ResolvePacketHits( Hit, ActiveMask >> ( 4 * h ), t, &pDist[h] ) << ( 4 * h );
+    }
+
+    return Result;
 }
 
 
 
-//-----------------------------------------------------------------------------
-INT IntersectFrustumPlane( const Frustum* pVolume, FXMVECTOR Plane )
+UINT IntersectRayAxisAlignedBoxPacket( FXMVECTOR Origin, FXMVECTOR Direction, const AxisAlignedBoxPacket4* pVolumes,
+                                       UINT ActiveMask, XMVECTOR* pDist )
 {
-    XMASSERT( pVolume );
-    XMASSERT( XMPlaneIsUnit( Plane ) );
-
-    // Load origin and orientation of the frustum.
-    XMVECTOR Origin = XMLoadFloat3( &pVolume->Origin );
-    XMVECTOR Orientation = XMLoadFloat4( &pVolume->Orientation );
+    XMASSERT( pVolumes );
+    XMASSERT( pDist );
 
-    XMASSERT( XMQuaternionIsUnit( Orientation ) );
+    XMVECTOR O[3], D[3];
+    SplatVector3( O, Origin );
+    SplatVector3( D, Direction );
 
-    // Set w of the origin to one so we can dot4 with a plane.
-    Origin = XMVectorInsert( Origin, XMVectorSplatOne(), 0, 0, 0, 0, 1);
+    XMVECTOR t;
+    XMVECTOR Hit = IntersectRayAxisAlignedBoxSoA( O, D, pVolumes->Center, pVolumes->Extents, &t );
 
-    // Build the corners of the frustum (in world space).
-    XMVECTOR RightTop = XMVectorSet( pVolume->RightSlope, pVolume->TopSlope, 1.0f, 0.0f );
-    XMVECTOR RightBottom = XMVectorSet( pVolume->RightSlope, pVolume->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR LeftTop = XMVectorSet( pVolume->LeftSlope, pVolume->TopSlope, 1.0f, 0.0f );
-    XMVECTOR LeftBottom = XMVectorSet( pVolume->LeftSlope, pVolume->BottomSlope, 1.0f, 0.0f );
-    XMVECTOR Near = XMVectorSet( pVolume->Near, pVolume->Near, pVolume->Near, 0.0f );
-    XMVECTOR Far = XMVectorSet( pVolume->Far, pVolume->Far, pVolume->Far, 0.0f );
+    return ResolvePacketHits( Hit, ActiveMask, t, pDist );
+}
 
-    RightTop = XMVector3Rotate( RightTop, Orientation );
-    RightBottom = XMVector3Rotate( RightBottom, Orientation );
-    LeftTop = XMVector3Rotate( LeftTop, Orientation );
-    LeftBottom = XMVector3Rotate( LeftBottom, Orientation );
 
-    XMVECTOR Corners0 = Origin + RightTop * Near;
-    XMVECTOR Corners1 = Origin + RightBottom * Near;
-    XMVECTOR Corners2 = Origin + LeftTop * Near;
-    XMVECTOR Corners3 = Origin + LeftBottom * Near;
-    XMVECTOR Corners4 = Origin + RightTop * Far;
-    XMVECTOR Corners5 = Origin + RightBottom * Far;
-    XMVECTOR Corners6 = Origin + LeftTop * Far;
-    XMVECTOR Corners7 = Origin + LeftBottom * Far;
 
-    XMVECTOR Outside, Inside;
-    FastIntersectFrustumPlane( Corners0, Corners1, Corners2, Corners3, 
-                               Corners4, Corners5, Corners6, Corners7, 
-                               Plane, Outside, Inside );
+UINT IntersectRayAxisAlignedBoxPacket( FXMVECTOR Origin, FXMVECTOR Direction, const AxisAlignedBoxPacket8* pVolumes,
+                                       UINT ActiveMask, XMVECTOR* pDist )
+{
+    XMASSERT( pVolumes );
+    XMASSERT( pDist );
 
-    // If the frustum is outside any plane it is outside.
-    if ( XMVector4EqualInt( Outside, XMVectorTrueInt() ) )
-        return 0;
+    XMVECTOR O[3], D[3];
+    SplatVector3( O, Origin );
+    SplatVector3( D, Direction );
 
-    // If the frustum is inside all planes it is inside.
-    if ( XMVector4EqualInt( Inside, XMVectorTrueInt() ) )
-        return 2;
+    UINT Result = 0;
+    for( UINT h = 0; h < 2; h++ )
+    {
+        XMVECTOR t;
+        XMVECTOR Hit = IntersectRayAxisAlignedBoxSoA( O, D, pVolumes->Packet[h].Center, pVolumes->Packet[h].Extents,
+                                                      &t );
+        Result |= ResolvePacketHits( Hit, ActiveMask >> ( 4 * h ), t, &pDist[h] ) << ( 4 * h );
+    }
 
-    // The frustum is not inside all planes or outside a plane it intersects.
-    return 1;
+    return Result;
 }
 
 }; // namespace
@@ -12,7 +12,33 @@
 #ifndef _XNA_COLLISION_H_
 #define _XNA_COLLISION_H_
 
-#include <xnamath.h>
+#if defined( _WIN32 )
+#include <Windows.h>
+#else
+#include <cstdint>
+
+// The Windows types used by the collision code, for GCC and Clang builds.
+typedef int BOOL;
+typedef int INT;
+typedef unsigned int UINT;
+typedef unsigned long long UINT64;
+typedef float FLOAT;
+typedef double DOUBLE;
+typedef uint8_t BYTE;
+#define VOID void
+#define CONST const
+#define TRUE 1
+#define FALSE 0
+#endif
+
+#include <cassert>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+#ifndef XMASSERT
+#define XMASSERT( Expression ) assert( Expression )
+#endif
 
 namespace XNA
 {
@@ -25,29 +51,31 @@ namespace XNA
 // premium relative to CPU cycles on Xbox 360.
 //-----------------------------------------------------------------------------
 
+#ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4324)
+#endif
 
-_DECLSPEC_ALIGN_16_ struct Sphere
+struct alignas( 16 ) Sphere
 {
     XMFLOAT3 Center;            // Center of the sphere.
     FLOAT Radius;               // Radius of the sphere.
 };
 
-_DECLSPEC_ALIGN_16_ struct AxisAlignedBox
+struct alignas( 16 ) AxisAlignedBox
 {
     XMFLOAT3 Center;            // Center of the box.
     XMFLOAT3 Extents;           // Distance from the center to each side.
 };
 
-_DECLSPEC_ALIGN_16_ struct OrientedBox
+struct alignas( 16 ) OrientedBox
 {
     XMFLOAT3 Center;            // Center of the box.
     XMFLOAT3 Extents;           // Distance from the center to each side.
     XMFLOAT4 Orientation;       // Unit quaternion representing rotation (box -> world).
 };
 
-_DECLSPEC_ALIGN_16_ struct Frustum
+struct alignas( 16 ) Frustum
 {
     XMFLOAT3 Origin;            // Origin of the frustum (and projection).
     XMFLOAT4 Orientation;       // Unit quaternion representing rotation.
@@ -59,7 +87,9 @@ _DECLSPEC_ALIGN_16_ struct Frustum
     FLOAT Near, Far;            // Z of the near plane and far plane.
 };
 
+#ifdef _MSC_VER
 #pragma warning(pop)
+#endif
 
 //-----------------------------------------------------------------------------
 // Bounding volume construction.
@@ -67,6 +97,23 @@ _DECLSPEC_ALIGN_16_ struct Frustum
 VOID ComputeBoundingSphereFromPoints( Sphere* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride );
 VOID ComputeBoundingAxisAlignedBoxFromPoints( AxisAlignedBox* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride );
 VOID ComputeBoundingOrientedBoxFromPoints( OrientedBox* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride );
+
+// Exact smallest enclosing sphere (Welzl's algorithm, expected linear time but
+// several times slower than the approximation of ComputeBoundingSphereFromPoints).
+VOID ComputeMinimumBoundingSphereFromPoints( Sphere* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride );
+
+// Versions of the above that split large point sets over ThreadCount threads
+// (0 = one per hardware thread). The axis aligned box matches the serial one
+// exactly. The sphere can be slightly larger, and the oriented box axes are
+// summed up in a different order (which matters when the covariance is close
+// to degenerate), but neither depends on thread timing.
+VOID ComputeBoundingSphereFromPointsParallel( Sphere* pOut, UINT Count, const XMFLOAT3* pPoints, UINT Stride,
+                                              UINT ThreadCount );
+VOID ComputeBoundingAxisAlignedBoxFromPointsParallel( AxisAlignedBox* pOut, UINT Count, const XMFLOAT3* pPoints,
+                                                      UINT Stride, UINT ThreadCount );
+VOID ComputeBoundingOrientedBoxFromPointsParallel( OrientedBox* pOut, UINT Count, const XMFLOAT3* pPoints,
+                                                   UINT Stride, UINT ThreadCount );
+
 VOID ComputeFrustumFromProjection( Frustum* pOut, XMMATRIX* pProjection );
 VOID ComputePlanesFromFrustum( const Frustum* pVolume, XMVECTOR* pPlane0, XMVECTOR* pPlane1, XMVECTOR* pPlane2,
                                XMVECTOR* pPlane3, XMVECTOR* pPlane4, XMVECTOR* pPlane5 );
@@ -85,6 +132,50 @@ VOID TransformFrustum( Frustum* pOut, const Frustum* pIn, FLOAT Scale, FXMVECTOR
 
 
 
+//-----------------------------------------------------------------------------
+// Batched bounding volume transforms.
+//
+// The volumes are given as structure of arrays, one array of Count floats per
+// component, and volume i is transformed by pMatrices[i]. Any affine matrix
+// (row vectors, as XMVector3Transform) is allowed, including non-uniform
+// scale. pOut may point at the same arrays as pIn. Large batches are split
+// over ThreadCount threads (0 = one per hardware thread).
+//
+// Axis aligned boxes use Arvo's method: the new extents are the old extents
+// times the absolute value of the 3x3 part of the matrix. This is the same box
+// as the bounds of the eight transformed corners. Sphere radii are scaled by
+// the largest axis scale of the matrix. An oriented box under non-uniform
+// scale is in general a parallelepiped. It is bounded by the oriented box
+// whose first two axes follow the transformed first two box axes.
+//-----------------------------------------------------------------------------
+struct SphereArrays
+{
+    FLOAT* pCenter[3];          // x, y and z of the centers.
+    FLOAT* pRadius;
+};
+
+struct AxisAlignedBoxArrays
+{
+    FLOAT* pCenter[3];
+    FLOAT* pExtents[3];
+};
+
+struct OrientedBoxArrays
+{
+    FLOAT* pCenter[3];
+    FLOAT* pExtents[3];
+    FLOAT* pOrientation[4];     // x, y, z and w of the unit quaternions.
+};
+
+VOID TransformSpheres( const SphereArrays* pOut, const SphereArrays* pIn, const XMFLOAT4X4* pMatrices, UINT Count,
+                       UINT ThreadCount );
+VOID TransformAxisAlignedBoxes( const AxisAlignedBoxArrays* pOut, const AxisAlignedBoxArrays* pIn,
+                                const XMFLOAT4X4* pMatrices, UINT Count, UINT ThreadCount );
+VOID TransformOrientedBoxes( const OrientedBoxArrays* pOut, const OrientedBoxArrays* pIn,
+                             const XMFLOAT4X4* pMatrices, UINT Count, UINT ThreadCount );
+
+
+
 //-----------------------------------------------------------------------------
 // Intersection testing routines.
 //-----------------------------------------------------------------------------
@@ -101,6 +192,15 @@ BOOL IntersectTriangleTriangle( FXMVECTOR A0, FXMVECTOR A1, FXMVECTOR A2, CXMVEC
 BOOL IntersectTriangleSphere( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const Sphere* pVolume );
 BOOL IntersectTriangleAxisAlignedBox( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const AxisAlignedBox* pVolume );
 BOOL IntersectTriangleOrientedBox( FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2, const OrientedBox* pVolume );
+
+// Sweep the sphere along Displacement against the triangle (either face).
+// Returns TRUE when it touches the triangle, with *pTime the fraction of
+// Displacement traveled until then (in [0, 1]) and *pNormal the unit contact
+// normal, pointing from the triangle towards the sphere. A sphere that already
+// overlaps the triangle hits it at time 0, unless it is moving away from it.
+BOOL IntersectSweptSphereTriangle( const Sphere* pVolume, FXMVECTOR Displacement, FXMVECTOR V0, FXMVECTOR V1,
+                                   CXMVECTOR V2, FLOAT* pTime, XMVECTOR* pNormal );
+
 BOOL IntersectSphereSphere( const Sphere* pVolumeA, const Sphere* pVolumeB );
 BOOL IntersectSphereAxisAlignedBox( const Sphere* pVolumeA, const AxisAlignedBox* pVolumeB );
 BOOL IntersectSphereOrientedBox( const Sphere* pVolumeA, const OrientedBox* pVolumeB );
@@ -108,6 +208,119 @@ BOOL IntersectAxisAlignedBoxAxisAlignedBox( const AxisAlignedBox* pVolumeA, cons
 BOOL IntersectAxisAlignedBoxOrientedBox( const AxisAlignedBox* pVolumeA, const OrientedBox* pVolumeB );
 BOOL IntersectOrientedBoxOrientedBox( const OrientedBox* pVolumeA, const OrientedBox* pVolumeB );
 
+// Same result, but the separating axis *pSeparatingAxis (0-14, any other value
+// for none) is tested first and the others only when it does not separate the
+// boxes. When the boxes are disjoint *pSeparatingAxis receives the axis that
+// separated them, otherwise it is left unchanged. Axes 0-2 are those of A,
+// 3-5 those of B and 6 + 3 * i + j the cross product of axis i of A and axis
+// j of B.
+static const BYTE OrientedBoxAxisCount = 15;
+
+BOOL IntersectOrientedBoxOrientedBox( const OrientedBox* pVolumeA, const OrientedBox* pVolumeB,
+                                      BYTE* pSeparatingAxis );
+
+
+
+//-----------------------------------------------------------------------------
+// Ray packet intersection routines.
+//
+// The packets hold four rays or four primitives in structure of arrays form:
+// Origin[0] holds the x coordinates of the four origins, Origin[1] the y
+// coordinates and so on. The 8-wide packets are two 4-wide halves, lanes 0-3
+// in Packet[0] and lanes 4-7 in Packet[1].
+//
+// ActiveMask has one bit per lane (bit i for lane i); inactive lanes are not
+// reported. The return value has a bit set for every active lane that hits.
+// The distance of a hit is written to the matching lane of *pDist (pDist[0]
+// and pDist[1] for 8 lanes) and the other lanes are left untouched, so lanes
+// preset to FLT_MAX keep that value when they miss.
+//
+// The results match the single ray routines above, which also means the ray
+// directions must be unit vectors for the sphere tests.
+//-----------------------------------------------------------------------------
+struct alignas( 16 ) RayPacket4
+{
+    XMVECTOR Origin[3];         // x, y, z of the four ray origins.
+    XMVECTOR Direction[3];      // x, y, z of the four ray directions.
+};
+
+struct alignas( 16 ) RayPacket8
+{
+    RayPacket4 Packet[2];
+};
+
+struct alignas( 16 ) SpherePacket4
+{
+    XMVECTOR Center[3];
+    XMVECTOR Radius;
+};
+
+struct alignas( 16 ) SpherePacket8
+{
+    SpherePacket4 Packet[2];
+};
+
+struct alignas( 16 ) AxisAlignedBoxPacket4
+{
+    XMVECTOR Center[3];
+    XMVECTOR Extents[3];
+};
+
+struct alignas( 16 ) AxisAlignedBoxPacket8
+{
+    AxisAlignedBoxPacket4 Packet[2];
+};
+
+struct alignas( 16 ) TrianglePacket4
+{
+    XMVECTOR V0[3];
+    XMVECTOR V1[3];
+    XMVECTOR V2[3];
+};
+
+struct alignas( 16 ) TrianglePacket8
+{
+    TrianglePacket4 Packet[2];
+};
+
+// Packet construction from arrays of structures. Count may be smaller than the
+// packet width; the unused lanes repeat the first element and should be left
+// out of ActiveMask. pTriangles holds V0, V1, V2 of each triangle in a row.
+VOID LoadRayPacket( RayPacket4* pOut, UINT Count, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections );
+VOID LoadRayPacket( RayPacket8* pOut, UINT Count, const XMFLOAT3* pOrigins, const XMFLOAT3* pDirections );
+VOID LoadSpherePacket( SpherePacket4* pOut, UINT Count, const Sphere* pSpheres );
+VOID LoadSpherePacket( SpherePacket8* pOut, UINT Count, const Sphere* pSpheres );
+VOID LoadAxisAlignedBoxPacket( AxisAlignedBoxPacket4* pOut, UINT Count, const AxisAlignedBox* pBoxes );
+VOID LoadAxisAlignedBoxPacket( AxisAlignedBoxPacket8* pOut, UINT Count, const AxisAlignedBox* pBoxes );
+VOID LoadTrianglePacket( TrianglePacket4* pOut, UINT Count, const XMFLOAT3* pTriangles );
+VOID LoadTrianglePacket( TrianglePacket8* pOut, UINT Count, const XMFLOAT3* pTriangles );
+
+// Several rays against one primitive.
+UINT IntersectRayPacketTriangle( const RayPacket4* pRays, UINT ActiveMask, FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2,
+                                 XMVECTOR* pDist );
+UINT IntersectRayPacketTriangle( const RayPacket8* pRays, UINT ActiveMask, FXMVECTOR V0, FXMVECTOR V1, FXMVECTOR V2,
+                                 XMVECTOR* pDist );
+UINT IntersectRayPacketSphere( const RayPacket4* pRays, UINT ActiveMask, const Sphere* pVolume, XMVECTOR* pDist );
+UINT IntersectRayPacketSphere( const RayPacket8* pRays, UINT ActiveMask, const Sphere* pVolume, XMVECTOR* pDist );
+UINT IntersectRayPacketAxisAlignedBox( const RayPacket4* pRays, UINT ActiveMask, const AxisAlignedBox* pVolume,
+                                       XMVECTOR* pDist );
+UINT IntersectRayPacketAxisAlignedBox( const RayPacket8* pRays, UINT ActiveMask, const AxisAlignedBox* pVolume,
+                                       XMVECTOR* pDist );
+
+// One ray against several primitives.
+UINT IntersectRayTrianglePacket( FXMVECTOR Origin, FXMVECTOR Direction, const TrianglePacket4* pTriangles,
+                                 UINT ActiveMask, XMVECTOR* pDist );
+UINT IntersectRayTrianglePacket( FXMVECTOR Origin, FXMVECTOR Direction, const TrianglePacket8* pTriangles,
+                                 UINT ActiveMask, XMVECTOR* pDist );
+UINT IntersectRaySpherePacket( FXMVECTOR Origin, FXMVECTOR Direction, const SpherePacket4* pVolumes,
+                               UINT ActiveMask, XMVECTOR* pDist );
+UINT IntersectRaySpherePacket( FXMVECTOR Origin, FXMVECTOR Direction, const SpherePacket8* pVolumes,
+                               UINT ActiveMask, XMVECTOR* pDist );
+UINT IntersectRayAxisAlignedBoxPacket( FXMVECTOR Origin, FXMVECTOR Direction, const AxisAlignedBoxPacket4* pVolumes,
+                                       UINT ActiveMask, XMVECTOR* pDist );
+UINT IntersectRayAxisAlignedBoxPacket( FXMVECTOR Origin, FXMVECTOR Direction, const AxisAlignedBoxPacket8* pVolumes,
+                                       UINT ActiveMask, XMVECTOR* pDist );
+
 
 
 //-----------------------------------------------------------------------------